@@ -0,0 +1,49 @@
+#
+# Tests and benchmarks live in `<module>/test/` and are only built with
+# `-DLODGE_BUILD_TESTS=ON`.
+#
+# Tests are registered with ctest and return non-zero on failure; `INCLUDES`
+# adds include directories, for tests of sources private to a module. Benchmarks
+# are plain executables that print their timings.
+#
+option(LODGE_BUILD_TESTS "Build tests and benchmarks" OFF)
+
+if(LODGE_BUILD_TESTS)
+    enable_testing()
+endif()
+
+function(lodge_add_test test_name)
+    if(NOT LODGE_BUILD_TESTS)
+        return()
+    endif()
+
+    cmake_parse_arguments(ARG "" "" "SOURCES;INCLUDES;LIBRARIES" ${ARGN})
+
+    add_executable(${test_name} ${ARG_SOURCES})
+    target_include_directories(${test_name}
+        PRIVATE
+            ${ARG_INCLUDES}
+    )
+    target_link_libraries(${test_name}
+        PRIVATE
+            lodge-build-flags
+            ${ARG_LIBRARIES}
+    )
+
+    add_test(NAME ${test_name} COMMAND ${test_name})
+endfunction()
+
+function(lodge_add_benchmark bench_name)
+    if(NOT LODGE_BUILD_TESTS)
+        return()
+    endif()
+
+    cmake_parse_arguments(ARG "" "" "SOURCES;LIBRARIES" ${ARGN})
+
+    add_executable(${bench_name} ${ARG_SOURCES})
+    target_link_libraries(${bench_name}
+        PRIVATE
+            lodge-build-flags
+            ${ARG_LIBRARIES}
+    )
+endfunction()
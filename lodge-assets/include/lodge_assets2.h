@@ -5,13 +5,25 @@
 
 #include <stdint.h>
 
+#define LODGE_ASSETS2_UPDATE_BUDGET_MS	2.0f
+
 struct lodge_assets2;
 
+struct lodge_jobs;
+
 struct lodge_asset;
 typedef struct lodge_asset* lodge_asset_t;
 
 typedef void				(*lodge_assets2_on_modified_t)(struct lodge_assets2 *assets, lodge_asset_t asset, void *userdata);
 
+enum lodge_asset_state
+{
+	LODGE_ASSET_STATE_UNLOADED,
+	LODGE_ASSET_STATE_LOADING,
+	LODGE_ASSET_STATE_LOADED,
+	LODGE_ASSET_STATE_FAILED,
+};
+
 struct lodge_assets2_desc
 {
 	strview_t				name;
@@ -21,6 +33,29 @@ struct lodge_assets2_desc
 	bool					(*new_default_inplace)(struct lodge_assets2 *assets, void *data);
 	bool					(*reload_inplace)(struct lodge_assets2 *assets, strview_t name, lodge_asset_t asset, void *data);
 	void					(*free_inplace)(struct lodge_assets2 *assets, strview_t name, lodge_asset_t asset, void *data);
+
+	//
+	// Optional split loading, used instead of `new_inplace` when `finalize_inplace` is set.
+	//
+	// `decode` runs on a worker thread and may only do file IO and CPU work (no GL, no other
+	// `lodge_assets2` calls); it returns an intermediate, or NULL on failure.
+	//
+	// `finalize_inplace` runs on the main thread and turns the intermediate into the asset.
+	// It returns LODGE_ASSET_STATE_LOADING to be retried next update, for example while
+	// waiting for a dependency requested with `_get_async()`.
+	//
+	void*					(*decode)(struct lodge_assets2 *assets, strview_t name);
+	enum lodge_asset_state	(*finalize_inplace)(struct lodge_assets2 *assets, strview_t name, lodge_asset_t asset, void *intermediate, void *data);
+	void					(*decode_free)(struct lodge_assets2 *assets, void *intermediate);
+};
+
+struct lodge_assets2_stats
+{
+	uint32_t				loads_count;		// Completed async loads.
+	double					load_ms_sum;		// Request to loaded, summed over `loads_count`.
+	double					load_ms_max;
+	double					finalize_ms_max;	// Longest single `finalize_inplace`.
+	double					update_ms_max;		// Longest `lodge_assets2_update()`, ie. worst frame hitch.
 };
 
 void						lodge_assets2_new_inplace(struct lodge_assets2 *assets, struct lodge_assets2_desc *desc);
@@ -29,6 +64,10 @@ size_t						lodge_assets2_sizeof();
 
 lodge_asset_t				lodge_assets2_register(struct lodge_assets2 *assets, strview_t name);
 lodge_asset_t				lodge_assets2_find_by_name(struct lodge_assets2 *assets, strview_t name);
+//
+// NOTE(TS): returns the first asset with this hash; prefer `_find_by_name`,
+// which also compares the full name.
+//
 lodge_asset_t				lodge_assets2_find_by_name_hash(struct lodge_assets2 *assets, uint32_t name_hash);
 
 void						lodge_assets2_add_listener(struct lodge_assets2 *assets, lodge_asset_t asset, struct lodge_assets2 *listener_assets, lodge_asset_t listener_asset);
@@ -36,12 +75,28 @@ void						lodge_assets2_remove_listener(struct lodge_assets2 *assets, lodge_asse
 void						lodge_assets2_remove_listener_by_name(struct lodge_assets2 *assets, strview_t name, struct lodge_assets2 *listener_assets, lodge_asset_t listener_asset);
 
 //
-// TODO(TS): refactor `lodge_assets2_get()` into `_async` and `_block` variants. _async will return a
-// Asset Type Default object while waiting for the asset to load, and _block will wait until the asset
-// is loaded.
+// `_block` loads the asset on the calling thread if needed. `_async` returns the
+// loaded asset, or else queues the load and returns the type default object
+// (`new_default_inplace`, NULL if the type has none) until it is ready.
+//
+// Types without `finalize_inplace` always load blocking, as do `_async` calls made
+// from inside a blocking load.
+//
+// `lodge_assets2_get()` is `_block`.
 //
-
 void*						lodge_assets2_get(struct lodge_assets2 *assets, lodge_asset_t asset);
+void*						lodge_assets2_get_block(struct lodge_assets2 *assets, lodge_asset_t asset);
+void*						lodge_assets2_get_async(struct lodge_assets2 *assets, lodge_asset_t asset);
+enum lodge_asset_state		lodge_assets2_get_state(struct lodge_assets2 *assets, lodge_asset_t asset);
+
+//
+// Async loads decode on `jobs` (inline if NULL) and are finalized by `lodge_assets2_update()`,
+// which should be called once per frame from the main thread. It stops finalizing once
+// `budget_ms` is spent, but always finalizes at least one load so every call makes progress.
+//
+void						lodge_assets2_set_jobs(struct lodge_assets2 *assets, struct lodge_jobs *jobs);
+void						lodge_assets2_update(struct lodge_assets2 *assets, float budget_ms);
+struct lodge_assets2_stats	lodge_assets2_get_stats(struct lodge_assets2 *assets);
 strview_t					lodge_assets2_get_name(struct lodge_assets2 *assets, const lodge_asset_t asset);
 
 lodge_asset_t				lodge_assets2_make_default(struct lodge_assets2 *assets);
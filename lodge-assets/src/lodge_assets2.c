@@ -6,8 +6,15 @@
 #include "strbuf.h"
 
 #include "lodge_platform.h"
+#include "lodge_jobs.h"
+#include "lodge_time.h"
+#include "log.h"
 
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LODGE_ASSETS2_NAME_INDEX_CAPACITY_MIN 256
 
 struct lodge_asset_listener
 {
@@ -41,6 +48,8 @@ struct lodge_asset_listeners
 	struct lodge_asset_listener		*elements;
 };
 
+struct lodge_asset_load;
+
 struct lodge_asset_info
 {
 	lodge_asset_t					id;
@@ -48,6 +57,9 @@ struct lodge_asset_info
 	uint32_t						name_hash;
 
 	struct lodge_asset_listeners	listeners;
+
+	struct lodge_asset_load			*load;			// Set while an async load is in flight.
+	bool							load_failed;	// Stops `_get_async()` from retrying until invalidated.
 };
 
 struct lodge_asset_infos
@@ -57,14 +69,70 @@ struct lodge_asset_infos
 	struct lodge_asset_info			*elements;
 };
 
+struct lodge_asset_name_slot
+{
+	uint32_t						name_hash;
+	uint32_t						index;			// `index + 1` into `infos`, 0 if the slot is empty.
+};
+
+//
+// Open addressing (linear probing) hash table from name to `infos` index.
+// Kept at most half full. Entries are never removed, since assets are
+// never unregistered.
+//
+struct lodge_asset_name_index
+{
+	size_t							count;
+	size_t							capacity;		// Power of two.
+	struct lodge_asset_name_slot	*slots;
+};
+
+//
+// An async load in flight. Heap allocated so the worker can hold on to it while
+// `infos` grows; `name` is copied for the same reason.
+//
+struct lodge_asset_load
+{
+	struct lodge_assets2			*assets;
+	lodge_asset_t					asset;
+	char							name[256];
+
+	void							*intermediate;	// Written by `decode` on the worker.
+	void							*data;			// `desc.size` bytes, finalized into before being moved to `set`.
+
+	struct lodge_job_counter		decoded;
+	lodge_timestamp_t				requested;
+	bool							finalizing;		// Set while `finalize_inplace` runs, which may invalidate this asset.
+};
+
+struct lodge_asset_loads
+{
+	size_t							count;
+	size_t							capacity;
+	struct lodge_asset_load			**elements;
+};
+
 struct lodge_assets2
 {
 	struct lodge_assets2_desc		desc;
 	sparse_set_t					set;
 	struct lodge_asset_infos		infos;
+	struct lodge_asset_name_index	name_index;
 	void							*userdatas[16];
+
+	struct lodge_jobs				*jobs;
+	struct lodge_asset_loads		loads;			// FIFO, finalized by `lodge_assets2_update()`.
+	void							*default_data;	// Lazily made by `new_default_inplace`.
+	struct lodge_assets2_stats		stats;
 };
 
+//
+// Nesting depth of blocking loads. While non-zero, `_get_async()` blocks as well, so a
+// blocking load never observes a half loaded dependency. Only touched on the main thread,
+// since `decode` may not call back into `lodge_assets2`.
+//
+static int32_t lodge_assets2_blocking = 0;
+
 static uint32_t lodge_asset_to_index(const lodge_asset_t asset)
 {
 	ASSERT(asset != NULL);
@@ -90,18 +158,217 @@ static struct lodge_asset_info* lodge_asset_to_info(struct lodge_assets2 *assets
 
 static void lodge_assets2_invalidate_listeners(struct lodge_assets2 *assets, struct lodge_asset_info *info)
 {
-	for(size_t i = 0, count = info->listeners.count; i < count; i++) {
-		struct lodge_asset_listener *listener = &info->listeners.elements[i];
-		lodge_assets2_invalidate(listener->assets, listener->asset);
+	//
+	// Listeners remove themselves from `info` when they are freed, so walk a copy.
+	//
+	const size_t count = info->listeners.count;
+	if(count == 0) {
+		return;
 	}
+
+	struct lodge_asset_listener *listeners = (struct lodge_asset_listener *)malloc(count * sizeof(struct lodge_asset_listener));
+	ASSERT_OR(listeners) { return; }
+	memcpy(listeners, info->listeners.elements, count * sizeof(struct lodge_asset_listener));
+
+	for(size_t i = 0; i < count; i++) {
+		lodge_assets2_invalidate(listeners[i].assets, listeners[i].asset);
+	}
+
+	free(listeners);
 }
 
 static void lodge_asset_info_new_inplace(struct lodge_asset_info *info, lodge_asset_t asset, strview_t name)
 {
 	info->id = asset;
 	strbuf_set(strbuf(info->name), name);
-	info->name_hash = strview_calc_hash(name);
+	info->name_hash = strview_calc_hash(strview_wrap(info->name));
 	dynbuf_new_inplace(dynbuf(info->listeners), 1);
+	info->load = NULL;
+	info->load_failed = false;
+}
+
+static void lodge_asset_name_index_insert(struct lodge_asset_name_index *name_index, uint32_t name_hash, uint32_t index)
+{
+	const size_t mask = name_index->capacity - 1;
+	for(size_t i = name_hash & mask;; i = (i + 1) & mask) {
+		struct lodge_asset_name_slot *slot = &name_index->slots[i];
+		if(slot->index == 0) {
+			slot->name_hash = name_hash;
+			slot->index = index + 1;
+			name_index->count++;
+			return;
+		}
+	}
+}
+
+static void lodge_asset_name_index_grow(struct lodge_asset_name_index *name_index)
+{
+	struct lodge_asset_name_index grown = {
+		.count = 0,
+		.capacity = max(name_index->capacity * 2, LODGE_ASSETS2_NAME_INDEX_CAPACITY_MIN),
+	};
+	grown.slots = (struct lodge_asset_name_slot *)calloc(grown.capacity, sizeof(struct lodge_asset_name_slot));
+	ASSERT_OR(grown.slots) { return; }
+
+	for(size_t i = 0; i < name_index->capacity; i++) {
+		const struct lodge_asset_name_slot *slot = &name_index->slots[i];
+		if(slot->index != 0) {
+			lodge_asset_name_index_insert(&grown, slot->name_hash, slot->index - 1);
+		}
+	}
+
+	free(name_index->slots);
+	*name_index = grown;
+}
+
+//
+// Returns the `infos` index of `name`, or UINT32_MAX. Names that share a hash
+// are told apart by comparing the full name.
+//
+static uint32_t lodge_assets2_find_index(struct lodge_assets2 *assets, strview_t name, uint32_t name_hash)
+{
+	const struct lodge_asset_name_index *name_index = &assets->name_index;
+	if(name_index->capacity == 0) {
+		return UINT32_MAX;
+	}
+
+	const size_t mask = name_index->capacity - 1;
+	for(size_t i = name_hash & mask;; i = (i + 1) & mask) {
+		const struct lodge_asset_name_slot *slot = &name_index->slots[i];
+		if(slot->index == 0) {
+			return UINT32_MAX;
+		}
+		if(slot->name_hash == name_hash
+			&& strview_equals(strview_wrap(assets->infos.elements[slot->index - 1].name), name)) {
+			return slot->index - 1;
+		}
+	}
+}
+
+static struct lodge_asset_info* lodge_assets2_add_info(struct lodge_assets2 *assets, strview_t name)
+{
+	const size_t index = assets->infos.count;
+	ASSERT_OR(index < UINT32_MAX - 1) { return NULL; }
+
+	if((assets->name_index.count + 1) * 2 > assets->name_index.capacity) {
+		lodge_asset_name_index_grow(&assets->name_index);
+		ASSERT_OR((assets->name_index.count + 1) * 2 <= assets->name_index.capacity) { return NULL; }
+	}
+
+	struct lodge_asset_info *info = dynbuf_append_no_init(dynbuf(assets->infos));
+	ASSERT_OR(info) { return NULL; }
+	lodge_asset_info_new_inplace(info, lodge_asset_from_index((uint32_t)index), name);
+
+	lodge_asset_name_index_insert(&assets->name_index, info->name_hash, (uint32_t)index);
+
+	return info;
+}
+
+static struct lodge_asset_load* lodge_asset_load_new(struct lodge_assets2 *assets, const struct lodge_asset_info *info)
+{
+	struct lodge_asset_load *load = (struct lodge_asset_load *)calloc(1, sizeof(struct lodge_asset_load));
+	ASSERT_OR(load) { return NULL; }
+
+	load->data = calloc(1, assets->desc.size);
+	ASSERT_OR(load->data) {
+		free(load);
+		return NULL;
+	}
+
+	load->assets = assets;
+	load->asset = info->id;
+	strbuf_set(strbuf(load->name), strview_wrap(info->name));
+	load->requested = lodge_timestamp_get();
+
+	return load;
+}
+
+static void lodge_asset_load_free(struct lodge_assets2 *assets, struct lodge_asset_load *load)
+{
+	if(load->intermediate && assets->desc.decode_free) {
+		assets->desc.decode_free(assets, load->intermediate);
+	}
+	free(load->data);
+	free(load);
+}
+
+//
+// Job function: runs on a worker thread.
+//
+static void lodge_asset_load_decode(struct lodge_asset_load *load)
+{
+	struct lodge_assets2 *assets = load->assets;
+	load->intermediate = assets->desc.decode ? assets->desc.decode(assets, strview_wrap(load->name)) : NULL;
+}
+
+static void lodge_assets2_remove_load(struct lodge_assets2 *assets, struct lodge_asset_load *load)
+{
+	const int64_t index = dynbuf_find(dynbuf(assets->loads), &load, sizeof(load));
+	ASSERT_OR(index >= 0) { return; }
+	dynbuf_remove(dynbuf(assets->loads), index, 1);
+
+	struct lodge_asset_info *info = lodge_asset_to_info(assets, load->asset);
+	if(info) {
+		info->load = NULL;
+	}
+}
+
+static void lodge_assets2_cancel_load(struct lodge_assets2 *assets, struct lodge_asset_load *load)
+{
+	lodge_jobs_wait(assets->jobs, &load->decoded);
+	lodge_assets2_remove_load(assets, load);
+	lodge_asset_load_free(assets, load);
+}
+
+//
+// Runs `finalize_inplace` on a decoded load and moves the result into `set`. With `block`,
+// dependencies requested by the finalizer are loaded blocking too, so it cannot be left
+// waiting.
+//
+static enum lodge_asset_state lodge_assets2_finalize_load(struct lodge_assets2 *assets, struct lodge_asset_load *load, bool block)
+{
+	struct lodge_asset_info *info = lodge_asset_to_info(assets, load->asset);
+	ASSERT_OR(info) { return LODGE_ASSET_STATE_FAILED; }
+
+	enum lodge_asset_state state = LODGE_ASSET_STATE_FAILED;
+	if(load->intermediate || !assets->desc.decode) {
+		if(block) {
+			lodge_assets2_blocking++;
+		}
+		load->finalizing = true;
+		state = assets->desc.finalize_inplace(assets, strview_wrap(load->name), load->asset, load->intermediate, load->data);
+		load->finalizing = false;
+		if(block) {
+			lodge_assets2_blocking--;
+		}
+	}
+
+	if(state == LODGE_ASSET_STATE_LOADED) {
+		sparse_set_set(assets->set, lodge_asset_to_index(load->asset), load->data);
+	} else if(state == LODGE_ASSET_STATE_FAILED || block) {
+		ASSERT(state != LODGE_ASSET_STATE_LOADING);
+		debugf("Assets", "Failed to load `" STRVIEW_PRINTF_FMT "::%s`\n", STRVIEW_PRINTF_ARG(assets->desc.name), load->name);
+		info->load_failed = true;
+		state = LODGE_ASSET_STATE_FAILED;
+	}
+
+	return state;
+}
+
+static void* lodge_assets2_get_default(struct lodge_assets2 *assets)
+{
+	if(!assets->default_data && assets->desc.new_default_inplace) {
+		void *data = calloc(1, assets->desc.size);
+		ASSERT_OR(data) { return NULL; }
+
+		ASSERT_OR(assets->desc.new_default_inplace(assets, data)) {
+			free(data);
+			return NULL;
+		}
+
+		assets->default_data = data;
+	}
+	return assets->default_data;
 }
 
 void lodge_assets2_new_inplace(struct lodge_assets2 *assets, struct lodge_assets2_desc *desc)
@@ -109,18 +376,39 @@ void lodge_assets2_new_inplace(struct lodge_assets2 *assets, struct lodge_assets
 	assets->desc = *desc;
 	assets->set = sparse_set_new(desc->size, 256, 256);
 	dynbuf_new_inplace(dynbuf(assets->infos), 256);
+	assets->name_index = (struct lodge_asset_name_index) { 0 };
+	assets->jobs = NULL;
+	assets->loads = (struct lodge_asset_loads) { 0 };
+	assets->default_data = NULL;
+	assets->stats = (struct lodge_assets2_stats) { 0 };
 }
 
 void lodge_assets2_free_inplace(struct lodge_assets2 *assets)
 {
+	for(size_t i = 0, count = assets->loads.count; i < count; i++) {
+		struct lodge_asset_load *load = assets->loads.elements[i];
+		lodge_jobs_wait(assets->jobs, &load->decoded);
+		lodge_asset_load_free(assets, load);
+	}
+	dynbuf_free_inplace(dynbuf(assets->loads));
+
 	if(assets->desc.free_inplace) {
 		for(void *it = sparse_set_it_begin(assets->set); it; it = sparse_set_it_next(assets->set, it)) {
 			uint32_t index = sparse_set_get_index(assets->set, it);
 			struct lodge_asset_info *info = lodge_assets2_get_info_by_index(assets, index);
 			assets->desc.free_inplace(assets, strview_wrap(info->name), info->id, it);
 		}
+		if(assets->default_data) {
+			assets->desc.free_inplace(assets, strview_null(), NULL, assets->default_data);
+		}
+	}
+	free(assets->default_data);
+
+	for(size_t i = 0, count = assets->infos.count; i < count; i++) {
+		dynbuf_free_inplace(dynbuf(assets->infos.elements[i].listeners));
 	}
 	dynbuf_free_inplace(dynbuf(assets->infos));
+	free(assets->name_index.slots);
 	sparse_set_free(assets->set);
 }
 
@@ -131,44 +419,57 @@ size_t lodge_assets2_sizeof()
 
 lodge_asset_t lodge_assets2_register(struct lodge_assets2 *assets, strview_t name)
 {
-	const uint32_t name_hash = strview_calc_hash(name);
-	lodge_asset_t tmp = lodge_assets2_find_by_name_hash(assets, name_hash);
+	lodge_asset_t tmp = lodge_assets2_find_by_name(assets, name);
 	if(tmp) {
 		return tmp;
 	}
 
-	const size_t index = assets->infos.count;
-	ASSERT_OR(index < UINT32_MAX) { return NULL; }
-	//
-	// TODO(TS): should insert sorted by `name_hash` so we can binary search for names
-	//
-	struct lodge_asset_info *info = dynbuf_append_no_init(dynbuf(assets->infos));
-	lodge_asset_info_new_inplace(info, lodge_asset_from_index(index), name);
-
-	return info->id;
+	struct lodge_asset_info *info = lodge_assets2_add_info(assets, name);
+	return info ? info->id : NULL;
 }
 
 lodge_asset_t lodge_assets2_find_by_name(struct lodge_assets2 *assets, strview_t name)
 {
-	return lodge_assets2_find_by_name_hash(assets, strview_calc_hash(name));
+	ASSERT_OR(assets) { return NULL; }
+
+	//
+	// Names are stored truncated to `info->name`; look up what would have been stored.
+	//
+	char tmp[LODGE_ARRAYSIZE(((struct lodge_asset_info *)NULL)->name)];
+	strbuf_set(strbuf(tmp), name);
+	const strview_t stored_name = strview_wrap(tmp);
+
+	const uint32_t index = lodge_assets2_find_index(assets, stored_name, strview_calc_hash(stored_name));
+	return (index != UINT32_MAX) ? lodge_asset_from_index(index) : NULL;
 }
 
 lodge_asset_t lodge_assets2_find_by_name_hash(struct lodge_assets2 *assets, uint32_t name_hash)
 {
 	ASSERT_OR(assets) { return NULL; }
-	//
-	// TODO(TS): this should be bsearch instead
-	//
-	for(size_t i = 0, count = assets->infos.count; i < count; i++) {
-		struct lodge_asset_info *info = &assets->infos.elements[i];
-		if(info->name_hash == name_hash) {
-			return info->id;
+
+	const struct lodge_asset_name_index *name_index = &assets->name_index;
+	if(name_index->capacity == 0) {
+		return NULL;
+	}
+
+	const size_t mask = name_index->capacity - 1;
+	for(size_t i = name_hash & mask;; i = (i + 1) & mask) {
+		const struct lodge_asset_name_slot *slot = &name_index->slots[i];
+		if(slot->index == 0) {
+			return NULL;
+		}
+		if(slot->name_hash == name_hash) {
+			return lodge_asset_from_index(slot->index - 1);
 		}
 	}
-	return NULL;
 }
 
 void* lodge_assets2_get(struct lodge_assets2 *assets, lodge_asset_t asset)
+{
+	return lodge_assets2_get_block(assets, asset);
+}
+
+void* lodge_assets2_get_block(struct lodge_assets2 *assets, lodge_asset_t asset)
 {
 	ASSERT_OR(assets) { return NULL; }
 	if(!asset) { return NULL; }
@@ -185,16 +486,40 @@ void* lodge_assets2_get(struct lodge_assets2 *assets, lodge_asset_t asset)
 		}
 	}
 
+	struct lodge_asset_info *info = lodge_assets2_get_info_by_index(assets, asset_index);
+	ASSERT_OR(info) { return NULL; }
+
+	//
+	// Split loading: pick up the async load if there is one, otherwise decode here.
+	//
+	if(assets->desc.finalize_inplace) {
+		struct lodge_asset_load *load = info->load;
+		if(load) {
+			lodge_jobs_wait(assets->jobs, &load->decoded);
+			lodge_assets2_remove_load(assets, load);
+		} else {
+			load = lodge_asset_load_new(assets, info);
+			ASSERT_OR(load) { return NULL; }
+			lodge_asset_load_decode(load);
+		}
+
+		const enum lodge_asset_state state = lodge_assets2_finalize_load(assets, load, true);
+		lodge_asset_load_free(assets, load);
+
+		return (state == LODGE_ASSET_STATE_LOADED) ? sparse_set_get(assets->set, asset_index) : NULL;
+	}
+
 	//
 	// Try to load asset
 	//
 	{
 		ASSERT_OR(assets->desc.new_inplace) { return NULL; }
 
-		struct lodge_asset_info *info = &assets->infos.elements[asset_index];
-
 		void *data = sparse_set_set_init_zero(assets->set, asset_index);
+
+		lodge_assets2_blocking++;
 		const bool ret = assets->desc.new_inplace(assets, strview_wrap(info->name), asset, data);
+		lodge_assets2_blocking--;
 		ASSERT(ret);
 
 		//
@@ -210,6 +535,129 @@ void* lodge_assets2_get(struct lodge_assets2 *assets, lodge_asset_t asset)
 	}
 }
 
+void* lodge_assets2_get_async(struct lodge_assets2 *assets, lodge_asset_t asset)
+{
+	ASSERT_OR(assets) { return NULL; }
+	if(!asset) { return NULL; }
+
+	if(!assets->desc.finalize_inplace || lodge_assets2_blocking > 0) {
+		return lodge_assets2_get_block(assets, asset);
+	}
+
+	const uint32_t asset_index = lodge_asset_to_index(asset);
+
+	void *data = sparse_set_get(assets->set, asset_index);
+	if(data) {
+		return data;
+	}
+
+	struct lodge_asset_info *info = lodge_assets2_get_info_by_index(assets, asset_index);
+	ASSERT_OR(info) { return NULL; }
+
+	if(!info->load && !info->load_failed) {
+		struct lodge_asset_load *load = lodge_asset_load_new(assets, info);
+		ASSERT_OR(load) { return NULL; }
+
+		dynbuf_append(dynbuf(assets->loads), &load, sizeof(load));
+		info->load = load;
+
+		if(assets->desc.decode) {
+			lodge_jobs_submit(assets->jobs, (lodge_job_func_t)&lodge_asset_load_decode, load, &load->decoded);
+		}
+	}
+
+	return lodge_assets2_get_default(assets);
+}
+
+enum lodge_asset_state lodge_assets2_get_state(struct lodge_assets2 *assets, lodge_asset_t asset)
+{
+	ASSERT_OR(assets && asset) { return LODGE_ASSET_STATE_UNLOADED; }
+
+	const uint32_t asset_index = lodge_asset_to_index(asset);
+	struct lodge_asset_info *info = lodge_assets2_get_info_by_index(assets, asset_index);
+	ASSERT_OR(info) { return LODGE_ASSET_STATE_UNLOADED; }
+
+	if(sparse_set_get(assets->set, asset_index)) {
+		return LODGE_ASSET_STATE_LOADED;
+	} else if(info->load) {
+		return LODGE_ASSET_STATE_LOADING;
+	} else if(info->load_failed) {
+		return LODGE_ASSET_STATE_FAILED;
+	}
+	return LODGE_ASSET_STATE_UNLOADED;
+}
+
+void lodge_assets2_set_jobs(struct lodge_assets2 *assets, struct lodge_jobs *jobs)
+{
+	ASSERT_OR(assets) { return; }
+	ASSERT(assets->loads.count == 0);
+	assets->jobs = jobs;
+}
+
+void lodge_assets2_update(struct lodge_assets2 *assets, float budget_ms)
+{
+	ASSERT_OR(assets) { return; }
+	if(assets->loads.count == 0) {
+		return;
+	}
+
+	const lodge_timestamp_t before = lodge_timestamp_get();
+	uint32_t finalized_count = 0;
+
+	for(size_t i = 0; i < assets->loads.count;) {
+		struct lodge_asset_load *load = assets->loads.elements[i];
+
+		if(!lodge_job_counter_is_done(&load->decoded)) {
+			i++;
+			continue;
+		}
+
+		if(finalized_count > 0 && lodge_timestamp_elapsed_ms(before) >= budget_ms) {
+			break;
+		}
+
+		//
+		// Loaded by other means (`_set()`) while decoding?
+		//
+		if(sparse_set_get(assets->set, lodge_asset_to_index(load->asset))) {
+			lodge_assets2_remove_load(assets, load);
+			lodge_asset_load_free(assets, load);
+			continue;
+		}
+
+		const lodge_timestamp_t finalize_before = lodge_timestamp_get();
+		const enum lodge_asset_state state = lodge_assets2_finalize_load(assets, load, false);
+		const double finalize_ms = lodge_timestamp_elapsed_ms(finalize_before);
+
+		if(state == LODGE_ASSET_STATE_LOADING) {
+			i++;
+			continue;
+		}
+
+		finalized_count++;
+		assets->stats.finalize_ms_max = max(assets->stats.finalize_ms_max, finalize_ms);
+
+		if(state == LODGE_ASSET_STATE_LOADED) {
+			const double load_ms = lodge_timestamp_elapsed_ms(load->requested);
+			assets->stats.loads_count++;
+			assets->stats.load_ms_sum += load_ms;
+			assets->stats.load_ms_max = max(assets->stats.load_ms_max, load_ms);
+
+			debugf("Assets", "Loaded `" STRVIEW_PRINTF_FMT "::%s` in %.1f ms (finalize: %.1f ms)\n", STRVIEW_PRINTF_ARG(assets->desc.name), load->name, load_ms, finalize_ms);
+		}
+
+		lodge_assets2_remove_load(assets, load);
+		lodge_asset_load_free(assets, load);
+	}
+
+	assets->stats.update_ms_max = max(assets->stats.update_ms_max, lodge_timestamp_elapsed_ms(before));
+}
+
+struct lodge_assets2_stats lodge_assets2_get_stats(struct lodge_assets2 *assets)
+{
+	ASSERT_OR(assets) { return (struct lodge_assets2_stats) { 0 }; }
+	return assets->stats;
+}
 
 strview_t lodge_assets2_get_name(struct lodge_assets2 *assets, const lodge_asset_t asset)
 {
@@ -244,12 +692,14 @@ lodge_asset_t lodge_assets2_make_default(struct lodge_assets2 *assets)
 {
 	ASSERT_OR(assets) { return NULL; }
 
-	lodge_asset_t id = lodge_assets2_register(assets, strview(""));
+	char name[256];
+	strbuf_setf(strbuf(name), "Unnamed %u", (uint32_t)assets->infos.count);
+
+	struct lodge_asset_info *info = lodge_assets2_add_info(assets, strview_wrap(name));
+	ASSERT_OR(info) { return NULL; }
 
+	lodge_asset_t id = info->id;
 	const uint32_t index = lodge_asset_to_index(id);
-	struct lodge_asset_info *info = &assets->infos.elements[index];
-	strbuf_setf(strbuf(info->name), "Unnamed %u", index);
-	info->name_hash = strview_calc_hash(strview_wrap(info->name));
 
 	void* data = sparse_set_set_init_zero(assets->set, index);
 
@@ -257,6 +707,7 @@ lodge_asset_t lodge_assets2_make_default(struct lodge_assets2 *assets)
 		bool ret = assets->desc.new_default_inplace(assets, data);
 		ASSERT_OR(ret) { return NULL; }
 	 } else {
+		ASSERT_OR(assets->desc.new_inplace) { return NULL; }
 		bool ret = assets->desc.new_inplace(assets, strview_wrap(info->name), id, data);
 		ASSERT_OR(ret) { return NULL; }
 	}
@@ -279,10 +730,19 @@ void lodge_assets2_add_listener(struct lodge_assets2 *assets, lodge_asset_t asse
 	struct lodge_asset_info *info = lodge_asset_to_info(assets, asset);
 	ASSERT_OR(info) { return; }
 
-	struct lodge_asset_listener *listener = dynbuf_append(dynbuf(info->listeners), &(struct lodge_asset_listener) {
+	const struct lodge_asset_listener new_listener = {
 		.assets = listener_assets,
 		.asset = listener_asset,
-	}, sizeof(struct lodge_asset_listener));
+	};
+
+	//
+	// Reloads add their listeners again; keep one of each.
+	//
+	if(dynbuf_find(dynbuf(info->listeners), &new_listener, sizeof(struct lodge_asset_listener)) >= 0) {
+		return;
+	}
+
+	struct lodge_asset_listener *listener = dynbuf_append(dynbuf(info->listeners), &new_listener, sizeof(struct lodge_asset_listener));
 	ASSERT_OR(listener) { return; }
 }
 
@@ -310,8 +770,6 @@ void lodge_assets2_remove_listener(struct lodge_assets2 *assets, lodge_asset_t a
 	LODGE_UNUSED(removed);
 }
 
-#include "log.h"
-
 void lodge_assets2_invalidate(struct lodge_assets2 *assets, lodge_asset_t asset)
 {
 	ASSERT_OR(assets && asset) { return; }
@@ -323,6 +781,15 @@ void lodge_assets2_invalidate(struct lodge_assets2 *assets, lodge_asset_t asset)
 
 	debugf("Assets", "Invalidating `" STRVIEW_PRINTF_FMT "::%s`...\n", STRVIEW_PRINTF_ARG(assets->desc.name), asset_info->name);
 
+	//
+	// A load being finalized is already newer than what invalidated it (eg. its finalizer
+	// replacing a file it listens to), and the finalizer still uses it.
+	//
+	if(asset_info->load && !asset_info->load->finalizing) {
+		lodge_assets2_cancel_load(assets, asset_info->load);
+	}
+	asset_info->load_failed = false;
+
 	void *asset_data = sparse_set_get(assets->set, index);
 	if(asset_data) {
 		assets->desc.free_inplace(assets, strview_wrap(asset_info->name), asset, asset_data);
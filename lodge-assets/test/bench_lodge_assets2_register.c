@@ -0,0 +1,71 @@
+//
+// Registering and looking up asset names, as a project with a large asset directory does
+// when it starts: every name through `lodge_assets2_register`, then again through
+// `_find_by_name` and `_register` once they all exist.
+//
+// Usage: bench_lodge_assets2_register [names]
+//
+
+#include "lodge_assets2.h"
+#include "lodge_time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static bool bench_asset_new_inplace(struct lodge_assets2 *assets, strview_t name, lodge_asset_t asset, void *data)
+{
+	return true;
+}
+
+static void bench_asset_free_inplace(struct lodge_assets2 *assets, strview_t name, lodge_asset_t asset, void *data)
+{
+}
+
+static strview_t bench_name(char *buf, size_t buf_size, uint32_t index)
+{
+	return strview_make(buf, snprintf(buf, buf_size, "textures/dir%u/file_%u.png", index % 97, index));
+}
+
+int main(int argc, char **argv)
+{
+	const uint32_t names_count = (argc > 1) ? (uint32_t)atoi(argv[1]) : 100000;
+
+	struct lodge_assets2 *assets = (struct lodge_assets2 *)calloc(1, lodge_assets2_sizeof());
+	lodge_assets2_new_inplace(assets, &(struct lodge_assets2_desc) {
+		.name = strview_static("bench_assets"),
+		.size = sizeof(int),
+		.new_inplace = &bench_asset_new_inplace,
+		.free_inplace = &bench_asset_free_inplace,
+	});
+
+	char name[64];
+	uint32_t misses = 0;
+
+	lodge_timestamp_t before = lodge_timestamp_get();
+	for(uint32_t i = 0; i < names_count; i++) {
+		misses += lodge_assets2_register(assets, bench_name(name, sizeof(name), i)) ? 0 : 1;
+	}
+	const double register_ms = lodge_timestamp_elapsed_ms(before);
+
+	before = lodge_timestamp_get();
+	for(uint32_t i = 0; i < names_count; i++) {
+		misses += lodge_assets2_find_by_name(assets, bench_name(name, sizeof(name), i)) ? 0 : 1;
+	}
+	const double find_ms = lodge_timestamp_elapsed_ms(before);
+
+	before = lodge_timestamp_get();
+	for(uint32_t i = 0; i < names_count; i++) {
+		misses += lodge_assets2_register(assets, bench_name(name, sizeof(name), i)) ? 0 : 1;
+	}
+	const double reregister_ms = lodge_timestamp_elapsed_ms(before);
+
+	printf("%u names (%u misses)\n", names_count, misses);
+	printf("register      total: %8.3f ms  avg: %6.1f ns/name\n", register_ms, register_ms * 1e6 / names_count);
+	printf("find_by_name  total: %8.3f ms  avg: %6.1f ns/name\n", find_ms, find_ms * 1e6 / names_count);
+	printf("re-register   total: %8.3f ms  avg: %6.1f ns/name\n", reregister_ms, reregister_ms * 1e6 / names_count);
+
+	lodge_assets2_free_inplace(assets);
+	free(assets);
+
+	return misses ? 1 : 0;
+}
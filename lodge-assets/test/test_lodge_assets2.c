@@ -0,0 +1,128 @@
+//
+// Name lookup in `lodge_assets2`: registering, finding and loading assets by name,
+// including names whose hashes collide.
+//
+
+#include "lodge_assets2.h"
+#include "lodge_platform.h"
+
+#include "lodge_test.h"
+
+#include "strbuf.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//
+// Each asset holds the name it was loaded from.
+//
+struct test_asset
+{
+	char						name[256];
+};
+
+static bool test_asset_new_inplace(struct lodge_assets2 *assets, strview_t name, lodge_asset_t asset, struct test_asset *data)
+{
+	strbuf_set(strbuf(data->name), name);
+	return true;
+}
+
+static void test_asset_free_inplace(struct lodge_assets2 *assets, strview_t name, lodge_asset_t asset, struct test_asset *data)
+{
+}
+
+static struct lodge_assets2* test_assets_new()
+{
+	struct lodge_assets2 *assets = (struct lodge_assets2 *)calloc(1, lodge_assets2_sizeof());
+	lodge_assets2_new_inplace(assets, &(struct lodge_assets2_desc) {
+		.name = strview_static("test_assets"),
+		.size = sizeof(struct test_asset),
+		.new_inplace = &test_asset_new_inplace,
+		.free_inplace = &test_asset_free_inplace,
+	});
+	return assets;
+}
+
+static void test_assets_free(struct lodge_assets2 *assets)
+{
+	lodge_assets2_free_inplace(assets);
+	free(assets);
+}
+
+static bool test_name_equals(struct lodge_assets2 *assets, lodge_asset_t asset, strview_t name)
+{
+	return strview_equals(lodge_assets2_get_name(assets, asset), name);
+}
+
+static void test_register_find()
+{
+	struct lodge_assets2 *assets = test_assets_new();
+
+	//
+	// Enough names to grow the name index several times.
+	//
+	const uint32_t count = 5000;
+	lodge_asset_t *registered = (lodge_asset_t *)malloc(count * sizeof(lodge_asset_t));
+
+	char name[64];
+	for(uint32_t i = 0; i < count; i++) {
+		const strview_t name_view = strview_make(name, snprintf(name, sizeof(name), "textures/dir%u/file_%u.png", i % 97, i));
+		registered[i] = lodge_assets2_register(assets, name_view);
+		LODGE_TEST_CHECK(registered[i]);
+	}
+
+	for(uint32_t i = 0; i < count; i++) {
+		const strview_t name_view = strview_make(name, snprintf(name, sizeof(name), "textures/dir%u/file_%u.png", i % 97, i));
+		LODGE_TEST_CHECK_MSG(lodge_assets2_find_by_name(assets, name_view) == registered[i], "%s", name);
+		LODGE_TEST_CHECK_MSG(lodge_assets2_register(assets, name_view) == registered[i], "%s", name);
+		LODGE_TEST_CHECK_MSG(test_name_equals(assets, registered[i], name_view), "%s", name);
+	}
+
+	LODGE_TEST_CHECK(!lodge_assets2_find_by_name(assets, strview_static("textures/missing.png")));
+
+	free(registered);
+	test_assets_free(assets);
+}
+
+//
+// Two names with the same murmur3 hash, found by brute force over "textures/<n>.png".
+//
+static void test_colliding_names_not_aliased()
+{
+	const strview_t first = strview_static("textures/60210.png");
+	const strview_t second = strview_static("textures/129514.png");
+
+	LODGE_TEST_CHECK(strview_calc_hash(first) == strview_calc_hash(second));
+
+	struct lodge_assets2 *assets = test_assets_new();
+
+	const lodge_asset_t first_asset = lodge_assets2_register(assets, first);
+	LODGE_TEST_CHECK(!lodge_assets2_find_by_name(assets, second));
+
+	const lodge_asset_t second_asset = lodge_assets2_register(assets, second);
+	LODGE_TEST_CHECK(first_asset && second_asset);
+	LODGE_TEST_CHECK(first_asset != second_asset);
+
+	LODGE_TEST_CHECK(lodge_assets2_find_by_name(assets, first) == first_asset);
+	LODGE_TEST_CHECK(lodge_assets2_find_by_name(assets, second) == second_asset);
+	LODGE_TEST_CHECK(lodge_assets2_register(assets, first) == first_asset);
+	LODGE_TEST_CHECK(lodge_assets2_register(assets, second) == second_asset);
+
+	LODGE_TEST_CHECK(test_name_equals(assets, first_asset, first));
+	LODGE_TEST_CHECK(test_name_equals(assets, second_asset, second));
+
+	const struct test_asset *first_data = lodge_assets2_get(assets, first_asset);
+	const struct test_asset *second_data = lodge_assets2_get(assets, second_asset);
+	LODGE_TEST_CHECK(first_data && second_data && first_data != second_data);
+	LODGE_TEST_CHECK(first_data && strview_equals(strview_wrap(first_data->name), first));
+	LODGE_TEST_CHECK(second_data && strview_equals(strview_wrap(second_data->name), second));
+
+	test_assets_free(assets);
+}
+
+int main(int argc, char **argv)
+{
+	LODGE_TEST_RUN(test_register_find);
+	LODGE_TEST_RUN(test_colliding_names_not_aliased);
+	return lodge_test_result();
+}
@@ -6,6 +6,8 @@
 #include <string.h>
 #include <stdlib.h>
 
+#define SPARSE_SET_PAGES_MAX 1024
+
 struct sparse_set
 {
 	char		*dense;
@@ -21,8 +23,13 @@ struct sparse_set
 	size_t		dense_count_capacity;
 	size_t		dense_count;
 
-	uint32_t	*sparse[1024];
+	uint32_t	*sparse[SPARSE_SET_PAGES_MAX];
 	uint32_t	sparse_indices_per_page;
+
+	//
+	// Bumped whenever the dense array is reordered, grown or shrunk.
+	//
+	uint32_t	version;
 };
 
 sparse_set_t sparse_set_new(size_t dense_element_size, size_t dense_elements_count_default, uint32_t sparse_indices_per_page)
@@ -46,7 +53,7 @@ sparse_set_t sparse_set_new(size_t dense_element_size, size_t dense_elements_cou
 
 void sparse_set_free(sparse_set_t set)
 {
-	for(uint32_t i = 0; i < 1024; i++) {
+	for(uint32_t i = 0; i < SPARSE_SET_PAGES_MAX; i++) {
 		if(set->sparse[i]) {
 			free(set->sparse[i]);
 		}
@@ -63,6 +70,10 @@ void* sparse_set_get(sparse_set_t set, uint32_t index)
 	const uint32_t sparse_index = index / set->sparse_indices_per_page;
 	const uint32_t page_index = index % set->sparse_indices_per_page;
 
+	if(sparse_index >= SPARSE_SET_PAGES_MAX) {
+		return NULL;
+	}
+
 	const uint32_t *sparse_page = set->sparse[sparse_index];
 	if(!sparse_page) {
 		return NULL;
@@ -98,6 +109,10 @@ void* sparse_set_set_no_init(sparse_set_t set, uint32_t index)
 	const uint32_t sparse_index = index / set->sparse_indices_per_page;
 	const uint32_t page_index = index % set->sparse_indices_per_page;
 
+	ASSERT_OR(sparse_index < SPARSE_SET_PAGES_MAX) {
+		return NULL;
+	}
+
 	uint32_t *sparse_page = set->sparse[sparse_index];
 	if(!sparse_page) {
 		sparse_page = (uint32_t*)calloc(set->sparse_indices_per_page, sizeof(uint32_t));
@@ -107,6 +122,7 @@ void* sparse_set_set_no_init(sparse_set_t set, uint32_t index)
 	size_t dense_index = sparse_page[page_index];
 	if(dense_index == 0) {
 		dense_index = set->dense_count++;
+		set->version++;
 		// The dense_index is encoded as `index+1` in the sparse page, as 0 signifies an unused index.
 		sparse_page[page_index] = dense_index + 1;
 	} else {
@@ -153,6 +169,11 @@ size_t sparse_set_get_dense_count(sparse_set_t sparse_set)
 	return sparse_set ? sparse_set->dense_count : 0;
 }
 
+uint32_t sparse_set_get_version(sparse_set_t sparse_set)
+{
+	return sparse_set ? sparse_set->version : 0;
+}
+
 void* sparse_set_set(sparse_set_t set, uint32_t index, const void *src)
 {
 	void *dst = sparse_set_set_no_init(set, index);
@@ -175,6 +196,9 @@ uint32_t* sparse_set_index_to_sparse_page_ptr(sparse_set_t set, uint32_t index)
 {
 	const uint32_t sparse_index = index / set->sparse_indices_per_page;
 	const uint32_t page_index = index % set->sparse_indices_per_page;
+	if(sparse_index >= SPARSE_SET_PAGES_MAX) {
+		return NULL;
+	}
 	uint32_t *sparse_page = set->sparse[sparse_index];
 	if(!sparse_page) {
 		return NULL;
@@ -196,6 +220,8 @@ void sparse_set_remove(sparse_set_t set, uint32_t index)
 	}
 	dense_index -= 1;
 
+	set->version++;
+
 	membuf_t buf = membuf_make(set->dense, set->dense_count_capacity * set->dense_element_size, set->dense_element_size);
 
 	size_t index_b = sparse_set_get_index(set, membuf_get(buf, set->dense_count - 1));
@@ -18,6 +18,13 @@ void*			sparse_set_set_init_zero(sparse_set_t set, uint32_t index);
 
 size_t			sparse_set_get_dense_count(sparse_set_t sparse_set);
 
+//
+// Changes every time an element is added or removed, which may move other
+// elements in the dense array. Pointers into the set stay valid as long as
+// the version is unchanged.
+//
+uint32_t		sparse_set_get_version(sparse_set_t sparse_set);
+
 void			sparse_set_remove(sparse_set_t set, uint32_t index);
 
 //
@@ -31,6 +31,11 @@ lodge_component_type_t					lodge_component_types_find(strview_t name);
 
 lodge_component_type_t					lodge_component_type_register(struct lodge_component_desc desc);
 
+//
+// Dense index in registration order, `0 <= index < lodge_component_types_get_count()`.
+//
+size_t									lodge_component_type_get_index(lodge_component_type_t component_type);
+
 strview_t								lodge_component_type_get_name(lodge_component_type_t component_type);
 strview_t								lodge_component_type_get_description(lodge_component_type_t component_type);
 size_t									lodge_component_type_get_size(lodge_component_type_t component_type);
@@ -21,9 +21,17 @@ typedef struct lodge_entity_type* lodge_entity_type_t;
 struct lodge_component;
 typedef struct lodge_component* lodge_component_t;
 
+//
+// Entity handles carry the entity ID in the low `LODGE_ENTITY_ID_BITS` bits
+// and a generation above them, so handles to removed entities are detected
+// even after their ID has been reused. IDs are kept small enough to be
+// stored exactly in a float (eg. for GPU picking).
+//
 struct lodge_entity;
 typedef struct lodge_entity* lodge_entity_t;
 
+#define LODGE_ENTITY_ID_BITS		24
+
 struct lodge_component_type;
 typedef struct lodge_component_type* lodge_component_type_t;
 
@@ -31,6 +39,10 @@ struct lodge_system_render_params;
 
 struct lodge_entity_components_desc;
 
+struct lodge_jobs;
+
+struct lodge_transform_cache;
+
 struct lodge_component_it
 {
 	void					*value;
@@ -52,6 +64,51 @@ struct lodge_entity_desc
 	char					name[256];
 };
 
+struct lodge_scene_update_stats
+{
+	double					elapsed_ms;			// Wall time of the last `lodge_scene_update`.
+	uint32_t				systems_count;
+	uint32_t				threads_count;		// 0 if the last update ran serially.
+	uint32_t				critical_path;		// Longest chain of conflicting systems.
+};
+
+#define LODGE_SCENE_QUERY_COMPONENTS_MAX	8
+
+struct lodge_scene_query_entities
+{
+	size_t					count;
+	size_t					capacity;
+	lodge_entity_t			*elements;
+};
+
+struct lodge_scene_query_components
+{
+	size_t					count;
+	size_t					capacity;
+	void					**elements;
+};
+
+//
+// Matches all entities that have every one of `component_types`.
+//
+// The matches are cached and only rebuilt when one of the queried component
+// sets has had components added or removed since the last refresh, so
+// iterating a query is a linear walk over packed arrays.
+//
+struct lodge_scene_query
+{
+	lodge_scene_t			scene;
+	size_t					component_types_count;
+	lodge_component_type_t	component_types[LODGE_SCENE_QUERY_COMPONENTS_MAX];
+
+	struct sparse_set		*sets[LODGE_SCENE_QUERY_COMPONENTS_MAX];
+	uint32_t				versions[LODGE_SCENE_QUERY_COMPONENTS_MAX];
+	bool					valid;
+
+	struct lodge_scene_query_entities	entities;
+	struct lodge_scene_query_components	components;		// `component_types_count` pointers per match.
+};
+
 struct lodge_scene_funcs
 {
 	struct  
@@ -80,7 +137,12 @@ size_t						lodge_scene_sizeof();
 lodge_entity_t				lodge_scene_add_entity_from_type(lodge_scene_t scene, lodge_entity_type_t entity_type);
 lodge_entity_t				lodge_scene_add_entity_from_desc(lodge_scene_t scene, const struct lodge_entity_desc *entity_desc, const struct lodge_entity_components_desc *components_desc);
 lodge_component_t			lodge_scene_add_entity_component(lodge_scene_t scene, lodge_entity_t entity_handle, lodge_component_type_t component_type);
-bool						lodge_scene_remove_entity(lodge_scene_t scene, lodge_entity_t entity_type);
+bool						lodge_scene_remove_entity(lodge_scene_t scene, lodge_entity_t entity);
+bool						lodge_scene_is_entity_valid(lodge_scene_t scene, lodge_entity_t entity);
+size_t						lodge_scene_get_entities_count(lodge_scene_t scene);
+
+uint32_t					lodge_entity_get_id(lodge_entity_t entity);
+lodge_entity_t				lodge_scene_get_entity_by_id(lodge_scene_t scene, uint32_t entity_id);
 
 lodge_system_t				lodge_scene_add_system(lodge_scene_t scene, lodge_system_type_t system_type);
 void*						lodge_scene_get_system(lodge_scene_t scene, lodge_system_type_t system_type);
@@ -106,6 +168,8 @@ struct lodge_system_it		lodge_scene_systems_begin(lodge_scene_t scene);
 struct lodge_system_it		lodge_scene_systems_next(lodge_scene_t scene, struct lodge_system_it current_system);
 
 void						lodge_scene_update(lodge_scene_t scene, float dt);
+void						lodge_scene_set_jobs(lodge_scene_t scene, struct lodge_jobs *jobs);
+struct lodge_scene_update_stats lodge_scene_get_update_stats(lodge_scene_t scene);
 float						lodge_scene_get_time(lodge_scene_t scene);
 
 void						lodge_scene_render(lodge_scene_t scene, struct lodge_system_render_params *render_params);
@@ -115,6 +179,16 @@ bool						lodge_scene_is_entity_selected(lodge_scene_t scene, lodge_entity_t ent
 
 struct lodge_scene_funcs*	lodge_scene_get_funcs(lodge_scene_t scene);
 
+uint32_t					lodge_scene_get_hierarchy_version(lodge_scene_t scene);
+struct lodge_transform_cache* lodge_scene_get_transform_cache(lodge_scene_t scene);
+
+void						lodge_scene_query_new_inplace(struct lodge_scene_query *query, lodge_scene_t scene, size_t component_types_count, const lodge_component_type_t *component_types);
+void						lodge_scene_query_free_inplace(struct lodge_scene_query *query);
+size_t						lodge_scene_query_refresh(struct lodge_scene_query *query);
+bool						lodge_scene_query_is_stale(const struct lodge_scene_query *query);
+lodge_entity_t				lodge_scene_query_get_entity(const struct lodge_scene_query *query, size_t index);
+void*						lodge_scene_query_get_component(const struct lodge_scene_query *query, size_t index, size_t component_index);
+
 #define						lodge_scene_entities_foreach(SCENE, IT) \
 	for(lodge_entity_t IT = lodge_scene_entities_begin(SCENE); IT; IT = lodge_scene_entities_next(SCENE, IT))
 
@@ -127,4 +201,15 @@ struct lodge_scene_funcs*	lodge_scene_get_funcs(lodge_scene_t scene);
 #define						lodge_scene_systems_foreach(SCENE, IT) \
 	for(struct lodge_system_it IT = lodge_scene_systems_begin(SCENE); IT.value; IT = lodge_scene_systems_next(SCENE, IT))
 
+//
+// Example:
+//
+//		lodge_scene_query_foreach(&query, i) {
+//			lodge_entity_t entity = lodge_scene_query_get_entity(&query, i);
+//			struct lodge_transform_component *transform = lodge_scene_query_get_component(&query, i, 0);
+//		}
+//
+#define						lodge_scene_query_foreach(QUERY, IT) \
+	for(size_t IT = 0, IT##_count = lodge_scene_query_refresh(QUERY); IT < IT##_count; IT++)
+
 #endif
\ No newline at end of file
@@ -40,6 +40,33 @@ struct lodge_system_plugins_desc
 	strview_t								elements[8];
 };
 
+struct lodge_system_components_desc
+{
+	size_t									count;
+	lodge_component_type_t					elements[16];
+};
+
+enum lodge_system_type_flags
+{
+	LODGE_SYSTEM_TYPE_FLAG_NONE				= 0,
+
+	//
+	// `reads` and `writes` list every component type `update` touches, so the
+	// scene may run it concurrently with systems it does not conflict with.
+	// Systems without this flag always run alone, on the main thread.
+	//
+	// Adding or removing entities and components is only safe from systems
+	// without this flag.
+	//
+	LODGE_SYSTEM_TYPE_FLAG_CONCURRENT		= LODGE_BIT(1),
+
+	//
+	// `update` must run on the thread calling `lodge_scene_update`, eg. because
+	// it loads assets or talks to the graphics API.
+	//
+	LODGE_SYSTEM_TYPE_FLAG_MAIN_THREAD		= LODGE_BIT(2),
+};
+
 struct lodge_system_type_desc
 {
 	strview_t								name;
@@ -66,6 +93,10 @@ struct lodge_system_type_desc
 	};
 
 	struct lodge_properties					properties;
+
+	uint32_t								flags;
+	struct lodge_system_components_desc		reads;
+	struct lodge_system_components_desc		writes;
 };
 
 lodge_system_type_t							lodge_system_type_register(struct lodge_system_type_desc desc);
@@ -81,6 +112,14 @@ strview_t									lodge_system_type_get_name(lodge_system_type_t system_type);
 struct lodge_properties*					lodge_system_type_get_properties(lodge_system_type_t system_type);
 LODGE_DEPRECATED void*						lodge_system_type_get_plugin(lodge_system_type_t system_type);
 void*										lodge_system_type_get_userdata(lodge_system_type_t system_type);
+uint32_t									lodge_system_type_get_flags(lodge_system_type_t system_type);
+
+//
+// Returns true if the two system types can not run concurrently: one writes a
+// component type the other reads or writes, or either lacks
+// `LODGE_SYSTEM_TYPE_FLAG_CONCURRENT`.
+//
+bool										lodge_system_type_conflicts(lodge_system_type_t lhs, lodge_system_type_t rhs);
 
 lodge_system_type_t							lodge_system_type_find(strview_t name);
 
@@ -58,4 +58,22 @@ void							lodge_set_scale(lodge_scene_t scene, lodge_entity_t entity, vec3 scal
 
 mat4							lodge_rotation_to_matrix(const vec3 rotation);
 
+//
+// Per-scene cache of world space transforms, owned by `lodge_scene`.
+//
+// `lodge_transform_cache_update` is called at the start of every
+// `lodge_scene_update` and refreshes only the subtrees that were modified
+// since the last update. The `lodge_get_*` helpers above read from the cache
+// and fall back to walking the hierarchy for entities modified through the
+// `lodge_set_*` helpers since then.
+//
+// NOTE(TS): writes directly to a `lodge_transform_component` are picked up
+// on the next update, not immediately.
+//
+struct lodge_transform_cache;
+
+struct lodge_transform_cache*	lodge_transform_cache_new();
+void							lodge_transform_cache_free(struct lodge_transform_cache *cache);
+void							lodge_transform_cache_update(struct lodge_transform_cache *cache, lodge_scene_t scene);
+
 #endif
\ No newline at end of file
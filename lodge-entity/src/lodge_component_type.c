@@ -56,6 +56,13 @@ size_t lodge_component_types_get_count()
 	return lodge_component_types_count;
 }
 
+size_t lodge_component_type_get_index(lodge_component_type_t type)
+{
+	const size_t index = lodge_component_type_to_index(type);
+	ASSERT(index < lodge_component_types_count);
+	return index;
+}
+
 lodge_component_type_t lodge_component_types_find(strview_t name)
 {
 	for(size_t i = 0; i < lodge_component_types_count; i++) {
@@ -4,11 +4,16 @@
 #include "lodge_component_type.h"
 #include "lodge_system_type.h"
 #include "lodge_bound_func.h"
+#include "lodge_transform_component.h"
+#include "lodge_jobs.h"
+#include "lodge_thread.h"
+#include "lodge_time.h"
 
 #include "str.h"
 #include "membuf.h"
 #include "strbuf.h"
 #include "sparse_set.h"
+#include "dynbuf.h"
 
 #include <stdbool.h>
 
@@ -24,6 +29,78 @@ struct lodge_component_set
 	sparse_set_t					set;
 };
 
+struct lodge_component_sets
+{
+	size_t							count;
+	size_t							capacity;
+	struct lodge_component_set		*elements;
+};
+
+struct lodge_systems
+{
+	size_t							count;
+	size_t							capacity;
+	struct lodge_system				*elements;
+};
+
+//
+// One node per system in the update DAG. Edges point from a system to the
+// later-registered systems it conflicts with, so conflicting systems always
+// run in registration order.
+//
+struct lodge_system_node
+{
+	struct lodge_scene				*scene;
+	uint32_t						index;
+	bool							main_thread;
+	uint32_t						dependencies_count;
+	volatile int32_t				dependencies_pending;
+	uint32_t						dependents_offset;
+	uint32_t						dependents_count;
+};
+
+struct lodge_system_nodes
+{
+	size_t							count;
+	size_t							capacity;
+	struct lodge_system_node		*elements;
+};
+
+struct lodge_system_indices
+{
+	size_t							count;
+	size_t							capacity;
+	uint32_t						*elements;
+};
+
+struct lodge_system_schedule
+{
+	bool							dirty;
+	float							dt;
+	uint32_t						critical_path;
+
+	struct lodge_system_nodes		nodes;
+	struct lodge_system_indices		dependents;
+
+	//
+	// Nodes that must run on the calling thread, pushed by workers when their
+	// dependencies finish.
+	//
+	struct lodge_system_indices		main_thread_ready;
+	volatile int32_t				remaining;
+
+	lodge_mutex_t					mutex;
+	lodge_cond_t					cond;
+	struct lodge_job_counter		counter;
+};
+
+struct lodge_entity_ids
+{
+	size_t							count;
+	size_t							capacity;
+	uint32_t						*elements;
+};
+
 struct lodge_scene
 {
 	float							time;
@@ -31,28 +108,63 @@ struct lodge_scene
 	sparse_set_t					entities;
 	size_t							entities_last_id;
 
-	struct lodge_component_set		component_sets[32];
-	size_t							component_sets_count;
+	//
+	// Indexed by entity ID; bumped when an entity is removed so handles to
+	// it (and to whatever later reuses its ID) can be told apart.
+	//
+	struct lodge_entity_ids			entities_generations;
+	struct lodge_entity_ids			entities_free_ids;
+
+	//
+	// Number of entities with a parent; lets removal skip the child scan
+	// for flat scenes.
+	//
+	size_t							entities_parented_count;
+
+	//
+	// Bumped whenever an entity's parent may have changed.
+	//
+	uint32_t						hierarchy_version;
+	struct lodge_transform_cache	*transform_cache;
 
-	struct lodge_system				systems[32];
-	size_t							systems_count;
+	struct lodge_component_sets		component_sets;
+
+	//
+	// Indexed by component type index; `index + 1` into `component_sets`,
+	// or 0 if the scene has no set for that type yet.
+	//
+	struct lodge_entity_ids			component_set_indices;
+
+	struct lodge_systems			systems;
 
 	struct lodge_scene_funcs		funcs;
+
+	struct lodge_jobs				*jobs;
+	struct lodge_system_schedule	schedule;
+	struct lodge_scene_update_stats	update_stats;
 };
 
+#define LODGE_ENTITY_ID_MASK			((uint32_t)((1u << LODGE_ENTITY_ID_BITS) - 1))
+#define LODGE_ENTITY_GENERATION_MASK	((uint32_t)(UINTPTR_MAX >> LODGE_ENTITY_ID_BITS))
+
 #define COMPONENTS_COUNT_DEFAULT	(256)
 #define ENTITIES_COUNT_DEFAULT		(256)
 #define SPARSE_INDICES_PER_PAGE		(4 * 1024)
 
+//
+// NOTE(TS): the returned pointer is invalidated when a component set is added.
+//
 static struct lodge_component_set* lodge_component_set_get_by_type(lodge_scene_t scene, lodge_component_type_t type)
 {
-	for(size_t i = 0, count = scene->component_sets_count; i < count; i++) {
-		struct lodge_component_set *component_set = &scene->component_sets[i];
-		if(component_set->type == type) {
-			return component_set;
-		}
+	if(!type) {
+		return NULL;
 	}
-	return NULL;
+	const size_t type_index = lodge_component_type_get_index(type);
+	if(type_index >= scene->component_set_indices.count) {
+		return NULL;
+	}
+	const uint32_t set_index = scene->component_set_indices.elements[type_index];
+	return set_index ? &scene->component_sets.elements[set_index - 1] : NULL;
 }
 
 static struct lodge_component_set* lodge_component_set_get_or_add_by_type(lodge_scene_t scene, lodge_component_type_t type)
@@ -60,15 +172,21 @@ static struct lodge_component_set* lodge_component_set_get_or_add_by_type(lodge_
 	struct lodge_component_set *component_set = lodge_component_set_get_by_type(scene, type);
 
 	if(!component_set) {
-		component_set = membuf_append(
-			membuf_wrap(scene->component_sets),
-			&scene->component_sets_count,
+		component_set = dynbuf_append(
+			dynbuf(scene->component_sets),
 			&(struct lodge_component_set) {
 				.type = type,
 				.set = sparse_set_new(lodge_component_type_get_size(type), COMPONENTS_COUNT_DEFAULT, SPARSE_INDICES_PER_PAGE),
 			},
 			sizeof(struct lodge_component_set)
 		);
+
+		const size_t type_index = lodge_component_type_get_index(type);
+		const uint32_t none = 0;
+		while(scene->component_set_indices.count <= type_index) {
+			dynbuf_append(dynbuf(scene->component_set_indices), &none, sizeof(uint32_t));
+		}
+		scene->component_set_indices.elements[type_index] = (uint32_t)scene->component_sets.count;
 	}
 
 	ASSERT(component_set);
@@ -90,18 +208,34 @@ static lodge_component_t lodge_scene_add_component_internal(lodge_scene_t scene,
 	return component;
 }
 
+static uint32_t lodge_entity_get_generation(lodge_entity_t entity)
+{
+	return (uint32_t)(((uintptr_t)entity >> LODGE_ENTITY_ID_BITS) & LODGE_ENTITY_GENERATION_MASK);
+}
+
+static lodge_entity_t lodge_entity_make(uint32_t id, uint32_t generation)
+{
+	return (lodge_entity_t)(((uintptr_t)(generation & LODGE_ENTITY_GENERATION_MASK) << LODGE_ENTITY_ID_BITS) | (uintptr_t)id);
+}
+
 static struct lodge_entity_desc* lodge_entity_desc_from_entity(lodge_scene_t scene, lodge_entity_t entity)
 {
 	if(!entity) {
 		return NULL;
 	}
-	const size_t entity_id = (size_t)((uintptr_t)entity - 1);
+	const uint32_t entity_id = lodge_entity_get_id(entity);
+	if(entity_id >= scene->entities_generations.count) {
+		return NULL;
+	}
+	if(lodge_entity_get_generation(entity) != (scene->entities_generations.elements[entity_id] & LODGE_ENTITY_GENERATION_MASK)) {
+		return NULL;
+	}
 	return sparse_set_get(scene->entities, entity_id);
 }
 
-static lodge_entity_t lodge_entity_desc_to_entity(struct lodge_entity_desc *entity)
+static lodge_entity_t lodge_entity_desc_to_entity(lodge_scene_t scene, struct lodge_entity_desc *entity)
 {
-	return entity ? (lodge_entity_t)((uintptr_t)entity->id + 1) : NULL;
+	return entity ? lodge_entity_make((uint32_t)entity->id, scene->entities_generations.elements[entity->id]) : NULL;
 }
 
 void lodge_scene_new_inplace(lodge_scene_t scene)
@@ -109,9 +243,24 @@ void lodge_scene_new_inplace(lodge_scene_t scene)
 	scene->time = 0.0f;
 	//scene->entities_count = 0;
 	scene->entities_last_id = 0;
-	scene->systems_count = 0;
+	scene->systems = (struct lodge_systems) { 0 };
+	scene->component_sets = (struct lodge_component_sets) { 0 };
+	scene->component_set_indices = (struct lodge_entity_ids) { 0 };
 
 	scene->entities = sparse_set_new(sizeof(struct lodge_entity_desc), ENTITIES_COUNT_DEFAULT, SPARSE_INDICES_PER_PAGE);
+	scene->entities_generations = (struct lodge_entity_ids) { 0 };
+	scene->entities_free_ids = (struct lodge_entity_ids) { 0 };
+	scene->entities_parented_count = 0;
+	scene->hierarchy_version = 0;
+	scene->transform_cache = lodge_transform_cache_new();
+
+	scene->jobs = NULL;
+	scene->schedule = (struct lodge_system_schedule) {
+		.dirty = true,
+		.mutex = lodge_mutex_new(),
+		.cond = lodge_cond_new(),
+	};
+	scene->update_stats = (struct lodge_scene_update_stats) { 0 };
 }
 
 void lodge_scene_free_inplace(lodge_scene_t scene)
@@ -119,26 +268,44 @@ void lodge_scene_free_inplace(lodge_scene_t scene)
 	//
 	// Free systems
 	//
-	for(size_t i = 0; i < scene->systems_count; i++) {
-		lodge_system_type_free_inplace(scene->systems[i].type, scene->systems[i].data, scene);
+	for(size_t i = 0; i < scene->systems.count; i++) {
+		lodge_system_type_free_inplace(scene->systems.elements[i].type, scene->systems.elements[i].data, scene);
+		free(scene->systems.elements[i].data);
 	}
+	dynbuf_free_inplace(dynbuf(scene->systems));
 
 	//
 	// Free components
 	//
-	for(size_t i = 0, count = scene->component_sets_count; i < count; i++) {
-		struct lodge_component_set *component_set = &scene->component_sets[i];
+	for(size_t i = 0, count = scene->component_sets.count; i < count; i++) {
+		struct lodge_component_set *component_set = &scene->component_sets.elements[i];
 		lodge_component_type_t type = component_set->type;
 
 		for(void *it = sparse_set_it_begin(component_set->set); it; it = sparse_set_it_next(component_set->set, it)) {
 			lodge_component_type_free_inplace(type, it);
 		}
+
+		sparse_set_free(component_set->set);
 	}
+	dynbuf_free_inplace(dynbuf(scene->component_sets));
+	dynbuf_free_inplace(dynbuf(scene->component_set_indices));
 
 	//
 	// Free entities
 	//
 	sparse_set_free(scene->entities);
+	dynbuf_free_inplace(dynbuf(scene->entities_generations));
+	dynbuf_free_inplace(dynbuf(scene->entities_free_ids));
+	lodge_transform_cache_free(scene->transform_cache);
+
+	//
+	// Free schedule
+	//
+	dynbuf_free_inplace(dynbuf(scene->schedule.nodes));
+	dynbuf_free_inplace(dynbuf(scene->schedule.dependents));
+	dynbuf_free_inplace(dynbuf(scene->schedule.main_thread_ready));
+	lodge_cond_free(scene->schedule.cond);
+	lodge_mutex_free(scene->schedule.mutex);
 }
 
 size_t lodge_scene_sizeof()
@@ -146,35 +313,255 @@ size_t lodge_scene_sizeof()
 	return sizeof(struct lodge_scene);
 }
 
+static void lodge_system_schedule_rebuild(lodge_scene_t scene)
+{
+	struct lodge_system_schedule *schedule = &scene->schedule;
+
+	dynbuf_clear(dynbuf(schedule->nodes));
+	dynbuf_clear(dynbuf(schedule->dependents));
+	dynbuf_clear(dynbuf(schedule->main_thread_ready));
+
+	for(uint32_t i = 0, count = (uint32_t)scene->systems.count; i < count; i++) {
+		const uint32_t flags = lodge_system_type_get_flags(scene->systems.elements[i].type);
+		struct lodge_system_node *node = dynbuf_append_no_init(dynbuf(schedule->nodes));
+		*node = (struct lodge_system_node) {
+			.scene = scene,
+			.index = i,
+			.main_thread = LODGE_IS_FLAG_SET(flags, LODGE_SYSTEM_TYPE_FLAG_MAIN_THREAD)
+				|| !LODGE_IS_FLAG_SET(flags, LODGE_SYSTEM_TYPE_FLAG_CONCURRENT),
+		};
+	}
+
+	//
+	// NOTE(TS): O(n^2) in the number of systems, but only redone when systems
+	// are added.
+	//
+	uint32_t *depths = LODGE_ALLOCA(sizeof(uint32_t) * max(scene->systems.count, 1));
+	schedule->critical_path = 0;
+
+	for(uint32_t i = 0, count = (uint32_t)schedule->nodes.count; i < count; i++) {
+		struct lodge_system_node *node = &schedule->nodes.elements[i];
+		node->dependents_offset = (uint32_t)schedule->dependents.count;
+		depths[i] = 1;
+
+		for(uint32_t j = 0; j < i; j++) {
+			if(lodge_system_type_conflicts(scene->systems.elements[j].type, scene->systems.elements[i].type)) {
+				depths[i] = max(depths[i], depths[j] + 1);
+			}
+		}
+		schedule->critical_path = max(schedule->critical_path, depths[i]);
+
+		for(uint32_t j = i + 1; j < count; j++) {
+			if(lodge_system_type_conflicts(scene->systems.elements[i].type, scene->systems.elements[j].type)) {
+				dynbuf_append(dynbuf(schedule->dependents), &j, sizeof(uint32_t));
+				schedule->nodes.elements[j].dependencies_count++;
+			}
+		}
+
+		node->dependents_count = (uint32_t)schedule->dependents.count - node->dependents_offset;
+	}
+
+	schedule->dirty = false;
+}
+
+static void lodge_system_node_run(void *node_ptr);
+
+static void lodge_system_node_dispatch(struct lodge_system_schedule *schedule, struct lodge_system_node *node)
+{
+	if(node->main_thread) {
+		lodge_mutex_lock(schedule->mutex);
+		dynbuf_append(dynbuf(schedule->main_thread_ready), &node->index, sizeof(uint32_t));
+		lodge_cond_broadcast(schedule->cond);
+		lodge_mutex_unlock(schedule->mutex);
+	} else {
+		lodge_jobs_submit(node->scene->jobs, &lodge_system_node_run, node, &schedule->counter);
+	}
+}
+
+static void lodge_system_node_run(void *node_ptr)
+{
+	struct lodge_system_node *node = (struct lodge_system_node *)node_ptr;
+	lodge_scene_t scene = node->scene;
+	struct lodge_system_schedule *schedule = &scene->schedule;
+	struct lodge_system *system = &scene->systems.elements[node->index];
+
+	lodge_system_type_update(system->type, system->data, scene, schedule->dt);
+
+	for(uint32_t i = 0; i < node->dependents_count; i++) {
+		struct lodge_system_node *dependent = &schedule->nodes.elements[schedule->dependents.elements[node->dependents_offset + i]];
+		if(lodge_atomic_add_i32(&dependent->dependencies_pending, -1) == 0) {
+			lodge_system_node_dispatch(schedule, dependent);
+		}
+	}
+
+	if(lodge_atomic_add_i32(&schedule->remaining, -1) == 0) {
+		lodge_mutex_lock(schedule->mutex);
+		lodge_cond_broadcast(schedule->cond);
+		lodge_mutex_unlock(schedule->mutex);
+	}
+}
+
+static void lodge_scene_update_parallel(lodge_scene_t scene, float dt)
+{
+	struct lodge_system_schedule *schedule = &scene->schedule;
+
+	if(schedule->dirty) {
+		lodge_system_schedule_rebuild(scene);
+	}
+
+	const uint32_t nodes_count = (uint32_t)schedule->nodes.count;
+	if(nodes_count == 0) {
+		return;
+	}
+
+	schedule->dt = dt;
+	lodge_atomic_store_i32(&schedule->remaining, (int32_t)nodes_count);
+	for(uint32_t i = 0; i < nodes_count; i++) {
+		struct lodge_system_node *node = &schedule->nodes.elements[i];
+		lodge_atomic_store_i32(&node->dependencies_pending, (int32_t)node->dependencies_count);
+	}
+
+	for(uint32_t i = 0; i < nodes_count; i++) {
+		struct lodge_system_node *node = &schedule->nodes.elements[i];
+		if(node->dependencies_count == 0) {
+			lodge_system_node_dispatch(schedule, node);
+		}
+	}
+
+	//
+	// Run main thread systems as they become ready, lowest index first, until
+	// every system has finished.
+	//
+	lodge_mutex_lock(schedule->mutex);
+	while(lodge_atomic_load_i32(&schedule->remaining) > 0) {
+		if(schedule->main_thread_ready.count > 0) {
+			size_t ready_index = 0;
+			for(size_t i = 1; i < schedule->main_thread_ready.count; i++) {
+				if(schedule->main_thread_ready.elements[i] < schedule->main_thread_ready.elements[ready_index]) {
+					ready_index = i;
+				}
+			}
+			const uint32_t node_index = schedule->main_thread_ready.elements[ready_index];
+			dynbuf_remove(dynbuf(schedule->main_thread_ready), ready_index, 1);
+
+			lodge_mutex_unlock(schedule->mutex);
+			lodge_system_node_run(&schedule->nodes.elements[node_index]);
+			lodge_mutex_lock(schedule->mutex);
+		} else {
+			lodge_cond_wait(schedule->cond, schedule->mutex);
+		}
+	}
+	lodge_mutex_unlock(schedule->mutex);
+
+	//
+	// All systems are done, but workers may still be unwinding their jobs.
+	//
+	lodge_jobs_wait(scene->jobs, &schedule->counter);
+}
+
 void lodge_scene_update(lodge_scene_t scene, float dt)
 {
+	const lodge_timestamp_t before = lodge_timestamp_get();
+	const uint32_t threads_count = lodge_jobs_get_threads_count(scene->jobs);
+
 	scene->time += dt;
-	for(size_t i = 0, count = scene->systems_count; i < count; i++) {
-		struct lodge_system *system = &scene->systems[i];
-		lodge_system_type_update(system->type, system->data, scene, dt);
+
+	lodge_transform_cache_update(scene->transform_cache, scene);
+
+	if(threads_count > 0) {
+		lodge_scene_update_parallel(scene, dt);
+	} else {
+		for(size_t i = 0, count = scene->systems.count; i < count; i++) {
+			struct lodge_system *system = &scene->systems.elements[i];
+			lodge_system_type_update(system->type, system->data, scene, dt);
+		}
+	}
+
+	if(scene->schedule.dirty) {
+		lodge_system_schedule_rebuild(scene);
 	}
+
+	scene->update_stats = (struct lodge_scene_update_stats) {
+		.elapsed_ms = lodge_timestamp_elapsed_ms(before),
+		.systems_count = (uint32_t)scene->systems.count,
+		.threads_count = threads_count,
+		.critical_path = scene->schedule.critical_path,
+	};
 }
 
-lodge_entity_t lodge_scene_add_entity_from_desc(lodge_scene_t scene, const struct lodge_entity_desc *entity_desc, const struct lodge_entity_components_desc *components_desc)
+void lodge_scene_set_jobs(lodge_scene_t scene, struct lodge_jobs *jobs)
 {
-	ASSERT_OR(scene && entity_desc) {
-		return NULL;
-	}
+	ASSERT_OR(scene) { return; }
+	scene->jobs = jobs;
+}
+
+struct lodge_scene_update_stats lodge_scene_get_update_stats(lodge_scene_t scene)
+{
+	ASSERT_OR(scene) { return (struct lodge_scene_update_stats) { 0 }; }
+	return scene->update_stats;
+}
 
-	size_t entity_id = entity_desc->id;
+static size_t lodge_scene_claim_entity_id(lodge_scene_t scene, size_t entity_id)
+{
 	if(entity_id == 0) {
+		if(scene->entities_free_ids.count > 0) {
+			return scene->entities_free_ids.elements[--scene->entities_free_ids.count];
+		}
 		entity_id = scene->entities_last_id + 1;
+	} else {
+		//
+		// Explicit IDs (eg. from a serialized scene) must not be in use.
+		//
+		ASSERT_OR(!sparse_set_get(scene->entities, (uint32_t)entity_id)) {
+			return 0;
+		}
+
+		const uint32_t needle = (uint32_t)entity_id;
+		const int64_t free_index = dynbuf_find(dynbuf(scene->entities_free_ids), &needle, sizeof(uint32_t));
+		if(free_index >= 0) {
+			dynbuf_remove(dynbuf(scene->entities_free_ids), (size_t)free_index, 1);
+		}
 	}
 
-	ASSERT_OR(entity_id > scene->entities_last_id) {
-		return NULL;
+	ASSERT_OR(entity_id <= LODGE_ENTITY_ID_MASK) {
+		return 0;
 	}
 
+	//
+	// IDs skipped over by an explicit ID are handed out later.
+	//
+	for(uint32_t id = (uint32_t)scene->entities_last_id + 1; id < entity_id; id++) {
+		dynbuf_append(dynbuf(scene->entities_free_ids), &id, sizeof(uint32_t));
+	}
 	scene->entities_last_id = max(scene->entities_last_id, entity_id);
 
-	struct lodge_entity_desc *tmp = sparse_set_set(scene->entities, entity_id, entity_desc);
+	const uint32_t generation = 0;
+	while(scene->entities_generations.count <= entity_id) {
+		dynbuf_append(dynbuf(scene->entities_generations), &generation, sizeof(uint32_t));
+	}
+
+	return entity_id;
+}
+
+lodge_entity_t lodge_scene_add_entity_from_desc(lodge_scene_t scene, const struct lodge_entity_desc *entity_desc, const struct lodge_entity_components_desc *components_desc)
+{
+	ASSERT_OR(scene && entity_desc) {
+		return NULL;
+	}
+
+	const size_t entity_id = lodge_scene_claim_entity_id(scene, entity_desc->id);
+	if(entity_id == 0) {
+		return NULL;
+	}
+
+	struct lodge_entity_desc *tmp = sparse_set_set(scene->entities, (uint32_t)entity_id, entity_desc);
 	tmp->id = entity_id;
 
+	if(tmp->parent) {
+		scene->entities_parented_count++;
+		scene->hierarchy_version++;
+	}
+
 	if(components_desc) {
 		for(size_t i = 0, count = components_desc->count; i < count; i++) {
 			lodge_component_t component = lodge_scene_add_component_internal(scene, tmp->id, components_desc->elements[i]);
@@ -183,7 +570,7 @@ lodge_entity_t lodge_scene_add_entity_from_desc(lodge_scene_t scene, const struc
 		}
 	}
 
-	return lodge_entity_desc_to_entity(tmp);
+	return lodge_entity_desc_to_entity(scene, tmp);
 }
 
 lodge_entity_t lodge_scene_add_entity_from_type(lodge_scene_t scene, lodge_entity_type_t entity_type)
@@ -198,19 +585,25 @@ lodge_entity_t lodge_scene_add_entity_from_type(lodge_scene_t scene, lodge_entit
 	}
 
 	struct lodge_entity_desc entity_desc = {
-		.id = scene->entities_last_id + 1,
+		.id = 0,
 		.name = { 0 },
 		.parent = NULL,
 	};
 
+	lodge_entity_t entity = lodge_scene_add_entity_from_desc(scene, &entity_desc, components_desc);
+	if(!entity) {
+		return NULL;
+	}
+
+	struct lodge_entity_desc *tmp = lodge_entity_desc_from_entity(scene, entity);
 	strview_t entity_type_name = lodge_entity_type_get_name(entity_type);
-	strbuf_setf(strbuf_wrap(entity_desc.name),
+	strbuf_setf(strbuf_wrap(tmp->name),
 		STRVIEW_PRINTF_FMT "_%zu",
 		STRVIEW_PRINTF_ARG(entity_type_name),
-		entity_desc.id
+		tmp->id
 	);
 
-	return lodge_scene_add_entity_from_desc(scene, &entity_desc, components_desc);
+	return entity;
 }
 
 lodge_component_t lodge_scene_add_entity_component(lodge_scene_t scene, lodge_entity_t entity, lodge_component_type_t component_type)
@@ -222,38 +615,96 @@ lodge_component_t lodge_scene_add_entity_component(lodge_scene_t scene, lodge_en
 	return lodge_scene_add_component_internal(scene, entity_desc->id, component_type);
 }
 
+//
+// NOTE(TS): removes the entity's children as well.
+//
 bool lodge_scene_remove_entity(lodge_scene_t scene, lodge_entity_t entity)
 {
-	ASSERT_NOT_IMPLEMENTED();
-	return false;
+	ASSERT_OR(scene) { return false; }
+
+	struct lodge_entity_desc *entity_desc = lodge_entity_desc_from_entity(scene, entity);
+	if(!entity_desc) {
+		return false;
+	}
+
+	const uint32_t entity_id = (uint32_t)entity_desc->id;
+
+	if(scene->entities_parented_count > 0) {
+		struct lodge_entity_ids children = { 0 };
+
+		for(struct lodge_entity_desc *it = sparse_set_it_begin(scene->entities); it; it = sparse_set_it_next(scene->entities, it)) {
+			if(it->parent == entity) {
+				const uint32_t child_id = (uint32_t)it->id;
+				dynbuf_append(dynbuf(children), &child_id, sizeof(uint32_t));
+			}
+		}
+
+		for(size_t i = 0; i < children.count; i++) {
+			lodge_scene_remove_entity(scene, lodge_scene_get_entity_by_id(scene, children.elements[i]));
+		}
+
+		dynbuf_free_inplace(dynbuf(children));
+
+		//
+		// Removing children moves entries around in the dense array.
+		//
+		entity_desc = sparse_set_get(scene->entities, entity_id);
+		ASSERT_OR(entity_desc) { return false; }
+
+		if(entity_desc->parent) {
+			scene->entities_parented_count--;
+		}
+	}
+
+	for(size_t i = 0, count = scene->component_sets.count; i < count; i++) {
+		struct lodge_component_set *component_set = &scene->component_sets.elements[i];
+
+		void *component = sparse_set_get(component_set->set, entity_id);
+		if(component) {
+			lodge_component_type_free_inplace(component_set->type, component);
+			sparse_set_remove(component_set->set, entity_id);
+		}
+	}
+
+	sparse_set_remove(scene->entities, entity_id);
+	scene->hierarchy_version++;
+
+	scene->entities_generations.elements[entity_id]++;
+	dynbuf_append(dynbuf(scene->entities_free_ids), &entity_id, sizeof(uint32_t));
+
+	return true;
 }
 
 lodge_system_t lodge_scene_add_system(lodge_scene_t scene, lodge_system_type_t system_type)
 {
 	ASSERT(system_type);
-	struct lodge_system *system = membuf_append(
-		membuf_wrap(scene->systems),
-		&scene->systems_count,
-		&(struct lodge_system) {
-			.type = system_type,
-			.data = NULL,
-		},
-		sizeof(struct lodge_system)
-	);
 
-	system->data = calloc(1, lodge_system_type_sizeof(system_type));
-	lodge_system_type_new_inplace(system_type, system->data, scene);
+	void *data = calloc(1, lodge_system_type_sizeof(system_type));
+	ASSERT_OR(data) { return NULL; }
+
+	const size_t index = scene->systems.count;
+	dynbuf_append(dynbuf(scene->systems), &(struct lodge_system) {
+		.type = system_type,
+		.data = data,
+	}, sizeof(struct lodge_system));
+
+	lodge_system_type_new_inplace(system_type, data, scene);
+
+	scene->schedule.dirty = true;
 
-	return system;
+	//
+	// NOTE(TS): invalidated by the next `lodge_scene_add_system`.
+	//
+	return &scene->systems.elements[index];
 }
 
 void* lodge_scene_get_system(lodge_scene_t scene, lodge_system_type_t system_type)
 {
 	ASSERT(scene);
 	ASSERT(system_type);
-	for(size_t i = 0, count = scene->systems_count; i<count; i++) {
-		if(scene->systems[i].type == system_type) {
-			return scene->systems[i].data;
+	for(size_t i = 0, count = scene->systems.count; i<count; i++) {
+		if(scene->systems.elements[i].type == system_type) {
+			return scene->systems.elements[i].data;
 		}
 	}
 	return NULL;
@@ -298,7 +749,7 @@ lodge_entity_t lodge_scene_get_component_entity(lodge_scene_t scene, lodge_compo
 		return NULL;
 	}
 
-	return lodge_entity_desc_to_entity(entity_desc);
+	return lodge_entity_desc_to_entity(scene, entity_desc);
 }
 
 //
@@ -310,22 +761,50 @@ void lodge_scene_set_entity_parent(lodge_scene_t scene, lodge_entity_t entity, l
 	struct lodge_entity_desc *entity_desc = lodge_entity_desc_from_entity(scene, entity);
 	ASSERT(entity_desc);
 	if(entity_desc) {
+		if(!entity_desc->parent && parent) {
+			scene->entities_parented_count++;
+		} else if(entity_desc->parent && !parent) {
+			scene->entities_parented_count--;
+		}
 		entity_desc->parent = parent;
+		scene->hierarchy_version++;
 		// TODO(TS): callback?
 	}
 }
 
+uint32_t lodge_entity_get_id(lodge_entity_t entity)
+{
+	return (uint32_t)((uintptr_t)entity & LODGE_ENTITY_ID_MASK);
+}
+
+lodge_entity_t lodge_scene_get_entity_by_id(lodge_scene_t scene, uint32_t entity_id)
+{
+	ASSERT_OR(scene) { return NULL; }
+	struct lodge_entity_desc *entity_desc = entity_id ? sparse_set_get(scene->entities, entity_id) : NULL;
+	return lodge_entity_desc_to_entity(scene, entity_desc);
+}
+
+bool lodge_scene_is_entity_valid(lodge_scene_t scene, lodge_entity_t entity)
+{
+	return scene && lodge_entity_desc_from_entity(scene, entity);
+}
+
+size_t lodge_scene_get_entities_count(lodge_scene_t scene)
+{
+	return scene ? sparse_set_get_dense_count(scene->entities) : 0;
+}
+
 lodge_entity_t lodge_scene_entities_begin(lodge_scene_t scene)
 {
 	struct lodge_entity_desc *first = sparse_set_it_begin(scene->entities);
-	return lodge_entity_desc_to_entity(first);
+	return lodge_entity_desc_to_entity(scene, first);
 }
 
 lodge_entity_t lodge_scene_entities_next(lodge_scene_t scene, lodge_entity_t entity)
 {
 	struct lodge_entity_desc *entity_instance = lodge_entity_desc_from_entity(scene, entity);
 	struct lodge_entity_desc *next = sparse_set_it_next(scene->entities, entity_instance);
-	return lodge_entity_desc_to_entity(next);
+	return lodge_entity_desc_to_entity(scene, next);
 }
 
 void* lodge_scene_components_begin(lodge_scene_t scene, lodge_component_type_t type)
@@ -350,8 +829,8 @@ struct lodge_component_it lodge_scene_entity_components_begin(lodge_scene_t scen
 {
 	struct lodge_entity_desc *entity_desc = lodge_entity_desc_from_entity(scene, entity);
 
-	for(size_t i = 0, count = scene->component_sets_count; i < count; i++) {
-		struct lodge_component_set *component_set = &scene->component_sets[i];
+	for(size_t i = 0, count = scene->component_sets.count; i < count; i++) {
+		struct lodge_component_set *component_set = &scene->component_sets.elements[i];
 
 		void *component = sparse_set_get(component_set->set, entity_desc->id);
 		if(component) {
@@ -370,8 +849,8 @@ struct lodge_component_it lodge_scene_entity_components_next(lodge_scene_t scene
 {
 	struct lodge_entity_desc *entity_desc = lodge_entity_desc_from_entity(scene, entity);
 
-	for(size_t i = previous.index + 1, count = scene->component_sets_count; i < count; i++) {
-		struct lodge_component_set *component_set = &scene->component_sets[i];
+	for(size_t i = previous.index + 1, count = scene->component_sets.count; i < count; i++) {
+		struct lodge_component_set *component_set = &scene->component_sets.elements[i];
 
 		void *component = sparse_set_get(component_set->set, entity_desc->id);
 		if(component) {
@@ -388,8 +867,8 @@ struct lodge_component_it lodge_scene_entity_components_next(lodge_scene_t scene
 
 struct lodge_system_it lodge_scene_systems_begin(lodge_scene_t scene)
 {
-	return (scene && scene->systems_count > 0)
-		? (struct lodge_system_it) { .value = scene->systems[0].data, .type = scene->systems[0].type }
+	return (scene && scene->systems.count > 0)
+		? (struct lodge_system_it) { .value = scene->systems.elements[0].data, .type = scene->systems.elements[0].type }
 		: (struct lodge_system_it) { .value = NULL, .type = NULL };
 }
 
@@ -398,14 +877,14 @@ struct lodge_system_it lodge_scene_systems_next(lodge_scene_t scene, struct lodg
 	ASSERT(scene);
 	ASSERT(current_it.value);
 	bool return_next = false;
-	for(size_t i = 0, count = scene->systems_count; i < count; i++) {
+	for(size_t i = 0, count = scene->systems.count; i < count; i++) {
 		if(return_next) {
 			return (struct lodge_system_it) {
-				.value = scene->systems[i].data,
-				.type = scene->systems[i].type,
+				.value = scene->systems.elements[i].data,
+				.type = scene->systems.elements[i].type,
 			};
 		}
-		if(scene->systems[i].data == current_it.value) {
+		if(scene->systems.elements[i].data == current_it.value) {
 			return_next = true;
 		}
 	}
@@ -415,8 +894,8 @@ struct lodge_system_it lodge_scene_systems_next(lodge_scene_t scene, struct lodg
 
 void lodge_scene_render(lodge_scene_t scene, struct lodge_system_render_params *render_params)
 {
-	for(size_t i = 0, count = scene->systems_count; i < count; i++) {
-		struct lodge_system *system = &scene->systems[i];
+	for(size_t i = 0, count = scene->systems.count; i < count; i++) {
+		struct lodge_system *system = &scene->systems.elements[i];
 		lodge_system_type_render(system->type, system->data, scene, render_params);
 	}
 }
@@ -431,6 +910,16 @@ struct lodge_scene_funcs* lodge_scene_get_funcs(lodge_scene_t scene)
 	return scene ? &scene->funcs : NULL;
 }
 
+uint32_t lodge_scene_get_hierarchy_version(lodge_scene_t scene)
+{
+	return scene ? scene->hierarchy_version : 0;
+}
+
+struct lodge_transform_cache* lodge_scene_get_transform_cache(lodge_scene_t scene)
+{
+	return scene ? scene->transform_cache : NULL;
+}
+
 void lodge_scene_set_entity_selected(lodge_scene_t scene, lodge_entity_t entity, bool selected)
 {
 	ASSERT_OR(scene && entity) { return; }
@@ -449,3 +938,122 @@ bool lodge_scene_is_entity_selected(lodge_scene_t scene, lodge_entity_t entity)
 	if(!lodge_bound_func_is_set(funcs->set_entity_selected)) { return false; }
 	return lodge_bound_func_call(funcs->is_entity_selected, entity);
 }
+
+void lodge_scene_query_new_inplace(struct lodge_scene_query *query, lodge_scene_t scene, size_t component_types_count, const lodge_component_type_t *component_types)
+{
+	ASSERT(scene);
+	ASSERT(component_types_count > 0 && component_types_count <= LODGE_SCENE_QUERY_COMPONENTS_MAX);
+
+	*query = (struct lodge_scene_query) {
+		.scene = scene,
+		.component_types_count = min(component_types_count, LODGE_SCENE_QUERY_COMPONENTS_MAX),
+	};
+
+	for(size_t i = 0; i < query->component_types_count; i++) {
+		ASSERT(component_types[i]);
+		query->component_types[i] = component_types[i];
+	}
+}
+
+void lodge_scene_query_free_inplace(struct lodge_scene_query *query)
+{
+	dynbuf_free_inplace(dynbuf(query->entities));
+	dynbuf_free_inplace(dynbuf(query->components));
+	query->valid = false;
+}
+
+bool lodge_scene_query_is_stale(const struct lodge_scene_query *query)
+{
+	ASSERT_OR(query && query->scene) { return true; }
+
+	if(!query->valid) {
+		return true;
+	}
+
+	for(size_t i = 0; i < query->component_types_count; i++) {
+		struct lodge_component_set *component_set = lodge_component_set_get_by_type(query->scene, query->component_types[i]);
+		sparse_set_t set = component_set ? component_set->set : NULL;
+		if(query->sets[i] != set || query->versions[i] != sparse_set_get_version(set)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+size_t lodge_scene_query_refresh(struct lodge_scene_query *query)
+{
+	ASSERT_OR(query && query->scene && query->component_types_count > 0) { return 0; }
+
+	lodge_scene_t scene = query->scene;
+	const size_t types_count = query->component_types_count;
+
+	bool stale = !query->valid;
+	for(size_t i = 0; i < types_count; i++) {
+		struct lodge_component_set *component_set = lodge_component_set_get_by_type(scene, query->component_types[i]);
+		sparse_set_t set = component_set ? component_set->set : NULL;
+		const uint32_t version = sparse_set_get_version(set);
+
+		if(query->sets[i] != set || query->versions[i] != version) {
+			query->sets[i] = set;
+			query->versions[i] = version;
+			stale = true;
+		}
+	}
+
+	if(!stale) {
+		return query->entities.count;
+	}
+
+	dynbuf_clear(dynbuf(query->entities));
+	dynbuf_clear(dynbuf(query->components));
+	query->valid = true;
+
+	//
+	// Walk the smallest set and probe the others.
+	//
+	size_t smallest = 0;
+	for(size_t i = 0; i < types_count; i++) {
+		if(!query->sets[i]) {
+			return 0;
+		}
+		if(sparse_set_get_dense_count(query->sets[i]) < sparse_set_get_dense_count(query->sets[smallest])) {
+			smallest = i;
+		}
+	}
+
+	sparse_set_t driver = query->sets[smallest];
+	for(void *it = sparse_set_it_begin(driver); it; it = sparse_set_it_next(driver, it)) {
+		const uint32_t entity_id = sparse_set_get_index(driver, it);
+
+		void *row[LODGE_SCENE_QUERY_COMPONENTS_MAX];
+		bool match = true;
+		for(size_t i = 0; i < types_count && match; i++) {
+			row[i] = (i == smallest) ? it : sparse_set_get(query->sets[i], entity_id);
+			match = (row[i] != NULL);
+		}
+		if(!match) {
+			continue;
+		}
+
+		lodge_entity_t entity = lodge_scene_get_entity_by_id(scene, entity_id);
+		ASSERT_OR(entity) { continue; }
+
+		dynbuf_append(dynbuf(query->entities), &entity, sizeof(entity));
+		dynbuf_append_range(dynbuf(query->components), row, sizeof(void*), types_count);
+	}
+
+	return query->entities.count;
+}
+
+lodge_entity_t lodge_scene_query_get_entity(const struct lodge_scene_query *query, size_t index)
+{
+	ASSERT_OR(index < query->entities.count) { return NULL; }
+	return query->entities.elements[index];
+}
+
+void* lodge_scene_query_get_component(const struct lodge_scene_query *query, size_t index, size_t component_index)
+{
+	ASSERT_OR(index < query->entities.count && component_index < query->component_types_count) { return NULL; }
+	return query->components.elements[index * query->component_types_count + component_index];
+}
@@ -19,9 +19,12 @@ static void lodge_scene_entity_to_json(lodge_scene_t scene, const lodge_entity_t
 {
 	lodge_json_object_set_string(dst_object, strview_static("name"), lodge_scene_get_entity_name(scene, entity));
 
-	uintptr_t entity_parent_id = (uintptr_t)lodge_scene_get_entity_parent(scene, entity);
-	if(entity_parent_id) {
-		lodge_json_object_set_number(dst_object, strview_static("parent"), (double)entity_parent_id);
+	//
+	// Plain ID, like the entity keys: the handle's generation is not preserved on reload.
+	//
+	lodge_entity_t entity_parent = lodge_scene_get_entity_parent(scene, entity);
+	if(entity_parent) {
+		lodge_json_object_set_number(dst_object, strview_static("parent"), (double)lodge_entity_get_id(entity_parent));
 	}
 
 	lodge_json_t components_object = lodge_json_object_set_new_object(dst_object, strview_static("components"));
@@ -181,7 +184,7 @@ char* lodge_scene_to_text(lodge_scene_t scene, size_t *size_out)
 
 		lodge_scene_entities_foreach(scene, entity) {
 			char entity_id[256];
-			strbuf_setf(strbuf_wrap(entity_id), "%" PRIxPTR, (uintptr_t)entity);
+			strbuf_setf(strbuf_wrap(entity_id), "%" PRIu32, lodge_entity_get_id(entity));
 			lodge_json_t entity_object = lodge_json_object_set_new_object(root_entities, strview_wrap(entity_id));
 			lodge_scene_entity_to_json(scene, entity, entity_object);
 		}
@@ -303,6 +306,33 @@ bool lodge_scene_from_text_inplace(struct lodge_scene *scene, strview_t text)
 		}
 	}
 
+	//
+	// Parents, once every entity they can refer to exists.
+	//
+	{
+		for(size_t entity_idx = 0, entities_count = lodge_json_object_get_child_count(root_entities); entity_idx < entities_count; entity_idx++) {
+			lodge_json_t entity_object = lodge_json_object_get_child_index(root_entities, entity_idx);
+
+			double parent_id = 0.0;
+			if(!lodge_json_object_get_number(lodge_json_object_get_child_index(entity_object, 0), strview_static("parent"), &parent_id)) {
+				continue;
+			}
+
+			strview_t entity_object_name;
+			uint64_t entity_id = 0;
+			ASSERT_OR(lodge_json_object_get_name(entity_object, &entity_object_name) && strview_to_u64(entity_object_name, &entity_id)) {
+				goto fail;
+			}
+
+			lodge_entity_t entity = lodge_scene_get_entity_by_id(scene, (uint32_t)entity_id);
+			lodge_entity_t parent = lodge_scene_get_entity_by_id(scene, (uint32_t)parent_id);
+			ASSERT_OR(entity && parent) {
+				goto fail;
+			}
+			lodge_scene_set_entity_parent(scene, entity, parent);
+		}
+	}
+
 	ASSERT_NOT_IMPLEMENTED();
 	
 	return true;
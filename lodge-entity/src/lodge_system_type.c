@@ -41,6 +41,15 @@ lodge_system_type_t lodge_system_type_register(struct lodge_system_type_desc des
 		}
 	}
 
+	ASSERT(desc.reads.count <= LODGE_ARRAYSIZE(desc.reads.elements));
+	ASSERT(desc.writes.count <= LODGE_ARRAYSIZE(desc.writes.elements));
+	for(size_t i = 0; i < desc.reads.count; i++) {
+		ASSERT(desc.reads.elements[i]);
+	}
+	for(size_t i = 0; i < desc.writes.count; i++) {
+		ASSERT(desc.writes.elements[i]);
+	}
+
 	return (lodge_system_type_t) membuf_append(membuf_wrap(system_descs), &system_descs_count, &desc, sizeof(struct lodge_system_type_desc));
 }
 
@@ -113,6 +122,49 @@ void* lodge_system_type_get_userdata(lodge_system_type_t system_type)
 	return system_desc ? system_desc->userdata : NULL;
 }
 
+uint32_t lodge_system_type_get_flags(lodge_system_type_t system_type)
+{
+	struct lodge_system_type_desc *system_desc = lodge_system_type_to_desc(system_type);
+	ASSERT(system_desc);
+	return system_desc ? system_desc->flags : LODGE_SYSTEM_TYPE_FLAG_NONE;
+}
+
+static bool lodge_system_components_contains(const struct lodge_system_components_desc *components, lodge_component_type_t type)
+{
+	for(size_t i = 0, count = components->count; i < count; i++) {
+		if(components->elements[i] == type) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool lodge_system_components_writes_any(const struct lodge_system_components_desc *writes, const struct lodge_system_type_desc *other)
+{
+	for(size_t i = 0, count = writes->count; i < count; i++) {
+		if(lodge_system_components_contains(&other->reads, writes->elements[i])
+			|| lodge_system_components_contains(&other->writes, writes->elements[i])) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool lodge_system_type_conflicts(lodge_system_type_t lhs, lodge_system_type_t rhs)
+{
+	struct lodge_system_type_desc *lhs_desc = lodge_system_type_to_desc(lhs);
+	struct lodge_system_type_desc *rhs_desc = lodge_system_type_to_desc(rhs);
+	ASSERT_OR(lhs_desc && rhs_desc) { return true; }
+
+	if(!LODGE_IS_FLAG_SET(lhs_desc->flags, LODGE_SYSTEM_TYPE_FLAG_CONCURRENT)
+		|| !LODGE_IS_FLAG_SET(rhs_desc->flags, LODGE_SYSTEM_TYPE_FLAG_CONCURRENT)) {
+		return true;
+	}
+
+	return lodge_system_components_writes_any(&lhs_desc->writes, rhs_desc)
+		|| lodge_system_components_writes_any(&rhs_desc->writes, lhs_desc);
+}
+
 lodge_system_type_t lodge_system_type_find(strview_t name)
 {
 	for(size_t i = 0; i < system_descs_count; i++) {
@@ -5,6 +5,62 @@
 #include "lodge_component_type.h"
 #include "lodge_platform.h"
 #include "lodge_scene.h"
+#include "dynbuf.h"
+
+#include <string.h>
+
+#define LODGE_TRANSFORM_NODE_NONE UINT32_MAX
+
+//
+// Cached world space transform of one entity. Nodes are stored parent before
+// child (depth first), so the descendants of a node are the contiguous range
+// `[index + 1, subtree_end)`.
+//
+struct lodge_transform_node
+{
+	lodge_entity_t						entity;
+	struct lodge_transform_component	*component;
+	uint32_t							parent;
+	uint32_t							subtree_end;
+	bool								dirty;
+	bool								changed;
+
+	//
+	// Copy of `component` from the last refresh, used to catch writes that
+	// bypass the `lodge_set_*` helpers.
+	//
+	struct lodge_transform_component	local;
+
+	mat4								world_transform;
+	vec3								world_position;
+	vec3								world_rotation;
+	vec3								world_scale;
+};
+
+struct lodge_transform_nodes
+{
+	size_t								count;
+	size_t								capacity;
+	struct lodge_transform_node			*elements;
+};
+
+struct lodge_transform_indices
+{
+	size_t								count;
+	size_t								capacity;
+	uint32_t							*elements;
+};
+
+struct lodge_transform_cache
+{
+	bool								valid;
+	bool								query_initialized;
+	uint32_t							hierarchy_version;
+	struct lodge_scene_query			query;
+
+	struct lodge_transform_nodes		nodes;
+	struct lodge_transform_indices		node_indices;		// Indexed by entity ID.
+};
 
 lodge_component_type_t LODGE_COMPONENT_TYPE_TRANSFORM = NULL;
 lodge_type_t LODGE_TYPE_ENUM_TRANSFORM_SPACE = NULL;
@@ -19,8 +75,263 @@ static void lodge_transform_component_new_inplace(struct lodge_transform_compone
 	};
 }
 
+static mat4 lodge_transform_component_to_trs(const struct lodge_transform_component *transform);
+
+struct lodge_transform_cache* lodge_transform_cache_new()
+{
+	return (struct lodge_transform_cache *)calloc(1, sizeof(struct lodge_transform_cache));
+}
+
+void lodge_transform_cache_free(struct lodge_transform_cache *cache)
+{
+	if(!cache) {
+		return;
+	}
+	if(cache->query_initialized) {
+		lodge_scene_query_free_inplace(&cache->query);
+	}
+	dynbuf_free_inplace(dynbuf(cache->nodes));
+	dynbuf_free_inplace(dynbuf(cache->node_indices));
+	free(cache);
+}
+
+static bool lodge_transform_cache_is_stale(const struct lodge_transform_cache *cache, lodge_scene_t scene)
+{
+	return !cache->valid
+		|| cache->hierarchy_version != lodge_scene_get_hierarchy_version(scene)
+		|| lodge_scene_query_is_stale(&cache->query);
+}
+
+static void lodge_transform_cache_rebuild(struct lodge_transform_cache *cache, lodge_scene_t scene)
+{
+	const uint32_t count = (uint32_t)lodge_scene_query_refresh(&cache->query);
+
+	cache->valid = true;
+	cache->hierarchy_version = lodge_scene_get_hierarchy_version(scene);
+	dynbuf_clear(dynbuf(cache->nodes));
+	dynbuf_clear(dynbuf(cache->node_indices));
+
+	//
+	// Map entity ID => query index, to find the parent of each match.
+	//
+	const uint32_t none = LODGE_TRANSFORM_NODE_NONE;
+	for(uint32_t i = 0; i < count; i++) {
+		const uint32_t entity_id = lodge_entity_get_id(lodge_scene_query_get_entity(&cache->query, i));
+		while(cache->node_indices.count <= entity_id) {
+			dynbuf_append(dynbuf(cache->node_indices), &none, sizeof(uint32_t));
+		}
+		cache->node_indices.elements[entity_id] = i;
+	}
+
+	struct lodge_transform_indices parents = { 0 };
+	struct lodge_transform_indices children_offsets = { 0 };
+	struct lodge_transform_indices children = { 0 };
+	struct lodge_transform_indices stack = { 0 };
+
+	for(uint32_t i = 0; i < count; i++) {
+		uint32_t parent_index = LODGE_TRANSFORM_NODE_NONE;
+
+		const lodge_entity_t parent = lodge_scene_get_entity_parent(scene, lodge_scene_query_get_entity(&cache->query, i));
+		const uint32_t parent_id = lodge_entity_get_id(parent);
+		if(parent && parent_id < cache->node_indices.count) {
+			const uint32_t index = cache->node_indices.elements[parent_id];
+			if(index != LODGE_TRANSFORM_NODE_NONE && lodge_scene_query_get_entity(&cache->query, index) == parent) {
+				parent_index = index;
+			}
+		}
+
+		dynbuf_append(dynbuf(parents), &parent_index, sizeof(uint32_t));
+	}
+
+	//
+	// Children lists, packed as `children[children_offsets[i]..children_offsets[i+1]]`.
+	//
+	const uint32_t zero = 0;
+	for(uint32_t i = 0; i <= count; i++) {
+		dynbuf_append(dynbuf(children_offsets), &zero, sizeof(uint32_t));
+	}
+	for(uint32_t i = 0; i < count; i++) {
+		if(parents.elements[i] != LODGE_TRANSFORM_NODE_NONE) {
+			children_offsets.elements[parents.elements[i] + 1]++;
+		}
+		dynbuf_append(dynbuf(children), &zero, sizeof(uint32_t));
+	}
+	for(uint32_t i = 0; i < count; i++) {
+		children_offsets.elements[i + 1] += children_offsets.elements[i];
+	}
+	{
+		struct lodge_transform_indices cursor = { 0 };
+		dynbuf_append_range(dynbuf(cursor), children_offsets.elements, sizeof(uint32_t), count);
+		for(uint32_t i = 0; i < count; i++) {
+			const uint32_t parent_index = parents.elements[i];
+			if(parent_index != LODGE_TRANSFORM_NODE_NONE) {
+				children.elements[cursor.elements[parent_index]++] = i;
+			}
+		}
+		dynbuf_free_inplace(dynbuf(cursor));
+	}
+
+	//
+	// Depth first walk from the roots; `node_indices` is rewritten to point
+	// into `nodes` as we go. Entities caught in a parent cycle are never
+	// reached and fall back to the uncached path.
+	//
+	for(uint32_t i = 0; i < count; i++) {
+		const uint32_t entity_id = lodge_entity_get_id(lodge_scene_query_get_entity(&cache->query, i));
+		cache->node_indices.elements[entity_id] = LODGE_TRANSFORM_NODE_NONE;
+	}
+
+	for(uint32_t root = 0; root < count; root++) {
+		if(parents.elements[root] != LODGE_TRANSFORM_NODE_NONE) {
+			continue;
+		}
+
+		dynbuf_append(dynbuf(stack), &root, sizeof(uint32_t));
+		while(stack.count > 0) {
+			const uint32_t index = stack.elements[--stack.count];
+			const lodge_entity_t entity = lodge_scene_query_get_entity(&cache->query, index);
+			const uint32_t parent_index = parents.elements[index];
+
+			const uint32_t node_index = (uint32_t)cache->nodes.count;
+			dynbuf_append(dynbuf(cache->nodes), &(struct lodge_transform_node) {
+				.entity = entity,
+				.component = lodge_scene_query_get_component(&cache->query, index, 0),
+				.parent = parent_index == LODGE_TRANSFORM_NODE_NONE
+					? LODGE_TRANSFORM_NODE_NONE
+					: cache->node_indices.elements[lodge_entity_get_id(lodge_scene_query_get_entity(&cache->query, parent_index))],
+				.subtree_end = node_index + 1,
+				.dirty = true,
+			}, sizeof(struct lodge_transform_node));
+			cache->node_indices.elements[lodge_entity_get_id(entity)] = node_index;
+
+			for(uint32_t c = children_offsets.elements[index + 1]; c > children_offsets.elements[index]; c--) {
+				dynbuf_append(dynbuf(stack), &children.elements[c - 1], sizeof(uint32_t));
+			}
+		}
+	}
+
+	//
+	// Children come after their parent, so a reverse pass accumulates subtree sizes.
+	//
+	for(size_t i = cache->nodes.count; i-- > 0;) {
+		const struct lodge_transform_node *node = &cache->nodes.elements[i];
+		if(node->parent != LODGE_TRANSFORM_NODE_NONE) {
+			struct lodge_transform_node *parent = &cache->nodes.elements[node->parent];
+			parent->subtree_end = max(parent->subtree_end, node->subtree_end);
+		}
+	}
+
+	dynbuf_free_inplace(dynbuf(stack));
+	dynbuf_free_inplace(dynbuf(children));
+	dynbuf_free_inplace(dynbuf(children_offsets));
+	dynbuf_free_inplace(dynbuf(parents));
+}
+
+static void lodge_transform_node_refresh(struct lodge_transform_node *node, const struct lodge_transform_node *parent)
+{
+	memcpy(&node->local, node->component, sizeof(struct lodge_transform_component));
+
+	const struct lodge_transform_component *local = &node->local;
+	const mat4 trs = lodge_transform_component_to_trs(local);
+
+	if(parent && local->space == LODGE_TRANSFORM_SPACE_LOCAL) {
+		node->world_transform = mat4_mult(parent->world_transform, trs);
+		node->world_position = vec3_add(parent->world_position, vec3_mult(local->translation, parent->world_scale));
+		node->world_rotation = vec3_add(parent->world_rotation, local->rotation);
+		node->world_scale = vec3_mult(parent->world_scale, local->scale);
+	} else {
+		node->world_transform = trs;
+		node->world_position = local->translation;
+		node->world_rotation = local->rotation;
+		node->world_scale = local->scale;
+	}
+}
+
+void lodge_transform_cache_update(struct lodge_transform_cache *cache, lodge_scene_t scene)
+{
+	ASSERT_OR(cache && scene) { return; }
+
+	if(!cache->query_initialized) {
+		if(!LODGE_COMPONENT_TYPE_TRANSFORM) {
+			return;
+		}
+		lodge_scene_query_new_inplace(&cache->query, scene, 1, &LODGE_COMPONENT_TYPE_TRANSFORM);
+		cache->query_initialized = true;
+	}
+
+	if(lodge_transform_cache_is_stale(cache, scene)) {
+		lodge_transform_cache_rebuild(cache, scene);
+	}
+
+	for(size_t i = 0, count = cache->nodes.count; i < count; i++) {
+		struct lodge_transform_node *node = &cache->nodes.elements[i];
+		const struct lodge_transform_node *parent = (node->parent != LODGE_TRANSFORM_NODE_NONE) ? &cache->nodes.elements[node->parent] : NULL;
+
+		node->changed = node->dirty
+			|| (parent && parent->changed)
+			|| memcmp(&node->local, node->component, sizeof(struct lodge_transform_component)) != 0;
+
+		if(node->changed) {
+			lodge_transform_node_refresh(node, parent);
+			node->dirty = false;
+		}
+	}
+}
+
+//
+// Returns NULL if the cached value for `entity` can not be trusted, in which
+// case the caller walks the hierarchy instead.
+//
+static const struct lodge_transform_node* lodge_transform_cache_get_node(lodge_scene_t scene, lodge_entity_t entity)
+{
+	const struct lodge_transform_cache *cache = lodge_scene_get_transform_cache(scene);
+	if(!cache || !cache->query_initialized || lodge_transform_cache_is_stale(cache, scene)) {
+		return NULL;
+	}
+
+	const uint32_t entity_id = lodge_entity_get_id(entity);
+	if(entity_id >= cache->node_indices.count) {
+		return NULL;
+	}
+
+	const uint32_t node_index = cache->node_indices.elements[entity_id];
+	if(node_index == LODGE_TRANSFORM_NODE_NONE) {
+		return NULL;
+	}
+
+	const struct lodge_transform_node *node = &cache->nodes.elements[node_index];
+	return (node->entity == entity && !node->dirty) ? node : NULL;
+}
+
+static void lodge_transform_cache_set_dirty(lodge_scene_t scene, lodge_entity_t entity)
+{
+	struct lodge_transform_cache *cache = lodge_scene_get_transform_cache(scene);
+	if(!cache || !cache->query_initialized || lodge_transform_cache_is_stale(cache, scene)) {
+		return;
+	}
+
+	const uint32_t entity_id = lodge_entity_get_id(entity);
+	if(entity_id >= cache->node_indices.count) {
+		return;
+	}
+
+	const uint32_t node_index = cache->node_indices.elements[entity_id];
+	if(node_index == LODGE_TRANSFORM_NODE_NONE || cache->nodes.elements[node_index].entity != entity) {
+		return;
+	}
+
+	for(uint32_t i = node_index, end = cache->nodes.elements[node_index].subtree_end; i < end; i++) {
+		cache->nodes.elements[i].dirty = true;
+	}
+}
+
 vec3 lodge_get_scale(lodge_scene_t scene, lodge_entity_t entity)
 {
+	const struct lodge_transform_node *node = lodge_transform_cache_get_node(scene, entity);
+	if(node) {
+		return node->world_scale;
+	}
+
 	struct lodge_transform_component* transform = lodge_scene_get_entity_component(scene, entity, LODGE_COMPONENT_TYPE_TRANSFORM);
 	if(!transform) {
 		return vec3_ones();
@@ -46,6 +357,11 @@ vec3 lodge_get_scale(lodge_scene_t scene, lodge_entity_t entity)
 
 vec3 lodge_get_rotation(lodge_scene_t scene, lodge_entity_t entity)
 {
+	const struct lodge_transform_node *node = lodge_transform_cache_get_node(scene, entity);
+	if(node) {
+		return node->world_rotation;
+	}
+
 	struct lodge_transform_component* transform = lodge_scene_get_entity_component(scene, entity, LODGE_COMPONENT_TYPE_TRANSFORM);
 	if(!transform) {
 		return vec3_zero();
@@ -76,6 +392,11 @@ vec3 lodge_get_direction_vector(lodge_scene_t scene, lodge_entity_t entity)
 
 vec3 lodge_get_position(lodge_scene_t scene, lodge_entity_t entity)
 {
+	const struct lodge_transform_node *node = lodge_transform_cache_get_node(scene, entity);
+	if(node) {
+		return node->world_position;
+	}
+
 	struct lodge_transform_component* transform = lodge_scene_get_entity_component(scene, entity, LODGE_COMPONENT_TYPE_TRANSFORM);
 	if(!transform) {
 		return vec3_zero();
@@ -110,7 +431,7 @@ mat4 lodge_rotation_to_matrix(const vec3 rotation)
 	return mat4_mult(mat4_mult(pitch, roll), yaw);
 }
 
-static mat4 lodge_transform_component_to_trs(struct lodge_transform_component *transform)
+static mat4 lodge_transform_component_to_trs(const struct lodge_transform_component *transform)
 {
 	const mat4 t = mat4_translation(xyz_of(transform->translation));
 	const mat4 r = lodge_rotation_to_matrix(transform->rotation);
@@ -125,6 +446,11 @@ static mat4 lodge_transform_component_to_trs(struct lodge_transform_component *t
 
 mat4 lodge_get_transform(lodge_scene_t scene, lodge_entity_t entity)
 {
+	const struct lodge_transform_node *node = lodge_transform_cache_get_node(scene, entity);
+	if(node) {
+		return node->world_transform;
+	}
+
 	struct lodge_transform_component *transform = lodge_scene_get_entity_component(scene, entity, LODGE_COMPONENT_TYPE_TRANSFORM);
 	if(!transform) {
 		return mat4_identity();
@@ -151,6 +477,34 @@ mat4 lodge_get_transform(lodge_scene_t scene, lodge_entity_t entity)
 	}
 }
 
+//
+// Returns the parent whose world transform `transform` is relative to, if any.
+//
+static lodge_entity_t lodge_transform_get_relative_parent(lodge_scene_t scene, lodge_entity_t entity, const struct lodge_transform_component *transform)
+{
+	return transform->space == LODGE_TRANSFORM_SPACE_LOCAL ? lodge_scene_get_entity_parent(scene, entity) : NULL;
+}
+
+void lodge_set_position(lodge_scene_t scene, lodge_entity_t entity, vec3 position)
+{
+	struct lodge_transform_component *transform = lodge_scene_get_entity_component(scene, entity, LODGE_COMPONENT_TYPE_TRANSFORM);
+	ASSERT(transform);
+	if(!transform) {
+		return;
+	}
+
+	lodge_entity_t parent = lodge_transform_get_relative_parent(scene, entity, transform);
+	if(parent) {
+		const vec3 parent_pos = lodge_get_position(scene, parent);
+		const vec3 parent_scale = lodge_get_scale(scene, parent);
+		transform->translation = vec3_div(vec3_sub(position, parent_pos), parent_scale);
+	} else {
+		transform->translation = position;
+	}
+
+	lodge_transform_cache_set_dirty(scene, entity);
+}
+
 void lodge_set_rotation(lodge_scene_t scene, lodge_entity_t entity, vec3 rotation)
 {
 	struct lodge_transform_component *transform = lodge_scene_get_entity_component(scene, entity, LODGE_COMPONENT_TYPE_TRANSFORM);
@@ -159,18 +513,32 @@ void lodge_set_rotation(lodge_scene_t scene, lodge_entity_t entity, vec3 rotatio
 		return;
 	}
 
-	switch(transform->space)
-	{
-	case LODGE_TRANSFORM_SPACE_LOCAL:
-	{
-		ASSERT_NOT_IMPLEMENTED();
+	lodge_entity_t parent = lodge_transform_get_relative_parent(scene, entity, transform);
+	if(parent) {
+		rotation = vec3_sub(rotation, lodge_get_rotation(scene, parent));
 	}
-	case LODGE_TRANSFORM_SPACE_WORLD:
-	default:
-	{
-		transform->rotation = vec3_make(fmod(rotation.x, M_PI*2), fmod(rotation.y, M_PI*2), fmod(rotation.z, M_PI*2));
+
+	transform->rotation = vec3_make(fmod(rotation.x, M_PI*2), fmod(rotation.y, M_PI*2), fmod(rotation.z, M_PI*2));
+
+	lodge_transform_cache_set_dirty(scene, entity);
+}
+
+void lodge_set_scale(lodge_scene_t scene, lodge_entity_t entity, vec3 scale)
+{
+	struct lodge_transform_component *transform = lodge_scene_get_entity_component(scene, entity, LODGE_COMPONENT_TYPE_TRANSFORM);
+	ASSERT(transform);
+	if(!transform) {
+		return;
 	}
+
+	lodge_entity_t parent = lodge_transform_get_relative_parent(scene, entity, transform);
+	if(parent) {
+		transform->scale = vec3_div(scale, lodge_get_scale(scene, parent));
+	} else {
+		transform->scale = scale;
 	}
+
+	lodge_transform_cache_set_dirty(scene, entity);
 }
 
 lodge_component_type_t lodge_transform_component_type_register()
@@ -0,0 +1,183 @@
+//
+// Joining static meshes with their transforms, the way the scene renderer gathers draws:
+// `lodge_scene_components_foreach` plus a component lookup per entity, against a cached
+// `lodge_scene_query` over both component types.
+//
+// Usage: bench_lodge_scene_query [frames]
+//
+
+#include "lodge_scene.h"
+#include "lodge_component_type.h"
+#include "lodge_transform_component.h"
+#include "lodge_time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//
+// Same layout as `lodge_static_mesh_component`, which lives in the scene renderer plugin.
+//
+struct bench_static_mesh
+{
+	void						*fbx_asset;
+	void						*shader_asset;
+	void						*shader_entity_id_asset;
+	void						*texture_asset;
+};
+
+static lodge_component_type_t	BENCH_STATIC_MESH = NULL;
+
+struct bench_result
+{
+	double						avg_ms;
+	double						worst_ms;
+	size_t						matches;
+	float						checksum;
+};
+
+static float bench_draw(const struct bench_static_mesh *static_mesh, const struct lodge_transform_component *transform)
+{
+	return static_mesh->fbx_asset ? transform->translation.x + transform->scale.y : 0.0f;
+}
+
+static size_t bench_foreach_lookup(lodge_scene_t scene, float *checksum)
+{
+	size_t matches = 0;
+	lodge_scene_components_foreach(scene, struct bench_static_mesh*, static_mesh, BENCH_STATIC_MESH) {
+		const lodge_entity_t owner = lodge_scene_get_component_entity(scene, BENCH_STATIC_MESH, static_mesh);
+		const struct lodge_transform_component *transform = lodge_scene_get_entity_component(scene, owner, LODGE_COMPONENT_TYPE_TRANSFORM);
+		if(transform) {
+			*checksum += bench_draw(static_mesh, transform);
+			matches++;
+		}
+	}
+	return matches;
+}
+
+static size_t bench_query(struct lodge_scene_query *query, float *checksum)
+{
+	size_t matches = 0;
+	lodge_scene_query_foreach(query, i) {
+		const struct bench_static_mesh *static_mesh = lodge_scene_query_get_component(query, i, 0);
+		const struct lodge_transform_component *transform = lodge_scene_query_get_component(query, i, 1);
+		*checksum += bench_draw(static_mesh, transform);
+		matches++;
+	}
+	return matches;
+}
+
+//
+// Adds and removes an entity with both components, so the next refresh rebuilds the query.
+//
+static void bench_invalidate(lodge_scene_t scene)
+{
+	const lodge_entity_t entity = lodge_scene_add_entity_from_desc(scene, &(struct lodge_entity_desc) { .id = 0 }, NULL);
+	lodge_scene_add_entity_component(scene, entity, BENCH_STATIC_MESH);
+	lodge_scene_add_entity_component(scene, entity, LODGE_COMPONENT_TYPE_TRANSFORM);
+	lodge_scene_remove_entity(scene, entity);
+}
+
+enum bench_mode
+{
+	BENCH_MODE_FOREACH_LOOKUP,
+	BENCH_MODE_QUERY,
+	BENCH_MODE_QUERY_REBUILT,
+};
+
+static struct bench_result bench_run(lodge_scene_t scene, struct lodge_scene_query *query, enum bench_mode mode, uint32_t frames)
+{
+	struct bench_result result = { 0 };
+
+	for(uint32_t i = 0; i < frames + 10; i++) {
+		if(mode == BENCH_MODE_QUERY_REBUILT) {
+			bench_invalidate(scene);
+		}
+
+		const lodge_timestamp_t before = lodge_timestamp_get();
+		result.matches = (mode == BENCH_MODE_FOREACH_LOOKUP)
+			? bench_foreach_lookup(scene, &result.checksum)
+			: bench_query(query, &result.checksum);
+		const double elapsed_ms = lodge_timestamp_elapsed_ms(before);
+
+		// Warm up.
+		if(i >= 10) {
+			result.avg_ms += elapsed_ms / frames;
+			result.worst_ms = max(result.worst_ms, elapsed_ms);
+		}
+	}
+
+	return result;
+}
+
+//
+// Every entity has a transform, every other one a static mesh, and every eighth
+// a static mesh without a transform -- the join has to skip those.
+//
+static void bench_scene(uint32_t entities_count, uint32_t frames)
+{
+	lodge_scene_t scene = malloc(lodge_scene_sizeof());
+	lodge_scene_new_inplace(scene);
+
+	for(uint32_t i = 0; i < entities_count; i++) {
+		const lodge_entity_t entity = lodge_scene_add_entity_from_desc(scene, &(struct lodge_entity_desc) { .id = 0 }, NULL);
+
+		if(i % 8 != 7) {
+			struct lodge_transform_component *transform = (struct lodge_transform_component *)lodge_scene_add_entity_component(scene, entity, LODGE_COMPONENT_TYPE_TRANSFORM);
+			transform->translation = vec3_make((float)(i % 128), 0.0f, (float)(i / 128));
+		}
+
+		if(i % 2 == 1) {
+			struct bench_static_mesh *static_mesh = (struct bench_static_mesh *)lodge_scene_add_entity_component(scene, entity, BENCH_STATIC_MESH);
+			static_mesh->fbx_asset = static_mesh;
+		}
+	}
+
+	const lodge_component_type_t component_types[] = { BENCH_STATIC_MESH, LODGE_COMPONENT_TYPE_TRANSFORM };
+	struct lodge_scene_query query;
+	lodge_scene_query_new_inplace(&query, scene, LODGE_ARRAYSIZE(component_types), component_types);
+
+	const struct
+	{
+		enum bench_mode			mode;
+		const char				*label;
+	} modes[] = {
+		{ BENCH_MODE_FOREACH_LOOKUP, "foreach + lookup" },
+		{ BENCH_MODE_QUERY, "query" },
+		{ BENCH_MODE_QUERY_REBUILT, "query, rebuilt" },
+	};
+
+	printf("%u entities, %u frames\n", entities_count, frames);
+
+	for(size_t i = 0; i < LODGE_ARRAYSIZE(modes); i++) {
+		const struct bench_result result = bench_run(scene, &query, modes[i].mode, frames);
+		printf("  %-18s matches: %6zu  avg: %8.3f ms/frame  worst: %8.3f ms  (checksum %g)\n",
+			modes[i].label,
+			result.matches,
+			result.avg_ms,
+			result.worst_ms,
+			result.checksum
+		);
+	}
+
+	lodge_scene_query_free_inplace(&query);
+	lodge_scene_free_inplace(scene);
+	free(scene);
+}
+
+int main(int argc, char **argv)
+{
+	const uint32_t frames = (argc > 1) ? (uint32_t)atoi(argv[1]) : 100;
+
+	lodge_transform_component_type_register();
+	BENCH_STATIC_MESH = lodge_component_type_register((struct lodge_component_desc) {
+		.name = strview_static("bench_static_mesh"),
+		.description = strview_static(""),
+		.size = sizeof(struct bench_static_mesh),
+	});
+
+	bench_scene(10000, frames);
+	bench_scene(100000, frames);
+
+	return 0;
+}
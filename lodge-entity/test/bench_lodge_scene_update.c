@@ -0,0 +1,221 @@
+//
+// Per-frame wall time of `lodge_scene_update` on a scene with thousands of
+// entities, serially and with the systems scheduled on a worker pool.
+//
+// Usage: bench_lodge_scene_update [entities] [frames] [threads]
+//
+
+#include "lodge_scene.h"
+#include "lodge_system_type.h"
+#include "lodge_component_type.h"
+#include "lodge_jobs.h"
+#include "lodge_thread.h"
+#include "lodge_time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+struct bench_position
+{
+	vec3						value;
+};
+
+struct bench_velocity
+{
+	vec3						value;
+};
+
+struct bench_health
+{
+	float						value;
+	float						regen;
+};
+
+struct bench_bounds
+{
+	vec3						min;
+	vec3						max;
+};
+
+static lodge_component_type_t	BENCH_POSITION = NULL;
+static lodge_component_type_t	BENCH_VELOCITY = NULL;
+static lodge_component_type_t	BENCH_HEALTH = NULL;
+static lodge_component_type_t	BENCH_BOUNDS = NULL;
+
+//
+// Shared by the system types as their userdata.
+//
+struct bench
+{
+	uint32_t					work;			// Iterations of `bench_work` per component.
+};
+
+//
+// Enough math per component that the systems, not the scheduler, dominate.
+//
+static float bench_work(const struct bench *bench, float value)
+{
+	for(uint32_t i = 0; i < bench->work; i++) {
+		value = sinf(value) * 0.5f + cosf(value * 0.25f);
+	}
+	return value;
+}
+
+static void bench_integrate_update(void *system, lodge_system_type_t type, lodge_scene_t scene, float dt, void *userdata)
+{
+	lodge_scene_components_foreach(scene, struct bench_velocity*, velocity, BENCH_VELOCITY) {
+		const lodge_entity_t owner = lodge_scene_get_component_entity(scene, BENCH_VELOCITY, velocity);
+		struct bench_position *position = lodge_scene_get_entity_component(scene, owner, BENCH_POSITION);
+		position->value = vec3_add(position->value, vec3_mult_scalar(velocity->value, dt * bench_work(userdata, dt)));
+	}
+}
+
+static void bench_health_update(void *system, lodge_system_type_t type, lodge_scene_t scene, float dt, void *userdata)
+{
+	lodge_scene_components_foreach(scene, struct bench_health*, health, BENCH_HEALTH) {
+		health->value = min(health->value + health->regen * dt * bench_work(userdata, health->value), 100.0f);
+	}
+}
+
+static void bench_bounds_update(void *system, lodge_system_type_t type, lodge_scene_t scene, float dt, void *userdata)
+{
+	lodge_scene_components_foreach(scene, struct bench_bounds*, bounds, BENCH_BOUNDS) {
+		const lodge_entity_t owner = lodge_scene_get_component_entity(scene, BENCH_BOUNDS, bounds);
+		const struct bench_position *position = lodge_scene_get_entity_component(scene, owner, BENCH_POSITION);
+		const float radius = 1.0f + 0.01f * bench_work(userdata, position->value.x);
+		bounds->min = vec3_sub(position->value, vec3_make(radius, radius, radius));
+		bounds->max = vec3_add(position->value, vec3_make(radius, radius, radius));
+	}
+}
+
+static void bench_drag_update(void *system, lodge_system_type_t type, lodge_scene_t scene, float dt, void *userdata)
+{
+	lodge_scene_components_foreach(scene, struct bench_velocity*, velocity, BENCH_VELOCITY) {
+		velocity->value = vec3_mult_scalar(velocity->value, 1.0f - 0.01f * dt * bench_work(userdata, velocity->value.y));
+	}
+}
+
+static lodge_component_type_t bench_component_type_register(const char *name, size_t size)
+{
+	return lodge_component_type_register((struct lodge_component_desc) {
+		.name = strview_make(name, strlen(name)),
+		.description = strview_static(""),
+		.size = size,
+	});
+}
+
+static lodge_system_type_t bench_system_type_register(struct bench *bench, const char *name, lodge_system_update_func_t update, struct lodge_system_components_desc reads, struct lodge_system_components_desc writes)
+{
+	return lodge_system_type_register((struct lodge_system_type_desc) {
+		.name = strview_make(name, strlen(name)),
+		.size = sizeof(int),
+		.update = update,
+		.userdata = bench,
+		.flags = LODGE_SYSTEM_TYPE_FLAG_CONCURRENT,
+		.reads = reads,
+		.writes = writes,
+	});
+}
+
+static void bench_run(lodge_scene_t scene, lodge_jobs_t jobs, uint32_t frames, const char *label)
+{
+	lodge_scene_set_jobs(scene, jobs);
+
+	// Warm up.
+	for(uint32_t i = 0; i < 10; i++) {
+		lodge_scene_update(scene, 1.0f / 60.0f);
+	}
+
+	double total_ms = 0.0;
+	double worst_ms = 0.0;
+	for(uint32_t i = 0; i < frames; i++) {
+		const lodge_timestamp_t before = lodge_timestamp_get();
+		lodge_scene_update(scene, 1.0f / 60.0f);
+		const double elapsed_ms = lodge_timestamp_elapsed_ms(before);
+		total_ms += elapsed_ms;
+		worst_ms = max(worst_ms, elapsed_ms);
+	}
+
+	const struct lodge_scene_update_stats stats = lodge_scene_get_update_stats(scene);
+	printf("%-10s threads: %2u  critical path: %u/%u systems  avg: %8.3f ms/frame  worst: %8.3f ms\n",
+		label,
+		stats.threads_count,
+		stats.critical_path,
+		stats.systems_count,
+		total_ms / frames,
+		worst_ms
+	);
+}
+
+int main(int argc, char **argv)
+{
+	const uint32_t entities_count = (argc > 1) ? (uint32_t)atoi(argv[1]) : 8192;
+	const uint32_t frames = (argc > 2) ? (uint32_t)atoi(argv[2]) : 100;
+	const uint32_t threads_count = (argc > 3) ? (uint32_t)atoi(argv[3]) : max(lodge_thread_get_hardware_concurrency(), 2) - 1;
+
+	struct bench bench = {
+		.work = 32,
+	};
+
+	BENCH_POSITION = bench_component_type_register("bench_position", sizeof(struct bench_position));
+	BENCH_VELOCITY = bench_component_type_register("bench_velocity", sizeof(struct bench_velocity));
+	BENCH_HEALTH = bench_component_type_register("bench_health", sizeof(struct bench_health));
+	BENCH_BOUNDS = bench_component_type_register("bench_bounds", sizeof(struct bench_bounds));
+
+	//
+	// integrate -> bounds and integrate -> drag are ordered, health is independent.
+	//
+	const lodge_system_type_t system_types[] = {
+		bench_system_type_register(&bench, "bench_integrate", &bench_integrate_update,
+			(struct lodge_system_components_desc) { .count = 1, .elements = { BENCH_VELOCITY } },
+			(struct lodge_system_components_desc) { .count = 1, .elements = { BENCH_POSITION } }),
+		bench_system_type_register(&bench, "bench_health", &bench_health_update,
+			(struct lodge_system_components_desc) { .count = 0 },
+			(struct lodge_system_components_desc) { .count = 1, .elements = { BENCH_HEALTH } }),
+		bench_system_type_register(&bench, "bench_bounds", &bench_bounds_update,
+			(struct lodge_system_components_desc) { .count = 1, .elements = { BENCH_POSITION } },
+			(struct lodge_system_components_desc) { .count = 1, .elements = { BENCH_BOUNDS } }),
+		bench_system_type_register(&bench, "bench_drag", &bench_drag_update,
+			(struct lodge_system_components_desc) { .count = 0 },
+			(struct lodge_system_components_desc) { .count = 1, .elements = { BENCH_VELOCITY } }),
+	};
+
+	lodge_scene_t scene = malloc(lodge_scene_sizeof());
+	lodge_scene_new_inplace(scene);
+
+	for(size_t i = 0; i < LODGE_ARRAYSIZE(system_types); i++) {
+		lodge_scene_add_system(scene, system_types[i]);
+	}
+
+	for(uint32_t i = 0; i < entities_count; i++) {
+		const lodge_entity_t entity = lodge_scene_add_entity_from_desc(scene, &(struct lodge_entity_desc) { .id = 0 }, NULL);
+
+		struct bench_position *position = (struct bench_position *)lodge_scene_add_entity_component(scene, entity, BENCH_POSITION);
+		position->value = vec3_make((float)(i % 128), 0.0f, (float)(i / 128));
+
+		struct bench_velocity *velocity = (struct bench_velocity *)lodge_scene_add_entity_component(scene, entity, BENCH_VELOCITY);
+		velocity->value = vec3_make(1.0f, 0.0f, 0.5f);
+
+		struct bench_health *health = (struct bench_health *)lodge_scene_add_entity_component(scene, entity, BENCH_HEALTH);
+		health->value = 50.0f;
+		health->regen = 1.0f;
+
+		lodge_scene_add_entity_component(scene, entity, BENCH_BOUNDS);
+	}
+
+	printf("%u entities, %u frames\n", entities_count, frames);
+
+	bench_run(scene, NULL, frames, "serial");
+
+	lodge_jobs_t jobs = lodge_jobs_new(threads_count);
+	bench_run(scene, jobs, frames, "scheduled");
+	lodge_scene_set_jobs(scene, NULL);
+	lodge_jobs_free(jobs);
+
+	lodge_scene_free_inplace(scene);
+	free(scene);
+
+	return 0;
+}
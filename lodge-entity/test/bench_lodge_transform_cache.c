@@ -0,0 +1,170 @@
+//
+// World transforms of every entity in a hierarchy whose roots move each frame: walking the
+// parents recursively in `lodge_get_transform`, against refreshing the scene's transform
+// cache and reading from it. Deep chains are the worst case for the recursive walk, wide
+// fan-outs the common one.
+//
+// Usage: bench_lodge_transform_cache [frames]
+//
+
+#include "lodge_scene.h"
+#include "lodge_transform_component.h"
+#include "lodge_time.h"
+#include "lodge_platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+struct bench_hierarchy
+{
+	const char					*label;
+	uint32_t					roots_count;
+	uint32_t					depth;			// Levels below each root.
+	uint32_t					fan_out;		// Children per node.
+};
+
+struct bench_scene
+{
+	lodge_scene_t				scene;
+	uint32_t					entities_count;
+	lodge_entity_t				*entities;
+	uint32_t					roots_count;
+	lodge_entity_t				*roots;
+};
+
+static lodge_entity_t bench_add_entity(struct bench_scene *bench, lodge_entity_t parent, float offset)
+{
+	const lodge_entity_t entity = lodge_scene_add_entity_from_desc(bench->scene, &(struct lodge_entity_desc) { .id = 0, .parent = parent }, NULL);
+
+	struct lodge_transform_component *transform = (struct lodge_transform_component *)lodge_scene_add_entity_component(bench->scene, entity, LODGE_COMPONENT_TYPE_TRANSFORM);
+	transform->translation = vec3_make(offset, 1.0f, 0.0f);
+	transform->rotation = vec3_make(0.0f, 0.01f, 0.0f);
+
+	bench->entities[bench->entities_count++] = entity;
+	return entity;
+}
+
+static void bench_add_children(struct bench_scene *bench, const struct bench_hierarchy *hierarchy, lodge_entity_t parent, uint32_t level)
+{
+	if(level == hierarchy->depth) {
+		return;
+	}
+	for(uint32_t i = 0; i < hierarchy->fan_out; i++) {
+		const lodge_entity_t child = bench_add_entity(bench, parent, (float)i);
+		bench_add_children(bench, hierarchy, child, level + 1);
+	}
+}
+
+static uint32_t bench_hierarchy_count(const struct bench_hierarchy *hierarchy)
+{
+	uint32_t count = 1;
+	uint32_t level_count = 1;
+	for(uint32_t i = 0; i < hierarchy->depth; i++) {
+		level_count *= hierarchy->fan_out;
+		count += level_count;
+	}
+	return hierarchy->roots_count * count;
+}
+
+static struct bench_scene bench_scene_new(const struct bench_hierarchy *hierarchy)
+{
+	struct bench_scene bench = {
+		.scene = malloc(lodge_scene_sizeof()),
+		.entities = malloc(bench_hierarchy_count(hierarchy) * sizeof(lodge_entity_t)),
+		.roots_count = hierarchy->roots_count,
+		.roots = malloc(hierarchy->roots_count * sizeof(lodge_entity_t)),
+	};
+	lodge_scene_new_inplace(bench.scene);
+
+	for(uint32_t i = 0; i < hierarchy->roots_count; i++) {
+		bench.roots[i] = bench_add_entity(&bench, NULL, (float)i);
+		bench_add_children(&bench, hierarchy, bench.roots[i], 0);
+	}
+
+	return bench;
+}
+
+static void bench_scene_free(struct bench_scene *bench)
+{
+	lodge_scene_free_inplace(bench->scene);
+	free(bench->scene);
+	free(bench->entities);
+	free(bench->roots);
+}
+
+//
+// Written straight to the component, like a system would, so the cache sees the change.
+//
+static void bench_move_roots(struct bench_scene *bench, uint32_t frame)
+{
+	for(uint32_t i = 0; i < bench->roots_count; i++) {
+		struct lodge_transform_component *transform = lodge_scene_get_entity_component(bench->scene, bench->roots[i], LODGE_COMPONENT_TYPE_TRANSFORM);
+		transform->translation.z = (float)frame;
+	}
+}
+
+static void bench_run(const struct bench_hierarchy *hierarchy, bool cached, uint32_t frames)
+{
+	struct bench_scene bench = bench_scene_new(hierarchy);
+	struct lodge_transform_cache *cache = lodge_scene_get_transform_cache(bench.scene);
+
+	float checksum = 0.0f;
+	double total_ms = 0.0;
+	double worst_ms = 0.0;
+
+	for(uint32_t i = 0; i < frames + 10; i++) {
+		bench_move_roots(&bench, i);
+
+		//
+		// Without a refresh the cache is never initialized, and every call walks to the root.
+		//
+		const lodge_timestamp_t before = lodge_timestamp_get();
+		if(cached) {
+			lodge_transform_cache_update(cache, bench.scene);
+		}
+		for(uint32_t j = 0; j < bench.entities_count; j++) {
+			const mat4 transform = lodge_get_transform(bench.scene, bench.entities[j]);
+			checksum += transform.m[12];
+		}
+		const double elapsed_ms = lodge_timestamp_elapsed_ms(before);
+
+		// Warm up.
+		if(i >= 10) {
+			total_ms += elapsed_ms;
+			worst_ms = max(worst_ms, elapsed_ms);
+		}
+	}
+
+	printf("%-6s %-10s entities: %6u  avg: %8.3f ms/frame  worst: %8.3f ms  (checksum %g)\n",
+		hierarchy->label,
+		cached ? "cached" : "recursive",
+		bench.entities_count,
+		total_ms / frames,
+		worst_ms,
+		checksum
+	);
+
+	bench_scene_free(&bench);
+}
+
+int main(int argc, char **argv)
+{
+	const uint32_t frames = (argc > 1) ? (uint32_t)atoi(argv[1]) : 100;
+
+	lodge_transform_component_type_register();
+
+	const struct bench_hierarchy hierarchies[] = {
+		{ .label = "deep", .roots_count = 64, .depth = 255, .fan_out = 1 },
+		{ .label = "wide", .roots_count = 64, .depth = 1, .fan_out = 255 },
+		{ .label = "tree", .roots_count = 64, .depth = 4, .fan_out = 4 },
+	};
+
+	printf("%u frames\n", frames);
+
+	for(size_t i = 0; i < LODGE_ARRAYSIZE(hierarchies); i++) {
+		bench_run(&hierarchies[i], false, frames);
+		bench_run(&hierarchies[i], true, frames);
+	}
+
+	return 0;
+}
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <inttypes.h>
+#include <limits.h>
 
 #include <stb/stb_image.h> // for stbi_zlib_decode_buffer()
 
@@ -12,7 +13,8 @@
 #include "strview.h"
 #include "blob.h"
 #include "blob_cur.h"
-#include "alist.h"
+#include "lodge_platform.h"
+#include "lodge_jobs.h"
 
 #define FBX_FILE_MAGIC "Kaydara FBX Binary  "
 
@@ -25,44 +27,79 @@
 #define FBX_VERSION_7_4 7400
 #define FBX_VERSION_7_5 7500	// FBX v7.5 adds large file support and is incompatible with < 7.5.
 
-struct fbx_array_type
-{
-	uint32_t				array_length;
-	uint32_t				encoding;
-	uint32_t				compressed_length;
-	const char*				contents;
-};
+//
+// All nodes, properties and decompressed arrays of a document live in one arena, so
+// parsing does a handful of allocations instead of one per node and property, and
+// `fbx_free()` releases the whole document at once.
+//
+// The first block is sized from the input; more blocks are only chained on when that
+// estimate falls short (deeply nested files with lots of tiny nodes, or large
+// compressed arrays).
+//
+#define FBX_ARENA_ALIGNMENT			sizeof(double)
+#define FBX_ARENA_BLOCK_SIZE_MIN	(64*1024)
+
+//
+// Small arrays are inflated in batches of about this many bytes, so a mesh with
+// thousands of tiny arrays does not turn into thousands of jobs.
+//
+#define FBX_INFLATE_BATCH_SIZE		(256*1024)
 
-struct fbx_property_special
+struct fbx_arena_block
 {
-	uint32_t				length;
-	char					data[];
+	struct fbx_arena_block	*next;
+	size_t					size;
+	size_t					used;
+	double					data[];		// `double` for alignment.
 };
 
-struct fbx_property_array
+struct fbx_arena
 {
-	uint32_t				array_length;
-	uint32_t				encoding;
-	uint32_t				compressed_length;
-	char					data[];
+	struct fbx_arena_block	*blocks;			// Newest first.
 };
 
 struct fbx_property
 {
 	char					type;
-	void*					heap_data;
-	char					static_data[sizeof(double)];
+	char					inflate_pending;
+	uint32_t				length;			// Byte length for strings and binaries, element count for arrays.
+	union
+	{
+		char				static_data[sizeof(double)];
+		const char*			data;			// Points into the source buffer, or into the arena if it was decompressed or unaligned.
+		struct fbx_inflate	*inflate;		// While `inflate_pending`.
+	};
+};
+
+//
+// A compressed array, recorded during the structural pass.
+//
+struct fbx_inflate
+{
+	struct fbx_inflate		*next;
+	struct fbx_property		*prop;
+	const char				*src;
+	uint32_t				src_size;
+	char					*dst;			// Reserved in the arena up front, so inflating never allocates.
+	size_t					dst_size;
+};
+
+struct fbx_inflate_batch
+{
+	struct fbx_inflate		*first;
+	size_t					count;
+	int						failed;
 };
 
 struct fbx_node
 {
-	uint64_t				end_offset;				// uint32_t for < v7.5
-	uint64_t				properties_count;		// uint32_t for < v7.5
-	uint64_t				properties_list_len;	// uint32_t for < v7.5
+	const char				*name;			// Points into the source buffer; not terminated.
 	uint8_t					name_len;
-	char					name[255];
-	struct alist			*properties;
-	struct alist			*children;
+	uint64_t				properties_count;
+	struct fbx_property		*properties;
+	size_t					children_count;
+	struct fbx_node			*children;		// First child.
+	struct fbx_node			*next;			// Next sibling.
 };
 
 struct fbx
@@ -70,9 +107,62 @@ struct fbx
 	char					magic[21];	// Bytes 0 - 20: `Kaydara FBX Binary  \x00` (file - magic, with 2 spaces at the end, then a NULL terminator)
 	char					pad[2];		// Bytes 21 - 22: [0x1A, 0x00] (unknown but all observed files show these bytes)
 	uint32_t				version;	// Bytes 23 - 26: unsigned int (7300 => FBX_VERSION_7_3)
-	struct alist			*children;
+	size_t					children_count;
+	struct fbx_node			*children;
+	struct fbx_inflate		*inflates;
+	struct fbx_inflate		**inflates_tail;
+	size_t					inflates_count;
+	struct fbx_arena		arena;
 };
 
+static struct fbx_arena_block* fbx_arena_block_new(size_t size)
+{
+	struct fbx_arena_block *block = (struct fbx_arena_block *)malloc(sizeof(struct fbx_arena_block) + size);
+	if(!block) {
+		return NULL;
+	}
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+	return block;
+}
+
+static void* fbx_arena_alloc(struct fbx_arena *arena, size_t size)
+{
+	size = (size + FBX_ARENA_ALIGNMENT - 1) & ~(FBX_ARENA_ALIGNMENT - 1);
+
+	struct fbx_arena_block *block = arena->blocks;
+	if(!block || block->size - block->used < size) {
+		//
+		// New blocks are at least as big as the last one, so a bad estimate only costs a
+		// few more blocks.
+		//
+		const size_t block_size = max(size, max(block ? block->size : 0, FBX_ARENA_BLOCK_SIZE_MIN));
+		block = fbx_arena_block_new(block_size);
+		if(!block) {
+			ASSERT_FAIL("FBX: Failed to allocate arena block");
+			return NULL;
+		}
+		block->next = arena->blocks;
+		arena->blocks = block;
+	}
+
+	void *ptr = (char *)block->data + block->used;
+	block->used += size;
+	return ptr;
+}
+
+static void fbx_arena_free(struct fbx_arena *arena)
+{
+	struct fbx_arena_block *it = arena->blocks;
+	while(it) {
+		struct fbx_arena_block *next = it->next;
+		free(it);
+		it = next;
+	}
+	arena->blocks = NULL;
+}
+
 static void fbx_print_header(const struct fbx *fbx)
 {
 	printf("magic: %s\n",		fbx->magic);
@@ -82,10 +172,10 @@ static void fbx_print_header(const struct fbx *fbx)
 
 static void fbx_print_node(const struct fbx_node *node, int print_arrays, int indent);
 
-static void fbx_print_node_list(const struct alist *list, int print_arrays, int indent)
+static void fbx_print_node_list(const struct fbx_node *first, int print_arrays, int indent)
 {
-	foreach_alist_p(struct fbx_node*, it, list) {
-		fbx_print_node(*it, print_arrays, indent);
+	for(const struct fbx_node *it = first; it; it = it->next) {
+		fbx_print_node(it, print_arrays, indent);
 	}
 }
 
@@ -127,46 +217,45 @@ static const char* fbx_property_get_type_string(const char type)
 	}
 }
 
-static void fbx_print_property_list(const struct alist *list, int print_arrays, int indent)
+static void fbx_print_property_list(const struct fbx_property *properties, uint64_t properties_count, int print_arrays, int indent)
 {
-	foreach_alist_p(struct fbx_property*, it, list) {
-		printf("%*sproperty: %s ", indent * 4, "", fbx_property_get_type_string((*it)->type));
+	for(uint64_t i = 0; i < properties_count; i++) {
+		const struct fbx_property *it = &properties[i];
+		printf("%*sproperty: %s ", indent * 4, "", fbx_property_get_type_string(it->type));
 
-		switch((*it)->type)
+		switch(it->type)
 		{
 		case FBX_PROPERTY_TYPE_INT16:
-			printf("(%" PRId16 ")", *(const int16_t*)(*it)->static_data);
+			printf("(%" PRId16 ")", *(const int16_t*)it->static_data);
 			break;
 		case FBX_PROPERTY_TYPE_BOOL:
-			printf("(%s)", (*it)->static_data[0] ? "true" : "false");
+			printf("(%s)", it->static_data[0] ? "true" : "false");
 			break;
 		case FBX_PROPERTY_TYPE_INT32:
-			printf("(%" PRId32 ")", *(const int32_t*)(*it)->static_data);
+			printf("(%" PRId32 ")", *(const int32_t*)it->static_data);
 			break;
 		case FBX_PROPERTY_TYPE_FLOAT:
-			printf("(%f)", *((const float*)(*it)->static_data));
+			printf("(%f)", *((const float*)it->static_data));
 			break;
 		case FBX_PROPERTY_TYPE_DOUBLE:
-			printf("(%f)", *((const double*)(*it)->static_data));
+			printf("(%f)", *((const double*)it->static_data));
 			break;
 		case FBX_PROPERTY_TYPE_INT64:
-			printf("(%" PRId64 ")", *((const int64_t*)(*it)->static_data));
+			printf("(%" PRId64 ")", *((const int64_t*)it->static_data));
 			break;
 		case FBX_PROPERTY_TYPE_BINARY:
 		case FBX_PROPERTY_TYPE_STRING:
 		{
-			ASSERT((*it)->heap_data);
-			const struct fbx_property_special *prop_special = (const struct fbx_property_special*)(*it)->heap_data;
-			printf("(%.*s)", prop_special->length, prop_special->data);
+			printf("(%.*s)", (int)it->length, it->data);
 			break;
 		}
 		case FBX_PROPERTY_TYPE_ARRAY_FLOAT:
 		{
-			const uint32_t prop_array_count = fbx_property_get_array_count(*it);
-			const float* prop_array_data = fbx_property_get_array_float(*it);
+			const uint32_t prop_array_count = fbx_property_get_array_count(it);
+			const float* prop_array_data = fbx_property_get_array_float(it);
 			printf("(%u) {", prop_array_count);
 
-			if(print_arrays) {
+			if(print_arrays && prop_array_data) {
 				for(uint32_t i = 0; i < prop_array_count; i++) {
 					printf("%.2f ", prop_array_data[i]);
 				}
@@ -179,11 +268,11 @@ static void fbx_print_property_list(const struct alist *list, int print_arrays,
 		}
 		case FBX_PROPERTY_TYPE_ARRAY_INT32:
 		{
-			const uint32_t prop_array_count = fbx_property_get_array_count(*it);
-			const int32_t* prop_array_data = fbx_property_get_array_int32(*it);
+			const uint32_t prop_array_count = fbx_property_get_array_count(it);
+			const int32_t* prop_array_data = fbx_property_get_array_int32(it);
 			printf("(%u) {", prop_array_count);
 
-			if(print_arrays) {
+			if(print_arrays && prop_array_data) {
 				for(uint32_t i = 0; i < prop_array_count; i++) {
 					printf("%" PRId32 " ", prop_array_data[i]);
 				}
@@ -196,11 +285,11 @@ static void fbx_print_property_list(const struct alist *list, int print_arrays,
 		}
 		case FBX_PROPERTY_TYPE_ARRAY_DOUBLE:
 		{
-			const uint32_t prop_array_count = fbx_property_get_array_count(*it);
-			const double* prop_array_data = fbx_property_get_array_double(*it);
+			const uint32_t prop_array_count = fbx_property_get_array_count(it);
+			const double* prop_array_data = fbx_property_get_array_double(it);
 			printf("(%u) {", prop_array_count);
 
-			if(print_arrays) {
+			if(print_arrays && prop_array_data) {
 				for(uint32_t i = 0; i < prop_array_count; i++) {
 					printf("%.2f ", prop_array_data[i]);
 				}
@@ -213,11 +302,11 @@ static void fbx_print_property_list(const struct alist *list, int print_arrays,
 		}
 		case FBX_PROPERTY_TYPE_ARRAY_INT64:
 		{
-			const uint32_t prop_array_count = fbx_property_get_array_count(*it);
-			const int64_t* prop_array_data = fbx_property_get_array_int64(*it);
+			const uint32_t prop_array_count = fbx_property_get_array_count(it);
+			const int64_t* prop_array_data = fbx_property_get_array_int64(it);
 			printf("(%u) {", prop_array_count);
 
-			if(print_arrays) {
+			if(print_arrays && prop_array_data) {
 				for(uint32_t i = 0; i < prop_array_count; i++) {
 					printf("%" PRId64 " ", prop_array_data[i]);
 				}
@@ -230,11 +319,11 @@ static void fbx_print_property_list(const struct alist *list, int print_arrays,
 		}
 		case FBX_PROPERTY_TYPE_ARRAY_BOOL:
 		{
-			const uint32_t prop_array_count = fbx_property_get_array_count(*it);
-			const char* prop_array_data = fbx_property_get_array_bool(*it);
+			const uint32_t prop_array_count = fbx_property_get_array_count(it);
+			const char* prop_array_data = fbx_property_get_array_bool(it);
 			printf("(%u) {", prop_array_count);
 
-			if(print_arrays) {
+			if(print_arrays && prop_array_data) {
 				for(uint32_t i = 0; i < prop_array_count; i++) {
 					printf("%s ", prop_array_data[i] ? "true" : "false");
 				}
@@ -247,11 +336,11 @@ static void fbx_print_property_list(const struct alist *list, int print_arrays,
 		}
 		case FBX_PROPERTY_TYPE_ARRAY_CHAR:
 		{
-			const uint32_t prop_array_count = fbx_property_get_array_count(*it);
-			const char* prop_array_data = fbx_property_get_array_char(*it);
+			const uint32_t prop_array_count = fbx_property_get_array_count(it);
+			const char* prop_array_data = fbx_property_get_array_char(it);
 			printf("(%u) {", prop_array_count);
 
-			if(print_arrays) {
+			if(print_arrays && prop_array_data) {
 				for(uint32_t i = 0; i < prop_array_count; i++) {
 					printf("%c ", prop_array_data[i]);
 				}
@@ -275,28 +364,24 @@ static void fbx_print_node(const struct fbx_node *node, int print_arrays, int in
 	printf("%*s`%.*s` (%zu children, %" PRIu64 " props)\n",
 		indent * 4, "",
 		node->name_len, node->name,
-		node->children ? alist_count(node->children) : 0,
+		node->children_count,
 		node->properties_count);
 
 	indent++;
 
-	if(node->properties) {
-		fbx_print_property_list(node->properties, print_arrays, indent);
-	}
-
-	if(node->children) {
-		fbx_print_node_list(node->children, print_arrays, indent);
-	}
+	fbx_print_property_list(node->properties, node->properties_count, print_arrays, indent);
+	fbx_print_node_list(node->children, print_arrays, indent);
 }
 
-static void fbx_property_free(struct fbx_property *prop)
-{
-	free(prop->heap_data);
-	prop->heap_data = NULL;
-	free(prop);
-}
-
-static struct fbx_property_array* fbx_property_array_new(size_t element_size, struct blob_cur *cur)
+//
+// Uncompressed arrays are referenced in place. The source buffer makes no alignment
+// promises though, so arrays that would be read through a misaligned pointer are copied
+// into the arena instead.
+//
+// Compressed arrays only get their destination reserved here; they are inflated after the
+// structural pass (see `fbx_inflate_all()`), or on first access for lazy documents.
+//
+static int fbx_property_array_read(struct fbx_property *prop, size_t element_size, struct fbx *fbx, struct blob_cur *cur)
 {
 	uint32_t array_length = 0;
 	uint32_t encoding = 0;
@@ -305,232 +390,140 @@ static struct fbx_property_array* fbx_property_array_new(size_t element_size, st
 		|| !blob_cur_read(encoding, cur)
 		|| !blob_cur_read(compressed_length, cur)) {
 		ASSERT_FAIL("FBX: Failed to read property array header");
-		return NULL;
+		return 0;
 	}
 
-	size_t array_size = array_length * element_size;
-	struct fbx_property_array* prop_array = calloc(1, sizeof(struct fbx_property_array) + array_size);
-	prop_array->array_length = array_length;
-	prop_array->encoding = encoding;
-	prop_array->compressed_length = compressed_length;
+	const size_t array_size = (size_t)array_length * element_size;
+	prop->length = array_length;
 
-	if(prop_array->encoding) {
-		if(blob_cur_can_read(cur, compressed_length)
-			&& stbi_zlib_decode_buffer(prop_array->data, (int)array_size, cur->it, prop_array->compressed_length) != array_size) {
-			ASSERT_FAIL("FBX: Property array decode failed");
-			goto fail;
+	if(encoding) {
+		if(!blob_cur_can_read(cur, compressed_length) || array_size > INT_MAX) {
+			ASSERT_FAIL("FBX: Property array overrun");
+			return 0;
+		}
+
+		struct fbx_inflate *inflate = (struct fbx_inflate *)fbx_arena_alloc(&fbx->arena, sizeof(struct fbx_inflate));
+		char *dst = (char *)fbx_arena_alloc(&fbx->arena, array_size);
+		if(!inflate || !dst) {
+			return 0;
 		}
-		if(!blob_cur_advance(cur, prop_array->compressed_length)) {
+		*inflate = (struct fbx_inflate) {
+			.prop = prop,
+			.src = cur->it,
+			.src_size = compressed_length,
+			.dst = dst,
+			.dst_size = array_size,
+		};
+		*fbx->inflates_tail = inflate;
+		fbx->inflates_tail = &inflate->next;
+		fbx->inflates_count++;
+
+		prop->inflate_pending = 1;
+		prop->inflate = inflate;
+
+		if(!blob_cur_advance(cur, compressed_length)) {
 			ASSERT_FAIL("FBX: Failed to advance data cursor");
-			goto fail;
+			return 0;
 		}
 	} else {
-		if(!blob_cur_read_type(prop_array->data, array_size, cur)) {
+		if(!blob_cur_can_read(cur, array_size)) {
 			ASSERT_FAIL("FBX: Failed to read property array data");
-			goto fail;
+			return 0;
 		}
-	}
 
-	return prop_array;
+		if(((uintptr_t)cur->it % element_size) == 0) {
+			prop->data = cur->it;
+		} else {
+			char *data = (char *)fbx_arena_alloc(&fbx->arena, array_size);
+			if(!data) {
+				return 0;
+			}
+			memcpy(data, cur->it, array_size);
+			prop->data = data;
+		}
 
-fail:
-	free(prop_array);
-	return NULL;
+		if(!blob_cur_advance(cur, array_size)) {
+			ASSERT_FAIL("FBX: Failed to advance data cursor");
+			return 0;
+		}
+	}
+
+	return 1;
 }
 
-static const struct fbx_property_array* fbx_property_get_array(const struct fbx_property *prop)
+static int fbx_property_is_array_type(char type)
 {
-	switch(prop->type)
+	switch(type)
 	{
-	case FBX_PROPERTY_TYPE_INT16:
-	case FBX_PROPERTY_TYPE_BOOL:
-	case FBX_PROPERTY_TYPE_INT32:
-	case FBX_PROPERTY_TYPE_FLOAT:
-	case FBX_PROPERTY_TYPE_DOUBLE:
-	case FBX_PROPERTY_TYPE_INT64:
-	case FBX_PROPERTY_TYPE_BINARY:
-	case FBX_PROPERTY_TYPE_STRING:
-		return NULL;
 	case FBX_PROPERTY_TYPE_ARRAY_FLOAT:
 	case FBX_PROPERTY_TYPE_ARRAY_INT32:
 	case FBX_PROPERTY_TYPE_ARRAY_DOUBLE:
 	case FBX_PROPERTY_TYPE_ARRAY_INT64:
 	case FBX_PROPERTY_TYPE_ARRAY_BOOL:
 	case FBX_PROPERTY_TYPE_ARRAY_CHAR:
-	{
-		ASSERT(prop->heap_data);
-		return (const struct fbx_property_array*)(prop->heap_data);
-	}
+		return 1;
 	default:
-		return NULL;
+		return 0;
 	}
 }
 
-static struct fbx_property* fbx_property_new(struct blob_cur *cur)
+static int fbx_property_read(struct fbx_property *prop, struct fbx *fbx, struct blob_cur *cur)
 {
-	struct fbx_property* prop = (struct fbx_property*) calloc(1, sizeof(struct fbx_property));
-	if(!prop) {
-		ASSERT_FAIL("FBX: Failed to allocate property");
-		return NULL;
-	}
-	prop->heap_data = NULL;
-
 	if(!blob_cur_read(prop->type, cur)) {
 		ASSERT_FAIL("FBX: Failed to read property type");
-		goto fail;
+		return 0;
 	}
 
 	switch(prop->type) {
 	case FBX_PROPERTY_TYPE_INT16:
-	{
-		if(!blob_cur_read_type(prop->static_data, sizeof(int16_t), cur)) {
-			goto fail;
-		}
-		break;
-	}
+		return blob_cur_read_type(prop->static_data, sizeof(int16_t), cur);
 	case FBX_PROPERTY_TYPE_BOOL:
-	{
-		if(!blob_cur_read_type(prop->static_data, sizeof(char), cur)) {
-			goto fail;
-		}
-		break;
-	}
+		return blob_cur_read_type(prop->static_data, sizeof(char), cur);
 	case FBX_PROPERTY_TYPE_INT32:
-	{
-		if(!blob_cur_read_type(prop->static_data, sizeof(int32_t), cur)) {
-			goto fail;
-		}
-		break;
-	}
+		return blob_cur_read_type(prop->static_data, sizeof(int32_t), cur);
 	case FBX_PROPERTY_TYPE_FLOAT:
-	{
-		if(!blob_cur_read_type(prop->static_data, sizeof(float), cur)) {
-			goto fail;
-		}
-		break;
-	}
+		return blob_cur_read_type(prop->static_data, sizeof(float), cur);
 	case FBX_PROPERTY_TYPE_DOUBLE:
-	{
-		if(!blob_cur_read_type(prop->static_data, sizeof(double), cur)) {
-			goto fail;
-		}
-		break;
-	}
+		return blob_cur_read_type(prop->static_data, sizeof(double), cur);
 	case FBX_PROPERTY_TYPE_INT64:
-	{
-		if(!blob_cur_read_type(prop->static_data, sizeof(int64_t), cur)) {
-			goto fail;
-		}
-		break;
-	}
+		return blob_cur_read_type(prop->static_data, sizeof(int64_t), cur);
 	case FBX_PROPERTY_TYPE_BINARY:
 	case FBX_PROPERTY_TYPE_STRING:
 	{
 		uint32_t special_size = 0;
 		if(!blob_cur_read(special_size, cur)) {
 			ASSERT_FAIL("FBX: Failed to read special property size");
-			goto fail;
+			return 0;
 		}
 
-		struct fbx_property_special* special = calloc(1, sizeof(struct fbx_property_special) + special_size);
-		special->length = special_size;
-		prop->heap_data = special;
+		prop->length = special_size;
+		prop->data = cur->it;
 
-		if(!blob_cur_read_type(special->data, special_size, cur)) {
+		if(!blob_cur_advance(cur, special_size)) {
 			ASSERT_FAIL("FBX: Property data underrun");
-			goto fail;
+			return 0;
 		}
-		break;
+		return 1;
 	}
 	case FBX_PROPERTY_TYPE_ARRAY_FLOAT:
-	{
-		struct fbx_property_array *array = fbx_property_array_new(sizeof(float), cur);
-		if(array) {
-			prop->heap_data = array;
-		} else {
-			goto fail;
-		}
-		break;
-	}
+		return fbx_property_array_read(prop, sizeof(float), fbx, cur);
 	case FBX_PROPERTY_TYPE_ARRAY_INT32:
-	{
-		struct fbx_property_array *array = fbx_property_array_new(sizeof(int32_t), cur);
-		if(array) {
-			prop->heap_data = array;
-		} else {
-			goto fail;
-		}
-		break;
-	}
+		return fbx_property_array_read(prop, sizeof(int32_t), fbx, cur);
 	case FBX_PROPERTY_TYPE_ARRAY_DOUBLE:
-	{
-		struct fbx_property_array *array = fbx_property_array_new(sizeof(double), cur);
-		if(array) {
-			prop->heap_data = array;
-		} else {
-			goto fail;
-		}
-		break;
-	}
+		return fbx_property_array_read(prop, sizeof(double), fbx, cur);
 	case FBX_PROPERTY_TYPE_ARRAY_INT64:
-	{
-		struct fbx_property_array *array = fbx_property_array_new(sizeof(int64_t), cur);
-		if(array) {
-			prop->heap_data = array;
-		} else {
-			goto fail;
-		}
-		break;
-	}
+		return fbx_property_array_read(prop, sizeof(int64_t), fbx, cur);
 	case FBX_PROPERTY_TYPE_ARRAY_BOOL:
-	{
-		struct fbx_property_array *array = fbx_property_array_new(sizeof(char), cur);
-		if(array) {
-			prop->heap_data = array;
-		} else {
-			goto fail;
-		}
-		break;
-	}
+		return fbx_property_array_read(prop, sizeof(char), fbx, cur);
 	case FBX_PROPERTY_TYPE_ARRAY_CHAR:
-	{
-		struct fbx_property_array *array = fbx_property_array_new(sizeof(char), cur);
-		if(array) {
-			prop->heap_data = array;
-		} else {
-			goto fail;
-		}
-		break;
-	}
+		return fbx_property_array_read(prop, sizeof(char), fbx, cur);
 	default:
 		ASSERT_FAIL("FBX: Unknown property type");
-		goto fail;
-	}
-
-	return prop;
-
-fail:
-	fbx_property_free(prop);
-	return NULL;
-}
-
-static void fbx_node_free(struct fbx_node *node)
-{
-	if(node->properties) {
-		alist_free(node->properties, 1);
-		node->properties = NULL;
-	}
-	if(node->children) {
-		foreach_alist(struct fbx_node*, it, index, node->children) {
-			fbx_node_free(it);
-		}
-		alist_free(node->children, 0);
-		node->children = NULL;
+		return 0;
 	}
-	free(node);
 }
 
-static struct alist* fbx_node_read_children(const int32_t version, struct blob_cur *cur);
+static int fbx_node_read_children(const uint32_t version, struct fbx *fbx, struct blob_cur *cur, struct fbx_node **children, size_t *children_count);
 
 //
 // v7.5+ uses uint64_t and uint32_t for older versions.
@@ -549,65 +542,73 @@ static int fbx_read_size_compat(uint64_t *dst, const uint32_t version, struct bl
 	}
 }
 
-static int fbx_read_node_header(const int32_t version, uint64_t *properties_count, uint64_t *properties_list_len, uint8_t *name_len, struct blob_cur *cur)
+static int fbx_read_node_header(const uint32_t version, uint64_t *properties_count, uint64_t *properties_list_len, uint8_t *name_len, struct blob_cur *cur)
 {
 	return fbx_read_size_compat(properties_count, version, cur)
 		&& fbx_read_size_compat(properties_list_len, version, cur)
 		&& blob_cur_read(*name_len, cur);
 }
 
-static struct fbx_node* fbx_node_new(const int32_t version, uint64_t end_offset, struct blob_cur *cur)
+static struct fbx_node* fbx_node_new(const uint32_t version, struct fbx *fbx, struct blob_cur *cur)
 {
-	ASSERT(end_offset);
-
-	struct fbx_node *node = (struct fbx_node*)calloc(1, sizeof(struct fbx_node));
-	node->end_offset = end_offset;
+	struct fbx_node *node = (struct fbx_node*)fbx_arena_alloc(&fbx->arena, sizeof(struct fbx_node));
+	if(!node) {
+		return NULL;
+	}
+	*node = (struct fbx_node) { 0 };
 
-	if(!fbx_read_node_header(version, &node->properties_count, &node->properties_list_len, &node->name_len, cur)) {
+	uint64_t properties_list_len = 0;
+	if(!fbx_read_node_header(version, &node->properties_count, &properties_list_len, &node->name_len, cur)) {
 		ASSERT_FAIL("FBX: Failed to read node header");
-		goto fail;
+		return NULL;
 	}
 
 	ASSERT(node->name_len);
 
-	if(!(blob_cur_read_type(node->name, node->name_len, cur))) {
+	node->name = cur->it;
+	if(!blob_cur_advance(cur, node->name_len)) {
 		ASSERT_FAIL("FBX: Failed to read node name");
-		goto fail;
+		return NULL;
 	}
 
 	if(node->properties_count > 0) {
-		node->properties = alist_new((size_t)node->properties_count);
+		//
+		// Every property is at least two bytes, which bounds the allocation for corrupt files.
+		//
+		if(node->properties_count > blob_cur_remaining(cur) / 2) {
+			ASSERT_FAIL("FBX: Property count overrun");
+			return NULL;
+		}
+
+		node->properties = (struct fbx_property*)fbx_arena_alloc(&fbx->arena, (size_t)node->properties_count * sizeof(struct fbx_property));
+		if(!node->properties) {
+			return NULL;
+		}
 
 		for(uint64_t i = 0; i < node->properties_count; i++) {
-			struct fbx_property *prop = fbx_property_new(cur);
-			if(!prop) {
+			node->properties[i] = (struct fbx_property) { 0 };
+			if(!fbx_property_read(&node->properties[i], fbx, cur)) {
 				ASSERT_FAIL("FBX: Failed to read property");
-				goto fail;
+				return NULL;
 			}
-			alist_append(node->properties, prop);
 		}
 	}
 
 	if(!blob_cur_is_empty(cur)) {
-		node->children = fbx_node_read_children(version, cur);
-		if(!node->children) {
+		if(!fbx_node_read_children(version, fbx, cur, &node->children, &node->children_count)) {
 			ASSERT_FAIL("FBX: Failed to read children");
-			goto fail;
+			return NULL;
 		}
 	}
 
 	return node;
-
-fail:
-	fbx_node_free(node);
-	return NULL;
 }
 
-static struct alist* fbx_node_read_children(const int32_t version, struct blob_cur *cur)
+static int fbx_node_read_children(const uint32_t version, struct fbx *fbx, struct blob_cur *cur, struct fbx_node **children, size_t *children_count)
 {
 	ASSERT(!blob_cur_is_empty(cur));
 
-	struct alist *children = alist_new(8);
+	struct fbx_node **tail = children;
 
 	while(!blob_cur_is_empty(cur)) {
 		uint64_t end_offset = 0;
@@ -615,7 +616,7 @@ static struct alist* fbx_node_read_children(const int32_t version, struct blob_c
 		while(1) {
 			if(!fbx_read_size_compat(&end_offset, version, cur)) {
 				ASSERT_FAIL("FBX: Failed to read node header");
-				goto fail;
+				return 0;
 			}
 
 			if(end_offset == 0) {
@@ -626,15 +627,18 @@ static struct alist* fbx_node_read_children(const int32_t version, struct blob_c
 			}
 
 			struct blob_cur child_cur = blob_cur_make_from_start(cur, (size_t)end_offset);
-			struct fbx_node *child = fbx_node_new(version, end_offset, &child_cur);
+			struct fbx_node *child = fbx_node_new(version, fbx, &child_cur);
 			if(!child) {
 				ASSERT_FAIL("FBX: Failed to parse root child");
-				goto fail;
+				return 0;
 			}
-			alist_append(children, child);
+			*tail = child;
+			tail = &child->next;
+			(*children_count)++;
+
 			if(!blob_cur_mirror(cur, &child_cur)) {
 				ASSERT_FAIL("FBX: Failed to mirror data cursor");
-				goto fail;
+				return 0;
 			}
 		}
 
@@ -652,25 +656,103 @@ static struct alist* fbx_node_read_children(const int32_t version, struct blob_c
 			break;
 		} else {
 			ASSERT_FAIL("FBX: Failed to read null node");
-			goto fail;
+			return 0;
 		}
 	}
 
-	return children;
+	return 1;
+}
 
-fail:
-	if(children) {
-		foreach_alist(struct fbx_node*, it, index, children) {
-			fbx_node_free(it);
+static int fbx_inflate_run(struct fbx_inflate *inflate)
+{
+	if(stbi_zlib_decode_buffer(inflate->dst, (int)inflate->dst_size, inflate->src, (int)inflate->src_size) != (int)inflate->dst_size) {
+		return 0;
+	}
+	inflate->prop->data = inflate->dst;
+	inflate->prop->inflate_pending = 0;
+	return 1;
+}
+
+static void fbx_inflate_batch_run(struct fbx_inflate_batch *batch)
+{
+	struct fbx_inflate *it = batch->first;
+	for(size_t i = 0; i < batch->count; i++, it = it->next) {
+		if(!fbx_inflate_run(it)) {
+			batch->failed = 1;
 		}
-		alist_free(children, 0);
 	}
-	return NULL;
+}
+
+//
+// Every array has its own destination, so batches can run on any thread without
+// touching the arena.
+//
+static int fbx_inflate_all(struct fbx *fbx, struct lodge_jobs *jobs)
+{
+	struct lodge_job_counter counter = { 0 };
+	struct fbx_inflate_batch *batches = (struct fbx_inflate_batch *)fbx_arena_alloc(&fbx->arena, fbx->inflates_count * sizeof(struct fbx_inflate_batch));
+	if(fbx->inflates_count && !batches) {
+		return 0;
+	}
+
+	size_t batches_count = 0;
+	for(struct fbx_inflate *it = fbx->inflates; it; ) {
+		struct fbx_inflate_batch *batch = &batches[batches_count++];
+		*batch = (struct fbx_inflate_batch) {
+			.first = it,
+		};
+
+		size_t batch_size = 0;
+		while(it && (batch->count == 0 || batch_size + it->dst_size <= FBX_INFLATE_BATCH_SIZE)) {
+			batch_size += it->dst_size;
+			batch->count++;
+			it = it->next;
+		}
+
+		lodge_jobs_submit(jobs, (lodge_job_func_t)&fbx_inflate_batch_run, batch, &counter);
+	}
+
+	lodge_jobs_wait(jobs, &counter);
+
+	for(size_t i = 0; i < batches_count; i++) {
+		if(batches[i].failed) {
+			ASSERT_FAIL("FBX: Property array decode failed");
+			return 0;
+		}
+	}
+	return 1;
+}
+
+//
+// Node and property headers expand to about twice their size as `fbx_node` and
+// `fbx_property`, and compressed arrays inflate to a few times their stored size. Exports
+// with a mix of both come out at 1-1.5x the file size, so 2x keeps nearly every document
+// in a single block; pages that are never touched are never committed.
+//
+static size_t fbx_arena_size_estimate(size_t buf_size)
+{
+	return sizeof(struct fbx) + buf_size * 2;
 }
 
 struct fbx* fbx_new(const char *buf, size_t buf_size)
 {
-	struct fbx *fbx = (struct fbx*) calloc(1, sizeof(struct fbx));
+	return fbx_new_from_desc(buf, buf_size, &(struct fbx_desc) { 0 });
+}
+
+struct fbx* fbx_new_from_desc(const char *buf, size_t buf_size, const struct fbx_desc *desc)
+{
+	struct fbx_arena arena = { 0 };
+	arena.blocks = fbx_arena_block_new(max(fbx_arena_size_estimate(buf_size), FBX_ARENA_BLOCK_SIZE_MIN));
+	if(!arena.blocks) {
+		ASSERT_FAIL("FBX: Failed to allocate arena");
+		return NULL;
+	}
+
+	struct fbx *fbx = (struct fbx*)fbx_arena_alloc(&arena, sizeof(struct fbx));
+	*fbx = (struct fbx) {
+		.arena = arena,
+	};
+	fbx->inflates_tail = &fbx->inflates;
 
 	struct blob_cur cursor = blob_cur_make(buf, buf_size);
 	struct blob_cur *cur = &cursor;
@@ -692,12 +774,16 @@ struct fbx* fbx_new(const char *buf, size_t buf_size)
 		//goto fail;
 	}
 
-	fbx->children = fbx_node_read_children(fbx->version, cur);
-	if(!fbx->children) {
+	if(blob_cur_is_empty(cur)
+		|| !fbx_node_read_children(fbx->version, fbx, cur, &fbx->children, &fbx->children_count)) {
 		ASSERT_FAIL("FBX: Failed to read root children");
 		goto fail;
 	}
 
+	if(!desc->lazy && !fbx_inflate_all(fbx, desc->jobs)) {
+		goto fail;
+	}
+
 	//
 	// TODO(TS): These bytes contain a hash based on the creation timestamp (for validation?), should implement this
 	//
@@ -712,11 +798,15 @@ fail:
 
 void fbx_free(struct fbx *fbx)
 {
-	foreach_alist(struct fbx_node*, it, index, fbx->children) {
-		fbx_node_free(it);
+	if(!fbx) {
+		return;
 	}
-	alist_free(fbx->children, 0);
-	free(fbx);
+
+	//
+	// `fbx` itself lives in the arena.
+	//
+	struct fbx_arena arena = fbx->arena;
+	fbx_arena_free(&arena);
 }
 
 void fbx_print(const struct fbx *fbx, int print_arrays)
@@ -725,24 +815,23 @@ void fbx_print(const struct fbx *fbx, int print_arrays)
 	fbx_print_node_list(fbx->children, print_arrays, 0);
 }
 
-static struct fbx_node* fbx_get_node_in(struct alist *list, const char *path, size_t path_len)
+static struct fbx_node* fbx_get_node_in(struct fbx_node *first, const char *path, size_t path_len)
 {
-	foreach_alist_p(struct fbx_node*, it, list) {
-		if(str_equals((*it)->name, (*it)->name_len, path, path_len)) {
-			return *it;
+	for(struct fbx_node *it = first; it; it = it->next) {
+		if(str_equals(it->name, it->name_len, path, path_len)) {
+			return it;
 		}
 	}
 	return NULL;
 }
 
-struct fbx_node* fbx_get_node(struct fbx *fbx, const char *path[], size_t path_count)
+struct fbx_node* fbx_find_node(struct fbx *fbx, const char *path[], size_t path_count)
 {
 	struct fbx_node *curr_node = NULL;
 
 	for(size_t i = 0; i < path_count; i++) {
 		curr_node = fbx_get_node_in(curr_node ? curr_node->children : fbx->children, path[i], strlen(path[i]));
 		if(!curr_node) {
-			ASSERT_FAIL("FBX: Could not find path element");
 			return NULL;
 		}
 	}
@@ -750,6 +839,15 @@ struct fbx_node* fbx_get_node(struct fbx *fbx, const char *path[], size_t path_c
 	return curr_node;
 }
 
+struct fbx_node* fbx_get_node(struct fbx *fbx, const char *path[], size_t path_count)
+{
+	struct fbx_node *node = fbx_find_node(fbx, path, path_count);
+	if(!node) {
+		ASSERT_FAIL("FBX: Could not find path element");
+	}
+	return node;
+}
+
 uint64_t fbx_node_get_property_count(const struct fbx_node *node)
 {
 	ASSERT(node);
@@ -763,7 +861,7 @@ const struct fbx_property* fbx_node_get_property(const struct fbx_node *node, ui
 		ASSERT_FAIL("FBX: Property index out of bounds");
 		return NULL;
 	}
-	return (struct fbx_property*)(node->properties->data)[index];
+	return &node->properties[index];
 }
 
 const struct fbx_property* fbx_node_get_property_array(const struct fbx_node *node, uint64_t index)
@@ -777,14 +875,15 @@ const struct fbx_property* fbx_node_get_property_array(const struct fbx_node *no
 
 uint32_t fbx_property_get_array_count(const struct fbx_property *prop)
 {
-	const struct fbx_property_array *prop_array = fbx_property_get_array(prop);
-	ASSERT(prop_array);
-	return prop_array ? prop_array->array_length : 0;
+	ASSERT(prop);
+	const int is_array = fbx_property_is_array_type(prop->type);
+	ASSERT(is_array);
+	return is_array ? prop->length : 0;
 }
 
 int fbx_property_is_array(const struct fbx_property *prop)
 {
-	return fbx_property_get_array(prop) != NULL;
+	return fbx_property_is_array_type(prop->type);
 }
 
 enum fbx_property_type fbx_property_get_type(const struct fbx_property *prop)
@@ -826,13 +925,21 @@ const int64_t* fbx_property_get_int64(const struct fbx_property *prop)
 	return FBX_PROPERTY_GET(prop, FBX_PROPERTY_TYPE_INT64, int64_t);
 }
 
+static const char* fbx_property_get_array_data(const struct fbx_property *prop)
+{
+	if(prop->inflate_pending && !fbx_inflate_run(prop->inflate)) {
+		ASSERT_FAIL("FBX: Property array decode failed");
+		return NULL;
+	}
+	return prop->data;
+}
+
 #define FBX_PROPERTY_ARRAY_RETURN(prop, fbx_type, c_type) \
 	if(prop->type != fbx_type) { \
 		ASSERT_FAIL("FBX: Incorrect type"); \
 		return NULL; \
 	} \
-	const struct fbx_property_array* prop_array = fbx_property_get_array(prop); \
-	return (const c_type*)prop_array->data;
+	return (const c_type*)fbx_property_get_array_data(prop);
 
 const double* fbx_property_get_array_double(const struct fbx_property *prop)
 {
@@ -871,11 +978,9 @@ struct fbx_string fbx_property_get_string(const struct fbx_property *prop)
 		static const struct fbx_string empty = { 0 };
 		return empty;
 	}
-	ASSERT(prop->heap_data);
-	struct fbx_property_special *prop_data = (struct fbx_property_special*)prop->heap_data;
 	return (struct fbx_string) {
-		.length = prop_data->length,
-		.data = prop_data->data
+		.length = prop->length,
+		.data = prop->data
 	};
 }
 
@@ -886,11 +991,9 @@ struct fbx_string fbx_property_get_binary(const struct fbx_property *prop)
 		static const struct fbx_string empty = { 0 };
 		return empty; \
 	}
-	ASSERT(prop->heap_data);
-	struct fbx_property_special *prop_data = (struct fbx_property_special*)prop->heap_data;
 	return (struct fbx_string) {
-		.length = prop_data->length,
-		.data = prop_data->data
+		.length = prop->length,
+		.data = prop->data
 	};
 }
 
@@ -910,8 +1013,7 @@ const struct fbx_node* fbx_get_typed_property(struct fbx *fbx, const char *path[
 
 	strview_t property_name_view = strview_make(property_name, strlen(property_name));
 
-	for(size_t i = 0, count = alist_count(properties_node->children); i < count; i++) {
-		const struct fbx_node *child = alist_get(properties_node->children, i);
+	for(const struct fbx_node *child = properties_node->children; child; child = child->next) {
 
 		ASSERT(child->name_len == 1 && child->name[0] == 'P' && child->properties_count >= 5);
 
@@ -20,7 +20,9 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 
+struct lodge_jobs;
 struct fbx;
 struct fbx_node;
 struct fbx_property;
@@ -82,10 +84,25 @@ enum fbx_polygon_type
 	FBX_POLYGON_TYPE_MAX,
 };
 
+struct fbx_desc
+{
+	struct lodge_jobs			*jobs;		// Inflates compressed arrays in parallel if set, inline otherwise.
+	bool						lazy;		// Inflate compressed arrays on their first `fbx_property_get_array_*()` instead.
+};
+
+//
+// Strings, binaries and uncompressed arrays point into `buf`, so it has to outlive the
+// returned document.
+//
+// Compressed arrays are inflated after the node tree has been parsed. Lazy documents
+// inflate on first access instead, which is not safe to do from several threads at once.
+//
 struct fbx*						fbx_new(const char *buf, size_t buf_size);
+struct fbx*						fbx_new_from_desc(const char *buf, size_t buf_size, const struct fbx_desc *desc);
 void							fbx_free(struct fbx *fbx);
 
 struct fbx_node*				fbx_get_node(struct fbx *fbx, const char *path[], size_t path_count);
+struct fbx_node*				fbx_find_node(struct fbx *fbx, const char *path[], size_t path_count);	// Like `fbx_get_node()`, for optional nodes.
 uint64_t						fbx_node_get_property_count(const struct fbx_node *node);
 const struct fbx_property*		fbx_node_get_property(const struct fbx_node *node, uint64_t index);
 const struct fbx_property*		fbx_node_get_property_array(const struct fbx_node *node, uint64_t index);
@@ -0,0 +1,384 @@
+//
+// Parse and free time of `fbx_new_from_desc` on a synthetic binary FBX shaped like an
+// exported scene: models with property blocks, and meshes whose larger arrays are zlib
+// compressed. Where the linker can wrap `malloc` (see CMakeLists.txt) it also counts the
+// heap allocations of each parse.
+//
+// Usage: bench_fbx_parse [meshes] [iterations]
+//
+
+#include "fbx.h"
+#include "lodge_jobs.h"
+#include "lodge_thread.h"
+#include "lodge_time.h"
+#include "lodge_platform.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb/stb_image_write.h> // for stbi_zlib_compress()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define BENCH_FBX_VERSION			7400	// 32 bit offsets, as written for < v7.5.
+#define BENCH_FBX_COMPRESS_MIN		200		// Arrays of meshes with more vertices than this are compressed.
+
+#ifdef BENCH_FBX_PARSE_COUNT_ALLOCATIONS
+static volatile int32_t bench_allocations = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void *ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+	lodge_atomic_add_i32(&bench_allocations, 1);
+	return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+	lodge_atomic_add_i32(&bench_allocations, 1);
+	return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void *ptr, size_t size)
+{
+	lodge_atomic_add_i32(&bench_allocations, 1);
+	return __real_realloc(ptr, size);
+}
+#endif
+
+struct bench_buf
+{
+	size_t						count;
+	size_t						capacity;
+	char						*elements;
+};
+
+//
+// A node record being written; its header is patched once its size is known.
+//
+struct bench_node
+{
+	size_t						start;
+	size_t						properties_start;
+	uint32_t					properties_count;
+	bool						has_children;
+};
+
+static void bench_buf_append(struct bench_buf *buf, const void *data, size_t size)
+{
+	if(buf->count + size > buf->capacity) {
+		buf->capacity = max(buf->capacity * 2, buf->count + size);
+		buf->elements = realloc(buf->elements, buf->capacity);
+	}
+	memcpy(buf->elements + buf->count, data, size);
+	buf->count += size;
+}
+
+static void bench_buf_append_u32(struct bench_buf *buf, uint32_t value)
+{
+	bench_buf_append(buf, &value, sizeof(value));
+}
+
+static void bench_buf_patch_u32(struct bench_buf *buf, size_t offset, uint32_t value)
+{
+	memcpy(buf->elements + offset, &value, sizeof(value));
+}
+
+static struct bench_node bench_node_begin(struct bench_buf *buf, const char *name)
+{
+	const uint8_t name_len = (uint8_t)strlen(name);
+
+	struct bench_node node = {
+		.start = buf->count,
+	};
+	bench_buf_append_u32(buf, 0);		// End offset
+	bench_buf_append_u32(buf, 0);		// Properties count
+	bench_buf_append_u32(buf, 0);		// Properties length
+	bench_buf_append(buf, &name_len, sizeof(name_len));
+	bench_buf_append(buf, name, name_len);
+	node.properties_start = buf->count;
+	return node;
+}
+
+//
+// Children follow the properties, so the property list is closed by the first child.
+//
+static void bench_node_begin_children(struct bench_buf *buf, struct bench_node *node)
+{
+	bench_buf_patch_u32(buf, node->start + 4, node->properties_count);
+	bench_buf_patch_u32(buf, node->start + 8, (uint32_t)(buf->count - node->properties_start));
+	node->has_children = true;
+}
+
+static void bench_node_end(struct bench_buf *buf, struct bench_node *node)
+{
+	if(node->has_children) {
+		static const char null_record[13] = { 0 };
+		bench_buf_append(buf, null_record, sizeof(null_record));
+	} else {
+		bench_buf_patch_u32(buf, node->start + 4, node->properties_count);
+		bench_buf_patch_u32(buf, node->start + 8, (uint32_t)(buf->count - node->properties_start));
+	}
+	bench_buf_patch_u32(buf, node->start, (uint32_t)buf->count);
+}
+
+static void bench_prop_i32(struct bench_buf *buf, struct bench_node *node, int32_t value)
+{
+	bench_buf_append(buf, "I", 1);
+	bench_buf_append(buf, &value, sizeof(value));
+	node->properties_count++;
+}
+
+static void bench_prop_i64(struct bench_buf *buf, struct bench_node *node, int64_t value)
+{
+	bench_buf_append(buf, "L", 1);
+	bench_buf_append(buf, &value, sizeof(value));
+	node->properties_count++;
+}
+
+static void bench_prop_f64(struct bench_buf *buf, struct bench_node *node, double value)
+{
+	bench_buf_append(buf, "D", 1);
+	bench_buf_append(buf, &value, sizeof(value));
+	node->properties_count++;
+}
+
+static void bench_prop_string(struct bench_buf *buf, struct bench_node *node, const char *value)
+{
+	bench_buf_append(buf, "S", 1);
+	bench_buf_append_u32(buf, (uint32_t)strlen(value));
+	bench_buf_append(buf, value, strlen(value));
+	node->properties_count++;
+}
+
+static void bench_prop_array(struct bench_buf *buf, struct bench_node *node, char type, const void *elements, uint32_t count, size_t element_size, bool compress)
+{
+	const int size = (int)(count * element_size);
+
+	bench_buf_append(buf, &type, 1);
+	bench_buf_append_u32(buf, count);
+	if(compress) {
+		int compressed_size = 0;
+		unsigned char *compressed = stbi_zlib_compress((unsigned char *)elements, size, &compressed_size, 8);
+		bench_buf_append_u32(buf, 1);
+		bench_buf_append_u32(buf, (uint32_t)compressed_size);
+		bench_buf_append(buf, compressed, compressed_size);
+		free(compressed);
+	} else {
+		bench_buf_append_u32(buf, 0);
+		bench_buf_append_u32(buf, (uint32_t)size);
+		bench_buf_append(buf, elements, size);
+	}
+	node->properties_count++;
+}
+
+static void bench_write_model(struct bench_buf *buf, uint32_t index)
+{
+	char name[64];
+
+	struct bench_node model = bench_node_begin(buf, "Model");
+	bench_prop_i64(buf, &model, index);
+	snprintf(name, sizeof(name), "Model%u", index);
+	bench_prop_string(buf, &model, name);
+	bench_prop_string(buf, &model, "Mesh");
+	bench_node_begin_children(buf, &model);
+	{
+		struct bench_node version = bench_node_begin(buf, "Version");
+		bench_prop_i32(buf, &version, 232);
+		bench_node_end(buf, &version);
+
+		struct bench_node properties = bench_node_begin(buf, "Properties70");
+		bench_node_begin_children(buf, &properties);
+		for(int i = 0; i < 12; i++) {
+			struct bench_node p = bench_node_begin(buf, "P");
+			snprintf(name, sizeof(name), "Prop%d", i);
+			bench_prop_string(buf, &p, name);
+			bench_prop_string(buf, &p, "double");
+			bench_prop_string(buf, &p, "Number");
+			bench_prop_string(buf, &p, "");
+			bench_prop_f64(buf, &p, i);
+			bench_node_end(buf, &p);
+		}
+		bench_node_end(buf, &properties);
+	}
+	bench_node_end(buf, &model);
+}
+
+static void bench_write_geometry(struct bench_buf *buf, uint32_t index, uint32_t vertices_count)
+{
+	double *vertices = malloc(vertices_count * 6 * sizeof(double));
+	int32_t *indices = malloc(vertices_count * 2 * sizeof(int32_t));
+	for(uint32_t i = 0; i < vertices_count * 6; i++) {
+		vertices[i] = sin(i * 0.37 + index);
+	}
+	for(uint32_t i = 0; i < vertices_count * 2; i++) {
+		indices[i] = (i % 3 == 2) ? ~(int32_t)((i * 7) % vertices_count) : (int32_t)((i * 7) % vertices_count);
+	}
+
+	const bool compress = vertices_count > BENCH_FBX_COMPRESS_MIN;
+	char name[64];
+
+	struct bench_node geometry = bench_node_begin(buf, "Geometry");
+	bench_prop_i64(buf, &geometry, 100000 + index);
+	snprintf(name, sizeof(name), "Geometry%u", index);
+	bench_prop_string(buf, &geometry, name);
+	bench_prop_string(buf, &geometry, "Mesh");
+	bench_node_begin_children(buf, &geometry);
+	{
+		struct bench_node vertices_node = bench_node_begin(buf, "Vertices");
+		bench_prop_array(buf, &vertices_node, 'd', vertices, vertices_count * 3, sizeof(double), compress);
+		bench_node_end(buf, &vertices_node);
+
+		struct bench_node indices_node = bench_node_begin(buf, "PolygonVertexIndex");
+		bench_prop_array(buf, &indices_node, 'i', indices, vertices_count * 2, sizeof(int32_t), compress);
+		bench_node_end(buf, &indices_node);
+
+		struct bench_node normals_layer = bench_node_begin(buf, "LayerElementNormal");
+		bench_prop_i32(buf, &normals_layer, 0);
+		bench_node_begin_children(buf, &normals_layer);
+		{
+			struct bench_node mapping = bench_node_begin(buf, "MappingInformationType");
+			bench_prop_string(buf, &mapping, "ByPolygonVertex");
+			bench_node_end(buf, &mapping);
+
+			struct bench_node normals = bench_node_begin(buf, "Normals");
+			bench_prop_array(buf, &normals, 'd', vertices, vertices_count * 6, sizeof(double), compress);
+			bench_node_end(buf, &normals);
+		}
+		bench_node_end(buf, &normals_layer);
+	}
+	bench_node_end(buf, &geometry);
+
+	free(vertices);
+	free(indices);
+}
+
+static struct bench_buf bench_write_fbx(uint32_t meshes_count)
+{
+	struct bench_buf buf = { 0 };
+
+	static const char magic[21] = "Kaydara FBX Binary  ";
+	static const char pad[2] = { 0x1a, 0x00 };
+	bench_buf_append(&buf, magic, sizeof(magic));
+	bench_buf_append(&buf, pad, sizeof(pad));
+	bench_buf_append_u32(&buf, BENCH_FBX_VERSION);
+
+	struct bench_node header = bench_node_begin(&buf, "FBXHeaderExtension");
+	bench_node_begin_children(&buf, &header);
+	{
+		struct bench_node version = bench_node_begin(&buf, "FBXVersion");
+		bench_prop_i32(&buf, &version, BENCH_FBX_VERSION);
+		bench_node_end(&buf, &version);
+	}
+	bench_node_end(&buf, &header);
+
+	struct bench_node objects = bench_node_begin(&buf, "Objects");
+	bench_node_begin_children(&buf, &objects);
+	uint32_t seed = 1;
+	for(uint32_t i = 0; i < meshes_count; i++) {
+		seed = seed * 1664525u + 1013904223u;
+		bench_write_model(&buf, i);
+		// The first mesh is checked after parsing, and is large enough to be compressed.
+		bench_write_geometry(&buf, i, (i == 0) ? 1000 : 20 + (seed >> 8) % 1000);
+	}
+	bench_node_end(&buf, &objects);
+
+	static const char null_record[13] = { 0 };
+	static const char footer[16] = { 0 };
+	bench_buf_append(&buf, null_record, sizeof(null_record));
+	bench_buf_append(&buf, footer, sizeof(footer));
+
+	return buf;
+}
+
+//
+// The first mesh's vertices, as `bench_write_geometry()` wrote them.
+//
+static bool bench_check(struct fbx *fbx)
+{
+	const struct fbx_node *vertices_node = fbx_find_node(fbx, (const char*[]) { "Objects", "Geometry", "Vertices" }, 3);
+	const struct fbx_property *vertices = vertices_node ? fbx_node_get_property_array(vertices_node, 0) : NULL;
+	const double *elements = vertices ? fbx_property_get_array_double(vertices) : NULL;
+	if(!elements) {
+		return false;
+	}
+	for(uint32_t i = 0, count = fbx_property_get_array_count(vertices); i < count; i++) {
+		if(elements[i] != sin(i * 0.37)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool bench_run(const struct bench_buf *buf, const struct fbx_desc *desc, uint32_t iterations, const char *label)
+{
+	double parse_ms = 0.0;
+	double parse_worst_ms = 0.0;
+	double free_ms = 0.0;
+	int32_t allocations = -1;
+
+	for(uint32_t i = 0; i < iterations; i++) {
+#ifdef BENCH_FBX_PARSE_COUNT_ALLOCATIONS
+		lodge_atomic_store_i32(&bench_allocations, 0);
+#endif
+		lodge_timestamp_t before = lodge_timestamp_get();
+		struct fbx *fbx = fbx_new_from_desc(buf->elements, buf->count, desc);
+		const double elapsed_ms = lodge_timestamp_elapsed_ms(before);
+#ifdef BENCH_FBX_PARSE_COUNT_ALLOCATIONS
+		allocations = lodge_atomic_load_i32(&bench_allocations);
+#endif
+		if(!fbx || (i == 0 && !bench_check(fbx))) {
+			printf("%-10s failed to parse\n", label);
+			fbx_free(fbx);
+			return false;
+		}
+
+		before = lodge_timestamp_get();
+		fbx_free(fbx);
+		free_ms += lodge_timestamp_elapsed_ms(before) / iterations;
+
+		parse_ms += elapsed_ms / iterations;
+		parse_worst_ms = max(parse_worst_ms, elapsed_ms);
+	}
+
+	char allocations_str[32] = "n/a";
+	if(allocations >= 0) {
+		snprintf(allocations_str, sizeof(allocations_str), "%d", allocations);
+	}
+
+	printf("%-10s parse avg: %8.3f ms  worst: %8.3f ms  free avg: %7.3f ms  allocations: %s\n",
+		label,
+		parse_ms,
+		parse_worst_ms,
+		free_ms,
+		allocations_str
+	);
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	const uint32_t meshes_count = (argc > 1) ? (uint32_t)atoi(argv[1]) : 500;
+	const uint32_t iterations = (argc > 2) ? (uint32_t)atoi(argv[2]) : 20;
+
+	struct bench_buf buf = bench_write_fbx(meshes_count);
+	printf("%u meshes, %.1f MB, %u iterations\n", meshes_count, buf.count / (1024.0 * 1024.0), iterations);
+
+	lodge_jobs_t jobs = lodge_jobs_new(max(lodge_thread_get_hardware_concurrency(), 2) - 1);
+
+	bool ok = true;
+	ok &= bench_run(&buf, &(struct fbx_desc) { 0 }, iterations, "inline");
+	ok &= bench_run(&buf, &(struct fbx_desc) { .jobs = jobs }, iterations, "jobs");
+	ok &= bench_run(&buf, &(struct fbx_desc) { .lazy = true }, iterations, "lazy");
+
+	lodge_jobs_free(jobs);
+	free(buf.elements);
+
+	return ok ? 0 : 1;
+}
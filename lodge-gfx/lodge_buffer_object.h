@@ -11,8 +11,20 @@ lodge_buffer_object_t	lodge_buffer_object_make_static(const void *data, size_t d
 
 void					lodge_buffer_object_remake_dynamic(lodge_buffer_object_t buffer_object, size_t max_size);
 
+//
+// Immutable storage that stays mapped (write only, coherent) until reset; `mapped` is the write
+// pointer. Synchronizing with the GPU is up to the caller, see `lodge_buffer_ring`.
+//
+lodge_buffer_object_t	lodge_buffer_object_make_persistent(size_t size, void **mapped);
+
 void					lodge_buffer_object_reset(lodge_buffer_object_t buffer_object);
 
 void					lodge_buffer_object_set(lodge_buffer_object_t buffer_object, size_t offset, const void *data, size_t data_size);
 
+//
+// Offsets when binding a range as a constant (uniform) or storage buffer must be multiples of these.
+//
+size_t					lodge_buffer_object_constant_offset_alignment();
+size_t					lodge_buffer_object_storage_offset_alignment();
+
 #endif
\ No newline at end of file
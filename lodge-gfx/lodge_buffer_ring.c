@@ -0,0 +1,102 @@
+#include "lodge_buffer_ring.h"
+
+#include "lodge_gfx.h"
+#include "lodge_buffer_object.h"
+#include "lodge_assert.h"
+
+#include <string.h>
+
+static size_t lodge_buffer_ring_align(size_t value, size_t alignment)
+{
+	return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+static void lodge_buffer_ring_remake(struct lodge_buffer_ring *ring, size_t frame_size)
+{
+	for(uint32_t i = 0; i < LODGE_BUFFER_RING_FRAMES; i++) {
+		lodge_gfx_fence_reset(ring->fences[i]);
+		ring->fences[i] = NULL;
+	}
+
+	//
+	// The GPU keeps the old storage alive for as long as it is still in use.
+	//
+	lodge_buffer_object_reset(ring->buffer_object);
+
+	//
+	// Regions start at multiples of 256, which covers all binding alignments.
+	//
+	ring->frame_size = lodge_buffer_ring_align(frame_size, 256);
+	ring->frame_used = 0;
+	ring->frame_index = 0;
+
+	void *mapped = NULL;
+	ring->buffer_object = lodge_buffer_object_make_persistent(ring->frame_size * LODGE_BUFFER_RING_FRAMES, &mapped);
+	ring->mapped = mapped;
+
+	if(!ring->buffer_object) {
+		ring->frame_size = 0;
+	}
+}
+
+void lodge_buffer_ring_new_inplace(struct lodge_buffer_ring *ring, size_t frame_size)
+{
+	memset(ring, 0, sizeof(struct lodge_buffer_ring));
+	lodge_buffer_ring_remake(ring, frame_size > 0 ? frame_size : 256);
+}
+
+void lodge_buffer_ring_free_inplace(struct lodge_buffer_ring *ring)
+{
+	for(uint32_t i = 0; i < LODGE_BUFFER_RING_FRAMES; i++) {
+		lodge_gfx_fence_reset(ring->fences[i]);
+	}
+	lodge_buffer_object_reset(ring->buffer_object);
+	memset(ring, 0, sizeof(struct lodge_buffer_ring));
+}
+
+void lodge_buffer_ring_begin_frame(struct lodge_buffer_ring *ring, size_t frame_size)
+{
+	const size_t required = frame_size > ring->frame_required ? frame_size : ring->frame_required;
+	ring->frame_required = 0;
+
+	if(required > ring->frame_size) {
+		//
+		// Grow by half again, so a slowly growing scene does not remake the buffer every frame.
+		//
+		lodge_buffer_ring_remake(ring, required + required / 2);
+		return;
+	}
+
+	//
+	// Everything that reads the current region has been submitted by now.
+	//
+	if(ring->frame_used > 0) {
+		ring->fences[ring->frame_index] = lodge_gfx_fence_make();
+	}
+
+	ring->frame_index = (ring->frame_index + 1) % LODGE_BUFFER_RING_FRAMES;
+	ring->frame_used = 0;
+
+	lodge_gfx_fence_wait(ring->fences[ring->frame_index]);
+	lodge_gfx_fence_reset(ring->fences[ring->frame_index]);
+	ring->fences[ring->frame_index] = NULL;
+}
+
+void* lodge_buffer_ring_alloc(struct lodge_buffer_ring *ring, size_t size, size_t alignment, size_t *offset)
+{
+	const size_t begin = lodge_buffer_ring_align(ring->frame_used, alignment);
+	const size_t end = begin + size;
+
+	//
+	// Counts what did not fit as well, so the next frame grows to fit all of it at once.
+	//
+	ring->frame_required = lodge_buffer_ring_align(ring->frame_required, alignment) + size;
+
+	if(end > ring->frame_size || !ring->mapped) {
+		return NULL;
+	}
+
+	ring->frame_used = end;
+	*offset = ring->frame_index * ring->frame_size + begin;
+	return ring->mapped + *offset;
+}
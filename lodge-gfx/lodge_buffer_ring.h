@@ -0,0 +1,48 @@
+#ifndef _LODGE_BUFFER_RING_H
+#define _LODGE_BUFFER_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LODGE_BUFFER_RING_FRAMES 3
+
+struct lodge_buffer_object;
+typedef struct lodge_buffer_object* lodge_buffer_object_t;
+
+struct lodge_gfx_fence;
+typedef struct lodge_gfx_fence* lodge_gfx_fence_t;
+
+//
+// For data that is rewritten every frame. The buffer is persistently mapped and split in
+// `LODGE_BUFFER_RING_FRAMES` regions; a frame writes straight into its own region, and only
+// waits if the GPU is still reading it from `LODGE_BUFFER_RING_FRAMES` frames ago.
+//
+// Regions only grow in `lodge_buffer_ring_begin_frame()`, so offsets handed out stay valid
+// for the whole frame.
+//
+struct lodge_buffer_ring
+{
+	lodge_buffer_object_t				buffer_object;
+	char								*mapped;
+	size_t								frame_size;
+	size_t								frame_used;
+	size_t								frame_required;		// Including allocations that did not fit.
+	uint32_t							frame_index;
+	lodge_gfx_fence_t					fences[LODGE_BUFFER_RING_FRAMES];
+};
+
+void									lodge_buffer_ring_new_inplace(struct lodge_buffer_ring *ring, size_t frame_size);
+void									lodge_buffer_ring_free_inplace(struct lodge_buffer_ring *ring);
+
+//
+// Retires the previous frame and grows to fit `frame_size`, or whatever the previous frame
+// asked for, if more.
+//
+void									lodge_buffer_ring_begin_frame(struct lodge_buffer_ring *ring, size_t frame_size);
+
+//
+// Returns a write pointer and its `offset` in `buffer_object`, or NULL if the frame is full.
+//
+void*									lodge_buffer_ring_alloc(struct lodge_buffer_ring *ring, size_t size, size_t alignment, size_t *offset);
+
+#endif
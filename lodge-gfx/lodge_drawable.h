@@ -21,14 +21,27 @@ typedef struct lodge_buffer_object* lodge_buffer_object_t;
 
 struct lodge_static_mesh;
 
+enum lodge_drawable_attrib_type
+{
+	LODGE_DRAWABLE_ATTRIB_TYPE_FLOAT = 0,
+	LODGE_DRAWABLE_ATTRIB_TYPE_HALF_FLOAT,
+};
+
+enum lodge_drawable_index_type
+{
+	LODGE_DRAWABLE_INDEX_TYPE_U32 = 0,
+	LODGE_DRAWABLE_INDEX_TYPE_U16,
+};
+
 struct lodge_drawable_attrib
 {
 	strview_t						name;
 	lodge_buffer_object_t			buffer_object;
-	uint32_t						float_count;
+	uint32_t						float_count;	// Component count, whatever the `type`.
 	uint32_t						offset;
 	uint32_t						stride;
 	uint32_t						instanced;
+	enum lodge_drawable_attrib_type	type;
 };
 
 struct lodge_drawable_desc
@@ -60,4 +73,10 @@ void								lodge_drawable_render_triangles_instanced(const lodge_drawable_t dra
 void								lodge_drawable_render_indexed_instanced(const lodge_drawable_t drawable, size_t index_count, size_t instances);
 void								lodge_drawable_render_indexed(const lodge_drawable_t drawable, size_t index_count, size_t offset);
 
+//
+// The above assume 32-bit indices. `offset` is in bytes into the index buffer.
+//
+void								lodge_drawable_render_indexed_instanced_typed(const lodge_drawable_t drawable, enum lodge_drawable_index_type index_type, size_t index_count, size_t offset, size_t instances);
+void								lodge_drawable_render_indexed_typed(const lodge_drawable_t drawable, enum lodge_drawable_index_type index_type, size_t index_count, size_t offset);
+
 #endif
\ No newline at end of file
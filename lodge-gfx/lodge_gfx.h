@@ -21,6 +21,12 @@ typedef struct lodge_sampler* lodge_sampler_t;
 struct lodge_buffer_object;
 typedef struct lodge_buffer_object* lodge_buffer_object_t;
 
+//
+// Marks a point in the command stream, to find out when the GPU has passed it.
+//
+struct lodge_gfx_fence;
+typedef struct lodge_gfx_fence* lodge_gfx_fence_t;
+
 enum lodge_gfx_primitive
 {
 	LODGE_GFX_PRIMITIVE_POINTS,
@@ -104,4 +110,8 @@ void									lodge_gfx_set_scissor(int32_t x, int32_t y, size_t width, size_t he
 void									lodge_gfx_annotate_begin(strview_t message);
 void									lodge_gfx_annotate_end();
 
+lodge_gfx_fence_t						lodge_gfx_fence_make();
+void									lodge_gfx_fence_wait(lodge_gfx_fence_t fence);
+void									lodge_gfx_fence_reset(lodge_gfx_fence_t fence);
+
 #endif
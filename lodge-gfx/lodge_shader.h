@@ -23,6 +23,10 @@ bool	lodge_shader_set_fragment_source(lodge_shader_t shader, strview_t fragment_
 bool	lodge_shader_set_compute_source(lodge_shader_t shader, strview_t compute_source);
 bool	lodge_shader_link(lodge_shader_t shader);
 
+//
+// Location of the vertex attribute `constant_name`, or -1 if the shader does not use it.
+// Looked up in a table filled in by `lodge_shader_link()`, so this is cheap per frame.
+//
 int		lodge_shader_get_constant_index(lodge_shader_t shader, strview_t constant_name);
 
 void	lodge_shader_set_constant_float(lodge_shader_t shader, strview_t name, float f);
@@ -35,6 +39,7 @@ void	lodge_shader_set_constant_mvp(lodge_shader_t shader, const struct mvp *mvp)
 
 void	lodge_shader_bind_constant_buffer(lodge_shader_t shader, uint32_t binding, lodge_buffer_object_t buffer_object);
 void	lodge_shader_bind_constant_buffer_range(lodge_shader_t shader, uint32_t binding, lodge_buffer_object_t buffer_object, size_t offset, size_t size);
+void	lodge_shader_bind_storage_buffer_range(lodge_shader_t shader, uint32_t binding, lodge_buffer_object_t buffer_object, size_t offset, size_t size);
 
 void	lodge_shader_dispatch_compute(uint32_t groups_x, uint32_t groups_y, uint32_t groups_z);
 
@@ -59,6 +59,35 @@ fail:
 	ASSERT_FAIL("Failed to make dynamic buffer object");
 }
 
+lodge_buffer_object_t lodge_buffer_object_make_persistent(size_t size, void **mapped)
+{
+	GLuint buffer_object = 0;
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glCreateBuffers(1, &buffer_object);
+	GL_OK_OR_GOTO(fail);
+
+	glNamedBufferStorage(buffer_object, size, NULL, flags);
+	GL_OK_OR_GOTO(fail);
+
+	*mapped = glMapNamedBufferRange(buffer_object, 0, size, flags);
+	GL_OK_OR_GOTO(fail);
+
+	if(!*mapped) {
+		goto fail;
+	}
+
+	return lodge_buffer_object_from_gl(buffer_object);
+
+fail:
+	ASSERT_FAIL("Failed to make persistent buffer object");
+	if(buffer_object) {
+		glDeleteBuffers(1, &buffer_object);
+	}
+	*mapped = NULL;
+	return 0;
+}
+
 void lodge_buffer_object_reset(lodge_buffer_object_t buffer_object)
 {
 	if(buffer_object) {
@@ -88,3 +117,29 @@ void lodge_buffer_object_set(lodge_buffer_object_t buffer_object, size_t offset,
 fail:
 	ASSERT_FAIL("Failed to set buffer object data");
 }
+
+static size_t lodge_buffer_object_get_alignment(GLenum pname)
+{
+	GLint alignment = 0;
+	glGetIntegerv(pname, &alignment);
+	GL_OK_OR_ASSERT("Failed to get buffer offset alignment");
+	return alignment > 0 ? (size_t)alignment : 256;
+}
+
+size_t lodge_buffer_object_constant_offset_alignment()
+{
+	static size_t alignment = 0;
+	if(!alignment) {
+		alignment = lodge_buffer_object_get_alignment(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT);
+	}
+	return alignment;
+}
+
+size_t lodge_buffer_object_storage_offset_alignment()
+{
+	static size_t alignment = 0;
+	if(!alignment) {
+		alignment = lodge_buffer_object_get_alignment(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT);
+	}
+	return alignment;
+}
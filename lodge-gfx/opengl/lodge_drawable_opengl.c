@@ -34,6 +34,32 @@ struct lodge_drawable_desc lodge_drawable_desc_make_from_static_mesh(const struc
 	};
 }
 
+static GLenum lodge_drawable_attrib_type_to_gl(enum lodge_drawable_attrib_type type)
+{
+	switch(type) {
+	case LODGE_DRAWABLE_ATTRIB_TYPE_FLOAT:
+		return GL_FLOAT;
+	case LODGE_DRAWABLE_ATTRIB_TYPE_HALF_FLOAT:
+		return GL_HALF_FLOAT;
+	default:
+		ASSERT_NOT_IMPLEMENTED();
+		return GL_FLOAT;
+	}
+}
+
+static GLenum lodge_drawable_index_type_to_gl(enum lodge_drawable_index_type type)
+{
+	switch(type) {
+	case LODGE_DRAWABLE_INDEX_TYPE_U32:
+		return GL_UNSIGNED_INT;
+	case LODGE_DRAWABLE_INDEX_TYPE_U16:
+		return GL_UNSIGNED_SHORT;
+	default:
+		ASSERT_NOT_IMPLEMENTED();
+		return GL_UNSIGNED_INT;
+	}
+}
+
 lodge_drawable_t lodge_drawable_make(struct lodge_drawable_desc desc)
 {
 	GLuint drawable = 0;
@@ -91,7 +117,7 @@ void lodge_drawable_set_buffer_object(lodge_drawable_t drawable, uint32_t index,
 	GLuint vertex_array = lodge_drawable_to_gl(drawable);
 	glEnableVertexArrayAttrib(vertex_array, index);
 	glVertexArrayVertexBuffer(vertex_array, index, lodge_buffer_object_to_gl(attrib.buffer_object), attrib.offset, (GLsizei)attrib.stride);
-	glVertexArrayAttribFormat(vertex_array, index, attrib.float_count, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribFormat(vertex_array, index, attrib.float_count, lodge_drawable_attrib_type_to_gl(attrib.type), GL_FALSE, 0);
 	glVertexArrayAttribBinding(vertex_array, index, index);
 	glVertexArrayBindingDivisor(vertex_array, index, attrib.instanced);
 	GL_OK_OR_GOTO(fail);
@@ -139,23 +165,33 @@ void lodge_drawable_render_triangles_instanced(const lodge_drawable_t drawable,
 }
 
 void lodge_drawable_render_indexed_instanced(const lodge_drawable_t drawable, size_t index_count, size_t instances)
+{
+	lodge_drawable_render_indexed_instanced_typed(drawable, LODGE_DRAWABLE_INDEX_TYPE_U32, index_count, 0, instances);
+}
+
+void lodge_drawable_render_indexed(const lodge_drawable_t drawable, size_t index_count, size_t offset)
+{
+	lodge_drawable_render_indexed_typed(drawable, LODGE_DRAWABLE_INDEX_TYPE_U32, index_count, offset);
+}
+
+void lodge_drawable_render_indexed_instanced_typed(const lodge_drawable_t drawable, enum lodge_drawable_index_type index_type, size_t index_count, size_t offset, size_t instances)
 {
 	glBindVertexArray(lodge_drawable_to_gl(drawable));
 	GL_OK_OR_ASSERT("Failed to bind drawable");
 
-	glDrawElementsInstanced(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, NULL, instances);
+	glDrawElementsInstanced(GL_TRIANGLES, index_count, lodge_drawable_index_type_to_gl(index_type), (const void*)offset, instances);
 	GL_OK_OR_ASSERT("Failed to render drawable");
 	
 	glBindVertexArray(0);
 	GL_OK_OR_ASSERT("Failed to unbind drawable");
 }
 
-void lodge_drawable_render_indexed(const lodge_drawable_t drawable, size_t index_count, size_t offset)
+void lodge_drawable_render_indexed_typed(const lodge_drawable_t drawable, enum lodge_drawable_index_type index_type, size_t index_count, size_t offset)
 {
 	glBindVertexArray(lodge_drawable_to_gl(drawable));
 	GL_OK_OR_ASSERT("Failed to bind drawable");
 
-	glDrawElements(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, (const void*)offset);
+	glDrawElements(GL_TRIANGLES, index_count, lodge_drawable_index_type_to_gl(index_type), (const void*)offset);
 	GL_OK_OR_ASSERT("Failed to render drawable");
 	
 	glBindVertexArray(0);
@@ -281,3 +281,36 @@ void lodge_gfx_annotate_end()
 	glPopDebugGroup();
 }
 
+lodge_gfx_fence_t lodge_gfx_fence_make()
+{
+	GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	GL_OK_OR_ASSERT("Failed to make fence");
+	return (lodge_gfx_fence_t)fence;
+}
+
+void lodge_gfx_fence_wait(lodge_gfx_fence_t fence)
+{
+	if(!fence) { return; }
+
+	GLbitfield flags = 0;
+	for(;;) {
+		const GLenum status = glClientWaitSync((GLsync)fence, flags, 1000000000ull);
+		if(status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+			return;
+		}
+		ASSERT_OR(status != GL_WAIT_FAILED) {
+			return;
+		}
+
+		// Make sure the fence itself gets submitted before waiting again.
+		flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	}
+}
+
+void lodge_gfx_fence_reset(lodge_gfx_fence_t fence)
+{
+	if(fence) {
+		glDeleteSync((GLsync)fence);
+		GL_OK_OR_ASSERT("Failed to reset fence");
+	}
+}
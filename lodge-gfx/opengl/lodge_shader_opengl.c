@@ -13,6 +13,8 @@
 #include "lodge_opengl.h"
 
 #define SHADER_INCLUDES_MAX			255
+#define SHADER_ATTRIBS_MAX			16
+#define SHADER_ATTRIB_NAME_MAX		64
 
 #define shader_debug(...) debugf("Shader", __VA_ARGS__)
 #define shader_error(...) errorf("Shader", __VA_ARGS__)
@@ -25,6 +27,12 @@ struct lodge_shader_stage
 	char								*compile_info;
 };
 
+struct lodge_shader_attrib
+{
+	char								name[SHADER_ATTRIB_NAME_MAX];
+	GLint								location;
+};
+
 struct lodge_shader
 {
 	GLuint								program;
@@ -35,6 +43,15 @@ struct lodge_shader
 	struct lodge_shader_stage			compute_stage;
 
 	char								*link_info;
+
+	//
+	// Active vertex attributes, queried once per link so `lodge_shader_get_constant_index()`
+	// does not go through the driver. `attribs_complete` is false if some did not fit; the
+	// misses then fall back to `glGetAttribLocation()`.
+	//
+	uint32_t							attribs_count;
+	bool								attribs_complete;
+	struct lodge_shader_attrib			attribs[SHADER_ATTRIBS_MAX];
 };
 
 static bool lodge_shader_check_link_status(struct lodge_shader *shader)
@@ -171,6 +188,42 @@ bool lodge_shader_set_compute_source(lodge_shader_t shader, strview_t compute_so
 	return lodge_shader_stage_compile(&shader->compute_stage, GL_COMPUTE_SHADER);
 }
 
+static void lodge_shader_cache_attribs(struct lodge_shader *shader)
+{
+	GLint active_count = 0;
+	glGetProgramiv(shader->program, GL_ACTIVE_ATTRIBUTES, &active_count);
+
+	shader->attribs_count = 0;
+	shader->attribs_complete = true;
+
+	for(GLint i = 0; i < active_count; i++) {
+		if(shader->attribs_count >= SHADER_ATTRIBS_MAX) {
+			shader->attribs_complete = false;
+			break;
+		}
+
+		struct lodge_shader_attrib *attrib = &shader->attribs[shader->attribs_count];
+
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveAttrib(shader->program, (GLuint)i, sizeof(attrib->name), &length, &size, &type, attrib->name);
+
+		//
+		// Possibly truncated.
+		//
+		if(length >= (GLsizei)sizeof(attrib->name) - 1) {
+			shader->attribs_complete = false;
+			continue;
+		}
+
+		attrib->location = glGetAttribLocation(shader->program, attrib->name);
+		shader->attribs_count++;
+	}
+
+	GL_OK_OR_ASSERT("lodge_shader_cache_attribs");
+}
+
 bool lodge_shader_link(lodge_shader_t shader)
 {
 	const bool has_fragment_shader = glIsShader(shader->fragment_stage.shader) == GL_TRUE;
@@ -220,6 +273,8 @@ bool lodge_shader_link(lodge_shader_t shader)
 		return false;
 	}
 
+	lodge_shader_cache_attribs(shader);
+
 	return true;
 }
 
@@ -367,12 +422,29 @@ void lodge_shader_bind_constant_buffer_range(lodge_shader_t shader, uint32_t bin
 	GL_OK_OR_ASSERT("lodge_shader_bind_constant_buffer_range");
 }
 
+void lodge_shader_bind_storage_buffer_range(lodge_shader_t shader, uint32_t binding, lodge_buffer_object_t buffer_object, size_t offset, size_t size)
+{
+	lodge_gfx_bind_shader(shader);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, lodge_buffer_object_to_gl(buffer_object), offset, size);
+	GL_OK_OR_ASSERT("lodge_shader_bind_storage_buffer_range");
+}
+
 int lodge_shader_get_constant_index(lodge_shader_t shader, strview_t constant_name)
 {
 	ASSERT(shader);
 	if(!shader) {
 		return 0;
 	}
+
+	for(uint32_t i = 0; i < shader->attribs_count; i++) {
+		if(strview_equals(strview_wrap(shader->attribs[i].name), constant_name)) {
+			return shader->attribs[i].location;
+		}
+	}
+
+	if(shader->attribs_complete) {
+		return -1;
+	}
 	return glGetAttribLocation(shader->program, constant_name.s);
 }
 
@@ -0,0 +1,40 @@
+#ifndef _LODGE_IMAGE_MINMAX_H
+#define _LODGE_IMAGE_MINMAX_H
+
+#include "lodge_image.h"
+
+#include <stdbool.h>
+
+struct lodge_jobs;
+
+#define LODGE_IMAGE_MINMAX_LEVELS_MAX 16
+
+//
+// Min and max pyramids of one channel of an image, for bounding what any region of it
+// contains (eg. the heights under a terrain node).
+//
+// Level 0 is the channel padded to a power of two by repeating the edges, each level after
+// that halves it, with both pyramids built in the same pass (see lodge_image_mips).
+//
+struct lodge_image_minmax
+{
+	uint32_t					width;			// Of the source image.
+	uint32_t					height;
+	uint32_t					levels_count;
+	struct lodge_image			levels_min[LODGE_IMAGE_MINMAX_LEVELS_MAX];
+	struct lodge_image			levels_max[LODGE_IMAGE_MINMAX_LEVELS_MAX];
+};
+
+//
+// Rows of each level are split across `jobs` (optional).
+//
+bool							lodge_image_minmax_new_inplace(struct lodge_image_minmax *minmax, const struct lodge_image *src, uint8_t channel, struct lodge_jobs *jobs);
+void							lodge_image_minmax_free_inplace(struct lodge_image_minmax *minmax);
+
+//
+// Range of the normalized channel values that linear filtering can return anywhere in the
+// normalized rect [uv_min, uv_max]; `x` is the min and `y` the max.
+//
+vec2							lodge_image_minmax_get_01(const struct lodge_image_minmax *minmax, vec2 uv_min, vec2 uv_max);
+
+#endif
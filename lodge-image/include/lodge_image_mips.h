@@ -0,0 +1,70 @@
+#ifndef _LODGE_IMAGE_MIPS_H
+#define _LODGE_IMAGE_MIPS_H
+
+#include "lodge_image.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LODGE_IMAGE_MIPS_LEVELS_MAX 16
+
+struct lodge_jobs;
+
+enum lodge_image_mips_filter
+{
+	LODGE_IMAGE_MIPS_FILTER_NONE = 0,
+	LODGE_IMAGE_MIPS_FILTER_BOX,		// Average of the source texels under the destination texel.
+	LODGE_IMAGE_MIPS_FILTER_KAISER,		// Kaiser windowed sinc, 2 destination texels wide; sharper than box.
+	LODGE_IMAGE_MIPS_FILTER_MIN,
+	LODGE_IMAGE_MIPS_FILTER_MAX,
+};
+
+enum lodge_image_mips_flag
+{
+	//
+	// Average color in linear space: the image is sRGB encoded, except for alpha (channel 3 of
+	// 4). Ignored for float images and for min/max, which do not depend on the encoding.
+	//
+	LODGE_IMAGE_MIPS_FLAG_SRGB			= 1 << 0,
+
+	//
+	// Also build `levels_min` and `levels_max`, where every texel is the min or max of the
+	// source texels it covers, in the same pass.
+	//
+	LODGE_IMAGE_MIPS_FLAG_MIN			= 1 << 1,
+	LODGE_IMAGE_MIPS_FLAG_MAX			= 1 << 2,
+};
+
+struct lodge_image_mips_desc
+{
+	enum lodge_image_mips_filter	filter;			// For `levels`; NONE leaves them empty.
+	uint32_t						flags;			// enum lodge_image_mips_flag
+	uint32_t						levels_max;		// Including the source, 0 for all the way to 1x1.
+	struct lodge_jobs				*jobs;			// Rows of each level are split across these; NULL runs inline.
+};
+
+//
+// Mip chains of an image, for 8-bit and 16-bit normalized or float (4 bytes per channel)
+// images with any number of channels.
+//
+// Each level is half the size of the one before, rounded down; odd sizes are filtered over the
+// exact footprint of every destination texel. Level 0 of every chain shares the pixel data of
+// the source image.
+//
+struct lodge_image_mips
+{
+	uint32_t						levels_count;
+	struct lodge_image				levels[LODGE_IMAGE_MIPS_LEVELS_MAX];
+	struct lodge_image				levels_min[LODGE_IMAGE_MIPS_LEVELS_MAX];
+	struct lodge_image				levels_max[LODGE_IMAGE_MIPS_LEVELS_MAX];
+};
+
+bool								lodge_image_mips_new_inplace(struct lodge_image_mips *mips, const struct lodge_image *src, struct lodge_image_mips_desc desc);
+void								lodge_image_mips_free_inplace(struct lodge_image_mips *mips);
+
+//
+// One level: `dst` is a new image half the size of `src`.
+//
+bool								lodge_image_mips_downsample_inplace(struct lodge_image *dst, const struct lodge_image *src, enum lodge_image_mips_filter filter, uint32_t flags, struct lodge_jobs *jobs);
+
+#endif
@@ -1,4 +1,5 @@
 #include "lodge_image.h"
+#include "lodge_image_mips.h"
 
 #include "blob.h"
 #include <stb/stb_image.h>
@@ -130,110 +131,19 @@ struct lodge_ret lodge_image_new_solid_color(struct lodge_image *image_out, uint
 	return lodge_ret_make_success();
 }
 
-typedef void (*lodge_image_downsample_func_t)(uint8_t *dst, const struct lodge_image *src, uint32_t src_x0, uint32_t src_y0, uint32_t src_x1, uint32_t src_y1);
-
-static void lodge_image_downsample_avg(uint8_t *dst, const struct lodge_image *src, uint32_t src_x0, uint32_t src_y0, uint32_t src_x1, uint32_t src_y1)
-{
-	const uint8_t bytes_per_channel = src->desc.bytes_per_channel;
-	for(uint8_t c = 0, c_max = src->desc.channels; c < c_max; c++) {
-		float avg = 0.0f;
-		for(uint32_t src_y = src_y0; src_y < src_y1; src_y++) {
-			for(uint32_t src_x = src_x0; src_x < src_x1; src_x++) {
-				avg += lodge_image_pixel_channel_get_01(lodge_image_get_pixel_channel(src, src_x, src_y, c), bytes_per_channel);
-			}
-		}
-		avg /= (src_x1 - src_x0) + (src_y1 - src_y0);
-		dst = lodge_image_pixel_channel_set_01(dst, src->desc.bytes_per_channel, avg);
-	}
-}
-
-static void lodge_image_downsample_max(uint8_t *dst, const struct lodge_image *src, uint32_t src_x0, uint32_t src_y0, uint32_t src_x1, uint32_t src_y1)
-{
-	const uint8_t bytes_per_channel = src->desc.bytes_per_channel;
-
-	for(uint8_t c = 0, c_max = src->desc.channels; c < c_max; c++) {
-		float max = 0.0f;
-		for(uint32_t src_y = src_y0; src_y < src_y1; src_y++) {
-			for(uint32_t src_x = src_x0; src_x < src_x1; src_x++) {
-				max = max(max, lodge_image_pixel_channel_get_01(lodge_image_get_pixel_channel(src, src_x, src_y, c), bytes_per_channel));
-			}
-		}
-		dst = lodge_image_pixel_channel_set_01(dst, src->desc.bytes_per_channel, max);
-	}
-}
-
-static void lodge_image_downsample_min(uint8_t *dst, const struct lodge_image *src, uint32_t src_x0, uint32_t src_y0, uint32_t src_x1, uint32_t src_y1)
-{
-	const uint8_t bytes_per_channel = src->desc.bytes_per_channel;
-
-	for(uint8_t c = 0, c_max = src->desc.channels; c < c_max; c++) {
-		float min = 1.0f;
-		for(uint32_t src_y = src_y0; src_y < src_y1; src_y++) {
-			for(uint32_t src_x = src_x0; src_x < src_x1; src_x++) {
-				min = min(min, lodge_image_pixel_channel_get_01(lodge_image_get_pixel_channel(src, src_x, src_y, c), bytes_per_channel));
-			}
-		}
-		dst = lodge_image_pixel_channel_set_01(dst, src->desc.bytes_per_channel, min);
-	}
-}
-
-void lodge_image_new_downsample_inplace(struct lodge_image *dst, const struct lodge_image *src, lodge_image_downsample_func_t func)
-{
-	ASSERT(src);
-	ASSERT(dst);
-
-	*dst = (struct lodge_image) {
-		.desc = {
-			.width = src->desc.width / 2,
-			.height = src->desc.height / 2,
-			.channels = src->desc.channels,
-			.bytes_per_channel = src->desc.bytes_per_channel,
-		},
-		.pixel_data = NULL,
-	};
-	dst->pixel_data = malloc(lodge_image_desc_get_data_size(&dst->desc));
-
-	uint8_t *pixel_data_cursor = dst->pixel_data;
-	for(uint32_t y = 0, y_max = dst->desc.height; y < y_max; y++) {
-		for(uint32_t x = 0, x_max = dst->desc.width; x < x_max; x++) {
-			const uint32_t src_x0 = x * 2;
-			const uint32_t src_y0 = y * 2;
-			const uint32_t src_x1 = x * 2 + 2;
-			const uint32_t src_y1 = y * 2 + 2;
-
-#if 0
-			for(uint8_t c = 0, c_max = dst->desc.channels; c < c_max; c++) {
-				float avg = 0.0f;
-				avg += lodge_image_pixel_channel_get_01(src, lodge_image_get_pixel_channel(src, src_x,     src_y,     c));
-				avg += lodge_image_pixel_channel_get_01(src, lodge_image_get_pixel_channel(src, src_x + 1, src_y,     c));
-				avg += lodge_image_pixel_channel_get_01(src, lodge_image_get_pixel_channel(src, src_x,     src_y + 1, c));
-				avg += lodge_image_pixel_channel_get_01(src, lodge_image_get_pixel_channel(src, src_x + 1, src_y + 1, c));
-				avg *= 0.25f;
-				lodge_image_pixel_channel_set_01(dst, pixel_data_cursor, avg);
-				pixel_data_cursor += dst->desc.bytes_per_channel;
-			}
-#else
-			func(pixel_data_cursor, src, src_x0, src_y0, src_x1, src_y1);
-			pixel_data_cursor += dst->desc.bytes_per_channel;
-#endif
-		}
-	}
-}
-
-
 void lodge_image_new_mipmap_inplace(struct lodge_image *dst, const struct lodge_image *src)
 {
-	lodge_image_new_downsample_inplace(dst, src, &lodge_image_downsample_avg);
+	lodge_image_mips_downsample_inplace(dst, src, LODGE_IMAGE_MIPS_FILTER_BOX, 0, NULL);
 }
 
 void lodge_image_new_max_mipmap_inplace(struct lodge_image *dst, const struct lodge_image *src)
 {
-	lodge_image_new_downsample_inplace(dst, src, &lodge_image_downsample_max);
+	lodge_image_mips_downsample_inplace(dst, src, LODGE_IMAGE_MIPS_FILTER_MAX, 0, NULL);
 }
 
 void lodge_image_new_min_mipmap_inplace(struct lodge_image *dst, const struct lodge_image *src)
 {
-	lodge_image_new_downsample_inplace(dst, src, &lodge_image_downsample_min);
+	lodge_image_mips_downsample_inplace(dst, src, LODGE_IMAGE_MIPS_FILTER_MIN, 0, NULL);
 }
 
 const uint8_t* lodge_image_get_row(const struct lodge_image *image, uint32_t y)
@@ -280,6 +190,8 @@ float lodge_image_pixel_channel_get_01(const uint8_t *pixel_channel, uint8_t byt
 		return *pixel_channel / (float)UINT8_MAX;
 	case 2:
 		return (*(const uint16_t*)(pixel_channel)) / (float)UINT16_MAX;
+	case 4:
+		return *(const float*)(pixel_channel);
 	default:
 		ASSERT_FAIL("Unsupported bytes_per_channel");
 		return 0.0f;
@@ -288,7 +200,7 @@ float lodge_image_pixel_channel_get_01(const uint8_t *pixel_channel, uint8_t byt
 
 uint8_t* lodge_image_pixel_channel_set_01(uint8_t *pixel_channel, uint8_t bytes_per_channel, float value)
 {
-	ASSERT(value >= 0.0f && value <= 1.0f);
+	ASSERT(bytes_per_channel == 4 || (value >= 0.0f && value <= 1.0f));
 
 	switch(bytes_per_channel)
 	{
@@ -300,6 +212,10 @@ uint8_t* lodge_image_pixel_channel_set_01(uint8_t *pixel_channel, uint8_t bytes_
 		*(uint16_t*)(pixel_channel) = (uint16_t)(roundf(value * UINT16_MAX));
 		return pixel_channel + 2;
 	}
+	case 4: {
+		*(float*)(pixel_channel) = value;
+		return pixel_channel + 4;
+	}
 	default:
 		ASSERT_FAIL("Unsupported bytes_per_channel");
 		return pixel_channel;
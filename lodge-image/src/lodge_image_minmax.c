@@ -0,0 +1,154 @@
+#include "lodge_image_minmax.h"
+#include "lodge_image_mips.h"
+
+static uint32_t lodge_image_minmax_pow2(uint32_t value)
+{
+	uint32_t pow2 = 1;
+	while(pow2 < value) {
+		pow2 *= 2;
+	}
+	return pow2;
+}
+
+bool lodge_image_minmax_new_inplace(struct lodge_image_minmax *minmax, const struct lodge_image *src, uint8_t channel, struct lodge_jobs *jobs)
+{
+	ASSERT(minmax);
+	ASSERT(src);
+
+	memset(minmax, 0, sizeof(struct lodge_image_minmax));
+
+	ASSERT_OR(src->pixel_data && src->desc.width > 0 && src->desc.height > 0 && channel < src->desc.channels) {
+		return false;
+	}
+
+	const uint32_t size = lodge_image_minmax_pow2(max(src->desc.width, src->desc.height));
+	ASSERT_OR(size <= (1u << (LODGE_IMAGE_MINMAX_LEVELS_MAX - 1))) {
+		return false;
+	}
+
+	//
+	// Level 0: the channel alone, with the last row and column repeated out to `size`.
+	//
+	const uint8_t bytes_per_channel = src->desc.bytes_per_channel;
+	struct lodge_image base = {
+		.desc = {
+			.width = size,
+			.height = size,
+			.channels = 1,
+			.bytes_per_channel = bytes_per_channel,
+		},
+		.pixel_data = NULL,
+		.shared_pixel_data = false,
+	};
+	base.pixel_data = malloc(lodge_image_desc_get_data_size(&base.desc));
+	ASSERT_OR(base.pixel_data) {
+		return false;
+	}
+
+	const size_t src_stride = (size_t)src->desc.channels * bytes_per_channel;
+	const size_t dst_row_size = (size_t)size * bytes_per_channel;
+
+	for(uint32_t y = 0; y < size; y++) {
+		uint8_t *dst = base.pixel_data + y * dst_row_size;
+		if(y >= src->desc.height) {
+			memcpy(dst, dst - dst_row_size, dst_row_size);
+			continue;
+		}
+
+		const uint8_t *src_channel = lodge_image_get_pixel_channel(src, 0, y, channel);
+		if(src->desc.channels == 1) {
+			memcpy(dst, src_channel, (size_t)src->desc.width * bytes_per_channel);
+		} else {
+			for(uint32_t x = 0; x < src->desc.width; x++) {
+				memcpy(&dst[x * bytes_per_channel], &src_channel[x * src_stride], bytes_per_channel);
+			}
+		}
+
+		const uint8_t *edge = &dst[(src->desc.width - 1) * bytes_per_channel];
+		for(uint32_t x = src->desc.width; x < size; x++) {
+			memcpy(&dst[x * bytes_per_channel], edge, bytes_per_channel);
+		}
+	}
+
+	//
+	// Both pyramids in one pass over each level.
+	//
+	struct lodge_image_mips mips;
+	const bool mips_ok = lodge_image_mips_new_inplace(&mips, &base, (struct lodge_image_mips_desc) {
+		.filter = LODGE_IMAGE_MIPS_FILTER_NONE,
+		.flags = LODGE_IMAGE_MIPS_FLAG_MIN | LODGE_IMAGE_MIPS_FLAG_MAX,
+		.levels_max = 0,
+		.jobs = jobs,
+	});
+	ASSERT_OR(mips_ok) {
+		lodge_image_free(&base);
+		return false;
+	}
+
+	//
+	// The levels move over to `minmax`, which owns `base` through `levels_min[0]`.
+	//
+	minmax->width = src->desc.width;
+	minmax->height = src->desc.height;
+	minmax->levels_count = mips.levels_count;
+	for(uint32_t level = 0; level < mips.levels_count; level++) {
+		minmax->levels_min[level] = mips.levels_min[level];
+		minmax->levels_max[level] = mips.levels_max[level];
+	}
+	minmax->levels_min[0].shared_pixel_data = false;
+
+	return true;
+}
+
+void lodge_image_minmax_free_inplace(struct lodge_image_minmax *minmax)
+{
+	for(uint32_t level = 0; level < minmax->levels_count; level++) {
+		lodge_image_free(&minmax->levels_min[level]);
+		lodge_image_free(&minmax->levels_max[level]);
+	}
+	memset(minmax, 0, sizeof(struct lodge_image_minmax));
+}
+
+//
+// Texels a linear sample at `uv_min` to `uv_max` reads from, along one axis.
+//
+static void lodge_image_minmax_texel_range(float uv_min, float uv_max, uint32_t size, uint32_t *texel_min, uint32_t *texel_max)
+{
+	const float t_min = floorf(uv_min * size - 0.5f);
+	const float t_max = floorf(uv_max * size - 0.5f) + 1.0f;
+	*texel_min = (uint32_t)clamp(t_min, 0.0f, (float)(size - 1));
+	*texel_max = (uint32_t)clamp(t_max, 0.0f, (float)(size - 1));
+}
+
+vec2 lodge_image_minmax_get_01(const struct lodge_image_minmax *minmax, vec2 uv_min, vec2 uv_max)
+{
+	ASSERT_OR(minmax && minmax->levels_count > 0) {
+		return vec2_make(0.0f, 1.0f);
+	}
+
+	uint32_t x0, x1, y0, y1;
+	lodge_image_minmax_texel_range(uv_min.x, uv_max.x, minmax->width, &x0, &x1);
+	lodge_image_minmax_texel_range(uv_min.y, uv_max.y, minmax->height, &y0, &y1);
+
+	//
+	// The first level where the range is at most 2x2 texels.
+	//
+	uint32_t level = 0;
+	while(level + 1 < minmax->levels_count
+		&& ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+		level++;
+	}
+
+	const struct lodge_image *level_min = &minmax->levels_min[level];
+	const struct lodge_image *level_max = &minmax->levels_max[level];
+	const uint8_t bytes_per_channel = level_min->desc.bytes_per_channel;
+
+	vec2 range = vec2_make(1.0f, 0.0f);
+	for(uint32_t y = y0 >> level, y_max = y1 >> level; y <= y_max; y++) {
+		for(uint32_t x = x0 >> level, x_max = x1 >> level; x <= x_max; x++) {
+			range.x = min(range.x, lodge_image_pixel_channel_get_01(lodge_image_get_pixel_channel(level_min, x, y, 0), bytes_per_channel));
+			range.y = max(range.y, lodge_image_pixel_channel_get_01(lodge_image_get_pixel_channel(level_max, x, y, 0), bytes_per_channel));
+		}
+	}
+	return range;
+}
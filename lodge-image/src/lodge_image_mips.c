@@ -0,0 +1,946 @@
+#include "lodge_image_mips.h"
+
+#include "lodge_jobs.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LODGE_IMAGE_MIPS_SSE2
+#include <emmintrin.h>
+#endif
+
+#define LODGE_IMAGE_MIPS_KAISER_BETA		4.0
+#define LODGE_IMAGE_MIPS_KAISER_RADIUS		2.0				// In destination texels.
+#define LODGE_IMAGE_MIPS_CHAINS_MAX			3
+#define LODGE_IMAGE_MIPS_JOBS_MAX			256
+#define LODGE_IMAGE_MIPS_JOB_ROWS_MIN		16
+#define LODGE_IMAGE_MIPS_SRGB_STEPS			4096
+
+//
+// Filter taps along one axis, for every destination texel.
+//
+struct lodge_image_mips_taps
+{
+	bool							pairs;			// Exactly 2:1 and not Kaiser: texels 2x and 2x + 1; `index` and `weight` are unused.
+	uint32_t						count;			// Per destination texel.
+	uint32_t						*index;			// Clamped to the source.
+	float							*weight;		// Sums to 1 per destination texel; unused for min/max.
+};
+
+//
+// 8-bit sRGB conversions. Encoding counts the thresholds below the value, starting from a
+// coarse guess, so it rounds exactly like `roundf(linear_to_srgb(value) * 255)`. The guess is
+// never more than 2 thresholds short, so the count is finished without branches.
+//
+struct lodge_image_mips_srgb
+{
+	float							to_linear[256];
+	float							thresholds[257];						// Linear values where the encoding goes from k to k + 1, then 2 past 1.
+	uint8_t							start[LODGE_IMAGE_MIPS_SRGB_STEPS];		// Thresholds below `(i - 1) / (steps - 1)`.
+};
+
+struct lodge_image_mips_chain
+{
+	enum lodge_image_mips_filter	filter;
+	const struct lodge_image		*src;
+	struct lodge_image				*dst;
+	const struct lodge_image_mips_taps *taps_x;
+	const struct lodge_image_mips_taps *taps_y;
+	const struct lodge_image_mips_srgb *srgb;		// NULL unless averaging in linear space.
+};
+
+//
+// Downsampling of one level, for every chain.
+//
+struct lodge_image_mips_pass
+{
+	struct lodge_image_desc			src_desc;
+	struct lodge_image_desc			dst_desc;
+
+	struct lodge_image_mips_chain	chains[LODGE_IMAGE_MIPS_CHAINS_MAX];
+	uint32_t						chains_count;
+
+	struct lodge_image_mips_taps	filter_x;
+	struct lodge_image_mips_taps	filter_y;
+	struct lodge_image_mips_taps	footprint_x;	// For min/max.
+	struct lodge_image_mips_taps	footprint_y;
+
+	uint32_t						rows_cached;
+};
+
+struct lodge_image_mips_job
+{
+	const struct lodge_image_mips_pass *pass;
+	uint32_t						y_begin;
+	uint32_t						y_end;
+};
+
+//
+// Source rows converted to float, per job; the filter taps of neighbouring destination rows
+// overlap, so recently used rows are kept around.
+//
+struct lodge_image_mips_row
+{
+	const struct lodge_image		*image;
+	uint32_t						y;
+	bool							srgb;
+	uint32_t						used;
+	float							*data;
+};
+
+struct lodge_image_mips_scratch
+{
+	struct lodge_image_mips_row		*rows;
+	uint32_t						rows_count;
+	uint32_t						tick;
+	float							*acc;			// Source width.
+	float							*out;			// Destination width.
+};
+
+enum lodge_image_mips_op
+{
+	LODGE_IMAGE_MIPS_OP_ADD,
+	LODGE_IMAGE_MIPS_OP_MIN,
+	LODGE_IMAGE_MIPS_OP_MAX,
+};
+
+static enum lodge_image_mips_op lodge_image_mips_filter_op(enum lodge_image_mips_filter filter)
+{
+	switch(filter) {
+	case LODGE_IMAGE_MIPS_FILTER_MIN:
+		return LODGE_IMAGE_MIPS_OP_MIN;
+	case LODGE_IMAGE_MIPS_FILTER_MAX:
+		return LODGE_IMAGE_MIPS_OP_MAX;
+	default:
+		return LODGE_IMAGE_MIPS_OP_ADD;
+	}
+}
+
+static uint32_t lodge_image_mips_level_size(uint32_t size)
+{
+	return max(size / 2, 1u);
+}
+
+//
+// sRGB
+//
+
+static double lodge_image_mips_srgb_to_linear(double value)
+{
+	return value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4);
+}
+
+static double lodge_image_mips_linear_to_srgb(double value)
+{
+	return value <= 0.0031308 ? value * 12.92 : 1.055 * pow(value, 1.0 / 2.4) - 0.055;
+}
+
+static void lodge_image_mips_srgb_make(struct lodge_image_mips_srgb *srgb)
+{
+	for(uint32_t k = 0; k < 256; k++) {
+		srgb->to_linear[k] = (float)lodge_image_mips_srgb_to_linear(k / 255.0);
+	}
+	for(uint32_t k = 0; k < 255; k++) {
+		srgb->thresholds[k] = (float)lodge_image_mips_srgb_to_linear((k + 0.5) / 255.0);
+	}
+	srgb->thresholds[255] = 2.0f;
+	srgb->thresholds[256] = 2.0f;
+
+	uint32_t k = 0;
+	srgb->start[0] = 0;
+	for(uint32_t i = 1; i < LODGE_IMAGE_MIPS_SRGB_STEPS; i++) {
+		const float value = (float)(i - 1) / (float)(LODGE_IMAGE_MIPS_SRGB_STEPS - 1);
+		while(k < 255 && srgb->thresholds[k] <= value) {
+			k++;
+		}
+		srgb->start[i] = (uint8_t)k;
+	}
+
+	//
+	// A value in step i is below `(i + 1) / (steps - 1)`, so at most the thresholds up to
+	// `start[i + 2]` are below it.
+	//
+	for(uint32_t i = 0; i + 2 < LODGE_IMAGE_MIPS_SRGB_STEPS; i++) {
+		ASSERT(srgb->start[i + 2] - srgb->start[i] <= 2);
+	}
+}
+
+static uint8_t lodge_image_mips_srgb_encode(const struct lodge_image_mips_srgb *srgb, float value)
+{
+	value = (value > 0.0f) ? min(value, 1.0f) : 0.0f;
+
+	uint32_t k = srgb->start[(uint32_t)(value * (float)(LODGE_IMAGE_MIPS_SRGB_STEPS - 1))];
+	k += value >= srgb->thresholds[k];
+	k += value >= srgb->thresholds[k];
+	return (uint8_t)k;
+}
+
+//
+// Taps
+//
+
+static double lodge_image_mips_bessel_i0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for(int k = 1; k < 32; k++) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+static double lodge_image_mips_kaiser(double distance)
+{
+	const double t = distance / LODGE_IMAGE_MIPS_KAISER_RADIUS;
+	if(fabs(t) >= 1.0) {
+		return 0.0;
+	}
+	const double sinc = distance == 0.0 ? 1.0 : sin(M_PI * distance) / (M_PI * distance);
+	return sinc * lodge_image_mips_bessel_i0(LODGE_IMAGE_MIPS_KAISER_BETA * sqrt(1.0 - t * t)) / lodge_image_mips_bessel_i0(LODGE_IMAGE_MIPS_KAISER_BETA);
+}
+
+static void lodge_image_mips_taps_free_inplace(struct lodge_image_mips_taps *taps)
+{
+	free(taps->index);
+	free(taps->weight);
+	memset(taps, 0, sizeof(struct lodge_image_mips_taps));
+}
+
+static bool lodge_image_mips_taps_new_inplace(struct lodge_image_mips_taps *taps, enum lodge_image_mips_filter filter, uint32_t src_size, uint32_t dst_size)
+{
+	memset(taps, 0, sizeof(struct lodge_image_mips_taps));
+
+	if(src_size == dst_size * 2 && filter != LODGE_IMAGE_MIPS_FILTER_KAISER) {
+		taps->pairs = true;
+		taps->count = 2;
+		return true;
+	}
+
+	const double ratio = (double)src_size / (double)dst_size;
+	const double radius = LODGE_IMAGE_MIPS_KAISER_RADIUS * ratio;
+	const uint32_t stride = filter == LODGE_IMAGE_MIPS_FILTER_KAISER
+		? (uint32_t)ceil(2.0 * radius) + 2
+		: (uint32_t)ceil(ratio) + 1;
+
+	taps->index = malloc((size_t)dst_size * stride * sizeof(uint32_t));
+	taps->weight = malloc((size_t)dst_size * stride * sizeof(float));
+	ASSERT_OR(taps->index && taps->weight) {
+		lodge_image_mips_taps_free_inplace(taps);
+		return false;
+	}
+
+	for(uint32_t x = 0; x < dst_size; x++) {
+		uint32_t *index = &taps->index[x * stride];
+		float *weight = &taps->weight[x * stride];
+		uint32_t count = 0;
+		double weight_sum = 0.0;
+
+		if(filter == LODGE_IMAGE_MIPS_FILTER_KAISER) {
+			const double center = (x + 0.5) * ratio;
+			for(int64_t s = (int64_t)floor(center - radius); s <= (int64_t)ceil(center + radius) && count < stride; s++) {
+				const double w = lodge_image_mips_kaiser((s + 0.5 - center) / ratio);
+				if(w == 0.0) {
+					continue;
+				}
+				index[count] = (uint32_t)min(max(s, (int64_t)0), (int64_t)src_size - 1);
+				weight[count] = (float)w;
+				weight_sum += w;
+				count++;
+			}
+		} else {
+			//
+			// Every source texel overlapping [x, x + 1) in destination texels, weighted by the
+			// overlap.
+			//
+			const double lo = x * ratio;
+			const double hi = (x + 1) * ratio;
+			for(uint32_t s = (uint32_t)floor(lo); s < hi && s < src_size && count < stride; s++) {
+				const double w = min(hi, s + 1.0) - max(lo, (double)s);
+				if(w <= 0.0) {
+					continue;
+				}
+				index[count] = s;
+				weight[count] = (float)w;
+				weight_sum += w;
+				count++;
+			}
+		}
+
+		ASSERT(count > 0);
+		for(uint32_t t = 0; t < count; t++) {
+			weight[t] = (float)(weight[t] / weight_sum);
+		}
+
+		//
+		// Repeating the last tap with no weight keeps both sums and min/max the same.
+		//
+		for(uint32_t t = count; t < stride; t++) {
+			index[t] = count > 0 ? index[count - 1] : 0;
+			weight[t] = 0.0f;
+		}
+
+		taps->count = max(taps->count, count);
+	}
+
+	//
+	// Most texels have fewer taps than the worst case; pack them down to the longest one.
+	//
+	for(uint32_t x = 1; x < dst_size; x++) {
+		memmove(&taps->index[x * taps->count], &taps->index[x * stride], taps->count * sizeof(uint32_t));
+		memmove(&taps->weight[x * taps->count], &taps->weight[x * stride], taps->count * sizeof(float));
+	}
+
+	return true;
+}
+
+//
+// Rows
+//
+// Rows are filtered as floats: normalized formats in their own codes (0-255, 0-65535), so
+// box averages of 2x2 texels are exact and round like the integer math would, and sRGB colors
+// in linear [0, 1].
+//
+
+static void lodge_image_mips_decode(float *dst, const uint8_t *src, uint32_t width, uint8_t channels, uint8_t bytes_per_channel, const struct lodge_image_mips_srgb *srgb)
+{
+	const size_t count = (size_t)width * channels;
+
+	if(srgb) {
+		const uint16_t *src_u16 = (const uint16_t *)src;
+		if(bytes_per_channel == 1) {
+			for(size_t i = 0; i < count; i++) {
+				dst[i] = srgb->to_linear[src[i]];
+			}
+		} else {
+			for(size_t i = 0; i < count; i++) {
+				dst[i] = (float)lodge_image_mips_srgb_to_linear(src_u16[i] / 65535.0);
+			}
+		}
+
+		//
+		// Alpha is linear already, and stays in codes like other normalized channels.
+		//
+		if(channels == 4) {
+			for(size_t i = 3; i < count; i += 4) {
+				dst[i] = bytes_per_channel == 1 ? src[i] : src_u16[i];
+			}
+		}
+		return;
+	}
+
+	size_t i = 0;
+
+	if(bytes_per_channel == 1) {
+#if defined(LODGE_IMAGE_MIPS_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		for(; i + 16 <= count; i += 16) {
+			const __m128i bytes = _mm_loadu_si128((const __m128i *)&src[i]);
+			const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+			const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+			_mm_storeu_ps(&dst[i +  0], _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)));
+			_mm_storeu_ps(&dst[i +  4], _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)));
+			_mm_storeu_ps(&dst[i +  8], _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)));
+			_mm_storeu_ps(&dst[i + 12], _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)));
+		}
+#endif
+		for(; i < count; i++) {
+			dst[i] = src[i];
+		}
+	} else if(bytes_per_channel == 2) {
+		const uint16_t *src_u16 = (const uint16_t *)src;
+#if defined(LODGE_IMAGE_MIPS_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		for(; i + 8 <= count; i += 8) {
+			const __m128i words = _mm_loadu_si128((const __m128i *)&src_u16[i]);
+			_mm_storeu_ps(&dst[i + 0], _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero)));
+			_mm_storeu_ps(&dst[i + 4], _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero)));
+		}
+#endif
+		for(; i < count; i++) {
+			dst[i] = src_u16[i];
+		}
+	} else {
+		memcpy(dst, src, count * sizeof(float));
+	}
+}
+
+static void lodge_image_mips_encode(uint8_t *dst, const float *src, uint32_t width, uint8_t channels, uint8_t bytes_per_channel, const struct lodge_image_mips_srgb *srgb)
+{
+	const size_t count = (size_t)width * channels;
+
+	if(srgb) {
+		uint16_t *dst_u16 = (uint16_t *)dst;
+		if(bytes_per_channel == 1) {
+			for(size_t i = 0; i < count; i++) {
+				dst[i] = lodge_image_mips_srgb_encode(srgb, src[i]);
+			}
+		} else {
+			for(size_t i = 0; i < count; i++) {
+				dst_u16[i] = (uint16_t)(lodge_image_mips_linear_to_srgb(clamp(src[i], 0.0f, 1.0f)) * 65535.0 + 0.5);
+			}
+		}
+
+		if(channels == 4) {
+			const float code_max = bytes_per_channel == 1 ? 255.0f : 65535.0f;
+			for(size_t i = 3; i < count; i += 4) {
+				const float value = clamp(src[i], 0.0f, code_max) + 0.5f;
+				if(bytes_per_channel == 1) {
+					dst[i] = (uint8_t)value;
+				} else {
+					dst_u16[i] = (uint16_t)value;
+				}
+			}
+		}
+		return;
+	}
+
+	//
+	// Rounds half up, like `lodge_image_pixel_channel_set_01()`.
+	//
+	size_t i = 0;
+
+	if(bytes_per_channel == 1) {
+#if defined(LODGE_IMAGE_MIPS_SSE2)
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 code_max = _mm_set1_ps(255.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		__m128i quads[4];
+		for(; i + 16 <= count; i += 16) {
+			for(int q = 0; q < 4; q++) {
+				const __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&src[i + q * 4]), zero), code_max);
+				quads[q] = _mm_cvttps_epi32(_mm_add_ps(value, half));
+			}
+			const __m128i lo = _mm_packs_epi32(quads[0], quads[1]);
+			const __m128i hi = _mm_packs_epi32(quads[2], quads[3]);
+			_mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(lo, hi));
+		}
+#endif
+		for(; i < count; i++) {
+			dst[i] = (uint8_t)(clamp(src[i], 0.0f, 255.0f) + 0.5f);
+		}
+	} else if(bytes_per_channel == 2) {
+		uint16_t *dst_u16 = (uint16_t *)dst;
+#if defined(LODGE_IMAGE_MIPS_SSE2)
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 code_max = _mm_set1_ps(65535.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+
+		//
+		// No unsigned 32 to 16-bit pack in SSE2: bias into the signed range and flip the sign
+		// bit back after packing.
+		//
+		const __m128i bias32 = _mm_set1_epi32(32768);
+		const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+		for(; i + 8 <= count; i += 8) {
+			const __m128 value_lo = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&src[i + 0]), zero), code_max);
+			const __m128 value_hi = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&src[i + 4]), zero), code_max);
+			const __m128i lo = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(value_lo, half)), bias32);
+			const __m128i hi = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(value_hi, half)), bias32);
+			_mm_storeu_si128((__m128i *)&dst_u16[i], _mm_xor_si128(_mm_packs_epi32(lo, hi), bias16));
+		}
+#endif
+		for(; i < count; i++) {
+			dst_u16[i] = (uint16_t)(clamp(src[i], 0.0f, 65535.0f) + 0.5f);
+		}
+	} else {
+		memcpy(dst, src, count * sizeof(float));
+	}
+}
+
+static const float* lodge_image_mips_get_row(struct lodge_image_mips_scratch *scratch, const struct lodge_image *image, uint32_t y, const struct lodge_image_mips_srgb *srgb)
+{
+	const uint8_t *src = lodge_image_get_row(image, y);
+	if(image->desc.bytes_per_channel == 4) {
+		return (const float *)src;
+	}
+
+	scratch->tick++;
+
+	struct lodge_image_mips_row *oldest = &scratch->rows[0];
+	for(uint32_t i = 0; i < scratch->rows_count; i++) {
+		struct lodge_image_mips_row *row = &scratch->rows[i];
+		if(row->image == image && row->y == y && row->srgb == (srgb != NULL)) {
+			row->used = scratch->tick;
+			return row->data;
+		}
+		if(row->used < oldest->used) {
+			oldest = row;
+		}
+	}
+
+	oldest->image = image;
+	oldest->y = y;
+	oldest->srgb = (srgb != NULL);
+	oldest->used = scratch->tick;
+	lodge_image_mips_decode(oldest->data, src, image->desc.width, image->desc.channels, image->desc.bytes_per_channel, srgb);
+	return oldest->data;
+}
+
+static inline float lodge_image_mips_op(enum lodge_image_mips_op op, float a, float b)
+{
+	switch(op) {
+	case LODGE_IMAGE_MIPS_OP_MIN:
+		return min(a, b);
+	case LODGE_IMAGE_MIPS_OP_MAX:
+		return max(a, b);
+	default:
+		return a + b;
+	}
+}
+
+#if defined(LODGE_IMAGE_MIPS_SSE2)
+static inline __m128 lodge_image_mips_op_sse2(enum lodge_image_mips_op op, __m128 a, __m128 b)
+{
+	switch(op) {
+	case LODGE_IMAGE_MIPS_OP_MIN:
+		return _mm_min_ps(a, b);
+	case LODGE_IMAGE_MIPS_OP_MAX:
+		return _mm_max_ps(a, b);
+	default:
+		return _mm_add_ps(a, b);
+	}
+}
+#endif
+
+//
+// `dst = op(a, b)`; `dst` may be `a`.
+//
+static void lodge_image_mips_row_reduce(enum lodge_image_mips_op op, float *dst, const float *a, const float *b, size_t count)
+{
+	size_t i = 0;
+#if defined(LODGE_IMAGE_MIPS_SSE2)
+	for(; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(&dst[i], lodge_image_mips_op_sse2(op, _mm_loadu_ps(&a[i]), _mm_loadu_ps(&b[i])));
+	}
+#endif
+	for(; i < count; i++) {
+		dst[i] = lodge_image_mips_op(op, a[i], b[i]);
+	}
+}
+
+//
+// `dst += src * weight`.
+//
+static void lodge_image_mips_row_madd(float *dst, const float *src, float weight, size_t count)
+{
+	size_t i = 0;
+#if defined(LODGE_IMAGE_MIPS_SSE2)
+	const __m128 w = _mm_set1_ps(weight);
+	for(; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(&dst[i], _mm_add_ps(_mm_loadu_ps(&dst[i]), _mm_mul_ps(_mm_loadu_ps(&src[i]), w)));
+	}
+#endif
+	for(; i < count; i++) {
+		dst[i] += src[i] * weight;
+	}
+}
+
+//
+// Filters the source rows of destination row `y` into `acc`. Box pairs are summed; their 1/2
+// is left to the horizontal pass.
+//
+static void lodge_image_mips_vertical(struct lodge_image_mips_scratch *scratch, const struct lodge_image_mips_chain *chain, enum lodge_image_mips_op op, uint32_t y)
+{
+	const struct lodge_image_mips_taps *taps = chain->taps_y;
+	const size_t count = (size_t)chain->src->desc.width * chain->src->desc.channels;
+
+	if(taps->pairs) {
+		//
+		// Both rows are used before the next lookup, so the cache always has room for them.
+		//
+		const float *row0 = lodge_image_mips_get_row(scratch, chain->src, y * 2, chain->srgb);
+		const float *row1 = lodge_image_mips_get_row(scratch, chain->src, y * 2 + 1, chain->srgb);
+		lodge_image_mips_row_reduce(op, scratch->acc, row0, row1, count);
+		return;
+	}
+
+	const uint32_t *index = &taps->index[y * taps->count];
+	const float *weight = &taps->weight[y * taps->count];
+
+	if(op == LODGE_IMAGE_MIPS_OP_ADD) {
+		memset(scratch->acc, 0, count * sizeof(float));
+		for(uint32_t t = 0; t < taps->count; t++) {
+			if(weight[t] != 0.0f) {
+				lodge_image_mips_row_madd(scratch->acc, lodge_image_mips_get_row(scratch, chain->src, index[t], chain->srgb), weight[t], count);
+			}
+		}
+	} else {
+		memcpy(scratch->acc, lodge_image_mips_get_row(scratch, chain->src, index[0], NULL), count * sizeof(float));
+		for(uint32_t t = 1; t < taps->count; t++) {
+			if(index[t] != index[t - 1]) {
+				lodge_image_mips_row_reduce(op, scratch->acc, scratch->acc, lodge_image_mips_get_row(scratch, chain->src, index[t], NULL), count);
+			}
+		}
+	}
+}
+
+//
+// Filters `acc` along x into `out`, scaling sums by `scale`.
+//
+static void lodge_image_mips_horizontal(struct lodge_image_mips_scratch *scratch, const struct lodge_image_mips_chain *chain, enum lodge_image_mips_op op, float scale)
+{
+	const struct lodge_image_mips_taps *taps = chain->taps_x;
+	const uint32_t channels = chain->src->desc.channels;
+	const uint32_t width = chain->dst->desc.width;
+	const float *acc = scratch->acc;
+	float *out = scratch->out;
+
+	if(op != LODGE_IMAGE_MIPS_OP_ADD) {
+		scale = 1.0f;
+	}
+
+	if(taps->pairs) {
+		uint32_t x = 0;
+#if defined(LODGE_IMAGE_MIPS_SSE2)
+		const __m128 s = _mm_set1_ps(scale);
+		if(channels == 1) {
+			for(; x + 4 <= width; x += 4) {
+				const __m128 a = _mm_loadu_ps(&acc[x * 2]);
+				const __m128 b = _mm_loadu_ps(&acc[x * 2 + 4]);
+				const __m128 even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+				const __m128 odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+				_mm_storeu_ps(&out[x], _mm_mul_ps(lodge_image_mips_op_sse2(op, even, odd), s));
+			}
+		} else if(channels == 2) {
+			for(; x + 2 <= width; x += 2) {
+				const __m128 a = _mm_loadu_ps(&acc[x * 4]);
+				const __m128 b = _mm_loadu_ps(&acc[x * 4 + 4]);
+				const __m128 even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 1, 0));
+				const __m128 odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 2, 3, 2));
+				_mm_storeu_ps(&out[x * 2], _mm_mul_ps(lodge_image_mips_op_sse2(op, even, odd), s));
+			}
+		} else if(channels == 4) {
+			for(; x < width; x++) {
+				const __m128 a = _mm_loadu_ps(&acc[x * 8]);
+				const __m128 b = _mm_loadu_ps(&acc[x * 8 + 4]);
+				_mm_storeu_ps(&out[x * 4], _mm_mul_ps(lodge_image_mips_op_sse2(op, a, b), s));
+			}
+		}
+#endif
+		for(; x < width; x++) {
+			for(uint32_t c = 0; c < channels; c++) {
+				out[x * channels + c] = lodge_image_mips_op(op, acc[x * 2 * channels + c], acc[(x * 2 + 1) * channels + c]) * scale;
+			}
+		}
+		return;
+	}
+
+	for(uint32_t x = 0; x < width; x++) {
+		const uint32_t *index = &taps->index[x * taps->count];
+		const float *weight = &taps->weight[x * taps->count];
+
+#if defined(LODGE_IMAGE_MIPS_SSE2)
+		if(channels == 4) {
+			__m128 value = _mm_loadu_ps(&acc[index[0] * 4]);
+			if(op == LODGE_IMAGE_MIPS_OP_ADD) {
+				value = _mm_mul_ps(value, _mm_set1_ps(weight[0]));
+				for(uint32_t t = 1; t < taps->count; t++) {
+					value = _mm_add_ps(value, _mm_mul_ps(_mm_loadu_ps(&acc[index[t] * 4]), _mm_set1_ps(weight[t])));
+				}
+				value = _mm_mul_ps(value, _mm_set1_ps(scale));
+			} else {
+				for(uint32_t t = 1; t < taps->count; t++) {
+					value = lodge_image_mips_op_sse2(op, value, _mm_loadu_ps(&acc[index[t] * 4]));
+				}
+			}
+			_mm_storeu_ps(&out[x * 4], value);
+			continue;
+		}
+#endif
+
+		for(uint32_t c = 0; c < channels; c++) {
+			float value = acc[index[0] * channels + c];
+			if(op == LODGE_IMAGE_MIPS_OP_ADD) {
+				value *= weight[0];
+				for(uint32_t t = 1; t < taps->count; t++) {
+					value += acc[index[t] * channels + c] * weight[t];
+				}
+				value *= scale;
+			} else {
+				for(uint32_t t = 1; t < taps->count; t++) {
+					value = lodge_image_mips_op(op, value, acc[index[t] * channels + c]);
+				}
+			}
+			out[x * channels + c] = value;
+		}
+	}
+}
+
+//
+// Jobs
+//
+
+static void lodge_image_mips_job_run(void *userdata)
+{
+	const struct lodge_image_mips_job *job = userdata;
+	const struct lodge_image_mips_pass *pass = job->pass;
+
+	const size_t src_count = (size_t)pass->src_desc.width * pass->src_desc.channels;
+	const size_t dst_count = (size_t)pass->dst_desc.width * pass->dst_desc.channels;
+
+	struct lodge_image_mips_scratch scratch = {
+		.rows = calloc(pass->rows_cached, sizeof(struct lodge_image_mips_row)),
+		.rows_count = pass->rows_cached,
+		.tick = 0,
+		.acc = malloc(src_count * sizeof(float)),
+		.out = malloc(dst_count * sizeof(float)),
+	};
+	float *rows_data = malloc(pass->rows_cached * src_count * sizeof(float));
+
+	ASSERT_OR(scratch.rows && scratch.acc && scratch.out && rows_data) {
+		goto cleanup;
+	}
+
+	for(uint32_t i = 0; i < scratch.rows_count; i++) {
+		scratch.rows[i].data = &rows_data[i * src_count];
+	}
+
+	for(uint32_t y = job->y_begin; y < job->y_end; y++) {
+		for(uint32_t i = 0; i < pass->chains_count; i++) {
+			const struct lodge_image_mips_chain *chain = &pass->chains[i];
+			const enum lodge_image_mips_op op = lodge_image_mips_filter_op(chain->filter);
+			const float scale = (chain->taps_x->pairs ? 0.5f : 1.0f) * (chain->taps_y->pairs ? 0.5f : 1.0f);
+
+			lodge_image_mips_vertical(&scratch, chain, op, y);
+			lodge_image_mips_horizontal(&scratch, chain, op, scale);
+
+			uint8_t *dst = chain->dst->pixel_data + lodge_image_desc_get_offset_row(&chain->dst->desc, y);
+			lodge_image_mips_encode(dst, scratch.out, chain->dst->desc.width, chain->dst->desc.channels, chain->dst->desc.bytes_per_channel, chain->srgb);
+		}
+	}
+
+cleanup:
+	free(rows_data);
+	free(scratch.rows);
+	free(scratch.acc);
+	free(scratch.out);
+}
+
+static void lodge_image_mips_pass_free_inplace(struct lodge_image_mips_pass *pass)
+{
+	lodge_image_mips_taps_free_inplace(&pass->filter_x);
+	lodge_image_mips_taps_free_inplace(&pass->filter_y);
+	lodge_image_mips_taps_free_inplace(&pass->footprint_x);
+	lodge_image_mips_taps_free_inplace(&pass->footprint_y);
+}
+
+//
+// Downsamples `src[i]` into new images `dst[i]` with `filters[i]`, for all chains in one go.
+// All sources must have the same desc.
+//
+static bool lodge_image_mips_downsample(struct lodge_image *dst[], const struct lodge_image *src[], const enum lodge_image_mips_filter filters[], uint32_t count, const struct lodge_image_mips_srgb *srgb, struct lodge_jobs *jobs)
+{
+	ASSERT_OR(count > 0 && count <= LODGE_IMAGE_MIPS_CHAINS_MAX) {
+		return false;
+	}
+
+	struct lodge_image_mips_pass pass = { 0 };
+	pass.src_desc = src[0]->desc;
+	pass.dst_desc = (struct lodge_image_desc) {
+		.width = lodge_image_mips_level_size(pass.src_desc.width),
+		.height = lodge_image_mips_level_size(pass.src_desc.height),
+		.channels = pass.src_desc.channels,
+		.bytes_per_channel = pass.src_desc.bytes_per_channel,
+	};
+
+	bool ok = true;
+	enum lodge_image_mips_filter filter = LODGE_IMAGE_MIPS_FILTER_NONE;
+	bool footprint = false;
+
+	for(uint32_t i = 0; i < count; i++) {
+		ASSERT(memcmp(&src[i]->desc, &pass.src_desc, sizeof(struct lodge_image_desc)) == 0);
+		ASSERT(filters[i] != LODGE_IMAGE_MIPS_FILTER_NONE);
+
+		const bool reduce = filters[i] == LODGE_IMAGE_MIPS_FILTER_MIN || filters[i] == LODGE_IMAGE_MIPS_FILTER_MAX;
+		if(reduce) {
+			footprint = true;
+		} else {
+			ASSERT(filter == LODGE_IMAGE_MIPS_FILTER_NONE || filter == filters[i]);
+			filter = filters[i];
+		}
+
+		pass.chains[i] = (struct lodge_image_mips_chain) {
+			.filter = filters[i],
+			.src = src[i],
+			.dst = dst[i],
+			.taps_x = reduce ? &pass.footprint_x : &pass.filter_x,
+			.taps_y = reduce ? &pass.footprint_y : &pass.filter_y,
+			.srgb = (!reduce && pass.src_desc.bytes_per_channel != 4) ? srgb : NULL,
+		};
+
+		*dst[i] = (struct lodge_image) {
+			.desc = pass.dst_desc,
+			.pixel_data = malloc(lodge_image_desc_get_data_size(&pass.dst_desc)),
+			.shared_pixel_data = false,
+		};
+		ok &= (dst[i]->pixel_data != NULL);
+	}
+	pass.chains_count = count;
+
+	if(filter != LODGE_IMAGE_MIPS_FILTER_NONE) {
+		ok &= lodge_image_mips_taps_new_inplace(&pass.filter_x, filter, pass.src_desc.width, pass.dst_desc.width);
+		ok &= lodge_image_mips_taps_new_inplace(&pass.filter_y, filter, pass.src_desc.height, pass.dst_desc.height);
+		pass.rows_cached += pass.filter_y.count;
+	}
+	if(footprint) {
+		ok &= lodge_image_mips_taps_new_inplace(&pass.footprint_x, LODGE_IMAGE_MIPS_FILTER_MIN, pass.src_desc.width, pass.dst_desc.width);
+		ok &= lodge_image_mips_taps_new_inplace(&pass.footprint_y, LODGE_IMAGE_MIPS_FILTER_MIN, pass.src_desc.height, pass.dst_desc.height);
+		pass.rows_cached += pass.footprint_y.count * (count - (filter != LODGE_IMAGE_MIPS_FILTER_NONE ? 1 : 0));
+	}
+
+	ASSERT_OR(ok) {
+		for(uint32_t i = 0; i < count; i++) {
+			free(dst[i]->pixel_data);
+			*dst[i] = (struct lodge_image) { 0 };
+		}
+		lodge_image_mips_pass_free_inplace(&pass);
+		return false;
+	}
+
+	//
+	// A few row ranges per thread, so threads that finish early can pick up more work.
+	//
+	const uint32_t threads_count = lodge_jobs_get_threads_count(jobs);
+	const uint32_t jobs_count = threads_count > 0
+		? max(min(pass.dst_desc.height / LODGE_IMAGE_MIPS_JOB_ROWS_MIN, min(threads_count * 4, LODGE_IMAGE_MIPS_JOBS_MAX)), 1u)
+		: 1;
+	const uint32_t rows_per_job = (pass.dst_desc.height + jobs_count - 1) / jobs_count;
+
+	struct lodge_image_mips_job jobs_data[LODGE_IMAGE_MIPS_JOBS_MAX];
+	struct lodge_job_counter counter = { 0 };
+
+	for(uint32_t i = 0; i < jobs_count; i++) {
+		jobs_data[i] = (struct lodge_image_mips_job) {
+			.pass = &pass,
+			.y_begin = min(i * rows_per_job, pass.dst_desc.height),
+			.y_end = min((i + 1) * rows_per_job, pass.dst_desc.height),
+		};
+		lodge_jobs_submit(jobs, &lodge_image_mips_job_run, &jobs_data[i], &counter);
+	}
+	lodge_jobs_wait(jobs, &counter);
+
+	lodge_image_mips_pass_free_inplace(&pass);
+	return true;
+}
+
+bool lodge_image_mips_new_inplace(struct lodge_image_mips *mips, const struct lodge_image *src, struct lodge_image_mips_desc desc)
+{
+	ASSERT(mips);
+	memset(mips, 0, sizeof(struct lodge_image_mips));
+
+	ASSERT_OR(src && src->pixel_data && src->desc.width > 0 && src->desc.height > 0 && src->desc.channels > 0) {
+		return false;
+	}
+	ASSERT_OR(src->desc.bytes_per_channel == 1 || src->desc.bytes_per_channel == 2 || src->desc.bytes_per_channel == 4) {
+		return false;
+	}
+
+	struct lodge_image *chains[LODGE_IMAGE_MIPS_CHAINS_MAX];
+	enum lodge_image_mips_filter filters[LODGE_IMAGE_MIPS_CHAINS_MAX];
+	uint32_t chains_count = 0;
+
+	if(desc.filter != LODGE_IMAGE_MIPS_FILTER_NONE) {
+		chains[chains_count] = mips->levels;
+		filters[chains_count++] = desc.filter;
+	}
+	if(desc.flags & LODGE_IMAGE_MIPS_FLAG_MIN) {
+		chains[chains_count] = mips->levels_min;
+		filters[chains_count++] = LODGE_IMAGE_MIPS_FILTER_MIN;
+	}
+	if(desc.flags & LODGE_IMAGE_MIPS_FLAG_MAX) {
+		chains[chains_count] = mips->levels_max;
+		filters[chains_count++] = LODGE_IMAGE_MIPS_FILTER_MAX;
+	}
+
+	for(uint32_t i = 0; i < chains_count; i++) {
+		chains[i][0] = *src;
+		chains[i][0].shared_pixel_data = true;
+	}
+	mips->levels_count = 1;
+
+	struct lodge_image_mips_srgb *srgb = NULL;
+	if((desc.flags & LODGE_IMAGE_MIPS_FLAG_SRGB) && src->desc.bytes_per_channel != 4) {
+		srgb = malloc(sizeof(struct lodge_image_mips_srgb));
+		ASSERT_OR(srgb) {
+			lodge_image_mips_free_inplace(mips);
+			return false;
+		}
+		lodge_image_mips_srgb_make(srgb);
+	}
+
+	const uint32_t levels_max = desc.levels_max > 0 ? min(desc.levels_max, LODGE_IMAGE_MIPS_LEVELS_MAX) : LODGE_IMAGE_MIPS_LEVELS_MAX;
+	bool ok = true;
+
+	while(chains_count > 0 && mips->levels_count < levels_max) {
+		const uint32_t level = mips->levels_count;
+		const struct lodge_image_desc *prev = &chains[0][level - 1].desc;
+		if(prev->width == 1 && prev->height == 1) {
+			break;
+		}
+
+		struct lodge_image *dst[LODGE_IMAGE_MIPS_CHAINS_MAX];
+		const struct lodge_image *level_src[LODGE_IMAGE_MIPS_CHAINS_MAX];
+		for(uint32_t i = 0; i < chains_count; i++) {
+			dst[i] = &chains[i][level];
+			level_src[i] = &chains[i][level - 1];
+		}
+
+		if(!lodge_image_mips_downsample(dst, level_src, filters, chains_count, srgb, desc.jobs)) {
+			ok = false;
+			break;
+		}
+		mips->levels_count++;
+	}
+
+	free(srgb);
+
+	if(!ok) {
+		lodge_image_mips_free_inplace(mips);
+	}
+	return ok;
+}
+
+void lodge_image_mips_free_inplace(struct lodge_image_mips *mips)
+{
+	for(uint32_t level = 0; level < mips->levels_count; level++) {
+		if(mips->levels[level].pixel_data) {
+			lodge_image_free(&mips->levels[level]);
+		}
+		if(mips->levels_min[level].pixel_data) {
+			lodge_image_free(&mips->levels_min[level]);
+		}
+		if(mips->levels_max[level].pixel_data) {
+			lodge_image_free(&mips->levels_max[level]);
+		}
+	}
+	memset(mips, 0, sizeof(struct lodge_image_mips));
+}
+
+bool lodge_image_mips_downsample_inplace(struct lodge_image *dst, const struct lodge_image *src, enum lodge_image_mips_filter filter, uint32_t flags, struct lodge_jobs *jobs)
+{
+	ASSERT(dst);
+	*dst = (struct lodge_image) { 0 };
+
+	ASSERT_OR(src && src->pixel_data && filter != LODGE_IMAGE_MIPS_FILTER_NONE) {
+		return false;
+	}
+	ASSERT_OR(src->desc.bytes_per_channel == 1 || src->desc.bytes_per_channel == 2 || src->desc.bytes_per_channel == 4) {
+		return false;
+	}
+
+	struct lodge_image_mips_srgb *srgb = NULL;
+	if((flags & LODGE_IMAGE_MIPS_FLAG_SRGB) && src->desc.bytes_per_channel != 4) {
+		srgb = malloc(sizeof(struct lodge_image_mips_srgb));
+		ASSERT_OR(srgb) {
+			return false;
+		}
+		lodge_image_mips_srgb_make(srgb);
+	}
+
+	const bool ok = lodge_image_mips_downsample(&dst, &src, &filter, 1, srgb, jobs);
+	free(srgb);
+	return ok;
+}
@@ -0,0 +1,306 @@
+//
+// Mip chains of a 9x5 image against golden values for every filter and pixel format. The
+// goldens come from the filter definitions evaluated in double precision: box and min/max over
+// the exact footprint of each destination texel, Kaiser taps as in `lodge_image_mips.c`,
+// sRGB averaged in linear space with alpha left alone. Both sizes are odd all the way down
+// (9x5, 4x2, 2x1, 1x1), so no level is a plain 2x2 average.
+//
+
+#include "lodge_image_mips.h"
+
+#include "lodge_platform.h"
+#include "lodge_test.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+#define TEST_WIDTH			9
+#define TEST_HEIGHT			5
+#define TEST_LEVELS			4
+
+//
+// Levels 1 to 3 of each chain, back to back.
+//
+
+static const float test_golden_box_u8[] = {
+	83, 162, 120, 130, 128, 116, 109, 119, 115, 148, 107, 141, 117, 128, 144, 154,
+	106, 145, 125, 129,
+	116, 137,
+};
+
+static const float test_golden_box_u16[] = {
+	23317, 37308, 38940, 32543, 38544, 26320, 27952, 36118, 32545, 34885, 37289, 25066, 34752, 28354, 30758, 27273,
+	33023, 32451, 33002, 29516,
+	33013, 30984,
+};
+
+static const float test_golden_box_float[] = {
+	-2.469841f, 8.796825f, 2.825397f, 4.339682f, 4.057143f, 2.320635f, 1.225397f, 2.739683f, 2.088889f, 6.853968f, 1.034921f, 5.800000f, 2.419048f, 3.933333f, 6.241270f, 7.755555f,
+	0.869841f, 6.447619f, 3.485714f, 4.187302f,
+	2.177778f, 5.317460f,
+};
+
+static const float test_golden_kaiser_u8[] = {
+	85, 158, 119, 130, 125, 111, 109, 123, 122, 147, 107, 143, 113, 137, 144, 149,
+	108, 143, 123, 130,
+	116, 137,
+};
+
+static const float test_golden_kaiser_u16[] = {
+	24328, 35708, 38821, 33066, 39577, 26577, 28503, 36634, 34883, 34257, 37305, 25765, 35035, 29806, 31308, 26234,
+	34198, 31944, 34121, 29580,
+	34160, 30762,
+};
+
+static const float test_golden_kaiser_float[] = {
+	-2.198743f, 8.327985f, 2.762655f, 4.218684f, 3.545969f, 1.585336f, 1.241079f, 3.230350f, 3.173337f, 6.776524f, 0.995470f, 6.171269f, 1.797252f, 5.255742f, 6.354436f, 7.040139f,
+	1.169514f, 6.169459f, 3.263070f, 4.256386f,
+	2.216292f, 5.212923f,
+};
+
+static const float test_golden_min_u8[] = {
+	0, 28, 12, 5, 8, 5, 3, 22, 12, 62, 5, 42, 5, 14, 8, 14,
+	0, 5, 3, 5,
+	0, 5,
+};
+
+static const float test_golden_min_u16[] = {
+	0, 4497, 11827, 4367, 10525, 1196, 4275, 8630, 8181, 4497, 8656, 24, 8656, 1196, 2804, 2908,
+	0, 24, 2804, 1196,
+	0, 24,
+};
+
+static const float test_golden_min_float[] = {
+	-14.285714f, -10.285714f, -12.571428f, -13.571428f, -13.142858f, -13.571428f, -13.857142f, -11.142858f, -12.571428f, -5.428571f, -13.571428f, -8.285714f, -13.571428f, -12.285714f, -13.142858f, -12.285714f,
+	-14.285714f, -13.571428f, -13.857142f, -13.571428f,
+	-14.285714f, -13.571428f,
+};
+
+static const float test_golden_max_u8[] = {
+	205, 255, 221, 251, 222, 251, 222, 247, 213, 255, 206, 251, 217, 251, 233, 252,
+	221, 255, 233, 252,
+	233, 255,
+};
+
+static const float test_golden_max_u16[] = {
+	64916, 61232, 64916, 59930, 64851, 54285, 61615, 62956, 64916, 59440, 64916, 54285, 62917, 54285, 61615, 54760,
+	64916, 61232, 64851, 62956,
+	64916, 62956,
+};
+
+static const float test_golden_max_float[] = {
+	15.000000f, 22.142857f, 17.285715f, 21.571428f, 17.428572f, 21.571428f, 17.428572f, 21.000000f, 16.142857f, 22.142857f, 15.142858f, 21.571428f, 16.714285f, 21.571428f, 19.000000f, 21.714285f,
+	17.285715f, 22.142857f, 19.000000f, 21.714285f,
+	19.000000f, 22.142857f,
+};
+
+static const float test_golden_box_srgb_u8[] = {
+	107, 176, 135, 143, 141, 156, 150, 157, 150, 143, 157, 109, 139, 141, 155, 135, 141, 166, 164, 118, 132, 162, 143, 111, 142, 151, 150, 132, 165, 174, 144, 136,
+	131, 165, 148, 132, 149, 153, 152, 128,
+	140, 159, 150, 130,
+};
+
+static const float test_golden_box_srgb_u16[] = {
+	29952, 42234, 36559, 37620, 43262, 39298, 38287, 32854, 43623, 32326, 38714, 32457, 35194, 41105, 41388, 30604, 39011, 39772, 34364, 35197, 42352, 31993, 37463, 31203, 40341, 35065, 35557, 37403, 37804, 33412, 42689, 36322,
+	39093, 38564, 36705, 34219, 39399, 35684, 39707, 34197,
+	39246, 37160, 38244, 34208,
+};
+
+static const float test_golden_kaiser_srgb_u8[] = {
+	110, 174, 132, 144, 139, 156, 149, 157, 148, 139, 162, 112, 139, 144, 155, 133, 146, 167, 165, 119, 132, 163, 142, 109, 138, 159, 149, 136, 165, 171, 140, 141,
+	132, 164, 149, 131, 148, 154, 151, 131,
+	140, 159, 150, 131,
+};
+
+struct test_golden
+{
+	const char						*name;
+	enum lodge_image_mips_filter	filter;
+	uint32_t						flags;
+	uint8_t							bytes_per_channel;
+	uint8_t							channels;
+	const float						*expected;
+	size_t							expected_count;
+};
+
+#define TEST_GOLDEN(name, filter, flags, bytes_per_channel, channels, expected) \
+	{ name, filter, flags, bytes_per_channel, channels, expected, LODGE_ARRAYSIZE(expected) }
+
+static const struct test_golden test_goldens[] = {
+	TEST_GOLDEN("box u8", LODGE_IMAGE_MIPS_FILTER_BOX, 0, 1, 2, test_golden_box_u8),
+	TEST_GOLDEN("box u16", LODGE_IMAGE_MIPS_FILTER_BOX, 0, 2, 2, test_golden_box_u16),
+	TEST_GOLDEN("box float", LODGE_IMAGE_MIPS_FILTER_BOX, 0, 4, 2, test_golden_box_float),
+	TEST_GOLDEN("kaiser u8", LODGE_IMAGE_MIPS_FILTER_KAISER, 0, 1, 2, test_golden_kaiser_u8),
+	TEST_GOLDEN("kaiser u16", LODGE_IMAGE_MIPS_FILTER_KAISER, 0, 2, 2, test_golden_kaiser_u16),
+	TEST_GOLDEN("kaiser float", LODGE_IMAGE_MIPS_FILTER_KAISER, 0, 4, 2, test_golden_kaiser_float),
+	TEST_GOLDEN("min u8", LODGE_IMAGE_MIPS_FILTER_MIN, 0, 1, 2, test_golden_min_u8),
+	TEST_GOLDEN("min u16", LODGE_IMAGE_MIPS_FILTER_MIN, 0, 2, 2, test_golden_min_u16),
+	TEST_GOLDEN("min float", LODGE_IMAGE_MIPS_FILTER_MIN, 0, 4, 2, test_golden_min_float),
+	TEST_GOLDEN("max u8", LODGE_IMAGE_MIPS_FILTER_MAX, 0, 1, 2, test_golden_max_u8),
+	TEST_GOLDEN("max u16", LODGE_IMAGE_MIPS_FILTER_MAX, 0, 2, 2, test_golden_max_u16),
+	TEST_GOLDEN("max float", LODGE_IMAGE_MIPS_FILTER_MAX, 0, 4, 2, test_golden_max_float),
+	TEST_GOLDEN("box srgb u8", LODGE_IMAGE_MIPS_FILTER_BOX, LODGE_IMAGE_MIPS_FLAG_SRGB, 1, 4, test_golden_box_srgb_u8),
+	TEST_GOLDEN("box srgb u16", LODGE_IMAGE_MIPS_FILTER_BOX, LODGE_IMAGE_MIPS_FLAG_SRGB, 2, 4, test_golden_box_srgb_u16),
+	TEST_GOLDEN("kaiser srgb u8", LODGE_IMAGE_MIPS_FILTER_KAISER, LODGE_IMAGE_MIPS_FLAG_SRGB, 1, 4, test_golden_kaiser_srgb_u8),
+
+	//
+	// Float images are linear already.
+	//
+	TEST_GOLDEN("box srgb float", LODGE_IMAGE_MIPS_FILTER_BOX, LODGE_IMAGE_MIPS_FLAG_SRGB, 4, 2, test_golden_box_float),
+};
+
+//
+// Integer patterns with no structure a filter could get lucky on; float is the 8-bit pattern
+// moved to [-14.3, 22.1].
+//
+static struct lodge_image test_image_make(uint8_t bytes_per_channel, uint8_t channels)
+{
+	struct lodge_image image = {
+		.desc = {
+			.width = TEST_WIDTH,
+			.height = TEST_HEIGHT,
+			.channels = channels,
+			.bytes_per_channel = bytes_per_channel,
+		},
+	};
+	image.pixel_data = malloc(lodge_image_desc_get_data_size(&image.desc));
+
+	size_t i = 0;
+	for(uint32_t y = 0; y < TEST_HEIGHT; y++) {
+		for(uint32_t x = 0; x < TEST_WIDTH; x++) {
+			for(uint32_t c = 0; c < channels; c++, i++) {
+				const uint32_t code = (x * 37 + y * 71 + c * 113 + x * y * 13) % 256;
+				if(bytes_per_channel == 1) {
+					image.pixel_data[i] = (uint8_t)code;
+				} else if(bytes_per_channel == 2) {
+					((uint16_t *)image.pixel_data)[i] = (uint16_t)((x * 9973 + y * 20011 + c * 30011 + x * y * 1237) % 65536);
+				} else {
+					((float *)image.pixel_data)[i] = ((float)code - 100.0f) / 7.0f;
+				}
+			}
+		}
+	}
+
+	return image;
+}
+
+static float test_image_get(const struct lodge_image *image, size_t i)
+{
+	switch(image->desc.bytes_per_channel) {
+	case 1:
+		return image->pixel_data[i];
+	case 2:
+		return ((const uint16_t *)image->pixel_data)[i];
+	default:
+		return ((const float *)image->pixel_data)[i];
+	}
+}
+
+//
+// Normalized formats must match the golden codes exactly; floats are filtered in single
+// precision.
+//
+static bool test_level_matches(const struct lodge_image *level, const struct test_golden *golden, uint32_t level_index, size_t *offset)
+{
+	uint32_t width = TEST_WIDTH;
+	uint32_t height = TEST_HEIGHT;
+	for(uint32_t i = 0; i < level_index; i++) {
+		width = max(width / 2, 1u);
+		height = max(height / 2, 1u);
+	}
+
+	const size_t count = (size_t)width * height * golden->channels;
+	const float tolerance = golden->bytes_per_channel == 4 ? 1e-4f : 0.0f;
+
+	bool matches = level->desc.width == width
+		&& level->desc.height == height
+		&& level->desc.channels == golden->channels
+		&& level->desc.bytes_per_channel == golden->bytes_per_channel
+		&& *offset + count <= golden->expected_count;
+
+	for(size_t i = 0; matches && i < count; i++) {
+		const float value = test_image_get(level, i);
+		const float expected = golden->expected[*offset + i];
+		if(fabsf(value - expected) > tolerance) {
+			fprintf(stderr, "%s, level %u, value %zu: %g, expected %g\n", golden->name, level_index, i, value, expected);
+			matches = false;
+		}
+	}
+
+	*offset += count;
+	return matches;
+}
+
+static void test_mips_match_goldens()
+{
+	for(size_t g = 0; g < LODGE_ARRAYSIZE(test_goldens); g++) {
+		const struct test_golden *golden = &test_goldens[g];
+		struct lodge_image src = test_image_make(golden->bytes_per_channel, golden->channels);
+
+		struct lodge_image_mips mips;
+		const bool created = lodge_image_mips_new_inplace(&mips, &src, (struct lodge_image_mips_desc) {
+			.filter = golden->filter,
+			.flags = golden->flags,
+		});
+		LODGE_TEST_CHECK_MSG(created, "%s", golden->name);
+		LODGE_TEST_CHECK_MSG(mips.levels_count == TEST_LEVELS, "%s: %u levels", golden->name, mips.levels_count);
+
+		size_t offset = 0;
+		for(uint32_t level = 1; level < min(mips.levels_count, TEST_LEVELS); level++) {
+			LODGE_TEST_CHECK_MSG(test_level_matches(&mips.levels[level], golden, level, &offset), "%s, level %u", golden->name, level);
+		}
+		LODGE_TEST_CHECK_MSG(offset == golden->expected_count, "%s: %zu of %zu values compared", golden->name, offset, golden->expected_count);
+
+		lodge_image_mips_free_inplace(&mips);
+
+		//
+		// One level on its own is the first level of the chain.
+		//
+		struct lodge_image level;
+		LODGE_TEST_CHECK_MSG(lodge_image_mips_downsample_inplace(&level, &src, golden->filter, golden->flags, NULL), "%s", golden->name);
+		offset = 0;
+		LODGE_TEST_CHECK_MSG(test_level_matches(&level, golden, 1, &offset), "%s, downsample", golden->name);
+		lodge_image_free(&level);
+
+		free(src.pixel_data);
+	}
+}
+
+//
+// Min and max chains built alongside a filtered chain, in the same pass, match the goldens of
+// the min and max filters on their own.
+//
+static void test_mips_min_max_flags_match_goldens()
+{
+	for(size_t g = 0; g < LODGE_ARRAYSIZE(test_goldens); g++) {
+		const struct test_golden *golden = &test_goldens[g];
+		if(golden->filter != LODGE_IMAGE_MIPS_FILTER_MIN && golden->filter != LODGE_IMAGE_MIPS_FILTER_MAX) {
+			continue;
+		}
+
+		struct lodge_image src = test_image_make(golden->bytes_per_channel, golden->channels);
+
+		struct lodge_image_mips mips;
+		const bool created = lodge_image_mips_new_inplace(&mips, &src, (struct lodge_image_mips_desc) {
+			.filter = LODGE_IMAGE_MIPS_FILTER_KAISER,
+			.flags = LODGE_IMAGE_MIPS_FLAG_SRGB | LODGE_IMAGE_MIPS_FLAG_MIN | LODGE_IMAGE_MIPS_FLAG_MAX,
+		});
+		LODGE_TEST_CHECK_MSG(created && mips.levels_count == TEST_LEVELS, "%s", golden->name);
+
+		const struct lodge_image *levels = golden->filter == LODGE_IMAGE_MIPS_FILTER_MIN ? mips.levels_min : mips.levels_max;
+		size_t offset = 0;
+		for(uint32_t level = 1; level < min(mips.levels_count, TEST_LEVELS); level++) {
+			LODGE_TEST_CHECK_MSG(test_level_matches(&levels[level], golden, level, &offset), "%s flag, level %u", golden->name, level);
+		}
+
+		lodge_image_mips_free_inplace(&mips);
+		free(src.pixel_data);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	LODGE_TEST_RUN(test_mips_match_goldens);
+	LODGE_TEST_RUN(test_mips_min_max_flags_match_goldens);
+	return lodge_test_result();
+}
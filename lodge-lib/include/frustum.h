@@ -26,6 +26,27 @@ struct frustum_planes	frustum_planes_make(const mat4 view_proj);
 bool					frustum_planes_vs_aabb(struct frustum_planes *frustum, struct aabb aabb);
 bool					frustum_planes_vs_sphere(struct frustum_planes *frustum, struct sphere *sphere);
 
+//
+// Axis aligned boxes as centers and half extents, one array per component, so many of
+// them can be tested against the same planes at once.
+//
+struct frustum_aabbs_soa
+{
+	size_t				count;
+	const float			*center_x;
+	const float			*center_y;
+	const float			*center_z;
+	const float			*extent_x;
+	const float			*extent_y;
+	const float			*extent_z;
+};
+
+//
+// `frustum_planes_vs_aabb()` for every box in `aabbs`: writes 1 to `visible[i]` if box `i`
+// may intersect the frustum, otherwise 0. Returns the number of visible boxes.
+//
+size_t					frustum_planes_cull_aabbs(const struct frustum_planes *frustum, const struct frustum_aabbs_soa *aabbs, uint8_t *visible);
+
 struct frustum_corners
 {
 	vec3 vertices[8];
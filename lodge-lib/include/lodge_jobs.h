@@ -0,0 +1,46 @@
+#ifndef _LODGE_JOBS_H
+#define _LODGE_JOBS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct lodge_jobs;
+typedef struct lodge_jobs* lodge_jobs_t;
+
+typedef void				(*lodge_job_func_t)(void *userdata);
+
+//
+// Tracks completion of a group of submitted jobs. Zero-initialize before
+// first use; it can be reused once it has been waited on.
+//
+struct lodge_job_counter
+{
+	volatile int32_t		pending;
+};
+
+//
+// A pool of worker threads consuming a FIFO job queue.
+//
+// With `threads_count == 0` (or a NULL pool) every job runs inline on the
+// submitting thread, which gives a deterministic single-threaded fallback
+// without callers having to special-case it.
+//
+lodge_jobs_t				lodge_jobs_new(uint32_t threads_count);
+void						lodge_jobs_free(lodge_jobs_t jobs);
+uint32_t					lodge_jobs_get_threads_count(lodge_jobs_t jobs);
+
+//
+// Jobs may submit other jobs. `counter` is optional.
+//
+void						lodge_jobs_submit(lodge_jobs_t jobs, lodge_job_func_t func, void *userdata, struct lodge_job_counter *counter);
+
+//
+// Blocks until all jobs tracked by `counter` have finished, or all jobs in
+// the pool if `counter` is NULL. The calling thread helps out by running
+// queued jobs while it waits.
+//
+void						lodge_jobs_wait(lodge_jobs_t jobs, struct lodge_job_counter *counter);
+
+bool						lodge_job_counter_is_done(struct lodge_job_counter *counter);
+
+#endif
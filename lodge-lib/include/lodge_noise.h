@@ -1,9 +1,64 @@
 #ifndef _LODGE_NOISE_H
 #define _LODGE_NOISE_H
 
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
 float lodge_noise_simplex_1d(float x);
 float lodge_noise_simplex_2d(float x, float y);
 float lodge_noise_simplex_3d(float x, float y, float z);
 float lodge_noise_simplex_4d(float x, float y, float z, float w);
 
-#endif
\ No newline at end of file
+//
+// Batches of 2D simplex noise, same as `lodge_noise_simplex_2d()` up to float rounding.
+//
+// They run on the widest instruction set the CPU supports, picked on first use.
+//
+enum lodge_noise_simd
+{
+	LODGE_NOISE_SIMD_SCALAR = 0,
+	LODGE_NOISE_SIMD_SSE2,
+	LODGE_NOISE_SIMD_AVX2,
+	LODGE_NOISE_SIMD_MAX,
+};
+
+enum lodge_noise_simd	lodge_noise_get_simd();
+
+//
+// Forces an instruction set (for testing); returns false if the CPU does not support it.
+//
+bool					lodge_noise_set_simd(enum lodge_noise_simd simd);
+
+//
+// `dst[i]` is the noise at `x[i], y[i]`.
+//
+void					lodge_noise_simplex_2d_n(float *dst, const float *x, const float *y, size_t count);
+
+//
+// `width * height` samples, row major; sample `x, y` is at `origin + (x, y) * step`.
+//
+void					lodge_noise_simplex_2d_grid(float *dst, uint32_t width, uint32_t height, float origin_x, float origin_y, float step_x, float step_y);
+
+//
+// Octave `i` samples at `frequency * lacunarity^i` with amplitude `gain^i`.
+//
+struct lodge_noise_fractal_desc
+{
+	uint32_t			octaves;
+	float				frequency;
+	float				lacunarity;
+	float				gain;
+};
+
+//
+// Sum of the octaves, divided by the sum of the amplitudes: [-1, 1].
+//
+void					lodge_noise_fbm_2d_grid(float *dst, uint32_t width, uint32_t height, float origin_x, float origin_y, float step_x, float step_y, struct lodge_noise_fractal_desc desc);
+
+//
+// Like fBm, of `(1 - |noise|)^2` instead: [0, 1], with sharp ridges where the noise crosses 0.
+//
+void					lodge_noise_ridged_2d_grid(float *dst, uint32_t width, uint32_t height, float origin_x, float origin_y, float step_x, float step_y, struct lodge_noise_fractal_desc desc);
+
+#endif
@@ -5,12 +5,144 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>
+
+#define LODGE_QUADTREE_LEVELS_MAX		16
+#define LODGE_QUADTREE_NODE_NONE		UINT32_MAX
 
 //
 // If this function returns false, it means the node is a leaf.
 //
 typedef bool (*lodge_quadtree_leaf_func_t)(const uint32_t level, const vec2 center, const vec2 size, void *userdata);
 
+//
+// Builds the tree from scratch, keeping no state between calls.
+//
 void lodge_quadtree_make(const vec2 center, const vec2 size, lodge_quadtree_leaf_func_t is_leaf, void *userdata);
 
-#endif
\ No newline at end of file
+//
+// Persistent quadtree, updated in place.
+//
+// Nodes live in a flat pool where the 4 children of a node are stored next to each other in
+// Morton order (SW, SE, NW, NE, with y going up), so visiting the leaves walks them along a
+// Z-curve. Node indices are stable for as long as the node exists; the root is always 0.
+//
+// Leaves are split when their metric reaches `split_threshold`, and children are merged when
+// their parent drops below `merge_threshold`. Keeping `merge_threshold` below
+// `split_threshold` stops nodes from popping back and forth around a single threshold.
+//
+struct lodge_quadtree_desc
+{
+	vec2						center;
+	vec2						size;
+	uint32_t					levels_max;			// Leaves never go deeper than this.
+	float						split_threshold;
+	float						merge_threshold;
+};
+
+struct lodge_quadtree_node
+{
+	uint32_t					children;			// First of the 4 children, or 0 for leaves.
+	uint32_t					parent;				// LODGE_QUADTREE_NODE_NONE for the root.
+	uint16_t					x;					// In the grid of `level`.
+	uint16_t					y;
+	uint8_t						level;
+	float						metric;				// From the last update that reached the node.
+};
+
+struct lodge_quadtree
+{
+	struct lodge_quadtree_desc	desc;
+
+	size_t						count;
+	size_t						capacity;
+	struct lodge_quadtree_node	*elements;
+
+	//
+	// Unused blocks of 4 children in `elements`.
+	//
+	struct
+	{
+		size_t					count;
+		size_t					capacity;
+		uint32_t				*elements;
+	}							free_blocks;
+
+	uint32_t					leaves_count;
+
+	//
+	// Node size per level, so finding where a node is costs no divisions.
+	//
+	vec2						level_sizes[LODGE_QUADTREE_LEVELS_MAX + 1];
+
+	//
+	// From the last update.
+	//
+	uint32_t					splits;
+	uint32_t					merges;
+	uint32_t					evaluated;
+};
+
+//
+// Returns the metric to compare against the split/merge thresholds. Negative metrics mark
+// nodes that should not be refined at all (eg. outside the view): they are never split, and
+// their children are merged.
+//
+// Node indices are stable, so the metric can cache per-node data (eg. bounds) by index; a block
+// of freed children may later be reused for a different node though.
+//
+typedef float (*lodge_quadtree_metric_func_t)(const struct lodge_quadtree *tree, uint32_t node_index, void *userdata);
+
+//
+// Return false to skip the children of `node`.
+//
+typedef bool (*lodge_quadtree_visit_func_t)(const struct lodge_quadtree *tree, uint32_t node_index, void *userdata);
+
+void							lodge_quadtree_new_inplace(struct lodge_quadtree *tree, struct lodge_quadtree_desc desc);
+void							lodge_quadtree_free_inplace(struct lodge_quadtree *tree);
+
+//
+// Collapses the tree back to just the root.
+//
+void							lodge_quadtree_reset(struct lodge_quadtree *tree);
+
+//
+// Re-evaluates the metric of every node reached from the root, splitting and merging nodes
+// where it crosses the thresholds. Subtrees that do not change keep their nodes.
+//
+// `leaf` (optional) is called for every leaf of the updated tree, in the same order as
+// `lodge_quadtree_visit()` (its return value is ignored). Collecting the leaves this way saves
+// walking the tree a second time.
+//
+void							lodge_quadtree_update(struct lodge_quadtree *tree, lodge_quadtree_metric_func_t metric, lodge_quadtree_visit_func_t leaf, void *userdata);
+
+//
+// Depth first, children in Morton order.
+//
+void							lodge_quadtree_visit(const struct lodge_quadtree *tree, lodge_quadtree_visit_func_t visit, void *userdata);
+
+//
+// The leaf containing `pos`, or LODGE_QUADTREE_NODE_NONE if it is outside the tree.
+//
+uint32_t						lodge_quadtree_find_leaf(const struct lodge_quadtree *tree, vec2 pos);
+
+static inline bool				lodge_quadtree_node_is_leaf(const struct lodge_quadtree_node *node) { return node->children == 0; }
+
+//
+// These are called for every node on every update, so they are inlined.
+//
+static inline vec2 lodge_quadtree_node_size(const struct lodge_quadtree *tree, const struct lodge_quadtree_node *node)
+{
+	return tree->level_sizes[node->level];
+}
+
+static inline vec2 lodge_quadtree_node_center(const struct lodge_quadtree *tree, const struct lodge_quadtree_node *node)
+{
+	const vec2 size = tree->level_sizes[node->level];
+	return (vec2) {
+		.x = tree->desc.center.x - tree->desc.size.x * 0.5f + (node->x + 0.5f) * size.x,
+		.y = tree->desc.center.y - tree->desc.size.y * 0.5f + (node->y + 0.5f) * size.y,
+	};
+}
+
+#endif
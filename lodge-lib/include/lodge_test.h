@@ -0,0 +1,114 @@
+#ifndef _LODGE_TEST_H
+#define _LODGE_TEST_H
+
+#include "math4.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+//
+// Checks for the test executables in `<module>/test/`.
+//
+// A failed check prints where it failed and keeps going, so one run reports
+// every failure. `main` returns `lodge_test_result()`.
+//
+static int lodge_test_failures = 0;
+
+#define LODGE_TEST_CHECK(expr) \
+	do { \
+		if(!(expr)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+			lodge_test_failures++; \
+		} \
+	} while(0)
+
+#define LODGE_TEST_CHECK_MSG(expr, ...) \
+	do { \
+		if(!(expr)) { \
+			fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__, __LINE__, #expr); \
+			fprintf(stderr, __VA_ARGS__); \
+			fprintf(stderr, "\n"); \
+			lodge_test_failures++; \
+		} \
+	} while(0)
+
+#define LODGE_TEST_RUN(func) \
+	do { \
+		const int lodge_test_failures_before = lodge_test_failures; \
+		func(); \
+		printf("%s %s\n", (lodge_test_failures == lodge_test_failures_before) ? "ok  " : "FAIL", #func); \
+	} while(0)
+
+static inline int lodge_test_result()
+{
+	return lodge_test_failures ? 1 : 0;
+}
+
+//
+// Deterministic random numbers for generating test data, the same sequence on every
+// platform. The sequence starts from seed 1 unless `lodge_test_random_seed()` is called.
+//
+static uint32_t lodge_test_random_state = 1;
+
+static inline void lodge_test_random_seed(uint32_t seed)
+{
+	lodge_test_random_state = seed;
+}
+
+static inline float lodge_test_random(float lo, float hi)
+{
+	lodge_test_random_state = lodge_test_random_state * 1664525u + 1013904223u;
+	return lo + (hi - lo) * (float)(lodge_test_random_state >> 8) / (float)(1u << 24);
+}
+
+//
+// Distance from `p` to the triangle `abc`, through the closest point on it from Ericson's
+// "Real-Time Collision Detection". For checking surfaces against a reference.
+//
+static inline double lodge_test_distance_to_triangle(vec3 p, vec3 a, vec3 b, vec3 c)
+{
+	const vec3 ab = vec3_sub(b, a);
+	const vec3 ac = vec3_sub(c, a);
+	const vec3 ap = vec3_sub(p, a);
+	const double d1 = vec3_dot(ab, ap);
+	const double d2 = vec3_dot(ac, ap);
+	if(d1 <= 0.0 && d2 <= 0.0) {
+		return vec3_distance(p, a);
+	}
+
+	const vec3 bp = vec3_sub(p, b);
+	const double d3 = vec3_dot(ab, bp);
+	const double d4 = vec3_dot(ac, bp);
+	if(d3 >= 0.0 && d4 <= d3) {
+		return vec3_distance(p, b);
+	}
+
+	const double vc = d1 * d4 - d3 * d2;
+	if(vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) {
+		return vec3_distance(p, vec3_add(a, vec3_mult_scalar(ab, (float)(d1 / (d1 - d3)))));
+	}
+
+	const vec3 cp = vec3_sub(p, c);
+	const double d5 = vec3_dot(ab, cp);
+	const double d6 = vec3_dot(ac, cp);
+	if(d6 >= 0.0 && d5 <= d6) {
+		return vec3_distance(p, c);
+	}
+
+	const double vb = d5 * d2 - d1 * d6;
+	if(vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) {
+		return vec3_distance(p, vec3_add(a, vec3_mult_scalar(ac, (float)(d2 / (d2 - d6)))));
+	}
+
+	const double va = d3 * d6 - d5 * d4;
+	if(va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0) {
+		const double w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		return vec3_distance(p, vec3_add(b, vec3_mult_scalar(vec3_sub(c, b), (float)w)));
+	}
+
+	const double denominator = 1.0 / (va + vb + vc);
+	const vec3 q = vec3_add(a, vec3_add(vec3_mult_scalar(ab, (float)(vb * denominator)), vec3_mult_scalar(ac, (float)(vc * denominator))));
+	return vec3_distance(p, q);
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef _LODGE_THREAD_H
+#define _LODGE_THREAD_H
+
+#include <stdint.h>
+
+struct lodge_thread;
+typedef struct lodge_thread* lodge_thread_t;
+
+struct lodge_mutex;
+typedef struct lodge_mutex* lodge_mutex_t;
+
+struct lodge_cond;
+typedef struct lodge_cond* lodge_cond_t;
+
+typedef void			(*lodge_thread_func_t)(void *userdata);
+
+lodge_thread_t			lodge_thread_new(lodge_thread_func_t func, void *userdata);
+void					lodge_thread_join(lodge_thread_t thread);
+uint32_t				lodge_thread_get_hardware_concurrency();
+
+lodge_mutex_t			lodge_mutex_new();
+void					lodge_mutex_free(lodge_mutex_t mutex);
+void					lodge_mutex_lock(lodge_mutex_t mutex);
+void					lodge_mutex_unlock(lodge_mutex_t mutex);
+
+lodge_cond_t			lodge_cond_new();
+void					lodge_cond_free(lodge_cond_t cond);
+void					lodge_cond_wait(lodge_cond_t cond, lodge_mutex_t mutex);
+void					lodge_cond_signal(lodge_cond_t cond);
+void					lodge_cond_broadcast(lodge_cond_t cond);
+
+//
+// Sequentially consistent atomics. `add` returns the new value.
+//
+int32_t					lodge_atomic_add_i32(volatile int32_t *dst, int32_t value);
+int32_t					lodge_atomic_load_i32(volatile int32_t *src);
+void					lodge_atomic_store_i32(volatile int32_t *dst, int32_t value);
+
+#endif
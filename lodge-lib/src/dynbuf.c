@@ -22,7 +22,7 @@ static void dynbuf_maybe_grow(dynbuf_t dst, size_t new_count)
 	if(!*dst.ptr || (new_count >= *dst.capacity)) {
 		size_t new_capacity = max(*dst.capacity, DYNBUF_CAPACITY_MIN);
 
-		if(new_count >= new_capacity) {
+		while(new_count >= new_capacity) {
 			new_capacity <<= 1;
 		}
 
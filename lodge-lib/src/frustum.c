@@ -1,6 +1,12 @@
 #include "frustum.h"
 
 #include <float.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_SSE2
+#include <emmintrin.h>
+#endif
 
 struct frustum_planes frustum_planes_make(const mat4 view_proj)
 {
@@ -22,20 +28,20 @@ struct frustum_planes frustum_planes_make(const mat4 view_proj)
 bool frustum_planes_vs_aabb(struct frustum_planes *frustum, struct aabb aabb)
 {
 	//
-    // Check box outside/inside of frustum
+	// Check box outside/inside of frustum: the box is outside a plane when its corner furthest
+	// along the plane normal is, which is the same as testing all 8 corners.
 	//
-    for(int i=0; i < FRUSTUM_PLANE_MAX; i++) {
-        int out = 0;
-        out += ((vec4_dot( frustum->planes[i], vec4_make(aabb.min.x, aabb.min.y, aabb.min.z, 1.0f) ) < 0.0 ) ? 1 : 0);
-        out += ((vec4_dot( frustum->planes[i], vec4_make(aabb.max.x, aabb.min.y, aabb.min.z, 1.0f) ) < 0.0 ) ? 1 : 0);
-        out += ((vec4_dot( frustum->planes[i], vec4_make(aabb.min.x, aabb.max.y, aabb.min.z, 1.0f) ) < 0.0 ) ? 1 : 0);
-        out += ((vec4_dot( frustum->planes[i], vec4_make(aabb.max.x, aabb.max.y, aabb.min.z, 1.0f) ) < 0.0 ) ? 1 : 0);
-        out += ((vec4_dot( frustum->planes[i], vec4_make(aabb.min.x, aabb.min.y, aabb.max.z, 1.0f) ) < 0.0 ) ? 1 : 0);
-        out += ((vec4_dot( frustum->planes[i], vec4_make(aabb.max.x, aabb.min.y, aabb.max.z, 1.0f) ) < 0.0 ) ? 1 : 0);
-        out += ((vec4_dot( frustum->planes[i], vec4_make(aabb.min.x, aabb.max.y, aabb.max.z, 1.0f) ) < 0.0 ) ? 1 : 0);
-        out += ((vec4_dot( frustum->planes[i], vec4_make(aabb.max.x, aabb.max.y, aabb.max.z, 1.0f) ) < 0.0 ) ? 1 : 0);
-        if( out==8 ) return false;
-    }
+	const vec3 center = vec3_make((aabb.min.x + aabb.max.x) * 0.5f, (aabb.min.y + aabb.max.y) * 0.5f, (aabb.min.z + aabb.max.z) * 0.5f);
+	const vec3 extent = vec3_make((aabb.max.x - aabb.min.x) * 0.5f, (aabb.max.y - aabb.min.y) * 0.5f, (aabb.max.z - aabb.min.z) * 0.5f);
+
+	for(int i = 0; i < FRUSTUM_PLANE_MAX; i++) {
+		const vec4 plane = frustum->planes[i];
+		const float d = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w
+			+ fabsf(plane.x) * extent.x + fabsf(plane.y) * extent.y + fabsf(plane.z) * extent.z;
+		if(d < 0.0f) {
+			return false;
+		}
+	}
 
 #if 0
 	//
@@ -62,6 +68,90 @@ bool frustum_planes_vs_sphere(struct frustum_planes *frustum, struct sphere *sph
 	return true;
 }
 
+//
+// A box is outside a plane if its corner furthest along the plane normal is behind it:
+// `dot(n, center) + w + dot(abs(n), extent) < 0`, which is the 8 corner test of
+// `frustum_planes_vs_aabb()` in one go.
+//
+struct frustum_planes_soa
+{
+	float x[FRUSTUM_PLANE_MAX];
+	float y[FRUSTUM_PLANE_MAX];
+	float z[FRUSTUM_PLANE_MAX];
+	float w[FRUSTUM_PLANE_MAX];
+	float abs_x[FRUSTUM_PLANE_MAX];
+	float abs_y[FRUSTUM_PLANE_MAX];
+	float abs_z[FRUSTUM_PLANE_MAX];
+};
+
+static bool frustum_planes_soa_vs_aabb(const struct frustum_planes_soa *planes, const struct frustum_aabbs_soa *aabbs, size_t i)
+{
+	for(int p = 0; p < FRUSTUM_PLANE_MAX; p++) {
+		const float d = planes->x[p] * aabbs->center_x[i] + planes->y[p] * aabbs->center_y[i] + planes->z[p] * aabbs->center_z[i] + planes->w[p]
+			+ planes->abs_x[p] * aabbs->extent_x[i] + planes->abs_y[p] * aabbs->extent_y[i] + planes->abs_z[p] * aabbs->extent_z[i];
+		if(d < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t frustum_planes_cull_aabbs(const struct frustum_planes *frustum, const struct frustum_aabbs_soa *aabbs, uint8_t *visible)
+{
+	struct frustum_planes_soa planes;
+	for(int p = 0; p < FRUSTUM_PLANE_MAX; p++) {
+		planes.x[p] = frustum->planes[p].x;
+		planes.y[p] = frustum->planes[p].y;
+		planes.z[p] = frustum->planes[p].z;
+		planes.w[p] = frustum->planes[p].w;
+		planes.abs_x[p] = fabsf(frustum->planes[p].x);
+		planes.abs_y[p] = fabsf(frustum->planes[p].y);
+		planes.abs_z[p] = fabsf(frustum->planes[p].z);
+	}
+
+	size_t visible_count = 0;
+	size_t i = 0;
+
+#if defined(FRUSTUM_SSE2)
+	//
+	// 4 boxes per iteration, in the same order of operations as the scalar tail.
+	//
+	for(; i + 4 <= aabbs->count; i += 4) {
+		const __m128 cx = _mm_loadu_ps(&aabbs->center_x[i]);
+		const __m128 cy = _mm_loadu_ps(&aabbs->center_y[i]);
+		const __m128 cz = _mm_loadu_ps(&aabbs->center_z[i]);
+		const __m128 ex = _mm_loadu_ps(&aabbs->extent_x[i]);
+		const __m128 ey = _mm_loadu_ps(&aabbs->extent_y[i]);
+		const __m128 ez = _mm_loadu_ps(&aabbs->extent_z[i]);
+
+		__m128 outside = _mm_setzero_ps();
+		for(int p = 0; p < FRUSTUM_PLANE_MAX; p++) {
+			__m128 d = _mm_mul_ps(_mm_set1_ps(planes.x[p]), cx);
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(planes.y[p]), cy));
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(planes.z[p]), cz));
+			d = _mm_add_ps(d, _mm_set1_ps(planes.w[p]));
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(planes.abs_x[p]), ex));
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(planes.abs_y[p]), ey));
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(planes.abs_z[p]), ez));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(d, _mm_setzero_ps()));
+		}
+
+		const int mask = ~_mm_movemask_ps(outside) & 0xf;
+		for(int j = 0; j < 4; j++) {
+			visible[i + j] = (mask >> j) & 1;
+		}
+		visible_count += (size_t)((mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1));
+	}
+#endif
+
+	for(; i < aabbs->count; i++) {
+		visible[i] = frustum_planes_soa_vs_aabb(&planes, aabbs, i) ? 1 : 0;
+		visible_count += visible[i];
+	}
+
+	return visible_count;
+}
+
 struct frustum_corners frustum_corners_make_ndc()
 {
 	return (struct frustum_corners) {
@@ -0,0 +1,212 @@
+#include "lodge_jobs.h"
+
+#include "lodge_thread.h"
+#include "lodge_platform.h"
+
+#include <string.h>
+
+#define LODGE_JOBS_THREADS_MAX			64
+#define LODGE_JOBS_QUEUE_CAPACITY_MIN	64
+
+struct lodge_job
+{
+	lodge_job_func_t			func;
+	void						*userdata;
+	struct lodge_job_counter	*counter;
+};
+
+struct lodge_job_queue
+{
+	size_t						head;
+	size_t						count;
+	size_t						capacity;
+	struct lodge_job			*elements;
+};
+
+struct lodge_jobs
+{
+	lodge_mutex_t				mutex;
+	lodge_cond_t				queued;
+	lodge_cond_t				finished;
+	bool						running;
+
+	struct lodge_job_queue		queue;
+	struct lodge_job_counter	all;
+
+	uint32_t					threads_count;
+	lodge_thread_t				threads[LODGE_JOBS_THREADS_MAX];
+};
+
+static void lodge_job_queue_push(struct lodge_job_queue *queue, const struct lodge_job *job)
+{
+	if(queue->count == queue->capacity) {
+		const size_t new_capacity = max(queue->capacity * 2, LODGE_JOBS_QUEUE_CAPACITY_MIN);
+		struct lodge_job *new_elements = (struct lodge_job *)malloc(new_capacity * sizeof(struct lodge_job));
+		ASSERT_OR(new_elements) { return; }
+
+		//
+		// Unwrap the ring so the queue starts at index 0 again.
+		//
+		for(size_t i = 0; i < queue->count; i++) {
+			new_elements[i] = queue->elements[(queue->head + i) % queue->capacity];
+		}
+
+		free(queue->elements);
+		queue->elements = new_elements;
+		queue->capacity = new_capacity;
+		queue->head = 0;
+	}
+
+	queue->elements[(queue->head + queue->count) % queue->capacity] = *job;
+	queue->count++;
+}
+
+static bool lodge_job_queue_pop(struct lodge_job_queue *queue, struct lodge_job *dst)
+{
+	if(queue->count == 0) {
+		return false;
+	}
+	*dst = queue->elements[queue->head];
+	queue->head = (queue->head + 1) % queue->capacity;
+	queue->count--;
+	return true;
+}
+
+//
+// Must be called without holding the pool mutex.
+//
+static void lodge_jobs_run(struct lodge_jobs *jobs, const struct lodge_job *job)
+{
+	job->func(job->userdata);
+
+	if(job->counter) {
+		lodge_atomic_add_i32(&job->counter->pending, -1);
+	}
+	lodge_atomic_add_i32(&jobs->all.pending, -1);
+
+	//
+	// Broadcast under the lock so a waiter that just checked its counter
+	// cannot miss the wakeup.
+	//
+	lodge_mutex_lock(jobs->mutex);
+	lodge_cond_broadcast(jobs->finished);
+	lodge_mutex_unlock(jobs->mutex);
+}
+
+static void lodge_jobs_worker(struct lodge_jobs *jobs)
+{
+	lodge_mutex_lock(jobs->mutex);
+	while(jobs->running) {
+		struct lodge_job job;
+		if(lodge_job_queue_pop(&jobs->queue, &job)) {
+			lodge_mutex_unlock(jobs->mutex);
+			lodge_jobs_run(jobs, &job);
+			lodge_mutex_lock(jobs->mutex);
+		} else {
+			lodge_cond_wait(jobs->queued, jobs->mutex);
+		}
+	}
+	lodge_mutex_unlock(jobs->mutex);
+}
+
+lodge_jobs_t lodge_jobs_new(uint32_t threads_count)
+{
+	struct lodge_jobs *jobs = (struct lodge_jobs *)calloc(1, sizeof(struct lodge_jobs));
+	ASSERT_OR(jobs) { return NULL; }
+
+	jobs->mutex = lodge_mutex_new();
+	jobs->queued = lodge_cond_new();
+	jobs->finished = lodge_cond_new();
+	jobs->running = true;
+
+	threads_count = min(threads_count, LODGE_JOBS_THREADS_MAX);
+	for(uint32_t i = 0; i < threads_count; i++) {
+		lodge_thread_t thread = lodge_thread_new((lodge_thread_func_t)&lodge_jobs_worker, jobs);
+		ASSERT_OR(thread) { break; }
+		jobs->threads[jobs->threads_count++] = thread;
+	}
+
+	return jobs;
+}
+
+void lodge_jobs_free(lodge_jobs_t jobs)
+{
+	if(!jobs) {
+		return;
+	}
+
+	lodge_jobs_wait(jobs, NULL);
+
+	lodge_mutex_lock(jobs->mutex);
+	jobs->running = false;
+	lodge_cond_broadcast(jobs->queued);
+	lodge_mutex_unlock(jobs->mutex);
+
+	for(uint32_t i = 0; i < jobs->threads_count; i++) {
+		lodge_thread_join(jobs->threads[i]);
+	}
+
+	lodge_cond_free(jobs->finished);
+	lodge_cond_free(jobs->queued);
+	lodge_mutex_free(jobs->mutex);
+	free(jobs->queue.elements);
+	free(jobs);
+}
+
+uint32_t lodge_jobs_get_threads_count(lodge_jobs_t jobs)
+{
+	return jobs ? jobs->threads_count : 0;
+}
+
+void lodge_jobs_submit(lodge_jobs_t jobs, lodge_job_func_t func, void *userdata, struct lodge_job_counter *counter)
+{
+	ASSERT_OR(func) { return; }
+
+	if(!jobs || jobs->threads_count == 0) {
+		func(userdata);
+		return;
+	}
+
+	if(counter) {
+		lodge_atomic_add_i32(&counter->pending, 1);
+	}
+	lodge_atomic_add_i32(&jobs->all.pending, 1);
+
+	lodge_mutex_lock(jobs->mutex);
+	lodge_job_queue_push(&jobs->queue, &(struct lodge_job) {
+		.func = func,
+		.userdata = userdata,
+		.counter = counter,
+	});
+	lodge_cond_signal(jobs->queued);
+	lodge_mutex_unlock(jobs->mutex);
+}
+
+void lodge_jobs_wait(lodge_jobs_t jobs, struct lodge_job_counter *counter)
+{
+	if(!jobs || jobs->threads_count == 0) {
+		return;
+	}
+
+	if(!counter) {
+		counter = &jobs->all;
+	}
+
+	lodge_mutex_lock(jobs->mutex);
+	while(lodge_atomic_load_i32(&counter->pending) > 0) {
+		struct lodge_job job;
+		if(lodge_job_queue_pop(&jobs->queue, &job)) {
+			lodge_mutex_unlock(jobs->mutex);
+			lodge_jobs_run(jobs, &job);
+			lodge_mutex_lock(jobs->mutex);
+		} else {
+			lodge_cond_wait(jobs->finished, jobs->mutex);
+		}
+	}
+	lodge_mutex_unlock(jobs->mutex);
+}
+
+bool lodge_job_counter_is_done(struct lodge_job_counter *counter)
+{
+	return counter ? lodge_atomic_load_i32(&counter->pending) == 0 : true;
+}
@@ -1,6 +1,59 @@
 #include "lodge_noise.h"
 
 #include "simplexnoise1234.h"
+#include "lodge_assert.h"
+#include "lodge_thread.h"
+#include "math4.h"
+
+#include <string.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LODGE_NOISE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(LODGE_NOISE_SSE2) && (defined(__GNUC__) || defined(_MSC_VER))
+#define LODGE_NOISE_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define LODGE_NOISE_TARGET_AVX2
+#else
+#define LODGE_NOISE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+//
+// Samples per call to the batch kernels from the grid and fractal helpers.
+//
+#define LODGE_NOISE_BATCH		256
+
+#define LODGE_NOISE_F2			0.366025403f
+#define LODGE_NOISE_G2			0.211324865f
+
+//
+// Same permutation as simplexnoise1234, repeated so `perm[i + perm[j]]` never wraps. As int32
+// so the AVX2 kernel can gather from it.
+//
+#define LODGE_NOISE_PERM \
+	151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23, \
+	190,6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,88,237,149,56,87,174, \
+	20,125,136,171,168,68,175,74,165,71,134,139,48,27,166,77,146,158,231,83,111,229,122,60,211,133, \
+	230,220,105,92,41,55,46,245,40,244,102,143,54,65,25,63,161,1,216,80,73,209,76,132,187,208,89,18, \
+	169,200,196,135,130,116,188,159,86,164,100,109,198,173,186,3,64,52,217,226,250,124,123,5,202,38, \
+	147,118,126,255,82,85,212,207,206,59,227,47,16,58,17,182,189,28,42,223,183,170,213,119,248,152,2, \
+	44,154,163,70,221,153,101,155,167,43,172,9,129,22,39,253,19,98,108,110,79,113,224,232,178,185,112, \
+	104,218,246,97,228,251,34,242,193,238,210,144,12,191,179,162,241,81,51,145,235,249,14,239,107,49, \
+	192,214,31,181,199,106,157,184,84,204,176,115,121,50,45,127,4,150,254,138,236,205,93,222,114,67, \
+	29,24,72,243,141,128,195,78,66,215,61,156,180
+
+static const int32_t lodge_noise_perm[512] = { LODGE_NOISE_PERM, LODGE_NOISE_PERM };
+
+//
+// LODGE_NOISE_SIMD_MAX until the first batch picks one.
+//
+static volatile int32_t lodge_noise_simd = LODGE_NOISE_SIMD_MAX;
 
 float lodge_noise_simplex_1d(float x)
 {
@@ -20,4 +73,399 @@ float lodge_noise_simplex_3d(float x, float y, float z)
 float lodge_noise_simplex_4d(float x, float y, float z, float w)
 {
 	return snoise4(x, y, z, w);
-}
\ No newline at end of file
+}
+
+static bool lodge_noise_simd_is_supported(enum lodge_noise_simd simd)
+{
+	switch(simd) {
+	case LODGE_NOISE_SIMD_SCALAR:
+		return true;
+#if defined(LODGE_NOISE_SSE2)
+	case LODGE_NOISE_SIMD_SSE2:
+		return true;
+#endif
+#if defined(LODGE_NOISE_AVX2)
+	case LODGE_NOISE_SIMD_AVX2:
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 1);
+		const bool osxsave_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28));
+		if(!osxsave_avx || (_xgetbv(0) & 0x6) != 0x6) {
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+	default:
+		return false;
+	}
+}
+
+enum lodge_noise_simd lodge_noise_get_simd()
+{
+	int32_t simd = lodge_atomic_load_i32(&lodge_noise_simd);
+	if(simd == LODGE_NOISE_SIMD_MAX) {
+		simd = LODGE_NOISE_SIMD_MAX - 1;
+		while(!lodge_noise_simd_is_supported((enum lodge_noise_simd)simd)) {
+			simd--;
+		}
+		lodge_atomic_store_i32(&lodge_noise_simd, simd);
+	}
+	return (enum lodge_noise_simd)simd;
+}
+
+bool lodge_noise_set_simd(enum lodge_noise_simd simd)
+{
+	if(!lodge_noise_simd_is_supported(simd)) {
+		return false;
+	}
+	lodge_atomic_store_i32(&lodge_noise_simd, simd);
+	return true;
+}
+
+static inline int32_t lodge_noise_floor(float x)
+{
+	const int32_t i = (int32_t)x;
+	return ((float)i <= x) ? i : i - 1;
+}
+
+static inline float lodge_noise_grad2(int32_t hash, float x, float y)
+{
+	const int32_t h = hash & 7;
+	const float u = h < 4 ? x : y;
+	const float v = h < 4 ? y : x;
+	return ((h & 1) ? -u : u) + ((h & 2) ? -2.0f * v : 2.0f * v);
+}
+
+//
+// The corner contributions in all kernels are computed in the same order as simplexnoise1234,
+// so results only differ where the compiler fuses multiply-adds.
+//
+static inline float lodge_noise_corner(float x, float y, int32_t hash)
+{
+	float t = 0.5f - x * x - y * y;
+	if(t < 0.0f) {
+		return 0.0f;
+	}
+	t *= t;
+	return t * t * lodge_noise_grad2(hash, x, y);
+}
+
+static void lodge_noise_simplex_2d_n_scalar(float *dst, const float *x, const float *y, size_t count)
+{
+	const int32_t *perm = lodge_noise_perm;
+
+	for(size_t k = 0; k < count; k++) {
+		const float s = (x[k] + y[k]) * LODGE_NOISE_F2;
+		const int32_t i = lodge_noise_floor(x[k] + s);
+		const int32_t j = lodge_noise_floor(y[k] + s);
+
+		const float t = (float)(i + j) * LODGE_NOISE_G2;
+		const float x0 = x[k] - (i - t);
+		const float y0 = y[k] - (j - t);
+
+		const int32_t i1 = x0 > y0 ? 1 : 0;
+		const int32_t j1 = 1 - i1;
+
+		const float x1 = x0 - i1 + LODGE_NOISE_G2;
+		const float y1 = y0 - j1 + LODGE_NOISE_G2;
+		const float x2 = x0 - 1.0f + 2.0f * LODGE_NOISE_G2;
+		const float y2 = y0 - 1.0f + 2.0f * LODGE_NOISE_G2;
+
+		const int32_t ii = i & 0xff;
+		const int32_t jj = j & 0xff;
+
+		const float n0 = lodge_noise_corner(x0, y0, perm[ii + perm[jj]]);
+		const float n1 = lodge_noise_corner(x1, y1, perm[ii + i1 + perm[jj + j1]]);
+		const float n2 = lodge_noise_corner(x2, y2, perm[ii + 1 + perm[jj + 1]]);
+
+		dst[k] = 40.0f * (n0 + n1 + n2);
+	}
+}
+
+#if defined(LODGE_NOISE_SSE2)
+
+static inline __m128 lodge_noise_corner_sse2(__m128 x, __m128 y, __m128i hash)
+{
+	const __m128i h = _mm_and_si128(hash, _mm_set1_epi32(7));
+	const __m128 h_lt4 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(4)));
+
+	__m128 u = _mm_or_ps(_mm_and_ps(h_lt4, x), _mm_andnot_ps(h_lt4, y));
+	__m128 v = _mm_or_ps(_mm_and_ps(h_lt4, y), _mm_andnot_ps(h_lt4, x));
+	v = _mm_mul_ps(_mm_set1_ps(2.0f), v);
+
+	//
+	// Flip the sign bits: bit 0 of the hash negates u, bit 1 negates v.
+	//
+	u = _mm_xor_ps(u, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31)));
+	v = _mm_xor_ps(v, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30)));
+
+	__m128 t = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(0.5f), _mm_mul_ps(x, x)), _mm_mul_ps(y, y));
+	t = _mm_max_ps(t, _mm_setzero_ps());
+	t = _mm_mul_ps(t, t);
+	return _mm_mul_ps(_mm_mul_ps(t, t), _mm_add_ps(u, v));
+}
+
+static inline __m128i lodge_noise_floor_sse2(__m128 x)
+{
+	//
+	// No SSE4.1 round: truncate, then step down where that rounded up.
+	//
+	const __m128i i = _mm_cvttps_epi32(x);
+	return _mm_add_epi32(i, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(i), x)));
+}
+
+static void lodge_noise_simplex_2d_4_sse2(float *dst, const float *x_src, const float *y_src)
+{
+	const __m128 x = _mm_loadu_ps(x_src);
+	const __m128 y = _mm_loadu_ps(y_src);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 g2 = _mm_set1_ps(LODGE_NOISE_G2);
+
+	const __m128 s = _mm_mul_ps(_mm_add_ps(x, y), _mm_set1_ps(LODGE_NOISE_F2));
+	const __m128i i = lodge_noise_floor_sse2(_mm_add_ps(x, s));
+	const __m128i j = lodge_noise_floor_sse2(_mm_add_ps(y, s));
+
+	const __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(i, j)), g2);
+	const __m128 x0 = _mm_sub_ps(x, _mm_sub_ps(_mm_cvtepi32_ps(i), t));
+	const __m128 y0 = _mm_sub_ps(y, _mm_sub_ps(_mm_cvtepi32_ps(j), t));
+
+	const __m128 i1_mask = _mm_cmpgt_ps(x0, y0);
+	const __m128 x1 = _mm_add_ps(_mm_sub_ps(x0, _mm_and_ps(i1_mask, one)), g2);
+	const __m128 y1 = _mm_add_ps(_mm_sub_ps(y0, _mm_andnot_ps(i1_mask, one)), g2);
+	const __m128 x2 = _mm_add_ps(_mm_sub_ps(x0, one), _mm_set1_ps(2.0f * LODGE_NOISE_G2));
+	const __m128 y2 = _mm_add_ps(_mm_sub_ps(y0, one), _mm_set1_ps(2.0f * LODGE_NOISE_G2));
+
+	//
+	// SSE2 has no gather, so the permutation lookups are done per lane.
+	//
+	const __m128i byte = _mm_set1_epi32(0xff);
+	int32_t ii[4], jj[4], i1[4];
+	_mm_storeu_si128((__m128i *)ii, _mm_and_si128(i, byte));
+	_mm_storeu_si128((__m128i *)jj, _mm_and_si128(j, byte));
+	_mm_storeu_si128((__m128i *)i1, _mm_castps_si128(i1_mask));
+
+	const int32_t *perm = lodge_noise_perm;
+	int32_t gi0[4], gi1[4], gi2[4];
+	for(int k = 0; k < 4; k++) {
+		gi0[k] = perm[ii[k] + perm[jj[k]]];
+		gi1[k] = perm[ii[k] - i1[k] + perm[jj[k] + 1 + i1[k]]];
+		gi2[k] = perm[ii[k] + 1 + perm[jj[k] + 1]];
+	}
+
+	const __m128 n0 = lodge_noise_corner_sse2(x0, y0, _mm_loadu_si128((const __m128i *)gi0));
+	const __m128 n1 = lodge_noise_corner_sse2(x1, y1, _mm_loadu_si128((const __m128i *)gi1));
+	const __m128 n2 = lodge_noise_corner_sse2(x2, y2, _mm_loadu_si128((const __m128i *)gi2));
+
+	_mm_storeu_ps(dst, _mm_mul_ps(_mm_set1_ps(40.0f), _mm_add_ps(_mm_add_ps(n0, n1), n2)));
+}
+
+static void lodge_noise_simplex_2d_n_sse2(float *dst, const float *x, const float *y, size_t count)
+{
+	size_t k = 0;
+	for(; k + 4 <= count; k += 4) {
+		lodge_noise_simplex_2d_4_sse2(dst + k, x + k, y + k);
+	}
+
+	if(k < count) {
+		float tail_x[4] = { 0 }, tail_y[4] = { 0 }, tail_dst[4];
+		memcpy(tail_x, x + k, (count - k) * sizeof(float));
+		memcpy(tail_y, y + k, (count - k) * sizeof(float));
+		lodge_noise_simplex_2d_4_sse2(tail_dst, tail_x, tail_y);
+		memcpy(dst + k, tail_dst, (count - k) * sizeof(float));
+	}
+}
+
+#endif
+
+#if defined(LODGE_NOISE_AVX2)
+
+LODGE_NOISE_TARGET_AVX2 static inline __m256 lodge_noise_corner_avx2(__m256 x, __m256 y, __m256i hash)
+{
+	const __m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(7));
+	const __m256 h_lt4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h));
+
+	__m256 u = _mm256_blendv_ps(y, x, h_lt4);
+	__m256 v = _mm256_blendv_ps(x, y, h_lt4);
+	v = _mm256_mul_ps(_mm256_set1_ps(2.0f), v);
+
+	u = _mm256_xor_ps(u, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31)));
+	v = _mm256_xor_ps(v, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30)));
+
+	__m256 t = _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(0.5f), _mm256_mul_ps(x, x)), _mm256_mul_ps(y, y));
+	t = _mm256_max_ps(t, _mm256_setzero_ps());
+	t = _mm256_mul_ps(t, t);
+	return _mm256_mul_ps(_mm256_mul_ps(t, t), _mm256_add_ps(u, v));
+}
+
+LODGE_NOISE_TARGET_AVX2 static void lodge_noise_simplex_2d_8_avx2(float *dst, const float *x_src, const float *y_src)
+{
+	const __m256 x = _mm256_loadu_ps(x_src);
+	const __m256 y = _mm256_loadu_ps(y_src);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 g2 = _mm256_set1_ps(LODGE_NOISE_G2);
+
+	const __m256 s = _mm256_mul_ps(_mm256_add_ps(x, y), _mm256_set1_ps(LODGE_NOISE_F2));
+	const __m256i i = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_add_ps(x, s)));
+	const __m256i j = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_add_ps(y, s)));
+
+	const __m256 t = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(i, j)), g2);
+	const __m256 x0 = _mm256_sub_ps(x, _mm256_sub_ps(_mm256_cvtepi32_ps(i), t));
+	const __m256 y0 = _mm256_sub_ps(y, _mm256_sub_ps(_mm256_cvtepi32_ps(j), t));
+
+	const __m256 i1_mask = _mm256_cmp_ps(x0, y0, _CMP_GT_OQ);
+	const __m256 x1 = _mm256_add_ps(_mm256_sub_ps(x0, _mm256_and_ps(i1_mask, one)), g2);
+	const __m256 y1 = _mm256_add_ps(_mm256_sub_ps(y0, _mm256_andnot_ps(i1_mask, one)), g2);
+	const __m256 x2 = _mm256_add_ps(_mm256_sub_ps(x0, one), _mm256_set1_ps(2.0f * LODGE_NOISE_G2));
+	const __m256 y2 = _mm256_add_ps(_mm256_sub_ps(y0, one), _mm256_set1_ps(2.0f * LODGE_NOISE_G2));
+
+	const __m256i byte = _mm256_set1_epi32(0xff);
+	const __m256i ii = _mm256_and_si256(i, byte);
+	const __m256i jj = _mm256_and_si256(j, byte);
+	const __m256i i1 = _mm256_srli_epi32(_mm256_castps_si256(i1_mask), 31);
+	const __m256i j1 = _mm256_sub_epi32(_mm256_set1_epi32(1), i1);
+	const __m256i one_i = _mm256_set1_epi32(1);
+
+	const int *perm = (const int *)lodge_noise_perm;
+	const __m256i perm_jj = _mm256_i32gather_epi32(perm, jj, 4);
+	const __m256i perm_jj1 = _mm256_i32gather_epi32(perm, _mm256_add_epi32(jj, j1), 4);
+	const __m256i perm_jj_1 = _mm256_i32gather_epi32(perm, _mm256_add_epi32(jj, one_i), 4);
+
+	const __m256i gi0 = _mm256_i32gather_epi32(perm, _mm256_add_epi32(ii, perm_jj), 4);
+	const __m256i gi1 = _mm256_i32gather_epi32(perm, _mm256_add_epi32(_mm256_add_epi32(ii, i1), perm_jj1), 4);
+	const __m256i gi2 = _mm256_i32gather_epi32(perm, _mm256_add_epi32(_mm256_add_epi32(ii, one_i), perm_jj_1), 4);
+
+	const __m256 n0 = lodge_noise_corner_avx2(x0, y0, gi0);
+	const __m256 n1 = lodge_noise_corner_avx2(x1, y1, gi1);
+	const __m256 n2 = lodge_noise_corner_avx2(x2, y2, gi2);
+
+	_mm256_storeu_ps(dst, _mm256_mul_ps(_mm256_set1_ps(40.0f), _mm256_add_ps(_mm256_add_ps(n0, n1), n2)));
+}
+
+LODGE_NOISE_TARGET_AVX2 static void lodge_noise_simplex_2d_n_avx2(float *dst, const float *x, const float *y, size_t count)
+{
+	size_t k = 0;
+	for(; k + 8 <= count; k += 8) {
+		lodge_noise_simplex_2d_8_avx2(dst + k, x + k, y + k);
+	}
+
+	if(k < count) {
+		float tail_x[8] = { 0 }, tail_y[8] = { 0 }, tail_dst[8];
+		memcpy(tail_x, x + k, (count - k) * sizeof(float));
+		memcpy(tail_y, y + k, (count - k) * sizeof(float));
+		lodge_noise_simplex_2d_8_avx2(tail_dst, tail_x, tail_y);
+		memcpy(dst + k, tail_dst, (count - k) * sizeof(float));
+	}
+}
+
+#endif
+
+void lodge_noise_simplex_2d_n(float *dst, const float *x, const float *y, size_t count)
+{
+	ASSERT_OR(dst && x && y) { return; }
+
+	switch(lodge_noise_get_simd()) {
+#if defined(LODGE_NOISE_AVX2)
+	case LODGE_NOISE_SIMD_AVX2:
+		lodge_noise_simplex_2d_n_avx2(dst, x, y, count);
+		break;
+#endif
+#if defined(LODGE_NOISE_SSE2)
+	case LODGE_NOISE_SIMD_SSE2:
+		lodge_noise_simplex_2d_n_sse2(dst, x, y, count);
+		break;
+#endif
+	default:
+		lodge_noise_simplex_2d_n_scalar(dst, x, y, count);
+		break;
+	}
+}
+
+void lodge_noise_simplex_2d_grid(float *dst, uint32_t width, uint32_t height, float origin_x, float origin_y, float step_x, float step_y)
+{
+	ASSERT_OR(dst) { return; }
+
+	float x[LODGE_NOISE_BATCH];
+	float y[LODGE_NOISE_BATCH];
+
+	for(uint32_t row = 0; row < height; row++) {
+		const float row_y = origin_y + (float)row * step_y;
+
+		for(uint32_t col = 0; col < width; col += LODGE_NOISE_BATCH) {
+			const uint32_t count = min(width - col, LODGE_NOISE_BATCH);
+			for(uint32_t k = 0; k < count; k++) {
+				x[k] = origin_x + (float)(col + k) * step_x;
+				y[k] = row_y;
+			}
+			lodge_noise_simplex_2d_n(dst + (size_t)row * width + col, x, y, count);
+		}
+	}
+}
+
+static void lodge_noise_fractal_2d_grid(float *dst, uint32_t width, uint32_t height, float origin_x, float origin_y, float step_x, float step_y, struct lodge_noise_fractal_desc desc, bool ridged)
+{
+	ASSERT_OR(dst && desc.octaves > 0) { return; }
+
+	float x[LODGE_NOISE_BATCH];
+	float y[LODGE_NOISE_BATCH];
+	float noise[LODGE_NOISE_BATCH];
+	float sum[LODGE_NOISE_BATCH];
+
+	for(uint32_t row = 0; row < height; row++) {
+		const float row_y = origin_y + (float)row * step_y;
+
+		for(uint32_t col = 0; col < width; col += LODGE_NOISE_BATCH) {
+			const uint32_t count = min(width - col, LODGE_NOISE_BATCH);
+			memset(sum, 0, count * sizeof(float));
+
+			float frequency = desc.frequency;
+			float amplitude = 1.0f;
+			float amplitude_sum = 0.0f;
+
+			for(uint32_t octave = 0; octave < desc.octaves; octave++) {
+				for(uint32_t k = 0; k < count; k++) {
+					x[k] = (origin_x + (float)(col + k) * step_x) * frequency;
+					y[k] = row_y * frequency;
+				}
+				lodge_noise_simplex_2d_n(noise, x, y, count);
+
+				if(ridged) {
+					for(uint32_t k = 0; k < count; k++) {
+						const float ridge = 1.0f - fabsf(noise[k]);
+						sum[k] += amplitude * ridge * ridge;
+					}
+				} else {
+					for(uint32_t k = 0; k < count; k++) {
+						sum[k] += amplitude * noise[k];
+					}
+				}
+
+				amplitude_sum += amplitude;
+				frequency *= desc.lacunarity;
+				amplitude *= desc.gain;
+			}
+
+			const float amplitude_scale = amplitude_sum > 0.0f ? 1.0f / amplitude_sum : 0.0f;
+			float *dst_row = dst + (size_t)row * width + col;
+			for(uint32_t k = 0; k < count; k++) {
+				dst_row[k] = sum[k] * amplitude_scale;
+			}
+		}
+	}
+}
+
+void lodge_noise_fbm_2d_grid(float *dst, uint32_t width, uint32_t height, float origin_x, float origin_y, float step_x, float step_y, struct lodge_noise_fractal_desc desc)
+{
+	lodge_noise_fractal_2d_grid(dst, width, height, origin_x, origin_y, step_x, step_y, desc, false);
+}
+
+void lodge_noise_ridged_2d_grid(float *dst, uint32_t width, uint32_t height, float origin_x, float origin_y, float step_x, float step_y, struct lodge_noise_fractal_desc desc)
+{
+	lodge_noise_fractal_2d_grid(dst, width, height, origin_x, origin_y, step_x, step_y, desc, true);
+}
@@ -1,6 +1,7 @@
 #include "lodge_quadtree.h"
 
 #include "lodge_assert.h"
+#include "dynbuf.h"
 
 static void lodge_quadtree_make_impl(uint32_t level, const vec2 center, const vec2 size, lodge_quadtree_leaf_func_t is_leaf, void *userdata)
 {
@@ -28,3 +29,190 @@ void lodge_quadtree_make(const vec2 center, const vec2 size, lodge_quadtree_leaf
 {
 	lodge_quadtree_make_impl(0, center, size, is_leaf, userdata);
 }
+
+void lodge_quadtree_new_inplace(struct lodge_quadtree *tree, struct lodge_quadtree_desc desc)
+{
+	ASSERT(desc.levels_max <= LODGE_QUADTREE_LEVELS_MAX);
+	ASSERT(desc.merge_threshold <= desc.split_threshold);
+
+	tree->desc = desc;
+	tree->desc.levels_max = min(desc.levels_max, LODGE_QUADTREE_LEVELS_MAX);
+
+	for(uint32_t level = 0; level <= LODGE_QUADTREE_LEVELS_MAX; level++) {
+		const float scale = 1.0f / (float)(1u << level);
+		tree->level_sizes[level] = vec2_make(desc.size.x * scale, desc.size.y * scale);
+	}
+
+	dynbuf_new_inplace(dynbuf_wrap(tree), 1 + 4 * 64);
+	dynbuf_new_inplace(dynbuf(tree->free_blocks), 64);
+
+	lodge_quadtree_reset(tree);
+}
+
+void lodge_quadtree_free_inplace(struct lodge_quadtree *tree)
+{
+	dynbuf_free_inplace(dynbuf_wrap(tree));
+	dynbuf_free_inplace(dynbuf(tree->free_blocks));
+}
+
+void lodge_quadtree_reset(struct lodge_quadtree *tree)
+{
+	dynbuf_clear(dynbuf_wrap(tree));
+	dynbuf_clear(dynbuf(tree->free_blocks));
+
+	struct lodge_quadtree_node *root = dynbuf_append_no_init(dynbuf_wrap(tree));
+	*root = (struct lodge_quadtree_node) {
+		.children = 0,
+		.parent = LODGE_QUADTREE_NODE_NONE,
+		.x = 0,
+		.y = 0,
+		.level = 0,
+		.metric = 0.0f,
+	};
+
+	tree->leaves_count = 1;
+	tree->splits = 0;
+	tree->merges = 0;
+	tree->evaluated = 0;
+}
+
+static void lodge_quadtree_split(struct lodge_quadtree *tree, uint32_t index)
+{
+	const struct lodge_quadtree_node parent = tree->elements[index];
+	ASSERT(lodge_quadtree_node_is_leaf(&parent));
+
+	uint32_t children;
+	if(tree->free_blocks.count > 0) {
+		children = tree->free_blocks.elements[--tree->free_blocks.count];
+	} else {
+		children = (uint32_t)tree->count;
+		struct lodge_quadtree_node block[4];
+		dynbuf_append_range(dynbuf_wrap(tree), block, sizeof(struct lodge_quadtree_node), 4);
+	}
+
+	for(uint32_t i = 0; i < 4; i++) {
+		tree->elements[children + i] = (struct lodge_quadtree_node) {
+			.children = 0,
+			.parent = index,
+			.x = (uint16_t)((parent.x << 1) | (i & 1)),
+			.y = (uint16_t)((parent.y << 1) | (i >> 1)),
+			.level = parent.level + 1,
+			.metric = 0.0f,
+		};
+	}
+
+	tree->elements[index].children = children;
+	tree->leaves_count += 3;
+	tree->splits++;
+}
+
+static void lodge_quadtree_merge(struct lodge_quadtree *tree, uint32_t index)
+{
+	const uint32_t children = tree->elements[index].children;
+	ASSERT_OR(children) { return; }
+
+	for(uint32_t i = 0; i < 4; i++) {
+		if(tree->elements[children + i].children) {
+			lodge_quadtree_merge(tree, children + i);
+		}
+	}
+
+	uint32_t *free_block = dynbuf_append_no_init(dynbuf(tree->free_blocks));
+	*free_block = children;
+
+	tree->elements[index].children = 0;
+	tree->leaves_count -= 3;
+	tree->merges++;
+}
+
+static void lodge_quadtree_update_node(struct lodge_quadtree *tree, uint32_t index, lodge_quadtree_metric_func_t metric_func, lodge_quadtree_visit_func_t leaf_func, void *userdata)
+{
+	//
+	// Splitting may grow the pool, so only hold on to indices here.
+	//
+	const struct lodge_quadtree_node node = tree->elements[index];
+
+	const float metric = metric_func(tree, index, userdata);
+	tree->elements[index].metric = metric;
+	tree->evaluated++;
+
+	if(node.children) {
+		if(metric < 0.0f || metric < tree->desc.merge_threshold) {
+			lodge_quadtree_merge(tree, index);
+			if(leaf_func) {
+				leaf_func(tree, index, userdata);
+			}
+			return;
+		}
+	} else {
+		if(metric < 0.0f || metric < tree->desc.split_threshold || node.level >= tree->desc.levels_max) {
+			if(leaf_func) {
+				leaf_func(tree, index, userdata);
+			}
+			return;
+		}
+		lodge_quadtree_split(tree, index);
+	}
+
+	const uint32_t children = tree->elements[index].children;
+	for(uint32_t i = 0; i < 4; i++) {
+		lodge_quadtree_update_node(tree, children + i, metric_func, leaf_func, userdata);
+	}
+}
+
+void lodge_quadtree_update(struct lodge_quadtree *tree, lodge_quadtree_metric_func_t metric, lodge_quadtree_visit_func_t leaf, void *userdata)
+{
+	ASSERT_OR(tree && metric && tree->count > 0) { return; }
+
+	tree->splits = 0;
+	tree->merges = 0;
+	tree->evaluated = 0;
+
+	lodge_quadtree_update_node(tree, 0, metric, leaf, userdata);
+}
+
+static void lodge_quadtree_visit_node(const struct lodge_quadtree *tree, uint32_t index, lodge_quadtree_visit_func_t visit, void *userdata)
+{
+	if(!visit(tree, index, userdata)) {
+		return;
+	}
+
+	const uint32_t children = tree->elements[index].children;
+	if(children) {
+		for(uint32_t i = 0; i < 4; i++) {
+			lodge_quadtree_visit_node(tree, children + i, visit, userdata);
+		}
+	}
+}
+
+void lodge_quadtree_visit(const struct lodge_quadtree *tree, lodge_quadtree_visit_func_t visit, void *userdata)
+{
+	ASSERT_OR(tree && visit && tree->count > 0) { return; }
+	lodge_quadtree_visit_node(tree, 0, visit, userdata);
+}
+
+uint32_t lodge_quadtree_find_leaf(const struct lodge_quadtree *tree, vec2 pos)
+{
+	ASSERT_OR(tree && tree->count > 0) { return LODGE_QUADTREE_NODE_NONE; }
+
+	const float u = (pos.x - tree->desc.center.x) / tree->desc.size.x + 0.5f;
+	const float v = (pos.y - tree->desc.center.y) / tree->desc.size.y + 0.5f;
+	if(!(u >= 0.0f && u <= 1.0f && v >= 0.0f && v <= 1.0f)) {
+		return LODGE_QUADTREE_NODE_NONE;
+	}
+
+	//
+	// Position in the grid of the deepest level, then one bit per level on the way down.
+	//
+	const uint32_t cells = 1u << tree->desc.levels_max;
+	const uint32_t x = min((uint32_t)(u * cells), cells - 1);
+	const uint32_t y = min((uint32_t)(v * cells), cells - 1);
+
+	uint32_t index = 0;
+	while(tree->elements[index].children) {
+		const uint32_t shift = tree->desc.levels_max - tree->elements[index].level - 1;
+		const uint32_t child = ((x >> shift) & 1) | (((y >> shift) & 1) << 1);
+		index = tree->elements[index].children + child;
+	}
+	return index;
+}
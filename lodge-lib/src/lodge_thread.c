@@ -0,0 +1,258 @@
+#include "lodge_thread.h"
+
+#include "lodge_platform.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+struct lodge_thread
+{
+#ifdef _WIN32
+	HANDLE					handle;
+#else
+	pthread_t				handle;
+#endif
+	lodge_thread_func_t		func;
+	void					*userdata;
+};
+
+struct lodge_mutex
+{
+#ifdef _WIN32
+	SRWLOCK					lock;
+#else
+	pthread_mutex_t			lock;
+#endif
+};
+
+struct lodge_cond
+{
+#ifdef _WIN32
+	CONDITION_VARIABLE		cond;
+#else
+	pthread_cond_t			cond;
+#endif
+};
+
+#ifdef _WIN32
+
+static DWORD WINAPI lodge_thread_main(LPVOID param)
+{
+	struct lodge_thread *thread = (struct lodge_thread *)param;
+	thread->func(thread->userdata);
+	return 0;
+}
+
+lodge_thread_t lodge_thread_new(lodge_thread_func_t func, void *userdata)
+{
+	struct lodge_thread *thread = (struct lodge_thread *)calloc(1, sizeof(struct lodge_thread));
+	ASSERT_OR(thread) { return NULL; }
+
+	thread->func = func;
+	thread->userdata = userdata;
+	thread->handle = CreateThread(NULL, 0, &lodge_thread_main, thread, 0, NULL);
+
+	ASSERT_OR(thread->handle) {
+		free(thread);
+		return NULL;
+	}
+
+	return thread;
+}
+
+void lodge_thread_join(lodge_thread_t thread)
+{
+	ASSERT_OR(thread) { return; }
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+	free(thread);
+}
+
+uint32_t lodge_thread_get_hardware_concurrency()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return max((uint32_t)info.dwNumberOfProcessors, 1);
+}
+
+lodge_mutex_t lodge_mutex_new()
+{
+	struct lodge_mutex *mutex = (struct lodge_mutex *)calloc(1, sizeof(struct lodge_mutex));
+	ASSERT_OR(mutex) { return NULL; }
+	InitializeSRWLock(&mutex->lock);
+	return mutex;
+}
+
+void lodge_mutex_free(lodge_mutex_t mutex)
+{
+	free(mutex);
+}
+
+void lodge_mutex_lock(lodge_mutex_t mutex)
+{
+	AcquireSRWLockExclusive(&mutex->lock);
+}
+
+void lodge_mutex_unlock(lodge_mutex_t mutex)
+{
+	ReleaseSRWLockExclusive(&mutex->lock);
+}
+
+lodge_cond_t lodge_cond_new()
+{
+	struct lodge_cond *cond = (struct lodge_cond *)calloc(1, sizeof(struct lodge_cond));
+	ASSERT_OR(cond) { return NULL; }
+	InitializeConditionVariable(&cond->cond);
+	return cond;
+}
+
+void lodge_cond_free(lodge_cond_t cond)
+{
+	free(cond);
+}
+
+void lodge_cond_wait(lodge_cond_t cond, lodge_mutex_t mutex)
+{
+	SleepConditionVariableSRW(&cond->cond, &mutex->lock, INFINITE, 0);
+}
+
+void lodge_cond_signal(lodge_cond_t cond)
+{
+	WakeConditionVariable(&cond->cond);
+}
+
+void lodge_cond_broadcast(lodge_cond_t cond)
+{
+	WakeAllConditionVariable(&cond->cond);
+}
+
+int32_t lodge_atomic_add_i32(volatile int32_t *dst, int32_t value)
+{
+	return (int32_t)InterlockedExchangeAdd((volatile LONG *)dst, (LONG)value) + value;
+}
+
+int32_t lodge_atomic_load_i32(volatile int32_t *src)
+{
+	return (int32_t)InterlockedCompareExchange((volatile LONG *)src, 0, 0);
+}
+
+void lodge_atomic_store_i32(volatile int32_t *dst, int32_t value)
+{
+	InterlockedExchange((volatile LONG *)dst, (LONG)value);
+}
+
+#else
+
+static void* lodge_thread_main(void *param)
+{
+	struct lodge_thread *thread = (struct lodge_thread *)param;
+	thread->func(thread->userdata);
+	return NULL;
+}
+
+lodge_thread_t lodge_thread_new(lodge_thread_func_t func, void *userdata)
+{
+	struct lodge_thread *thread = (struct lodge_thread *)calloc(1, sizeof(struct lodge_thread));
+	ASSERT_OR(thread) { return NULL; }
+
+	thread->func = func;
+	thread->userdata = userdata;
+
+	ASSERT_OR(pthread_create(&thread->handle, NULL, &lodge_thread_main, thread) == 0) {
+		free(thread);
+		return NULL;
+	}
+
+	return thread;
+}
+
+void lodge_thread_join(lodge_thread_t thread)
+{
+	ASSERT_OR(thread) { return; }
+	pthread_join(thread->handle, NULL);
+	free(thread);
+}
+
+uint32_t lodge_thread_get_hardware_concurrency()
+{
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (uint32_t)count : 1;
+}
+
+lodge_mutex_t lodge_mutex_new()
+{
+	struct lodge_mutex *mutex = (struct lodge_mutex *)calloc(1, sizeof(struct lodge_mutex));
+	ASSERT_OR(mutex) { return NULL; }
+	pthread_mutex_init(&mutex->lock, NULL);
+	return mutex;
+}
+
+void lodge_mutex_free(lodge_mutex_t mutex)
+{
+	if(mutex) {
+		pthread_mutex_destroy(&mutex->lock);
+		free(mutex);
+	}
+}
+
+void lodge_mutex_lock(lodge_mutex_t mutex)
+{
+	pthread_mutex_lock(&mutex->lock);
+}
+
+void lodge_mutex_unlock(lodge_mutex_t mutex)
+{
+	pthread_mutex_unlock(&mutex->lock);
+}
+
+lodge_cond_t lodge_cond_new()
+{
+	struct lodge_cond *cond = (struct lodge_cond *)calloc(1, sizeof(struct lodge_cond));
+	ASSERT_OR(cond) { return NULL; }
+	pthread_cond_init(&cond->cond, NULL);
+	return cond;
+}
+
+void lodge_cond_free(lodge_cond_t cond)
+{
+	if(cond) {
+		pthread_cond_destroy(&cond->cond);
+		free(cond);
+	}
+}
+
+void lodge_cond_wait(lodge_cond_t cond, lodge_mutex_t mutex)
+{
+	pthread_cond_wait(&cond->cond, &mutex->lock);
+}
+
+void lodge_cond_signal(lodge_cond_t cond)
+{
+	pthread_cond_signal(&cond->cond);
+}
+
+void lodge_cond_broadcast(lodge_cond_t cond)
+{
+	pthread_cond_broadcast(&cond->cond);
+}
+
+int32_t lodge_atomic_add_i32(volatile int32_t *dst, int32_t value)
+{
+	return __atomic_add_fetch(dst, value, __ATOMIC_SEQ_CST);
+}
+
+int32_t lodge_atomic_load_i32(volatile int32_t *src)
+{
+	return __atomic_load_n(src, __ATOMIC_SEQ_CST);
+}
+
+void lodge_atomic_store_i32(volatile int32_t *dst, int32_t value)
+{
+	__atomic_store_n(dst, value, __ATOMIC_SEQ_CST);
+}
+
+#endif
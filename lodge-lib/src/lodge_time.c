@@ -101,35 +101,37 @@ static lodge_timestamp_t get_cycles()
 }
 #endif
 
+//
+// NOTE(TS): monotonic wall time -- CPU time would sum up the time spent on
+// all threads and no longer reflect frame time once work is spread out.
+//
 lodge_timestamp_t lodge_timestamp_get()
 {
     struct timespec start;
-    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
     return start;
 }
 
-double lodge_timestamp_elapsed_us(lodge_timestamp_t start)
+static double lodge_timestamp_elapsed_ns(lodge_timestamp_t start)
 {
 	struct timespec end;
-	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
-	uint64_t delta_us = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
-	return (double)delta_us;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (double)(end.tv_sec - start.tv_sec) * 1e9 + (double)(end.tv_nsec - start.tv_nsec);
+}
+
+double lodge_timestamp_elapsed_us(lodge_timestamp_t start)
+{
+	return lodge_timestamp_elapsed_ns(start) / 1e3;
 }
 
 double lodge_timestamp_elapsed_ms(lodge_timestamp_t start)
 {
-	struct timespec end;
-	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
-	uint64_t delta_ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000;
-	return (double)delta_ms;
+	return lodge_timestamp_elapsed_ns(start) / 1e6;
 }
 
 double lodge_timestamp_elapsed_s(lodge_timestamp_t start)
 {
-	struct timespec end;
-	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
-	uint64_t delta_s = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1000;
-	return (double)delta_s;
+	return lodge_timestamp_elapsed_ns(start) / 1e9;
 }
 
 static double get_milliseconds()
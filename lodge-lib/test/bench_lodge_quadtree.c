@@ -0,0 +1,140 @@
+//
+// CPU time of keeping a quadtree refined around a moving camera: rebuilding it from scratch
+// with `lodge_quadtree_make()` every frame, against updating a persistent tree in place with
+// `lodge_quadtree_update()`. Both collect the leaves, like a renderer would.
+//
+// Usage: bench_lodge_quadtree [frames]
+//
+
+#include "lodge_quadtree.h"
+#include "lodge_platform.h"
+#include "lodge_time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+struct bench_leaves
+{
+	vec4							elements[1 << 16];
+	size_t							count;
+};
+
+struct bench_params
+{
+	vec2							camera_pos;
+	float							camera_height;
+	float							threshold;			// For `lodge_quadtree_make()`.
+	uint32_t						levels_max;
+	uint32_t						evaluated;
+	struct bench_leaves				*leaves;
+};
+
+static float bench_metric_calc(struct bench_params *params, const vec2 center, const vec2 size)
+{
+	params->evaluated++;
+	const float dx = center.x - params->camera_pos.x;
+	const float dy = center.y - params->camera_pos.y;
+	return size.x / sqrtf(dx * dx + dy * dy + params->camera_height * params->camera_height);
+}
+
+static void bench_leaves_append(struct bench_leaves *leaves, const vec2 center, const vec2 size)
+{
+	if(leaves->count < LODGE_ARRAYSIZE(leaves->elements)) {
+		leaves->elements[leaves->count++] = vec4_make(center.x, center.y, size.x, size.y);
+	}
+}
+
+static bool bench_make_is_leaf(const uint32_t level, const vec2 center, const vec2 size, struct bench_params *params)
+{
+	const float metric = bench_metric_calc(params, center, size);
+	const bool is_leaf = metric < params->threshold || level >= params->levels_max;
+	if(is_leaf) {
+		bench_leaves_append(params->leaves, center, size);
+	}
+	return is_leaf;
+}
+
+static float bench_metric(const struct lodge_quadtree *tree, uint32_t node_index, struct bench_params *params)
+{
+	const struct lodge_quadtree_node *node = &tree->elements[node_index];
+	return bench_metric_calc(params, lodge_quadtree_node_center(tree, node), lodge_quadtree_node_size(tree, node));
+}
+
+static bool bench_append_leaf(const struct lodge_quadtree *tree, uint32_t node_index, struct bench_params *params)
+{
+	const struct lodge_quadtree_node *node = &tree->elements[node_index];
+	bench_leaves_append(params->leaves, lodge_quadtree_node_center(tree, node), lodge_quadtree_node_size(tree, node));
+	return false;
+}
+
+static struct bench_leaves bench_leaves;
+
+int main(int argc, char **argv)
+{
+	const uint32_t frames = (argc > 1) ? (uint32_t)atoi(argv[1]) : 2000;
+
+	const struct lodge_quadtree_desc desc = {
+		.center = { 0.0f, 0.0f },
+		.size = { 16384.0f, 16384.0f },
+		.levels_max = 12,
+		.split_threshold = 0.1f,
+		.merge_threshold = 0.09f,
+	};
+
+	printf("%u levels, %u frames\n", desc.levels_max, frames);
+
+	//
+	// Camera orbiting the middle of the tree at different speeds; 0 is a static camera.
+	//
+	const float speeds[] = { 0.0f, 0.0005f, 0.003f, 0.02f };
+	for(size_t s = 0; s < LODGE_ARRAYSIZE(speeds); s++) {
+		struct lodge_quadtree tree;
+		lodge_quadtree_new_inplace(&tree, desc);
+
+		double make_ms = 0.0;
+		double update_ms = 0.0;
+		size_t make_evaluated = 0;
+		size_t update_evaluated = 0;
+		size_t make_leaves = 0;
+		size_t update_leaves = 0;
+		size_t changes = 0;
+
+		for(uint32_t i = 0; i < frames; i++) {
+			const float angle = i * speeds[s];
+			struct bench_params params = {
+				.camera_pos = vec2_make(7000.0f * cosf(angle), 7000.0f * sinf(angle)),
+				.camera_height = 50.0f,
+				.threshold = desc.split_threshold,
+				.levels_max = desc.levels_max,
+				.leaves = &bench_leaves,
+			};
+
+			bench_leaves.count = 0;
+			lodge_timestamp_t before = lodge_timestamp_get();
+			lodge_quadtree_make(desc.center, desc.size, &bench_make_is_leaf, &params);
+			make_ms += lodge_timestamp_elapsed_ms(before);
+			make_evaluated += params.evaluated;
+			make_leaves += bench_leaves.count;
+
+			params.evaluated = 0;
+			bench_leaves.count = 0;
+			before = lodge_timestamp_get();
+			lodge_quadtree_update(&tree, &bench_metric, &bench_append_leaf, &params);
+			update_ms += lodge_timestamp_elapsed_ms(before);
+			update_evaluated += params.evaluated;
+			update_leaves += bench_leaves.count;
+			changes += tree.splits + tree.merges;
+		}
+
+		printf("speed %.4f rad/frame\n", speeds[s]);
+		printf("  rebuild     avg: %7.4f ms  evaluated: %6.1f  leaves: %6.1f\n",
+			make_ms / frames, make_evaluated / (double)frames, make_leaves / (double)frames);
+		printf("  persistent  avg: %7.4f ms  evaluated: %6.1f  leaves: %6.1f  splits+merges: %7.2f\n",
+			update_ms / frames, update_evaluated / (double)frames, update_leaves / (double)frames, changes / (double)frames);
+
+		lodge_quadtree_free_inplace(&tree);
+	}
+
+	return 0;
+}
@@ -0,0 +1,168 @@
+//
+// Batched 2D simplex noise on every instruction set the CPU supports, against
+// `lodge_noise_simplex_2d()` one sample at a time. Counts that are not a multiple of the
+// lane width go through the tail, which must neither drift from the scalar noise nor write
+// past the end of the batch.
+//
+
+#include "lodge_noise.h"
+
+#include "lodge_platform.h"
+#include "lodge_test.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+//
+// Noise is in [-1, 1]; the batches reorder a few float operations.
+//
+#define TEST_TOLERANCE		1e-5f
+
+//
+// Written past `count` to catch the tail writing out of bounds.
+//
+#define TEST_SENTINEL		12345.0f
+
+static const char *test_simd_names[] = {
+	"scalar",
+	"sse2",
+	"avx2",
+};
+
+//
+// Random points, with every fourth one on the simplex lattice or an integer, where the floor
+// and the corner selection are on an edge.
+//
+static void test_points_make(float *x, float *y, size_t count, float range)
+{
+	for(size_t i = 0; i < count; i++) {
+		x[i] = lodge_test_random(-range, range);
+		y[i] = lodge_test_random(-range, range);
+		if(i % 4 == 3) {
+			x[i] = floorf(x[i]);
+			y[i] = (i % 8 == 7) ? floorf(y[i]) : x[i];
+		}
+	}
+}
+
+static float test_max_error(const float *dst, const float *x, const float *y, size_t count)
+{
+	float error = 0.0f;
+	for(size_t i = 0; i < count; i++) {
+		error = max(error, fabsf(dst[i] - lodge_noise_simplex_2d(x[i], y[i])));
+	}
+	return error;
+}
+
+static void test_batch_matches_scalar_impl(enum lodge_noise_simd simd)
+{
+	//
+	// Every count up to a few lanes of the widest batch, and some large ones.
+	//
+	size_t counts[40 + 3];
+	for(size_t i = 0; i < 40; i++) {
+		counts[i] = i;
+	}
+	counts[40] = 255;
+	counts[41] = 1024;
+	counts[42] = 10007;
+
+	const float ranges[] = { 4.0f, 1000.0f };
+
+	float *x = malloc((10007 + 1) * sizeof(float));
+	float *y = malloc((10007 + 1) * sizeof(float));
+	float *dst = malloc((10007 + 9) * sizeof(float));
+
+	for(size_t r = 0; r < LODGE_ARRAYSIZE(ranges); r++) {
+		for(size_t c = 0; c < LODGE_ARRAYSIZE(counts); c++) {
+			const size_t count = counts[c];
+
+			//
+			// Off by one float from the allocation, so the batches see unaligned pointers.
+			//
+			test_points_make(x + 1, y + 1, count, ranges[r]);
+			for(size_t i = 0; i < count + 9; i++) {
+				dst[i] = TEST_SENTINEL;
+			}
+
+			lodge_noise_simplex_2d_n(dst + 1, x + 1, y + 1, count);
+
+			const float error = test_max_error(dst + 1, x + 1, y + 1, count);
+			LODGE_TEST_CHECK_MSG(error <= TEST_TOLERANCE, "%s, %zu samples in +-%g: max error %g", test_simd_names[simd], count, ranges[r], error);
+
+			bool in_bounds = dst[0] == TEST_SENTINEL;
+			for(size_t i = count + 1; i < count + 9; i++) {
+				in_bounds &= dst[i] == TEST_SENTINEL;
+			}
+			LODGE_TEST_CHECK_MSG(in_bounds, "%s, %zu samples: wrote outside the batch", test_simd_names[simd], count);
+		}
+	}
+
+	free(x);
+	free(y);
+	free(dst);
+}
+
+static void test_grid_matches_scalar_impl(enum lodge_noise_simd simd)
+{
+	//
+	// Widths around the lane widths and past the internal batch.
+	//
+	const uint32_t widths[] = { 1, 3, 7, 9, 37, 257, 300 };
+	const uint32_t height = 5;
+	const float origin_x = -3.3f;
+	const float origin_y = 1.1f;
+	const float step_x = 0.07f;
+	const float step_y = 0.05f;
+
+	float *dst = malloc(300 * height * sizeof(float));
+
+	for(size_t w = 0; w < LODGE_ARRAYSIZE(widths); w++) {
+		const uint32_t width = widths[w];
+		lodge_noise_simplex_2d_grid(dst, width, height, origin_x, origin_y, step_x, step_y);
+
+		float error = 0.0f;
+		for(uint32_t row = 0; row < height; row++) {
+			for(uint32_t col = 0; col < width; col++) {
+				const float expected = lodge_noise_simplex_2d(origin_x + (float)col * step_x, origin_y + (float)row * step_y);
+				error = max(error, fabsf(dst[row * width + col] - expected));
+			}
+		}
+		LODGE_TEST_CHECK_MSG(error <= TEST_TOLERANCE, "%s, %ux%u grid: max error %g", test_simd_names[simd], width, height, error);
+	}
+
+	free(dst);
+}
+
+static void test_for_each_simd(void (*func)(enum lodge_noise_simd simd))
+{
+	const enum lodge_noise_simd simd_before = lodge_noise_get_simd();
+
+	for(enum lodge_noise_simd simd = LODGE_NOISE_SIMD_SCALAR; simd < LODGE_NOISE_SIMD_MAX; simd++) {
+		if(!lodge_noise_set_simd(simd)) {
+			printf("     %s not supported, skipped\n", test_simd_names[simd]);
+			continue;
+		}
+		LODGE_TEST_CHECK(lodge_noise_get_simd() == simd);
+		func(simd);
+	}
+
+	lodge_noise_set_simd(simd_before);
+}
+
+static void test_batch_matches_scalar()
+{
+	test_for_each_simd(&test_batch_matches_scalar_impl);
+}
+
+static void test_grid_matches_scalar()
+{
+	test_for_each_simd(&test_grid_matches_scalar_impl);
+}
+
+int main(int argc, char **argv)
+{
+	LODGE_TEST_RUN(test_batch_matches_scalar);
+	LODGE_TEST_RUN(test_grid_matches_scalar);
+	return lodge_test_result();
+}
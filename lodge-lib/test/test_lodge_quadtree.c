@@ -0,0 +1,366 @@
+//
+// Persistent quadtree: the leaves always tile the tree exactly once, nodes split and merge on
+// the right side of their thresholds, the hysteresis band stops a jittering camera from
+// churning nodes, and updating with a camera that does not move changes nothing.
+//
+
+#include "lodge_quadtree.h"
+
+#include "lodge_platform.h"
+#include "lodge_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define TEST_LEAVES_MAX		100000
+
+struct test_leaves;
+
+//
+// Projected size of a node seen from a camera `height` above the plane. Nodes entirely left of
+// `cull_x` count as culled.
+//
+struct test_camera
+{
+	vec2							pos;
+	float							height;
+	float							cull_x;
+	uint32_t						evaluated;
+	struct test_leaves				*leaves;			// Leaves reported by the update.
+};
+
+static float test_metric_calc(const struct test_camera *camera, const vec2 center, const vec2 size)
+{
+	if(center.x + size.x / 2.0f < camera->cull_x) {
+		return -1.0f;
+	}
+	const float dx = center.x - camera->pos.x;
+	const float dy = center.y - camera->pos.y;
+	return size.x / sqrtf(dx * dx + dy * dy + camera->height * camera->height);
+}
+
+static float test_metric(const struct lodge_quadtree *tree, uint32_t node_index, struct test_camera *camera)
+{
+	const struct lodge_quadtree_node *node = &tree->elements[node_index];
+	camera->evaluated++;
+	return test_metric_calc(camera, lodge_quadtree_node_center(tree, node), lodge_quadtree_node_size(tree, node));
+}
+
+struct test_leaf
+{
+	float							x;
+	float							y;
+	float							size;
+};
+
+struct test_leaves
+{
+	struct test_leaf				elements[TEST_LEAVES_MAX];
+	size_t							count;
+	double							area;
+};
+
+static int test_leaf_cmp(const void *lhs, const void *rhs)
+{
+	const struct test_leaf *a = lhs;
+	const struct test_leaf *b = rhs;
+	if(a->x != b->x) {
+		return a->x < b->x ? -1 : 1;
+	}
+	if(a->y != b->y) {
+		return a->y < b->y ? -1 : 1;
+	}
+	return (a->size > b->size) - (a->size < b->size);
+}
+
+static void test_leaves_append(struct test_leaves *leaves, const vec2 center, const vec2 size)
+{
+	if(leaves->count < TEST_LEAVES_MAX) {
+		leaves->elements[leaves->count++] = (struct test_leaf) { center.x, center.y, size.x };
+		leaves->area += (double)size.x * size.y;
+	}
+}
+
+static bool test_visit_leaf(const struct lodge_quadtree *tree, uint32_t node_index, struct test_leaves *leaves)
+{
+	const struct lodge_quadtree_node *node = &tree->elements[node_index];
+	if(!lodge_quadtree_node_is_leaf(node)) {
+		return true;
+	}
+	test_leaves_append(leaves, lodge_quadtree_node_center(tree, node), lodge_quadtree_node_size(tree, node));
+	return false;
+}
+
+static void test_leaves_collect(const struct lodge_quadtree *tree, struct test_leaves *leaves)
+{
+	leaves->count = 0;
+	leaves->area = 0.0;
+	lodge_quadtree_visit(tree, &test_visit_leaf, leaves);
+}
+
+static bool test_update_leaf(const struct lodge_quadtree *tree, uint32_t node_index, struct test_camera *camera)
+{
+	LODGE_TEST_CHECK(lodge_quadtree_node_is_leaf(&tree->elements[node_index]));
+	return test_visit_leaf(tree, node_index, camera->leaves);
+}
+
+//
+// Same rule as `lodge_quadtree_update()` with split == merge, for `lodge_quadtree_make()`.
+//
+struct test_make_params
+{
+	const struct test_camera		*camera;
+	float							threshold;
+	uint32_t						levels_max;
+	struct test_leaves				*leaves;
+};
+
+static bool test_make_is_leaf(const uint32_t level, const vec2 center, const vec2 size, struct test_make_params *params)
+{
+	const float metric = test_metric_calc(params->camera, center, size);
+	const bool is_leaf = metric < 0.0f || metric < params->threshold || level >= params->levels_max;
+	if(is_leaf) {
+		test_leaves_append(params->leaves, center, size);
+	}
+	return is_leaf;
+}
+
+static struct test_leaves test_leaves_a;
+static struct test_leaves test_leaves_b;
+
+static const struct lodge_quadtree_desc test_desc = {
+	.center = { 100.0f, -50.0f },
+	.size = { 16384.0f, 16384.0f },
+	.levels_max = 10,
+	.split_threshold = 1.0f,
+	.merge_threshold = 0.75f,
+};
+
+//
+// The leaves cover the tree without gaps or overlaps: their areas add up, every point is in
+// exactly one, and `find_leaf()` agrees with the visit.
+//
+static void test_leaves_cover_tree(const struct lodge_quadtree *tree)
+{
+	test_leaves_collect(tree, &test_leaves_a);
+	LODGE_TEST_CHECK(test_leaves_a.count == tree->leaves_count);
+
+	const double area = (double)tree->desc.size.x * tree->desc.size.y;
+	LODGE_TEST_CHECK_MSG(fabs(test_leaves_a.area - area) <= area * 1e-9, "leaves area %f, tree area %f", test_leaves_a.area, area);
+
+	for(int i = 0; i < 500; i++) {
+		const vec2 p = vec2_make(
+			tree->desc.center.x + lodge_test_random(-0.5f, 0.5f) * tree->desc.size.x,
+			tree->desc.center.y + lodge_test_random(-0.5f, 0.5f) * tree->desc.size.y
+		);
+
+		uint32_t containing = 0;
+		for(size_t l = 0; l < test_leaves_a.count; l++) {
+			const struct test_leaf *leaf = &test_leaves_a.elements[l];
+			const float half = leaf->size / 2.0f;
+			containing += (p.x >= leaf->x - half && p.x < leaf->x + half && p.y >= leaf->y - half && p.y < leaf->y + half);
+		}
+		LODGE_TEST_CHECK_MSG(containing == 1, "(%f, %f) is in %u leaves", p.x, p.y, containing);
+
+		const uint32_t leaf_index = lodge_quadtree_find_leaf(tree, p);
+		LODGE_TEST_CHECK(leaf_index != LODGE_QUADTREE_NODE_NONE);
+		if(leaf_index != LODGE_QUADTREE_NODE_NONE) {
+			const struct lodge_quadtree_node *leaf = &tree->elements[leaf_index];
+			const vec2 center = lodge_quadtree_node_center(tree, leaf);
+			const vec2 size = lodge_quadtree_node_size(tree, leaf);
+			LODGE_TEST_CHECK(lodge_quadtree_node_is_leaf(leaf));
+			LODGE_TEST_CHECK(fabsf(p.x - center.x) <= size.x / 2.0f && fabsf(p.y - center.y) <= size.y / 2.0f);
+		}
+	}
+
+	LODGE_TEST_CHECK(lodge_quadtree_find_leaf(tree, vec2_make(tree->desc.center.x + tree->desc.size.x, tree->desc.center.y)) == LODGE_QUADTREE_NODE_NONE);
+}
+
+//
+// Leaves are below the split threshold (unless they can not split), and nodes with children
+// are at or above the merge threshold.
+//
+static void test_nodes_respect_thresholds(const struct lodge_quadtree *tree, uint32_t node_index)
+{
+	const struct lodge_quadtree_node *node = &tree->elements[node_index];
+	if(lodge_quadtree_node_is_leaf(node)) {
+		LODGE_TEST_CHECK_MSG(node->metric < tree->desc.split_threshold || node->level >= tree->desc.levels_max,
+			"leaf at level %u has metric %f", node->level, node->metric);
+		return;
+	}
+
+	LODGE_TEST_CHECK_MSG(node->metric >= tree->desc.merge_threshold, "node at level %u has metric %f", node->level, node->metric);
+	for(uint32_t i = 0; i < 4; i++) {
+		const struct lodge_quadtree_node *child = &tree->elements[node->children + i];
+		LODGE_TEST_CHECK(child->parent == node_index);
+		LODGE_TEST_CHECK(child->level == node->level + 1);
+		LODGE_TEST_CHECK(child->x == ((node->x << 1) | (i & 1)) && child->y == ((node->y << 1) | (i >> 1)));
+		test_nodes_respect_thresholds(tree, node->children + i);
+	}
+}
+
+static void test_quadtree_leaf_coverage()
+{
+	struct lodge_quadtree tree;
+	lodge_quadtree_new_inplace(&tree, test_desc);
+
+	struct test_camera camera = { .height = 50.0f, .cull_x = -4000.0f, .leaves = &test_leaves_b };
+	for(int frame = 0; frame < 200; frame++) {
+		camera.pos = vec2_make(6000.0f * cosf(frame * 0.02f), 6000.0f * sinf(frame * 0.031f));
+		test_leaves_b.count = 0;
+		test_leaves_b.area = 0.0;
+		lodge_quadtree_update(&tree, &test_metric, &test_update_leaf, &camera);
+
+		//
+		// The update reports the same leaves as a visit, in the same order.
+		//
+		test_leaves_collect(&tree, &test_leaves_a);
+		LODGE_TEST_CHECK(test_leaves_a.count == test_leaves_b.count);
+		LODGE_TEST_CHECK(memcmp(test_leaves_a.elements, test_leaves_b.elements, min(test_leaves_a.count, test_leaves_b.count) * sizeof(struct test_leaf)) == 0);
+
+		if(frame % 20 == 0) {
+			test_leaves_cover_tree(&tree);
+			test_nodes_respect_thresholds(&tree, 0);
+		}
+	}
+
+	lodge_quadtree_reset(&tree);
+	LODGE_TEST_CHECK(tree.leaves_count == 1);
+	test_leaves_cover_tree(&tree);
+
+	lodge_quadtree_free_inplace(&tree);
+}
+
+//
+// Without a hysteresis band the tree has the same leaves as a full rebuild.
+//
+static void test_quadtree_matches_rebuild()
+{
+	struct lodge_quadtree_desc desc = test_desc;
+	desc.merge_threshold = desc.split_threshold;
+
+	struct lodge_quadtree tree;
+	lodge_quadtree_new_inplace(&tree, desc);
+
+	struct test_camera camera = { .height = 50.0f, .cull_x = -4000.0f };
+	for(int frame = 0; frame < 100; frame++) {
+		camera.pos = vec2_make(6000.0f * cosf(frame * 0.05f), 6000.0f * sinf(frame * 0.07f));
+		lodge_quadtree_update(&tree, &test_metric, NULL, &camera);
+		test_leaves_collect(&tree, &test_leaves_a);
+
+		test_leaves_b.count = 0;
+		test_leaves_b.area = 0.0;
+		struct test_make_params params = {
+			.camera = &camera,
+			.threshold = desc.split_threshold,
+			.levels_max = desc.levels_max,
+			.leaves = &test_leaves_b,
+		};
+		lodge_quadtree_make(desc.center, desc.size, &test_make_is_leaf, &params);
+
+		LODGE_TEST_CHECK_MSG(test_leaves_a.count == test_leaves_b.count, "frame %d: %zu leaves, rebuild has %zu", frame, test_leaves_a.count, test_leaves_b.count);
+		if(test_leaves_a.count == test_leaves_b.count) {
+			qsort(test_leaves_a.elements, test_leaves_a.count, sizeof(struct test_leaf), &test_leaf_cmp);
+			qsort(test_leaves_b.elements, test_leaves_b.count, sizeof(struct test_leaf), &test_leaf_cmp);
+			LODGE_TEST_CHECK_MSG(memcmp(test_leaves_a.elements, test_leaves_b.elements, test_leaves_a.count * sizeof(struct test_leaf)) == 0, "frame %d", frame);
+		}
+	}
+
+	lodge_quadtree_free_inplace(&tree);
+}
+
+//
+// A camera shaking back and forth by a few units keeps crossing the split threshold of some
+// nodes. With merging at 0.75 of the split threshold nothing changes after the first frames;
+// with a single threshold nodes keep popping.
+//
+static void test_quadtree_hysteresis()
+{
+	struct lodge_quadtree_desc desc_single = test_desc;
+	desc_single.merge_threshold = desc_single.split_threshold;
+
+	struct lodge_quadtree tree_hysteresis;
+	struct lodge_quadtree tree_single;
+	lodge_quadtree_new_inplace(&tree_hysteresis, test_desc);
+	lodge_quadtree_new_inplace(&tree_single, desc_single);
+
+	uint32_t changes_hysteresis = 0;
+	uint32_t changes_single = 0;
+
+	struct test_camera camera = { .height = 50.0f, .cull_x = -4000.0f };
+	for(int frame = 0; frame < 200; frame++) {
+		camera.pos = vec2_make(1000.0f + ((frame & 1) ? 2.0f : -2.0f), 500.0f);
+		lodge_quadtree_update(&tree_hysteresis, &test_metric, NULL, &camera);
+		lodge_quadtree_update(&tree_single, &test_metric, NULL, &camera);
+
+		if(frame >= 2) {
+			changes_hysteresis += tree_hysteresis.splits + tree_hysteresis.merges;
+			changes_single += tree_single.splits + tree_single.merges;
+		}
+	}
+
+	LODGE_TEST_CHECK_MSG(changes_hysteresis == 0, "%u splits and merges with hysteresis", changes_hysteresis);
+	LODGE_TEST_CHECK_MSG(changes_single > 0, "the camera never crossed a threshold, the test proves nothing");
+	test_nodes_respect_thresholds(&tree_hysteresis, 0);
+
+	lodge_quadtree_free_inplace(&tree_hysteresis);
+	lodge_quadtree_free_inplace(&tree_single);
+}
+
+//
+// Updating again with the same camera splits and merges nothing and keeps every node where it
+// is, and the pool stops growing once merged blocks are reused.
+//
+static void test_quadtree_static_camera()
+{
+	struct lodge_quadtree tree;
+	lodge_quadtree_new_inplace(&tree, test_desc);
+
+	struct test_camera camera = { .pos = { -300.0f, 1200.0f }, .height = 50.0f, .cull_x = -4000.0f };
+	lodge_quadtree_update(&tree, &test_metric, NULL, &camera);
+	LODGE_TEST_CHECK(tree.splits > 0);
+
+	const size_t count = tree.count;
+	struct lodge_quadtree_node *nodes = malloc(count * sizeof(struct lodge_quadtree_node));
+	memcpy(nodes, tree.elements, count * sizeof(struct lodge_quadtree_node));
+	const uint32_t leaves_count = tree.leaves_count;
+
+	for(int i = 0; i < 10; i++) {
+		lodge_quadtree_update(&tree, &test_metric, NULL, &camera);
+		LODGE_TEST_CHECK_MSG(tree.splits == 0 && tree.merges == 0, "update %d: %u splits, %u merges", i, tree.splits, tree.merges);
+	}
+	LODGE_TEST_CHECK(tree.count == count);
+	LODGE_TEST_CHECK(tree.leaves_count == leaves_count);
+	LODGE_TEST_CHECK(memcmp(nodes, tree.elements, count * sizeof(struct lodge_quadtree_node)) == 0);
+	free(nodes);
+
+	//
+	// Circling the tree, merged blocks are reused: the pool never holds more blocks than could
+	// have been in use at once (those before an update plus the ones it split).
+	//
+	uint32_t blocks_max = (tree.leaves_count - 1) / 3;
+	uint32_t splits = 0;
+	for(int frame = 0; frame < 1000; frame++) {
+		const uint32_t blocks_before = (tree.leaves_count - 1) / 3;
+		camera.pos = vec2_make(7000.0f * cosf(frame * 0.0126f), 7000.0f * sinf(frame * 0.0126f));
+		lodge_quadtree_update(&tree, &test_metric, NULL, &camera);
+		blocks_max = max(blocks_max, blocks_before + tree.splits);
+		splits += tree.splits;
+		LODGE_TEST_CHECK(tree.count == 1 + 4 * (tree.free_blocks.count + (tree.leaves_count - 1) / 3));
+	}
+	LODGE_TEST_CHECK_MSG(tree.count <= 1 + 4 * blocks_max, "%zu nodes in the pool, at most %u blocks were used", tree.count, blocks_max);
+	LODGE_TEST_CHECK(blocks_max < splits);
+	test_leaves_cover_tree(&tree);
+
+	lodge_quadtree_free_inplace(&tree);
+}
+
+int main(int argc, char **argv)
+{
+	LODGE_TEST_RUN(test_quadtree_leaf_coverage);
+	LODGE_TEST_RUN(test_quadtree_matches_rebuild);
+	LODGE_TEST_RUN(test_quadtree_hysteresis);
+	LODGE_TEST_RUN(test_quadtree_static_camera);
+	return lodge_test_result();
+}
@@ -0,0 +1,128 @@
+#include "lodge_mesh.h"
+
+#include "dynbuf.h"
+#include "lodge_hash.h"
+#include "lodge_assert.h"
+#include "lodge_platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#define LODGE_MESH_WELD_EMPTY UINT32_MAX
+
+_Static_assert(sizeof(struct lodge_mesh_vertex) == 8 * sizeof(float), "lodge_mesh_vertex is hashed and compared bytewise");
+
+void lodge_mesh_free_inplace(struct lodge_mesh *mesh)
+{
+	dynbuf_free_inplace(dynbuf(mesh->vertices));
+	dynbuf_free_inplace(dynbuf(mesh->indices));
+	mesh->lods_count = 0;
+}
+
+static void lodge_mesh_vertex_canonicalize(struct lodge_mesh_vertex *vertex)
+{
+	float *it = (float *)vertex;
+	for(size_t i = 0; i < sizeof(*vertex) / sizeof(float); i++) {
+		if(it[i] == 0.0f) {
+			it[i] = 0.0f;
+		}
+	}
+}
+
+void lodge_mesh_weld(struct lodge_mesh *mesh)
+{
+	const size_t vertices_count = mesh->vertices.count;
+	if(vertices_count == 0) {
+		return;
+	}
+	ASSERT_OR(vertices_count < LODGE_MESH_WELD_EMPTY) { return; }
+
+	size_t table_size = 16;
+	while(table_size < vertices_count * 2) {
+		table_size *= 2;
+	}
+
+	uint32_t *table = (uint32_t *)malloc(table_size * sizeof(uint32_t));
+	uint32_t *remap = (uint32_t *)malloc(vertices_count * sizeof(uint32_t));
+	ASSERT_OR(table && remap) {
+		free(table);
+		free(remap);
+		return;
+	}
+	memset(table, 0xff, table_size * sizeof(uint32_t));
+
+	//
+	// Unique vertices are compacted to the front as they are found; `unique_count` never
+	// passes `i`, so this never overwrites a vertex that has not been visited yet.
+	//
+	struct lodge_mesh_vertex *vertices = mesh->vertices.elements;
+	uint32_t unique_count = 0;
+
+	for(size_t i = 0; i < vertices_count; i++) {
+		struct lodge_mesh_vertex vertex = vertices[i];
+		lodge_mesh_vertex_canonicalize(&vertex);
+
+		size_t slot = lodge_hash_murmur3_32(&vertex, sizeof(vertex)) & (table_size - 1);
+		while(table[slot] != LODGE_MESH_WELD_EMPTY && memcmp(&vertices[table[slot]], &vertex, sizeof(vertex)) != 0) {
+			slot = (slot + 1) & (table_size - 1);
+		}
+
+		if(table[slot] == LODGE_MESH_WELD_EMPTY) {
+			table[slot] = unique_count;
+			vertices[unique_count++] = vertex;
+		}
+		remap[i] = table[slot];
+	}
+
+	for(size_t i = 0; i < mesh->indices.count; i++) {
+		ASSERT(mesh->indices.elements[i] < vertices_count);
+		mesh->indices.elements[i] = remap[mesh->indices.elements[i]];
+	}
+	mesh->vertices.count = unique_count;
+
+	free(remap);
+	free(table);
+}
+
+uint32_t lodge_mesh_lod_select(const struct lodge_mesh_lod *lods, uint32_t lods_count, float distance)
+{
+	uint32_t lod = 0;
+	while(lod + 1 < lods_count && distance >= lods[lod + 1].distance) {
+		lod++;
+	}
+	return lod;
+}
+
+struct aabb lodge_mesh_calc_bounds(const struct lodge_mesh *mesh)
+{
+	if(mesh->vertices.count == 0) {
+		return (struct aabb) { 0 };
+	}
+
+	struct aabb bounds = {
+		.min = vec3_make(FLT_MAX, FLT_MAX, FLT_MAX),
+		.max = vec3_make(-FLT_MAX, -FLT_MAX, -FLT_MAX),
+	};
+	for(size_t i = 0; i < mesh->vertices.count; i++) {
+		bounds.min = vec3_min(bounds.min, mesh->vertices.elements[i].position);
+		bounds.max = vec3_max(bounds.max, mesh->vertices.elements[i].position);
+	}
+	return bounds;
+}
+
+struct sphere lodge_mesh_calc_bounding_sphere(const struct lodge_mesh *mesh, struct aabb bounds)
+{
+	const vec3 center = vec3_mult_scalar(vec3_add(bounds.min, bounds.max), 0.5f);
+
+	float r_squared = 0.0f;
+	for(size_t i = 0; i < mesh->vertices.count; i++) {
+		r_squared = max(r_squared, vec3_distance_squared(center, mesh->vertices.elements[i].position));
+	}
+
+	return (struct sphere) {
+		.pos = center,
+		.r = sqrtf(r_squared),
+	};
+}
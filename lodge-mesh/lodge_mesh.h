@@ -0,0 +1,75 @@
+//
+// CPU side triangle mesh, as used by the mesh import and cook steps.
+//
+#ifndef _LODGE_MESH_H
+#define _LODGE_MESH_H
+
+#include "math4.h"
+#include "geometry.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LODGE_MESH_LODS_MAX					8
+
+struct lodge_mesh_vertex
+{
+	vec3								position;
+	vec3								normal;
+	vec2								tex_coord;
+};
+
+struct lodge_mesh_lod
+{
+	uint32_t							indices_offset;
+	uint32_t							indices_count;
+	float								error;			// Object space deviation from the full mesh.
+	float								distance;		// Object space distance to switch to this LOD at.
+};
+
+struct lodge_mesh
+{
+	struct
+	{
+		size_t							capacity;
+		size_t							count;
+		struct lodge_mesh_vertex		*elements;
+	} vertices;
+
+	struct
+	{
+		size_t							capacity;
+		size_t							count;
+		uint32_t						*elements;		// Triangle list.
+	} indices;
+
+	//
+	// Ranges of `indices`, all indexing the same vertices. `lods[0]` is the full mesh,
+	// coarser LODs follow it. 0 means there are no LODs, just the full mesh.
+	//
+	uint32_t							lods_count;
+	struct lodge_mesh_lod				lods[LODGE_MESH_LODS_MAX];
+};
+
+void									lodge_mesh_free_inplace(struct lodge_mesh *mesh);
+
+//
+// Merges vertices with bit-identical attributes (`-0.0` and `0.0` count as equal) and
+// remaps the indices. Vertices keep the order of their first occurrence, so the result
+// only depends on the input.
+//
+void									lodge_mesh_weld(struct lodge_mesh *mesh);
+
+//
+// The coarsest LOD whose `distance` has been reached. `lods` must be sorted by distance.
+//
+uint32_t								lodge_mesh_lod_select(const struct lodge_mesh_lod *lods, uint32_t lods_count, float distance);
+
+struct aabb								lodge_mesh_calc_bounds(const struct lodge_mesh *mesh);
+
+//
+// Centered on the bounds, which is not minimal but cheap and deterministic.
+//
+struct sphere							lodge_mesh_calc_bounding_sphere(const struct lodge_mesh *mesh, struct aabb bounds);
+
+#endif
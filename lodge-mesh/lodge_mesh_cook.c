@@ -0,0 +1,123 @@
+#include "lodge_mesh_cook.h"
+
+#include "lodge_mesh.h"
+#include "lodge_mesh_file.h"
+
+#include "lodge_assert.h"
+#include "lodge_log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t lodge_mesh_cook_align(uint64_t offset, uint64_t alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+static void lodge_mesh_cook_write_floats(char *dst, const float *src, uint32_t count, enum lodge_mesh_attrib_format format)
+{
+	if(format == LODGE_MESH_ATTRIB_FORMAT_FLOAT16) {
+		for(uint32_t i = 0; i < count; i++) {
+			const uint16_t h = lodge_mesh_half_from_float(src[i]);
+			memcpy(dst + i * sizeof(uint16_t), &h, sizeof(h));
+		}
+	} else {
+		memcpy(dst, src, count * sizeof(float));
+	}
+}
+
+void* lodge_mesh_cook(const struct lodge_mesh *mesh, const struct lodge_mesh_cook_desc *desc, size_t *size)
+{
+	ASSERT_OR(mesh && desc && size) { return NULL; }
+
+	if(mesh->vertices.count > UINT32_MAX || mesh->indices.count > UINT32_MAX) {
+		errorf("Mesh", "Too many vertices to cook: %zu\n", mesh->vertices.count);
+		return NULL;
+	}
+
+	const enum lodge_mesh_attrib_format format = desc->half_floats ? LODGE_MESH_ATTRIB_FORMAT_FLOAT16 : LODGE_MESH_ATTRIB_FORMAT_FLOAT32;
+	const uint32_t component_size = desc->half_floats ? sizeof(uint16_t) : sizeof(float);
+
+	struct lodge_mesh_file_header header = {
+		.magic = { 'L', 'M', 'S', 'H' },
+		.version = LODGE_MESH_FILE_VERSION,
+		.vertices_count = (uint32_t)mesh->vertices.count,
+		.indices_count = (uint32_t)mesh->indices.count,
+		.index_size = (!desc->index32 && mesh->vertices.count <= UINT16_MAX + 1) ? sizeof(uint16_t) : sizeof(uint32_t),
+	};
+
+	//
+	// Every attribute starts on a 4 byte boundary.
+	//
+	header.attribs[LODGE_MESH_ATTRIB_POSITION] = (struct lodge_mesh_file_attrib) {
+		.format = LODGE_MESH_ATTRIB_FORMAT_FLOAT32,
+		.components = 3,
+		.offset = 0,
+	};
+	header.attribs[LODGE_MESH_ATTRIB_NORMAL] = (struct lodge_mesh_file_attrib) {
+		.format = format,
+		.components = 3,
+		.offset = 3 * sizeof(float),
+	};
+	header.attribs[LODGE_MESH_ATTRIB_TEX_COORD] = (struct lodge_mesh_file_attrib) {
+		.format = format,
+		.components = 2,
+		.offset = header.attribs[LODGE_MESH_ATTRIB_NORMAL].offset + (uint32_t)lodge_mesh_cook_align(3 * component_size, 4),
+	};
+	header.vertex_stride = header.attribs[LODGE_MESH_ATTRIB_TEX_COORD].offset + 2 * component_size;
+
+	//
+	// A mesh without LODs is cooked as its own LOD 0.
+	//
+	if(mesh->lods_count == 0) {
+		header.lods_count = 1;
+		header.lods[0] = (struct lodge_mesh_file_lod) {
+			.indices_offset = 0,
+			.indices_count = header.indices_count,
+		};
+	} else {
+		ASSERT_OR(mesh->lods_count <= LODGE_MESH_LODS_MAX) { return NULL; }
+		header.lods_count = mesh->lods_count;
+		for(uint32_t i = 0; i < mesh->lods_count; i++) {
+			header.lods[i] = (struct lodge_mesh_file_lod) {
+				.indices_offset = mesh->lods[i].indices_offset,
+				.indices_count = mesh->lods[i].indices_count,
+				.error = mesh->lods[i].error,
+				.distance = mesh->lods[i].distance,
+			};
+		}
+	}
+
+	header.bounds = lodge_mesh_calc_bounds(mesh);
+	header.bounding_sphere = lodge_mesh_calc_bounding_sphere(mesh, header.bounds);
+
+	header.vertices_offset = lodge_mesh_cook_align(sizeof(struct lodge_mesh_file_header), LODGE_MESH_FILE_ALIGNMENT);
+	header.indices_offset = lodge_mesh_cook_align(header.vertices_offset + (uint64_t)header.vertices_count * header.vertex_stride, LODGE_MESH_FILE_ALIGNMENT);
+	const uint64_t file_size = header.indices_offset + (uint64_t)header.indices_count * header.index_size;
+
+	char *data = (char *)calloc(1, (size_t)file_size);
+	ASSERT_OR(data) { return NULL; }
+
+	memcpy(data, &header, sizeof(header));
+
+	char *vertex_it = data + header.vertices_offset;
+	for(size_t i = 0; i < mesh->vertices.count; i++, vertex_it += header.vertex_stride) {
+		const struct lodge_mesh_vertex *vertex = &mesh->vertices.elements[i];
+		lodge_mesh_cook_write_floats(vertex_it + header.attribs[LODGE_MESH_ATTRIB_POSITION].offset, vertex->position.v, 3, LODGE_MESH_ATTRIB_FORMAT_FLOAT32);
+		lodge_mesh_cook_write_floats(vertex_it + header.attribs[LODGE_MESH_ATTRIB_NORMAL].offset, vertex->normal.v, 3, format);
+		lodge_mesh_cook_write_floats(vertex_it + header.attribs[LODGE_MESH_ATTRIB_TEX_COORD].offset, vertex->tex_coord.v, 2, format);
+	}
+
+	char *index_it = data + header.indices_offset;
+	if(header.index_size == sizeof(uint16_t)) {
+		for(size_t i = 0; i < mesh->indices.count; i++) {
+			const uint16_t index = (uint16_t)mesh->indices.elements[i];
+			memcpy(index_it + i * sizeof(uint16_t), &index, sizeof(index));
+		}
+	} else {
+		memcpy(index_it, mesh->indices.elements, mesh->indices.count * sizeof(uint32_t));
+	}
+
+	*size = (size_t)file_size;
+	return data;
+}
@@ -0,0 +1,23 @@
+#ifndef _LODGE_MESH_COOK_H
+#define _LODGE_MESH_COOK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct lodge_mesh;
+
+struct lodge_mesh_cook_desc
+{
+	bool				half_floats;	// Store normals and tex coords as 16-bit floats (positions always stay 32-bit).
+	bool				index32;		// Use 32-bit indices even when 16 bits would do.
+};
+
+//
+// Encodes `mesh` as a `.lmesh` file image (see `lodge_mesh_file.h`). Padding is zeroed, so
+// the same mesh and desc always produce the same bytes.
+//
+// Returns a malloc'd buffer of `size` bytes, or NULL.
+//
+void*					lodge_mesh_cook(const struct lodge_mesh *mesh, const struct lodge_mesh_cook_desc *desc, size_t *size);
+
+#endif
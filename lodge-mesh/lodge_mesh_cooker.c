@@ -0,0 +1,157 @@
+//
+// lodge-mesh-cooker: converts the first mesh of an FBX file into a `.lmesh` file that the
+// `mesh` asset type can upload without any further processing.
+//
+// Usage: lodge-mesh-cooker [--half] [--index32] [--no-optimize] [--lods <count>]
+//                          [--lod-error <ratio>] [--pixel-error <pixels>] <input.fbx> <output.lmesh>
+//
+// Generates up to `--lods` LODs (default 4, 1 turns them off), each allowed to deviate
+// `--lod-error` of the bounding radius at most, and switching once that is below
+// `--pixel-error` pixels on a 1080p screen. See `lodge_mesh_simplify.h`.
+//
+// Triangles and vertices are reordered for the vertex caches unless `--no-optimize` is given.
+//
+// The output only depends on the input and the flags, so cooked files can be checked in
+// and compared byte for byte.
+//
+
+#include "lodge_mesh.h"
+#include "lodge_mesh_fbx.h"
+#include "lodge_mesh_cook.h"
+#include "lodge_mesh_optimize.h"
+#include "lodge_mesh_simplify.h"
+#include "lodge_mesh_file.h"
+
+#include "fbx.h"
+
+#include "stb/deprecated/stb.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void lodge_mesh_cooker_usage()
+{
+	fprintf(stderr, "Usage: lodge-mesh-cooker [--half] [--index32] [--no-optimize] [--lods <count>] [--lod-error <ratio>] [--pixel-error <pixels>] <input.fbx> <output" LODGE_MESH_FILE_EXTENSION ">\n");
+}
+
+static bool lodge_mesh_cooker_write(const char *output_path, const void *data, size_t size)
+{
+	FILE *file = fopen(output_path, "wb");
+	if(!file) {
+		fprintf(stderr, "Could not open `%s` for writing\n", output_path);
+		return false;
+	}
+
+	bool ok = fwrite(data, 1, size, file) == size;
+	if(fclose(file) != 0) {
+		ok = false;
+	}
+	if(!ok) {
+		fprintf(stderr, "Failed to write `%s`\n", output_path);
+	}
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	struct lodge_mesh_cook_desc desc = { 0 };
+	struct lodge_mesh_lods_desc lods_desc = { .count = 4 };
+	bool optimize = true;
+	const char *input_path = NULL;
+	const char *output_path = NULL;
+
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--half") == 0) {
+			desc.half_floats = true;
+		} else if(strcmp(argv[i], "--index32") == 0) {
+			desc.index32 = true;
+		} else if(strcmp(argv[i], "--no-optimize") == 0) {
+			optimize = false;
+		} else if(strcmp(argv[i], "--lods") == 0 && i + 1 < argc) {
+			lods_desc.count = (uint32_t)atoi(argv[++i]);
+			if(lods_desc.count == 0 || lods_desc.count > LODGE_MESH_LODS_MAX) {
+				fprintf(stderr, "--lods must be between 1 and %d\n", LODGE_MESH_LODS_MAX);
+				return 1;
+			}
+		} else if(strcmp(argv[i], "--lod-error") == 0 && i + 1 < argc) {
+			lods_desc.max_error = (float)atof(argv[++i]);
+		} else if(strcmp(argv[i], "--pixel-error") == 0 && i + 1 < argc) {
+			lods_desc.pixel_error = (float)atof(argv[++i]);
+		} else if(!input_path) {
+			input_path = argv[i];
+		} else if(!output_path) {
+			output_path = argv[i];
+		} else {
+			lodge_mesh_cooker_usage();
+			return 1;
+		}
+	}
+
+	if(!input_path || !output_path) {
+		lodge_mesh_cooker_usage();
+		return 1;
+	}
+
+	size_t input_size = 0;
+	char *input = stb_file((char *)input_path, &input_size);
+	if(!input) {
+		fprintf(stderr, "Could not read `%s`\n", input_path);
+		return 1;
+	}
+
+	struct fbx *fbx = fbx_new(input, input_size);
+	if(!fbx) {
+		fprintf(stderr, "Could not parse `%s`\n", input_path);
+		free(input);
+		return 1;
+	}
+
+	struct lodge_mesh mesh;
+	if(!lodge_mesh_new_from_fbx_inplace(&mesh, fbx)) {
+		fprintf(stderr, "Could not read a mesh from `%s`\n", input_path);
+		fbx_free(fbx);
+		free(input);
+		return 1;
+	}
+	fbx_free(fbx);
+	free(input);
+
+	const size_t corners_count = mesh.vertices.count;
+	lodge_mesh_weld(&mesh);
+
+	const float acmr_before = lodge_mesh_calc_acmr(mesh.indices.elements, mesh.indices.count, mesh.vertices.count, LODGE_MESH_VERTEX_CACHE_SIZE);
+
+	//
+	// Before optimizing, so every LOD gets its own triangle order and the vertices are
+	// fetched in LOD 0 order.
+	//
+	if(!lodge_mesh_generate_lods(&mesh, &lods_desc)) {
+		fprintf(stderr, "Could not generate LODs for `%s`\n", input_path);
+		lodge_mesh_free_inplace(&mesh);
+		return 1;
+	}
+	if(optimize) {
+		lodge_mesh_optimize_vertex_cache(&mesh);
+		lodge_mesh_optimize_vertex_fetch(&mesh);
+	}
+	const float acmr_after = lodge_mesh_calc_acmr(mesh.indices.elements, mesh.lods[0].indices_count, mesh.vertices.count, LODGE_MESH_VERTEX_CACHE_SIZE);
+
+	size_t size = 0;
+	void *cooked = lodge_mesh_cook(&mesh, &desc, &size);
+	bool ok = cooked && lodge_mesh_cooker_write(output_path, cooked, size);
+
+	if(ok) {
+		printf("%s: %zu triangles, %zu vertices (welded from %zu), ACMR %.3f -> %.3f, %zu bytes\n", output_path,
+			mesh.lods[0].indices_count / 3, mesh.vertices.count, corners_count, acmr_before, acmr_after, size);
+		for(uint32_t i = 1; i < mesh.lods_count; i++) {
+			printf("  LOD %u: %u triangles, error %g, from distance %g\n", i,
+				mesh.lods[i].indices_count / 3, mesh.lods[i].error, mesh.lods[i].distance);
+		}
+	}
+
+	free(cooked);
+	lodge_mesh_free_inplace(&mesh);
+
+	return ok ? 0 : 1;
+}
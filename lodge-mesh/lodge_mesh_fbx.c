@@ -0,0 +1,245 @@
+#include "lodge_mesh_fbx.h"
+
+#include "lodge_mesh.h"
+
+#include "fbx.h"
+#include "dynbuf.h"
+#include "strview.h"
+#include "lodge_log.h"
+#include "lodge_assert.h"
+#include "lodge_platform.h"
+
+#include <string.h>
+
+struct lodge_mesh_fbx_layer
+{
+	const double			*data;
+	uint32_t				data_count;
+	const int32_t			*indices;
+	uint32_t				indices_count;
+	enum fbx_mapping_type	mapping_type;
+	enum fbx_ref_type		ref_type;
+	uint32_t				components;
+};
+
+static const struct fbx_property* lodge_mesh_fbx_find_property(struct fbx *fbx, const char *path[], size_t path_count, enum fbx_property_type type)
+{
+	struct fbx_node *node = fbx_find_node(fbx, path, path_count);
+	if(node) {
+		const uint64_t property_count = fbx_node_get_property_count(node);
+		for(uint64_t i = 0; i < property_count; i++) {
+			const struct fbx_property *prop = fbx_node_get_property(node, i);
+			if(fbx_property_get_type(prop) == type) {
+				return prop;
+			}
+		}
+	}
+	return NULL;
+}
+
+static strview_t lodge_mesh_fbx_find_string(struct fbx *fbx, const char *path[], size_t path_count)
+{
+	const struct fbx_property *prop = lodge_mesh_fbx_find_property(fbx, path, path_count, FBX_PROPERTY_TYPE_STRING);
+	if(!prop) {
+		return strview_make(NULL, 0);
+	}
+	const struct fbx_string str = fbx_property_get_string(prop);
+	return strview_make(str.data, str.length);
+}
+
+static enum fbx_mapping_type lodge_mesh_fbx_mapping_type_from_strview(strview_t mapping_type)
+{
+	if(strview_equals(mapping_type, strview_static("ByPolygon"))) {
+		return FBX_MAPPING_TYPE_BY_POLYGON;
+	} else if(strview_equals(mapping_type, strview_static("ByPolygonVertex"))) {
+		return FBX_MAPPING_TYPE_BY_POLYGON_VERTEX;
+	} else if(strview_equals(mapping_type, strview_static("ByVertex")) || strview_equals(mapping_type, strview_static("ByVertice"))) {
+		return FBX_MAPPING_TYPE_BY_VERTEX;
+	} else if(strview_equals(mapping_type, strview_static("AllSame"))) {
+		return FBX_MAPPING_TYPE_ALL_SAME;
+	}
+	return FBX_MAPPING_TYPE_MAX;
+}
+
+static enum fbx_ref_type lodge_mesh_fbx_ref_type_from_strview(strview_t ref_type)
+{
+	if(strview_equals(ref_type, strview_static("Direct"))) {
+		return FBX_REF_TYPE_DIRECT;
+	} else if(strview_equals(ref_type, strview_static("IndexToDirect")) || strview_equals(ref_type, strview_static("Index"))) {
+		return FBX_REF_TYPE_INDEX_TO_DIRECT;
+	}
+	return FBX_REF_TYPE_MAX;
+}
+
+//
+// Returns false if the layer is missing, and sets `layer->components` to 0.
+//
+static bool lodge_mesh_fbx_layer_make(struct lodge_mesh_fbx_layer *layer, struct fbx *fbx, const char *layer_name, const char *data_name, const char *indices_name, uint32_t components)
+{
+	*layer = (struct lodge_mesh_fbx_layer) { 0 };
+
+	const char* path_mapping_type[] = { "Objects", "Geometry", layer_name, "MappingInformationType" };
+	const char* path_ref_type[] = { "Objects", "Geometry", layer_name, "ReferenceInformationType" };
+	const char* path_data[] = { "Objects", "Geometry", layer_name, data_name };
+	const char* path_indices[] = { "Objects", "Geometry", layer_name, indices_name };
+
+	const struct fbx_property *data_prop = lodge_mesh_fbx_find_property(fbx, path_data, LODGE_ARRAYSIZE(path_data), FBX_PROPERTY_TYPE_ARRAY_DOUBLE);
+	if(!data_prop) {
+		return false;
+	}
+
+	layer->data = fbx_property_get_array_double(data_prop);
+	layer->data_count = fbx_property_get_array_count(data_prop);
+	layer->mapping_type = lodge_mesh_fbx_mapping_type_from_strview(lodge_mesh_fbx_find_string(fbx, path_mapping_type, LODGE_ARRAYSIZE(path_mapping_type)));
+	layer->ref_type = lodge_mesh_fbx_ref_type_from_strview(lodge_mesh_fbx_find_string(fbx, path_ref_type, LODGE_ARRAYSIZE(path_ref_type)));
+	layer->components = components;
+
+	if(layer->ref_type == FBX_REF_TYPE_INDEX_TO_DIRECT) {
+		const struct fbx_property *indices_prop = lodge_mesh_fbx_find_property(fbx, path_indices, LODGE_ARRAYSIZE(path_indices), FBX_PROPERTY_TYPE_ARRAY_INT32);
+		if(indices_prop) {
+			layer->indices = fbx_property_get_array_int32(indices_prop);
+			layer->indices_count = fbx_property_get_array_count(indices_prop);
+		}
+	}
+
+	return layer->data != NULL;
+}
+
+static bool lodge_mesh_fbx_layer_get(const struct lodge_mesh_fbx_layer *layer, uint32_t corner, uint32_t control_point, uint32_t polygon, float *dst)
+{
+	uint32_t index;
+	switch(layer->mapping_type) {
+	case FBX_MAPPING_TYPE_BY_POLYGON_VERTEX:
+		index = corner;
+		break;
+	case FBX_MAPPING_TYPE_BY_VERTEX:
+		index = control_point;
+		break;
+	case FBX_MAPPING_TYPE_BY_POLYGON:
+		index = polygon;
+		break;
+	case FBX_MAPPING_TYPE_ALL_SAME:
+		index = 0;
+		break;
+	default:
+		return false;
+	}
+
+	if(layer->ref_type == FBX_REF_TYPE_INDEX_TO_DIRECT) {
+		if(!layer->indices || index >= layer->indices_count || layer->indices[index] < 0) {
+			return false;
+		}
+		index = (uint32_t)layer->indices[index];
+	} else if(layer->ref_type != FBX_REF_TYPE_DIRECT) {
+		return false;
+	}
+
+	if((uint64_t)index * layer->components + layer->components > layer->data_count) {
+		return false;
+	}
+
+	for(uint32_t i = 0; i < layer->components; i++) {
+		dst[i] = (float)layer->data[(size_t)index * layer->components + i];
+	}
+	return true;
+}
+
+static int32_t lodge_mesh_fbx_get_up_axis(struct fbx *fbx)
+{
+	static const char* path_global_settings[] = { "GlobalSettings" };
+	if(fbx_find_node(fbx, path_global_settings, LODGE_ARRAYSIZE(path_global_settings))) {
+		const int32_t *up_axis = fbx_get_typed_property_int32(fbx, path_global_settings, LODGE_ARRAYSIZE(path_global_settings), "UpAxis");
+		if(up_axis) {
+			return *up_axis;
+		}
+	}
+	return 1;
+}
+
+static vec3 lodge_mesh_fbx_swizzle(const float v[3], bool swap_y_z)
+{
+	return swap_y_z ? vec3_make(v[0], v[2], v[1]) : vec3_make(v[0], v[1], v[2]);
+}
+
+bool lodge_mesh_new_from_fbx_inplace(struct lodge_mesh *mesh, struct fbx *fbx)
+{
+	*mesh = (struct lodge_mesh) { 0 };
+
+	static const char* path_vertices[] = { "Objects", "Geometry", "Vertices" };
+	static const char* path_indices[] = { "Objects", "Geometry", "PolygonVertexIndex" };
+
+	const struct fbx_property *vertices_prop = lodge_mesh_fbx_find_property(fbx, path_vertices, LODGE_ARRAYSIZE(path_vertices), FBX_PROPERTY_TYPE_ARRAY_DOUBLE);
+	const struct fbx_property *indices_prop = lodge_mesh_fbx_find_property(fbx, path_indices, LODGE_ARRAYSIZE(path_indices), FBX_PROPERTY_TYPE_ARRAY_INT32);
+	if(!vertices_prop || !indices_prop) {
+		lodge_log(LODGE_LOG_LEVEL_ERROR, strview("Mesh"), strview("FBX has no geometry\n"));
+		return false;
+	}
+
+	const struct lodge_mesh_fbx_layer positions = {
+		.data = fbx_property_get_array_double(vertices_prop),
+		.data_count = fbx_property_get_array_count(vertices_prop),
+		.mapping_type = FBX_MAPPING_TYPE_BY_VERTEX,
+		.ref_type = FBX_REF_TYPE_DIRECT,
+		.components = 3,
+	};
+	const int32_t *polygon_vertex_indices = fbx_property_get_array_int32(indices_prop);
+	const uint32_t polygon_vertex_indices_count = fbx_property_get_array_count(indices_prop);
+	if(!positions.data || !polygon_vertex_indices) {
+		lodge_log(LODGE_LOG_LEVEL_ERROR, strview("Mesh"), strview("FBX geometry could not be decoded\n"));
+		return false;
+	}
+
+	struct lodge_mesh_fbx_layer normals;
+	if(!lodge_mesh_fbx_layer_make(&normals, fbx, "LayerElementNormal", "Normals", "NormalsIndex", 3)) {
+		lodge_log(LODGE_LOG_LEVEL_ERROR, strview("Mesh"), strview("FBX geometry has no normals\n"));
+		return false;
+	}
+
+	struct lodge_mesh_fbx_layer uvs;
+	const bool has_uvs = lodge_mesh_fbx_layer_make(&uvs, fbx, "LayerElementUV", "UV", "UVIndex", 2);
+
+	const int32_t up_axis = lodge_mesh_fbx_get_up_axis(fbx);
+	ASSERT(up_axis == 1 || up_axis == 2);
+	const bool swap_y_z = (up_axis == 1);
+
+	dynbuf_new_inplace(dynbuf(mesh->vertices), polygon_vertex_indices_count);
+	dynbuf_new_inplace(dynbuf(mesh->indices), polygon_vertex_indices_count * 3);
+
+	uint32_t polygon = 0;
+	uint32_t polygon_start = 0;
+
+	for(uint32_t corner = 0; corner < polygon_vertex_indices_count; corner++) {
+		const int32_t raw_index = polygon_vertex_indices[corner];
+		const bool polygon_end = raw_index < 0;
+		const uint32_t control_point = polygon_end ? (uint32_t)(~raw_index) : (uint32_t)raw_index;
+
+		float position[3];
+		float normal[3];
+		float tex_coord[2] = { 0.0f, 0.0f };
+
+		if(!lodge_mesh_fbx_layer_get(&positions, corner, control_point, polygon, position)
+			|| !lodge_mesh_fbx_layer_get(&normals, corner, control_point, polygon, normal)
+			|| (has_uvs && !lodge_mesh_fbx_layer_get(&uvs, corner, control_point, polygon, tex_coord))) {
+			errorf("Mesh", "FBX polygon vertex %u is out of range\n", corner);
+			lodge_mesh_free_inplace(mesh);
+			return false;
+		}
+
+		struct lodge_mesh_vertex *vertex = dynbuf_append_no_init(dynbuf(mesh->vertices));
+		vertex->position = lodge_mesh_fbx_swizzle(position, swap_y_z);
+		vertex->normal = lodge_mesh_fbx_swizzle(normal, swap_y_z);
+		vertex->tex_coord = vec2_make(tex_coord[0], tex_coord[1]);
+
+		if(polygon_end) {
+			// Fan triangulation; exported FBX polygons are convex in practice.
+			for(uint32_t i = polygon_start + 1; i < corner; i++) {
+				const uint32_t triangle[3] = { polygon_start, i, i + 1 };
+				dynbuf_append_range(dynbuf(mesh->indices), (void *)triangle, sizeof(uint32_t), LODGE_ARRAYSIZE(triangle));
+			}
+			polygon++;
+			polygon_start = corner + 1;
+		}
+	}
+
+	return true;
+}
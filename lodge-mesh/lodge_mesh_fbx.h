@@ -0,0 +1,18 @@
+#ifndef _LODGE_MESH_FBX_H
+#define _LODGE_MESH_FBX_H
+
+#include <stdbool.h>
+
+struct fbx;
+struct lodge_mesh;
+
+//
+// Builds a triangle list from the first `Objects/Geometry` of `fbx`, with one vertex per
+// polygon corner (so nothing is shared yet, see `lodge_mesh_weld()`).
+//
+// Polygons are fan triangulated. Normals are required, UVs are optional. Y and Z are
+// swapped for Y-up documents, like `fbx_asset` does.
+//
+bool				lodge_mesh_new_from_fbx_inplace(struct lodge_mesh *mesh, struct fbx *fbx);
+
+#endif
@@ -0,0 +1,158 @@
+#include "lodge_mesh_file.h"
+
+#include <string.h>
+
+_Static_assert(sizeof(struct lodge_mesh_file_header) == 248, "lodge_mesh_file_header must not contain padding");
+
+static bool lodge_mesh_file_indices_valid(const char *indices, uint32_t indices_count, uint32_t index_size, uint32_t vertices_count)
+{
+	if(index_size == sizeof(uint16_t)) {
+		for(uint32_t i = 0; i < indices_count; i++) {
+			uint16_t index;
+			memcpy(&index, indices + i * sizeof(uint16_t), sizeof(index));
+			if(index >= vertices_count) {
+				return false;
+			}
+		}
+	} else {
+		for(uint32_t i = 0; i < indices_count; i++) {
+			uint32_t index;
+			memcpy(&index, indices + i * sizeof(uint32_t), sizeof(index));
+			if(index >= vertices_count) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool lodge_mesh_file_init(struct lodge_mesh_file *file, const void *data, size_t size)
+{
+	const struct lodge_mesh_file_header *header = (const struct lodge_mesh_file_header *)data;
+
+	if(size < sizeof(struct lodge_mesh_file_header)
+		|| memcmp(header->magic, LODGE_MESH_FILE_MAGIC, sizeof(header->magic)) != 0
+		|| header->version != LODGE_MESH_FILE_VERSION
+		|| (header->index_size != sizeof(uint16_t) && header->index_size != sizeof(uint32_t))
+		|| header->vertex_stride == 0
+		|| header->lods_count == 0
+		|| header->lods_count > LODGE_MESH_LODS_MAX) {
+		return false;
+	}
+
+	for(uint32_t i = 0; i < header->lods_count; i++) {
+		const struct lodge_mesh_file_lod *lod = &header->lods[i];
+		if((uint64_t)lod->indices_offset + lod->indices_count > header->indices_count
+			|| (lod->indices_count % 3) != 0) {
+			return false;
+		}
+	}
+
+	for(uint32_t i = 0; i < LODGE_MESH_ATTRIB_MAX; i++) {
+		const struct lodge_mesh_file_attrib *attrib = &header->attribs[i];
+		const uint64_t component_size = attrib->format == LODGE_MESH_ATTRIB_FORMAT_FLOAT16 ? sizeof(uint16_t) : sizeof(float);
+		if(attrib->format > LODGE_MESH_ATTRIB_FORMAT_FLOAT16
+			|| attrib->components == 0
+			|| attrib->components > 4
+			|| (uint64_t)attrib->offset + attrib->components * component_size > header->vertex_stride) {
+			return false;
+		}
+	}
+
+	const uint64_t vertices_size = (uint64_t)header->vertices_count * header->vertex_stride;
+	const uint64_t indices_size = (uint64_t)header->indices_count * header->index_size;
+	if(header->vertices_offset > size
+		|| vertices_size > size - header->vertices_offset
+		|| header->indices_offset > size
+		|| indices_size > size - header->indices_offset
+		|| (header->vertices_offset % LODGE_MESH_FILE_ALIGNMENT) != 0
+		|| (header->indices_offset % LODGE_MESH_FILE_ALIGNMENT) != 0) {
+		return false;
+	}
+
+	//
+	// GL does not bounds check index buffers.
+	//
+	const char *indices = (const char *)data + header->indices_offset;
+	if(!lodge_mesh_file_indices_valid(indices, header->indices_count, header->index_size, header->vertices_count)) {
+		return false;
+	}
+
+	*file = (struct lodge_mesh_file) {
+		.header = header,
+		.vertices = (const char *)data + header->vertices_offset,
+		.vertices_size = (size_t)vertices_size,
+		.indices = indices,
+		.indices_size = (size_t)indices_size,
+	};
+	return true;
+}
+
+uint16_t lodge_mesh_half_from_float(float f)
+{
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const uint32_t abs = bits & 0x7fffffff;
+
+	if(abs >= 0x7f800000) {
+		// Inf or NaN (keeps NaNs quiet).
+		return (uint16_t)(sign | 0x7c00 | (abs > 0x7f800000 ? 0x200 : 0));
+	}
+	if(abs >= 0x477ff000) {
+		// Rounds to above the largest half.
+		return (uint16_t)(sign | 0x7c00);
+	}
+	if(abs < 0x38800000) {
+		// Subnormal half (or zero): shift the implicit bit into the mantissa and round.
+		if(abs < 0x33000000) {
+			return (uint16_t)sign;
+		}
+		const uint32_t exponent = abs >> 23;
+		const uint32_t mantissa = (abs & 0x7fffff) | 0x800000;
+		const uint32_t shift = 126 - exponent;
+		const uint32_t half = mantissa >> shift;
+		const uint32_t rest = mantissa & ((1u << shift) - 1);
+		const uint32_t halfway = 1u << (shift - 1);
+		const uint32_t round_up = rest > halfway || (rest == halfway && (half & 1));
+		return (uint16_t)(sign | (half + round_up));
+	}
+
+	// Normal: rebias the exponent and round the mantissa to 10 bits.
+	const uint32_t rebased = abs - ((127 - 15) << 23);
+	const uint32_t rest = rebased & 0x1fff;
+	uint32_t half = rebased >> 13;
+	if(rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+		half++;
+	}
+	return (uint16_t)(sign | half);
+}
+
+float lodge_mesh_float_from_half(uint16_t h)
+{
+	const uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+	const uint32_t exponent = (h >> 10) & 0x1f;
+	uint32_t mantissa = h & 0x3ff;
+	uint32_t bits;
+
+	if(exponent == 0x1f) {
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	} else if(exponent != 0) {
+		bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	} else if(mantissa != 0) {
+		// Subnormal half: normalize.
+		uint32_t e = 127 - 15 + 1;
+		while(!(mantissa & 0x400)) {
+			mantissa <<= 1;
+			e--;
+		}
+		bits = sign | (e << 23) | ((mantissa & 0x3ff) << 13);
+	} else {
+		bits = sign;
+	}
+
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
@@ -0,0 +1,100 @@
+//
+// Cooked mesh: vertices and indices laid out exactly like the GPU wants them, so loading
+// is a map of the file and one upload per buffer.
+//
+// Layout (little endian):
+//
+//		struct lodge_mesh_file_header
+//		...							vertices[vertices_count]	(interleaved, `vertex_stride` bytes each)
+//		...							indices[indices_count]		(`index_size` bytes each)
+//
+// Both blocks start at a multiple of `LODGE_MESH_FILE_ALIGNMENT`. Every LOD is a range of
+// the index block over the shared vertices; LOD 0 is the full detail mesh. Produced by the
+// `lodge-mesh-cooker` tool, see `lodge_mesh_cook.h`.
+//
+#ifndef _LODGE_MESH_FILE_H
+#define _LODGE_MESH_FILE_H
+
+#include "geometry.h"
+#include "lodge_mesh.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define LODGE_MESH_FILE_EXTENSION		".lmesh"
+#define LODGE_MESH_FILE_MAGIC			"LMSH"
+#define LODGE_MESH_FILE_VERSION			2
+#define LODGE_MESH_FILE_ALIGNMENT		16
+
+enum lodge_mesh_attrib
+{
+	LODGE_MESH_ATTRIB_POSITION,
+	LODGE_MESH_ATTRIB_NORMAL,
+	LODGE_MESH_ATTRIB_TEX_COORD,
+	LODGE_MESH_ATTRIB_MAX,
+};
+
+enum lodge_mesh_attrib_format
+{
+	LODGE_MESH_ATTRIB_FORMAT_FLOAT32,
+	LODGE_MESH_ATTRIB_FORMAT_FLOAT16,
+};
+
+struct lodge_mesh_file_attrib
+{
+	uint32_t							format;				// enum lodge_mesh_attrib_format
+	uint32_t							components;
+	uint32_t							offset;				// Within a vertex.
+};
+
+struct lodge_mesh_file_lod
+{
+	uint32_t							indices_offset;		// In indices, not bytes.
+	uint32_t							indices_count;
+	float								error;				// Object space.
+	float								distance;			// Switch to this LOD from here on.
+};
+
+struct lodge_mesh_file_header
+{
+	char								magic[4];
+	uint32_t							version;
+	uint64_t							vertices_offset;	// From the start of the file.
+	uint64_t							indices_offset;
+	uint32_t							vertices_count;
+	uint32_t							vertex_stride;
+	uint32_t							indices_count;
+	uint32_t							index_size;			// 2 or 4.
+	struct lodge_mesh_file_attrib		attribs[LODGE_MESH_ATTRIB_MAX];
+	struct aabb							bounds;
+	struct sphere						bounding_sphere;
+	uint32_t							lods_count;			// At least 1.
+	struct lodge_mesh_file_lod			lods[LODGE_MESH_LODS_MAX];
+};
+
+//
+// A cooked mesh in memory (usually a mapped file). Does not own the data.
+//
+struct lodge_mesh_file
+{
+	const struct lodge_mesh_file_header	*header;
+	const char							*vertices;
+	size_t								vertices_size;
+	const char							*indices;
+	size_t								indices_size;
+};
+
+//
+// Validates the header against `size`, so the returned blocks can be uploaded as-is, every
+// LOD range lies within the index block and every index is less than `vertices_count`.
+//
+bool									lodge_mesh_file_init(struct lodge_mesh_file *file, const void *data, size_t size);
+
+//
+// IEEE 754 binary16, round to nearest even.
+//
+uint16_t								lodge_mesh_half_from_float(float f);
+float									lodge_mesh_float_from_half(uint16_t h);
+
+#endif
@@ -0,0 +1,263 @@
+#include "lodge_mesh_optimize.h"
+
+#include "lodge_mesh.h"
+
+#include "lodge_assert.h"
+#include "lodge_platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LODGE_MESH_OPTIMIZE_NONE	UINT32_MAX
+
+//
+// Forsyth's scores in 16.16 fixed point, so the triangle order (and with it the cooked
+// output) does not depend on how the platform rounds `powf()`.
+//
+// Cache position: the last triangle's vertices get 0.75, the rest
+// `(1 - (pos - 3) / (cache_size - 3))^1.5`.
+//
+static const int32_t lodge_mesh_optimize_cache_scores[LODGE_MESH_VERTEX_CACHE_SIZE] = {
+	49152, 49152, 49152, 65536, 62176, 58875, 55634, 52456, 49340, 46289, 43303, 40384, 37534, 34755, 32047, 29414,
+	26857, 24379, 21982, 19670, 17444, 15310, 13270, 11330, 9496, 7772, 6168, 4692, 3357, 2181, 1187, 420,
+};
+
+//
+// Remaining triangles: `2 * remaining^-0.5`, which favours vertices that are almost done.
+// Clamped at the last entry.
+//
+static const int32_t lodge_mesh_optimize_valence_scores[] = {
+	0, 131072, 92682, 75674, 65536, 58617, 53510, 49541, 46341, 43691, 41449, 39520, 37837, 36353, 35030, 33843,
+	32768, 31790, 30894, 30070, 29309, 28602, 27945, 27330, 26755, 26214, 25705, 25225, 24770, 24339, 23930, 23541,
+	23170,
+};
+
+struct lodge_mesh_optimize_vertex
+{
+	uint32_t	triangles_offset;		// Into `vertex_triangles`.
+	uint32_t	triangles_remaining;	// Not yet emitted; these come first in its range.
+	int32_t		cache_pos;				// -1 if not in the cache.
+	int32_t		score;
+};
+
+static int32_t lodge_mesh_optimize_vertex_score(const struct lodge_mesh_optimize_vertex *vertex)
+{
+	if(vertex->triangles_remaining == 0) {
+		return -1;
+	}
+
+	int32_t score = vertex->cache_pos >= 0 ? lodge_mesh_optimize_cache_scores[vertex->cache_pos] : 0;
+	score += lodge_mesh_optimize_valence_scores[min(vertex->triangles_remaining, LODGE_ARRAYSIZE(lodge_mesh_optimize_valence_scores) - 1)];
+	return score;
+}
+
+static void lodge_mesh_optimize_vertex_cache_range(uint32_t *indices_inout, size_t indices_count, size_t vertices_count)
+{
+	const size_t triangles_count = indices_count / 3;
+	if(triangles_count == 0) {
+		return;
+	}
+	ASSERT_OR(vertices_count < LODGE_MESH_OPTIMIZE_NONE && indices_count < LODGE_MESH_OPTIMIZE_NONE) { return; }
+
+	const uint32_t *indices = indices_inout;
+
+	struct lodge_mesh_optimize_vertex *vertices = (struct lodge_mesh_optimize_vertex *)calloc(vertices_count, sizeof(struct lodge_mesh_optimize_vertex));
+	uint32_t *vertex_triangles = (uint32_t *)malloc(triangles_count * 3 * sizeof(uint32_t));
+	uint8_t *triangle_emitted = (uint8_t *)calloc(triangles_count, sizeof(uint8_t));
+	uint32_t *new_indices = (uint32_t *)malloc(triangles_count * 3 * sizeof(uint32_t));
+	ASSERT_OR(vertices && vertex_triangles && triangle_emitted && new_indices) {
+		goto done;
+	}
+
+	//
+	// Per vertex triangle lists, packed into `vertex_triangles`.
+	//
+	for(size_t i = 0; i < triangles_count * 3; i++) {
+		ASSERT(indices[i] < vertices_count);
+		vertices[indices[i]].triangles_remaining++;
+	}
+	uint32_t offset = 0;
+	for(size_t i = 0; i < vertices_count; i++) {
+		vertices[i].triangles_offset = offset;
+		offset += vertices[i].triangles_remaining;
+		vertices[i].triangles_remaining = 0;
+		vertices[i].cache_pos = -1;
+	}
+	for(size_t i = 0; i < triangles_count * 3; i++) {
+		struct lodge_mesh_optimize_vertex *vertex = &vertices[indices[i]];
+		vertex_triangles[vertex->triangles_offset + vertex->triangles_remaining++] = (uint32_t)(i / 3);
+	}
+
+	for(size_t i = 0; i < vertices_count; i++) {
+		vertices[i].score = lodge_mesh_optimize_vertex_score(&vertices[i]);
+	}
+
+	uint32_t best_triangle = 0;
+	int32_t best_score = -1;
+	for(size_t i = 0; i < triangles_count; i++) {
+		const int32_t score = vertices[indices[i * 3 + 0]].score + vertices[indices[i * 3 + 1]].score + vertices[indices[i * 3 + 2]].score;
+		if(score > best_score) {
+			best_score = score;
+			best_triangle = (uint32_t)i;
+		}
+	}
+
+	//
+	// Room for the 3 new vertices pushed in front of a full cache.
+	//
+	uint32_t cache[LODGE_MESH_VERTEX_CACHE_SIZE + 3];
+	uint32_t cache_count = 0;
+	uint32_t next_unemitted = 0;
+
+	for(size_t emitted = 0; emitted < triangles_count; emitted++) {
+		//
+		// Dead end: nothing in the cache touches a remaining triangle, so continue with the
+		// next one in input order. Scanning for the best would be O(n^2).
+		//
+		if(best_score < 0) {
+			while(triangle_emitted[next_unemitted]) {
+				next_unemitted++;
+			}
+			best_triangle = next_unemitted;
+		}
+
+		const uint32_t *triangle = &indices[best_triangle * 3];
+		memcpy(&new_indices[emitted * 3], triangle, 3 * sizeof(uint32_t));
+		triangle_emitted[best_triangle] = 1;
+
+		// Take the triangle off its vertices' remaining lists.
+		for(uint32_t corner = 0; corner < 3; corner++) {
+			struct lodge_mesh_optimize_vertex *vertex = &vertices[triangle[corner]];
+			uint32_t *it = &vertex_triangles[vertex->triangles_offset];
+			for(uint32_t i = 0; i < vertex->triangles_remaining; i++) {
+				if(it[i] == best_triangle) {
+					it[i] = it[vertex->triangles_remaining - 1];
+					it[vertex->triangles_remaining - 1] = best_triangle;
+					vertex->triangles_remaining--;
+					break;
+				}
+			}
+		}
+
+		// LRU: the triangle's vertices move to the front.
+		uint32_t new_cache[LODGE_MESH_VERTEX_CACHE_SIZE + 3];
+		uint32_t new_cache_count = 0;
+		for(uint32_t corner = 0; corner < 3; corner++) {
+			if(new_cache_count == 0 || (new_cache[0] != triangle[corner] && (new_cache_count < 2 || new_cache[1] != triangle[corner]))) {
+				new_cache[new_cache_count++] = triangle[corner];
+			}
+		}
+		for(uint32_t i = 0; i < cache_count; i++) {
+			if(cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2]) {
+				new_cache[new_cache_count++] = cache[i];
+			}
+		}
+
+		for(uint32_t i = 0; i < new_cache_count; i++) {
+			struct lodge_mesh_optimize_vertex *vertex = &vertices[new_cache[i]];
+			vertex->cache_pos = i < LODGE_MESH_VERTEX_CACHE_SIZE ? (int32_t)i : -1;
+			vertex->score = lodge_mesh_optimize_vertex_score(vertex);
+		}
+
+		// Rescore the remaining triangles around the cache and pick the best of them.
+		best_score = -1;
+		for(uint32_t i = 0; i < new_cache_count; i++) {
+			const struct lodge_mesh_optimize_vertex *vertex = &vertices[new_cache[i]];
+			const uint32_t *it = &vertex_triangles[vertex->triangles_offset];
+			for(uint32_t j = 0; j < vertex->triangles_remaining; j++) {
+				const uint32_t t = it[j];
+				const int32_t score = vertices[indices[t * 3 + 0]].score + vertices[indices[t * 3 + 1]].score + vertices[indices[t * 3 + 2]].score;
+				if(score > best_score || (score == best_score && t < best_triangle)) {
+					best_score = score;
+					best_triangle = t;
+				}
+			}
+		}
+
+		cache_count = min(new_cache_count, LODGE_MESH_VERTEX_CACHE_SIZE);
+		memcpy(cache, new_cache, cache_count * sizeof(uint32_t));
+	}
+
+	memcpy(indices_inout, new_indices, triangles_count * 3 * sizeof(uint32_t));
+
+done:
+	free(new_indices);
+	free(triangle_emitted);
+	free(vertex_triangles);
+	free(vertices);
+}
+
+void lodge_mesh_optimize_vertex_cache(struct lodge_mesh *mesh)
+{
+	if(mesh->lods_count == 0) {
+		lodge_mesh_optimize_vertex_cache_range(mesh->indices.elements, mesh->indices.count, mesh->vertices.count);
+		return;
+	}
+
+	for(uint32_t i = 0; i < mesh->lods_count; i++) {
+		const struct lodge_mesh_lod *lod = &mesh->lods[i];
+		ASSERT_OR((size_t)lod->indices_offset + lod->indices_count <= mesh->indices.count) { return; }
+		lodge_mesh_optimize_vertex_cache_range(&mesh->indices.elements[lod->indices_offset], lod->indices_count, mesh->vertices.count);
+	}
+}
+
+void lodge_mesh_optimize_vertex_fetch(struct lodge_mesh *mesh)
+{
+	const size_t vertices_count = mesh->vertices.count;
+	if(vertices_count == 0) {
+		return;
+	}
+
+	uint32_t *remap = (uint32_t *)malloc(vertices_count * sizeof(uint32_t));
+	struct lodge_mesh_vertex *new_vertices = (struct lodge_mesh_vertex *)malloc(vertices_count * sizeof(struct lodge_mesh_vertex));
+	ASSERT_OR(remap && new_vertices) {
+		free(remap);
+		free(new_vertices);
+		return;
+	}
+	memset(remap, 0xff, vertices_count * sizeof(uint32_t));
+
+	uint32_t new_vertices_count = 0;
+	for(size_t i = 0; i < mesh->indices.count; i++) {
+		uint32_t *index = &mesh->indices.elements[i];
+		ASSERT(*index < vertices_count);
+		if(remap[*index] == LODGE_MESH_OPTIMIZE_NONE) {
+			new_vertices[new_vertices_count] = mesh->vertices.elements[*index];
+			remap[*index] = new_vertices_count++;
+		}
+		*index = remap[*index];
+	}
+
+	memcpy(mesh->vertices.elements, new_vertices, new_vertices_count * sizeof(struct lodge_mesh_vertex));
+	mesh->vertices.count = new_vertices_count;
+
+	free(new_vertices);
+	free(remap);
+}
+
+float lodge_mesh_calc_acmr(const uint32_t *indices, size_t indices_count, size_t vertices_count, uint32_t cache_size)
+{
+	const size_t triangles_count = indices_count / 3;
+	if(triangles_count == 0 || cache_size == 0) {
+		return 0.0f;
+	}
+
+	//
+	// FIFO: a vertex is in the cache if it was pushed less than `cache_size` misses ago.
+	//
+	uint32_t *pushed_at = (uint32_t *)malloc(vertices_count * sizeof(uint32_t));
+	ASSERT_OR(pushed_at) { return 0.0f; }
+	memset(pushed_at, 0xff, vertices_count * sizeof(uint32_t));
+
+	uint32_t misses = 0;
+	for(size_t i = 0; i < triangles_count * 3; i++) {
+		const uint32_t index = indices[i];
+		ASSERT_OR(index < vertices_count) { continue; }
+		if(pushed_at[index] == LODGE_MESH_OPTIMIZE_NONE || misses - pushed_at[index] >= cache_size) {
+			pushed_at[index] = misses++;
+		}
+	}
+
+	free(pushed_at);
+	return (float)misses / (float)triangles_count;
+}
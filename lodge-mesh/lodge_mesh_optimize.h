@@ -0,0 +1,37 @@
+//
+// Index and vertex reordering for the GPU vertex caches. Neither changes what is drawn,
+// only the order, and both are deterministic.
+//
+#ifndef _LODGE_MESH_OPTIMIZE_H
+#define _LODGE_MESH_OPTIMIZE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+//
+// Post-transform cache size the optimizer targets and `lodge_mesh_calc_acmr()` simulates.
+//
+#define LODGE_MESH_VERTEX_CACHE_SIZE	32
+
+struct lodge_mesh;
+
+//
+// Reorders triangles so vertices are reused while still in the post-transform cache
+// (Forsyth, "Linear-Speed Vertex Cache Optimisation"). Each LOD is reordered on its own.
+//
+void				lodge_mesh_optimize_vertex_cache(struct lodge_mesh *mesh);
+
+//
+// Reorders vertices by first use in the index buffer, so fetches walk the vertex buffer
+// mostly forwards. Unreferenced vertices are dropped. Run after `_vertex_cache()`, and
+// after generating LODs so they keep the vertices they use.
+//
+void				lodge_mesh_optimize_vertex_fetch(struct lodge_mesh *mesh);
+
+//
+// Average cache miss ratio: transformed vertices per triangle with a FIFO cache of
+// `cache_size` entries. 3.0 is the worst case, around 0.5-0.7 is good for a grid.
+//
+float				lodge_mesh_calc_acmr(const uint32_t *indices, size_t indices_count, size_t vertices_count, uint32_t cache_size);
+
+#endif
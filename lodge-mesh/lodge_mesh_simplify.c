@@ -0,0 +1,632 @@
+#include "lodge_mesh_simplify.h"
+
+#include "dynbuf.h"
+#include "lodge_hash.h"
+#include "lodge_assert.h"
+#include "lodge_platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define LODGE_MESH_SIMPLIFY_NONE	UINT32_MAX
+
+enum lodge_mesh_simplify_kind
+{
+	LODGE_MESH_SIMPLIFY_KIND_MANIFOLD,		// Collapses onto any neighbour.
+	LODGE_MESH_SIMPLIFY_KIND_BORDER,		// Only slides along its open border.
+	LODGE_MESH_SIMPLIFY_KIND_LOCKED,		// Attribute seams, border corners and non-manifold vertices.
+};
+
+//
+// Sum of squared distances to a set of planes: `p^T A p + 2 b^T p + c`.
+//
+struct lodge_mesh_quadric
+{
+	double							a00, a11, a22, a01, a02, a12;
+	double							b0, b1, b2;
+	double							c;
+};
+
+struct lodge_mesh_collapse
+{
+	double							cost;
+	uint32_t						from;		// Vertex that goes away...
+	uint32_t						to;			// ...onto this one.
+	uint32_t						shared;		// Triangles on the edge, ie. removed by the collapse.
+};
+
+struct lodge_mesh_simplify_adjacency
+{
+	uint32_t						*offsets;	// Per position, `vertices_count + 1` entries.
+	uint32_t						*triangles;
+};
+
+//
+// Doubles throughout: the costs decide the collapse order, so they should not be at the
+// mercy of float cancellation on large meshes.
+//
+static void lodge_mesh_position_to_double(double dst[3], vec3 src)
+{
+	dst[0] = src.x;
+	dst[1] = src.y;
+	dst[2] = src.z;
+}
+
+static void lodge_mesh_double3_cross(double dst[3], const double a[3], const double b[3])
+{
+	dst[0] = a[1] * b[2] - a[2] * b[1];
+	dst[1] = a[2] * b[0] - a[0] * b[2];
+	dst[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static double lodge_mesh_double3_dot(const double a[3], const double b[3])
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static void lodge_mesh_quadric_add_plane(struct lodge_mesh_quadric *q, const double n[3], double d)
+{
+	q->a00 += n[0] * n[0];
+	q->a11 += n[1] * n[1];
+	q->a22 += n[2] * n[2];
+	q->a01 += n[0] * n[1];
+	q->a02 += n[0] * n[2];
+	q->a12 += n[1] * n[2];
+	q->b0 += n[0] * d;
+	q->b1 += n[1] * d;
+	q->b2 += n[2] * d;
+	q->c += d * d;
+}
+
+static void lodge_mesh_quadric_add(struct lodge_mesh_quadric *dst, const struct lodge_mesh_quadric *src)
+{
+	dst->a00 += src->a00;
+	dst->a11 += src->a11;
+	dst->a22 += src->a22;
+	dst->a01 += src->a01;
+	dst->a02 += src->a02;
+	dst->a12 += src->a12;
+	dst->b0 += src->b0;
+	dst->b1 += src->b1;
+	dst->b2 += src->b2;
+	dst->c += src->c;
+}
+
+static double lodge_mesh_quadric_eval(const struct lodge_mesh_quadric *q, const double p[3])
+{
+	const double x = p[0], y = p[1], z = p[2];
+	const double value = q->a00 * x * x + q->a11 * y * y + q->a22 * z * z
+		+ 2.0 * (q->a01 * x * y + q->a02 * x * z + q->a12 * y * z)
+		+ 2.0 * (q->b0 * x + q->b1 * y + q->b2 * z)
+		+ q->c;
+	return value > 0.0 ? value : 0.0;
+}
+
+//
+// Maps every vertex to the first vertex with the same position, so seams (vertices split
+// by normal or UV) are simplified as one point.
+//
+static void lodge_mesh_simplify_calc_positions(uint32_t *positions, const struct lodge_mesh *mesh)
+{
+	const size_t vertices_count = mesh->vertices.count;
+
+	size_t table_size = 16;
+	while(table_size < vertices_count * 2) {
+		table_size *= 2;
+	}
+
+	uint32_t *table = (uint32_t *)malloc(table_size * sizeof(uint32_t));
+	ASSERT_OR(table) {
+		for(size_t i = 0; i < vertices_count; i++) {
+			positions[i] = (uint32_t)i;
+		}
+		return;
+	}
+	memset(table, 0xff, table_size * sizeof(uint32_t));
+
+	for(size_t i = 0; i < vertices_count; i++) {
+		vec3 position = mesh->vertices.elements[i].position;
+		for(int c = 0; c < 3; c++) {
+			if(position.v[c] == 0.0f) {
+				position.v[c] = 0.0f;
+			}
+		}
+
+		size_t slot = lodge_hash_murmur3_32(&position, sizeof(position)) & (table_size - 1);
+		while(table[slot] != LODGE_MESH_SIMPLIFY_NONE && memcmp(&mesh->vertices.elements[table[slot]].position, &position, sizeof(position)) != 0) {
+			slot = (slot + 1) & (table_size - 1);
+		}
+
+		if(table[slot] == LODGE_MESH_SIMPLIFY_NONE) {
+			table[slot] = (uint32_t)i;
+		}
+		positions[i] = table[slot];
+	}
+
+	free(table);
+}
+
+static bool lodge_mesh_simplify_is_degenerate(const uint32_t *triangle, const uint32_t *positions)
+{
+	const uint32_t a = positions[triangle[0]];
+	const uint32_t b = positions[triangle[1]];
+	const uint32_t c = positions[triangle[2]];
+	return a == b || b == c || c == a;
+}
+
+static size_t lodge_mesh_simplify_remove_degenerate(uint32_t *indices, size_t indices_count, const uint32_t *positions)
+{
+	size_t count = 0;
+	for(size_t i = 0; i < indices_count; i += 3) {
+		if(!lodge_mesh_simplify_is_degenerate(&indices[i], positions)) {
+			memmove(&indices[count], &indices[i], 3 * sizeof(uint32_t));
+			count += 3;
+		}
+	}
+	return count;
+}
+
+static void lodge_mesh_simplify_calc_adjacency(struct lodge_mesh_simplify_adjacency *adjacency, const uint32_t *indices, size_t indices_count, const uint32_t *positions, size_t vertices_count)
+{
+	uint32_t *offsets = adjacency->offsets;
+	memset(offsets, 0, (vertices_count + 1) * sizeof(uint32_t));
+
+	for(size_t i = 0; i < indices_count; i++) {
+		offsets[positions[indices[i]]]++;
+	}
+
+	uint32_t start = 0;
+	for(size_t i = 0; i < vertices_count; i++) {
+		const uint32_t count = offsets[i];
+		offsets[i] = start;
+		start += count;
+	}
+
+	//
+	// Filling advances each `offsets[p]` to the start of the next range; shift them back.
+	//
+	for(size_t i = 0; i < indices_count; i++) {
+		adjacency->triangles[offsets[positions[indices[i]]]++] = (uint32_t)(i / 3);
+	}
+	memmove(&offsets[1], &offsets[0], vertices_count * sizeof(uint32_t));
+	offsets[0] = 0;
+}
+
+static bool lodge_mesh_simplify_triangle_has(const uint32_t *triangle, const uint32_t *positions, uint32_t position)
+{
+	return positions[triangle[0]] == position || positions[triangle[1]] == position || positions[triangle[2]] == position;
+}
+
+static uint32_t lodge_mesh_simplify_edge_triangles(const struct lodge_mesh_simplify_adjacency *adjacency, const uint32_t *indices, const uint32_t *positions, uint32_t a, uint32_t b)
+{
+	uint32_t count = 0;
+	for(uint32_t i = adjacency->offsets[a]; i < adjacency->offsets[a + 1]; i++) {
+		count += lodge_mesh_simplify_triangle_has(&indices[adjacency->triangles[i] * 3], positions, b);
+	}
+	return count;
+}
+
+static void lodge_mesh_simplify_triangle_normal(double n[3], const struct lodge_mesh *mesh, const uint32_t *triangle, uint32_t from, const double *to_position)
+{
+	double p[3][3];
+	for(int c = 0; c < 3; c++) {
+		if(triangle[c] == from && to_position) {
+			memcpy(p[c], to_position, sizeof(p[c]));
+		} else {
+			lodge_mesh_position_to_double(p[c], mesh->vertices.elements[triangle[c]].position);
+		}
+	}
+
+	const double e0[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+	const double e1[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+	lodge_mesh_double3_cross(n, e0, e1);
+}
+
+static int lodge_mesh_collapse_compare(const void *lhs, const void *rhs)
+{
+	const struct lodge_mesh_collapse *a = (const struct lodge_mesh_collapse *)lhs;
+	const struct lodge_mesh_collapse *b = (const struct lodge_mesh_collapse *)rhs;
+	if(a->cost != b->cost) {
+		return a->cost < b->cost ? -1 : 1;
+	}
+	if(a->from != b->from) {
+		return a->from < b->from ? -1 : 1;
+	}
+	return a->to < b->to ? -1 : (a->to > b->to);
+}
+
+size_t lodge_mesh_simplify(uint32_t *dst, const struct lodge_mesh *mesh, const uint32_t *indices, size_t indices_count, size_t target_indices_count, float max_error, float *error)
+{
+	if(error) {
+		*error = 0.0f;
+	}
+
+	const size_t vertices_count = mesh->vertices.count;
+	ASSERT_OR(indices_count % 3 == 0 && vertices_count < LODGE_MESH_SIMPLIFY_NONE && indices_count < LODGE_MESH_SIMPLIFY_NONE) { return 0; }
+	if(indices_count == 0) {
+		return 0;
+	}
+
+	uint32_t *positions = (uint32_t *)malloc(vertices_count * sizeof(uint32_t));
+	uint32_t *wedges = (uint32_t *)calloc(vertices_count, sizeof(uint32_t));
+	uint32_t *borders = (uint32_t *)calloc(vertices_count, sizeof(uint32_t));
+	uint8_t *kinds = (uint8_t *)malloc(vertices_count);
+	uint32_t *collapses = (uint32_t *)malloc(vertices_count * sizeof(uint32_t));
+	uint32_t *touched = (uint32_t *)calloc(vertices_count, sizeof(uint32_t));
+	uint32_t *marks = (uint32_t *)calloc(vertices_count, sizeof(uint32_t));
+	struct lodge_mesh_quadric *quadrics = (struct lodge_mesh_quadric *)calloc(vertices_count, sizeof(struct lodge_mesh_quadric));
+	struct lodge_mesh_collapse *candidates = (struct lodge_mesh_collapse *)malloc(indices_count * sizeof(struct lodge_mesh_collapse));
+	struct lodge_mesh_simplify_adjacency adjacency = {
+		.offsets = (uint32_t *)malloc((vertices_count + 1) * sizeof(uint32_t)),
+		.triangles = (uint32_t *)malloc(indices_count * sizeof(uint32_t)),
+	};
+
+	size_t count = 0;
+	ASSERT_OR(positions && wedges && borders && kinds && collapses && touched && marks && quadrics && candidates && adjacency.offsets && adjacency.triangles) {
+		goto done;
+	}
+
+	lodge_mesh_simplify_calc_positions(positions, mesh);
+
+	memcpy(dst, indices, indices_count * sizeof(uint32_t));
+	for(size_t i = 0; i < indices_count; i++) {
+		ASSERT_OR(dst[i] < vertices_count) { goto done; }
+	}
+	count = lodge_mesh_simplify_remove_degenerate(dst, indices_count, positions);
+
+	//
+	// Count the (referenced) vertices at each position; more than one is a seam.
+	//
+	memset(collapses, 0, vertices_count * sizeof(uint32_t));
+	for(size_t i = 0; i < count; i++) {
+		if(!collapses[dst[i]]) {
+			collapses[dst[i]] = 1;
+			wedges[positions[dst[i]]]++;
+		}
+	}
+	for(size_t i = 0; i < vertices_count; i++) {
+		collapses[i] = (uint32_t)i;
+	}
+
+	//
+	// Classify positions and set up their quadrics: the planes of their triangles, plus a
+	// plane perpendicular to each open edge that keeps borders from shrinking.
+	//
+	lodge_mesh_simplify_calc_adjacency(&adjacency, dst, count, positions, vertices_count);
+
+	for(size_t t = 0; t < count / 3; t++) {
+		const uint32_t *triangle = &dst[t * 3];
+
+		double n[3];
+		lodge_mesh_simplify_triangle_normal(n, mesh, triangle, LODGE_MESH_SIMPLIFY_NONE, NULL);
+		const double length = sqrt(lodge_mesh_double3_dot(n, n));
+		if(length == 0.0) {
+			continue;
+		}
+		n[0] /= length;
+		n[1] /= length;
+		n[2] /= length;
+
+		double p0[3];
+		lodge_mesh_position_to_double(p0, mesh->vertices.elements[triangle[0]].position);
+		const double d = -lodge_mesh_double3_dot(n, p0);
+
+		for(int c = 0; c < 3; c++) {
+			lodge_mesh_quadric_add_plane(&quadrics[positions[triangle[c]]], n, d);
+		}
+
+		for(int c = 0; c < 3; c++) {
+			const uint32_t a = positions[triangle[c]];
+			const uint32_t b = positions[triangle[(c + 1) % 3]];
+			const uint32_t shared = lodge_mesh_simplify_edge_triangles(&adjacency, dst, positions, a, b);
+			if(shared == 1) {
+				double pa[3], pb[3];
+				lodge_mesh_position_to_double(pa, mesh->vertices.elements[a].position);
+				lodge_mesh_position_to_double(pb, mesh->vertices.elements[b].position);
+				const double edge[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+
+				double m[3];
+				lodge_mesh_double3_cross(m, edge, n);
+				const double m_length = sqrt(lodge_mesh_double3_dot(m, m));
+				if(m_length > 0.0) {
+					m[0] /= m_length;
+					m[1] /= m_length;
+					m[2] /= m_length;
+					const double m_d = -lodge_mesh_double3_dot(m, pa);
+					lodge_mesh_quadric_add_plane(&quadrics[a], m, m_d);
+					lodge_mesh_quadric_add_plane(&quadrics[b], m, m_d);
+				}
+
+				borders[a]++;
+				borders[b]++;
+			} else if(shared > 2) {
+				borders[a] = LODGE_MESH_SIMPLIFY_NONE;
+				borders[b] = LODGE_MESH_SIMPLIFY_NONE;
+			}
+		}
+	}
+
+	for(size_t i = 0; i < vertices_count; i++) {
+		if(wedges[i] > 1 || (borders[i] != 0 && borders[i] != 2)) {
+			kinds[i] = LODGE_MESH_SIMPLIFY_KIND_LOCKED;
+		} else if(borders[i] == 2) {
+			kinds[i] = LODGE_MESH_SIMPLIFY_KIND_BORDER;
+		} else {
+			kinds[i] = LODGE_MESH_SIMPLIFY_KIND_MANIFOLD;
+		}
+	}
+
+	//
+	// Collapse in passes: pick the cheapest edges, apply as many as possible where nothing
+	// around them has changed yet this pass (so the checks below are exact), then rebuild.
+	//
+	const size_t target_triangles = target_indices_count / 3;
+	const double max_cost = (double)max_error * (double)max_error;
+	double applied_cost = 0.0;
+	uint32_t stamp = 0;
+	uint32_t mark = 0;
+
+	while(count / 3 > target_triangles) {
+		if(stamp != 0) {
+			lodge_mesh_simplify_calc_adjacency(&adjacency, dst, count, positions, vertices_count);
+		}
+
+		size_t candidates_count = 0;
+		for(size_t i = 0; i < count; i++) {
+			const uint32_t a = dst[i];
+			const uint32_t b = dst[i - i % 3 + (i % 3 + 1) % 3];
+			const uint32_t pa = positions[a];
+			const uint32_t pb = positions[b];
+
+			const uint32_t shared = lodge_mesh_simplify_edge_triangles(&adjacency, dst, positions, pa, pb);
+			if(shared > 2 || (shared == 2 && pa > pb)) {
+				// Non-manifold, or the other triangle on this edge adds it.
+				continue;
+			}
+
+			struct lodge_mesh_collapse best = { .cost = -1.0 };
+			for(int direction = 0; direction < 2; direction++) {
+				const uint32_t from = direction ? b : a;
+				const uint32_t to = direction ? a : b;
+				const uint32_t p_from = positions[from];
+				const uint32_t p_to = positions[to];
+
+				if(kinds[p_from] == LODGE_MESH_SIMPLIFY_KIND_LOCKED
+					|| (kinds[p_from] == LODGE_MESH_SIMPLIFY_KIND_BORDER && (shared != 1 || kinds[p_to] == LODGE_MESH_SIMPLIFY_KIND_MANIFOLD))) {
+					continue;
+				}
+
+				struct lodge_mesh_quadric q = quadrics[p_from];
+				lodge_mesh_quadric_add(&q, &quadrics[p_to]);
+
+				double p[3];
+				lodge_mesh_position_to_double(p, mesh->vertices.elements[to].position);
+				const double cost = lodge_mesh_quadric_eval(&q, p);
+
+				if(best.cost < 0.0 || cost < best.cost) {
+					best = (struct lodge_mesh_collapse) {
+						.cost = cost,
+						.from = from,
+						.to = to,
+						.shared = shared,
+					};
+				}
+			}
+
+			if(best.cost >= 0.0 && best.cost <= max_cost) {
+				candidates[candidates_count++] = best;
+			}
+		}
+
+		if(candidates_count == 0) {
+			break;
+		}
+
+		qsort(candidates, candidates_count, sizeof(struct lodge_mesh_collapse), &lodge_mesh_collapse_compare);
+
+		//
+		// Each collapse removes about two triangles. Allow some slack over what is needed, as
+		// not all of them will pass, but not so much that expensive ones get in ahead of
+		// cheaper ones a later pass would find. Close to the target the goal gets tiny, so take
+		// at least the cheapest 1/64th to avoid a long tail of passes that collapse a handful of
+		// edges each. Past the limit, keep going until one passes, or a pass whose cheapest
+		// candidates are all rejected would end the simplification.
+		//
+		const size_t goal = (count / 3 - target_triangles + 1) / 2;
+		const double cost_limit = candidates[min(candidates_count - 1, max(goal + goal / 2, candidates_count / 64))].cost;
+
+		stamp++;
+		size_t removed = 0;
+		size_t collapsed = 0;
+
+		for(size_t i = 0; i < candidates_count && (candidates[i].cost <= cost_limit || collapsed == 0); i++) {
+			const struct lodge_mesh_collapse *collapse = &candidates[i];
+			const uint32_t p_from = positions[collapse->from];
+			const uint32_t p_to = positions[collapse->to];
+
+			if(touched[p_from] == stamp || touched[p_to] == stamp) {
+				continue;
+			}
+
+			//
+			// Link condition: the endpoints may only share the neighbours of the triangles on
+			// the edge, or the collapse pinches the surface into a non-manifold one.
+			//
+			mark += 2;
+			for(uint32_t j = adjacency.offsets[p_from]; j < adjacency.offsets[p_from + 1]; j++) {
+				const uint32_t *triangle = &dst[adjacency.triangles[j] * 3];
+				for(int c = 0; c < 3; c++) {
+					marks[positions[triangle[c]]] = mark;
+				}
+			}
+			uint32_t common = 0;
+			for(uint32_t j = adjacency.offsets[p_to]; j < adjacency.offsets[p_to + 1]; j++) {
+				const uint32_t *triangle = &dst[adjacency.triangles[j] * 3];
+				for(int c = 0; c < 3; c++) {
+					const uint32_t p = positions[triangle[c]];
+					if(p != p_from && p != p_to && marks[p] == mark) {
+						marks[p] = mark + 1;
+						common++;
+					}
+				}
+			}
+			if(common != collapse->shared) {
+				continue;
+			}
+
+			//
+			// Reject collapses that fold a remaining triangle over.
+			//
+			double to_position[3];
+			lodge_mesh_position_to_double(to_position, mesh->vertices.elements[collapse->to].position);
+
+			bool flipped = false;
+			for(uint32_t j = adjacency.offsets[p_from]; j < adjacency.offsets[p_from + 1] && !flipped; j++) {
+				const uint32_t *triangle = &dst[adjacency.triangles[j] * 3];
+				if(lodge_mesh_simplify_triangle_has(triangle, positions, p_to)) {
+					continue;
+				}
+
+				double n_before[3], n_after[3];
+				lodge_mesh_simplify_triangle_normal(n_before, mesh, triangle, LODGE_MESH_SIMPLIFY_NONE, NULL);
+				lodge_mesh_simplify_triangle_normal(n_after, mesh, triangle, collapse->from, to_position);
+
+				const double limit = 0.25 * sqrt(lodge_mesh_double3_dot(n_before, n_before) * lodge_mesh_double3_dot(n_after, n_after));
+				flipped = lodge_mesh_double3_dot(n_before, n_after) <= limit;
+			}
+			if(flipped) {
+				continue;
+			}
+
+			collapses[collapse->from] = collapse->to;
+			lodge_mesh_quadric_add(&quadrics[p_to], &quadrics[p_from]);
+			applied_cost = max(applied_cost, collapse->cost);
+
+			for(uint32_t j = adjacency.offsets[p_from]; j < adjacency.offsets[p_from + 1]; j++) {
+				const uint32_t *triangle = &dst[adjacency.triangles[j] * 3];
+				for(int c = 0; c < 3; c++) {
+					touched[positions[triangle[c]]] = stamp;
+				}
+			}
+			touched[p_to] = stamp;
+
+			collapsed++;
+			removed += collapse->shared;
+			if(count / 3 - removed <= target_triangles) {
+				break;
+			}
+		}
+
+		if(collapsed == 0) {
+			break;
+		}
+
+		for(size_t i = 0; i < count; i++) {
+			dst[i] = collapses[dst[i]];
+		}
+		count = lodge_mesh_simplify_remove_degenerate(dst, count, positions);
+	}
+
+	if(error) {
+		*error = (float)sqrt(applied_cost);
+	}
+
+done:
+	free(adjacency.triangles);
+	free(adjacency.offsets);
+	free(candidates);
+	free(quadrics);
+	free(marks);
+	free(touched);
+	free(collapses);
+	free(kinds);
+	free(borders);
+	free(wedges);
+	free(positions);
+	return count;
+}
+
+float lodge_mesh_lod_distance(float error, float pixel_error, float fov_y, float viewport_height)
+{
+	ASSERT_OR(pixel_error > 0.0f && fov_y > 0.0f && viewport_height > 0.0f) { return 0.0f; }
+
+	//
+	// At distance `d` the viewport spans `2 d tan(fov_y / 2)` object units vertically.
+	//
+	return error * viewport_height / (2.0f * tanf(fov_y * 0.5f) * pixel_error);
+}
+
+bool lodge_mesh_generate_lods(struct lodge_mesh *mesh, const struct lodge_mesh_lods_desc *desc)
+{
+	ASSERT_OR(mesh && desc && mesh->lods_count == 0) { return false; }
+	ASSERT_OR(desc->count <= LODGE_MESH_LODS_MAX) { return false; }
+	ASSERT_OR(mesh->indices.count < UINT32_MAX) { return false; }
+
+	const uint32_t lod0_indices_count = (uint32_t)mesh->indices.count;
+
+	mesh->lods[0] = (struct lodge_mesh_lod) {
+		.indices_offset = 0,
+		.indices_count = lod0_indices_count,
+		.error = 0.0f,
+		.distance = 0.0f,
+	};
+	mesh->lods_count = 1;
+
+	if(desc->count <= 1 || lod0_indices_count == 0) {
+		return true;
+	}
+
+	const float pixel_error = desc->pixel_error > 0.0f ? desc->pixel_error : 1.0f;
+	const float fov_y = desc->fov_y > 0.0f ? desc->fov_y : 1.0471976f;
+	const float viewport_height = desc->viewport_height > 0.0f ? desc->viewport_height : 1080.0f;
+
+	const struct sphere bounding_sphere = lodge_mesh_calc_bounding_sphere(mesh, lodge_mesh_calc_bounds(mesh));
+	const float max_error = (desc->max_error > 0.0f ? desc->max_error : 0.05f) * bounding_sphere.r;
+
+	//
+	// Every LOD is simplified from LOD 0 rather than the previous LOD, so errors do not
+	// compound and each LOD's error is measured against the real surface.
+	//
+	uint32_t *lod0 = (uint32_t *)malloc(lod0_indices_count * sizeof(uint32_t));
+	uint32_t *lod = (uint32_t *)malloc(lod0_indices_count * sizeof(uint32_t));
+	ASSERT_OR(lod0 && lod) {
+		free(lod0);
+		free(lod);
+		return false;
+	}
+	memcpy(lod0, mesh->indices.elements, lod0_indices_count * sizeof(uint32_t));
+
+	float ratio = 1.0f;
+	for(uint32_t i = 1; i < desc->count; i++) {
+		ratio = desc->ratios[i] > 0.0f ? desc->ratios[i] : ratio * 0.5f;
+		const size_t target_indices_count = (size_t)((double)(lod0_indices_count / 3) * ratio) * 3;
+
+		float error = 0.0f;
+		const size_t lod_indices_count = lodge_mesh_simplify(lod, mesh, lod0, lod0_indices_count, target_indices_count, max_error, &error);
+
+		//
+		// Out of error budget: a LOD that saves less than 10% is not worth a draw switch.
+		//
+		const struct lodge_mesh_lod *prev = &mesh->lods[i - 1];
+		if(lod_indices_count == 0 || lod_indices_count * 10 > (size_t)prev->indices_count * 9) {
+			break;
+		}
+
+		const size_t offset = mesh->indices.count;
+		ASSERT_OR(dynbuf_append_range(dynbuf(mesh->indices), lod, sizeof(uint32_t), lod_indices_count)) { break; }
+
+		error = max(error, prev->error);
+		mesh->lods[i] = (struct lodge_mesh_lod) {
+			.indices_offset = (uint32_t)offset,
+			.indices_count = (uint32_t)lod_indices_count,
+			.error = error,
+			.distance = lodge_mesh_lod_distance(error, pixel_error, fov_y, viewport_height),
+		};
+		mesh->lods_count++;
+	}
+
+	free(lod);
+	free(lod0);
+	return true;
+}
@@ -0,0 +1,56 @@
+//
+// Mesh simplification and LOD chains.
+//
+// Edges are collapsed in quadric error order (Garland and Heckbert, "Surface Simplification
+// Using Quadric Error Metrics"), always onto one of the edge's own vertices. No vertices are
+// created, so every LOD is just another index range over the full mesh's vertex buffer.
+//
+// The result only depends on the input.
+//
+#ifndef _LODGE_MESH_SIMPLIFY_H
+#define _LODGE_MESH_SIMPLIFY_H
+
+#include "lodge_mesh.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+//
+// Zeroed fields pick the default noted next to them.
+//
+struct lodge_mesh_lods_desc
+{
+	uint32_t				count;							// Including LOD 0. At most `LODGE_MESH_LODS_MAX`.
+	float					ratios[LODGE_MESH_LODS_MAX];	// Triangles relative to LOD 0. Default: half of the previous LOD.
+	float					max_error;						// Relative to the bounding sphere radius. Default: 0.05.
+	float					pixel_error;					// Tolerated on screen when switching. Default: 1.
+	float					fov_y;							// Radians. Default: 60 degrees.
+	float					viewport_height;				// Pixels. Default: 1080.
+};
+
+//
+// Simplifies the triangles in `indices` (over `mesh` vertices) towards `target_indices_count`,
+// without moving any surface further than `max_error` (object space). Seams and open borders
+// are kept intact.
+//
+// Writes at most `indices_count` indices to `dst` and returns how many. `error` is set to the
+// largest deviation introduced.
+//
+size_t						lodge_mesh_simplify(uint32_t *dst, const struct lodge_mesh *mesh, const uint32_t *indices, size_t indices_count, size_t target_indices_count, float max_error, float *error);
+
+//
+// The distance at which `error` (object space) projects to `pixel_error` pixels.
+//
+float						lodge_mesh_lod_distance(float error, float pixel_error, float fov_y, float viewport_height);
+
+//
+// Appends the LODs in `desc` to `mesh->indices` and fills in `mesh->lods`. Stops early once
+// a LOD would exceed the error bound or barely reduce the previous one, so `lods_count` may
+// end up lower than `desc->count`.
+//
+// `mesh` must not have LODs yet.
+//
+bool						lodge_mesh_generate_lods(struct lodge_mesh *mesh, const struct lodge_mesh_lods_desc *desc);
+
+#endif
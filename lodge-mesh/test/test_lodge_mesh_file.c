@@ -0,0 +1,337 @@
+//
+// `.lmesh` cooking and loading: the cooked bytes match a hand built file image, cooking is
+// deterministic, a loaded file gives back the cooked mesh and malformed files are rejected.
+//
+
+#include "lodge_mesh.h"
+#include "lodge_mesh_cook.h"
+#include "lodge_mesh_file.h"
+
+#include "lodge_platform.h"
+#include "lodge_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static const struct lodge_mesh_vertex test_triangle_vertices[] = {
+	{ .position = { 0.0f, 0.0f, 0.0f }, .normal = { 0.0f, 0.0f, 1.0f }, .tex_coord = { 0.0f, 0.0f } },
+	{ .position = { 2.0f, 0.0f, 0.0f }, .normal = { 0.0f, 0.0f, 1.0f }, .tex_coord = { 1.0f, 0.0f } },
+	{ .position = { 0.0f, 2.0f, 0.0f }, .normal = { 0.0f, 0.0f, 1.0f }, .tex_coord = { 0.0f, 1.0f } },
+};
+
+static const uint32_t test_triangle_indices[] = { 0, 1, 2 };
+
+static struct lodge_mesh test_mesh_make(const struct lodge_mesh_vertex *vertices, size_t vertices_count, const uint32_t *indices, size_t indices_count)
+{
+	struct lodge_mesh mesh = { 0 };
+	mesh.vertices.count = mesh.vertices.capacity = vertices_count;
+	mesh.vertices.elements = malloc(vertices_count * sizeof(struct lodge_mesh_vertex));
+	memcpy(mesh.vertices.elements, vertices, vertices_count * sizeof(struct lodge_mesh_vertex));
+	mesh.indices.count = mesh.indices.capacity = indices_count;
+	mesh.indices.elements = malloc(indices_count * sizeof(uint32_t));
+	memcpy(mesh.indices.elements, indices, indices_count * sizeof(uint32_t));
+	return mesh;
+}
+
+//
+// A grid with enough vertices to need 32-bit indices when `n` is large.
+//
+static struct lodge_mesh test_grid_make(uint32_t n)
+{
+	struct lodge_mesh mesh = { 0 };
+	mesh.vertices.count = mesh.vertices.capacity = (size_t)(n + 1) * (n + 1);
+	mesh.vertices.elements = malloc(mesh.vertices.count * sizeof(struct lodge_mesh_vertex));
+	for(uint32_t y = 0; y <= n; y++) {
+		for(uint32_t x = 0; x <= n; x++) {
+			const float u = (float)x / n;
+			const float v = (float)y / n;
+			mesh.vertices.elements[y * (n + 1) + x] = (struct lodge_mesh_vertex) {
+				.position = vec3_make(u * 10.0f, sinf(u * 7.0f) * cosf(v * 5.0f), v * 10.0f),
+				.normal = vec3_make(0.0f, 1.0f, 0.0f),
+				.tex_coord = vec2_make(u, v),
+			};
+		}
+	}
+
+	mesh.indices.count = mesh.indices.capacity = (size_t)n * n * 6;
+	mesh.indices.elements = malloc(mesh.indices.count * sizeof(uint32_t));
+	uint32_t *it = mesh.indices.elements;
+	for(uint32_t y = 0; y < n; y++) {
+		for(uint32_t x = 0; x < n; x++) {
+			const uint32_t i = y * (n + 1) + x;
+			*it++ = i; *it++ = i + n + 1; *it++ = i + 1;
+			*it++ = i + 1; *it++ = i + n + 1; *it++ = i + n + 2;
+		}
+	}
+	return mesh;
+}
+
+static void test_write_f32(char *dst, size_t offset, float a, float b, float c)
+{
+	const float v[3] = { a, b, c };
+	memcpy(dst + offset, v, sizeof(v));
+}
+
+static void test_write_u16(char *dst, size_t offset, uint16_t a, uint16_t b, uint16_t c)
+{
+	const uint16_t v[3] = { a, b, c };
+	memcpy(dst + offset, v, sizeof(v));
+}
+
+static void test_write_u32(char *dst, size_t offset, uint32_t a, uint32_t b, uint32_t c)
+{
+	const uint32_t v[3] = { a, b, c };
+	memcpy(dst + offset, v, sizeof(v));
+}
+
+static struct lodge_mesh_file_header test_triangle_header(uint32_t stride, uint32_t format, uint32_t index_size)
+{
+	const uint32_t component_size = format == LODGE_MESH_ATTRIB_FORMAT_FLOAT16 ? 2 : 4;
+	return (struct lodge_mesh_file_header) {
+		.magic = { 'L', 'M', 'S', 'H' },
+		.version = LODGE_MESH_FILE_VERSION,
+		.vertices_offset = 256,
+		.indices_offset = (256 + 3 * stride + 15) / 16 * 16,
+		.vertices_count = 3,
+		.vertex_stride = stride,
+		.indices_count = 3,
+		.index_size = index_size,
+		.attribs = {
+			[LODGE_MESH_ATTRIB_POSITION] = { .format = LODGE_MESH_ATTRIB_FORMAT_FLOAT32, .components = 3, .offset = 0 },
+			[LODGE_MESH_ATTRIB_NORMAL] = { .format = format, .components = 3, .offset = 12 },
+			[LODGE_MESH_ATTRIB_TEX_COORD] = { .format = format, .components = 2, .offset = stride - 2 * component_size },
+		},
+		.bounds = { .min = { 0.0f, 0.0f, 0.0f }, .max = { 2.0f, 2.0f, 0.0f } },
+		.bounding_sphere = { .pos = { 1.0f, 1.0f, 0.0f }, .r = sqrtf(2.0f) },
+		.lods_count = 1,
+		.lods = { { .indices_offset = 0, .indices_count = 3 } },
+	};
+}
+
+//
+// The file images are built field by field here, independently of the cooker.
+//
+static void test_cook_golden_f32_index16()
+{
+	struct lodge_mesh mesh = test_mesh_make(test_triangle_vertices, 3, test_triangle_indices, 3);
+
+	size_t size = 0;
+	char *cooked = lodge_mesh_cook(&mesh, &(struct lodge_mesh_cook_desc) { 0 }, &size);
+	LODGE_TEST_CHECK(cooked);
+
+	char expected[358] = { 0 };
+	const struct lodge_mesh_file_header header = test_triangle_header(32, LODGE_MESH_ATTRIB_FORMAT_FLOAT32, 2);
+	memcpy(expected, &header, sizeof(header));
+	for(uint32_t i = 0; i < 3; i++) {
+		const struct lodge_mesh_vertex *v = &test_triangle_vertices[i];
+		test_write_f32(expected, 256 + i * 32 + 0, v->position.x, v->position.y, v->position.z);
+		test_write_f32(expected, 256 + i * 32 + 12, v->normal.x, v->normal.y, v->normal.z);
+		memcpy(expected + 256 + i * 32 + 24, v->tex_coord.v, 2 * sizeof(float));
+	}
+	test_write_u16(expected, 352, 0, 1, 2);
+
+	LODGE_TEST_CHECK_MSG(size == sizeof(expected), "size: %zu", size);
+	LODGE_TEST_CHECK(cooked && size == sizeof(expected) && memcmp(cooked, expected, size) == 0);
+
+	free(cooked);
+	lodge_mesh_free_inplace(&mesh);
+}
+
+static void test_cook_golden_f16_index32()
+{
+	struct lodge_mesh mesh = test_mesh_make(test_triangle_vertices, 3, test_triangle_indices, 3);
+
+	size_t size = 0;
+	char *cooked = lodge_mesh_cook(&mesh, &(struct lodge_mesh_cook_desc) { .half_floats = true, .index32 = true }, &size);
+	LODGE_TEST_CHECK(cooked);
+
+	//
+	// Stride is 12 (position) + 6 (normal) + 2 (padding) + 4 (tex coord).
+	//
+	char expected[348] = { 0 };
+	const struct lodge_mesh_file_header header = test_triangle_header(24, LODGE_MESH_ATTRIB_FORMAT_FLOAT16, 4);
+	memcpy(expected, &header, sizeof(header));
+	const uint16_t half_one = 0x3c00;
+	const uint16_t tex_coords[3][2] = { { 0, 0 }, { half_one, 0 }, { 0, half_one } };
+	for(uint32_t i = 0; i < 3; i++) {
+		const struct lodge_mesh_vertex *v = &test_triangle_vertices[i];
+		test_write_f32(expected, 256 + i * 24 + 0, v->position.x, v->position.y, v->position.z);
+		test_write_u16(expected, 256 + i * 24 + 12, 0, 0, half_one);
+		memcpy(expected + 256 + i * 24 + 20, tex_coords[i], sizeof(tex_coords[i]));
+	}
+	test_write_u32(expected, 336, 0, 1, 2);
+
+	LODGE_TEST_CHECK_MSG(size == sizeof(expected), "size: %zu", size);
+	LODGE_TEST_CHECK(cooked && size == sizeof(expected) && memcmp(cooked, expected, size) == 0);
+
+	free(cooked);
+	lodge_mesh_free_inplace(&mesh);
+}
+
+static void test_cook_deterministic()
+{
+	struct lodge_mesh mesh = test_grid_make(300);
+
+	for(int flags = 0; flags < 4; flags++) {
+		const struct lodge_mesh_cook_desc desc = { .half_floats = flags & 1, .index32 = flags & 2 };
+
+		size_t size_a = 0, size_b = 0;
+		char *a = lodge_mesh_cook(&mesh, &desc, &size_a);
+		char *b = lodge_mesh_cook(&mesh, &desc, &size_b);
+		LODGE_TEST_CHECK_MSG(a && b && size_a == size_b && memcmp(a, b, size_a) == 0, "flags: %d", flags);
+		free(a);
+		free(b);
+	}
+
+	lodge_mesh_free_inplace(&mesh);
+}
+
+static vec3 test_read_vec3(const char *src, const struct lodge_mesh_file_attrib *attrib)
+{
+	vec3 v = vec3_zero();
+	for(uint32_t i = 0; i < 3; i++) {
+		if(attrib->format == LODGE_MESH_ATTRIB_FORMAT_FLOAT16) {
+			uint16_t h;
+			memcpy(&h, src + attrib->offset + i * sizeof(uint16_t), sizeof(h));
+			v.v[i] = lodge_mesh_float_from_half(h);
+		} else {
+			memcpy(&v.v[i], src + attrib->offset + i * sizeof(float), sizeof(float));
+		}
+	}
+	return v;
+}
+
+static void test_round_trip()
+{
+	//
+	// 301x301 vertices do not fit 16-bit indices, 100x100 do.
+	//
+	const uint32_t sizes[] = { 100, 300 };
+
+	for(size_t s = 0; s < LODGE_ARRAYSIZE(sizes); s++) {
+		struct lodge_mesh mesh = test_grid_make(sizes[s]);
+
+		for(int half_floats = 0; half_floats < 2; half_floats++) {
+			size_t size = 0;
+			char *cooked = lodge_mesh_cook(&mesh, &(struct lodge_mesh_cook_desc) { .half_floats = half_floats }, &size);
+
+			struct lodge_mesh_file file;
+			LODGE_TEST_CHECK(cooked && lodge_mesh_file_init(&file, cooked, size));
+			if(!cooked) {
+				continue;
+			}
+
+			const struct lodge_mesh_file_header *header = file.header;
+			LODGE_TEST_CHECK(header->vertices_count == mesh.vertices.count);
+			LODGE_TEST_CHECK(header->indices_count == mesh.indices.count);
+			LODGE_TEST_CHECK(header->index_size == (mesh.vertices.count <= UINT16_MAX + 1 ? 2 : 4));
+
+			float max_error = 0.0f;
+			bool positions_exact = true;
+			for(uint32_t i = 0; i < header->vertices_count; i++) {
+				const char *vertex = file.vertices + (size_t)i * header->vertex_stride;
+				const struct lodge_mesh_vertex *expected = &mesh.vertices.elements[i];
+
+				const vec3 position = test_read_vec3(vertex, &header->attribs[LODGE_MESH_ATTRIB_POSITION]);
+				positions_exact &= memcmp(&position, &expected->position, sizeof(vec3)) == 0;
+
+				const vec3 normal = test_read_vec3(vertex, &header->attribs[LODGE_MESH_ATTRIB_NORMAL]);
+				max_error = max(max_error, vec3_distance(normal, expected->normal));
+			}
+			LODGE_TEST_CHECK(positions_exact);
+			LODGE_TEST_CHECK_MSG(max_error <= (half_floats ? 1.0e-3f : 0.0f), "normal error: %g", max_error);
+
+			bool indices_equal = true;
+			for(uint32_t i = 0; i < header->indices_count; i++) {
+				uint32_t index = 0;
+				memcpy(&index, file.indices + (size_t)i * header->index_size, header->index_size);
+				indices_equal &= index == mesh.indices.elements[i];
+			}
+			LODGE_TEST_CHECK(indices_equal);
+
+			free(cooked);
+		}
+
+		lodge_mesh_free_inplace(&mesh);
+	}
+}
+
+static char* test_cook_triangle(size_t *size)
+{
+	struct lodge_mesh mesh = test_mesh_make(test_triangle_vertices, 3, test_triangle_indices, 3);
+	char *cooked = lodge_mesh_cook(&mesh, &(struct lodge_mesh_cook_desc) { 0 }, size);
+	lodge_mesh_free_inplace(&mesh);
+	return cooked;
+}
+
+static void test_reject_truncated()
+{
+	size_t size = 0;
+	char *cooked = test_cook_triangle(&size);
+	struct lodge_mesh_file file;
+
+	for(size_t i = 0; i < size; i++) {
+		//
+		// A copy of exactly `i` bytes, so reads past it are caught by sanitizers.
+		//
+		char *prefix = malloc(i ? i : 1);
+		memcpy(prefix, cooked, i);
+		LODGE_TEST_CHECK_MSG(!lodge_mesh_file_init(&file, prefix, i), "prefix: %zu", i);
+		free(prefix);
+	}
+	LODGE_TEST_CHECK(lodge_mesh_file_init(&file, cooked, size));
+
+	free(cooked);
+}
+
+static void test_reject_attrib_offset_overflow()
+{
+	size_t size = 0;
+	char *cooked = test_cook_triangle(&size);
+	struct lodge_mesh_file_header *header = (struct lodge_mesh_file_header *)cooked;
+	struct lodge_mesh_file file;
+
+	//
+	// offset + 2 * 4 wraps to 0 in 32 bits.
+	//
+	header->attribs[LODGE_MESH_ATTRIB_TEX_COORD].offset = UINT32_MAX - 7;
+	LODGE_TEST_CHECK(!lodge_mesh_file_init(&file, cooked, size));
+
+	header->attribs[LODGE_MESH_ATTRIB_TEX_COORD].offset = header->vertex_stride - 4;
+	LODGE_TEST_CHECK(!lodge_mesh_file_init(&file, cooked, size));
+
+	free(cooked);
+}
+
+static void test_reject_index_out_of_range()
+{
+	size_t size = 0;
+	char *cooked = test_cook_triangle(&size);
+	const struct lodge_mesh_file_header *header = (const struct lodge_mesh_file_header *)cooked;
+	uint16_t *indices = (uint16_t *)(cooked + header->indices_offset);
+	struct lodge_mesh_file file;
+
+	indices[2] = 3;
+	LODGE_TEST_CHECK(!lodge_mesh_file_init(&file, cooked, size));
+
+	indices[2] = UINT16_MAX;
+	LODGE_TEST_CHECK(!lodge_mesh_file_init(&file, cooked, size));
+
+	indices[2] = 2;
+	LODGE_TEST_CHECK(lodge_mesh_file_init(&file, cooked, size));
+
+	free(cooked);
+}
+
+int main(int argc, char **argv)
+{
+	LODGE_TEST_RUN(test_cook_golden_f32_index16);
+	LODGE_TEST_RUN(test_cook_golden_f16_index32);
+	LODGE_TEST_RUN(test_cook_deterministic);
+	LODGE_TEST_RUN(test_round_trip);
+	LODGE_TEST_RUN(test_reject_truncated);
+	LODGE_TEST_RUN(test_reject_attrib_offset_overflow);
+	LODGE_TEST_RUN(test_reject_index_out_of_range);
+	return lodge_test_result();
+}
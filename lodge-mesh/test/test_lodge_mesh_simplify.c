@@ -0,0 +1,261 @@
+//
+// Simplifier and LOD chain: simplified index and vertex counts, the reported error against
+// a measured surface distance, determinism and monotonic LOD chains.
+//
+
+#include "lodge_mesh.h"
+#include "lodge_mesh_simplify.h"
+
+#include "dynbuf.h"
+#include "lodge_platform.h"
+#include "lodge_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+enum test_shape
+{
+	TEST_SHAPE_FLAT,
+	TEST_SHAPE_BUMPY,
+	TEST_SHAPE_SPHERE,
+};
+
+//
+// An `n` x `n` quad grid. Flat and bumpy grids have open borders, the sphere is welded
+// into a closed surface.
+//
+static struct lodge_mesh test_mesh_make(enum test_shape shape, uint32_t n)
+{
+	struct lodge_mesh mesh = { 0 };
+
+	for(uint32_t y = 0; y <= n; y++) {
+		for(uint32_t x = 0; x <= n; x++) {
+			const float u = (float)x / n;
+			const float v = (float)y / n;
+			struct lodge_mesh_vertex vertex = { .tex_coord = vec2_make(u, v) };
+
+			if(shape == TEST_SHAPE_SPHERE) {
+				const float theta = u * 2.0f * 3.14159265f;
+				const float phi = v * 3.14159265f;
+				vertex.position = vec3_make(sinf(phi) * cosf(theta), sinf(phi) * sinf(theta), cosf(phi));
+				vertex.normal = vertex.position;
+				vertex.tex_coord = vec2_make(0.0f, 0.0f);
+			} else {
+				const float height = shape == TEST_SHAPE_BUMPY ? sinf(u * 6.0f) * cosf(v * 5.0f) : 0.0f;
+				vertex.position = vec3_make(u * 10.0f, v * 10.0f, height);
+				vertex.normal = vec3_make(0.0f, 0.0f, 1.0f);
+			}
+			dynbuf_append(dynbuf(mesh.vertices), &vertex, sizeof(vertex));
+		}
+	}
+
+	for(uint32_t y = 0; y < n; y++) {
+		for(uint32_t x = 0; x < n; x++) {
+			const uint32_t a = y * (n + 1) + x;
+			uint32_t quad[6] = { a, a + 1, a + n + 2, a, a + n + 2, a + n + 1 };
+			dynbuf_append_range(dynbuf(mesh.indices), quad, sizeof(uint32_t), 6);
+		}
+	}
+
+	if(shape == TEST_SHAPE_SPHERE) {
+		lodge_mesh_weld(&mesh);
+	}
+	return mesh;
+}
+
+//
+// Largest distance from the corners and centroids of `from` to the surface of `to`.
+//
+static double test_surface_distance(const struct lodge_mesh *mesh, const uint32_t *from, size_t from_count, const uint32_t *to, size_t to_count)
+{
+	const struct lodge_mesh_vertex *vertices = mesh->vertices.elements;
+
+	double worst = 0.0;
+	for(size_t i = 0; i < from_count; i += 3) {
+		const vec3 a = vertices[from[i + 0]].position;
+		const vec3 b = vertices[from[i + 1]].position;
+		const vec3 c = vertices[from[i + 2]].position;
+		const vec3 samples[4] = { a, b, c, vec3_mult_scalar(vec3_add(a, vec3_add(b, c)), 1.0f / 3.0f) };
+
+		for(size_t s = 0; s < LODGE_ARRAYSIZE(samples); s++) {
+			double best = INFINITY;
+			for(size_t t = 0; t < to_count; t += 3) {
+				best = fmin(best, lodge_test_distance_to_triangle(samples[s], vertices[to[t + 0]].position, vertices[to[t + 1]].position, vertices[to[t + 2]].position));
+			}
+			worst = fmax(worst, best);
+		}
+	}
+	return worst;
+}
+
+static size_t test_count_used_vertices(const struct lodge_mesh *mesh, const uint32_t *indices, size_t indices_count)
+{
+	bool *used = calloc(mesh->vertices.count, sizeof(bool));
+	size_t count = 0;
+	for(size_t i = 0; i < indices_count; i++) {
+		count += !used[indices[i]];
+		used[indices[i]] = true;
+	}
+	free(used);
+	return count;
+}
+
+static bool test_indices_valid(const struct lodge_mesh *mesh, const uint32_t *indices, size_t indices_count)
+{
+	if(indices_count % 3 != 0) {
+		return false;
+	}
+	for(size_t i = 0; i < indices_count; i += 3) {
+		if(indices[i] >= mesh->vertices.count || indices[i + 1] >= mesh->vertices.count || indices[i + 2] >= mesh->vertices.count
+			|| indices[i] == indices[i + 1] || indices[i + 1] == indices[i + 2] || indices[i] == indices[i + 2]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//
+// A flat grid costs nothing to simplify, so every target is reached.
+//
+static void test_simplify_counts()
+{
+	struct lodge_mesh mesh = test_mesh_make(TEST_SHAPE_FLAT, 20);
+	const size_t indices_count = mesh.indices.count;
+	const size_t vertices_used = test_count_used_vertices(&mesh, mesh.indices.elements, indices_count);
+	uint32_t *dst = malloc(indices_count * sizeof(uint32_t));
+
+	const float ratios[] = { 0.5f, 0.25f, 0.1f, 0.02f };
+	size_t prev_vertices_used = vertices_used;
+	for(size_t r = 0; r < LODGE_ARRAYSIZE(ratios); r++) {
+		const size_t target = (size_t)((indices_count / 3) * ratios[r]) * 3;
+
+		float error = -1.0f;
+		const size_t count = lodge_mesh_simplify(dst, &mesh, mesh.indices.elements, indices_count, target, 1.0f, &error);
+		const size_t used = test_count_used_vertices(&mesh, dst, count);
+
+		LODGE_TEST_CHECK(test_indices_valid(&mesh, dst, count));
+		LODGE_TEST_CHECK_MSG(count <= target && count + 6 >= target, "ratio %g: %zu indices, target %zu", ratios[r], count, target);
+		LODGE_TEST_CHECK_MSG(used < prev_vertices_used, "ratio %g: %zu vertices used, before %zu", ratios[r], used, prev_vertices_used);
+		LODGE_TEST_CHECK_MSG(error == 0.0f, "ratio %g: error %g", ratios[r], error);
+		prev_vertices_used = used;
+	}
+
+	//
+	// No vertices are created or moved.
+	//
+	LODGE_TEST_CHECK(mesh.vertices.count == (size_t)21 * 21);
+
+	free(dst);
+	lodge_mesh_free_inplace(&mesh);
+}
+
+//
+// The reported error bounds the measured two-sided distance between the surfaces, and
+// never exceeds `max_error`.
+//
+static void test_simplify_error_bound()
+{
+	const enum test_shape shapes[] = { TEST_SHAPE_BUMPY, TEST_SHAPE_SPHERE };
+
+	for(size_t s = 0; s < LODGE_ARRAYSIZE(shapes); s++) {
+		struct lodge_mesh mesh = test_mesh_make(shapes[s], 20);
+		const size_t indices_count = mesh.indices.count;
+		uint32_t *dst = malloc(indices_count * sizeof(uint32_t));
+
+		const float ratios[] = { 0.5f, 0.25f, 0.1f };
+		for(size_t r = 0; r < LODGE_ARRAYSIZE(ratios); r++) {
+			const size_t target = (size_t)((indices_count / 3) * ratios[r]) * 3;
+
+			float error = 0.0f;
+			const size_t count = lodge_mesh_simplify(dst, &mesh, mesh.indices.elements, indices_count, target, 1.0e9f, &error);
+			LODGE_TEST_CHECK(test_indices_valid(&mesh, dst, count));
+
+			const double distance = fmax(
+				test_surface_distance(&mesh, mesh.indices.elements, indices_count, dst, count),
+				test_surface_distance(&mesh, dst, count, mesh.indices.elements, indices_count)
+			);
+			LODGE_TEST_CHECK_MSG(distance <= error + 1.0e-4, "shape %zu, ratio %g: distance %g, error %g", s, ratios[r], distance, error);
+
+			//
+			// Half the error budget stops the simplifier early.
+			//
+			const float max_error = error * 0.5f;
+			float bounded_error = 0.0f;
+			const size_t bounded_count = lodge_mesh_simplify(dst, &mesh, mesh.indices.elements, indices_count, target, max_error, &bounded_error);
+			LODGE_TEST_CHECK(test_indices_valid(&mesh, dst, bounded_count));
+			LODGE_TEST_CHECK_MSG(bounded_error <= max_error, "shape %zu, ratio %g: error %g, max %g", s, ratios[r], bounded_error, max_error);
+			LODGE_TEST_CHECK_MSG(bounded_count > count, "shape %zu, ratio %g: %zu indices, unbounded %zu", s, ratios[r], bounded_count, count);
+		}
+
+		free(dst);
+		lodge_mesh_free_inplace(&mesh);
+	}
+}
+
+static void test_simplify_deterministic()
+{
+	struct lodge_mesh mesh = test_mesh_make(TEST_SHAPE_BUMPY, 30);
+	const size_t indices_count = mesh.indices.count;
+	uint32_t *a = malloc(indices_count * sizeof(uint32_t));
+	uint32_t *b = malloc(indices_count * sizeof(uint32_t));
+
+	float error_a = 0.0f, error_b = 0.0f;
+	const size_t count_a = lodge_mesh_simplify(a, &mesh, mesh.indices.elements, indices_count, indices_count / 4, 1.0e9f, &error_a);
+	const size_t count_b = lodge_mesh_simplify(b, &mesh, mesh.indices.elements, indices_count, indices_count / 4, 1.0e9f, &error_b);
+	LODGE_TEST_CHECK(count_a == count_b && error_a == error_b && memcmp(a, b, count_a * sizeof(uint32_t)) == 0);
+
+	free(a);
+	free(b);
+	lodge_mesh_free_inplace(&mesh);
+}
+
+//
+// Every LOD has fewer triangles than the one before, an error and switch distance no
+// smaller, and lies within the index buffer. LOD 0 is left as it was.
+//
+static void test_lods_monotonic()
+{
+	const enum test_shape shapes[] = { TEST_SHAPE_BUMPY, TEST_SHAPE_SPHERE };
+
+	for(size_t s = 0; s < LODGE_ARRAYSIZE(shapes); s++) {
+		struct lodge_mesh mesh = test_mesh_make(shapes[s], 30);
+		const size_t lod0_indices_count = mesh.indices.count;
+		uint32_t *lod0 = malloc(lod0_indices_count * sizeof(uint32_t));
+		memcpy(lod0, mesh.indices.elements, lod0_indices_count * sizeof(uint32_t));
+
+		LODGE_TEST_CHECK(lodge_mesh_generate_lods(&mesh, &(struct lodge_mesh_lods_desc) { .count = 5, .max_error = 0.2f }));
+		LODGE_TEST_CHECK_MSG(mesh.lods_count >= 3, "shape %zu: %u LODs", s, mesh.lods_count);
+
+		LODGE_TEST_CHECK(mesh.lods[0].indices_offset == 0 && mesh.lods[0].indices_count == lod0_indices_count);
+		LODGE_TEST_CHECK(memcmp(mesh.indices.elements, lod0, lod0_indices_count * sizeof(uint32_t)) == 0);
+
+		for(uint32_t i = 0; i < mesh.lods_count; i++) {
+			const struct lodge_mesh_lod *lod = &mesh.lods[i];
+			LODGE_TEST_CHECK((uint64_t)lod->indices_offset + lod->indices_count <= mesh.indices.count);
+
+			//
+			// LOD 0 keeps the sphere's degenerate pole triangles.
+			//
+			if(i > 0) {
+				const struct lodge_mesh_lod *prev = &mesh.lods[i - 1];
+				LODGE_TEST_CHECK(test_indices_valid(&mesh, mesh.indices.elements + lod->indices_offset, lod->indices_count));
+				LODGE_TEST_CHECK_MSG(lod->indices_count < prev->indices_count, "shape %zu, LOD %u: %u tris, before %u", s, i, lod->indices_count / 3, prev->indices_count / 3);
+				LODGE_TEST_CHECK(lod->error >= prev->error);
+				LODGE_TEST_CHECK(lod->distance >= prev->distance);
+			}
+		}
+
+		free(lod0);
+		lodge_mesh_free_inplace(&mesh);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	LODGE_TEST_RUN(test_simplify_counts);
+	LODGE_TEST_RUN(test_simplify_error_bound);
+	LODGE_TEST_RUN(test_simplify_deterministic);
+	LODGE_TEST_RUN(test_lods_monotonic);
+	return lodge_test_result();
+}
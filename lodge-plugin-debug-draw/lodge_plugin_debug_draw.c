@@ -226,7 +226,12 @@ static lodge_system_type_t lodge_debug_draw_system_type_register(struct lodge_pl
 					.on_modified = NULL,
 				},
 			}
-		}
+		},
+		.flags = LODGE_SYSTEM_TYPE_FLAG_CONCURRENT | LODGE_SYSTEM_TYPE_FLAG_MAIN_THREAD,
+		.reads = {
+			.count = 2,
+			.elements = { LODGE_COMPONENT_TYPE_DEBUG_SPHERE, LODGE_COMPONENT_TYPE_TRANSFORM },
+		},
 	});
 }
 
@@ -246,10 +251,10 @@ struct lodge_ret lodge_debug_draw_plugin_new_inplace(struct lodge_plugin_debug_d
 {
 	plugin->shaders = dependencies[PLUGIN_IDX_SHADERS];
 
-	plugin->system_type = lodge_debug_draw_system_type_register(plugin);
-	ASSERT(plugin->system_type);
-
 	plugin->sphere_component_type = lodge_debug_sphere_component_type_register();
+	ASSERT(plugin->sphere_component_type);
+
+	plugin->system_type = lodge_debug_draw_system_type_register(plugin);
 	ASSERT(plugin->system_type);
 
 	return lodge_success();
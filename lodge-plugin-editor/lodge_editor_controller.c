@@ -43,12 +43,10 @@ static void lodge_editor_controller_component_move(struct lodge_editor_controlle
 static void lodge_editor_controller_component_snap_to_target_pos(lodge_scene_t scene, struct lodge_editor_controller_component *component)
 {
 	lodge_entity_t owner = lodge_scene_get_component_entity(scene, LODGE_COMPONENT_TYPE_EDITOR_CONTROLLER, component);
+	ASSERT(owner);
 
-	struct lodge_transform_component *owner_transform = lodge_scene_get_entity_component(scene, owner, LODGE_COMPONENT_TYPE_TRANSFORM);
-	ASSERT(owner_transform);
-		
-	if(owner_transform) {
-		owner_transform->translation = component->target_pos;
+	if(owner) {
+		lodge_set_position(scene, owner, component->target_pos);
 	}
 }
 
@@ -198,20 +196,11 @@ static void lodge_editor_controller_system_update(struct lodge_editor_controller
 		}
 
 		if(owner) {
-			struct lodge_transform_component *owner_transform = lodge_scene_get_entity_component(scene, owner, LODGE_COMPONENT_TYPE_TRANSFORM);
-			ASSERT(owner_transform);
-
-			if(owner_transform) {
-				//
-				// NOTE(TS): not implemented for local space yet; it is trivial to add
-				//
-				ASSERT(owner_transform->space == LODGE_TRANSFORM_SPACE_WORLD);
-
-				//
-				// Lerp towards `target_pos`
-				//
-				owner_transform->translation = vec3_lerp(owner_transform->translation, component->target_pos, component->move_lerp_speed*dt);
-			}
+			//
+			// Lerp towards `target_pos`
+			//
+			const vec3 owner_pos = lodge_get_position(scene, owner);
+			lodge_set_position(scene, owner, vec3_lerp(owner_pos, component->target_pos, component->move_lerp_speed*dt));
 		}
 	}
 }
@@ -228,6 +217,15 @@ lodge_system_type_t lodge_editor_controller_system_type_register(struct lodge_ed
 		.properties = {
 			.count = 0,
 			.elements = { 0 }
-		}
+		},
+		.flags = LODGE_SYSTEM_TYPE_FLAG_CONCURRENT,
+		.reads = {
+			.count = 1,
+			.elements = { LODGE_COMPONENT_TYPE_CAMERA },
+		},
+		.writes = {
+			.count = 2,
+			.elements = { LODGE_COMPONENT_TYPE_EDITOR_CONTROLLER, LODGE_COMPONENT_TYPE_TRANSFORM },
+		},
 	});
 }
\ No newline at end of file
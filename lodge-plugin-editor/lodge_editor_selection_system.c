@@ -33,7 +33,7 @@ static void lodge_editor_selection_system_update(struct lodge_editor_selection_s
 static size_t lodge_entity_to_sparse_index(lodge_entity_t entity)
 {
 	ASSERT(entity);
-	return (size_t)((uintptr_t)entity - 1);
+	return (size_t)lodge_entity_get_id(entity);
 }
 
 lodge_system_type_t lodge_editor_selection_system_type_register(struct lodge_editor *plugin)
@@ -56,7 +56,8 @@ lodge_system_type_t lodge_editor_selection_system_type_register(struct lodge_edi
 						.flags = LODGE_PROPERTY_FLAG_READ_ONLY,
 					}
 				}
-			}
+			},
+			.flags = LODGE_SYSTEM_TYPE_FLAG_CONCURRENT,
 		});
 	}
 
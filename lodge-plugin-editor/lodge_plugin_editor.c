@@ -212,10 +212,12 @@ static struct lodge_ret lodge_editor_new_inplace(struct lodge_editor *editor, st
 		editor->gui = lodge_gui_new(editor->window, 32 * 1024 * 1024, 32 * 1024 * 1024);
 	}
 
-	editor->types = (struct lodge_editor_types) {
-		.controller_component_type = lodge_editor_controller_component_type_register(),
-		.controller_system_type = lodge_editor_controller_system_type_register(editor),
-	};
+	//
+	// NOTE(TS): component types must be registered before the system types
+	// that declare access to them.
+	//
+	editor->types.controller_component_type = lodge_editor_controller_component_type_register();
+	editor->types.controller_system_type = lodge_editor_controller_system_type_register(editor);
 
 	//
 	// FIXME(TS): register panels through plugins instead
@@ -386,6 +388,7 @@ static void lodge_editor_update(struct lodge_editor *editor, float dt)
 	if(editor->scene) {
 		lodge_scene_t scene = lodge_assets2_get(editor->scenes, editor->scene);
 		if(scene) {
+			lodge_scene_set_jobs(scene, lodge_plugins_get_jobs(editor->plugins));
 			lodge_scene_update(scene, dt);
 		}
 	}
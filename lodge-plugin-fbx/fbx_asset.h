@@ -2,11 +2,17 @@
 #define _FBX_ASSET_H
 
 #include "math4.h"
+#include "geometry.h"
 #include "lodge_static_mesh.h"
+#include "lodge_mesh.h"
+#include "lodge_mesh_simplify.h"
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 struct fbx;
+struct fbx_mesh;
 
 struct lodge_drawable;
 typedef struct lodge_drawable* lodge_drawable_t;
@@ -17,15 +23,70 @@ typedef struct lodge_shader* lodge_shader_t;
 struct lodge_texture;
 typedef struct lodge_texture* lodge_texture_t;
 
+//
+// `static_mesh.indices` holds every LOD back to back; LOD 0 is the full mesh and there is
+// always at least one.
+//
 struct fbx_asset
 {
 	lodge_drawable_t			drawable;
 	struct lodge_static_mesh	static_mesh;
+	uint32_t					lods_count;
+	struct lodge_mesh_lod		lods[LODGE_MESH_LODS_MAX];
+	struct aabb					bounds;				// Object space.
+	struct sphere				bounding_sphere;	// Object space.
 };
 
 struct fbx_asset				fbx_asset_make(struct fbx *fbx);
 void							fbx_asset_reset(struct fbx_asset *asset);
 
+struct fbx_mesh_desc
+{
+	//
+	// Reorder triangles for the post-transform cache and vertices for fetch locality.
+	// Off keeps the exporter's order (vertices are still welded).
+	//
+	bool						optimize;
+
+	//
+	// LODs to generate, see `lodge_mesh_generate_lods()`. A count of 0 or 1 skips them,
+	// which is the default: simplifying takes seconds on large meshes, so LODs are meant
+	// to be made offline by `lodge-mesh-cooker`.
+	//
+	struct lodge_mesh_lods_desc	lods;
+};
+
+struct fbx_mesh_stats
+{
+	size_t						corners_count;		// Vertices before welding.
+	size_t						vertices_count;
+	size_t						triangles_count;	// In LOD 0.
+	uint32_t					lods_count;
+	float						acmr_before;		// See `lodge_mesh_calc_acmr()`.
+	float						acmr_after;
+};
+
+//
+// `fbx_asset_make()` in two steps: `fbx_mesh_new()` is CPU only and can run on a worker
+// thread, `fbx_asset_make_from_mesh()` does the GPU upload.
+//
+struct fbx_mesh*				fbx_mesh_new(struct fbx *fbx);
+struct fbx_mesh*				fbx_mesh_new_from_desc(struct fbx *fbx, const struct fbx_mesh_desc *desc);
+struct fbx_mesh_stats			fbx_mesh_get_stats(const struct fbx_mesh *mesh);
+void							fbx_mesh_free(struct fbx_mesh *mesh);
+struct fbx_asset				fbx_asset_make_from_mesh(struct fbx_mesh *mesh);
+
+//
+// The LOD to draw at `distance` from the camera (object space, so divide by the scale).
+//
+uint32_t						fbx_asset_select_lod(const struct fbx_asset *asset, float distance);
+
+//
+// Issues the draw call for `lod` only; shader, constants and textures are up to the caller.
+//
+void							fbx_asset_draw_lod(const struct fbx_asset *asset, uint32_t lod);
+void							fbx_asset_draw_lod_instanced(const struct fbx_asset *asset, uint32_t lod, size_t instances);
+
 void							fbx_asset_render(const struct fbx_asset *asset, lodge_shader_t shader, lodge_texture_t tex, struct mvp mvp);
 
 #endif
\ No newline at end of file
@@ -4,6 +4,10 @@
 #include "lodge_plugin_files.h"
 #include "lodge_assets2.h"
 #include "lodge_type_asset.h"
+#include "lodge_thread.h"
+#include "lodge_log.h"
+#include "dynbuf.h"
+#include "strbuf.h"
 
 #include "fbx.h"
 #include "fbx_asset.h"
@@ -12,6 +16,8 @@ enum lodge_assets_fbx_userdata
 {
 	USERDATA_FILES,
 	USERDATA_ASSET_TYPE,
+	USERDATA_JOBS,
+	USERDATA_MESH_DESCS,
 };
 
 enum lodge_plugin_idx
@@ -20,36 +26,137 @@ enum lodge_plugin_idx
 	PLUGIN_IDX_MAX,
 };
 
-static bool lodge_asset_fbx_new_inplace(struct lodge_assets2 *fbx_assets, strview_t name, lodge_asset_t asset, void *fbx_asset_ptr)
+//
+// Per asset overrides of the default `fbx_mesh_desc`. Read from the decode workers.
+//
+struct lodge_fbx_mesh_desc_override
 {
-	struct fbx_asset *fbx_asset = (struct fbx_asset *)fbx_asset_ptr;
+	char							name[256];
+	struct fbx_mesh_desc			desc;
+};
 
-	struct lodge_assets2 *files = lodge_assets2_get_userdata(fbx_assets, USERDATA_FILES);
-	ASSERT(files);
+struct lodge_fbx_mesh_descs
+{
+	lodge_mutex_t					mutex;
 
-	lodge_asset_t file_asset = lodge_assets2_register(files, name);
-	if(!file_asset) {
-		return false;
+	struct
+	{
+		size_t								capacity;
+		size_t								count;
+		struct lodge_fbx_mesh_desc_override	*elements;
+	} overrides;
+};
+
+static struct lodge_fbx_mesh_desc_override* lodge_fbx_mesh_descs_find(struct lodge_fbx_mesh_descs *descs, strview_t name)
+{
+	for(size_t i = 0; i < descs->overrides.count; i++) {
+		struct lodge_fbx_mesh_desc_override *it = &descs->overrides.elements[i];
+		if(strview_equals(strview_wrap(it->name), name)) {
+			return it;
+		}
 	}
+	return NULL;
+}
 
-	lodge_assets2_add_listener(files, file_asset, fbx_assets, asset);
+static struct fbx_mesh_desc lodge_fbx_mesh_descs_get(struct lodge_fbx_mesh_descs *descs, strview_t name)
+{
+	struct fbx_mesh_desc desc = {
+		.optimize = true,
+	};
+
+	lodge_mutex_lock(descs->mutex);
+	const struct lodge_fbx_mesh_desc_override *it = lodge_fbx_mesh_descs_find(descs, name);
+	if(it) {
+		desc = it->desc;
+	}
+	lodge_mutex_unlock(descs->mutex);
 
-	const struct lodge_asset_file *file = lodge_assets2_get(files, file_asset);
+	return desc;
+}
+
+//
+// CPU side of an FBX load, made on a worker thread.
+//
+struct lodge_fbx_decoded
+{
+	struct lodge_vfs_file_view		file;
+	struct fbx_mesh					*mesh;
+};
 
-	if(!file) {
-		return false;
+static void lodge_asset_fbx_decode_free(struct lodge_assets2 *fbx_assets, struct lodge_fbx_decoded *decoded)
+{
+	lodge_vfs_file_view_release(&decoded->file);
+	fbx_mesh_free(decoded->mesh);
+	free(decoded);
+}
+
+static struct lodge_fbx_decoded* lodge_asset_fbx_decode(struct lodge_assets2 *fbx_assets, strview_t name)
+{
+	struct lodge_assets2 *files = lodge_assets2_get_userdata(fbx_assets, USERDATA_FILES);
+	ASSERT_OR(files) { return NULL; }
+
+	struct lodge_fbx_decoded *decoded = (struct lodge_fbx_decoded *)calloc(1, sizeof(struct lodge_fbx_decoded));
+	ASSERT_OR(decoded) { return NULL; }
+
+	if(!lodge_plugin_files_read(files, name, &decoded->file)) {
+		goto fail;
 	}
 
-	struct fbx *fbx = fbx_new(file->data, file->size);
+	//
+	// Decoding already runs on a worker, but large meshes are mostly a few big compressed
+	// arrays; spread those over the pool as well.
+	//
+	struct fbx *fbx = fbx_new_from_desc(decoded->file.data, decoded->file.size, &(struct fbx_desc) {
+		.jobs = lodge_assets2_get_userdata(fbx_assets, USERDATA_JOBS),
+	});
 	if(!fbx) {
-		return false;
+		goto fail;
 	}
 
-	*fbx_asset = fbx_asset_make(fbx);
-
+	const struct fbx_mesh_desc mesh_desc = lodge_fbx_mesh_descs_get(lodge_assets2_get_userdata(fbx_assets, USERDATA_MESH_DESCS), name);
+	decoded->mesh = fbx_mesh_new_from_desc(fbx, &mesh_desc);
 	fbx_free(fbx);
 
-	return true;
+	if(!decoded->mesh) {
+		goto fail;
+	}
+
+	const struct fbx_mesh_stats stats = fbx_mesh_get_stats(decoded->mesh);
+	lodge_logf(LODGE_LOG_LEVEL_INFO, strview("FBX"), strview(STRVIEW_PRINTF_FMT ": %zu triangles, %zu vertices (welded from %zu), ACMR %.3f -> %.3f, %u LODs\n"),
+		STRVIEW_PRINTF_ARG(name),
+		stats.triangles_count,
+		stats.vertices_count,
+		stats.corners_count,
+		stats.acmr_before,
+		stats.acmr_after,
+		stats.lods_count
+	);
+
+	return decoded;
+
+fail:
+	lodge_asset_fbx_decode_free(fbx_assets, decoded);
+	return NULL;
+}
+
+static enum lodge_asset_state lodge_asset_fbx_finalize_inplace(struct lodge_assets2 *fbx_assets, strview_t name, lodge_asset_t asset, struct lodge_fbx_decoded *decoded, struct fbx_asset *fbx_asset)
+{
+	struct lodge_assets2 *files = lodge_assets2_get_userdata(fbx_assets, USERDATA_FILES);
+	ASSERT(files);
+
+	//
+	// Keep the file around (and watched) just like a blocking load would.
+	//
+	lodge_asset_t file_asset = lodge_plugin_files_set(files, name, &decoded->file);
+	if(!file_asset) {
+		return LODGE_ASSET_STATE_FAILED;
+	}
+
+	lodge_assets2_add_listener(files, file_asset, fbx_assets, asset);
+
+	*fbx_asset = fbx_asset_make_from_mesh(decoded->mesh);
+
+	return fbx_asset->drawable ? LODGE_ASSET_STATE_LOADED : LODGE_ASSET_STATE_FAILED;
 }
 
 static void lodge_asset_fbx_free_inplace(struct lodge_assets2 *fbx_assets, strview_t name, lodge_asset_t asset, struct fbx_asset *fbx_asset)
@@ -69,23 +176,45 @@ static struct lodge_ret lodge_plugin_fbx_new_inplace(struct lodge_assets2 *fbx_a
 	lodge_assets2_new_inplace(fbx_assets, &(struct lodge_assets2_desc) {
 		.name = strview("fbx"),
 		.size = sizeof(struct fbx_asset),
-		.new_inplace = &lodge_asset_fbx_new_inplace,
 		.reload_inplace = NULL,
-		.free_inplace = &lodge_asset_fbx_free_inplace
+		.free_inplace = &lodge_asset_fbx_free_inplace,
+		.decode = &lodge_asset_fbx_decode,
+		.finalize_inplace = &lodge_asset_fbx_finalize_inplace,
+		.decode_free = &lodge_asset_fbx_decode_free,
 	});
+	lodge_assets2_set_jobs(fbx_assets, lodge_plugins_get_jobs(plugins));
 
 	lodge_type_t fbx_asset_type = lodge_type_register_asset(strview("fbx"), fbx_assets);
 	ASSERT(fbx_asset_type);
 
 	lodge_assets2_set_userdata(fbx_assets, USERDATA_FILES, files);
 	lodge_assets2_set_userdata(fbx_assets, USERDATA_ASSET_TYPE, fbx_asset_type);
+	lodge_assets2_set_userdata(fbx_assets, USERDATA_JOBS, lodge_plugins_get_jobs(plugins));
+
+	struct lodge_fbx_mesh_descs *mesh_descs = (struct lodge_fbx_mesh_descs *)calloc(1, sizeof(struct lodge_fbx_mesh_descs));
+	ASSERT_OR(mesh_descs) { return lodge_error("Failed to allocate mesh descs"); }
+	mesh_descs->mutex = lodge_mutex_new();
+	lodge_assets2_set_userdata(fbx_assets, USERDATA_MESH_DESCS, mesh_descs);
 
 	return lodge_success();
 }
 
 static void lodge_plugin_fbx_free_inplace(struct lodge_assets2 *fbx_assets)
 {
+	struct lodge_fbx_mesh_descs *mesh_descs = lodge_assets2_get_userdata(fbx_assets, USERDATA_MESH_DESCS);
+
 	lodge_assets2_free_inplace(fbx_assets);
+
+	if(mesh_descs) {
+		dynbuf_free_inplace(dynbuf(mesh_descs->overrides));
+		lodge_mutex_free(mesh_descs->mutex);
+		free(mesh_descs);
+	}
+}
+
+static void lodge_plugin_fbx_update(struct lodge_assets2 *fbx_assets, float dt)
+{
+	lodge_assets2_update(fbx_assets, LODGE_ASSETS2_UPDATE_BUDGET_MS);
 }
 
 struct fbx_types lodge_plugin_fbx_get_types(struct lodge_assets2 *fbx_assets)
@@ -95,6 +224,32 @@ struct fbx_types lodge_plugin_fbx_get_types(struct lodge_assets2 *fbx_assets)
 	};
 }
 
+void lodge_plugin_fbx_set_mesh_desc(struct lodge_assets2 *fbx_assets, strview_t name, const struct fbx_mesh_desc *desc)
+{
+	struct lodge_fbx_mesh_descs *mesh_descs = lodge_assets2_get_userdata(fbx_assets, USERDATA_MESH_DESCS);
+	ASSERT_OR(mesh_descs && desc) { return; }
+
+	struct lodge_fbx_mesh_desc_override tmp = { 0 };
+	ASSERT_OR(name.length < sizeof(tmp.name)) { return; }
+
+	lodge_mutex_lock(mesh_descs->mutex);
+	struct lodge_fbx_mesh_desc_override *it = lodge_fbx_mesh_descs_find(mesh_descs, name);
+	if(!it) {
+		strbuf_wrap_and(tmp.name, strbuf_set, name);
+		it = dynbuf_append(dynbuf(mesh_descs->overrides), &tmp, sizeof(tmp));
+	}
+	it->desc = *desc;
+	lodge_mutex_unlock(mesh_descs->mutex);
+
+	//
+	// Reimport if it is already loaded.
+	//
+	lodge_asset_t asset = lodge_assets2_find_by_name(fbx_assets, name);
+	if(asset) {
+		lodge_assets2_invalidate(fbx_assets, asset);
+	}
+}
+
 LODGE_PLUGIN_IMPL(lodge_plugin_fbx)
 {
 	return (struct lodge_plugin_desc) {
@@ -103,7 +258,7 @@ LODGE_PLUGIN_IMPL(lodge_plugin_fbx)
 		.name = strview("fbx"),
 		.new_inplace = &lodge_plugin_fbx_new_inplace,
 		.free_inplace = &lodge_plugin_fbx_free_inplace,
-		.update = NULL,
+		.update = &lodge_plugin_fbx_update,
 		.render = NULL,
 		.dependencies = {
 			.count = PLUGIN_IDX_MAX,
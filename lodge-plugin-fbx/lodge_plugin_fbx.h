@@ -2,11 +2,13 @@
 #define _LODGE_PLUGIN_FBX_H
 
 #include "lodge_plugin.h"
+#include "strview.h"
 
 struct lodge_type;
 typedef struct lodge_type* lodge_type_t;
 
 struct lodge_assets2;
+struct fbx_mesh_desc;
 
 struct fbx_types
 {
@@ -15,6 +17,13 @@ struct fbx_types
 
 struct fbx_types	lodge_plugin_fbx_get_types(struct lodge_assets2 *fbx_assets);
 
+//
+// Overrides how `name` is imported (the default optimizes it but generates no LODs), and
+// reloads it if it is already loaded. Set it before the first `lodge_assets2_get()` to
+// avoid the extra import.
+//
+void				lodge_plugin_fbx_set_mesh_desc(struct lodge_assets2 *fbx_assets, strview_t name, const struct fbx_mesh_desc *desc);
+
 LODGE_PLUGIN_DECL(lodge_plugin_fbx);
 
 #endif
\ No newline at end of file
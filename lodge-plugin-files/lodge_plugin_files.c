@@ -106,9 +106,8 @@ static bool lodge_asset_file_new_inplace(struct lodge_assets2 *files, strview_t
 		return false;
 	}
 
-	size_t vfs_size = 0;
-	char* vfs_data = lodge_vfs_read_file(vfs, name, &vfs_size);
-	if(!vfs_data) {
+	struct lodge_vfs_file_view view;
+	if(!lodge_vfs_map_file(vfs, name, &view)) {
 		return false;
 	}
 
@@ -116,8 +115,9 @@ static bool lodge_asset_file_new_inplace(struct lodge_assets2 *files, strview_t
 
 	*out = (struct lodge_asset_file) {
 		.name = name,
-		.data = vfs_data,
-		.size = vfs_size,
+		.data = view.data,
+		.size = view.size,
+		.view = view,
 		.vfs_callback = true,
 	};
 
@@ -126,10 +126,9 @@ static bool lodge_asset_file_new_inplace(struct lodge_assets2 *files, strview_t
 
 static int lodge_asset_file_free_inplace(struct lodge_assets2 *files, strview_t name, lodge_asset_t asset, struct lodge_asset_file *data)
 {
-	if(data->data) {
-		free(data->data);
-		data->data = NULL;
-	}
+	lodge_vfs_file_view_release(&data->view);
+	data->data = NULL;
+	data->size = 0;
 
 	struct lodge_vfs *vfs = lodge_assets2_get_userdata(files, USERDATA_VFS);
 	ASSERT_OR(vfs) {
@@ -205,6 +204,49 @@ void lodge_plugin_files_add_file_discovery(struct lodge_assets2 *files, struct l
 	lodge_file_discovery_scan_entry(file_discovery, vfs, strview("/"), callback);
 }
 
+bool lodge_plugin_files_read(struct lodge_assets2 *files, strview_t name, struct lodge_vfs_file_view *view_out)
+{
+	struct lodge_vfs *vfs = lodge_assets2_get_userdata(files, USERDATA_VFS);
+	ASSERT_OR(vfs) { return false; }
+	return lodge_vfs_map_file(vfs, name, view_out);
+}
+
+lodge_asset_t lodge_plugin_files_set(struct lodge_assets2 *files, strview_t name, struct lodge_vfs_file_view *view)
+{
+	lodge_asset_t asset = lodge_assets2_register(files, name);
+	ASSERT_OR(asset) {
+		lodge_vfs_file_view_release(view);
+		return NULL;
+	}
+
+	//
+	// Callers may point into the view (raw images do), so replace what is loaded rather
+	// than keeping it. Listeners of the old data are reloaded.
+	//
+	if(lodge_assets2_get_state(files, asset) == LODGE_ASSET_STATE_LOADED) {
+		lodge_assets2_invalidate(files, asset);
+	}
+
+	struct lodge_vfs *vfs = lodge_assets2_get_userdata(files, USERDATA_VFS);
+	ASSERT_OR(vfs) {
+		lodge_vfs_file_view_release(view);
+		return NULL;
+	}
+
+	lodge_vfs_register_callback(vfs, name, &lodge_asset_file_on_modified, files);
+
+	lodge_assets2_set(files, asset, &(struct lodge_asset_file) {
+		.name = lodge_assets2_get_name(files, asset),
+		.data = view->data,
+		.size = view->size,
+		.view = *view,
+		.vfs_callback = true,
+	});
+	*view = (struct lodge_vfs_file_view) { 0 };
+
+	return asset;
+}
+
 LODGE_PLUGIN_IMPL(lodge_plugin_files)
 {
 	return (struct lodge_plugin_desc) {
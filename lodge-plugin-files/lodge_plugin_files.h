@@ -3,21 +3,36 @@
 
 #include "strview.h"
 #include "lodge_plugin.h"
+#include "lodge_vfs.h"
 
 struct lodge_assets2;
 
+struct lodge_asset;
+typedef struct lodge_asset* lodge_asset_t;
+
 struct lodge_asset_file
 {
-	strview_t				name;
-	char					*data;
-	size_t					size;
-	bool					vfs_callback;
+	strview_t					name;
+	const char					*data;		// `\0` terminated, see `lodge_vfs_map_file()`.
+	size_t						size;
+	struct lodge_vfs_file_view	view;		// Owns `data`.
+	bool						vfs_callback;
 };
 
 typedef bool				(*lodge_file_filter_func_t)(strview_t filename);
 
 void						lodge_plugin_files_add_file_discovery(struct lodge_assets2 *files, struct lodge_assets2 *populate, lodge_file_filter_func_t filter);
 
+//
+// For `lodge_assets2_desc::decode`: `_read` maps a file straight from the VFS and is
+// safe to call from worker threads, also while plugins are still mounting (see
+// `lodge_vfs_map_file()`). `_set` (main thread only) then hands the view over
+// to the file asset, so it is watched for changes without being read again. Takes
+// ownership of `view`.
+//
+bool						lodge_plugin_files_read(struct lodge_assets2 *files, strview_t name, struct lodge_vfs_file_view *view_out);
+lodge_asset_t				lodge_plugin_files_set(struct lodge_assets2 *files, strview_t name, struct lodge_vfs_file_view *view);
+
 LODGE_PLUGIN_DECL(lodge_plugin_files);
 
 #endif
\ No newline at end of file
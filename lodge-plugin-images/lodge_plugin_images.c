@@ -45,24 +45,68 @@ static bool lodge_image_desc_from_json(lodge_json_t object, struct lodge_image_d
 	return true;
 }
 
-static bool lodge_image_asset_new_inplace(struct lodge_assets2 *images, strview_t name, lodge_asset_t image_asset, void *lodge_image_ptr)
+//
+// Raw images are described by a JSON header next to them: `<name>.json`.
+//
+static void lodge_image_raw_header_name(strview_t name, char *dst, size_t dst_size)
 {
-	struct lodge_image *image = (struct lodge_image *)lodge_image_ptr;
+	strbuf_setf(strbuf_make(dst, dst_size), STRVIEW_PRINTF_FMT ".json", STRVIEW_PRINTF_ARG(name));
+}
 
-	struct lodge_assets2 *files = lodge_assets2_get_userdata(images, USERDATA_FILES);
-	ASSERT(files);
+//
+// CPU side of an image load, made on a worker thread.
+//
+struct lodge_image_decoded
+{
+	struct lodge_vfs_file_view		file;
+	struct lodge_vfs_file_view		header_file;			// Only for .raw files.
 
-	lodge_asset_t file_asset = lodge_assets2_register(files, name);
-	if(!file_asset) {
+	struct lodge_image				image;
+	bool							has_image;
+};
+
+static void lodge_image_asset_decode_free(struct lodge_assets2 *images, struct lodge_image_decoded *decoded)
+{
+	if(decoded->has_image) {
+		lodge_image_free(&decoded->image);
+	}
+	lodge_vfs_file_view_release(&decoded->file);
+	lodge_vfs_file_view_release(&decoded->header_file);
+	free(decoded);
+}
+
+static bool lodge_image_decode_raw(struct lodge_image_decoded *decoded)
+{
+	// File views end with \0, which the JSON lib needs.
+	lodge_json_t header = lodge_json_from_string(strview_make(decoded->header_file.data, decoded->header_file.size));
+	ASSERT(header);
+	if(!header) {
 		return false;
 	}
 
-	lodge_assets2_add_listener(files, file_asset, images, image_asset);
-	const struct lodge_asset_file *file = lodge_assets2_get(files, file_asset);
-	if(!file) {
+	struct lodge_image_desc raw_desc = { 0 };
+	if(!lodge_image_desc_from_json(header, &raw_desc)) {
+		lodge_json_free(header);
 		return false;
 	}
 
+	const bool ret = lodge_image_raw_new(&decoded->image, &raw_desc, (const uint8_t*)decoded->file.data, decoded->file.size);
+	lodge_json_free(header);
+	return ret;
+}
+
+static struct lodge_image_decoded* lodge_image_asset_decode(struct lodge_assets2 *images, strview_t name)
+{
+	struct lodge_assets2 *files = lodge_assets2_get_userdata(images, USERDATA_FILES);
+	ASSERT_OR(files) { return NULL; }
+
+	struct lodge_image_decoded *decoded = (struct lodge_image_decoded *)calloc(1, sizeof(struct lodge_image_decoded));
+	ASSERT_OR(decoded) { return NULL; }
+
+	if(!lodge_plugin_files_read(files, name, &decoded->file)) {
+		goto fail;
+	}
+
 	//
 	// If .RAW file: look for a raw header:
 	//
@@ -70,53 +114,73 @@ static bool lodge_image_asset_new_inplace(struct lodge_assets2 *images, strview_
 	//
 	if(strview_ends_with(name, strview(".raw"))) {
 		char header_file_name[512];
-		strbuf_setf(strbuf_wrap(header_file_name), STRVIEW_PRINTF_FMT ".json", STRVIEW_PRINTF_ARG(name));
+		lodge_image_raw_header_name(name, header_file_name, sizeof(header_file_name));
+
+		if(!lodge_plugin_files_read(files, strview_wrap(header_file_name), &decoded->header_file)) {
+			goto fail;
+		}
+
+		decoded->has_image = lodge_image_decode_raw(decoded);
+	} else {
+		struct lodge_ret ret = lodge_image_new(&decoded->image, (const uint8_t*)decoded->file.data, decoded->file.size);
+		decoded->has_image = ret.success;
+	}
+
+	if(!decoded->has_image) {
+		goto fail;
+	}
 
-		lodge_asset_t header_file_asset = lodge_assets2_register(files, strview_wrap(header_file_name));
+	return decoded;
+
+fail:
+	lodge_image_asset_decode_free(images, decoded);
+	return NULL;
+}
+
+static enum lodge_asset_state lodge_image_asset_finalize_inplace(struct lodge_assets2 *images, strview_t name, lodge_asset_t image_asset, struct lodge_image_decoded *decoded, struct lodge_image *image)
+{
+	struct lodge_assets2 *files = lodge_assets2_get_userdata(images, USERDATA_FILES);
+	ASSERT(files);
+
+	//
+	// Hand the file views over to `files`, like a blocking load would have left them. Raw
+	// images point straight into the data file.
+	//
+	// Replacing a file invalidates its listeners. The listeners are added after both files
+	// are set (and removed when the image is freed), so this image is never one of them.
+	//
+	lodge_asset_t header_file_asset = NULL;
+	lodge_asset_t file_asset = lodge_plugin_files_set(files, name, &decoded->file);
+	if(!file_asset) {
+		goto fail;
+	}
+
+	if(decoded->header_file.data) {
+		char header_file_name[512];
+		lodge_image_raw_header_name(name, header_file_name, sizeof(header_file_name));
+
+		header_file_asset = lodge_plugin_files_set(files, strview_wrap(header_file_name), &decoded->header_file);
 		if(!header_file_asset) {
-			return false;
+			goto fail;
 		}
+	}
 
+	lodge_assets2_add_listener(files, file_asset, images, image_asset);
+	if(header_file_asset) {
 		lodge_assets2_add_listener(files, header_file_asset, images, image_asset);
-		const struct lodge_asset_file *header_file = lodge_assets2_get(files, header_file_asset);
-		if(!header_file) {
-			return false;
-		}
+	}
 
-		// Need to end with \0 because of the JSON lib
-		size_t header_file_size = header_file->size + 1; 
-		char* header_file_data = malloc(header_file_size);
-		memcpy(header_file_data, header_file->data, header_file->size);
-		header_file_data[header_file_size - 1] = '\0';
-
-		lodge_json_t header = lodge_json_from_string(strview_make(header_file_data, header_file->size));
-		ASSERT(header);
-		if(!header) {
-			free(header_file_data);
-			return false;
-		}
+	*image = decoded->image;
+	decoded->has_image = false;
 
-		struct lodge_image_desc raw_desc = { 0 };
-		if(!lodge_image_desc_from_json(header, &raw_desc)) {
-			free(header_file_data);
-			lodge_json_free(header);
-			return false;
-		}
+	return LODGE_ASSET_STATE_LOADED;
 
-		if(lodge_image_raw_new(image, &raw_desc, (const uint8_t*)file->data, file->size)) {
-			free(header_file_data);
-			lodge_json_free(header);
-			return true;
-		}
-		free(header_file_data);
-		lodge_json_free(header);
-	} else {
-		struct lodge_ret ret = lodge_image_new(image, (const uint8_t*)file->data, file->size);
-		if(ret.success) {
-			return true;
-		}
+fail:
+	if(decoded->has_image) {
+		lodge_image_free(&decoded->image);
+		decoded->has_image = false;
 	}
-	return false;
+	return LODGE_ASSET_STATE_FAILED;
 }
 
 static void lodge_image_asset_free_inplace(struct lodge_assets2 *images, strview_t name, lodge_asset_t image_asset, struct lodge_image *image)
@@ -125,8 +189,12 @@ static void lodge_image_asset_free_inplace(struct lodge_assets2 *images, strview
 	ASSERT(files);
 
 	lodge_assets2_remove_listener_by_name(files, name, images, image_asset);
-	
-	//lodge_assets2_remove_listener_by_name(files, header_file_name);
+
+	if(strview_ends_with(name, strview(".raw"))) {
+		char header_file_name[512];
+		lodge_image_raw_header_name(name, header_file_name, sizeof(header_file_name));
+		lodge_assets2_remove_listener_by_name(files, strview_wrap(header_file_name), images, image_asset);
+	}
 
 	lodge_image_free(image);
 }
@@ -138,10 +206,13 @@ static struct lodge_ret lodge_images_new_inplace(struct lodge_assets2 *images, s
 	lodge_assets2_new_inplace(images, &(struct lodge_assets2_desc) {
 		.name = strview("images"),
 		.size = sizeof(struct lodge_image),
-		.new_inplace = &lodge_image_asset_new_inplace,
 		.reload_inplace = NULL,
-		.free_inplace = &lodge_image_asset_free_inplace
+		.free_inplace = &lodge_image_asset_free_inplace,
+		.decode = &lodge_image_asset_decode,
+		.finalize_inplace = &lodge_image_asset_finalize_inplace,
+		.decode_free = &lodge_image_asset_decode_free,
 	} );
+	lodge_assets2_set_jobs(images, lodge_plugins_get_jobs(plugins));
 
 	lodge_assets2_set_userdata(images, USERDATA_FILES, files);
 
@@ -153,6 +224,11 @@ static void lodge_images_free_inplace(struct lodge_assets2 *images)
 	lodge_assets2_free_inplace(images);
 }
 
+static void lodge_images_update(struct lodge_assets2 *images, float dt)
+{
+	lodge_assets2_update(images, LODGE_ASSETS2_UPDATE_BUDGET_MS);
+}
+
 LODGE_PLUGIN_IMPL(lodge_plugin_images)
 {
 	return (struct lodge_plugin_desc) {
@@ -161,7 +237,7 @@ LODGE_PLUGIN_IMPL(lodge_plugin_images)
 		.name = strview("images"),
 		.new_inplace = &lodge_images_new_inplace,
 		.free_inplace = &lodge_images_free_inplace,
-		.update = NULL,
+		.update = &lodge_images_update,
 		.render = NULL,
 		.dependencies ={
 			.count = PLUGIN_IDX_MAX,
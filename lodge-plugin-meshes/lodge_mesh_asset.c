@@ -0,0 +1,126 @@
+#include "lodge_mesh_asset.h"
+
+#include "lodge_mesh_file.h"
+
+#include "lodge_gfx.h"
+#include "lodge_shader.h"
+#include "lodge_buffer_object.h"
+#include "lodge_drawable.h"
+#include "lodge_assert.h"
+
+static enum lodge_drawable_attrib_type lodge_mesh_asset_attrib_type(const struct lodge_mesh_file_attrib *attrib)
+{
+	return attrib->format == LODGE_MESH_ATTRIB_FORMAT_FLOAT16 ? LODGE_DRAWABLE_ATTRIB_TYPE_HALF_FLOAT : LODGE_DRAWABLE_ATTRIB_TYPE_FLOAT;
+}
+
+struct lodge_mesh_asset lodge_mesh_asset_make(const struct lodge_mesh_file *file)
+{
+	const struct lodge_mesh_file_header *header = file->header;
+
+	struct lodge_mesh_asset asset = {
+		.indices_count = header->indices_count,
+		.index_type = header->index_size == sizeof(uint16_t) ? LODGE_DRAWABLE_INDEX_TYPE_U16 : LODGE_DRAWABLE_INDEX_TYPE_U32,
+		.bounds = header->bounds,
+		.bounding_sphere = header->bounding_sphere,
+		.lods_count = header->lods_count,
+	};
+
+	for(uint32_t i = 0; i < header->lods_count; i++) {
+		asset.lods[i] = (struct lodge_mesh_lod) {
+			.indices_offset = header->lods[i].indices_offset,
+			.indices_count = header->lods[i].indices_count,
+			.error = header->lods[i].error,
+			.distance = header->lods[i].distance,
+		};
+	}
+
+	asset.vertices = lodge_buffer_object_make_static(file->vertices, file->vertices_size);
+	if(!asset.vertices) {
+		goto fail;
+	}
+
+	asset.indices = lodge_buffer_object_make_static(file->indices, file->indices_size);
+	if(!asset.indices) {
+		goto fail;
+	}
+
+	const strview_t attrib_names[LODGE_MESH_ATTRIB_MAX] = {
+		[LODGE_MESH_ATTRIB_POSITION] = strview_static("vertex"),
+		[LODGE_MESH_ATTRIB_NORMAL] = strview_static("normal"),
+		[LODGE_MESH_ATTRIB_TEX_COORD] = strview_static("tex_coord"),
+	};
+
+	struct lodge_drawable_desc desc = {
+		.indices = asset.indices,
+		.attribs_count = LODGE_MESH_ATTRIB_MAX,
+	};
+	for(uint32_t i = 0; i < LODGE_MESH_ATTRIB_MAX; i++) {
+		desc.attribs[i] = (struct lodge_drawable_attrib) {
+			.name = attrib_names[i],
+			.buffer_object = asset.vertices,
+			.float_count = header->attribs[i].components,
+			.offset = header->attribs[i].offset,
+			.stride = header->vertex_stride,
+			.instanced = 0,
+			.type = lodge_mesh_asset_attrib_type(&header->attribs[i]),
+		};
+	}
+
+	asset.drawable = lodge_drawable_make(desc);
+	if(!asset.drawable) {
+		goto fail;
+	}
+
+	return asset;
+
+fail:
+	ASSERT_FAIL("Failed to make mesh asset");
+	lodge_mesh_asset_reset(&asset);
+	return (struct lodge_mesh_asset) { 0 };
+}
+
+void lodge_mesh_asset_reset(struct lodge_mesh_asset *asset)
+{
+	lodge_drawable_reset(asset->drawable);
+	lodge_buffer_object_reset(asset->vertices);
+	lodge_buffer_object_reset(asset->indices);
+	*asset = (struct lodge_mesh_asset) { 0 };
+}
+
+uint32_t lodge_mesh_asset_select_lod(const struct lodge_mesh_asset *asset, float distance)
+{
+	return lodge_mesh_lod_select(asset->lods, asset->lods_count, distance);
+}
+
+static size_t lodge_mesh_asset_index_size(const struct lodge_mesh_asset *asset)
+{
+	return asset->index_type == LODGE_DRAWABLE_INDEX_TYPE_U16 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+void lodge_mesh_asset_draw_lod(const struct lodge_mesh_asset *asset, uint32_t lod)
+{
+	ASSERT_OR(lod < asset->lods_count) { return; }
+	lodge_drawable_render_indexed_typed(asset->drawable, asset->index_type, asset->lods[lod].indices_count, asset->lods[lod].indices_offset * lodge_mesh_asset_index_size(asset));
+}
+
+void lodge_mesh_asset_draw_lod_instanced(const struct lodge_mesh_asset *asset, uint32_t lod, size_t instances)
+{
+	ASSERT_OR(lod < asset->lods_count) { return; }
+	lodge_drawable_render_indexed_instanced_typed(asset->drawable, asset->index_type, asset->lods[lod].indices_count, asset->lods[lod].indices_offset * lodge_mesh_asset_index_size(asset), instances);
+}
+
+void lodge_mesh_asset_render_lod(const struct lodge_mesh_asset *asset, uint32_t lod, lodge_shader_t shader, lodge_texture_t tex, struct mvp mvp)
+{
+	lodge_gfx_bind_shader(shader);
+	lodge_shader_set_constant_mvp(shader, &mvp);
+
+	// FIXME(TS): material should not be hardcoded, use texture unit instead
+	lodge_gfx_bind_texture_2d(0, tex);
+
+	lodge_mesh_asset_draw_lod(asset, lod);
+}
+
+void lodge_mesh_asset_render(const struct lodge_mesh_asset *asset, lodge_shader_t shader, lodge_texture_t tex, struct mvp mvp)
+{
+	lodge_mesh_asset_render_lod(asset, 0, shader, tex, mvp);
+}
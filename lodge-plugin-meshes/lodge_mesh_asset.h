@@ -0,0 +1,56 @@
+#ifndef _LODGE_MESH_ASSET_H
+#define _LODGE_MESH_ASSET_H
+
+#include "math4.h"
+#include "geometry.h"
+#include "lodge_drawable.h"
+#include "lodge_mesh.h"
+
+#include <stdint.h>
+
+struct lodge_mesh_file;
+
+struct lodge_shader;
+typedef struct lodge_shader* lodge_shader_t;
+
+struct lodge_texture;
+typedef struct lodge_texture* lodge_texture_t;
+
+//
+// A cooked `.lmesh` on the GPU: one interleaved vertex buffer and one index buffer, which
+// holds every LOD back to back.
+//
+struct lodge_mesh_asset
+{
+	lodge_drawable_t				drawable;
+	lodge_buffer_object_t			vertices;
+	lodge_buffer_object_t			indices;
+	uint32_t						indices_count;
+	enum lodge_drawable_index_type	index_type;
+	struct aabb						bounds;
+	struct sphere					bounding_sphere;
+	uint32_t						lods_count;
+	struct lodge_mesh_lod			lods[LODGE_MESH_LODS_MAX];
+};
+
+//
+// Uploads the file blocks as-is; `file` must have passed `lodge_mesh_file_init()`.
+//
+struct lodge_mesh_asset				lodge_mesh_asset_make(const struct lodge_mesh_file *file);
+void								lodge_mesh_asset_reset(struct lodge_mesh_asset *asset);
+
+//
+// The LOD to draw at `distance` from the camera (object space, so divide by the scale).
+//
+uint32_t							lodge_mesh_asset_select_lod(const struct lodge_mesh_asset *asset, float distance);
+
+void								lodge_mesh_asset_render(const struct lodge_mesh_asset *asset, lodge_shader_t shader, lodge_texture_t tex, struct mvp mvp);
+void								lodge_mesh_asset_render_lod(const struct lodge_mesh_asset *asset, uint32_t lod, lodge_shader_t shader, lodge_texture_t tex, struct mvp mvp);
+
+//
+// Issues the draw call for `lod` only; shader, constants and textures are up to the caller.
+//
+void								lodge_mesh_asset_draw_lod(const struct lodge_mesh_asset *asset, uint32_t lod);
+void								lodge_mesh_asset_draw_lod_instanced(const struct lodge_mesh_asset *asset, uint32_t lod, size_t instances);
+
+#endif
@@ -0,0 +1,158 @@
+#include "lodge_plugin_meshes.h"
+
+#include "lodge_plugins.h"
+#include "lodge_plugin_files.h"
+#include "lodge_assets2.h"
+#include "lodge_type_asset.h"
+#include "lodge_log.h"
+
+#include "lodge_mesh_file.h"
+#include "lodge_mesh_asset.h"
+
+enum lodge_assets_meshes_userdata
+{
+	USERDATA_FILES,
+	USERDATA_ASSET_TYPE,
+};
+
+enum lodge_plugin_idx
+{
+	PLUGIN_IDX_FILES,
+	PLUGIN_IDX_MAX,
+};
+
+//
+// A cooked mesh needs no decoding, so this only maps the file and checks the header on
+// the worker; the mapping is uploaded as-is on finalize.
+//
+struct lodge_mesh_decoded
+{
+	struct lodge_vfs_file_view		file;
+	struct lodge_mesh_file			mesh_file;
+};
+
+static void lodge_asset_mesh_decode_free(struct lodge_assets2 *meshes, struct lodge_mesh_decoded *decoded)
+{
+	lodge_vfs_file_view_release(&decoded->file);
+	free(decoded);
+}
+
+static struct lodge_mesh_decoded* lodge_asset_mesh_decode(struct lodge_assets2 *meshes, strview_t name)
+{
+	struct lodge_assets2 *files = lodge_assets2_get_userdata(meshes, USERDATA_FILES);
+	ASSERT_OR(files) { return NULL; }
+
+	struct lodge_mesh_decoded *decoded = (struct lodge_mesh_decoded *)calloc(1, sizeof(struct lodge_mesh_decoded));
+	ASSERT_OR(decoded) { return NULL; }
+
+	if(!lodge_plugin_files_read(files, name, &decoded->file)) {
+		goto fail;
+	}
+
+	if(!lodge_mesh_file_init(&decoded->mesh_file, decoded->file.data, decoded->file.size)) {
+		errorf("Meshes", "Invalid mesh file: `" STRVIEW_PRINTF_FMT "`\n", STRVIEW_PRINTF_ARG(name));
+		goto fail;
+	}
+
+	return decoded;
+
+fail:
+	lodge_asset_mesh_decode_free(meshes, decoded);
+	return NULL;
+}
+
+static enum lodge_asset_state lodge_asset_mesh_finalize_inplace(struct lodge_assets2 *meshes, strview_t name, lodge_asset_t asset, struct lodge_mesh_decoded *decoded, struct lodge_mesh_asset *mesh_asset)
+{
+	struct lodge_assets2 *files = lodge_assets2_get_userdata(meshes, USERDATA_FILES);
+	ASSERT(files);
+
+	*mesh_asset = lodge_mesh_asset_make(&decoded->mesh_file);
+	if(!mesh_asset->drawable) {
+		return LODGE_ASSET_STATE_FAILED;
+	}
+
+	//
+	// Keep the file watched so recooking reloads the mesh.
+	//
+	lodge_asset_t file_asset = lodge_plugin_files_set(files, name, &decoded->file);
+	if(!file_asset) {
+		lodge_mesh_asset_reset(mesh_asset);
+		return LODGE_ASSET_STATE_FAILED;
+	}
+
+	lodge_assets2_add_listener(files, file_asset, meshes, asset);
+
+	return LODGE_ASSET_STATE_LOADED;
+}
+
+static void lodge_asset_mesh_free_inplace(struct lodge_assets2 *meshes, strview_t name, lodge_asset_t asset, struct lodge_mesh_asset *mesh_asset)
+{
+	struct lodge_assets2 *files = lodge_assets2_get_userdata(meshes, USERDATA_FILES);
+	ASSERT(files);
+
+	lodge_assets2_remove_listener_by_name(files, name, meshes, asset);
+
+	lodge_mesh_asset_reset(mesh_asset);
+}
+
+static struct lodge_ret lodge_plugin_meshes_new_inplace(struct lodge_assets2 *meshes, struct lodge_plugins *plugins, const struct lodge_argv *args, void **dependencies)
+{
+	struct lodge_assets2 *files = dependencies[PLUGIN_IDX_FILES];
+
+	lodge_assets2_new_inplace(meshes, &(struct lodge_assets2_desc) {
+		.name = strview("meshes"),
+		.size = sizeof(struct lodge_mesh_asset),
+		.reload_inplace = NULL,
+		.free_inplace = &lodge_asset_mesh_free_inplace,
+		.decode = &lodge_asset_mesh_decode,
+		.finalize_inplace = &lodge_asset_mesh_finalize_inplace,
+		.decode_free = &lodge_asset_mesh_decode_free,
+	});
+	lodge_assets2_set_jobs(meshes, lodge_plugins_get_jobs(plugins));
+
+	lodge_type_t mesh_asset_type = lodge_type_register_asset(strview("mesh"), meshes);
+	ASSERT(mesh_asset_type);
+
+	lodge_assets2_set_userdata(meshes, USERDATA_FILES, files);
+	lodge_assets2_set_userdata(meshes, USERDATA_ASSET_TYPE, mesh_asset_type);
+
+	return lodge_success();
+}
+
+static void lodge_plugin_meshes_free_inplace(struct lodge_assets2 *meshes)
+{
+	lodge_assets2_free_inplace(meshes);
+}
+
+static void lodge_plugin_meshes_update(struct lodge_assets2 *meshes, float dt)
+{
+	lodge_assets2_update(meshes, LODGE_ASSETS2_UPDATE_BUDGET_MS);
+}
+
+struct mesh_types lodge_plugin_meshes_get_types(struct lodge_assets2 *meshes)
+{
+	return (struct mesh_types) {
+		.mesh_asset_type = lodge_assets2_get_userdata(meshes, USERDATA_ASSET_TYPE),
+	};
+}
+
+LODGE_PLUGIN_IMPL(lodge_plugin_meshes)
+{
+	return (struct lodge_plugin_desc) {
+		.version = LODGE_PLUGIN_VERSION,
+		.size = lodge_assets2_sizeof(),
+		.name = strview("meshes"),
+		.new_inplace = &lodge_plugin_meshes_new_inplace,
+		.free_inplace = &lodge_plugin_meshes_free_inplace,
+		.update = &lodge_plugin_meshes_update,
+		.render = NULL,
+		.dependencies = {
+			.count = PLUGIN_IDX_MAX,
+			.elements = {
+				[PLUGIN_IDX_FILES] = {
+					.name = strview("files"),
+				}
+			}
+		}
+	};
+}
@@ -0,0 +1,20 @@
+#ifndef _LODGE_PLUGIN_MESHES_H
+#define _LODGE_PLUGIN_MESHES_H
+
+#include "lodge_plugin.h"
+
+struct lodge_type;
+typedef struct lodge_type* lodge_type_t;
+
+struct lodge_assets2;
+
+struct mesh_types
+{
+	lodge_type_t	mesh_asset_type;
+};
+
+struct mesh_types	lodge_plugin_meshes_get_types(struct lodge_assets2 *meshes);
+
+LODGE_PLUGIN_DECL(lodge_plugin_meshes);
+
+#endif
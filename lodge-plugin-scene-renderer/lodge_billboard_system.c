@@ -217,7 +217,7 @@ static void lodge_billboard_system_update(struct lodge_billboard_system *system,
 	}
 
 	lodge_scene_components_foreach(scene, struct lodge_billboard_component*, billboard, system->billboard_component_type) {
-		lodge_texture_t *texture = lodge_assets2_get(textures, billboard->texture_asset);
+		lodge_texture_t *texture = lodge_assets2_get_async(textures, billboard->texture_asset);
 		if(!texture) {
 			continue;
 		}
@@ -257,6 +257,11 @@ lodge_system_type_t lodge_billboard_system_type_register(struct lodge_scene_rend
 					.flags = LODGE_PROPERTY_FLAG_NONE,
 				},
 			}
-		}
+		},
+		.flags = LODGE_SYSTEM_TYPE_FLAG_CONCURRENT | LODGE_SYSTEM_TYPE_FLAG_MAIN_THREAD,
+		.reads = {
+			.count = 2,
+			.elements = { lodge_component_types_find(strview("billboard")), LODGE_COMPONENT_TYPE_TRANSFORM },
+		},
 	});
 }
@@ -0,0 +1,308 @@
+#include "lodge_light_clusters.h"
+
+#include "lodge_assert.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+static void* lodge_light_clusters_reserve(void *ptr, size_t *capacity, size_t count, size_t element_size)
+{
+	if(count <= *capacity) {
+		return ptr;
+	}
+
+	size_t new_capacity = *capacity ? *capacity : 1024;
+	while(new_capacity < count) {
+		new_capacity *= 2;
+	}
+
+	void *new_ptr = realloc(ptr, new_capacity * element_size);
+	ASSERT_OR(new_ptr) {
+		return ptr;
+	}
+
+	*capacity = new_capacity;
+	return new_ptr;
+}
+
+static uint32_t lodge_light_clusters_clamp(float value, uint32_t count)
+{
+	if(!(value > 0.0f)) {
+		return 0;
+	}
+	return value < (float)count ? (uint32_t)value : count - 1;
+}
+
+void lodge_light_clusters_new_inplace(struct lodge_light_clusters *clusters, struct lodge_light_clusters_desc desc)
+{
+	ASSERT(desc.tiles_x > 0 && desc.tiles_y > 0 && desc.slices > 0);
+
+	memset(clusters, 0, sizeof(struct lodge_light_clusters));
+
+	clusters->params.tiles_x = desc.tiles_x;
+	clusters->params.tiles_y = desc.tiles_y;
+	clusters->params.slices = desc.slices;
+
+	clusters->clusters_count = (size_t)desc.tiles_x * desc.tiles_y * desc.slices;
+	clusters->clusters = calloc(clusters->clusters_count, sizeof(struct lodge_light_cluster));
+	clusters->bounds_min = calloc(clusters->clusters_count, sizeof(vec3));
+	clusters->bounds_max = calloc(clusters->clusters_count, sizeof(vec3));
+	clusters->spheres = calloc(clusters->clusters_count, sizeof(vec4));
+	clusters->slice_depths = calloc(desc.slices + 1, sizeof(float));
+}
+
+void lodge_light_clusters_free_inplace(struct lodge_light_clusters *clusters)
+{
+	free(clusters->clusters);
+	free(clusters->bounds_min);
+	free(clusters->bounds_max);
+	free(clusters->spheres);
+	free(clusters->slice_depths);
+	free(clusters->indices);
+	free(clusters->pairs);
+	memset(clusters, 0, sizeof(struct lodge_light_clusters));
+}
+
+//
+// Depth slices are exponential, so clusters stay roughly cube shaped from near to far.
+//
+static float lodge_light_clusters_slice_depth(const struct lodge_light_clusters_params *params, uint32_t slice)
+{
+	return params->z_near * powf(params->z_far / params->z_near, (float)slice / (float)params->slices);
+}
+
+static void lodge_light_clusters_set_projection(struct lodge_light_clusters *clusters, const mat4 *projection)
+{
+	struct lodge_light_clusters_params *params = &clusters->params;
+
+	clusters->projection = *projection;
+
+	//
+	// From `mat4_perspective()`: m[10] = (f + n) / (n - f), m[14] = 2fn / (n - f).
+	//
+	params->z_near = projection->m[14] / (projection->m[10] - 1.0f);
+	params->z_far = projection->m[14] / (projection->m[10] + 1.0f);
+
+	const float log_range = logf(params->z_far / params->z_near);
+	params->slice_scale = (float)params->slices / log_range;
+	params->slice_bias = -(float)params->slices * logf(params->z_near) / log_range;
+
+	const float scale_x = projection->m[0];
+	const float scale_y = projection->m[5];
+
+	for(uint32_t slice = 0; slice <= params->slices; slice++) {
+		clusters->slice_depths[slice] = lodge_light_clusters_slice_depth(params, slice);
+	}
+
+	for(uint32_t slice = 0; slice < params->slices; slice++) {
+		const float depth_near = clusters->slice_depths[slice];
+		const float depth_far = clusters->slice_depths[slice + 1];
+
+		for(uint32_t y = 0; y < params->tiles_y; y++) {
+			const float ndc_y0 = -1.0f + 2.0f * (float)y / (float)params->tiles_y;
+			const float ndc_y1 = -1.0f + 2.0f * (float)(y + 1) / (float)params->tiles_y;
+
+			for(uint32_t x = 0; x < params->tiles_x; x++) {
+				const float ndc_x0 = -1.0f + 2.0f * (float)x / (float)params->tiles_x;
+				const float ndc_x1 = -1.0f + 2.0f * (float)(x + 1) / (float)params->tiles_x;
+
+				const size_t index = x + (size_t)y * params->tiles_x + (size_t)slice * params->tiles_x * params->tiles_y;
+
+				clusters->bounds_min[index] = vec3_make(
+					min(ndc_x0 * depth_near, ndc_x0 * depth_far) / scale_x,
+					min(ndc_y0 * depth_near, ndc_y0 * depth_far) / scale_y,
+					-depth_far
+				);
+				clusters->bounds_max[index] = vec3_make(
+					max(ndc_x1 * depth_near, ndc_x1 * depth_far) / scale_x,
+					max(ndc_y1 * depth_near, ndc_y1 * depth_far) / scale_y,
+					-depth_near
+				);
+				clusters->spheres[index] = vec4_make_from_vec3(
+					vec3_mult_scalar(vec3_add(clusters->bounds_min[index], clusters->bounds_max[index]), 0.5f),
+					0.5f * vec3_distance(clusters->bounds_min[index], clusters->bounds_max[index])
+				);
+			}
+		}
+	}
+}
+
+static bool lodge_light_clusters_sphere_vs_bounds(vec3 center, float radius, vec3 bounds_min, vec3 bounds_max)
+{
+	const float dx = max(bounds_min.x - center.x, max(0.0f, center.x - bounds_max.x));
+	const float dy = max(bounds_min.y - center.y, max(0.0f, center.y - bounds_max.y));
+	const float dz = max(bounds_min.z - center.z, max(0.0f, center.z - bounds_max.z));
+	return dx * dx + dy * dy + dz * dz <= radius * radius;
+}
+
+//
+// Against the bounding sphere of a cluster (Wronski, "Cull that cone!").
+//
+static bool lodge_light_clusters_cone_vs_sphere(vec3 origin, vec3 direction, float range, float cos_angle, float sin_angle, vec4 sphere)
+{
+	const float radius = sphere.w;
+	const vec3 v = vec3_sub(vec3_make(xyz_of(sphere)), origin);
+	const float v_length_sq = vec3_dot(v, v);
+	const float v1_length = vec3_dot(v, direction);
+	const float closest = cos_angle * sqrtf(max(v_length_sq - v1_length * v1_length, 0.0f)) - v1_length * sin_angle;
+
+	return !(closest > radius || v1_length > radius + range || v1_length < -radius);
+}
+
+static void lodge_light_clusters_assign(struct lodge_light_clusters *clusters, const mat4 *view, const struct lodge_light_clusters_light *light, uint32_t light_index)
+{
+	const struct lodge_light_clusters_params *params = &clusters->params;
+	const float *v = view->m;
+	const float r = light->range;
+
+	if(!(r > 0.0f)) {
+		return;
+	}
+
+	const vec3 p = vec3_make(
+		v[0] * light->pos.x + v[4] * light->pos.y + v[8] * light->pos.z + v[12],
+		v[1] * light->pos.x + v[5] * light->pos.y + v[9] * light->pos.z + v[13],
+		v[2] * light->pos.x + v[6] * light->pos.y + v[10] * light->pos.z + v[14]
+	);
+	const float depth = -p.z;
+
+	if(depth + r < params->z_near || depth - r > params->z_far) {
+		return;
+	}
+
+	//
+	// Slices covered by the depth range of the sphere.
+	//
+	const uint32_t slice_min = depth - r <= params->z_near ? 0 : lodge_light_clusters_clamp(logf(depth - r) * params->slice_scale + params->slice_bias, params->slices);
+	const uint32_t slice_max = depth + r >= params->z_far ? params->slices - 1 : lodge_light_clusters_clamp(logf(depth + r) * params->slice_scale + params->slice_bias, params->slices);
+
+	//
+	// Cones wider than a hemisphere are treated as point lights.
+	//
+	const bool cone = light->cone_angle > 0.0f && light->cone_angle < (float)M_PI * 0.5f;
+	vec3 cone_direction = vec3_zero();
+	if(cone) {
+		const vec3 d = light->cone_direction;
+		cone_direction = vec3_norm(vec3_make(
+			v[0] * d.x + v[4] * d.y + v[8] * d.z,
+			v[1] * d.x + v[5] * d.y + v[9] * d.z,
+			v[2] * d.x + v[6] * d.y + v[10] * d.z
+		));
+	}
+	const float cos_angle = cosf(light->cone_angle);
+	const float sin_angle = sinf(light->cone_angle);
+
+	const float scale_x = clusters->projection.m[0];
+	const float scale_y = clusters->projection.m[5];
+
+	for(uint32_t slice = slice_min; slice <= slice_max; slice++) {
+		//
+		// Tiles covered by the part of the sphere within this slice, projected from its bounding box.
+		//
+		const float depth_near = max(clusters->slice_depths[slice], depth - r);
+		const float depth_far = min(clusters->slice_depths[slice + 1], depth + r);
+		const float dz = depth < depth_near ? depth_near - depth : (depth > depth_far ? depth - depth_far : 0.0f);
+		const float rr_sq = r * r - dz * dz;
+		if(depth_near > depth_far || rr_sq < 0.0f) {
+			continue;
+		}
+		const float rr = sqrtf(rr_sq);
+
+		const float ndc_x_min = scale_x * min((p.x - rr) / depth_near, (p.x - rr) / depth_far);
+		const float ndc_x_max = scale_x * max((p.x + rr) / depth_near, (p.x + rr) / depth_far);
+		const float ndc_y_min = scale_y * min((p.y - rr) / depth_near, (p.y - rr) / depth_far);
+		const float ndc_y_max = scale_y * max((p.y + rr) / depth_near, (p.y + rr) / depth_far);
+
+		if(ndc_x_max < -1.0f || ndc_x_min > 1.0f || ndc_y_max < -1.0f || ndc_y_min > 1.0f) {
+			continue;
+		}
+
+		const uint32_t x_min = lodge_light_clusters_clamp((ndc_x_min * 0.5f + 0.5f) * params->tiles_x, params->tiles_x);
+		const uint32_t x_max = lodge_light_clusters_clamp((ndc_x_max * 0.5f + 0.5f) * params->tiles_x, params->tiles_x);
+		const uint32_t y_min = lodge_light_clusters_clamp((ndc_y_min * 0.5f + 0.5f) * params->tiles_y, params->tiles_y);
+		const uint32_t y_max = lodge_light_clusters_clamp((ndc_y_max * 0.5f + 0.5f) * params->tiles_y, params->tiles_y);
+
+		const size_t pairs_max = clusters->pairs_count + 2 * (size_t)(x_max - x_min + 1) * (y_max - y_min + 1);
+		clusters->pairs = lodge_light_clusters_reserve(clusters->pairs, &clusters->pairs_capacity, pairs_max, sizeof(uint32_t));
+		ASSERT_OR(clusters->pairs_capacity >= pairs_max) {
+			return;
+		}
+
+		for(uint32_t y = y_min; y <= y_max; y++) {
+			const size_t row = (size_t)y * params->tiles_x + (size_t)slice * params->tiles_x * params->tiles_y;
+
+			for(uint32_t x = x_min; x <= x_max; x++) {
+				const size_t index = row + x;
+
+				if(!lodge_light_clusters_sphere_vs_bounds(p, r, clusters->bounds_min[index], clusters->bounds_max[index])) {
+					continue;
+				}
+				if(cone && !lodge_light_clusters_cone_vs_sphere(p, cone_direction, r, cos_angle, sin_angle, clusters->spheres[index])) {
+					continue;
+				}
+
+				clusters->pairs[clusters->pairs_count++] = (uint32_t)index;
+				clusters->pairs[clusters->pairs_count++] = light_index;
+			}
+		}
+	}
+}
+
+void lodge_light_clusters_update(struct lodge_light_clusters *clusters, const mat4 *view, const mat4 *projection, const struct lodge_light_clusters_light *lights, size_t lights_count, uint32_t index_base)
+{
+	if(memcmp(&clusters->projection, projection, sizeof(mat4)) != 0) {
+		lodge_light_clusters_set_projection(clusters, projection);
+	}
+
+	clusters->pairs_count = 0;
+	for(size_t i = 0; i < lights_count; i++) {
+		lodge_light_clusters_assign(clusters, view, &lights[i], index_base + (uint32_t)i);
+	}
+
+	//
+	// Counting sort by cluster; each list stays in light order.
+	//
+	const size_t count = clusters->pairs_count / 2;
+
+	for(size_t i = 0; i < clusters->clusters_count; i++) {
+		clusters->clusters[i].count = 0;
+	}
+	for(size_t i = 0; i < count; i++) {
+		clusters->clusters[clusters->pairs[i * 2]].count++;
+	}
+
+	uint32_t offset = 0;
+	for(size_t i = 0; i < clusters->clusters_count; i++) {
+		clusters->clusters[i].offset = offset;
+		offset += clusters->clusters[i].count;
+		clusters->clusters[i].count = 0;
+	}
+
+	clusters->indices = lodge_light_clusters_reserve(clusters->indices, &clusters->indices_capacity, count, sizeof(uint32_t));
+	ASSERT_OR(clusters->indices_capacity >= count) {
+		clusters->indices_count = 0;
+		memset(clusters->clusters, 0, clusters->clusters_count * sizeof(struct lodge_light_cluster));
+		return;
+	}
+
+	for(size_t i = 0; i < count; i++) {
+		struct lodge_light_cluster *cluster = &clusters->clusters[clusters->pairs[i * 2]];
+		clusters->indices[cluster->offset + cluster->count++] = clusters->pairs[i * 2 + 1];
+	}
+	clusters->indices_count = count;
+}
+
+float lodge_light_clusters_range(vec3 intensities, float attenuation, float threshold)
+{
+	const float intensity = max(intensities.x, max(intensities.y, intensities.z));
+
+	if(!(attenuation > 0.0f)) {
+		return INFINITY;
+	}
+	if(intensity <= threshold) {
+		return 0.0f;
+	}
+	return sqrtf((intensity / threshold - 1.0f) / attenuation);
+}
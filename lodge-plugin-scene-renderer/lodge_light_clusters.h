@@ -0,0 +1,104 @@
+#ifndef _LODGE_LIGHT_CLUSTERS_H
+#define _LODGE_LIGHT_CLUSTERS_H
+
+#include "math4.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+//
+// Clustered light assignment (Olsson et al., "Clustered Deferred and Forward Shading").
+//
+// The view frustum is split in screen tiles and exponential depth slices, and every cluster
+// gets a compact list of the lights that can reach it, so shading only loops over those.
+//
+// CPU only, nothing here touches the GPU.
+//
+struct lodge_light_clusters_desc
+{
+	uint32_t						tiles_x;
+	uint32_t						tiles_y;
+	uint32_t						slices;
+};
+
+//
+// A light to assign, in world space. `range` is where it no longer contributes, see
+// `lodge_light_clusters_range()`; spot lights also have a cone.
+//
+struct lodge_light_clusters_light
+{
+	vec3							pos;
+	float							range;
+	vec3							cone_direction;
+	float							cone_angle;			// Half angle, radians; 0 means no cone.
+};
+
+//
+// Layout of the header the shaders read, std430.
+//
+struct lodge_light_clusters_params
+{
+	uint32_t						tiles_x;
+	uint32_t						tiles_y;
+	uint32_t						slices;
+	uint32_t						_pad0;
+	float							slice_scale;		// slice = log(depth) * slice_scale + slice_bias
+	float							slice_bias;
+	float							z_near;
+	float							z_far;
+};
+
+struct lodge_light_cluster
+{
+	uint32_t						offset;				// Into `indices`.
+	uint32_t						count;
+};
+
+struct lodge_light_clusters
+{
+	struct lodge_light_clusters_params params;
+
+	//
+	// View space bounds, one per cluster, and where each slice begins; rebuilt when the
+	// projection changes.
+	//
+	mat4							projection;
+	vec3							*bounds_min;
+	vec3							*bounds_max;
+	vec4							*spheres;
+	float							*slice_depths;
+
+	//
+	// Indexed `x + y * tiles_x + slice * tiles_x * tiles_y`, with `y` going up.
+	//
+	struct lodge_light_cluster		*clusters;
+	size_t							clusters_count;
+
+	uint32_t						*indices;
+	size_t							indices_count;
+	size_t							indices_capacity;
+
+	//
+	// {cluster, light} pairs, before they are sorted into `indices`.
+	//
+	uint32_t						*pairs;
+	size_t							pairs_count;
+	size_t							pairs_capacity;
+};
+
+void								lodge_light_clusters_new_inplace(struct lodge_light_clusters *clusters, struct lodge_light_clusters_desc desc);
+void								lodge_light_clusters_free_inplace(struct lodge_light_clusters *clusters);
+
+//
+// Assigns `lights` for the camera given by `view` and a perspective `projection`. Light indices
+// written to `indices` are `index_base` plus the index in `lights`.
+//
+void								lodge_light_clusters_update(struct lodge_light_clusters *clusters, const mat4 *view, const mat4 *projection, const struct lodge_light_clusters_light *lights, size_t lights_count, uint32_t index_base);
+
+//
+// Distance where `1 / (1 + attenuation * d^2)` falls below `threshold` of the brightest channel
+// in `intensities`; INFINITY without attenuation.
+//
+float								lodge_light_clusters_range(vec3 intensities, float attenuation, float threshold);
+
+#endif
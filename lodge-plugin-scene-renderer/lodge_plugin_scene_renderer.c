@@ -2,8 +2,10 @@
 
 #include "math4.h"
 #include "membuf.h"
+#include "dynbuf.h"
 #include "fbx_asset.h"
 #include "gruvbox.h"
+#include "frustum.h"
 
 #include "lodge_plugin.h"
 #include "lodge_plugins.h"
@@ -30,8 +32,10 @@
 #include "lodge_post_process.h"
 #include "lodge_sampler.h"
 #include "lodge_shadow_map.h"
+#include "lodge_light_clusters.h"
 #include "lodge_texture.h"
 #include "lodge_buffer_object.h"
+#include "lodge_buffer_ring.h"
 #include "lodge_debug_draw.h"
 #include "lodge_shader.h"
 
@@ -42,6 +46,7 @@
 #include "lodge_editor_selection_system.h"
 
 #include <stdio.h>
+#include <string.h>
 #define alignas _Alignas
 
 enum lodge_plugin_idx
@@ -82,16 +87,46 @@ struct lodge_distance_fog
 	alignas(4) float					density;
 };
 
-struct lodge_transform_uniform
+//
+// Per-instance data for shaders that opt into instancing, by declaring:
+//
+//		layout(location = 3) in mat4 instance_model;
+//		layout(location = 7) in vec2 instance_entity;	// { entity_id, entity_selected }
+//
+// Other shaders keep reading `model` from the constant buffer at binding 1, and the
+// `entity_id` and `entity_selected` constants, one draw call per mesh.
+//
+#define LODGE_STATIC_MESH_INSTANCE_ATTRIB_MODEL		3
+#define LODGE_STATIC_MESH_INSTANCE_ATTRIB_ENTITY	7
+
+struct lodge_static_mesh_instance
 {
-	alignas(16) mat4					model;
+	mat4								model;
+	vec2								entity;
+	vec2								_pad0;
+};
 
-	//
-	// UBOs need to be aligned to at least `UNIFORM_BUFFER_OFFSET_ALIGNMENT`
-	//
-	mat4								_pad0;
-	mat4								_pad1;
-	mat4								_pad2;
+//
+// Shadow casters of one cascade, last frame. Cascades whose static casters were reused from
+// the cache draw nothing.
+//
+struct lodge_static_meshes_cascade
+{
+	uint32_t							drawn;
+	uint32_t							culled;
+	uint32_t							draw_calls;
+	uint32_t							state_changes;
+};
+
+//
+// Maps pointers to small ids, in the order they are first seen; NULL is always 0.
+//
+struct lodge_static_meshes_ids
+{
+	const void							**keys;
+	uint32_t							*values;
+	size_t								capacity;		// Power of two.
+	uint32_t							count;
 };
 
 struct lodge_static_meshes
@@ -100,14 +135,64 @@ struct lodge_static_meshes
 	struct lodge_assets2				*shaders;
 	struct lodge_assets2				*textures;
 
+	struct lodge_scene_query			query;
+
+	//
+	// One element per mesh drawn this frame, in query order; grown by `lodge_static_meshes_reserve()`.
+	//
 	size_t								count;
-	struct lodge_static_mesh_component	*components[1024];
-	struct lodge_transform_uniform		transforms[1024];
-	const struct fbx_asset				*meshes[1024];
-	lodge_entity_t						ids[1024];
-	float								selected[1024];
+	size_t								capacity;
+	struct lodge_static_mesh_component	**components;
+	mat4								*models;
+	const struct fbx_asset				**meshes;
+	uint32_t							*lods;
+	lodge_entity_t						*ids;
+	float								*selected;
+
+	//
+	// Resolved in `lodge_static_meshes_update()`; `textures_resolved` is NULL until loaded.
+	//
+	lodge_shader_t						*shaders_resolved;
+	lodge_texture_t						*textures_resolved;
+	bool								*shader_instanced;
+	bool								*shader_ids_instanced;	// By `shader_ids` value.
+
+	//
+	// Draw order, one key per mesh, radix sorted:
+	//
+	//		63..50 shader | 49..37 texture | 36..23 mesh | 22..20 lod | 19..0 index
+	//
+	// Ids past what their bits hold share the last one, which costs batching but not correctness:
+	// runs are split on the actual state.
+	//
+	uint64_t							*keys;
+	uint64_t							*keys_scratch;
+	struct lodge_static_meshes_ids		shader_ids;
+	struct lodge_static_meshes_ids		texture_ids;
+	struct lodge_static_meshes_ids		mesh_ids;
 
-	lodge_buffer_object_t				transforms_buffer;
+	//
+	// World space bounds of `meshes`, one array per component for `frustum_planes_cull_aabbs()`.
+	// `visible` is rewritten by every pass.
+	//
+	float								*bounds_center[3];
+	float								*bounds_extent[3];
+	uint8_t								*visible;
+
+	//
+	// Everything uploaded per frame: `model` for the shaders that are not instanced (at
+	// `transforms_offsets`, aligned for binding), then each pass' instances.
+	//
+	bool								instance;
+	struct lodge_buffer_ring			buffer;
+	size_t								*transforms_offsets;
+
+	bool								cull;
+	uint32_t							drawn;				// Last frame, camera pass.
+	uint32_t							culled;
+	uint32_t							draw_calls;
+	uint32_t							state_changes;
+	struct lodge_static_meshes_cascade	shadow_cascades[LODGE_SHADOW_CASCADE_SPLITS_COUNT];
 };
 
 struct lodge_hdr_resolve
@@ -127,8 +212,50 @@ struct lodge_light
 
 struct lodge_lights
 {
-	alignas(16) struct lodge_light		elements[128];
-	alignas(4) int32_t					count;
+	size_t								count;
+	size_t								capacity;
+	struct lodge_light					*elements;
+};
+
+struct lodge_lights_clustered
+{
+	size_t								count;
+	size_t								capacity;
+	struct lodge_light_clusters_light	*elements;
+};
+
+//
+// The lights are bound as a storage buffer, at binding 4, directional lights first:
+//
+//		layout(std430, binding = 4) readonly buffer lights_buffer
+//		{
+//			int		lights_count;
+//			int		lights_directional_count;
+//			light	lights[];
+//		};
+//
+// Point lights are only shaded in the clusters they reach. The cluster of a fragment is
+// found from its tile and view space depth, and its lights listed in `light_indices`:
+//
+//		layout(std430, binding = 5) readonly buffer light_clusters_buffer
+//		{
+//			uvec4	light_clusters_tiles;		// x, y, slices, unused
+//			vec4	light_clusters_slicing;		// scale, bias, z_near, z_far
+//			uvec2	light_clusters[];			// offset, count
+//		};
+//
+//		layout(std430, binding = 6) readonly buffer light_indices_buffer
+//		{
+//			uint	light_indices[];
+//		};
+//
+//		uvec3 tile = uvec3(gl_FragCoord.xy / resolution * light_clusters_tiles.xy,
+//			uint(max(log(-view_pos.z) * light_clusters_slicing.x + light_clusters_slicing.y, 0.0)));
+//
+struct lodge_lights_header
+{
+	alignas(16) int32_t					count;
+	int32_t								directional_count;
 };
 
 struct lodge_hdr
@@ -177,7 +304,17 @@ struct lodge_scene_render_system
 	lodge_buffer_object_t				camera_buffer;
 
 	struct lodge_lights					lights;
-	lodge_buffer_object_t				lights_buffer_object;
+	struct lodge_buffer_ring			lights_buffer;
+	size_t								lights_buffer_offset;
+	size_t								lights_buffer_size;
+	struct lodge_scene_query			point_lights_query;
+
+	struct lodge_lights_clustered		lights_clustered;
+	struct lodge_light_clusters			light_clusters;
+	size_t								light_clusters_offset;
+	size_t								light_clusters_size;
+	size_t								light_indices_offset;
+	size_t								light_indices_size;
 
 	lodge_texture_t						texture_offscreen;
 	lodge_framebuffer_t					framebuffer_offscreen;
@@ -187,6 +324,9 @@ struct lodge_scene_render_system
 
 	struct lodge_shadow_map				shadow_map;
 	bool								shadow_map_update;
+	bool								shadow_map_cache;
+	bool								shadow_map_redraw[LODGE_SHADOW_CASCADE_SPLITS_COUNT];	// Static casters, this frame.
+	uint32_t							shadow_map_cached;		// Last frame, cascades reused from the cache.
 
 	lodge_asset_t						volumetric_light_shader;
 	lodge_texture_t						volumetric_light_texture;
@@ -204,10 +344,20 @@ struct lodge_scene_render_system
 	struct lodge_render_system_pass		passes[LODGE_SCENE_RENDER_SYSTEM_PASS_MAX];
 
 	lodge_entity_t						active_camera;
+
+	lodge_scene_t						scene;
 };
 
 lodge_system_type_t LODGE_SYSTEM_TYPE_SCENE_RENDER = NULL;
 
+//
+// The first light is the sun, if there is one.
+//
+static vec3 lodge_lights_get_sun_dir(const struct lodge_lights *lights)
+{
+	return lights->count > 0 ? vec3_make(xyz_of(lights->elements[0].pos_dir)) : vec3_zero();
+}
+
 static void lodge_scene_render_system_post_process_light(const struct lodge_scene_render_system *system, struct mvp mvp, struct lodge_scene_render_pass_params *pass_params)
 {
 #if 1
@@ -232,7 +382,7 @@ static void lodge_scene_render_system_post_process_light(const struct lodge_scen
 	//
 	// globals
 	//
-	lodge_shader_set_constant_vec3(deferred_light_shader, strview("sun_dir"), vec3_make(xyz_of(system->lights.elements[0].pos_dir)));
+	lodge_shader_set_constant_vec3(deferred_light_shader, strview("sun_dir"), lodge_lights_get_sun_dir(&system->lights));
 
 	//
 	// postprocess
@@ -243,10 +393,129 @@ static void lodge_scene_render_system_post_process_light(const struct lodge_scen
 	// distance_fog
 	//
 	lodge_shader_bind_constant_buffer(deferred_light_shader, 2, system->distance_fog_buffer);
-	lodge_shader_bind_constant_buffer(deferred_light_shader, 4, system->lights_buffer_object);
+	if(system->lights_buffer_size > 0) {
+		lodge_shader_bind_storage_buffer_range(deferred_light_shader, 4, system->lights_buffer.buffer_object, system->lights_buffer_offset, system->lights_buffer_size);
+	}
+	if(system->light_clusters_size > 0) {
+		lodge_shader_bind_storage_buffer_range(deferred_light_shader, 5, system->lights_buffer.buffer_object, system->light_clusters_offset, system->light_clusters_size);
+	}
+	if(system->light_indices_size > 0) {
+		lodge_shader_bind_storage_buffer_range(deferred_light_shader, 6, system->lights_buffer.buffer_object, system->light_indices_offset, system->light_indices_size);
+	}
 #endif
 }
 
+//
+// Points the instance attributes of `drawable` at `offset` (in bytes) in `buffer`; this stands
+// in for a base instance on the draw call.
+//
+static void lodge_static_meshes_bind_instances(struct lodge_static_meshes *system, lodge_drawable_t drawable, size_t offset)
+{
+	const uint32_t stride = sizeof(struct lodge_static_mesh_instance);
+
+	for(uint32_t column = 0; column < 4; column++) {
+		lodge_drawable_set_buffer_object(drawable, LODGE_STATIC_MESH_INSTANCE_ATTRIB_MODEL + column, (struct lodge_drawable_attrib) {
+			.name = strview_static("instance_model"),
+			.buffer_object = system->buffer.buffer_object,
+			.float_count = 4,
+			.offset = (uint32_t)(offset + column * sizeof(vec4)),
+			.stride = stride,
+			.instanced = 1,
+		});
+	}
+
+	lodge_drawable_set_buffer_object(drawable, LODGE_STATIC_MESH_INSTANCE_ATTRIB_ENTITY, (struct lodge_drawable_attrib) {
+		.name = strview_static("instance_entity"),
+		.buffer_object = system->buffer.buffer_object,
+		.float_count = 2,
+		.offset = (uint32_t)(offset + offsetof(struct lodge_static_mesh_instance, entity)),
+		.stride = stride,
+		.instanced = 1,
+	});
+}
+
+static bool lodge_static_meshes_same_draw(const struct lodge_static_meshes *system, size_t a, size_t b)
+{
+	return system->shaders_resolved[a] == system->shaders_resolved[b]
+		&& system->textures_resolved[a] == system->textures_resolved[b]
+		&& system->meshes[a] == system->meshes[b]
+		&& system->lods[a] == system->lods[b];
+}
+
+#define LODGE_STATIC_MESHES_KEY_INDEX_BITS	20
+#define LODGE_STATIC_MESHES_KEY_INDEX_MASK	((1ull << LODGE_STATIC_MESHES_KEY_INDEX_BITS) - 1)
+
+//
+// Writes `visible` for the meshes inside `view_projection`, and returns how many are.
+//
+static size_t lodge_static_meshes_cull(struct lodge_static_meshes *system, const mat4 *view_projection, bool shadow)
+{
+	if(!system->cull) {
+		if(system->count > 0) {
+			memset(system->visible, 1, system->count);
+		}
+		return system->count;
+	}
+
+	struct frustum_planes frustum = frustum_planes_make(*view_projection);
+
+	//
+	// Casters between the light and a cascade still throw shadows into it.
+	//
+	if(shadow) {
+		frustum.planes[FRUSTUM_PLANE_NEAR] = vec4_make(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	return frustum_planes_cull_aabbs(&frustum, &(struct frustum_aabbs_soa) {
+		.count = system->count,
+		.center_x = system->bounds_center[0],
+		.center_y = system->bounds_center[1],
+		.center_z = system->bounds_center[2],
+		.extent_x = system->bounds_extent[0],
+		.extent_y = system->bounds_extent[1],
+		.extent_z = system->bounds_extent[2],
+	}, system->visible);
+}
+
+static uint64_t lodge_static_meshes_hash(uint64_t hash, uint64_t value)
+{
+	return hash ^ (value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+}
+
+//
+// Identifies the casters inside a shadow cascade by what they draw with, so the cascade can
+// tell when its cached static shadows are stale.
+//
+static uint64_t lodge_static_meshes_casters_hash(struct lodge_static_meshes *system, const mat4 *view_projection)
+{
+	uint64_t hash = 0;
+
+	if(!system->draw) {
+		return hash;
+	}
+
+	lodge_static_meshes_cull(system, view_projection, true);
+
+	for(size_t i = 0, count = system->count; i < count; i++) {
+		if(!system->visible[i]) {
+			continue;
+		}
+
+		hash = lodge_static_meshes_hash(hash, i);
+		hash = lodge_static_meshes_hash(hash, (uintptr_t)system->meshes[i]);
+		hash = lodge_static_meshes_hash(hash, (uintptr_t)system->shaders_resolved[i]);
+		hash = lodge_static_meshes_hash(hash, system->lods[i]);
+
+		uint64_t model[sizeof(mat4) / sizeof(uint64_t)];
+		memcpy(model, &system->models[i], sizeof(mat4));
+		for(size_t j = 0; j < LODGE_ARRAYSIZE(model); j++) {
+			hash = lodge_static_meshes_hash(hash, model[j]);
+		}
+	}
+
+	return hash;
+}
+
 //
 // FIXME(TS): should this live here?
 //
@@ -255,81 +524,213 @@ static void lodge_static_mesh_render(lodge_scene_t scene, const struct lodge_sce
 	lodge_gfx_annotate_begin(strview("static_meshes"));
 
 	ASSERT_OR(pass_params->pass == LODGE_SCENE_RENDER_SYSTEM_PASS_DEFERRED
-		|| pass_params->pass == LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW) {
+		|| pass_params->pass == LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW_STATIC) {
 		return;
 	}
 
-	for(size_t i = 0, count = system->count; i < count; i++) {
-		struct lodge_static_mesh_component *component = system->components[i];
+	const bool shadow = pass_params->pass == LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW_STATIC;
+	ASSERT_OR(!shadow || pass_params->cascade_index < LODGE_SHADOW_CASCADE_SPLITS_COUNT) {
+		return;
+	}
+	struct lodge_static_meshes_cascade *cascade = shadow ? &system->shadow_cascades[pass_params->cascade_index] : NULL;
+
+	const size_t visible_count = lodge_static_meshes_cull(system, &pass_params->camera.view_projection, shadow);
 
-		lodge_shader_t shader = NULL;
+	if(shadow) {
+		cascade->drawn = (uint32_t)visible_count;
+		cascade->culled = (uint32_t)(system->count - visible_count);
+	} else {
+		system->drawn = (uint32_t)visible_count;
+		system->culled = (uint32_t)(system->count - visible_count);
+	}
 
+	//
+	// Instances are written in draw order, so each run below reads a contiguous slice.
+	//
+	size_t instances_count = 0;
+	if(system->instance) {
+		for(size_t k = 0, count = system->count; k < count; k++) {
+			const size_t i = system->keys[k] & LODGE_STATIC_MESHES_KEY_INDEX_MASK;
+			instances_count += system->visible[i] && system->shader_instanced[i];
+		}
+	}
+
+	size_t instances_offset = 0;
+	struct lodge_static_mesh_instance *instances = NULL;
+	if(instances_count > 0) {
 		//
-		// TODO(TS): do asset lookup in _update pass
+		// NULL if this frame ran out of space; the buffer grows to fit the next one.
 		//
-		shader = lodge_assets2_get(system->shaders, component->shader_asset);
+		instances = lodge_buffer_ring_alloc(&system->buffer, instances_count * sizeof(struct lodge_static_mesh_instance), sizeof(struct lodge_static_mesh_instance), &instances_offset);
+		if(instances) {
+			for(size_t k = 0, count = system->count, instance = 0; k < count; k++) {
+				const size_t i = system->keys[k] & LODGE_STATIC_MESHES_KEY_INDEX_MASK;
+				if(system->visible[i] && system->shader_instanced[i]) {
+					instances[instance++] = (struct lodge_static_mesh_instance) {
+						.model = system->models[i],
+						.entity = vec2_make((float)lodge_entity_get_id(system->ids[i]), system->selected[i]),
+					};
+				}
+			}
+		}
+	}
 
-		if(!shader) {
-			continue;
+	lodge_shader_t bound_shader = NULL;
+	lodge_texture_t bound_texture = NULL;
+	uint32_t draw_calls = 0;
+	uint32_t state_changes = 0;
+
+	for(size_t k = 0, count = system->count, run_end; k < count; k = run_end) {
+		const uint64_t run_key = system->keys[k] >> LODGE_STATIC_MESHES_KEY_INDEX_BITS;
+		const size_t run_index = system->keys[k] & LODGE_STATIC_MESHES_KEY_INDEX_MASK;
+
+		size_t run_first = k;
+		size_t run_visible = 0;
+		for(run_end = k; run_end < count; run_end++) {
+			const size_t i = system->keys[run_end] & LODGE_STATIC_MESHES_KEY_INDEX_MASK;
+			if((system->keys[run_end] >> LODGE_STATIC_MESHES_KEY_INDEX_BITS) != run_key
+				|| !lodge_static_meshes_same_draw(system, run_index, i)) {
+				break;
+			}
+			if(system->visible[i] && run_visible++ == 0) {
+				run_first = run_end;
+			}
 		}
 
-		lodge_gfx_bind_shader(shader);
+		if(run_visible == 0) {
+			continue;
+		}
 
 		//
-		// TODO(TS): do once in shader init
+		// The whole run shares these.
 		//
-		lodge_shader_bind_constant_buffer(shader, 0, pass_params->camera_buffer);
+		const size_t first = system->keys[run_first] & LODGE_STATIC_MESHES_KEY_INDEX_MASK;
+		lodge_shader_t shader = system->shaders_resolved[first];
+		lodge_texture_t texture = system->textures_resolved[first];
+		const struct fbx_asset *mesh = system->meshes[first];
+		const uint32_t lod = system->lods[first];
+		const bool instanced = system->instance && system->shader_instanced[first];
+
+		if(instanced && !instances) {
+			continue;
+		}
 
-		lodge_shader_set_constant_float(shader, strview("entity_id"), (float)((uintptr_t)system->ids[i]));
-		lodge_shader_set_constant_float(shader, strview("entity_selected"), (float)((uintptr_t)system->selected[i]));
+		if(shader != bound_shader) {
+			lodge_gfx_bind_shader(shader);
+			state_changes++;
 
-#if 1
-		lodge_shader_bind_constant_buffer_range(shader,
-			1,
-			system->transforms_buffer,
-			i * sizeof(struct lodge_transform_uniform),
-			sizeof(struct lodge_transform_uniform)
-		);
-#else
-		//
-		// TODO(TS): It would be nice to upload `system->static_mesh_transforms` as offsets into a VBO
-		//
-		//lodge_shader_set_constant_mat4(static_mesh->shader, strview("model"), system->static_mesh_transforms[i].model);
-#endif
+			//
+			// The binding point is not per shader, once per pass is enough.
+			//
+			if(!bound_shader) {
+				lodge_shader_bind_constant_buffer(shader, 0, pass_params->camera_buffer);
+				state_changes++;
+			}
+			bound_shader = shader;
+		}
 
-		//
-		// TODO(TS): do asset lookup in _update pass
-		//
-		if(component->texture_asset) {
-			lodge_texture_t *texture = lodge_assets2_get(system->textures, component->texture_asset);
-			if(texture) {
-				lodge_gfx_bind_texture_2d(0, *texture);
+		if(texture && texture != bound_texture) {
+			lodge_gfx_bind_texture_2d(0, texture);
+			bound_texture = texture;
+			state_changes++;
+		}
+
+		if(instanced) {
+			lodge_static_meshes_bind_instances(system, mesh->drawable, instances_offset);
+			state_changes++;
+
+			fbx_asset_draw_lod_instanced(mesh, lod, run_visible);
+			draw_calls++;
+
+			instances_offset += run_visible * sizeof(struct lodge_static_mesh_instance);
+			continue;
+		}
+
+		for(size_t j = run_first; j < run_end; j++) {
+			const size_t i = system->keys[j] & LODGE_STATIC_MESHES_KEY_INDEX_MASK;
+			if(!system->visible[i] || system->transforms_offsets[i] == SIZE_MAX) {
+				continue;
 			}
+
+			lodge_shader_set_constant_float(shader, strview("entity_id"), (float)lodge_entity_get_id(system->ids[i]));
+			lodge_shader_set_constant_float(shader, strview("entity_selected"), system->selected[i]);
+			lodge_shader_bind_constant_buffer_range(shader,
+				1,
+				system->buffer.buffer_object,
+				system->transforms_offsets[i],
+				sizeof(mat4)
+			);
+			state_changes += 3;
+
+			fbx_asset_draw_lod(mesh, lod);
+			draw_calls++;
 		}
+	}
 
-		lodge_drawable_render_indexed(system->meshes[i]->drawable, system->meshes[i]->static_mesh.indices_count, 0);
+	if(shadow) {
+		cascade->draw_calls = draw_calls;
+		cascade->state_changes = state_changes;
+	} else {
+		system->draw_calls = draw_calls;
+		system->state_changes = state_changes;
 	}
 
 	lodge_gfx_annotate_end();
 }
 
-static void lodge_static_meshes_new_inplace(struct lodge_static_meshes *static_meshes, lodge_scene_t scene, struct lodge_assets2 *shaders, struct lodge_assets2 *textures)
+static void lodge_static_meshes_ids_free_inplace(struct lodge_static_meshes_ids *ids)
 {
+	free(ids->keys);
+	free(ids->values);
+	*ids = (struct lodge_static_meshes_ids) { 0 };
+}
+
+static void lodge_static_meshes_new_inplace(struct lodge_static_meshes *static_meshes, lodge_scene_t scene, lodge_component_type_t static_mesh_component_type, struct lodge_assets2 *shaders, struct lodge_assets2 *textures)
+{
+	memset(static_meshes, 0, sizeof(struct lodge_static_meshes));
+
 	static_meshes->draw = true;
-	static_meshes->count = 0;
-	static_meshes->transforms_buffer = lodge_buffer_object_make_dynamic(sizeof(static_meshes->transforms));
+	static_meshes->cull = true;
+	static_meshes->instance = true;
+	lodge_buffer_ring_new_inplace(&static_meshes->buffer, 1024 * sizeof(struct lodge_static_mesh_instance));
 
 	static_meshes->shaders = shaders;
 	static_meshes->textures = textures;
 
+	lodge_scene_query_new_inplace(&static_meshes->query, scene, 1, &static_mesh_component_type);
+
 	// HACK(TS): static_meshes live here for now FIXME(TS)
 	lodge_scene_add_render_pass_func(scene, LODGE_SCENE_RENDER_SYSTEM_PASS_DEFERRED, &lodge_static_mesh_render, static_meshes);
-	lodge_scene_add_render_pass_func(scene, LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW, &lodge_static_mesh_render, static_meshes);
+	lodge_scene_add_render_pass_func(scene, LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW_STATIC, &lodge_static_mesh_render, static_meshes);
 }
 
 static void lodge_static_meshes_free_inplace(struct lodge_static_meshes *static_meshes)
 {
-	lodge_buffer_object_reset(static_meshes->transforms_buffer);
+	free(static_meshes->components);
+	free(static_meshes->models);
+	free(static_meshes->meshes);
+	free(static_meshes->lods);
+	free(static_meshes->ids);
+	free(static_meshes->selected);
+	free(static_meshes->shaders_resolved);
+	free(static_meshes->textures_resolved);
+	free(static_meshes->shader_instanced);
+	free(static_meshes->shader_ids_instanced);
+	free(static_meshes->keys);
+	free(static_meshes->keys_scratch);
+	for(int axis = 0; axis < 3; axis++) {
+		free(static_meshes->bounds_center[axis]);
+		free(static_meshes->bounds_extent[axis]);
+	}
+	free(static_meshes->visible);
+	free(static_meshes->transforms_offsets);
+
+	lodge_static_meshes_ids_free_inplace(&static_meshes->shader_ids);
+	lodge_static_meshes_ids_free_inplace(&static_meshes->texture_ids);
+	lodge_static_meshes_ids_free_inplace(&static_meshes->mesh_ids);
+
+	lodge_buffer_ring_free_inplace(&static_meshes->buffer);
+	lodge_scene_query_free_inplace(&static_meshes->query);
 }
 
 struct vec2i
@@ -473,6 +874,7 @@ static void lodge_scene_render_system_offscreen_resized(struct lodge_scene_rende
 
 static void lodge_scene_render_system_new_inplace(struct lodge_scene_render_system *system, lodge_scene_t scene, struct lodge_scene_renderer_plugin *plugin)
 {
+	system->scene = scene;
 	system->render_width = 1920;
 	system->render_height = 1080;
 	system->window_width = 1920;
@@ -543,6 +945,7 @@ static void lodge_scene_render_system_new_inplace(struct lodge_scene_render_syst
 		const uint32_t height = 4096;
 		lodge_shadow_map_new_inplace(&system->shadow_map, width, height, z_near, z_far);
 		system->shadow_map_update = true;
+		system->shadow_map_cache = true;
 		//system->shadow_map_draw_debug = false;
 	}
 
@@ -553,9 +956,21 @@ static void lodge_scene_render_system_new_inplace(struct lodge_scene_render_syst
 	// Volumetric light
 	//
 	{
-		system->lights.count = 0;
-		system->lights_buffer_object = lodge_buffer_object_make_dynamic(sizeof(struct lodge_lights));
-		lodge_buffer_object_set(system->lights_buffer_object, 0, &system->lights, sizeof(system->lights));
+		dynbuf_new_inplace(dynbuf(system->lights), 128);
+		lodge_buffer_ring_new_inplace(&system->lights_buffer, sizeof(struct lodge_lights_header) + 128 * sizeof(struct lodge_light));
+		system->lights_buffer_offset = 0;
+		system->lights_buffer_size = 0;
+
+		dynbuf_new_inplace(dynbuf(system->lights_clustered), 128);
+		lodge_light_clusters_new_inplace(&system->light_clusters, (struct lodge_light_clusters_desc) {
+			.tiles_x = 16,
+			.tiles_y = 9,
+			.slices = 24,
+		});
+		system->light_clusters_offset = 0;
+		system->light_clusters_size = 0;
+		system->light_indices_offset = 0;
+		system->light_indices_size = 0;
 
 		system->volumetric_light_texture = lodge_texture_3d_make((struct lodge_texture_3d_desc) {
 			.width = 128,
@@ -599,7 +1014,8 @@ static void lodge_scene_render_system_new_inplace(struct lodge_scene_render_syst
 		lodge_buffer_object_set(system->distance_fog_buffer, 0, &system->distance_fog, sizeof(struct lodge_distance_fog));
 	}
 
-	lodge_static_meshes_new_inplace(&system->static_meshes, scene, system->shaders, system->textures);
+	lodge_static_meshes_new_inplace(&system->static_meshes, scene, plugin->static_mesh_component_type, system->shaders, system->textures);
+	lodge_scene_query_new_inplace(&system->point_lights_query, scene, 1, &LODGE_COMPONENT_TYPE_POINT_LIGHT);
 
 	{
 		struct lodge_scene_funcs *funcs = lodge_scene_get_funcs(scene);
@@ -611,6 +1027,11 @@ void lodge_scene_render_system_free_inplace(struct lodge_scene_render_system *sy
 {
 	lodge_post_process_free_inplace(&system->post_process);
 	lodge_static_meshes_free_inplace(&system->static_meshes);
+	lodge_scene_query_free_inplace(&system->point_lights_query);
+	lodge_buffer_ring_free_inplace(&system->lights_buffer);
+	dynbuf_free_inplace(dynbuf(system->lights));
+	lodge_light_clusters_free_inplace(&system->light_clusters);
+	dynbuf_free_inplace(dynbuf(system->lights_clustered));
 	lodge_geometry_buffer_reset(&system->geometry_buffer);
 	lodge_pipeline_reset(system->pipeline_wireframe);
 	lodge_pipeline_reset(system->pipeline_default);
@@ -631,11 +1052,27 @@ static void lodge_scene_render_system_update_shadow_map(struct lodge_scene_rende
 			&system->shadow_map,
 			dt,
 			camera_params.inv_view_projection,
-			vec3_make(xyz_of(system->lights.elements[0].pos_dir)),
+			lodge_lights_get_sun_dir(&system->lights),
 			shadow_map_debugs
 		);
 	}
 
+	//
+	// Static casters are only drawn again in the cascades where they changed, or that moved.
+	//
+	if(!system->shadow_map_cache) {
+		lodge_shadow_map_cache_invalidate(&system->shadow_map);
+	}
+
+	system->shadow_map_cached = 0;
+	for(uint32_t cascade_index = 0; cascade_index < LODGE_SHADOW_CASCADE_SPLITS_COUNT; cascade_index++) {
+		const mat4 view_projection = mat4_mult(system->shadow_map.buffer.projections[cascade_index], system->shadow_map.buffer.views[cascade_index]);
+		const uint64_t casters_hash = lodge_static_meshes_casters_hash(&system->static_meshes, &view_projection);
+
+		system->shadow_map_redraw[cascade_index] = lodge_shadow_map_cache_update(&system->shadow_map, cascade_index, casters_hash);
+		system->shadow_map_cached += !system->shadow_map_redraw[cascade_index];
+	}
+
 	//
 	// Display shadow map debugging?
 	//
@@ -672,25 +1109,240 @@ static void lodge_scene_render_system_update_shadow_map(struct lodge_scene_rende
 #endif
 }
 
-static void lodge_static_meshes_update(struct lodge_static_meshes *system, lodge_system_type_t type, lodge_scene_t scene, float dt, struct lodge_scene_renderer_plugin *plugin)
+//
+// Transforms the object space box (Arvo, "Transforming Axis-Aligned Bounding Boxes").
+//
+static void lodge_static_meshes_set_bounds(struct lodge_static_meshes *system, size_t index, const mat4 *model, const struct aabb *bounds)
+{
+	const vec3 center = vec3_mult_scalar(vec3_add(bounds->min, bounds->max), 0.5f);
+	const vec3 extent = vec3_mult_scalar(vec3_sub(bounds->max, bounds->min), 0.5f);
+
+	for(int row = 0; row < 3; row++) {
+		system->bounds_center[row][index] = model->m[row] * center.x + model->m[4 + row] * center.y + model->m[8 + row] * center.z + model->m[12 + row];
+		system->bounds_extent[row][index] = fabsf(model->m[row]) * extent.x + fabsf(model->m[4 + row]) * extent.y + fabsf(model->m[8 + row]) * extent.z;
+	}
+}
+
+#define lodge_static_meshes_realloc(ptr, capacity) \
+	ptr = realloc(ptr, (capacity) * sizeof(*ptr)); \
+	ASSERT(ptr)
+
+static void lodge_static_meshes_reserve(struct lodge_static_meshes *system, size_t count)
+{
+	if(count <= system->capacity) {
+		return;
+	}
+
+	ASSERT_OR(count <= LODGE_STATIC_MESHES_KEY_INDEX_MASK + 1) {
+		return;
+	}
+
+	size_t capacity = system->capacity ? system->capacity : 256;
+	while(capacity < count) {
+		capacity *= 2;
+	}
+
+	lodge_static_meshes_realloc(system->components, capacity);
+	lodge_static_meshes_realloc(system->models, capacity);
+	lodge_static_meshes_realloc(system->meshes, capacity);
+	lodge_static_meshes_realloc(system->lods, capacity);
+	lodge_static_meshes_realloc(system->ids, capacity);
+	lodge_static_meshes_realloc(system->selected, capacity);
+	lodge_static_meshes_realloc(system->shaders_resolved, capacity);
+	lodge_static_meshes_realloc(system->textures_resolved, capacity);
+	lodge_static_meshes_realloc(system->shader_instanced, capacity);
+	lodge_static_meshes_realloc(system->shader_ids_instanced, capacity + 1);
+	lodge_static_meshes_realloc(system->keys, capacity);
+	lodge_static_meshes_realloc(system->keys_scratch, capacity);
+	for(int axis = 0; axis < 3; axis++) {
+		lodge_static_meshes_realloc(system->bounds_center[axis], capacity);
+		lodge_static_meshes_realloc(system->bounds_extent[axis], capacity);
+	}
+	lodge_static_meshes_realloc(system->visible, capacity);
+	lodge_static_meshes_realloc(system->transforms_offsets, capacity);
+
+	system->capacity = capacity;
+}
+
+//
+// Makes room for `count` unique keys at half load.
+//
+static void lodge_static_meshes_ids_reset(struct lodge_static_meshes_ids *ids, size_t count)
+{
+	size_t capacity = ids->capacity ? ids->capacity : 256;
+	while(capacity < count * 2) {
+		capacity *= 2;
+	}
+
+	if(capacity != ids->capacity) {
+		lodge_static_meshes_realloc(ids->keys, capacity);
+		lodge_static_meshes_realloc(ids->values, capacity);
+		ids->capacity = capacity;
+	}
+
+	memset(ids->keys, 0, ids->capacity * sizeof(*ids->keys));
+	ids->count = 0;
+}
+
+static uint32_t lodge_static_meshes_ids_get(struct lodge_static_meshes_ids *ids, const void *key)
+{
+	if(!key) {
+		return 0;
+	}
+
+	const size_t mask = ids->capacity - 1;
+	for(size_t slot = (size_t)(((uint64_t)(uintptr_t)key * 0x9E3779B97F4A7C15ull) >> 32) & mask;; slot = (slot + 1) & mask) {
+		if(ids->keys[slot] == key) {
+			return ids->values[slot];
+		}
+		if(!ids->keys[slot]) {
+			ASSERT(ids->count < mask);
+			ids->keys[slot] = key;
+			ids->values[slot] = ++ids->count;
+			return ids->values[slot];
+		}
+	}
+}
+
+//
+// LSD radix sort, a byte at a time. The low bits are the index, and `keys` are built in
+// index order, so sorting starts above them.
+//
+static void lodge_static_meshes_sort(uint64_t *keys, uint64_t *scratch, size_t count)
+{
+	uint64_t *src = keys;
+	uint64_t *dst = scratch;
+
+	for(uint32_t shift = LODGE_STATIC_MESHES_KEY_INDEX_BITS; shift < 64 && count > 1; shift += 8) {
+		size_t offsets[256] = { 0 };
+		for(size_t i = 0; i < count; i++) {
+			offsets[(src[i] >> shift) & 0xff]++;
+		}
+
+		//
+		// Skip bytes that are the same for every key (most of them, with few unique ids).
+		//
+		if(offsets[(src[0] >> shift) & 0xff] == count) {
+			continue;
+		}
+
+		for(size_t bucket = 0, sum = 0; bucket < 256; bucket++) {
+			const size_t bucket_count = offsets[bucket];
+			offsets[bucket] = sum;
+			sum += bucket_count;
+		}
+
+		for(size_t i = 0; i < count; i++) {
+			dst[offsets[(src[i] >> shift) & 0xff]++] = src[i];
+		}
+
+		uint64_t *tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	if(src != keys) {
+		memcpy(keys, src, count * sizeof(uint64_t));
+	}
+}
+
+static uint64_t lodge_static_meshes_key_bits(uint64_t id, uint32_t bits, uint32_t shift)
 {
-	// TODO(TS):
-	//		- do we want to collect all static_meshes of the same {drawable,material,shader} and instance them?
-	//		- maybe separate draw calls is enough?
-	//		- maybe we want to just batch them together to make it easier for the driver?
+	const uint64_t max_id = (1ull << bits) - 1;
+	return (id < max_id ? id : max_id) << shift;
+}
+
+//
+// Groups draws by shader, then texture, then mesh and LOD. Only the shaders that declare
+// `instance_model` are drawn instanced; each one is asked once.
+//
+static void lodge_static_meshes_build_keys(struct lodge_static_meshes *system)
+{
+	lodge_static_meshes_ids_reset(&system->shader_ids, system->count);
+	lodge_static_meshes_ids_reset(&system->texture_ids, system->count);
+	lodge_static_meshes_ids_reset(&system->mesh_ids, system->count);
+
+	for(size_t i = 0; i < system->count; i++) {
+		const uint32_t shader_count = system->shader_ids.count;
+		const uint32_t shader_id = lodge_static_meshes_ids_get(&system->shader_ids, system->shaders_resolved[i]);
+		if(shader_id > shader_count) {
+			system->shader_ids_instanced[shader_id] = lodge_shader_get_constant_index(system->shaders_resolved[i], strview("instance_model")) >= 0;
+		}
+		system->shader_instanced[i] = system->shader_ids_instanced[shader_id];
+
+		const uint32_t texture_id = lodge_static_meshes_ids_get(&system->texture_ids, system->textures_resolved[i]);
+		const uint32_t mesh_id = lodge_static_meshes_ids_get(&system->mesh_ids, system->meshes[i]);
+
+		system->keys[i] = lodge_static_meshes_key_bits(shader_id, 14, 50)
+			| lodge_static_meshes_key_bits(texture_id, 13, 37)
+			| lodge_static_meshes_key_bits(mesh_id, 14, 23)
+			| lodge_static_meshes_key_bits(system->lods[i], 3, 20)
+			| (uint64_t)i;
+	}
+
+	lodge_static_meshes_sort(system->keys, system->keys_scratch, system->count);
+}
+
+//
+// Writes `model` for the meshes whose shaders are not instanced, each at a constant buffer
+// aligned offset. The instances are written per pass, in `lodge_static_mesh_render()`.
+//
+static void lodge_static_meshes_upload_transforms(struct lodge_static_meshes *system)
+{
+	const size_t alignment = lodge_buffer_object_constant_offset_alignment();
+	const size_t stride = (sizeof(mat4) + alignment - 1) / alignment * alignment;
+
+	size_t instanced_count = 0;
+	for(size_t i = 0; system->instance && i < system->count; i++) {
+		instanced_count += system->shader_instanced[i];
+	}
+
+	//
+	// Room for the transforms and two passes worth of instances; passes past that make the
+	// buffer grow for the next frame.
+	//
+	lodge_buffer_ring_begin_frame(&system->buffer,
+		(system->count - instanced_count) * stride
+		+ 2 * instanced_count * sizeof(struct lodge_static_mesh_instance)
+	);
+
+	for(size_t i = 0; i < system->count; i++) {
+		system->transforms_offsets[i] = SIZE_MAX;
+		if(system->instance && system->shader_instanced[i]) {
+			continue;
+		}
+
+		size_t offset = 0;
+		mat4 *model = lodge_buffer_ring_alloc(&system->buffer, sizeof(mat4), alignment, &offset);
+		if(model) {
+			*model = system->models[i];
+			system->transforms_offsets[i] = offset;
+		}
+	}
+}
+
+//
+// `camera` picks the LODs; without one everything is drawn at full detail.
+//
+static void lodge_static_meshes_update(struct lodge_static_meshes *system, lodge_system_type_t type, lodge_scene_t scene, float dt, struct lodge_scene_renderer_plugin *plugin, lodge_entity_t camera)
+{
+	const vec3 camera_pos = camera ? lodge_get_position(scene, camera) : vec3_zero();
+
+	memset(system->shadow_cascades, 0, sizeof(system->shadow_cascades));
 
 	//
 	// Static meshes
 	//
 	system->count = 0;
 	if(system->draw) {
-		lodge_scene_components_foreach(scene, struct lodge_static_mesh_component*, static_mesh, plugin->static_mesh_component_type) {
+		lodge_scene_query_foreach(&system->query, i) {
+			struct lodge_static_mesh_component *static_mesh = lodge_scene_query_get_component(&system->query, i, 0);
 			// TODO: static_mesh->drawable
 
 			// Load FBX?
 			const struct fbx_asset *fbx_asset = NULL;
 			if(static_mesh->fbx_asset) {
-				fbx_asset = lodge_assets2_get(plugin->fbx_assets, static_mesh->fbx_asset);
+				fbx_asset = lodge_assets2_get_async(plugin->fbx_assets, static_mesh->fbx_asset);
 			}
 
 			// Load shader?
@@ -711,35 +1363,51 @@ static void lodge_static_meshes_update(struct lodge_static_meshes *system, lodge
 			//}
 
 			//
-			// TODO(TS): cull meshes here
+			// Culled per pass in `lodge_static_mesh_render()`, against the bounds gathered here.
 			//
+			lodge_shader_t shader = NULL;
 			if(fbx_asset
 				&& static_mesh->shader_asset
 				&& static_mesh->texture_asset) {
-				lodge_entity_t entity = lodge_scene_get_component_entity(scene, plugin->static_mesh_component_type, static_mesh);
+				shader = lodge_assets2_get(system->shaders, static_mesh->shader_asset);
+			}
+
+			if(shader) {
+				lodge_entity_t entity = lodge_scene_query_get_entity(&system->query, i);
 				ASSERT(entity);
-				if(entity) {
-					//
-					// TODO(TS): insert sorted, based on the {static_mesh,material,shader} used.
-					//
-					membuf_append(membuf_wrap(system->components), &system->count, &static_mesh, sizeof(static_mesh));
-					system->meshes[system->count - 1] = fbx_asset;
-					system->transforms[system->count - 1].model = lodge_get_transform(scene, entity);
-					system->ids[system->count - 1] = entity;
-					system->selected[system->count - 1] = lodge_scene_is_entity_selected(scene, entity) ? 1.0f : 0.0f;
+				lodge_static_meshes_reserve(system, system->count + 1);
+				if(entity && system->count < system->capacity) {
+					const size_t index = system->count++;
+					const lodge_texture_t *texture = lodge_assets2_get_async(system->textures, static_mesh->texture_asset);
+					system->components[index] = static_mesh;
+					system->shaders_resolved[index] = shader;
+					system->textures_resolved[index] = texture ? *texture : NULL;
+					system->meshes[index] = fbx_asset;
+					system->lods[index] = 0;
+					if(camera) {
+						//
+						// LOD distances are in object space; the largest scale axis keeps the
+						// error on screen within bounds.
+						//
+						const vec3 scale = lodge_get_scale(scene, entity);
+						const float max_scale = max(fabsf(scale.x), max(fabsf(scale.y), fabsf(scale.z)));
+						if(max_scale > 0.0f) {
+							const float distance = vec3_distance(camera_pos, lodge_get_position(scene, entity)) / max_scale;
+							system->lods[index] = fbx_asset_select_lod(fbx_asset, distance);
+						}
+					}
+					system->models[index] = lodge_get_transform(scene, entity);
+					system->ids[index] = entity;
+					lodge_static_meshes_set_bounds(system, index, &system->models[index], &fbx_asset->bounds);
+					system->selected[index] = lodge_scene_is_entity_selected(scene, entity) ? 1.0f : 0.0f;
 				}
 			}
 		}
 
-		if(system->count > 0) {
-			lodge_buffer_object_set(
-				system->transforms_buffer,
-				0,
-				&system->transforms,
-				system->count * sizeof(struct lodge_transform_uniform)
-			);
-		}
+		lodge_static_meshes_build_keys(system);
 	}
+
+	lodge_static_meshes_upload_transforms(system);
 }
 
 static void lodge_scene_render_system_update(struct lodge_scene_render_system *system, lodge_system_type_t type, lodge_scene_t scene, float dt, struct lodge_scene_renderer_plugin *plugin)
@@ -749,40 +1417,42 @@ static void lodge_scene_render_system_update(struct lodge_scene_render_system *s
 	//
 	// Static meshes -- TODO(TS): move to separate system
 	//
-	lodge_static_meshes_update(&system->static_meshes, type, scene, dt, plugin);
+	lodge_static_meshes_update(&system->static_meshes, type, scene, dt, plugin, system->active_camera);
 
 	//
 	// Directional and point lights 
 	//
-	system->lights.count = 0;
+	dynbuf_clear(dynbuf(system->lights));
 	lodge_scene_components_foreach(scene, struct lodge_directional_light_component*, directional_light, LODGE_COMPONENT_TYPE_DIRECTIONAL_LIGHT) {
-		{
-			size_t tmp = system->lights.count;
-			struct lodge_light light = {
-				.pos_dir = vec4_make_from_vec3(directional_light->dir, 0.0f),
-				.intensity_attenuation = vec4_make_from_vec3(directional_light->intensities, 0.0f),
-			};
-			membuf_append(membuf_wrap(system->lights.elements), &tmp, &light, sizeof(light));
-			system->lights.count = tmp;
-		}
+		struct lodge_light light = {
+			.pos_dir = vec4_make_from_vec3(directional_light->dir, 0.0f),
+			.intensity_attenuation = vec4_make_from_vec3(directional_light->intensities, 0.0f),
+		};
+		dynbuf_append(dynbuf(system->lights), &light, sizeof(light));
 	}
-	lodge_scene_components_foreach(scene, struct lodge_point_light_component*, point_light, LODGE_COMPONENT_TYPE_POINT_LIGHT) {
-		{
-			size_t tmp = system->lights.count;
-			lodge_entity_t owner = lodge_scene_get_component_entity(scene, LODGE_COMPONENT_TYPE_POINT_LIGHT, point_light);
-
-			struct lodge_light light = {
-				.pos_dir = vec4_make_from_vec3(lodge_get_position(scene, owner), 1.0f),
-				.intensity_attenuation = vec4_make_from_vec3(point_light->intensities, point_light->attenuation),
-				.cone_direction_ambient_coefficient = vec4_make_from_vec3(point_light->cone_direction, point_light->ambient_coefficient),
-				.cone_angle = vec4_make(point_light->cone_angle, 0.0f, 0.0f, 0.0f),
-			};
-
-			membuf_append(membuf_wrap(system->lights.elements), &tmp, &light, sizeof(light));
-			system->lights.count = tmp;
-		}
+	const size_t directional_count = system->lights.count;
+
+	dynbuf_clear(dynbuf(system->lights_clustered));
+	lodge_scene_query_foreach(&system->point_lights_query, i) {
+		const struct lodge_point_light_component *point_light = lodge_scene_query_get_component(&system->point_lights_query, i, 0);
+		lodge_entity_t owner = lodge_scene_query_get_entity(&system->point_lights_query, i);
+
+		struct lodge_light light = {
+			.pos_dir = vec4_make_from_vec3(lodge_get_position(scene, owner), 1.0f),
+			.intensity_attenuation = vec4_make_from_vec3(point_light->intensities, point_light->attenuation),
+			.cone_direction_ambient_coefficient = vec4_make_from_vec3(point_light->cone_direction, point_light->ambient_coefficient),
+			.cone_angle = vec4_make(point_light->cone_angle, 0.0f, 0.0f, 0.0f),
+		};
+		dynbuf_append(dynbuf(system->lights), &light, sizeof(light));
+
+		struct lodge_light_clusters_light light_clustered = {
+			.pos = vec3_make(xyz_of(light.pos_dir)),
+			.range = lodge_light_clusters_range(point_light->intensities, point_light->attenuation, 1.0f / 256.0f),
+			.cone_direction = point_light->cone_direction,
+			.cone_angle = (point_light->cone_angle > 0.0f && point_light->cone_angle < 180.0f) ? radians(point_light->cone_angle) : 0.0f,
+		};
+		dynbuf_append(dynbuf(system->lights_clustered), &light_clustered, sizeof(light_clustered));
 	}
-	lodge_buffer_object_set(system->lights_buffer_object, 0, &system->lights, sizeof(system->lights));
 
 	//
 	// Shadow map (update after: directional lights, camera)
@@ -798,6 +1468,57 @@ static void lodge_scene_render_system_update(struct lodge_scene_render_system *s
 		}
 	}
 
+	//
+	// Point lights are binned in the view clusters they reach.
+	//
+	if(system->active_camera) {
+		struct render_size render_size = lodge_scene_render_system_get_render_size(system);
+		struct lodge_camera_params camera_params = lodge_camera_params_make(scene, system->active_camera, render_size.aspect_ratio);
+
+		lodge_light_clusters_update(&system->light_clusters, &camera_params.view, &camera_params.projection,
+			system->lights_clustered.elements, system->lights_clustered.count, (uint32_t)directional_count);
+	}
+
+	//
+	// Only the lights in use are uploaded, and their clusters next to them.
+	//
+	{
+		const size_t alignment = lodge_buffer_object_storage_offset_alignment();
+		const size_t lights_size = sizeof(struct lodge_lights_header) + system->lights.count * sizeof(struct lodge_light);
+		const size_t light_clusters_size = sizeof(struct lodge_light_clusters_params) + system->light_clusters.clusters_count * sizeof(struct lodge_light_cluster);
+		const size_t light_indices_size = max(system->light_clusters.indices_count, 1) * sizeof(uint32_t);
+		lodge_buffer_ring_begin_frame(&system->lights_buffer, lights_size + light_clusters_size + light_indices_size + 3 * alignment);
+
+		system->lights_buffer_size = 0;
+		system->light_clusters_size = 0;
+		system->light_indices_size = 0;
+
+		char *dst = lodge_buffer_ring_alloc(&system->lights_buffer, lights_size, alignment, &system->lights_buffer_offset);
+		if(dst) {
+			memcpy(dst, &(struct lodge_lights_header) {
+				.count = (int32_t)system->lights.count,
+				.directional_count = (int32_t)directional_count,
+			}, sizeof(struct lodge_lights_header));
+			memcpy(dst + sizeof(struct lodge_lights_header), system->lights.elements, system->lights.count * sizeof(struct lodge_light));
+			system->lights_buffer_size = lights_size;
+		}
+
+		dst = system->active_camera ? lodge_buffer_ring_alloc(&system->lights_buffer, light_clusters_size, alignment, &system->light_clusters_offset) : NULL;
+		if(dst) {
+			memcpy(dst, &system->light_clusters.params, sizeof(struct lodge_light_clusters_params));
+			memcpy(dst + sizeof(struct lodge_light_clusters_params), system->light_clusters.clusters, system->light_clusters.clusters_count * sizeof(struct lodge_light_cluster));
+			system->light_clusters_size = light_clusters_size;
+		}
+
+		dst = system->active_camera ? lodge_buffer_ring_alloc(&system->lights_buffer, light_indices_size, alignment, &system->light_indices_offset) : NULL;
+		if(dst && system->light_clusters.indices_count > 0) {
+			memcpy(dst, system->light_clusters.indices, system->light_clusters.indices_count * sizeof(uint32_t));
+		}
+		if(dst) {
+			system->light_indices_size = light_indices_size;
+		}
+	}
+
 	if(system->active_camera) {
 		lodge_scene_render_system_update_shadow_map(system, scene, dt);
 	}
@@ -889,6 +1610,45 @@ static void lodge_scene_render_system_render_shadow_map_cascade(struct lodge_sce
 	
 	lodge_gfx_annotate_begin(strbuf_to_strview(annotation));
 
+	struct lodge_scene_render_pass_params pass_params = {
+		.pass = LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW_STATIC,
+		.time = system->time,
+		.camera = lodge_camera_params_make_from_shadow_map_cascade(system, cascade_index),
+		.camera_buffer = system->camera_buffer,
+		.cascade_index = cascade_index,
+		.data.shadow = &system->geometry_buffer,
+	};
+
+	lodge_buffer_object_set(system->camera_buffer, 0, &pass_params.camera, sizeof(struct lodge_camera_params));
+
+	const struct lodge_recti rect = {
+		.x0 = 0,
+		.y0 = 0,
+		.x1 = (int32_t)system->shadow_map.width,
+		.y1 = (int32_t)system->shadow_map.height,
+	};
+
+	//
+	// Static casters, into the cache if it is stale.
+	//
+	struct lodge_render_system_pass *shadow_static_pass = &system->passes[LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW_STATIC];
+	if(shadow_static_pass->funcs_count > 0) {
+		lodge_framebuffer_t framebuffer_static = system->shadow_map.framebuffer_static;
+		lodge_framebuffer_set_depth_layer(framebuffer_static, system->shadow_map.depth_textures_array_static, cascade_index);
+
+		if(system->shadow_map_redraw[cascade_index]) {
+			lodge_framebuffer_bind(framebuffer_static);
+			lodge_gfx_set_viewport(0, 0, system->shadow_map.width, system->shadow_map.height);
+			lodge_gfx_set_scissor(0, 0, system->shadow_map.width, system->shadow_map.height);
+
+			lodge_framebuffer_clear_depth(framebuffer_static, LODGE_FRAMEBUFFER_DEPTH_DEFAULT);
+
+			for(size_t i = 0, count = shadow_static_pass->funcs_count; i < count; i++) {
+				shadow_static_pass->funcs[i](scene, &pass_params, shadow_static_pass->func_userdatas[i]);
+			}
+		}
+	}
+
 	lodge_framebuffer_t framebuffer = system->shadow_map.framebuffer;
 
 	// NOTE(TS): Needs to be done before bind?
@@ -899,23 +1659,19 @@ static void lodge_scene_render_system_render_shadow_map_cascade(struct lodge_sce
 	lodge_gfx_set_scissor(0, 0, system->shadow_map.width, system->shadow_map.height);
 
 	//lodge_framebuffer_clear_color(framebuffer, 0, vec4_make(0.33f, 0.33f, 0.33f, 1.0f));
-	lodge_framebuffer_clear_depth(framebuffer, LODGE_FRAMEBUFFER_DEPTH_DEFAULT);
+	if(shadow_static_pass->funcs_count > 0) {
+		lodge_framebuffer_copy(framebuffer, system->shadow_map.framebuffer_static, rect, rect);
+	} else {
+		lodge_framebuffer_clear_depth(framebuffer, LODGE_FRAMEBUFFER_DEPTH_DEFAULT);
+	}
 	lodge_framebuffer_clear_stencil(framebuffer, LODGE_FRAMEBUFFER_STENCIL_DEFAULT);
 
-	struct lodge_scene_render_pass_params pass_params = {
-		.pass = LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW,
-		.time = system->time,
-		.camera = lodge_camera_params_make_from_shadow_map_cascade(system, cascade_index),
-		.camera_buffer = system->camera_buffer,
-		.data.shadow = &system->geometry_buffer,
-	};
-
-	lodge_buffer_object_set(system->camera_buffer, 0, &pass_params.camera, sizeof(struct lodge_camera_params));
-
 	//
 	// Pass callbacks
 	//
 	{
+		pass_params.pass = LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW;
+
 		struct lodge_render_system_pass *shadow_pass = &system->passes[LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW];
 		for(size_t i = 0, count = shadow_pass->funcs_count; i < count; i++) {
 			shadow_pass->funcs[i](scene, &pass_params, shadow_pass->func_userdatas[i]);
@@ -1252,11 +2008,45 @@ static lodge_system_type_t lodge_scene_render_system_type_register(struct lodge_
 			}
 		);
 
+		lodge_type_t lodge_type_static_meshes_cascade = lodge_type_register_property_object(
+			strview("static_meshes_cascade"),
+			sizeof(struct lodge_static_meshes_cascade),
+			&(struct lodge_properties) {
+				.count = 4,
+				.elements = {
+					{
+						.name = strview("drawn"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_static_meshes_cascade, drawn),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY | LODGE_PROPERTY_FLAG_TRANSIENT,
+					},
+					{
+						.name = strview("culled"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_static_meshes_cascade, culled),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY | LODGE_PROPERTY_FLAG_TRANSIENT,
+					},
+					{
+						.name = strview("draw_calls"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_static_meshes_cascade, draw_calls),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY | LODGE_PROPERTY_FLAG_TRANSIENT,
+					},
+					{
+						.name = strview("state_changes"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_static_meshes_cascade, state_changes),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY | LODGE_PROPERTY_FLAG_TRANSIENT,
+					},
+				}
+			}
+		);
+
 		lodge_type_t lodge_type_static_meshes = lodge_type_register_property_object(
 			strview("static_meshes"),
 			sizeof(struct lodge_static_meshes),
 			&(struct lodge_properties) {
-				.count = 1,
+				.count = 10,
 				.elements = {
 					{
 						.name = strview("draw"),
@@ -1265,6 +2055,60 @@ static lodge_system_type_t lodge_scene_render_system_type_register(struct lodge_
 						.flags = LODGE_PROPERTY_FLAG_NONE,
 						.on_modified = NULL,
 					},
+					{
+						.name = strview("cull"),
+						.type = LODGE_TYPE_BOOL,
+						.offset = offsetof(struct lodge_static_meshes, cull),
+						.flags = LODGE_PROPERTY_FLAG_NONE,
+					},
+					{
+						.name = strview("drawn"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_static_meshes, drawn),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY | LODGE_PROPERTY_FLAG_TRANSIENT,
+					},
+					{
+						.name = strview("culled"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_static_meshes, culled),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY | LODGE_PROPERTY_FLAG_TRANSIENT,
+					},
+					{
+						.name = strview("instance"),
+						.type = LODGE_TYPE_BOOL,
+						.offset = offsetof(struct lodge_static_meshes, instance),
+						.flags = LODGE_PROPERTY_FLAG_NONE,
+					},
+					{
+						.name = strview("draw_calls"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_static_meshes, draw_calls),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY | LODGE_PROPERTY_FLAG_TRANSIENT,
+					},
+					{
+						.name = strview("state_changes"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_static_meshes, state_changes),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY | LODGE_PROPERTY_FLAG_TRANSIENT,
+					},
+					{
+						.name = strview("shadow_cascade_0"),
+						.type = lodge_type_static_meshes_cascade,
+						.offset = offsetof(struct lodge_static_meshes, shadow_cascades[0]),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY | LODGE_PROPERTY_FLAG_TRANSIENT,
+					},
+					{
+						.name = strview("shadow_cascade_1"),
+						.type = lodge_type_static_meshes_cascade,
+						.offset = offsetof(struct lodge_static_meshes, shadow_cascades[1]),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY | LODGE_PROPERTY_FLAG_TRANSIENT,
+					},
+					{
+						.name = strview("shadow_cascade_2"),
+						.type = lodge_type_static_meshes_cascade,
+						.offset = offsetof(struct lodge_static_meshes, shadow_cascades[2]),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY | LODGE_PROPERTY_FLAG_TRANSIENT,
+					},
 				}
 			}
 		);
@@ -1304,7 +2148,7 @@ static lodge_system_type_t lodge_scene_render_system_type_register(struct lodge_
 			.update = &lodge_scene_render_system_update,
 			.render = &lodge_scene_render_system_render,
 			.properties = {
-				.count = 14,
+				.count = 16,
 				.elements = {
 					{
 						.name = strview("draw_post_process"),
@@ -1372,6 +2216,18 @@ static lodge_system_type_t lodge_scene_render_system_type_register(struct lodge_
 						.offset = offsetof(struct lodge_scene_render_system, shadow_map_update),
 						.flags = LODGE_PROPERTY_FLAG_NONE,
 					},
+					{
+						.name = strview("shadow_map_cache"),
+						.type = LODGE_TYPE_BOOL,
+						.offset = offsetof(struct lodge_scene_render_system, shadow_map_cache),
+						.flags = LODGE_PROPERTY_FLAG_NONE,
+					},
+					{
+						.name = strview("shadow_map_cached"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_scene_render_system, shadow_map_cached),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY | LODGE_PROPERTY_FLAG_TRANSIENT,
+					},
 					{
 						.name = strview("distance_fog"),
 						.type = lodge_type_distance_fog,
@@ -1521,6 +2377,19 @@ void lodge_scene_remove_render_pass_func(lodge_scene_t scene, enum lodge_scene_r
 	}
 }
 
+void lodge_scene_invalidate_static_shadows(lodge_scene_t scene)
+{
+	ASSERT(scene);
+
+	struct lodge_scene_render_system *renderer = lodge_scene_get_system(scene, LODGE_SYSTEM_TYPE_SCENE_RENDER);
+	ASSERT(renderer);
+	if(!renderer) {
+		return;
+	}
+
+	lodge_shadow_map_cache_invalidate(&renderer->shadow_map);
+}
+
 void lodge_scene_set_active_camera(lodge_scene_t scene, lodge_entity_t camera_entity)
 {
 	ASSERT(scene);
@@ -1552,7 +2421,7 @@ lodge_entity_t lodge_scene_renderer_get_entity_at_screen_pos(struct lodge_scene_
 		return NULL;
 	}
 
-	return (lodge_entity_t)((uintptr_t)sample.r);
+	return lodge_scene_get_entity_by_id(renderer->scene, (uint32_t)sample.r);
 }
 
 LODGE_PLUGIN_IMPL(lodge_scene_renderer_plugin)
@@ -35,6 +35,7 @@ enum lodge_scene_render_system_pass
 	LODGE_SCENE_RENDER_SYSTEM_PASS_FORWARD,
 	LODGE_SCENE_RENDER_SYSTEM_PASS_FORWARD_TRANSPARENT,
 	LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW,
+	LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW_STATIC,		// Cached; see `lodge_scene_invalidate_static_shadows()`.
 	LODGE_SCENE_RENDER_SYSTEM_PASS_POST_PROCESS,
 	LODGE_SCENE_RENDER_SYSTEM_PASS_MAX,
 };
@@ -48,6 +49,8 @@ struct lodge_scene_render_pass_params
 	struct lodge_camera_params			camera;
 	lodge_buffer_object_t				camera_buffer;
 
+	uint32_t							cascade_index;		// In the shadow passes.
+
 	union
 	{
 		struct lodge_geometry_buffer	*shadow;
@@ -90,6 +93,12 @@ struct lodge_assets2*				lodge_scene_renderer_plugin_get_textures(struct lodge_s
 void								lodge_scene_add_render_pass_func(lodge_scene_t scene, enum lodge_scene_render_system_pass pass, lodge_scene_render_system_func_t func, void *userdata);
 void								lodge_scene_remove_render_pass_func(lodge_scene_t scene, enum lodge_scene_render_system_pass pass, lodge_scene_render_system_func_t func, void *userdata);
 
+//
+// Draws the static shadow casters again next frame, for when a `LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW_STATIC`
+// function has something new to draw.
+//
+void								lodge_scene_invalidate_static_shadows(lodge_scene_t scene);
+
 void								lodge_scene_set_active_camera(lodge_scene_t scene, lodge_entity_t camera_entity);
 lodge_entity_t						lodge_scene_renderer_get_entity_at_screen_pos(struct lodge_scene_render_system *renderer, vec2 screen_pos);
 
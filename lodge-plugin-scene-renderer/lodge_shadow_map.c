@@ -7,6 +7,8 @@
 #include "lodge_shader.h"
 #include "lodge_buffer_object.h"
 
+#include <string.h>
+
 void lodge_shadow_map_new_inplace(struct lodge_shadow_map *shadow_map, uint32_t width, uint32_t height, float z_near, float z_far)
 {
 	shadow_map->width = width;
@@ -40,6 +42,14 @@ void lodge_shadow_map_new_inplace(struct lodge_shadow_map *shadow_map, uint32_t
 		.stencil = NULL,
 		.depth = shadow_map->depth_textures_array
 	});
+
+	shadow_map->depth_textures_array_static = lodge_texture_2d_array_make_depth(width, height, LODGE_SHADOW_CASCADE_SPLITS_COUNT);
+	shadow_map->framebuffer_static = lodge_framebuffer_make(&(struct lodge_framebuffer_desc) {
+		.colors_count = 0,
+		.stencil = NULL,
+		.depth = shadow_map->depth_textures_array_static
+	});
+	lodge_shadow_map_cache_invalidate(shadow_map);
 }
 
 vec3 vec3_transform(const vec3 p, const mat4 *m)
@@ -126,4 +136,35 @@ void lodge_shadow_map_update(struct lodge_shadow_map *shadow_map, float dt, cons
 	}
 
 	lodge_buffer_object_set(shadow_map->buffer_object, 0, &shadow_map->buffer, sizeof(struct lodge_shadow_map_buffer));
-}
\ No newline at end of file
+}
+
+bool lodge_shadow_map_cache_update(struct lodge_shadow_map *shadow_map, uint32_t cascade_index, uint64_t casters_hash)
+{
+	ASSERT_OR(cascade_index < LODGE_SHADOW_CASCADE_SPLITS_COUNT) {
+		return true;
+	}
+
+	struct lodge_shadow_map_cache *cache = &shadow_map->caches[cascade_index];
+	const mat4 *view = &shadow_map->buffer.views[cascade_index];
+	const mat4 *projection = &shadow_map->buffer.projections[cascade_index];
+
+	if(cache->valid
+		&& cache->casters_hash == casters_hash
+		&& memcmp(&cache->view, view, sizeof(mat4)) == 0
+		&& memcmp(&cache->projection, projection, sizeof(mat4)) == 0) {
+		return false;
+	}
+
+	cache->valid = true;
+	cache->view = *view;
+	cache->projection = *projection;
+	cache->casters_hash = casters_hash;
+	return true;
+}
+
+void lodge_shadow_map_cache_invalidate(struct lodge_shadow_map *shadow_map)
+{
+	for(uint32_t cascade_index = 0; cascade_index < LODGE_SHADOW_CASCADE_SPLITS_COUNT; cascade_index++) {
+		shadow_map->caches[cascade_index].valid = false;
+	}
+}
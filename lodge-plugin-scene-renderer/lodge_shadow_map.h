@@ -27,6 +27,17 @@ struct lodge_shadow_map_buffer
 	vec4							cascade_splits_worldspace;
 };
 
+//
+// What the static casters of a cascade were last drawn with.
+//
+struct lodge_shadow_map_cache
+{
+	bool							valid;
+	mat4							view;
+	mat4							projection;
+	uint64_t						casters_hash;
+};
+
 struct lodge_shadow_map
 {
 	uint32_t						width;
@@ -38,6 +49,13 @@ struct lodge_shadow_map
 	struct lodge_shadow_map_buffer	buffer;
 	lodge_buffer_object_t			buffer_object;
 
+	//
+	// Static casters are drawn here and copied into `depth_textures_array` every frame, until
+	// their cascade moves or they change.
+	//
+	lodge_framebuffer_t				framebuffer_static;
+	lodge_texture_t					depth_textures_array_static;
+	struct lodge_shadow_map_cache	caches[LODGE_SHADOW_CASCADE_SPLITS_COUNT];
 };
 
 struct lodge_shadow_map_debug
@@ -54,4 +72,12 @@ struct lodge_shadow_map_debug
 void								lodge_shadow_map_new_inplace(struct lodge_shadow_map *shadow_map, uint32_t width, uint32_t height, float z_near, float z_far);
 void								lodge_shadow_map_update(struct lodge_shadow_map *shadow_map, float dt, const mat4 inv_view_proj, vec3 light_dir, struct lodge_shadow_map_debug debug_out[LODGE_SHADOW_CASCADE_SPLITS_COUNT]);
 
+//
+// Returns true if the static casters of `cascade_index` need to be drawn again, and assumes
+// they will be. `casters_hash` identifies what is in the cascade; the matrices are snapped to
+// texels, so they only change when the cascade moves by at least one.
+//
+bool								lodge_shadow_map_cache_update(struct lodge_shadow_map *shadow_map, uint32_t cascade_index, uint64_t casters_hash);
+void								lodge_shadow_map_cache_invalidate(struct lodge_shadow_map *shadow_map);
+
 #endif
\ No newline at end of file
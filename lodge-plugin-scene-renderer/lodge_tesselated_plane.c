@@ -4,24 +4,67 @@
 #include "dynbuf.h"
 #include "coordinate_systems.h"
 #include "gruvbox.h"
+#include "frustum.h"
 
 #include "lodge_quadtree.h"
 #include "lodge_assert.h"
 #include "lodge_debug_draw.h"
+#include "lodge_image_minmax.h"
 
-#include "lodge_plugin_scene_renderer.h" // for camera_params
+#include "lodge_camera_params.h"
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
+#include <float.h>
+
+//
+// Nodes merge again once they are this much smaller than when they were split.
+//
+#define LODGE_TESSELATED_PLANE_MERGE_FACTOR 0.9f
+
+struct lodge_tesselated_plane_inputs
+{
+	vec3								pos;
+	vec3								scale;
+	mat4								view_projection;
+	uint32_t							level_max;
+	float								lod_switch_distance;
+	const struct lodge_image_minmax		*heights;
+};
+
+//
+// Bounds of the heights under a quadtree node, cached by node index.
+//
+struct lodge_tesselated_plane_node
+{
+	struct aabb							bounds;
+	uint16_t							x;				// Of the node the bounds were made for.
+	uint16_t							y;
+	uint8_t								level;
+	bool								valid;
+};
 
 struct lodge_tesselated_plane
 {
 	struct lodge_tesselated_plane_chunk	*elements;
 	size_t								count;
 	size_t								capacity;
+
+	struct lodge_quadtree				tree;
+
+	struct
+	{
+		size_t							count;
+		size_t							capacity;
+		struct lodge_tesselated_plane_node *elements;
+	}									nodes;
+
+	struct lodge_tesselated_plane_inputs inputs;	// Of the last update.
+	bool								inputs_valid;
 };
 
-struct lodge_tesselated_plane_is_leaf_params
+struct lodge_tesselated_plane_update_params
 {
 	struct lodge_tesselated_plane		*plane;
 	vec3								pos;
@@ -29,6 +72,9 @@ struct lodge_tesselated_plane_is_leaf_params
 	const struct lodge_camera_params	*camera;
 	uint32_t							level_max;
 	float								lod_switch_distance;
+	const struct lodge_image_minmax		*heights;
+	struct frustum_planes				frustum;
+	float								fov_cot;
 	struct lodge_debug_draw				*debug_draw;
 };
 
@@ -37,6 +83,11 @@ void lodge_tesselated_plane_new_inplace(struct lodge_tesselated_plane *plane)
 	plane->count = 0;
 	plane->capacity = 32;
 	plane->elements = NULL;
+
+	lodge_quadtree_new_inplace(&plane->tree, (struct lodge_quadtree_desc) { 0 });
+	dynbuf_new_inplace(dynbuf(plane->nodes), 64);
+	memset(&plane->inputs, 0, sizeof(plane->inputs));
+	plane->inputs_valid = false;
 }
 
 void lodge_tesselated_plane_free_inplace(struct lodge_tesselated_plane *plane)
@@ -44,6 +95,16 @@ void lodge_tesselated_plane_free_inplace(struct lodge_tesselated_plane *plane)
 	if(plane->elements) {
 		free(plane->elements);
 	}
+	lodge_quadtree_free_inplace(&plane->tree);
+	dynbuf_free_inplace(dynbuf(plane->nodes));
+}
+
+void lodge_tesselated_plane_reset(struct lodge_tesselated_plane *plane)
+{
+	lodge_quadtree_reset(&plane->tree);
+	dynbuf_clear(dynbuf(plane->nodes));
+	plane->count = 0;
+	plane->inputs_valid = false;
 }
 
 size_t lodge_tesselated_plane_sizeof()
@@ -51,130 +112,168 @@ size_t lodge_tesselated_plane_sizeof()
 	return sizeof(struct lodge_tesselated_plane);
 }
 
-static bool lodge_tesselated_plane_is_leaf_impl(const uint32_t level, const vec2 center, const vec2 size, struct lodge_tesselated_plane_is_leaf_params *userdata)
+static struct aabb lodge_tesselated_plane_calc_bounds(const vec2 center, const vec2 size, struct lodge_tesselated_plane_update_params *userdata)
 {
-	if(level == 0) {
-		return false;
+	vec2 heights = vec2_make(0.0f, 1.0f);
+	if(userdata->heights) {
+		const vec2 uv_min = vec2_make(
+			(center.x - size.x / 2.0f - userdata->pos.x) / userdata->scale.x + 0.5f,
+			(center.y - size.y / 2.0f - userdata->pos.y) / userdata->scale.y + 0.5f
+		);
+		const vec2 uv_max = vec2_make(
+			uv_min.x + size.x / userdata->scale.x,
+			uv_min.y + size.y / userdata->scale.y
+		);
+		heights = lodge_image_minmax_get_01(userdata->heights, uv_min, uv_max);
 	}
 
-	if(level == userdata->level_max) {
-		return true;
-	}
+	return (struct aabb) {
+		.min = vec3_make(center.x - size.x / 2.0f, center.y - size.y / 2.0f, heights.x * userdata->scale.z),
+		.max = vec3_make(center.x + size.x / 2.0f, center.y + size.y / 2.0f, heights.y * userdata->scale.z),
+	};
+}
 
-#if 0
-	// vec3_negate(camera->pos)
-	if(camera->pos.x >= (center.x - size.x)
-		&& camera->pos.x <= (center.x + size.x)
-		&& camera->pos.y >= (center.y - size.y)
-		&& camera->pos.y <= (center.y + size.y)) {
-		return false;
+//
+// Looking the heights up is most of the cost of visiting a node, and the heights under a node
+// never change while it exists, so they are only looked up the first time it is visited.
+//
+static struct aabb lodge_tesselated_plane_get_bounds(const struct lodge_quadtree *tree, uint32_t node_index, struct lodge_tesselated_plane_update_params *userdata)
+{
+	struct lodge_tesselated_plane *plane = userdata->plane;
+	while(plane->nodes.count < tree->count) {
+		struct lodge_tesselated_plane_node *node = dynbuf_append_no_init(dynbuf(plane->nodes));
+		node->valid = false;
 	}
-#else
-
-#if 0
-	const vec3 center_v3 = vec3_make(center.x, center.y, 0.0f);
-	const vec3 size_half = vec3_make(size.x/2.0f, size.y/2.0f, userdata->scale.z/2.0f); // TODO(TS): account for scale
-	const vec3 p0 = vec3_add(center_v3, size_half);
-	const vec3 p1 = vec3_sub(center_v3, size_half);
 
-	// FIXME(TS): ndc vs clip?
+	const struct lodge_quadtree_node *tree_node = &tree->elements[node_index];
+	struct lodge_tesselated_plane_node *node = &plane->nodes.elements[node_index];
 
-	const vec3 p0_ndc_space = vec3_world_to_ndc_space(p0, &userdata->camera->view_projection);
-	const vec3 p1_ndc_space = vec3_world_to_ndc_space(p1, &userdata->camera->view_projection);
+	if(!node->valid || node->x != tree_node->x || node->y != tree_node->y || node->level != tree_node->level) {
+		*node = (struct lodge_tesselated_plane_node) {
+			.bounds = lodge_tesselated_plane_calc_bounds(lodge_quadtree_node_center(tree, tree_node), lodge_quadtree_node_size(tree, tree_node), userdata),
+			.x = tree_node->x,
+			.y = tree_node->y,
+			.level = tree_node->level,
+			.valid = true,
+		};
+	}
 
-	const bool in_clip = vec3_is_in_clip(p0_ndc_space) && vec3_is_in_clip(p1_ndc_space);
+	return node->bounds;
+}
 
-	// FIXME(TS): Not true, only for testing
-	//if(!in_clip) {
-	//	return true;
-	//}
+//
+// Projected size of the node in clip space, or negative outside the frustum.
+//
+static float lodge_tesselated_plane_metric(const struct lodge_quadtree *tree, uint32_t node_index, struct lodge_tesselated_plane_update_params *userdata)
+{
+	ASSERT(userdata);
 
-	//if(!vec3_is_in_clip(p0_clip_space) || vec3_is_in_clip(p1_clip_space)) {
-	{
-		const float clip_dist = vec3_distance(p0_ndc_space, p1_ndc_space);
+	const struct aabb bounds = lodge_tesselated_plane_get_bounds(tree, node_index, userdata);
+	if(!frustum_planes_vs_aabb(&userdata->frustum, bounds)) {
+		return -1.0f;
+	}
 
-		if(clip_dist >= userdata->lod_switch_distance) {
-			return false;
-		}
+	if(tree->elements[node_index].level == 0) {
+		return FLT_MAX;
 	}
-#else
 
+	//
 	// Neat approximation of projected sphere:
 	//
 	//		https://stackoverflow.com/questions/3717226/radius-of-projected-sphere
 	//
-
-	//
-	// FIXME(TS): take min/max height into consideration
+	// The sphere is around the heights under the node, not the node at z = 0.
 	//
-	const float fov_cot = 1.0f / tanf(userdata->camera->fov_y / 2.0f);
-	const float z = vec3_distance(userdata->camera->pos, vec3_make(center.x, center.y, 0.0f));
-	const float radius_worldspace = vec2_length(size);
-	const float radius_clipspace_approx = radius_worldspace * fov_cot / z;
-
-	if(radius_clipspace_approx*2.0f >= userdata->lod_switch_distance) {
-		if(userdata->debug_draw) {
-			lodge_debug_draw_sphere(
-				userdata->debug_draw,
-				(struct sphere) {
-					.pos = vec3_make(center.x, center.y, 0.0f),
-					.r = radius_worldspace
-				},
-				vec4_make(xyz_of(GRUVBOX_BRIGHT_YELLOW), 0.1f),
-				0.0f
-			);
-		}
-		return false;
+	const vec3 bounds_center = vec3_mult_scalar(vec3_add(bounds.min, bounds.max), 0.5f);
+	const float z = vec3_distance(userdata->camera->pos, bounds_center);
+	const float radius_worldspace = vec3_distance(bounds.min, bounds.max);
+	const float radius_clipspace_approx = radius_worldspace * userdata->fov_cot / z;
+
+	if(userdata->debug_draw && radius_clipspace_approx*2.0f >= userdata->lod_switch_distance) {
+		lodge_debug_draw_sphere(
+			userdata->debug_draw,
+			(struct sphere) {
+				.pos = bounds_center,
+				.r = radius_worldspace
+			},
+			vec4_make(xyz_of(GRUVBOX_BRIGHT_YELLOW), 0.1f),
+			0.0f
+		);
 	}
 
-#endif
-
-#endif
-
-	return true;
+	return radius_clipspace_approx*2.0f;
 }
 
-static bool lodge_tesselated_plane_is_leaf(const uint32_t level, const vec2 center, const vec2 size, struct lodge_tesselated_plane_is_leaf_params *userdata)
+static bool lodge_tesselated_plane_append_leaf(const struct lodge_quadtree *tree, uint32_t node_index, struct lodge_tesselated_plane_update_params *userdata)
 {
-	ASSERT(userdata);
-	
-	const bool is_leaf = lodge_tesselated_plane_is_leaf_impl(
-		level,
-		center,
-		size,
-		userdata
-	);
-
-	if(is_leaf) {
-		struct lodge_tesselated_plane_chunk *chunk = dynbuf_append_no_init(dynbuf_wrap(userdata->plane));
-
-		*chunk = (struct lodge_tesselated_plane_chunk) {
-			.lod = userdata->level_max - level,
-			.center = center,
-			.size = size,
-		};
+	const struct lodge_quadtree_node *node = &tree->elements[node_index];
+	if(!lodge_quadtree_node_is_leaf(node)) {
+		return true;
 	}
 
-	//
-	// If not leaf: split again.
-	//
-	return is_leaf;
+	struct lodge_tesselated_plane_chunk *chunk = dynbuf_append_no_init(dynbuf_wrap(userdata->plane));
+	*chunk = (struct lodge_tesselated_plane_chunk) {
+		.lod = userdata->level_max - node->level,
+		.center = lodge_quadtree_node_center(tree, node),
+		.size = lodge_quadtree_node_size(tree, node),
+		.visible = node->metric >= 0.0f,
+		.bounds = lodge_tesselated_plane_get_bounds(tree, node_index, userdata),
+	};
+	return false;
 }
 
-void lodge_tesselated_plane_update(struct lodge_tesselated_plane *plane, vec3 pos, vec3 scale, const struct lodge_camera_params *camera, uint32_t level_max, float lod_switch_distance, struct lodge_debug_draw *debug_draw)
+void lodge_tesselated_plane_update(struct lodge_tesselated_plane *plane, vec3 pos, vec3 scale, const struct lodge_camera_params *camera, uint32_t level_max, float lod_switch_distance, const struct lodge_image_minmax *heights, struct lodge_debug_draw *debug_draw)
 {
-	struct lodge_tesselated_plane_is_leaf_params params = {
+	//
+	// Several passes may share a camera; only update when something changed (debug drawing
+	// needs the traversal every time).
+	//
+	struct lodge_tesselated_plane_inputs inputs;
+	memset(&inputs, 0, sizeof(inputs));
+	inputs.pos = pos;
+	inputs.scale = scale;
+	inputs.view_projection = camera->view_projection;
+	inputs.level_max = level_max;
+	inputs.lod_switch_distance = lod_switch_distance;
+	inputs.heights = heights;
+
+	if(plane->inputs_valid && !debug_draw && memcmp(&plane->inputs, &inputs, sizeof(inputs)) == 0) {
+		return;
+	}
+
+	const struct lodge_quadtree_desc desc = {
+		.center = vec2_make(pos.x, pos.y),
+		.size = vec2_make(scale.x, scale.y),
+		.levels_max = level_max,
+		.split_threshold = lod_switch_distance,
+		.merge_threshold = lod_switch_distance * LODGE_TESSELATED_PLANE_MERGE_FACTOR,
+	};
+	if(memcmp(&plane->tree.desc, &desc, sizeof(desc)) != 0) {
+		lodge_quadtree_free_inplace(&plane->tree);
+		lodge_quadtree_new_inplace(&plane->tree, desc);
+		dynbuf_clear(dynbuf(plane->nodes));
+	} else if(!plane->inputs_valid || plane->inputs.heights != heights || plane->inputs.scale.z != scale.z) {
+		dynbuf_clear(dynbuf(plane->nodes));
+	}
+
+	plane->inputs = inputs;
+	plane->inputs_valid = true;
+
+	struct lodge_tesselated_plane_update_params params = {
 		.plane = plane,
 		.pos = pos,
 		.scale = scale,
 		.camera = camera,
 		.level_max = level_max,
 		.lod_switch_distance = lod_switch_distance,
+		.heights = heights,
+		.frustum = frustum_planes_make(camera->view_projection),
+		.fov_cot = 1.0f / tanf(camera->fov_y / 2.0f),
 		.debug_draw = debug_draw,
 	};
 
 	plane->count = 0;
-	lodge_quadtree_make(vec2_make(pos.x, pos.y), vec2_make(scale.x, scale.y), &lodge_tesselated_plane_is_leaf, &params);
+	lodge_quadtree_update(&plane->tree, &lodge_tesselated_plane_metric, &lodge_tesselated_plane_append_leaf, &params);
 }
 
 struct lodge_tesselated_plane_chunk* lodge_tesselated_plane_chunks_begin(struct lodge_tesselated_plane *plane)
@@ -2,9 +2,14 @@
 #define _LODGE_TESSELATED_PLANE_H
 
 #include "math4.h"
+#include "geometry.h"
+
+#include <stdbool.h>
 
 struct lodge_camera_params;
 
+struct lodge_image_minmax;
+
 struct lodge_tesselated_plane;
 
 struct lodge_debug_draw;
@@ -14,13 +19,29 @@ struct lodge_tesselated_plane_chunk
 	vec2								center;
 	vec2								size;
 	uint8_t								lod;
+	bool								visible;		// In the camera frustum it was selected for.
+	struct aabb							bounds;
 };
 
 void									lodge_tesselated_plane_new_inplace(struct lodge_tesselated_plane *plane);
 void									lodge_tesselated_plane_free_inplace(struct lodge_tesselated_plane *plane);
 size_t									lodge_tesselated_plane_sizeof();
 
-void									lodge_tesselated_plane_update(struct lodge_tesselated_plane *plane, vec3 pos, vec3 scale, const struct lodge_camera_params *camera, uint32_t level_max, float lod_switch_distance, struct lodge_debug_draw *debug);
+//
+// Forgets the quadtree and the node bounds of earlier updates. Call this when the heights were
+// rebuilt, since they are only compared by pointer.
+//
+void									lodge_tesselated_plane_reset(struct lodge_tesselated_plane *plane);
+
+//
+// Heights are `heights * scale.z`, on a plane at z = 0. Without `heights`, nodes are bounded by
+// the full height range. Nodes outside the camera frustum are not split further, and are kept
+// as chunks that are not `visible` (for shadow passes).
+//
+// The quadtree persists between updates, and nodes split and merge at slightly different sizes
+// so they do not pop back and forth. Updating again with the same camera does nothing.
+//
+void									lodge_tesselated_plane_update(struct lodge_tesselated_plane *plane, vec3 pos, vec3 scale, const struct lodge_camera_params *camera, uint32_t level_max, float lod_switch_distance, const struct lodge_image_minmax *heights, struct lodge_debug_draw *debug);
 
 struct lodge_tesselated_plane_chunk*	lodge_tesselated_plane_chunks_begin(struct lodge_tesselated_plane *plane);
 struct lodge_tesselated_plane_chunk*	lodge_tesselated_plane_chunks_end(struct lodge_tesselated_plane *plane);
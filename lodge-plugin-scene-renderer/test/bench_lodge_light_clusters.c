@@ -0,0 +1,87 @@
+//
+// CPU time of `lodge_light_clusters_update()` binning 1k to 10k point and spot lights
+// spread around a camera, with short and long ranges.
+//
+// Usage: bench_lodge_light_clusters [frames]
+//
+
+#include "lodge_light_clusters.h"
+#include "lodge_time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+static uint32_t bench_random_state = 1;
+
+static float bench_random(float lo, float hi)
+{
+	bench_random_state = bench_random_state * 1664525u + 1013904223u;
+	return lo + (hi - lo) * (float)(bench_random_state >> 8) / (float)(1u << 24);
+}
+
+int main(int argc, char **argv)
+{
+	const uint32_t frames = (argc > 1) ? (uint32_t)atoi(argv[1]) : 50;
+
+	const size_t lights_max = 10000;
+	struct lodge_light_clusters_light *lights = malloc(lights_max * sizeof(struct lodge_light_clusters_light));
+
+	struct lodge_light_clusters clusters;
+	lodge_light_clusters_new_inplace(&clusters, (struct lodge_light_clusters_desc) { .tiles_x = 16, .tiles_y = 9, .slices = 24 });
+
+	const mat4 view = mat4_lookat(vec3_make(3.0f, 5.0f, 7.0f), vec3_make(40.0f, 2.0f, -60.0f), vec3_make(0.0f, 1.0f, 0.0f));
+	const mat4 projection = mat4_perspective((float)radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+
+	const struct
+	{
+		float							range_min;
+		float							range_max;
+	} ranges[] = {
+		{ 1.0f, 10.0f },
+		{ 5.0f, 40.0f },
+	};
+
+	printf("16x9x24 clusters, %u frames\n", frames);
+
+	for(size_t lights_count = 1000; lights_count <= lights_max; lights_count += (lights_count < 5000) ? 4000 : 5000) {
+		for(size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+			bench_random_state = 1;
+			for(size_t i = 0; i < lights_count; i++) {
+				lights[i] = (struct lodge_light_clusters_light) {
+					.pos = vec3_make(bench_random(-200.0f, 200.0f), bench_random(-10.0f, 30.0f), bench_random(-400.0f, 100.0f)),
+					.range = bench_random(ranges[r].range_min, ranges[r].range_max),
+					.cone_direction = vec3_norm(vec3_make(bench_random(-1.0f, 1.0f), bench_random(-1.0f, 1.0f), bench_random(-1.0f, 1.0f))),
+					.cone_angle = (i % 3 == 0) ? bench_random(0.1f, 1.4f) : 0.0f,
+				};
+			}
+
+			// Warm up, and build the cluster bounds for the projection.
+			lodge_light_clusters_update(&clusters, &view, &projection, lights, lights_count, 0);
+
+			double total_ms = 0.0;
+			double worst_ms = 0.0;
+			for(uint32_t i = 0; i < frames; i++) {
+				const lodge_timestamp_t before = lodge_timestamp_get();
+				lodge_light_clusters_update(&clusters, &view, &projection, lights, lights_count, 0);
+				const double elapsed_ms = lodge_timestamp_elapsed_ms(before);
+				total_ms += elapsed_ms;
+				worst_ms = max(worst_ms, elapsed_ms);
+			}
+
+			printf("%5zu lights  range %4.1f-%4.1f  indices: %7zu  avg: %7.3f ms  worst: %7.3f ms\n",
+				lights_count,
+				ranges[r].range_min,
+				ranges[r].range_max,
+				clusters.indices_count,
+				total_ms / frames,
+				worst_ms
+			);
+		}
+	}
+
+	lodge_light_clusters_free_inplace(&clusters);
+	free(lights);
+
+	return 0;
+}
@@ -0,0 +1,323 @@
+//
+// Light cluster binning against a brute force check of every light against every
+// cluster's view space bounds and volume. No GPU involved.
+//
+
+#include "lodge_light_clusters.h"
+
+#include "lodge_test.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define TEST_TILES_X		16
+#define TEST_TILES_Y		9
+#define TEST_SLICES			24
+#define TEST_Z_NEAR			0.1f
+#define TEST_Z_FAR			500.0f
+
+static vec3 test_transform_point(const mat4 *m, vec3 p)
+{
+	return vec3_make(
+		m->m[0] * p.x + m->m[4] * p.y + m->m[8] * p.z + m->m[12],
+		m->m[1] * p.x + m->m[5] * p.y + m->m[9] * p.z + m->m[13],
+		m->m[2] * p.x + m->m[6] * p.y + m->m[10] * p.z + m->m[14]
+	);
+}
+
+//
+// View space corners of a cluster, straight from the frustum: tile edges in NDC scaled out
+// to the slice's near and far depths. Indexed `x + 2 * y + 4 * z`, 0 is low (near for z).
+//
+static void test_cluster_corners(const mat4 *projection, uint32_t x, uint32_t y, uint32_t slice, vec3 corners[8])
+{
+	const double depths[2] = {
+		TEST_Z_NEAR * pow(TEST_Z_FAR / TEST_Z_NEAR, (double)slice / TEST_SLICES),
+		TEST_Z_NEAR * pow(TEST_Z_FAR / TEST_Z_NEAR, (double)(slice + 1) / TEST_SLICES),
+	};
+	const double ndc_x[2] = { -1.0 + 2.0 * x / TEST_TILES_X, -1.0 + 2.0 * (x + 1) / TEST_TILES_X };
+	const double ndc_y[2] = { -1.0 + 2.0 * y / TEST_TILES_Y, -1.0 + 2.0 * (y + 1) / TEST_TILES_Y };
+
+	for(int i = 0; i < 8; i++) {
+		const double depth = depths[i >> 2];
+		corners[i] = vec3_make(
+			(float)(ndc_x[i & 1] * depth / projection->m[0]),
+			(float)(ndc_y[(i >> 1) & 1] * depth / projection->m[5]),
+			(float)-depth
+		);
+	}
+}
+
+static void test_cluster_bounds(const vec3 corners[8], vec3 *bounds_min, vec3 *bounds_max)
+{
+	*bounds_min = corners[0];
+	*bounds_max = corners[0];
+	for(int i = 1; i < 8; i++) {
+		*bounds_min = vec3_make(min(bounds_min->x, corners[i].x), min(bounds_min->y, corners[i].y), min(bounds_min->z, corners[i].z));
+		*bounds_max = vec3_make(max(bounds_max->x, corners[i].x), max(bounds_max->y, corners[i].y), max(bounds_max->z, corners[i].z));
+	}
+}
+
+//
+// Distance from `p` to the cluster itself (0 inside), as opposed to its bounding box.
+//
+static double test_distance_to_cluster(const mat4 *projection, const vec3 corners[8], vec3 p)
+{
+	const double depth = -p.z;
+	const double near = -corners[0].z;
+	const double far = -corners[4].z;
+	const double ndc_x = p.x * projection->m[0] / depth;
+	const double ndc_y = p.y * projection->m[5] / depth;
+	const double ndc_x0 = corners[0].x * projection->m[0] / near;
+	const double ndc_x1 = corners[1].x * projection->m[0] / near;
+	const double ndc_y0 = corners[0].y * projection->m[5] / near;
+	const double ndc_y1 = corners[2].y * projection->m[5] / near;
+	if(depth >= near && depth <= far && ndc_x >= ndc_x0 && ndc_x <= ndc_x1 && ndc_y >= ndc_y0 && ndc_y <= ndc_y1) {
+		return 0.0;
+	}
+
+	//
+	// Outside a convex cell, the closest point is on one of its six quads.
+	//
+	static const int faces[6][4] = {
+		{ 0, 1, 3, 2 }, { 4, 5, 7, 6 },		// Near, far.
+		{ 0, 2, 6, 4 }, { 1, 3, 7, 5 },		// Left, right.
+		{ 0, 1, 5, 4 }, { 2, 3, 7, 6 },		// Bottom, top.
+	};
+	double distance = INFINITY;
+	for(int i = 0; i < 6; i++) {
+		const vec3 a = corners[faces[i][0]];
+		const vec3 b = corners[faces[i][1]];
+		const vec3 c = corners[faces[i][2]];
+		const vec3 d = corners[faces[i][3]];
+		distance = fmin(distance, fmin(lodge_test_distance_to_triangle(p, a, b, c), lodge_test_distance_to_triangle(p, a, c, d)));
+	}
+	return distance;
+}
+
+static double test_distance_squared_to_bounds(vec3 p, vec3 bounds_min, vec3 bounds_max)
+{
+	const double dx = fmax(bounds_min.x - p.x, fmax(0.0, p.x - bounds_max.x));
+	const double dy = fmax(bounds_min.y - p.y, fmax(0.0, p.y - bounds_max.y));
+	const double dz = fmax(bounds_min.z - p.z, fmax(0.0, p.z - bounds_max.z));
+	return dx * dx + dy * dy + dz * dz;
+}
+
+static bool test_cluster_has(const struct lodge_light_clusters *clusters, size_t cluster_index, uint32_t light_index)
+{
+	const struct lodge_light_cluster *cluster = &clusters->clusters[cluster_index];
+	for(uint32_t i = 0; i < cluster->count; i++) {
+		if(clusters->indices[cluster->offset + i] == light_index) {
+			return true;
+		}
+	}
+	return false;
+}
+
+struct test_scene
+{
+	mat4								view;
+	mat4								projection;
+	struct lodge_light_clusters_light	*lights;
+	size_t								lights_count;
+};
+
+static struct test_scene test_scene_make(size_t lights_count, float cone_share)
+{
+	struct test_scene scene = {
+		.view = mat4_lookat(vec3_make(3.0f, 5.0f, 7.0f), vec3_make(40.0f, 2.0f, -60.0f), vec3_make(0.0f, 1.0f, 0.0f)),
+		.projection = mat4_perspective((float)radians(60.0f), 16.0f / 9.0f, TEST_Z_NEAR, TEST_Z_FAR),
+		.lights = malloc(lights_count * sizeof(struct lodge_light_clusters_light)),
+		.lights_count = lights_count,
+	};
+
+	for(size_t i = 0; i < lights_count; i++) {
+		const bool cone = lodge_test_random(0.0f, 1.0f) < cone_share;
+		scene.lights[i] = (struct lodge_light_clusters_light) {
+			.pos = vec3_make(lodge_test_random(-200.0f, 200.0f), lodge_test_random(-10.0f, 30.0f), lodge_test_random(-400.0f, 100.0f)),
+			.range = lodge_test_random(0.5f, 30.0f),
+			.cone_direction = vec3_norm(vec3_make(lodge_test_random(-1.0f, 1.0f), lodge_test_random(-1.0f, 1.0f), lodge_test_random(-1.0f, 1.0f))),
+			.cone_angle = cone ? lodge_test_random(0.1f, 1.4f) : 0.0f,
+		};
+	}
+	return scene;
+}
+
+static void test_scene_free(struct test_scene *scene)
+{
+	free(scene->lights);
+}
+
+//
+// Point lights: every cluster the sphere reaches has the light, and every cluster that has
+// it is reached by the sphere's bounding box test. Clusters within `epsilon` of the sphere
+// may go either way.
+//
+static void test_point_lights_match_brute_force()
+{
+	struct test_scene scene = test_scene_make(600, 0.0f);
+
+	struct lodge_light_clusters clusters;
+	lodge_light_clusters_new_inplace(&clusters, (struct lodge_light_clusters_desc) { TEST_TILES_X, TEST_TILES_Y, TEST_SLICES });
+
+	const uint32_t index_base = 7;
+	lodge_light_clusters_update(&clusters, &scene.view, &scene.projection, scene.lights, scene.lights_count, index_base);
+
+	LODGE_TEST_CHECK(fabsf(clusters.params.z_near - TEST_Z_NEAR) < 1.0e-4f);
+	LODGE_TEST_CHECK(fabsf(clusters.params.z_far - TEST_Z_FAR) < 0.5f);
+
+	size_t misses = 0, extras = 0, hits = 0;
+	for(uint32_t slice = 0; slice < TEST_SLICES; slice++) {
+		for(uint32_t y = 0; y < TEST_TILES_Y; y++) {
+			for(uint32_t x = 0; x < TEST_TILES_X; x++) {
+				const size_t cluster_index = x + (size_t)y * TEST_TILES_X + (size_t)slice * TEST_TILES_X * TEST_TILES_Y;
+
+				vec3 corners[8], bounds_min, bounds_max;
+				test_cluster_corners(&scene.projection, x, y, slice, corners);
+				test_cluster_bounds(corners, &bounds_min, &bounds_max);
+
+				for(size_t i = 0; i < scene.lights_count; i++) {
+					const struct lodge_light_clusters_light *light = &scene.lights[i];
+					const vec3 p = test_transform_point(&scene.view, light->pos);
+					const double epsilon = 1.0e-3 * light->range + 1.0e-3;
+					const bool has = test_cluster_has(&clusters, cluster_index, index_base + (uint32_t)i);
+
+					if(has && test_distance_squared_to_bounds(p, bounds_min, bounds_max) > (light->range + epsilon) * (light->range + epsilon)) {
+						extras++;
+					}
+					if(test_distance_to_cluster(&scene.projection, corners, p) <= light->range - epsilon) {
+						misses += !has;
+						hits += has;
+					}
+				}
+			}
+		}
+	}
+
+	LODGE_TEST_CHECK_MSG(hits > 1000, "only %zu hits, the scene does not exercise the binning", hits);
+	LODGE_TEST_CHECK_MSG(misses == 0, "%zu missing of %zu", misses, hits + misses);
+	LODGE_TEST_CHECK_MSG(extras == 0, "%zu assigned out of range", extras);
+
+	lodge_light_clusters_free_inplace(&clusters);
+	test_scene_free(&scene);
+}
+
+//
+// Spot lights are only ever assigned where their sphere reaches, and every point lit by a
+// cone is found in its cluster.
+//
+static void test_spot_lights_conservative()
+{
+	struct test_scene scene = test_scene_make(400, 1.0f);
+
+	struct lodge_light_clusters clusters;
+	lodge_light_clusters_new_inplace(&clusters, (struct lodge_light_clusters_desc) { TEST_TILES_X, TEST_TILES_Y, TEST_SLICES });
+	lodge_light_clusters_update(&clusters, &scene.view, &scene.projection, scene.lights, scene.lights_count, 0);
+
+	size_t extras = 0;
+	for(uint32_t slice = 0; slice < TEST_SLICES; slice++) {
+		for(uint32_t y = 0; y < TEST_TILES_Y; y++) {
+			for(uint32_t x = 0; x < TEST_TILES_X; x++) {
+				const size_t cluster_index = x + (size_t)y * TEST_TILES_X + (size_t)slice * TEST_TILES_X * TEST_TILES_Y;
+				const struct lodge_light_cluster *cluster = &clusters.clusters[cluster_index];
+
+				vec3 corners[8], bounds_min, bounds_max;
+				test_cluster_corners(&scene.projection, x, y, slice, corners);
+				test_cluster_bounds(corners, &bounds_min, &bounds_max);
+
+				for(uint32_t i = 0; i < cluster->count; i++) {
+					const struct lodge_light_clusters_light *light = &scene.lights[clusters.indices[cluster->offset + i]];
+					const vec3 p = test_transform_point(&scene.view, light->pos);
+					const double epsilon = 1.0e-3 * light->range + 1.0e-3;
+					extras += test_distance_squared_to_bounds(p, bounds_min, bounds_max) > (light->range + epsilon) * (light->range + epsilon);
+				}
+			}
+		}
+	}
+	LODGE_TEST_CHECK_MSG(extras == 0, "%zu assigned out of range", extras);
+
+	//
+	// Random points in the frustum, checked against every cone that lights them.
+	//
+	const mat4 inv_view = mat4_inverse(scene.view, NULL);
+	size_t misses = 0, checks = 0;
+	for(int s = 0; s < 20000; s++) {
+		const float ndc_x = lodge_test_random(-0.999f, 0.999f);
+		const float ndc_y = lodge_test_random(-0.999f, 0.999f);
+		const float depth = expf(lodge_test_random(logf(TEST_Z_NEAR * 1.001f), logf(TEST_Z_FAR * 0.999f)));
+		const vec3 p_view = vec3_make(ndc_x * depth / scene.projection.m[0], ndc_y * depth / scene.projection.m[5], -depth);
+		const vec3 p_world = test_transform_point(&inv_view, p_view);
+
+		const uint32_t x = (uint32_t)((ndc_x * 0.5f + 0.5f) * TEST_TILES_X);
+		const uint32_t y = (uint32_t)((ndc_y * 0.5f + 0.5f) * TEST_TILES_Y);
+		const uint32_t slice = (uint32_t)(log(depth / TEST_Z_NEAR) / log(TEST_Z_FAR / TEST_Z_NEAR) * TEST_SLICES);
+		if(slice >= TEST_SLICES) {
+			continue;
+		}
+		const size_t cluster_index = x + (size_t)y * TEST_TILES_X + (size_t)slice * TEST_TILES_X * TEST_TILES_Y;
+
+		for(size_t i = 0; i < scene.lights_count; i++) {
+			const struct lodge_light_clusters_light *light = &scene.lights[i];
+			const vec3 to_point = vec3_sub(p_world, light->pos);
+			const float distance = vec3_length(to_point);
+			if(distance > light->range * 0.999f || distance < 1.0e-3f) {
+				continue;
+			}
+			if(acosf(vec3_dot(vec3_mult_scalar(to_point, 1.0f / distance), light->cone_direction)) > light->cone_angle * 0.999f) {
+				continue;
+			}
+			checks++;
+			misses += !test_cluster_has(&clusters, cluster_index, (uint32_t)i);
+		}
+	}
+	LODGE_TEST_CHECK_MSG(checks > 100, "only %zu lit points", checks);
+	LODGE_TEST_CHECK_MSG(misses == 0, "%zu of %zu lit points missing their light", misses, checks);
+
+	lodge_light_clusters_free_inplace(&clusters);
+	test_scene_free(&scene);
+}
+
+//
+// Lists are in light order, add up to `indices_count`, and are empty without lights.
+//
+static void test_cluster_lists()
+{
+	struct test_scene scene = test_scene_make(300, 0.3f);
+
+	struct lodge_light_clusters clusters;
+	lodge_light_clusters_new_inplace(&clusters, (struct lodge_light_clusters_desc) { TEST_TILES_X, TEST_TILES_Y, TEST_SLICES });
+	lodge_light_clusters_update(&clusters, &scene.view, &scene.projection, scene.lights, scene.lights_count, 0);
+
+	size_t total = 0;
+	bool ordered = true;
+	for(size_t i = 0; i < clusters.clusters_count; i++) {
+		const struct lodge_light_cluster *cluster = &clusters.clusters[i];
+		ordered &= cluster->offset == total;
+		for(uint32_t j = 1; j < cluster->count; j++) {
+			ordered &= clusters.indices[cluster->offset + j - 1] < clusters.indices[cluster->offset + j];
+		}
+		total += cluster->count;
+	}
+	LODGE_TEST_CHECK(ordered);
+	LODGE_TEST_CHECK(total == clusters.indices_count);
+
+	lodge_light_clusters_update(&clusters, &scene.view, &scene.projection, scene.lights, 0, 0);
+	LODGE_TEST_CHECK(clusters.indices_count == 0);
+	bool empty = true;
+	for(size_t i = 0; i < clusters.clusters_count; i++) {
+		empty &= clusters.clusters[i].count == 0;
+	}
+	LODGE_TEST_CHECK(empty);
+
+	lodge_light_clusters_free_inplace(&clusters);
+	test_scene_free(&scene);
+}
+
+int main(int argc, char **argv)
+{
+	LODGE_TEST_RUN(test_point_lights_match_brute_force);
+	LODGE_TEST_RUN(test_spot_lights_conservative);
+	LODGE_TEST_RUN(test_cluster_lists);
+	return lodge_test_result();
+}
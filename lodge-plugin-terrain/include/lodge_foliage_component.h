@@ -6,9 +6,14 @@
 struct lodge_component_type;
 typedef struct lodge_component_type* lodge_component_type_t;
 
+struct lodge_jobs;
+
 extern lodge_component_type_t LODGE_COMPONENT_TYPE_FOLIAGE;
 
-lodge_component_type_t lodge_foliage_component_type_register();
+//
+// Foliage cells are generated on `jobs` (inline if NULL).
+//
+lodge_component_type_t lodge_foliage_component_type_register(struct lodge_jobs *jobs);
 
 /// FOLIAGE SYSTEM
 
@@ -42,10 +47,14 @@ struct lodge_foliage_component;
 
 struct lodge_assets2;
 
+//
+// One mesh asset per LOD, or a single one to use the LODs generated on import.
+//
 struct lodge_foliage_lods_desc
 {
 	size_t			count;
 	lodge_asset_t	elements[LODGE_FOLIAGE_LODS_MAX];
+	float			distances[LODGE_FOLIAGE_LODS_MAX];	// Object space; only used with one asset per LOD.
 };
 
 void				lodge_foliage_component_render(struct lodge_foliage_component *foliage, const struct lodge_scene_render_pass_params *pass_params, lodge_shader_t shader, lodge_sampler_t heightfield_sampler, lodge_texture_t heightfield, struct lodge_terrain_component *terrain, lodge_entity_t owner, vec3 terrain_scale);
@@ -5,6 +5,7 @@
 
 struct lodge_plugin_debug_draw;
 struct lodge_assets2;
+struct lodge_jobs;
 
 struct lodge_component_type;
 typedef struct lodge_component_type* lodge_component_type_t;
@@ -26,11 +27,14 @@ struct lodge_plugin_terrain
 {
 	struct lodge_assets2			*shaders;
 	struct lodge_assets2			*textures;
+	struct lodge_assets2			*images;
 	void							*plugin_scene_renderer;
 	
 	struct lodge_plugin_debug_draw	*plugin_debug_draw;
 	struct lodge_editor				*plugin_editor;
 
+	struct lodge_jobs				*jobs;
+
 	struct lodge_terrain_types		types;
 };
 
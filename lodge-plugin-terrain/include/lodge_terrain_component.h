@@ -18,6 +18,8 @@ typedef struct lodge_asset* lodge_asset_t;
 struct lodge_type;
 typedef struct lodge_type* lodge_type_t;
 
+struct lodge_image_minmax;
+
 struct lodge_static_material
 {
 	lodge_asset_t					albedo;
@@ -31,6 +33,7 @@ struct lodge_terrain_chunk
 	vec2							offset;
 	vec3							world_offset;
 	vec3							world_size;
+	struct aabb						bounds;			// Of the heights in the chunk.
 	bool							visible;
 	float							lod;
 };
@@ -47,6 +50,12 @@ struct lodge_terrain_component
 	struct lodge_terrain_chunk		*chunks;
 
 	struct lodge_tesselated_plane	*plane;
+
+	//
+	// Built from the `heightmap` image when it has loaded, NULL until then.
+	//
+	struct lodge_image_minmax		*heights;
+	lodge_asset_t					heights_heightmap;
 };
 
 extern lodge_component_type_t		LODGE_COMPONENT_TYPE_TERRAIN;
@@ -0,0 +1,335 @@
+#include "lodge_foliage_cells.h"
+
+#include "dynbuf.h"
+#include "lodge_assert.h"
+#include "lodge_thread.h"
+#include "lodge_noise.h"
+#include "lodge_hash.h"
+#include "lodge_time.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//
+// How far instances may be nudged off their candidate position, in terrain space.
+//
+#define LODGE_FOLIAGE_CELLS_JITTER 0.01f
+
+//
+// Candidates per call to the batch noise.
+//
+#define LODGE_FOLIAGE_CELLS_NOISE_BATCH 64
+
+static uint32_t lodge_foliage_cells_grid_size(const struct lodge_foliage_cells_desc *desc)
+{
+	return desc->cells_per_axis * desc->cells_per_axis;
+}
+
+//
+// First candidate index along an axis in cell `cell`; neighbours evaluate the exact same
+// expression for their shared edge, so every candidate ends up in one cell only.
+//
+static uint32_t lodge_foliage_cells_candidate_begin(const struct lodge_foliage_cells_desc *desc, uint32_t cell)
+{
+	return (uint32_t)ceilf((float)cell * desc->axis_divisor / (float)desc->cells_per_axis);
+}
+
+static uint32_t lodge_foliage_cells_candidate_end(const struct lodge_foliage_cells_desc *desc, uint32_t cell)
+{
+	//
+	// The last cell includes the candidates on the far edge (at 1.0).
+	//
+	return cell + 1 < desc->cells_per_axis
+		? lodge_foliage_cells_candidate_begin(desc, cell + 1)
+		: (uint32_t)floorf(desc->axis_divisor) + 1;
+}
+
+static uint32_t lodge_foliage_cells_xorshift32(uint32_t *state)
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+void lodge_foliage_cell_generate(struct lodge_foliage_cell *cell)
+{
+	const lodge_timestamp_t before = lodge_timestamp_get();
+	const struct lodge_foliage_cells_desc *desc = &cell->desc;
+
+	struct
+	{
+		size_t		count;
+		size_t		capacity;
+		vec4		*elements;
+	} instances;
+	dynbuf_new_inplace(dynbuf(instances), 64);
+
+	if(desc->axis_divisor > 0.0f) {
+		const float step_size = 1.0f / desc->axis_divisor;
+
+		float u[LODGE_FOLIAGE_CELLS_NOISE_BATCH];
+		float v[LODGE_FOLIAGE_CELLS_NOISE_BATCH];
+		float noise[LODGE_FOLIAGE_CELLS_NOISE_BATCH];
+
+		const uint32_t x_begin = lodge_foliage_cells_candidate_begin(desc, cell->x);
+		const uint32_t x_end = lodge_foliage_cells_candidate_end(desc, cell->x);
+
+		for(uint32_t y = lodge_foliage_cells_candidate_begin(desc, cell->y), y_end = lodge_foliage_cells_candidate_end(desc, cell->y); y < y_end; y++) {
+			for(uint32_t x = x_begin; x < x_end; x += LODGE_FOLIAGE_CELLS_NOISE_BATCH) {
+				const uint32_t count = min(x_end - x, LODGE_FOLIAGE_CELLS_NOISE_BATCH);
+				for(uint32_t i = 0; i < count; i++) {
+					u[i] = (x + i) * step_size;
+					v[i] = y * step_size;
+				}
+				lodge_noise_simplex_2d_n(noise, u, v, count);
+
+				for(uint32_t i = 0; i < count; i++) {
+					if(noise[i] >= desc->threshold) {
+						vec4 *element = dynbuf_append_no_init(dynbuf(instances));
+
+						element->x = u[i] + clamp(noise[i], -LODGE_FOLIAGE_CELLS_JITTER, LODGE_FOLIAGE_CELLS_JITTER);
+						element->y = v[i] + clamp(noise[i], -LODGE_FOLIAGE_CELLS_JITTER, LODGE_FOLIAGE_CELLS_JITTER);
+						element->z = 0.0f;
+						element->w = 1.0f + noise[i] * 10;
+					}
+				}
+			}
+		}
+	}
+
+	//
+	// Shuffle, seeded by the cell, so any prefix is an even subsample.
+	//
+	const uint32_t key[] = { cell->x, cell->y, desc->seed };
+	uint32_t state = lodge_hash_murmur3_32(key, sizeof(key)) | 1;
+
+	for(size_t i = instances.count; i > 1; i--) {
+		const size_t j = lodge_foliage_cells_xorshift32(&state) % i;
+		const vec4 tmp = instances.elements[i - 1];
+		instances.elements[i - 1] = instances.elements[j];
+		instances.elements[j] = tmp;
+	}
+
+	cell->instances = instances.elements;
+	cell->instances_count = (uint32_t)instances.count;
+	cell->generate_ms = (float)lodge_timestamp_elapsed_ms(before);
+
+	lodge_atomic_store_i32(&cell->state, LODGE_FOLIAGE_CELL_STATE_READY);
+}
+
+static bool lodge_foliage_cell_is_ready(const struct lodge_foliage_cell *cell)
+{
+	return lodge_atomic_load_i32((volatile int32_t *)&cell->state) == LODGE_FOLIAGE_CELL_STATE_READY;
+}
+
+static uint32_t lodge_foliage_cell_get_memory(const struct lodge_foliage_cell *cell)
+{
+	return (uint32_t)(sizeof(struct lodge_foliage_cell) + cell->instances_count * sizeof(vec4));
+}
+
+static void lodge_foliage_cell_free(struct lodge_foliage_cell *cell)
+{
+	free(cell->instances);
+	free(cell);
+}
+
+void lodge_foliage_cells_new_inplace(struct lodge_foliage_cells *cells, struct lodge_foliage_cells_desc desc, struct lodge_jobs *jobs)
+{
+	memset(cells, 0, sizeof(struct lodge_foliage_cells));
+
+	cells->jobs = jobs;
+	dynbuf_new_inplace(dynbuf(cells->resident), 64);
+	dynbuf_new_inplace(dynbuf(cells->candidates), 64);
+
+	lodge_foliage_cells_reset(cells, desc);
+}
+
+void lodge_foliage_cells_free_inplace(struct lodge_foliage_cells *cells)
+{
+	lodge_foliage_cells_reset(cells, (struct lodge_foliage_cells_desc) { 0 });
+
+	free(cells->grid);
+	dynbuf_free_inplace(dynbuf(cells->resident));
+	dynbuf_free_inplace(dynbuf(cells->candidates));
+}
+
+void lodge_foliage_cells_reset(struct lodge_foliage_cells *cells, struct lodge_foliage_cells_desc desc)
+{
+	lodge_jobs_wait(cells->jobs, &cells->pending);
+
+	for(size_t i = 0; i < cells->resident.count; i++) {
+		lodge_foliage_cell_free(cells->resident.elements[i]);
+	}
+	dynbuf_clear(dynbuf(cells->resident));
+
+	if(lodge_foliage_cells_grid_size(&desc) != lodge_foliage_cells_grid_size(&cells->desc)) {
+		free(cells->grid);
+		cells->grid = NULL;
+	}
+	cells->desc = desc;
+
+	const uint32_t grid_size = lodge_foliage_cells_grid_size(&desc);
+	if(grid_size > 0) {
+		if(!cells->grid) {
+			cells->grid = malloc(grid_size * sizeof(struct lodge_foliage_cell *));
+		}
+		memset(cells->grid, 0, grid_size * sizeof(struct lodge_foliage_cell *));
+	}
+
+	memset(&cells->stats, 0, sizeof(struct lodge_foliage_cells_stats));
+}
+
+static int lodge_foliage_cells_candidate_compare(const struct lodge_foliage_cells_candidate *lhs, const struct lodge_foliage_cells_candidate *rhs)
+{
+	return (lhs->distance > rhs->distance) - (lhs->distance < rhs->distance);
+}
+
+static void lodge_foliage_cells_request(struct lodge_foliage_cells *cells, uint32_t x, uint32_t y)
+{
+	struct lodge_foliage_cell *cell = calloc(1, sizeof(struct lodge_foliage_cell));
+	ASSERT_OR(cell) { return; }
+
+	cell->state = LODGE_FOLIAGE_CELL_STATE_PENDING;
+	cell->x = x;
+	cell->y = y;
+	cell->last_requested = cells->tick;
+	cell->desc = cells->desc;
+
+	cells->grid[x + y * cells->desc.cells_per_axis] = cell;
+	dynbuf_append(dynbuf(cells->resident), &cell, sizeof(cell));
+
+	lodge_jobs_submit(cells->jobs, (lodge_job_func_t)&lodge_foliage_cell_generate, cell, &cells->pending);
+}
+
+void lodge_foliage_cells_update(struct lodge_foliage_cells *cells, vec2 center, float radius, size_t memory_budget)
+{
+	const uint32_t cells_per_axis = cells->desc.cells_per_axis;
+	if(cells_per_axis == 0) {
+		return;
+	}
+
+	cells->tick++;
+
+	struct lodge_foliage_cells_stats *stats = &cells->stats;
+	memset(stats, 0, sizeof(struct lodge_foliage_cells_stats));
+
+	//
+	// Collect the cells that finished since the last update.
+	//
+	for(size_t i = 0; i < cells->resident.count; i++) {
+		struct lodge_foliage_cell *cell = cells->resident.elements[i];
+
+		if(!lodge_foliage_cell_is_ready(cell)) {
+			stats->cells_pending++;
+			continue;
+		}
+
+		if(!cell->collected) {
+			cell->collected = true;
+			stats->cells_generated++;
+			stats->generate_ms += cell->generate_ms;
+		}
+		stats->memory += lodge_foliage_cell_get_memory(cell);
+	}
+
+	//
+	// Request the cells overlapping the circle, nearest first.
+	//
+	const float cell_size = 1.0f / cells_per_axis;
+	const uint32_t x_min = (uint32_t)clamp(floorf((center.x - radius) / cell_size), 0.0f, (float)(cells_per_axis - 1));
+	const uint32_t x_max = (uint32_t)clamp(floorf((center.x + radius) / cell_size), 0.0f, (float)(cells_per_axis - 1));
+	const uint32_t y_min = (uint32_t)clamp(floorf((center.y - radius) / cell_size), 0.0f, (float)(cells_per_axis - 1));
+	const uint32_t y_max = (uint32_t)clamp(floorf((center.y + radius) / cell_size), 0.0f, (float)(cells_per_axis - 1));
+
+	dynbuf_clear(dynbuf(cells->candidates));
+	if(radius > 0.0f) {
+		for(uint32_t y = y_min; y <= y_max; y++) {
+			for(uint32_t x = x_min; x <= x_max; x++) {
+				const float dx = max(max(x * cell_size - center.x, center.x - (x + 1) * cell_size), 0.0f);
+				const float dy = max(max(y * cell_size - center.y, center.y - (y + 1) * cell_size), 0.0f);
+				const float distance = sqrtf(dx * dx + dy * dy);
+
+				if(distance <= radius) {
+					struct lodge_foliage_cells_candidate *candidate = dynbuf_append_no_init(dynbuf(cells->candidates));
+					*candidate = (struct lodge_foliage_cells_candidate) {
+						.distance = distance,
+						.x = x,
+						.y = y,
+					};
+				}
+			}
+		}
+	}
+
+	qsort(cells->candidates.elements, cells->candidates.count, sizeof(struct lodge_foliage_cells_candidate), (int (*)(const void *, const void *))&lodge_foliage_cells_candidate_compare);
+
+	for(size_t i = 0; i < cells->candidates.count; i++) {
+		const struct lodge_foliage_cells_candidate *candidate = &cells->candidates.elements[i];
+		struct lodge_foliage_cell *cell = cells->grid[candidate->x + candidate->y * cells_per_axis];
+
+		if(cell) {
+			cell->last_requested = cells->tick;
+		} else if(stats->memory < memory_budget) {
+			lodge_foliage_cells_request(cells, candidate->x, candidate->y);
+
+			//
+			// Without worker threads, the cell is generated right away.
+			//
+			cell = cells->grid[candidate->x + candidate->y * cells_per_axis];
+			if(lodge_foliage_cell_is_ready(cell)) {
+				cell->collected = true;
+				stats->cells_generated++;
+				stats->generate_ms += cell->generate_ms;
+				stats->memory += lodge_foliage_cell_get_memory(cell);
+			} else {
+				stats->cells_pending++;
+			}
+		}
+	}
+
+	//
+	// Evict the least recently requested cells until the budget holds. Pending cells belong
+	// to a job, so they stay until they are done.
+	//
+	while(stats->memory > memory_budget) {
+		size_t lru_index = SIZE_MAX;
+		for(size_t i = 0; i < cells->resident.count; i++) {
+			const struct lodge_foliage_cell *cell = cells->resident.elements[i];
+			if(cell->last_requested != cells->tick
+				&& lodge_foliage_cell_is_ready(cell)
+				&& (lru_index == SIZE_MAX || cell->last_requested < cells->resident.elements[lru_index]->last_requested)) {
+				lru_index = i;
+			}
+		}
+
+		if(lru_index == SIZE_MAX) {
+			break;
+		}
+
+		struct lodge_foliage_cell *cell = cells->resident.elements[lru_index];
+		stats->memory -= lodge_foliage_cell_get_memory(cell);
+		stats->cells_evicted++;
+
+		cells->grid[cell->x + cell->y * cells_per_axis] = NULL;
+		cells->resident.elements[lru_index] = cells->resident.elements[cells->resident.count - 1];
+		cells->resident.count--;
+
+		lodge_foliage_cell_free(cell);
+	}
+
+	stats->cells_count = (uint32_t)cells->resident.count;
+	for(size_t i = 0; i < cells->resident.count; i++) {
+		const struct lodge_foliage_cell *cell = cells->resident.elements[i];
+		if(cell->collected) {
+			stats->instances_count += cell->instances_count;
+		}
+	}
+}
+
+bool lodge_foliage_cells_is_active(const struct lodge_foliage_cells *cells, const struct lodge_foliage_cell *cell)
+{
+	return cell->collected && cell->last_requested == cells->tick;
+}
@@ -0,0 +1,126 @@
+#ifndef _LODGE_FOLIAGE_CELLS_H
+#define _LODGE_FOLIAGE_CELLS_H
+
+#include "math4.h"
+#include "lodge_jobs.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+//
+// Foliage instances, generated on demand in cells around the camera.
+//
+// The terrain (unit square) is split in `cells_per_axis`^2 cells. Each cell is generated on a
+// job from its coordinates and `seed` only, so a cell that is evicted and generated again
+// comes back the same. Cells that were not requested for the longest are evicted first once
+// the instances take more memory than the budget.
+//
+// Nothing here touches the GPU.
+//
+struct lodge_foliage_cells_desc
+{
+	uint32_t					cells_per_axis;
+	float						axis_divisor;		// Candidate positions per axis, over the whole terrain.
+	float						threshold;			// Noise needed for a candidate to get an instance.
+	uint32_t					seed;
+};
+
+enum lodge_foliage_cell_state
+{
+	LODGE_FOLIAGE_CELL_STATE_PENDING = 0,
+	LODGE_FOLIAGE_CELL_STATE_READY,
+};
+
+struct lodge_foliage_cell
+{
+	volatile int32_t			state;				// enum lodge_foliage_cell_state, written by the job.
+	uint32_t					x;
+	uint32_t					y;
+	uint32_t					last_requested;		// Update tick.
+	struct lodge_foliage_cells_desc desc;
+
+	//
+	// Terrain space x, y, z, uniform_scale; in random order, so the first N are an even
+	// subsample of the cell.
+	//
+	vec4						*instances;
+	uint32_t					instances_count;
+	float						generate_ms;
+
+	bool						collected;			// Counted as generated in an update.
+};
+
+struct lodge_foliage_cells_candidate
+{
+	float						distance;
+	uint32_t					x;
+	uint32_t					y;
+};
+
+struct lodge_foliage_cells_stats
+{
+	uint32_t					cells_count;		// Resident, including pending.
+	uint32_t					cells_pending;
+	uint32_t					cells_generated;	// Finished since the last update.
+	uint32_t					cells_evicted;		// In the last update.
+	uint32_t					instances_count;	// In ready cells.
+	uint32_t					memory;				// Bytes, in ready cells.
+	float						generate_ms;		// Worker time of `cells_generated`.
+};
+
+struct lodge_foliage_cells
+{
+	struct lodge_foliage_cells_desc desc;
+	struct lodge_jobs			*jobs;
+	struct lodge_job_counter	pending;
+	uint32_t					tick;
+
+	//
+	// `cells_per_axis`^2, NULL where no cell is resident.
+	//
+	struct lodge_foliage_cell	**grid;
+
+	struct
+	{
+		size_t					count;
+		size_t					capacity;
+		struct lodge_foliage_cell **elements;
+	}							resident;
+
+	struct
+	{
+		size_t					count;
+		size_t					capacity;
+		struct lodge_foliage_cells_candidate *elements;
+	}							candidates;
+
+	struct lodge_foliage_cells_stats stats;
+};
+
+void							lodge_foliage_cells_new_inplace(struct lodge_foliage_cells *cells, struct lodge_foliage_cells_desc desc, struct lodge_jobs *jobs);
+void							lodge_foliage_cells_free_inplace(struct lodge_foliage_cells *cells);
+
+//
+// Waits for pending cells and drops all of them.
+//
+void							lodge_foliage_cells_reset(struct lodge_foliage_cells *cells, struct lodge_foliage_cells_desc desc);
+
+//
+// Picks up finished cells, requests the ones within `radius` of `center` (nearest first, both
+// in terrain space), and evicts cells that were not requested until the instances fit in
+// `memory_budget` bytes. No new cells are requested while over budget.
+//
+void							lodge_foliage_cells_update(struct lodge_foliage_cells *cells, vec2 center, float radius, size_t memory_budget);
+
+//
+// Ready, and requested in the last update.
+//
+bool							lodge_foliage_cells_is_active(const struct lodge_foliage_cells *cells, const struct lodge_foliage_cell *cell);
+
+//
+// Runs on the jobs; fills in the instances of `cell` from its coordinates and desc.
+//
+void							lodge_foliage_cell_generate(struct lodge_foliage_cell *cell);
+
+#endif
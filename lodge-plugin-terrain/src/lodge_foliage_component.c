@@ -7,10 +7,11 @@
 #include "lodge_static_mesh.h"
 #include "lodge_buffer_object.h"
 #include "lodge_drawable.h"
-#include "lodge_noise.h"
 #include "fbx_asset.h"
 #include "lodge_assets2.h"
 
+#include "lodge_foliage_cells.h"
+
 #include <string.h>
 
 struct lodge_foliage_instances
@@ -23,18 +24,29 @@ struct lodge_foliage_instances
 struct lodge_foliage_lod
 {
 	struct lodge_foliage_instances	instances;
+	uint32_t						instances_max;				// Room in `buffer_object`.
 	lodge_asset_t					mesh_asset;
+	uint32_t						mesh_lod;					// Range of `mesh_asset` to draw.
+	float							distance;					// Object space, instances switch to this LOD from here on.
 	lodge_buffer_object_t			buffer_object;
 	lodge_drawable_t				drawable;
 	uint32_t						drawable_indices_count;
+	size_t							drawable_indices_offset;	// Bytes.
 };
 
 struct lodge_foliage_component
 {
 	float							threshold;
 	float							axis_divisor;
-	uint32_t						instances_count;
-	struct lodge_foliage_instances	instances;
+	uint32_t						cells_per_axis;
+	uint32_t						seed;
+	float							view_distance;				// World space, from the camera.
+	float							density_falloff;			// Each LOD keeps this much of the instances of the one before.
+	uint32_t						memory_budget;				// Bytes of instances kept in cells.
+
+	struct lodge_foliage_cells		cells;
+	struct lodge_foliage_cells_stats cells_stats;
+	uint32_t						instances_drawn;			// In the last pass.
 
 	uint32_t						lods_count;
 	struct lodge_foliage_lod		lods[LODGE_FOLIAGE_LODS_MAX];
@@ -53,13 +65,17 @@ static void lodge_foliage_lod_free_inplace(struct lodge_foliage_lod *lod)
 	dynbuf_free_inplace(dynbuf(lod->instances));
 }
 
-static void lodge_foliage_lod_set_mesh_asset(struct lodge_foliage_lod *lod, struct lodge_assets2 *mesh_assets, lodge_asset_t mesh_asset)
+static void lodge_foliage_lod_set_mesh_asset(struct lodge_foliage_lod *lod, struct lodge_assets2 *mesh_assets, lodge_asset_t mesh_asset, uint32_t mesh_lod)
 {
-	if(lod->mesh_asset == mesh_asset) {
+	if(lod->mesh_asset == mesh_asset && lod->mesh_lod == mesh_lod) {
 		return;
 	}
 
 	struct fbx_asset *static_mesh = lodge_assets2_get(mesh_assets, mesh_asset);
+	if(static_mesh && mesh_lod >= static_mesh->lods_count) {
+		ASSERT_FAIL("Foliage mesh LOD out of range");
+		return;
+	}
 
 	if(static_mesh && lod->buffer_object) {
 		struct lodge_drawable_desc drawble_desc = lodge_drawable_desc_make_from_static_mesh(&static_mesh->static_mesh);
@@ -77,9 +93,11 @@ static void lodge_foliage_lod_set_mesh_asset(struct lodge_foliage_lod *lod, stru
 			lodge_drawable_reset(lod->drawable);
 		}
 		lod->drawable = lodge_drawable_make(drawble_desc);
-		lod->drawable_indices_count = static_mesh->static_mesh.indices_count;
+		lod->drawable_indices_count = static_mesh->lods[mesh_lod].indices_count;
+		lod->drawable_indices_offset = static_mesh->lods[mesh_lod].indices_offset * sizeof(uint32_t);
 
 		lod->mesh_asset = mesh_asset;
+		lod->mesh_lod = mesh_lod;
 	}
 }
 
@@ -87,6 +105,7 @@ static void lodge_foliage_lod_set_instances_max(struct lodge_foliage_lod *lod, u
 {
 	dynbuf_free_inplace(dynbuf(lod->instances));
 	dynbuf_new_inplace(dynbuf(lod->instances), instances_max);
+	lod->instances_max = instances_max;
 
 	if(!lod->buffer_object) {
 		lod->buffer_object = lodge_buffer_object_make_dynamic(sizeof(vec4) * instances_max);
@@ -99,75 +118,58 @@ static void lodge_foliage_lod_new_inplace(struct lodge_foliage_lod *lod, uint32_
 {
 	memset(lod, 0, sizeof(struct lodge_foliage_lod));
 	lodge_foliage_lod_set_instances_max(lod, instances_max);
-	lodge_foliage_lod_set_mesh_asset(lod, NULL, NULL);
+	lodge_foliage_lod_set_mesh_asset(lod, NULL, NULL, 0);
+}
+
+static struct lodge_foliage_cells_desc lodge_foliage_component_get_cells_desc(const struct lodge_foliage_component *foliage)
+{
+	return (struct lodge_foliage_cells_desc) {
+		.cells_per_axis = foliage->cells_per_axis,
+		.axis_divisor = foliage->axis_divisor,
+		.threshold = foliage->threshold,
+		.seed = foliage->seed,
+	};
 }
 
-void lodge_foliage_component_new_inplace(struct lodge_foliage_component *foliage, void *userdata)
+void lodge_foliage_component_new_inplace(struct lodge_foliage_component *foliage, struct lodge_jobs *jobs)
 {
 	foliage->axis_divisor = 100.0f;
 	foliage->threshold = 1.0f;
+	foliage->cells_per_axis = 32;
+	foliage->seed = 0;
+	foliage->view_distance = 1000.0f;
+	foliage->density_falloff = 0.5f;
+	foliage->memory_budget = 8 * 1024 * 1024;
 	foliage->lods_count = 0;
+	foliage->instances_drawn = 0;
 
-	foliage->instances_count = 64;
-	dynbuf_new_inplace(dynbuf(foliage->instances), foliage->instances_count);
+	lodge_foliage_cells_new_inplace(&foliage->cells, lodge_foliage_component_get_cells_desc(foliage), jobs);
+	memset(&foliage->cells_stats, 0, sizeof(struct lodge_foliage_cells_stats));
 
 	for(int lod_idx = 0; lod_idx < LODGE_FOLIAGE_LODS_MAX; lod_idx++) {
-		lodge_foliage_lod_new_inplace(&foliage->lods[lod_idx], foliage->instances_count);
+		lodge_foliage_lod_new_inplace(&foliage->lods[lod_idx], 64);
 	}
 }
 
-void lodge_foliage_component_free_inplace(struct lodge_foliage_component *foliage, void *userdata)
+void lodge_foliage_component_free_inplace(struct lodge_foliage_component *foliage, struct lodge_jobs *jobs)
 {
+	lodge_foliage_cells_free_inplace(&foliage->cells);
+
 	for(int lod_idx = 0; lod_idx < LODGE_FOLIAGE_LODS_MAX; lod_idx++) {
 		lodge_foliage_lod_free_inplace(&foliage->lods[lod_idx]);
 	}
-	dynbuf_free_inplace(dynbuf(foliage->instances));
 }
 
-static void on_modified_instances_count(struct lodge_property *property, struct lodge_foliage_component *foliage)
+//
+// Instances are generated in cells around the camera as it moves (see `lodge_foliage_cells`),
+// so changing how they are placed only has to drop the cells.
+//
+static void on_modified_placement(struct lodge_property *property, struct lodge_foliage_component *foliage)
 {
-	dynbuf_t instances = dynbuf(foliage->instances);
-
-	dynbuf_clear(instances);
-#if 0
-	for(uint32_t i = 0, count = foliage->instances_count; i < count; i++) {
-		vec4 *element = dynbuf_append_no_init(instances);
-
-		element->x = randr(0.0f, 1.0f);
-		element->y = randr(0.0f, 1.0f);
-		element->z = randr(0.0f, 0.0f);
-		element->w = randr(1.0f, 10.0f);
-	}
-#else
-	//
-	// TODO(TS): do this on-demand in render call and populate only close to camera
-	//
-	foliage->instances_count = 0;
-	const float cell_size = 0.01f;
-	const float step_size = 1.0f / foliage->axis_divisor;
-	for(float y = 0.0f; y <= 1.0f; y+=step_size) {
-		for(float x = 0.0f; x <= 1.0f; x+=step_size) {
-			const float noise = lodge_noise_simplex_2d(x, y);
-			if(noise >= foliage->threshold) {
-				vec4 *element = dynbuf_append_no_init(instances);
-
-				element->x = x + clamp(noise, -cell_size, cell_size);
-				element->y = y + clamp(noise, -cell_size, cell_size);
-				element->z = 0.0f;
-				element->w = 1.0f + noise * 10;
-
-				foliage->instances_count++;
-			}
-		}
-	}
-#endif
-
-	for(uint32_t i = 0; i < foliage->lods_count; i++) {
-		lodge_foliage_lod_set_instances_max(&foliage->lods[i], foliage->instances_count);
-	}
+	lodge_foliage_cells_reset(&foliage->cells, lodge_foliage_component_get_cells_desc(foliage));
 }
 
-lodge_component_type_t lodge_foliage_component_type_register()
+lodge_component_type_t lodge_foliage_component_type_register(struct lodge_jobs *jobs)
 {
 	if(!LODGE_COMPONENT_TYPE_FOLIAGE) {
 		LODGE_COMPONENT_TYPE_FOLIAGE = lodge_component_type_register((struct lodge_component_desc) {
@@ -176,29 +178,100 @@ lodge_component_type_t lodge_foliage_component_type_register()
 			.new_inplace = &lodge_foliage_component_new_inplace,
 			.free_inplace = &lodge_foliage_component_free_inplace,
 			.size = sizeof(struct lodge_foliage_component),
+			.userdata = jobs,
 			.properties = {
-				.count = 3,
+				.count = 13,
 				.elements = {
-					{
-						.name = strview_static("instances_count"),
-						.type = LODGE_TYPE_U32,
-						.offset = offsetof(struct lodge_foliage_component, instances_count),
-						.flags = LODGE_PROPERTY_FLAG_READ_ONLY,
-						.on_modified = NULL,
-					},
 					{
 						.name = strview_static("threshold"),
 						.type = LODGE_TYPE_F32,
 						.offset = offsetof(struct lodge_foliage_component, threshold),
 						.flags = LODGE_PROPERTY_FLAG_NONE,
-						.on_modified = &on_modified_instances_count,
+						.on_modified = &on_modified_placement,
 					},
 					{
 						.name = strview_static("axis_divisor"),
 						.type = LODGE_TYPE_F32,
 						.offset = offsetof(struct lodge_foliage_component, axis_divisor),
 						.flags = LODGE_PROPERTY_FLAG_NONE,
-						.on_modified = &on_modified_instances_count,
+						.on_modified = &on_modified_placement,
+					},
+					{
+						.name = strview_static("cells_per_axis"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_foliage_component, cells_per_axis),
+						.flags = LODGE_PROPERTY_FLAG_NONE,
+						.on_modified = &on_modified_placement,
+					},
+					{
+						.name = strview_static("seed"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_foliage_component, seed),
+						.flags = LODGE_PROPERTY_FLAG_NONE,
+						.on_modified = &on_modified_placement,
+					},
+					{
+						.name = strview_static("view_distance"),
+						.type = LODGE_TYPE_F32,
+						.offset = offsetof(struct lodge_foliage_component, view_distance),
+						.flags = LODGE_PROPERTY_FLAG_NONE,
+						.on_modified = NULL,
+					},
+					{
+						.name = strview_static("density_falloff"),
+						.type = LODGE_TYPE_F32,
+						.offset = offsetof(struct lodge_foliage_component, density_falloff),
+						.flags = LODGE_PROPERTY_FLAG_NONE,
+						.on_modified = NULL,
+					},
+					{
+						.name = strview_static("memory_budget"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_foliage_component, memory_budget),
+						.flags = LODGE_PROPERTY_FLAG_NONE,
+						.on_modified = NULL,
+					},
+					{
+						.name = strview_static("instances_count"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_foliage_component, cells_stats.instances_count),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY,
+						.on_modified = NULL,
+					},
+					{
+						.name = strview_static("instances_drawn"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_foliage_component, instances_drawn),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY,
+						.on_modified = NULL,
+					},
+					{
+						.name = strview_static("cells_count"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_foliage_component, cells_stats.cells_count),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY,
+						.on_modified = NULL,
+					},
+					{
+						.name = strview_static("cells_pending"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_foliage_component, cells_stats.cells_pending),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY,
+						.on_modified = NULL,
+					},
+					{
+						.name = strview_static("memory"),
+						.type = LODGE_TYPE_U32,
+						.offset = offsetof(struct lodge_foliage_component, cells_stats.memory),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY,
+						.on_modified = NULL,
+					},
+					{
+						.name = strview_static("generate_ms"),
+						.type = LODGE_TYPE_F32,
+						.offset = offsetof(struct lodge_foliage_component, cells_stats.generate_ms),
+						.flags = LODGE_PROPERTY_FLAG_READ_ONLY,
+						.on_modified = NULL,
 					},
 				}
 			}
@@ -232,11 +305,86 @@ void lodge_foliage_component_render(struct lodge_foliage_component *foliage, con
 		lodge_gfx_bind_texture_unit_2d(0, heightfield, heightfield_sampler);
 
 		//
-		// FIXME(TS): debugging, puts all instances into LOD 0
+		// NOTE(TS): assumes the terrain is centered at the origin, like the terrain system
+		// draws it.
+		//
+		const vec2 camera_pos = vec2_make(pass_params->camera.pos.x, pass_params->camera.pos.y);
+
+		//
+		// Shadow passes draw the cells around the main camera.
 		//
+		if(pass_params->pass != LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW) {
+			const vec2 center = vec2_make(camera_pos.x / terrain_scale.x + 0.5f, camera_pos.y / terrain_scale.y + 0.5f);
+			const float radius = foliage->view_distance / max(min(terrain_scale.x, terrain_scale.y), 1e-6f);
+
+			lodge_foliage_cells_update(&foliage->cells, center, radius, foliage->memory_budget);
+			foliage->cells_stats = foliage->cells.stats;
+		}
+
+		//
+		// Every instance may end up in the same LOD.
+		//
+		const uint32_t instances_max = foliage->cells.stats.instances_count;
+		for(size_t lod_idx = 0; lod_idx < foliage->lods_count; lod_idx++) {
+			struct lodge_foliage_lod *lod = &foliage->lods[lod_idx];
+			if(lod->instances_max < instances_max) {
+				uint32_t capacity = max(lod->instances_max, 64);
+				while(capacity < instances_max) {
+					capacity *= 2;
+				}
+				lodge_foliage_lod_set_instances_max(lod, capacity);
+			}
+			dynbuf_clear(dynbuf(lod->instances));
+		}
+
+		//
+		// Bin the instances by distance to the camera. Instances are in terrain space and the
+		// heightfield is only applied in the shader, so this is the distance in the terrain
+		// plane -- never further than the real one, which errs on the side of detail.
+		//
+		// Each LOD keeps `density_falloff` of the instances of the one before; cells are in
+		// random order, so that is a prefix of each cell.
+		//
+		float lod_densities[LODGE_FOLIAGE_LODS_MAX];
+		for(uint32_t lod_idx = 0; lod_idx < LODGE_FOLIAGE_LODS_MAX; lod_idx++) {
+			lod_densities[lod_idx] = powf(clamp(foliage->density_falloff, 0.0f, 1.0f), (float)lod_idx);
+		}
+
+		foliage->instances_drawn = 0;
+
 		if(foliage->lods_count > 0) {
-			dynbuf_clear(dynbuf(foliage->lods[0].instances));
-			dynbuf_append_range(dynbuf(foliage->lods[0].instances), foliage->instances.elements, sizeof(vec4), foliage->instances.count);
+			for(size_t cell_idx = 0; cell_idx < foliage->cells.resident.count; cell_idx++) {
+				const struct lodge_foliage_cell *cell = foliage->cells.resident.elements[cell_idx];
+				if(!lodge_foliage_cells_is_active(&foliage->cells, cell)) {
+					continue;
+				}
+
+				for(uint32_t i = 0; i < cell->instances_count; i++) {
+					const vec4 *instance = &cell->instances[i];
+					const vec2 pos = vec2_make((instance->x - 0.5f) * terrain_scale.x, (instance->y - 0.5f) * terrain_scale.y);
+					const vec2 delta = vec2_make(pos.x - camera_pos.x, pos.y - camera_pos.y);
+					const float distance_world = sqrtf(delta.x * delta.x + delta.y * delta.y);
+					if(distance_world > foliage->view_distance) {
+						continue;
+					}
+
+					const float distance = distance_world / max(instance->w, 1e-6f);
+
+					uint32_t lod_idx = 0;
+					while(lod_idx + 1 < foliage->lods_count && distance >= foliage->lods[lod_idx + 1].distance) {
+						lod_idx++;
+					}
+
+					if((float)i >= lod_densities[lod_idx] * cell->instances_count) {
+						continue;
+					}
+
+					struct lodge_foliage_lod *lod = &foliage->lods[lod_idx];
+					ASSERT_OR(lod->instances.count < lod->instances_max) { continue; }
+					dynbuf_append(dynbuf(lod->instances), instance, sizeof(vec4));
+					foliage->instances_drawn++;
+				}
+			}
 		}
 
 		for(size_t lod_idx = 0; lod_idx < foliage->lods_count; lod_idx++) {
@@ -251,9 +399,11 @@ void lodge_foliage_component_render(struct lodge_foliage_component *foliage, con
 						lod->instances.count * sizeof(vec4)
 					);
 
-					lodge_drawable_render_indexed_instanced(
+					lodge_drawable_render_indexed_instanced_typed(
 						lod->drawable,
+						LODGE_DRAWABLE_INDEX_TYPE_U32,
 						lod->drawable_indices_count,
+						lod->drawable_indices_offset,
 						lod->instances.count
 					);
 				}
@@ -265,9 +415,27 @@ void lodge_foliage_component_render(struct lodge_foliage_component *foliage, con
 
 void lodge_foliage_component_set_lods_desc(struct lodge_foliage_component *foliage, struct lodge_assets2 *mesh_assets, struct lodge_foliage_lods_desc *lods_desc)
 {
-	foliage->lods_count = lods_desc->count;
+	ASSERT_OR(lods_desc->count <= LODGE_FOLIAGE_LODS_MAX) { return; }
+
+	//
+	// A single mesh brings its own LODs (see `fbx_mesh_desc`); draw those ranges instead.
+	//
+	if(lods_desc->count == 1) {
+		const struct fbx_asset *static_mesh = lodge_assets2_get(mesh_assets, lods_desc->elements[0]);
+		if(static_mesh && static_mesh->lods_count > 1) {
+			foliage->lods_count = min(static_mesh->lods_count, LODGE_FOLIAGE_LODS_MAX);
+			for(uint32_t i = 0; i < foliage->lods_count; i++) {
+				lodge_foliage_lod_set_mesh_asset(&foliage->lods[i], mesh_assets, lods_desc->elements[0], i);
+				foliage->lods[i].distance = static_mesh->lods[i].distance;
+			}
+			return;
+		}
+	}
+
+	foliage->lods_count = (uint32_t)lods_desc->count;
 
 	for(uint32_t i = 0; i < lods_desc->count; i++) {
-		lodge_foliage_lod_set_mesh_asset(&foliage->lods[i], mesh_assets, lods_desc->elements[i]);
+		lodge_foliage_lod_set_mesh_asset(&foliage->lods[i], mesh_assets, lods_desc->elements[i], 0);
+		foliage->lods[i].distance = lods_desc->distances[i];
 	}
 }
\ No newline at end of file
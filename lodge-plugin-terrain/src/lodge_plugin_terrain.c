@@ -14,6 +14,7 @@ enum lodge_plugin_idx
 	PLUGIN_IDX_SHADERS,
 	PLUGIN_IDX_TEXTURES,
 	PLUGIN_IDX_SCENE_RENDERER,
+	PLUGIN_IDX_OPTIONAL_IMAGES,
 	PLUGIN_IDX_OPTIONAL_DEBUG_DRAW,
 	PLUGIN_IDX_OPTIONAL_EDITOR,
 	PLUGIN_IDX_MAX,
@@ -23,18 +24,23 @@ struct lodge_ret lodge_plugin_terrain_new_inplace(struct lodge_plugin_terrain *p
 {
 	plugin->shaders = dependencies[PLUGIN_IDX_SHADERS];
 	plugin->textures = dependencies[PLUGIN_IDX_TEXTURES];
+	plugin->images = dependencies[PLUGIN_IDX_OPTIONAL_IMAGES];
 	plugin->plugin_scene_renderer = dependencies[PLUGIN_IDX_SCENE_RENDERER];
 
 	plugin->plugin_debug_draw = dependencies[PLUGIN_IDX_OPTIONAL_DEBUG_DRAW];
 	plugin->plugin_editor = dependencies[PLUGIN_IDX_OPTIONAL_EDITOR];
 
+	plugin->jobs = lodge_plugins_get_jobs(plugins);
+
 	struct texture_types texture_types = lodge_plugin_textures_get_types(plugin->textures);
 
-	plugin->types = (struct lodge_terrain_types) {
-		.terrain_system_type = lodge_terrain_system_type_register(plugin),
-		.terrain_component_type = lodge_terrain_component_type_register(texture_types.texture_asset_type),
-		.foliage_component_type = lodge_foliage_component_type_register(),
-	};
+	//
+	// NOTE(TS): component types must be registered before the system types
+	// that declare access to them.
+	//
+	plugin->types.terrain_component_type = lodge_terrain_component_type_register(texture_types.texture_asset_type);
+	plugin->types.foliage_component_type = lodge_foliage_component_type_register(plugin->jobs);
+	plugin->types.terrain_system_type = lodge_terrain_system_type_register(plugin);
 
 	return lodge_success();
 }
@@ -69,6 +75,10 @@ LODGE_PLUGIN_IMPL(lodge_plugin_terrain)
 				[PLUGIN_IDX_SCENE_RENDERER] = {
 					.name = strview("scene_renderer"),
 				},
+				[PLUGIN_IDX_OPTIONAL_IMAGES] = {
+					.name = strview("images"),
+					.optional = true,
+				},
 				[PLUGIN_IDX_OPTIONAL_DEBUG_DRAW] = {
 					.name = strview("debug_draw"),
 					.optional = true,
@@ -1,6 +1,7 @@
 #include "lodge_terrain_component.h"
 
 #include "lodge_component_type.h"
+#include "lodge_image_minmax.h"
 
 lodge_component_type_t LODGE_COMPONENT_TYPE_TERRAIN = NULL;
 
@@ -26,6 +27,9 @@ void lodge_terrain_component_new_inplace(struct lodge_terrain_component *terrain
 	terrain->plane = calloc(1, lodge_tesselated_plane_sizeof());
 	lodge_tesselated_plane_new_inplace(terrain->plane);
 
+	terrain->heights = NULL;
+	terrain->heights_heightmap = NULL;
+
 	terrain->heightmap = NULL;
 	terrain->material = (struct lodge_static_material) {
 		.albedo = NULL,
@@ -38,6 +42,11 @@ void lodge_terrain_component_new_inplace(struct lodge_terrain_component *terrain
 void lodge_terrain_component_free_inplace(struct lodge_terrain_component *terrain, void *userdata)
 {
 	free(terrain->chunks);
+
+	if(terrain->heights) {
+		lodge_image_minmax_free_inplace(terrain->heights);
+		free(terrain->heights);
+	}
 }
 
 lodge_component_type_t lodge_terrain_component_type_register(lodge_type_t texture_asset_type)
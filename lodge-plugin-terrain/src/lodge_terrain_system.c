@@ -11,6 +11,7 @@
 #include "lodge_shader.h"
 #include "lodge_drawable.h"
 #include "lodge_parametric_drawable.h"
+#include "lodge_image_minmax.h"
 
 #include "lodge_terrain_component.h"
 #include "lodge_foliage_component.h"
@@ -80,10 +81,7 @@ struct lodge_terrain_system
 
 static int lodge_terrain_chunk_in_frustum(struct lodge_terrain_chunk *chunk, struct frustum_planes *frustum /*, struct lodge_debug_draw *debug_draw*/)
 {
-	struct aabb aabb = {
-		.min = chunk->world_offset,
-		.max = vec3_add(chunk->world_offset, chunk->world_size)
-	};
+	struct aabb aabb = chunk->bounds;
 
 #if 0
 	if(debug_draw) {
@@ -127,6 +125,18 @@ static void lodge_terrain_system_update_visible_chunks(struct lodge_terrain_comp
 
 			chunk->world_size = vec3_mult(scale, component->chunk_size);
 
+			//
+			// Only as high as the heights in the chunk, all of the range until they have loaded.
+			//
+			const vec2 uv_min = vec2_make(chunk->offset.x + 0.5f, chunk->offset.y + 0.5f);
+			const vec2 uv_max = vec2_make(uv_min.x + component->chunk_size.x, uv_min.y + component->chunk_size.y);
+			const vec2 heights = component->heights ? lodge_image_minmax_get_01(component->heights, uv_min, uv_max) : vec2_make(0.0f, 1.0f);
+
+			chunk->bounds = (struct aabb) {
+				.min = vec3_make(chunk->world_offset.x, chunk->world_offset.y, chunk->world_offset.z + heights.x * chunk->world_size.z),
+				.max = vec3_make(chunk->world_offset.x + chunk->world_size.x, chunk->world_offset.y + chunk->world_size.y, chunk->world_offset.z + heights.y * chunk->world_size.z),
+			};
+
 			chunk->visible = lodge_terrain_chunk_in_frustum(chunk, frustum /*, params->debug_draw*/);
 		}
 	}
@@ -169,6 +179,7 @@ static void lodge_terrain_system_render(lodge_scene_t scene, const struct lodge_
 						&pass_params->camera,
 						system->lod_level_min,
 						system->lod_switch_threshold,
+						component->heights,
 						system->debug ? system->debug_draw : NULL
 					);
 				}
@@ -213,7 +224,7 @@ static void lodge_terrain_system_render(lodge_scene_t scene, const struct lodge_
 			lodge_shader_set_constant_vec2(terrain_shader, strview("chunk_size"), vec2_make(xy_of(component->chunk_size)));
 
 #if 1
-			lodge_shader_set_constant_float(terrain_shader, strview("entity_id"), (float)((uintptr_t)owner));
+			lodge_shader_set_constant_float(terrain_shader, strview("entity_id"), (float)lodge_entity_get_id(owner));
 			const bool selected = lodge_scene_is_entity_selected(scene, owner);
 			lodge_shader_set_constant_float(terrain_shader, strview("entity_selected"), selected ? 1.0f : 0.0f);
 #endif
@@ -242,9 +253,21 @@ static void lodge_terrain_system_render(lodge_scene_t scene, const struct lodge_
 					}
 				}
 			} else {
+				//
+				// The chunks were selected for the camera; shadow passes draw the ones in their own
+				// frustum, including casters between it and the light.
+				//
+				const bool shadow = pass_params->pass == LODGE_SCENE_RENDER_SYSTEM_PASS_SHADOW;
+				struct frustum_planes frustum = frustum_planes_make(pass_params->camera.view_projection);
+				frustum.planes[FRUSTUM_PLANE_NEAR] = vec4_make(0.0f, 0.0f, 0.0f, 1.0f);
+
 				for(struct lodge_tesselated_plane_chunk *it = lodge_tesselated_plane_chunks_begin(component->plane),
 					*end = lodge_tesselated_plane_chunks_end(component->plane); it < end; it++) {
-					
+
+					if(shadow ? !frustum_planes_vs_aabb(&frustum, it->bounds) : !it->visible) {
+						continue;
+					}
+
 					mat4 model = mat4_translation(it->center.x, it->center.y, 0.0f);
 					model = mat4_scale(model, it->size.x, it->size.y, render_data->scale.z); // FIXME(TS): Z scaling
 
@@ -336,6 +359,56 @@ static void lodge_terrain_system_free_inplace(struct lodge_terrain_system *syste
 	}
 }
 
+//
+// The height bounds are built once per heightmap, from the image the texture was made from.
+// Without the images plugin there are none, and chunks are bounded by the full height range.
+//
+static void lodge_terrain_system_update_heights(struct lodge_terrain_component *component, struct lodge_assets2 *textures, struct lodge_assets2 *images, struct lodge_jobs *jobs)
+{
+	if(component->heights_heightmap == component->heightmap) {
+		return;
+	}
+
+	if(component->heights) {
+		lodge_image_minmax_free_inplace(component->heights);
+		free(component->heights);
+		component->heights = NULL;
+	}
+
+	if(!component->heightmap) {
+		component->heights_heightmap = NULL;
+		return;
+	}
+
+	lodge_asset_t image_asset = lodge_assets2_register(images, lodge_assets2_get_name(textures, component->heightmap));
+	ASSERT_OR(image_asset) {
+		return;
+	}
+
+	const struct lodge_image *image = lodge_assets2_get_async(images, image_asset);
+	const enum lodge_asset_state image_state = lodge_assets2_get_state(images, image_asset);
+	if(image_state == LODGE_ASSET_STATE_LOADING) {
+		return;
+	}
+
+	component->heights_heightmap = component->heightmap;
+	if(image_state != LODGE_ASSET_STATE_LOADED || !image) {
+		return;
+	}
+
+	component->heights = malloc(sizeof(struct lodge_image_minmax));
+	if(!lodge_image_minmax_new_inplace(component->heights, image, 0, jobs)) {
+		free(component->heights);
+		component->heights = NULL;
+		return;
+	}
+
+	//
+	// The plane only compares heights by pointer, and a new one may reuse the old address.
+	//
+	lodge_tesselated_plane_reset(component->plane);
+}
+
 static void lodge_terrain_system_update(struct lodge_terrain_system *system, lodge_system_type_t type, lodge_scene_t scene, float dt, struct lodge_plugin_terrain *plugin)
 {
 	if(system->terrain_shader_asset) {
@@ -367,6 +440,10 @@ static void lodge_terrain_system_update(struct lodge_terrain_system *system, lod
 
 		const vec3 scale = lodge_get_scale(scene, owner);
 
+		if(plugin->images) {
+			lodge_terrain_system_update_heights(component, textures, plugin->images, plugin->jobs);
+		}
+
  		lodge_texture_t *heightmap = lodge_assets2_get(textures, component->heightmap);
 		lodge_texture_t *albedo = lodge_assets2_get(textures, component->material.albedo);
 		lodge_texture_t *displacement = lodge_assets2_get(textures, component->material.displacement);
@@ -484,6 +561,15 @@ lodge_system_type_t lodge_terrain_system_type_register(struct lodge_plugin_terra
 					.offset = offsetof(struct lodge_terrain_system, lod_switch_threshold),
 				},
 			}
-		}
+		},
+		.flags = LODGE_SYSTEM_TYPE_FLAG_CONCURRENT | LODGE_SYSTEM_TYPE_FLAG_MAIN_THREAD,
+		.reads = {
+			.count = 1,
+			.elements = { LODGE_COMPONENT_TYPE_TRANSFORM },
+		},
+		.writes = {
+			.count = 1,
+			.elements = { LODGE_COMPONENT_TYPE_TERRAIN },
+		},
 	});
 }
@@ -0,0 +1,151 @@
+//
+// CPU time of the terrain quadtree traversal (`lodge_tesselated_plane_update()`) along a
+// recorded camera path over a 4096x4096x400 terrain with a 1025x1025 heightmap.
+//
+// Usage: bench_lodge_terrain_traversal [frames]
+//
+
+#include "lodge_tesselated_plane.h"
+#include "lodge_camera_params.h"
+#include "lodge_image_minmax.h"
+#include "lodge_platform.h"
+#include "lodge_time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+//
+// Camera positions and look-at targets, recorded from a flight over the terrain: low over the
+// ground, up a slope, a wide orbit and back down. Frames are interpolated between them.
+//
+static const struct
+{
+	vec3								pos;
+	vec3								target;
+} bench_camera_path[] = {
+	{ { -1800.0f, -1800.0f, 260.0f }, { -1200.0f, -1300.0f, 180.0f } },
+	{ { -1500.0f, -1450.0f, 240.0f }, { -900.0f, -1000.0f, 190.0f } },
+	{ { -1100.0f, -1000.0f, 230.0f }, { -400.0f, -700.0f, 200.0f } },
+	{ { -600.0f, -750.0f, 280.0f }, { 100.0f, -500.0f, 230.0f } },
+	{ { -100.0f, -600.0f, 360.0f }, { 600.0f, -200.0f, 250.0f } },
+	{ { 500.0f, -300.0f, 420.0f }, { 900.0f, 400.0f, 240.0f } },
+	{ { 900.0f, 300.0f, 520.0f }, { 600.0f, 1000.0f, 220.0f } },
+	{ { 1100.0f, 1100.0f, 700.0f }, { 0.0f, 600.0f, 150.0f } },
+	{ { 300.0f, 1700.0f, 900.0f }, { -300.0f, 200.0f, 100.0f } },
+	{ { -900.0f, 1500.0f, 800.0f }, { -200.0f, -200.0f, 120.0f } },
+	{ { -1700.0f, 500.0f, 500.0f }, { -600.0f, -300.0f, 180.0f } },
+	{ { -1400.0f, -400.0f, 300.0f }, { -500.0f, -700.0f, 200.0f } },
+	{ { -900.0f, -900.0f, 230.0f }, { -200.0f, -1300.0f, 190.0f } },
+};
+
+static vec3 bench_vec3_lerp(const vec3 a, const vec3 b, float t)
+{
+	return vec3_make(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+}
+
+static struct lodge_camera_params bench_camera_params(uint32_t frame, uint32_t frames)
+{
+	const uint32_t segments = LODGE_ARRAYSIZE(bench_camera_path) - 1;
+	const float t = (float)frame / (float)frames * segments;
+	const uint32_t segment = min((uint32_t)t, segments - 1);
+	const float segment_t = t - (float)segment;
+
+	struct lodge_camera_params camera = { 0 };
+	camera.pos = bench_vec3_lerp(bench_camera_path[segment].pos, bench_camera_path[segment + 1].pos, segment_t);
+	const vec3 target = bench_vec3_lerp(bench_camera_path[segment].target, bench_camera_path[segment + 1].target, segment_t);
+
+	camera.fov_y = (float)radians(60.0f);
+	camera.view = mat4_lookat(camera.pos, target, vec3_make(0.0f, 0.0f, 1.0f));
+	camera.projection = mat4_perspective(camera.fov_y, 16.0f / 9.0f, 0.1f, 10000.0f);
+	camera.view_projection = mat4_mult(camera.projection, camera.view);
+	return camera;
+}
+
+int main(int argc, char **argv)
+{
+	const uint32_t frames = (argc > 1) ? (uint32_t)atoi(argv[1]) : 600;
+
+	const uint32_t size = 1025;
+	struct lodge_image heightmap = {
+		.desc = {
+			.width = size,
+			.height = size,
+			.channels = 1,
+			.bytes_per_channel = 1,
+		},
+		.pixel_data = malloc(size * size),
+	};
+	for(uint32_t y = 0; y < size; y++) {
+		for(uint32_t x = 0; x < size; x++) {
+			const float h = 0.5f
+				+ 0.25f * sinf(x * 0.013f) * cosf(y * 0.011f)
+				+ 0.15f * sinf(x * 0.05f + y * 0.03f)
+				+ 0.1f * sinf(y * 0.2f);
+			heightmap.pixel_data[y * size + x] = (uint8_t)(clamp(h, 0.0f, 1.0f) * 255.0f);
+		}
+	}
+
+	struct lodge_image_minmax heights;
+	const lodge_timestamp_t build_before = lodge_timestamp_get();
+	lodge_image_minmax_new_inplace(&heights, &heightmap, 0, NULL);
+	printf("heights pyramid: %.3f ms\n", lodge_timestamp_elapsed_ms(build_before));
+
+	const vec3 pos = vec3_make(0.0f, 0.0f, 0.0f);
+	const vec3 scale = vec3_make(4096.0f, 4096.0f, 400.0f);
+	const uint32_t level_max = 7;
+	const float lod_switch_distance = 1.5f;
+
+	struct lodge_tesselated_plane *plane = malloc(lodge_tesselated_plane_sizeof());
+
+	const struct
+	{
+		const char							*name;
+		const struct lodge_image_minmax		*heights;
+	} cases[] = {
+		{ "flat bounds", NULL },
+		{ "heightmap bounds", &heights },
+	};
+
+	printf("%zu keyframes, %u frames, %u levels\n", LODGE_ARRAYSIZE(bench_camera_path), frames, level_max);
+
+	for(size_t c = 0; c < LODGE_ARRAYSIZE(cases); c++) {
+		lodge_tesselated_plane_new_inplace(plane);
+
+		double total_ms = 0.0;
+		double worst_ms = 0.0;
+		size_t chunks = 0;
+		size_t chunks_visible = 0;
+
+		for(uint32_t i = 0; i < frames; i++) {
+			const struct lodge_camera_params camera = bench_camera_params(i, frames);
+
+			const lodge_timestamp_t before = lodge_timestamp_get();
+			lodge_tesselated_plane_update(plane, pos, scale, &camera, level_max, lod_switch_distance, cases[c].heights, NULL);
+			const double elapsed_ms = lodge_timestamp_elapsed_ms(before);
+			total_ms += elapsed_ms;
+			worst_ms = max(worst_ms, elapsed_ms);
+
+			for(const struct lodge_tesselated_plane_chunk *it = lodge_tesselated_plane_chunks_begin(plane), *end = lodge_tesselated_plane_chunks_end(plane); it != end; it++) {
+				chunks++;
+				chunks_visible += it->visible;
+			}
+		}
+
+		printf("%-18s chunks: %6.1f  visible: %6.1f  avg: %7.4f ms  worst: %7.4f ms\n",
+			cases[c].name,
+			chunks / (double)frames,
+			chunks_visible / (double)frames,
+			total_ms / frames,
+			worst_ms
+		);
+
+		lodge_tesselated_plane_free_inplace(plane);
+	}
+
+	free(plane);
+	lodge_image_minmax_free_inplace(&heights);
+	free(heightmap.pixel_data);
+
+	return 0;
+}
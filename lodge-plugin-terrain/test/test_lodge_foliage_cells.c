@@ -0,0 +1,312 @@
+//
+// Foliage cells against generating the whole terrain in one go, and the cell cache against
+// its memory budget. Runs without a GPU.
+//
+
+#include "lodge_foliage_cells.h"
+#include "lodge_noise.h"
+#include "lodge_platform.h"
+
+#include "lodge_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+//
+// 7 cells over 200 candidates per axis, so the cell edges fall between candidates and on them.
+//
+static const struct lodge_foliage_cells_desc test_desc = {
+	.cells_per_axis = 7,
+	.axis_divisor = 200.0f,
+	.threshold = 0.3f,
+	.seed = 7,
+};
+
+struct test_instances
+{
+	size_t							count;
+	size_t							capacity;
+	vec4							*elements;
+};
+
+static void test_instances_append(struct test_instances *instances, const vec4 *elements, size_t count)
+{
+	if(instances->count + count > instances->capacity) {
+		instances->capacity = max(instances->capacity * 2, instances->count + count);
+		instances->elements = realloc(instances->elements, instances->capacity * sizeof(vec4));
+	}
+	if(count) {
+		memcpy(&instances->elements[instances->count], elements, count * sizeof(vec4));
+	}
+	instances->count += count;
+}
+
+static int test_vec4_compare(const vec4 *lhs, const vec4 *rhs)
+{
+	for(int i = 0; i < 4; i++) {
+		if(lhs->v[i] != rhs->v[i]) {
+			return lhs->v[i] < rhs->v[i] ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+static void test_instances_sort(struct test_instances *instances)
+{
+	if(instances->count > 1) {
+		qsort(instances->elements, instances->count, sizeof(vec4), (int (*)(const void *, const void *))&test_vec4_compare);
+	}
+}
+
+static bool test_instances_equal(const struct test_instances *lhs, const struct test_instances *rhs)
+{
+	return lhs->count == rhs->count
+		&& (lhs->count == 0 || memcmp(lhs->elements, rhs->elements, lhs->count * sizeof(vec4)) == 0);
+}
+
+//
+// Every candidate on the terrain, row by row, placed like the cells place them.
+//
+static struct test_instances test_full_grid(const struct lodge_foliage_cells_desc *desc)
+{
+	struct test_instances instances = { 0 };
+
+	const float step_size = 1.0f / desc->axis_divisor;
+	const uint32_t candidates = (uint32_t)floorf(desc->axis_divisor) + 1;
+
+	float *u = malloc(candidates * sizeof(float));
+	float *v = malloc(candidates * sizeof(float));
+	float *noise = malloc(candidates * sizeof(float));
+
+	for(uint32_t y = 0; y < candidates; y++) {
+		for(uint32_t x = 0; x < candidates; x++) {
+			u[x] = x * step_size;
+			v[x] = y * step_size;
+		}
+		lodge_noise_simplex_2d_n(noise, u, v, candidates);
+
+		for(uint32_t x = 0; x < candidates; x++) {
+			if(noise[x] >= desc->threshold) {
+				const vec4 instance = vec4_make(
+					u[x] + clamp(noise[x], -0.01f, 0.01f),
+					v[x] + clamp(noise[x], -0.01f, 0.01f),
+					0.0f,
+					1.0f + noise[x] * 10
+				);
+				test_instances_append(&instances, &instance, 1);
+			}
+		}
+	}
+
+	free(u);
+	free(v);
+	free(noise);
+
+	return instances;
+}
+
+static struct lodge_foliage_cell test_cell_generate(uint32_t x, uint32_t y, struct lodge_foliage_cells_desc desc)
+{
+	struct lodge_foliage_cell cell = {
+		.x = x,
+		.y = y,
+		.desc = desc,
+	};
+	lodge_foliage_cell_generate(&cell);
+	return cell;
+}
+
+static void test_cell_deterministic()
+{
+	struct lodge_foliage_cells_desc reseeded = test_desc;
+	reseeded.seed = test_desc.seed + 1;
+
+	bool reordered = false;
+
+	for(uint32_t y = 0; y < test_desc.cells_per_axis; y++) {
+		for(uint32_t x = 0; x < test_desc.cells_per_axis; x++) {
+			struct lodge_foliage_cell first = test_cell_generate(x, y, test_desc);
+			struct lodge_foliage_cell again = test_cell_generate(x, y, test_desc);
+			struct lodge_foliage_cell other = test_cell_generate(x, y, reseeded);
+
+			LODGE_TEST_CHECK(first.state == LODGE_FOLIAGE_CELL_STATE_READY);
+
+			struct test_instances first_instances = { first.instances_count, first.instances_count, first.instances };
+			struct test_instances again_instances = { again.instances_count, again.instances_count, again.instances };
+			struct test_instances other_instances = { other.instances_count, other.instances_count, other.instances };
+
+			LODGE_TEST_CHECK_MSG(test_instances_equal(&first_instances, &again_instances), "cell %u, %u", x, y);
+
+			//
+			// Another seed shuffles the same instances differently.
+			//
+			reordered |= first.instances_count > 1 && !test_instances_equal(&first_instances, &other_instances);
+			test_instances_sort(&first_instances);
+			test_instances_sort(&other_instances);
+			LODGE_TEST_CHECK_MSG(test_instances_equal(&first_instances, &other_instances), "cell %u, %u", x, y);
+
+			free(first.instances);
+			free(again.instances);
+			free(other.instances);
+		}
+	}
+
+	LODGE_TEST_CHECK(reordered);
+}
+
+//
+// Streams the cells along a path over the whole terrain, keeping the instances of each cell
+// the first time it is ready. With a budget big enough for everything nothing is evicted, and
+// all cells together must hold exactly the instances of the full grid.
+//
+static void test_streamed_union_matches_full_grid_impl(uint32_t threads_count)
+{
+	struct test_instances expected = test_full_grid(&test_desc);
+	LODGE_TEST_CHECK(expected.count > 0);
+
+	lodge_jobs_t jobs = threads_count ? lodge_jobs_new(threads_count) : NULL;
+
+	struct lodge_foliage_cells cells;
+	lodge_foliage_cells_new_inplace(&cells, test_desc, jobs);
+
+	const uint32_t cells_count = test_desc.cells_per_axis * test_desc.cells_per_axis;
+	bool *seen = calloc(cells_count, sizeof(bool));
+	uint32_t seen_count = 0;
+
+	struct test_instances streamed = { 0 };
+
+	const uint32_t frames = 200;
+	for(uint32_t i = 0; i <= frames; i++) {
+		//
+		// Boustrophedon over the terrain; the last update only collects pending cells.
+		//
+		const float t = (float)min(i, frames - 1) / (float)(frames - 1);
+		const float row = floorf(t * 3.999f);
+		const float along = t * 4.0f - row;
+		const vec2 center = vec2_make(((int)row & 1) ? 1.0f - along : along, (row + 0.5f) / 4.0f);
+
+		if(i == frames) {
+			lodge_jobs_wait(jobs, NULL);
+		}
+		lodge_foliage_cells_update(&cells, center, 0.15f, SIZE_MAX);
+		LODGE_TEST_CHECK(cells.stats.cells_evicted == 0);
+
+		for(size_t j = 0; j < cells.resident.count; j++) {
+			const struct lodge_foliage_cell *cell = cells.resident.elements[j];
+			const uint32_t index = cell->x + cell->y * test_desc.cells_per_axis;
+			if(cell->collected && !seen[index]) {
+				seen[index] = true;
+				seen_count++;
+				test_instances_append(&streamed, cell->instances, cell->instances_count);
+			}
+		}
+	}
+
+	LODGE_TEST_CHECK_MSG(seen_count == cells_count, "%u of %u cells streamed", seen_count, cells_count);
+
+	test_instances_sort(&expected);
+	test_instances_sort(&streamed);
+	LODGE_TEST_CHECK_MSG(test_instances_equal(&expected, &streamed), "%zu streamed, %zu expected", streamed.count, expected.count);
+
+	lodge_foliage_cells_free_inplace(&cells);
+	lodge_jobs_free(jobs);
+
+	free(seen);
+	free(streamed.elements);
+	free(expected.elements);
+}
+
+static void test_streamed_union_matches_full_grid()
+{
+	//
+	// Every instruction set the noise runs on, as the cells and the full grid batch the
+	// candidates differently.
+	//
+	const enum lodge_noise_simd simd = lodge_noise_get_simd();
+
+	for(enum lodge_noise_simd i = LODGE_NOISE_SIMD_SCALAR; i < LODGE_NOISE_SIMD_MAX; i++) {
+		if(lodge_noise_set_simd(i)) {
+			test_streamed_union_matches_full_grid_impl(0);
+			test_streamed_union_matches_full_grid_impl(4);
+		}
+	}
+
+	lodge_noise_set_simd(simd);
+}
+
+static uint32_t test_cell_memory(const struct lodge_foliage_cell *cell)
+{
+	return (uint32_t)(sizeof(struct lodge_foliage_cell) + cell->instances_count * sizeof(vec4));
+}
+
+//
+// A camera circling the terrain with room for only a few cells. After each update the
+// cells must fit in the budget, unless every resident cell was requested in that update,
+// and the evicted cells must be the least recently requested ones.
+//
+static void test_lru_eviction_respects_budget()
+{
+	struct lodge_foliage_cells_desc desc = test_desc;
+	desc.cells_per_axis = 16;
+
+	struct lodge_foliage_cells cells;
+	lodge_foliage_cells_new_inplace(&cells, desc, NULL);
+
+	const uint32_t cells_count = desc.cells_per_axis * desc.cells_per_axis;
+	uint32_t *last_requested = calloc(cells_count, sizeof(uint32_t));
+
+	const size_t budget = 8 * 1024;
+	size_t evicted = 0;
+
+	const uint32_t frames = 400;
+	for(uint32_t i = 0; i < frames; i++) {
+		const float angle = i * 0.05f;
+		const vec2 center = vec2_make(0.5f + 0.35f * cosf(angle), 0.5f + 0.35f * sinf(angle));
+
+		for(uint32_t j = 0; j < cells_count; j++) {
+			last_requested[j] = cells.grid[j] ? cells.grid[j]->last_requested : 0;
+		}
+
+		lodge_foliage_cells_update(&cells, center, 0.1f, budget);
+		evicted += cells.stats.cells_evicted;
+
+		uint32_t memory = 0;
+		bool all_requested = true;
+		uint32_t kept_oldest = UINT32_MAX;
+		for(size_t j = 0; j < cells.resident.count; j++) {
+			const struct lodge_foliage_cell *cell = cells.resident.elements[j];
+			memory += test_cell_memory(cell);
+			if(cell->last_requested != cells.tick) {
+				all_requested = false;
+				kept_oldest = min(kept_oldest, cell->last_requested);
+			}
+		}
+
+		LODGE_TEST_CHECK_MSG(memory == cells.stats.memory, "frame %u: %u bytes resident, %u in stats", i, memory, cells.stats.memory);
+		LODGE_TEST_CHECK_MSG(memory <= budget || all_requested, "frame %u: %u bytes resident", i, memory);
+
+		uint32_t evicted_this_frame = 0;
+		for(uint32_t j = 0; j < cells_count; j++) {
+			if(last_requested[j] && !cells.grid[j]) {
+				evicted_this_frame++;
+				LODGE_TEST_CHECK_MSG(last_requested[j] <= kept_oldest, "frame %u: evicted a cell requested at %u, kept one requested at %u", i, last_requested[j], kept_oldest);
+			}
+		}
+		LODGE_TEST_CHECK(evicted_this_frame == cells.stats.cells_evicted);
+	}
+
+	LODGE_TEST_CHECK(evicted > 0);
+
+	lodge_foliage_cells_free_inplace(&cells);
+	free(last_requested);
+}
+
+int main(int argc, char **argv)
+{
+	LODGE_TEST_RUN(test_cell_deterministic);
+	LODGE_TEST_RUN(test_streamed_union_matches_full_grid);
+	LODGE_TEST_RUN(test_lru_eviction_respects_budget);
+	return lodge_test_result();
+}
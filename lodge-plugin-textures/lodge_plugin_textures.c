@@ -22,25 +22,54 @@ enum lodge_plugin_idx
 // TODO(TS): implement reload_inplace() to reuse tex id
 //
 
-static bool lodge_assets_texture_new_inplace(struct lodge_assets2 *textures, strview_t name, lodge_asset_t asset, void *lodge_texture_ptr)
+static enum lodge_asset_state lodge_assets_texture_finalize_inplace(struct lodge_assets2 *textures, strview_t name, lodge_asset_t asset, void *intermediate, lodge_texture_t *texture)
 {
-	lodge_texture_t *texture = (lodge_texture_t *)lodge_texture_ptr;
-
 	struct lodge_assets2 *images = lodge_assets2_get_userdata(textures, USERDATA_IMAGES);
-	ASSERT_OR(images) { return false; }
+	ASSERT_OR(images) { return LODGE_ASSET_STATE_FAILED; }
 
 	lodge_asset_t image_asset = lodge_assets2_register(images, name);
-	ASSERT_OR(image_asset) { return false; }
+	ASSERT_OR(image_asset) { return LODGE_ASSET_STATE_FAILED; }
+
+	//
+	// The image decodes on a worker; the upload is retried until it is ready.
+	//
+	const struct lodge_image *image = lodge_assets2_get_async(images, image_asset);
+	const enum lodge_asset_state image_state = lodge_assets2_get_state(images, image_asset);
+	if(image_state == LODGE_ASSET_STATE_LOADING) {
+		return LODGE_ASSET_STATE_LOADING;
+	} else if(image_state != LODGE_ASSET_STATE_LOADED || !image) {
+		return LODGE_ASSET_STATE_FAILED;
+	}
 
 	lodge_assets2_add_listener(images, image_asset, textures, asset);
-	const struct lodge_image *image = lodge_assets2_get(images, image_asset);
-	if(!image) {
-		return false;
-	}
 
 	*texture = lodge_texture_2d_make_from_image(image);
 
-	return true;
+	return *texture ? LODGE_ASSET_STATE_LOADED : LODGE_ASSET_STATE_FAILED;
+}
+
+//
+// Shown while a texture is loading.
+//
+static bool lodge_assets_texture_new_default_inplace(struct lodge_assets2 *textures, lodge_texture_t *texture)
+{
+	static const uint8_t white[4] = { 255, 255, 255, 255 };
+
+	*texture = lodge_texture_2d_make_from_data(
+		&(struct lodge_texture_2d_desc) {
+			.width = 1,
+			.height = 1,
+			.mipmaps_count = 1,
+			.texture_format = LODGE_TEXTURE_FORMAT_RGBA8,
+		},
+		&(struct lodge_texture_data_desc) {
+			.pixel_format = LODGE_PIXEL_FORMAT_RGBA,
+			.pixel_type = LODGE_PIXEL_TYPE_UINT8,
+			.data = white,
+		}
+	);
+
+	return *texture != NULL;
 }
 
 static void lodge_assets_texture_free_inplace(struct lodge_assets2 *textures, strview_t name, lodge_asset_t asset, lodge_texture_t *texture)
@@ -48,7 +77,10 @@ static void lodge_assets_texture_free_inplace(struct lodge_assets2 *textures, st
 	struct lodge_assets2 *images = lodge_assets2_get_userdata(textures, USERDATA_IMAGES);
 	ASSERT_OR(images) { return; }
 
-	lodge_assets2_remove_listener_by_name(images, name, textures, asset);
+	// The default texture has no asset.
+	if(asset) {
+		lodge_assets2_remove_listener_by_name(images, name, textures, asset);
+	}
 
 	lodge_texture_reset(*texture);
 }
@@ -60,10 +92,12 @@ static struct lodge_ret lodge_textures_new_inplace(struct lodge_assets2 *texture
 	lodge_assets2_new_inplace(textures, &(struct lodge_assets2_desc) {
 		.name = strview("textures"),
 		.size = sizeof(lodge_texture_t),
-		.new_inplace = &lodge_assets_texture_new_inplace,
+		.new_default_inplace = &lodge_assets_texture_new_default_inplace,
 		.reload_inplace = NULL,
-		.free_inplace = &lodge_assets_texture_free_inplace
+		.free_inplace = &lodge_assets_texture_free_inplace,
+		.finalize_inplace = &lodge_assets_texture_finalize_inplace,
 	});
+	lodge_assets2_set_jobs(textures, lodge_plugins_get_jobs(plugins));
 
 	lodge_assets2_set_userdata(textures, USERDATA_IMAGES, images);
 	lodge_assets2_set_userdata(textures, USERDATA_ASSET_TYPE, lodge_type_register_asset(strview("texture"), textures));
@@ -76,6 +110,11 @@ static void lodge_textures_free_inplace(struct lodge_assets2 *textures)
 	lodge_assets2_free_inplace(textures);
 }
 
+static void lodge_textures_update(struct lodge_assets2 *textures, float dt)
+{
+	lodge_assets2_update(textures, LODGE_ASSETS2_UPDATE_BUDGET_MS);
+}
+
 struct texture_types lodge_plugin_textures_get_types(struct lodge_assets2 *textures)
 {
 	return (struct texture_types) {
@@ -91,7 +130,7 @@ LODGE_PLUGIN_IMPL(lodge_plugin_textures)
 		.name = strview("textures"),
 		.new_inplace = &lodge_textures_new_inplace,
 		.free_inplace = &lodge_textures_free_inplace,
-		.update = NULL,
+		.update = &lodge_textures_update,
 		.render = NULL,
 		.dependencies = {
 			.count = PLUGIN_IDX_MAX,
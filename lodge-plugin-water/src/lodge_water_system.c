@@ -247,7 +247,8 @@ lodge_system_type_t lodge_water_system_type_register(struct lodge_plugin_water *
 					.offset = offsetof(struct lodge_water_system, shader_asset),
 				}
 			}
-		}
+		},
+		.flags = LODGE_SYSTEM_TYPE_FLAG_CONCURRENT | LODGE_SYSTEM_TYPE_FLAG_MAIN_THREAD,
 	});
 }
 
@@ -9,6 +9,7 @@
 struct lodge_argv;
 struct lodge_plugin_desc;
 struct lodge_plugins;
+struct lodge_jobs;
 
 struct lodge_plugins_frame_times
 {
@@ -35,6 +36,7 @@ void								lodge_plugins_run(struct lodge_plugins *plugins);
 void								lodge_plugins_set_running(struct lodge_plugins *plugins, bool running);
 void								lodge_plugins_set_delta_time_factor(struct lodge_plugins *plugins, float delta_time_factor);
 struct lodge_plugins_frame_times	lodge_plugins_get_frame_times(struct lodge_plugins *plugins);
+struct lodge_jobs*					lodge_plugins_get_jobs(struct lodge_plugins *plugins);
 
 uint32_t							lodge_plugins_get_count(const struct lodge_plugins *plugins);
 const struct lodge_plugin_desc*		lodge_plugins_get_desc(const struct lodge_plugins *plugins, size_t index);
@@ -5,6 +5,8 @@
 #include "membuf.h"
 
 #include "lodge_time.h"
+#include "lodge_jobs.h"
+#include "lodge_thread.h"
 #include "lodge_argv.h"
 #include "lodge_plugin.h"
 #include "lodge_vfs.h"
@@ -40,6 +42,8 @@ struct lodge_plugins
 	struct lodge_plugins_frame_times	last_frame_times;
 
 	const struct lodge_argv				*args;
+
+	lodge_jobs_t						jobs;
 };
 
 static struct lodge_plugin_desc* lodge_plugins_find_desc_by_name(struct lodge_plugins *plugins, strview_t name)
@@ -253,6 +257,7 @@ void lodge_plugins_free(struct lodge_plugins *plugins)
 		struct lodge_loaded_plugin *plugin = &plugins->loaded[i];
 		lodge_plugin_try_free(plugins, plugin);
 	}
+	lodge_jobs_free(plugins->jobs);
 	free(plugins);
 }
 
@@ -352,6 +357,15 @@ struct lodge_ret lodge_plugins_find(struct lodge_plugins *plugins, const struct
 
 struct lodge_ret lodge_plugins_init(struct lodge_plugins *plugins)
 {
+	//
+	// Worker threads shared by all plugins; `--threads 0` runs all jobs inline.
+	//
+	if(!plugins->jobs) {
+		const uint32_t threads_count = lodge_argv_get_u32(plugins->args, strview("threads"), lodge_thread_get_hardware_concurrency() - 1);
+		plugins->jobs = lodge_jobs_new(threads_count);
+		debugf("Plugins", "Worker threads: %u\n", lodge_jobs_get_threads_count(plugins->jobs));
+	}
+
 	if(plugins->args->positionals.count > 0) {
 		for(const struct lodge_argv_positional* it = lodge_argv_positional_it_begin(plugins->args); it; it = lodge_argv_positional_it_next(plugins->args, it)) {
 			struct lodge_plugin_desc *default_plugin = lodge_plugins_find_desc_by_name(plugins, it->key);
@@ -441,6 +455,11 @@ struct lodge_plugins_frame_times lodge_plugins_get_frame_times(struct lodge_plug
 	return plugins->last_frame_times;
 }
 
+struct lodge_jobs* lodge_plugins_get_jobs(struct lodge_plugins *plugins)
+{
+	return plugins ? plugins->jobs : NULL;
+}
+
 const struct lodge_plugin_desc* lodge_plugins_get_desc(const struct lodge_plugins *plugins, size_t index)
 {
 	return (index >= 0 && index < plugins->descriptions_count) ? plugins->loaded[index].desc : NULL;
@@ -1,16 +1,82 @@
 #include "lodge_filewatch.h"
 
 #include "membuf.h"
+#include "dynbuf.h"
 #include "strbuf.h"
 
+#include "lodge_platform.h"
 #include "lodge_assert.h"
+#include "lodge_time.h"
 
 #include <string.h>
 
-#define LODGE_FILEWATCH_EVENT_QUEUE_MAX	256
 #define LODGE_FILEWATCH_DIRS_MAX		256
 #define LODGE_FILWATCH_PATH_MAX			4096
 
+struct lodge_filewatch_event
+{
+	size_t							entry_index;
+	char							path[LODGE_FILWATCH_PATH_MAX];
+	enum lodge_filewatch_reason		reason;
+	lodge_timestamp_t				last;
+};
+
+struct lodge_filewatch_events
+{
+	size_t							count;
+	size_t							capacity;
+	struct lodge_filewatch_event	*elements;
+};
+
+static enum lodge_filewatch_reason lodge_filewatch_reason_merge(enum lodge_filewatch_reason prev, enum lodge_filewatch_reason next)
+{
+	if(prev == LODGE_FILEWATCH_REASON_FILE_CREATED && next == LODGE_FILEWATCH_REASON_FILE_MODIFIED) {
+		return LODGE_FILEWATCH_REASON_FILE_CREATED;
+	} else if(prev == LODGE_FILEWATCH_REASON_FILE_DELETED && next == LODGE_FILEWATCH_REASON_FILE_CREATED) {
+		return LODGE_FILEWATCH_REASON_FILE_MODIFIED;
+	} else if(prev == LODGE_FILEWATCH_REASON_DIR_CREATED && next == LODGE_FILEWATCH_REASON_DIR_MODIFIED) {
+		return LODGE_FILEWATCH_REASON_DIR_CREATED;
+	}
+	return next;
+}
+
+static void lodge_filewatch_events_push(struct lodge_filewatch_events *events, size_t entry_index, strview_t path, enum lodge_filewatch_reason reason)
+{
+	for(size_t i = 0; i < events->count; i++) {
+		struct lodge_filewatch_event *event = &events->elements[i];
+		if(event->entry_index == entry_index && strview_equals(strview_wrap(event->path), path)) {
+			event->reason = lodge_filewatch_reason_merge(event->reason, reason);
+			event->last = lodge_timestamp_get();
+			return;
+		}
+	}
+
+	struct lodge_filewatch_event *event = dynbuf_append_no_init(dynbuf_ptr(events));
+	ASSERT_OR(event) { return; }
+	event->entry_index = entry_index;
+	strbuf_set(strbuf_wrap(event->path), path);
+	event->reason = reason;
+	event->last = lodge_timestamp_get();
+}
+
+//
+// Fires events that have been quiet for the debounce window, in the order they first arrived.
+//
+static void lodge_filewatch_events_flush(struct lodge_filewatch_events *events, lodge_filewatch_func_t funcs[], void *userdatas[])
+{
+	for(size_t i = 0; i < events->count;) {
+		if(lodge_timestamp_elapsed_ms(events->elements[i].last) < LODGE_FILEWATCH_DEBOUNCE_MS) {
+			i++;
+			continue;
+		}
+
+		const struct lodge_filewatch_event event = events->elements[i];
+		dynbuf_remove(dynbuf_ptr(events), i, 1);
+
+		funcs[event.entry_index](strview_wrap(event.path), event.reason, userdatas[event.entry_index]);
+	}
+}
+
 #ifdef _WIN32
 
 // NOTE: This Windows API is horrible.
@@ -27,9 +93,8 @@
 //		- Add support for watching individual files. This will add a dir watch internally,
 //		  but allows registering a separate callback for that individual file.
 //
-//		- Add event delayed + filter for file events. We are currently getting multiple CHANGE
-//		  events for files saved with Notepad for instance. We should record the events and
-//		  wait for a timeout, and then send an event with a bitfield of events fired.
+//		- Send a bitfield of the events that were merged by the debounce, instead of only the
+//		  merged reason.
 //
 
 #include <stdio.h>
@@ -50,13 +115,6 @@ struct lodge_filewatch_entry
 	OVERLAPPED						overlapped;
 };
 
-struct lodge_filewatch_event
-{
-	size_t							entry_index;
-	char							path[LODGE_FILWATCH_PATH_MAX];
-	enum lodge_filewatch_reason		reason;
-};
-
 struct lodge_filewatch
 {
 	size_t							count;
@@ -65,8 +123,7 @@ struct lodge_filewatch
 
 	struct lodge_filewatch_entry	entries[LODGE_FILEWATCH_DIRS_MAX];
 
-	struct lodge_filewatch_event	event_queue[LODGE_FILEWATCH_EVENT_QUEUE_MAX];
-	size_t							event_queue_count;
+	struct lodge_filewatch_events	events;
 
 	HANDLE							io_completion_port_handle;
 };
@@ -97,12 +154,11 @@ static void lodge_filewatch_queue_events(struct lodge_filewatch *filewatch, stru
     for(;;) {
         const FILE_NOTIFY_INFORMATION* file_notify_info = (const FILE_NOTIFY_INFORMATION*)pos;
 
-		size_t event_index = filewatch->event_queue_count++;
-		struct lodge_filewatch_event *event = &filewatch->event_queue[event_index];
-		event->entry_index = entry->index;
-		event->reason = lodge_filewatch_action_to_reason(file_notify_info->Action);
-		//strbuf_setf(strbuf_wrap(event->path), "%s/%.*ls", watch->path, file_notify_info->FileNameLength, file_notify_info->FileName);
-		strbuf_setf(strbuf_wrap(event->path), "%.*ls", file_notify_info->FileNameLength, file_notify_info->FileName);
+		// `FileNameLength` is in bytes.
+		char path[LODGE_FILWATCH_PATH_MAX];
+		strbuf_setf(strbuf_wrap(path), "%s/%.*ls", entry->path, (int)(file_notify_info->FileNameLength / sizeof(WCHAR)), file_notify_info->FileName);
+
+		lodge_filewatch_events_push(&filewatch->events, entry->index, strview_wrap(path), lodge_filewatch_action_to_reason(file_notify_info->Action));
 
         const DWORD offset = file_notify_info->NextEntryOffset;
         if(!offset) {
@@ -114,13 +170,7 @@ static void lodge_filewatch_queue_events(struct lodge_filewatch *filewatch, stru
 
 static void lodge_filewatch_broadcast_events(struct lodge_filewatch *filewatch)
 {
-	for(size_t i = 0; i < filewatch->event_queue_count; i++) {
-		struct lodge_filewatch_event *event = &filewatch->event_queue[i];
-		const size_t dir_index = event->entry_index;
-		filewatch->funcs[dir_index](strbuf_wrap_and(event->path, strbuf_to_strview), event->reason, filewatch->userdatas[dir_index]);
-	}
-
-	filewatch->event_queue_count = 0;
+	lodge_filewatch_events_flush(&filewatch->events, filewatch->funcs, filewatch->userdatas);
 }
 
 static void lodge_filewatch_poll(struct lodge_filewatch *filewatch)
@@ -170,6 +220,7 @@ void lodge_filewatch_free(struct lodge_filewatch *filewatch)
 	BOOL ret = CloseHandle(filewatch->io_completion_port_handle);
 	ASSERT(ret);
 
+	dynbuf_free_inplace(dynbuf(filewatch->events));
 	free(filewatch);
 }
 
@@ -229,25 +280,302 @@ void lodge_filewatch_add_dir(struct lodge_filewatch *filewatch, strview_t dir, b
 
 #else
 
-struct lodge_filewatch* lodge_filewatch_new()
+//
+// inotify backend.
+//
+// inotify watches are not recursive, so every directory below a recursive root gets its
+// own watch. Directories created (or moved in) later are watched as they appear, and
+// files already inside them are reported as created since their own events may have
+// been missed.
+//
+
+#include "lodge_log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#define LODGE_FILEWATCH_INOTIFY_MASK	(IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+
+struct lodge_filewatch_watch
+{
+	int								wd;
+	size_t							entry_index;
+	char							path[LODGE_FILWATCH_PATH_MAX];
+};
+
+//
+// Sorted by `wd`, which the kernel hands out in increasing order.
+//
+struct lodge_filewatch_watches
+{
+	size_t							count;
+	size_t							capacity;
+	struct lodge_filewatch_watch	*elements;
+};
+
+struct lodge_filewatch
+{
+	size_t							count;
+	lodge_filewatch_func_t			funcs[LODGE_FILEWATCH_DIRS_MAX];
+	void*							userdatas[LODGE_FILEWATCH_DIRS_MAX];
+	bool							recursive[LODGE_FILEWATCH_DIRS_MAX];
+
+	int								fd;
+	struct lodge_filewatch_watches	watches;
+	struct lodge_filewatch_events	events;
+};
+
+static struct lodge_filewatch_watch* lodge_filewatch_find_watch(struct lodge_filewatch *filewatch, int wd)
 {
-	ASSERT_NOT_IMPLEMENTED();
+	size_t lo = 0;
+	size_t hi = filewatch->watches.count;
+	while(lo < hi) {
+		const size_t mid = lo + (hi - lo) / 2;
+		struct lodge_filewatch_watch *watch = &filewatch->watches.elements[mid];
+		if(watch->wd == wd) {
+			return watch;
+		} else if(watch->wd < wd) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
 	return NULL;
 }
 
+static void lodge_filewatch_remove_watch(struct lodge_filewatch *filewatch, int wd)
+{
+	struct lodge_filewatch_watch *watch = lodge_filewatch_find_watch(filewatch, wd);
+	if(watch) {
+		dynbuf_remove(dynbuf(filewatch->watches), watch - filewatch->watches.elements, 1);
+	}
+}
+
+static bool lodge_filewatch_add_watch(struct lodge_filewatch *filewatch, size_t entry_index, const char *path)
+{
+	const int wd = inotify_add_watch(filewatch->fd, path, LODGE_FILEWATCH_INOTIFY_MASK);
+	if(wd < 0) {
+		return false;
+	}
+
+	//
+	// Already watched (the same dir reached twice): the kernel returned the existing `wd`.
+	//
+	if(lodge_filewatch_find_watch(filewatch, wd)) {
+		return true;
+	}
+
+	struct lodge_filewatch_watch *watch = dynbuf_append_no_init(dynbuf(filewatch->watches));
+	ASSERT_OR(watch) { return false; }
+	watch->wd = wd;
+	watch->entry_index = entry_index;
+	strbuf_set(strbuf_wrap(watch->path), strview_make(path, strlen(path)));
+
+	//
+	// New descriptors are almost always the largest; keep the order if one is reused.
+	//
+	for(size_t i = filewatch->watches.count - 1; i > 0 && filewatch->watches.elements[i - 1].wd > wd; i--) {
+		const struct lodge_filewatch_watch tmp = filewatch->watches.elements[i - 1];
+		filewatch->watches.elements[i - 1] = filewatch->watches.elements[i];
+		filewatch->watches.elements[i] = tmp;
+	}
+	return true;
+}
+
+//
+// Watches `path` and, if recursive, all directories below it. With `report_files`, files
+// found on the way are queued as created. Returns false if `path` itself could not be watched.
+//
+static bool lodge_filewatch_add_tree(struct lodge_filewatch *filewatch, size_t entry_index, const char *path, bool report_files)
+{
+	if(!lodge_filewatch_add_watch(filewatch, entry_index, path)) {
+		return false;
+	}
+
+	if(!filewatch->recursive[entry_index] && !report_files) {
+		return true;
+	}
+
+	DIR *dir = opendir(path);
+	if(!dir) {
+		return true;
+	}
+
+	char child_path[LODGE_FILWATCH_PATH_MAX];
+	for(struct dirent *it = readdir(dir); it; it = readdir(dir)) {
+		if(strcmp(it->d_name, ".") == 0 || strcmp(it->d_name, "..") == 0) {
+			continue;
+		}
+
+		strbuf_setf(strbuf_wrap(child_path), "%s/%s", path, it->d_name);
+
+		bool is_dir = (it->d_type == DT_DIR);
+		if(it->d_type == DT_UNKNOWN) {
+			struct stat st;
+			is_dir = (stat(child_path, &st) == 0) && S_ISDIR(st.st_mode);
+		}
+
+		if(is_dir) {
+			if(filewatch->recursive[entry_index]) {
+				lodge_filewatch_add_tree(filewatch, entry_index, child_path, report_files);
+			}
+		} else if(report_files) {
+			lodge_filewatch_events_push(&filewatch->events, entry_index, strbuf_wrap_and(child_path, strbuf_to_strview), LODGE_FILEWATCH_REASON_FILE_CREATED);
+		}
+	}
+
+	closedir(dir);
+	return true;
+}
+
+//
+// A directory moved away keeps its watches, but they would report the old path.
+//
+static void lodge_filewatch_remove_tree(struct lodge_filewatch *filewatch, strview_t path)
+{
+	for(size_t i = 0; i < filewatch->watches.count;) {
+		struct lodge_filewatch_watch *watch = &filewatch->watches.elements[i];
+		const strview_t watch_path = strview_wrap(watch->path);
+		if(strview_begins_with(watch_path, path)
+			&& (watch_path.length == path.length || watch_path.s[path.length] == '/')) {
+			inotify_rm_watch(filewatch->fd, watch->wd);
+			dynbuf_remove(dynbuf(filewatch->watches), i, 1);
+		} else {
+			i++;
+		}
+	}
+}
+
+static enum lodge_filewatch_reason lodge_filewatch_mask_to_reason(uint32_t mask)
+{
+	const bool is_dir = (mask & IN_ISDIR);
+	if(mask & IN_CREATE) {
+		return is_dir ? LODGE_FILEWATCH_REASON_DIR_CREATED : LODGE_FILEWATCH_REASON_FILE_CREATED;
+	} else if(mask & IN_DELETE) {
+		return is_dir ? LODGE_FILEWATCH_REASON_DIR_DELETED : LODGE_FILEWATCH_REASON_FILE_DELETED;
+	} else if(mask & (IN_MOVED_FROM | IN_MOVED_TO)) {
+		return is_dir ? LODGE_FILEWATCH_REASON_DIR_MODIFIED : LODGE_FILEWATCH_REASON_FILE_RENAMED;
+	} else {
+		return is_dir ? LODGE_FILEWATCH_REASON_DIR_MODIFIED : LODGE_FILEWATCH_REASON_FILE_MODIFIED;
+	}
+}
+
+static void lodge_filewatch_handle_event(struct lodge_filewatch *filewatch, const struct inotify_event *event)
+{
+	if(event->mask & IN_Q_OVERFLOW) {
+		lodge_log(LODGE_LOG_LEVEL_WARNING, strview("Filewatch"), strview("inotify queue overflow, file events were lost\n"));
+		return;
+	}
+
+	if(event->mask & IN_IGNORED) {
+		lodge_filewatch_remove_watch(filewatch, event->wd);
+		return;
+	}
+
+	if(event->len == 0) {
+		return;
+	}
+
+	struct lodge_filewatch_watch *watch = lodge_filewatch_find_watch(filewatch, event->wd);
+	if(!watch) {
+		return;
+	}
+
+	const size_t entry_index = watch->entry_index;
+
+	char path[LODGE_FILWATCH_PATH_MAX];
+	strbuf_setf(strbuf_wrap(path), "%s/%s", watch->path, event->name);
+
+	lodge_filewatch_events_push(&filewatch->events, entry_index, strbuf_wrap_and(path, strbuf_to_strview), lodge_filewatch_mask_to_reason(event->mask));
+
+	if((event->mask & IN_ISDIR) && filewatch->recursive[entry_index]) {
+		if(event->mask & (IN_CREATE | IN_MOVED_TO)) {
+			lodge_filewatch_add_tree(filewatch, entry_index, path, true);
+		} else if(event->mask & IN_MOVED_FROM) {
+			lodge_filewatch_remove_tree(filewatch, strbuf_wrap_and(path, strbuf_to_strview));
+		}
+	}
+}
+
+static void lodge_filewatch_poll(struct lodge_filewatch *filewatch)
+{
+	_Alignas(struct inotify_event) char buf[16 * 1024];
+
+	for(;;) {
+		const ssize_t len = read(filewatch->fd, buf, sizeof(buf));
+		if(len <= 0) {
+			ASSERT(len == 0 || errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+			return;
+		}
+
+		for(const char *it = buf; it < buf + len;) {
+			const struct inotify_event *event = (const struct inotify_event *)it;
+			lodge_filewatch_handle_event(filewatch, event);
+			it += sizeof(struct inotify_event) + event->len;
+		}
+	}
+}
+
+struct lodge_filewatch* lodge_filewatch_new()
+{
+	struct lodge_filewatch *filewatch = (struct lodge_filewatch*) calloc(1, sizeof(struct lodge_filewatch));
+	ASSERT_OR(filewatch) { return NULL; }
+
+	filewatch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	ASSERT_OR(filewatch->fd >= 0) {
+		free(filewatch);
+		return NULL;
+	}
+
+	return filewatch;
+}
+
 void lodge_filewatch_free(struct lodge_filewatch *filewatch)
 {
-	ASSERT_NOT_IMPLEMENTED();
+	if(!filewatch) {
+		return;
+	}
+
+	// Closing the inotify instance removes all its watches.
+	close(filewatch->fd);
+
+	dynbuf_free_inplace(dynbuf(filewatch->watches));
+	dynbuf_free_inplace(dynbuf(filewatch->events));
+	free(filewatch);
 }
 
 void lodge_filewatch_update(struct lodge_filewatch *filewatch, float dt)
 {
-	ASSERT_NOT_IMPLEMENTED();
+	if(!filewatch) {
+		return;
+	}
+
+	// Never blocks: the inotify fd is non-blocking.
+	lodge_filewatch_poll(filewatch);
+	lodge_filewatch_events_flush(&filewatch->events, filewatch->funcs, filewatch->userdatas);
 }
 
 void lodge_filewatch_add_dir(struct lodge_filewatch *filewatch, strview_t dir, bool recursive, lodge_filewatch_func_t func, void *func_userdata)
 {
-	ASSERT_NOT_IMPLEMENTED();
+	ASSERT_OR(filewatch && func) { return; }
+	ASSERT_OR(filewatch->count < LODGE_FILEWATCH_DIRS_MAX) { return; }
+
+	const size_t index = filewatch->count++;
+	filewatch->funcs[index] = func;
+	filewatch->userdatas[index] = func_userdata;
+	filewatch->recursive[index] = recursive;
+
+	char path[LODGE_FILWATCH_PATH_MAX];
+	strbuf_set(strbuf_wrap(path), dir);
+
+	if(!lodge_filewatch_add_tree(filewatch, index, path, false)) {
+		ASSERT_FAIL("Failed to watch dir");
+	}
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -5,6 +5,12 @@
 
 #include <stdbool.h>
 
+//
+// Events for the same path are merged until no new event has arrived for
+// this long, so a save that touches a file several times fires only once.
+//
+#define LODGE_FILEWATCH_DEBOUNCE_MS		100.0
+
 // TODO(TS):
 //		- Add _add_file() varaint of _add_dir -- this can use _add_dir internally but will register a separate callback for the specific file
 //		- Add _remove_dir(), _remove_file() API
@@ -0,0 +1,102 @@
+#include "lodge_pack.h"
+
+#include <string.h>
+
+uint32_t lodge_pack_hash(strview_t name)
+{
+	uint32_t hash = 2166136261u;
+	for(size_t i = 0; i < name.length; i++) {
+		hash ^= (uint8_t)name.s[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+int lodge_pack_entry_compare(const struct lodge_pack_entry *lhs, strview_t lhs_name, const struct lodge_pack_entry *rhs, strview_t rhs_name)
+{
+	if(lhs->name_hash != rhs->name_hash) {
+		return lhs->name_hash < rhs->name_hash ? -1 : 1;
+	}
+
+	const size_t common_length = lhs_name.length < rhs_name.length ? lhs_name.length : rhs_name.length;
+	const int ret = memcmp(lhs_name.s, rhs_name.s, common_length);
+	if(ret != 0) {
+		return ret;
+	}
+	return (lhs_name.length > rhs_name.length) - (lhs_name.length < rhs_name.length);
+}
+
+bool lodge_pack_init(struct lodge_pack *pack, const void *data, size_t size)
+{
+	const struct lodge_pack_header *header = (const struct lodge_pack_header *)data;
+
+	if(size < sizeof(struct lodge_pack_header)
+		|| memcmp(header->magic, LODGE_PACK_MAGIC, sizeof(header->magic)) != 0
+		|| header->version != LODGE_PACK_VERSION) {
+		return false;
+	}
+
+	const uint64_t entries_size = (uint64_t)header->entries_count * sizeof(struct lodge_pack_entry);
+	if(header->entries_offset > size
+		|| entries_size > size - header->entries_offset
+		|| (header->entries_offset % sizeof(uint64_t)) != 0
+		|| header->names_offset > size
+		|| header->names_size > size - header->names_offset) {
+		return false;
+	}
+
+	const struct lodge_pack_entry *entries = (const struct lodge_pack_entry *)((const char *)data + header->entries_offset);
+	for(uint32_t i = 0; i < header->entries_count; i++) {
+		const struct lodge_pack_entry *entry = &entries[i];
+		if(entry->name_offset > header->names_size
+			|| entry->name_length > header->names_size - entry->name_offset
+			|| entry->offset > size
+			|| entry->size >= size - entry->offset
+			|| ((const char *)data)[entry->offset + entry->size] != '\0') {
+			return false;
+		}
+	}
+
+	*pack = (struct lodge_pack) {
+		.data = (const char *)data,
+		.size = size,
+		.header = header,
+		.entries = entries,
+		.names = (const char *)data + header->names_offset,
+	};
+	return true;
+}
+
+strview_t lodge_pack_entry_name(const struct lodge_pack *pack, const struct lodge_pack_entry *entry)
+{
+	return strview_make(pack->names + entry->name_offset, entry->name_length);
+}
+
+size_t lodge_pack_entries_count(const struct lodge_pack *pack)
+{
+	return pack->header ? pack->header->entries_count : 0;
+}
+
+const struct lodge_pack_entry* lodge_pack_find(const struct lodge_pack *pack, strview_t name)
+{
+	const struct lodge_pack_entry needle = {
+		.name_hash = lodge_pack_hash(name),
+	};
+
+	size_t lo = 0;
+	size_t hi = lodge_pack_entries_count(pack);
+	while(lo < hi) {
+		const size_t mid = lo + (hi - lo) / 2;
+		const struct lodge_pack_entry *entry = &pack->entries[mid];
+		const int ret = lodge_pack_entry_compare(entry, lodge_pack_entry_name(pack, entry), &needle, name);
+		if(ret == 0) {
+			return entry;
+		} else if(ret < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return NULL;
+}
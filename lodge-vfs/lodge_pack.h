@@ -0,0 +1,87 @@
+//
+// Pack archive: a single file holding a directory tree, for shipping builds.
+//
+// Layout (little endian):
+//
+//		struct lodge_pack_header
+//		struct lodge_pack_entry		entries[entries_count]	(sorted by `name_hash`, then name)
+//		char						names[names_size]		(not terminated)
+//		...							entry data, each at a multiple of `alignment`
+//
+// Every entry's data is followed by at least one `\0` byte, so uncompressed entries can be
+// parsed as text in place. Names are relative to the pack root and use `/`.
+//
+#ifndef _LODGE_PACK_H
+#define _LODGE_PACK_H
+
+#include "strview.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define LODGE_PACK_EXTENSION			".lpak"
+#define LODGE_PACK_MAGIC				"LPAK"
+#define LODGE_PACK_VERSION				1
+#define LODGE_PACK_ALIGNMENT_DEFAULT	64
+
+enum lodge_pack_entry_flags
+{
+	LODGE_PACK_ENTRY_COMPRESSED			= 1 << 0,	// zlib stream, see `stbi_zlib_decode_buffer()`.
+};
+
+struct lodge_pack_header
+{
+	char								magic[4];
+	uint32_t							version;
+	uint32_t							entries_count;
+	uint32_t							alignment;
+	uint64_t							entries_offset;
+	uint64_t							names_offset;
+	uint64_t							names_size;
+};
+
+struct lodge_pack_entry
+{
+	uint32_t							name_hash;
+	uint32_t							name_offset;		// Into the names block.
+	uint32_t							name_length;
+	uint32_t							flags;
+	uint64_t							offset;				// From the start of the pack.
+	uint64_t							size;				// Stored size.
+	uint64_t							uncompressed_size;
+};
+
+//
+// A pack in memory (usually a mapped file). Does not own the data.
+//
+struct lodge_pack
+{
+	const char							*data;
+	size_t								size;
+	const struct lodge_pack_header		*header;
+	const struct lodge_pack_entry		*entries;
+	const char							*names;
+};
+
+//
+// Validates the header and every entry, including the `\0` after its data, so lookups
+// need no further bounds checks and uncompressed entries can be used as text.
+//
+bool									lodge_pack_init(struct lodge_pack *pack, const void *data, size_t size);
+
+const struct lodge_pack_entry*			lodge_pack_find(const struct lodge_pack *pack, strview_t name);
+strview_t								lodge_pack_entry_name(const struct lodge_pack *pack, const struct lodge_pack_entry *entry);
+size_t									lodge_pack_entries_count(const struct lodge_pack *pack);
+
+//
+// Stable on disk, so it does not use `strview_calc_hash()` (murmur3), which may change.
+//
+uint32_t								lodge_pack_hash(strview_t name);
+
+//
+// Orders entries the way `lodge_pack_find()` expects them.
+//
+int										lodge_pack_entry_compare(const struct lodge_pack_entry *lhs, strview_t lhs_name, const struct lodge_pack_entry *rhs, strview_t rhs_name);
+
+#endif
@@ -0,0 +1,246 @@
+//
+// lodge-pack: packs a directory tree into a single `.lpak` file that `lodge_vfs_mount()`
+// can mount in place of the directory.
+//
+// Usage: lodge-pack [--align <bytes>] [--compress] <input dir> <output.lpak>
+//
+
+#include "lodge_pack.h"
+
+#include "strbuf.h"
+#include "lodge_platform.h"
+
+#include "stb/deprecated/stb.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb/stb_image_write.h> // for stbi_zlib_compress()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+//
+// Compressed entries are only kept if they save at least this much, since they can not
+// be served straight from the mapping.
+//
+#define LODGE_PACK_TOOL_COMPRESS_RATIO_MAX	0.9
+
+struct lodge_pack_tool_file
+{
+	struct lodge_pack_entry				entry;
+	char								name[4096];
+	char								*data;					// Stored data, compressed or not.
+};
+
+static uint64_t lodge_pack_tool_align(uint64_t offset, uint64_t alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+static int lodge_pack_tool_file_compare(const void *lhs_ptr, const void *rhs_ptr)
+{
+	const struct lodge_pack_tool_file *lhs = (const struct lodge_pack_tool_file *)lhs_ptr;
+	const struct lodge_pack_tool_file *rhs = (const struct lodge_pack_tool_file *)rhs_ptr;
+	return lodge_pack_entry_compare(&lhs->entry, strview_make(lhs->name, strlen(lhs->name)), &rhs->entry, strview_make(rhs->name, strlen(rhs->name)));
+}
+
+static bool lodge_pack_tool_write_zeroes(FILE *file, uint64_t count)
+{
+	static const char zeroes[4096] = { 0 };
+	while(count > 0) {
+		const size_t n = (size_t)min(count, sizeof(zeroes));
+		if(fwrite(zeroes, 1, n, file) != n) {
+			return false;
+		}
+		count -= n;
+	}
+	return true;
+}
+
+static bool lodge_pack_tool_write(const char *output_path, struct lodge_pack_tool_file *files, uint32_t files_count, uint32_t alignment)
+{
+	struct lodge_pack_header header = {
+		.magic = { 'L', 'P', 'A', 'K' },
+		.version = LODGE_PACK_VERSION,
+		.entries_count = files_count,
+		.alignment = alignment,
+		.entries_offset = sizeof(struct lodge_pack_header),
+	};
+	header.names_offset = header.entries_offset + (uint64_t)files_count * sizeof(struct lodge_pack_entry);
+
+	uint64_t names_size = 0;
+	for(uint32_t i = 0; i < files_count; i++) {
+		files[i].entry.name_offset = (uint32_t)names_size;
+		names_size += files[i].entry.name_length;
+	}
+	header.names_size = names_size;
+
+	//
+	// Data follows, each entry aligned and followed by at least one `\0`.
+	//
+	uint64_t offset = header.names_offset + header.names_size;
+	for(uint32_t i = 0; i < files_count; i++) {
+		offset = lodge_pack_tool_align(offset, alignment);
+		files[i].entry.offset = offset;
+		offset += files[i].entry.size + 1;
+	}
+
+	FILE *file = fopen(output_path, "wb");
+	if(!file) {
+		fprintf(stderr, "Could not open `%s` for writing\n", output_path);
+		return false;
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	for(uint32_t i = 0; ok && i < files_count; i++) {
+		ok = fwrite(&files[i].entry, sizeof(struct lodge_pack_entry), 1, file) == 1;
+	}
+	for(uint32_t i = 0; ok && i < files_count; i++) {
+		ok = fwrite(files[i].name, 1, files[i].entry.name_length, file) == files[i].entry.name_length;
+	}
+
+	uint64_t written = header.names_offset + header.names_size;
+	for(uint32_t i = 0; ok && i < files_count; i++) {
+		const struct lodge_pack_entry *entry = &files[i].entry;
+		ok = lodge_pack_tool_write_zeroes(file, entry->offset - written)
+			&& fwrite(files[i].data, 1, (size_t)entry->size, file) == entry->size
+			&& lodge_pack_tool_write_zeroes(file, 1);
+		written = entry->offset + entry->size + 1;
+	}
+
+	if(fclose(file) != 0) {
+		ok = false;
+	}
+	if(!ok) {
+		fprintf(stderr, "Failed to write `%s`\n", output_path);
+	}
+	return ok;
+}
+
+static void lodge_pack_tool_usage()
+{
+	fprintf(stderr, "Usage: lodge-pack [--align <bytes>] [--compress] <input dir> <output" LODGE_PACK_EXTENSION ">\n");
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t alignment = LODGE_PACK_ALIGNMENT_DEFAULT;
+	bool compress = false;
+	const char *input_dir = NULL;
+	const char *output_path = NULL;
+
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--align") == 0 && i + 1 < argc) {
+			alignment = (uint32_t)strtoul(argv[++i], NULL, 10);
+		} else if(strcmp(argv[i], "--compress") == 0) {
+			compress = true;
+		} else if(!input_dir) {
+			input_dir = argv[i];
+		} else if(!output_path) {
+			output_path = argv[i];
+		} else {
+			lodge_pack_tool_usage();
+			return 1;
+		}
+	}
+
+	if(!input_dir || !output_path || alignment == 0 || (alignment & (alignment - 1)) != 0) {
+		lodge_pack_tool_usage();
+		return 1;
+	}
+
+	char input_dir_buf[4096];
+	strbuf_set(strbuf_wrap(input_dir_buf), strview_make(input_dir, strlen(input_dir)));
+	size_t input_dir_length = strlen(input_dir_buf);
+	if(input_dir_length > 0 && (input_dir_buf[input_dir_length - 1] == '/' || input_dir_buf[input_dir_length - 1] == '\\')) {
+		input_dir_buf[--input_dir_length] = '\0';
+	}
+
+	char **filenames = stb_readdir_recursive(input_dir_buf, NULL);
+	if(!filenames) {
+		fprintf(stderr, "Could not read `%s`\n", input_dir_buf);
+		return 1;
+	}
+
+	const uint32_t files_count = (uint32_t)stb_arr_len(filenames);
+	struct lodge_pack_tool_file *files = (struct lodge_pack_tool_file *)calloc(max(files_count, 1), sizeof(struct lodge_pack_tool_file));
+	if(!files) {
+		stb_readdir_free(filenames);
+		return 1;
+	}
+
+	uint64_t bytes_in = 0;
+	uint64_t bytes_stored = 0;
+	uint32_t compressed_count = 0;
+
+	for(uint32_t i = 0; i < files_count; i++) {
+		struct lodge_pack_tool_file *file = &files[i];
+
+		// Relative to the input dir, always with `/`.
+		strbuf_set(strbuf_wrap(file->name), strview_make(filenames[i] + input_dir_length + 1, strlen(filenames[i]) - input_dir_length - 1));
+		for(char *it = file->name; *it; it++) {
+			if(*it == '\\') {
+				*it = '/';
+			}
+		}
+
+		size_t size = 0;
+		file->data = stb_file(filenames[i], &size);
+		if(!file->data) {
+			fprintf(stderr, "Could not read `%s`\n", filenames[i]);
+			stb_readdir_free(filenames);
+			return 1;
+		}
+
+		const strview_t name = strview_make(file->name, strlen(file->name));
+		file->entry = (struct lodge_pack_entry) {
+			.name_hash = lodge_pack_hash(name),
+			.name_length = (uint32_t)name.length,
+			.size = size,
+			.uncompressed_size = size,
+		};
+
+		if(compress && size > 0 && size < INT32_MAX) {
+			int compressed_size = 0;
+			unsigned char *compressed = stbi_zlib_compress((unsigned char *)file->data, (int)size, &compressed_size, 8);
+			if(compressed && compressed_size < size * LODGE_PACK_TOOL_COMPRESS_RATIO_MAX) {
+				free(file->data);
+				file->data = (char *)compressed;
+				file->entry.size = (uint64_t)compressed_size;
+				file->entry.flags |= LODGE_PACK_ENTRY_COMPRESSED;
+				compressed_count++;
+			} else {
+				free(compressed);
+			}
+		}
+
+		bytes_in += file->entry.uncompressed_size;
+		bytes_stored += file->entry.size;
+	}
+
+	stb_readdir_free(filenames);
+
+	qsort(files, files_count, sizeof(struct lodge_pack_tool_file), &lodge_pack_tool_file_compare);
+
+	for(uint32_t i = 1; i < files_count; i++) {
+		if(lodge_pack_tool_file_compare(&files[i - 1], &files[i]) == 0) {
+			fprintf(stderr, "Duplicate entry `%s`\n", files[i].name);
+			return 1;
+		}
+	}
+
+	const bool ok = lodge_pack_tool_write(output_path, files, files_count, alignment);
+
+	if(ok) {
+		printf("%s: %u files, %llu bytes (%llu stored, %u compressed)\n", output_path, files_count,
+			(unsigned long long)bytes_in, (unsigned long long)bytes_stored, compressed_count);
+	}
+
+	for(uint32_t i = 0; i < files_count; i++) {
+		free(files[i].data);
+	}
+	free(files);
+
+	return ok ? 0 : 1;
+}
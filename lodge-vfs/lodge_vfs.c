@@ -9,14 +9,31 @@
 #include "membuf.h"
 #include "dynbuf.h"
 #include "lodge_platform.h"
+#include "lodge_thread.h"
 #include "lodge_filewatch.h"
+#include "lodge_pack.h"
 
 #include "stb/deprecated/stb.h"
+#include <stb/stb_image.h> // for stbi_zlib_decode_buffer()
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+struct lodge_vfs_file_mapping;
 
 struct lodge_vfs_mount
 {
 	char							point[LODGE_VFS_MOUNT_POINT_MAX];
 	char							path[LODGE_VFS_MOUNT_PATH_MAX];
+
+	struct lodge_pack				pack;					// Only for pack mounts.
+	struct lodge_vfs_file_mapping	*pack_mapping;
 };
 
 struct lodge_vfs_func
@@ -46,10 +63,16 @@ struct lodge_vfs_file_entries
 	struct lodge_vfs_file_entry		*elements;
 };
 
+//
+// Mounts are only ever appended, and fully set up before `mounts_count` is bumped
+// under `mounts_mutex`. Readers on other threads take the count under the same
+// mutex and can then use the mounts below it without holding it.
+//
 struct lodge_vfs
 {
 	struct lodge_vfs_mount			mounts[LODGE_VFS_MOUNT_POINTS_MAX];
 	size_t							mounts_count;
+	lodge_mutex_t					mounts_mutex;
 
 	struct lodge_vfs_file_entries	file_entries;
 	struct lodge_vfs_funcs			global_funcs;
@@ -60,8 +83,18 @@ struct lodge_vfs
 	struct lodge_filewatch			*filewatch;
 };
 
+//
+// Callbacks are keyed on the virtual path without its leading `/`, so `/a.png` and
+// `a.png` name the same file.
+//
+static strview_t lodge_vfs_strip_root(strview_t virtual_path)
+{
+	return (virtual_path.length > 0 && virtual_path.s[0] == '/') ? strview_substring_from_start(virtual_path, 1) : virtual_path;
+}
+
 static struct lodge_vfs_file_entry* lodge_vfs_get_func_entry(struct lodge_vfs *vfs, strview_t virtual_path)
 {
+	virtual_path = lodge_vfs_strip_root(virtual_path);
 	uint32_t virtual_path_hash = strview_calc_hash(virtual_path);
 
 	for (size_t i = 0; i < vfs->file_entries.count; i++) {
@@ -89,22 +122,285 @@ static void lodge_vfs_broadcast_file_funcs(struct lodge_vfs *vfs, struct lodge_v
 	lodge_vfs_funcs_broadcast(&file_funcs->funcs, vfs, strview_wrap(file_funcs->virtual_path));
 }
 
-static void lodge_vfs_filewatch_event(strview_t path, enum lodge_filewatch_reason reason, struct lodge_vfs *vfs)
+//
+// Backing storage of a file view. `heap` views store the data right after this struct.
+//
+struct lodge_vfs_file_mapping
+{
+	volatile int32_t				refs;
+	bool							mapped;
+	void							*base;
+	size_t							size;
+};
+
+static struct lodge_vfs_file_mapping* lodge_vfs_file_mapping_new_heap_no_init(size_t size)
+{
+	// Keep the data 16 byte aligned for SIMD decoders.
+	const size_t header_size = (sizeof(struct lodge_vfs_file_mapping) + 15) & ~(size_t)15;
+
+	struct lodge_vfs_file_mapping *mapping = (struct lodge_vfs_file_mapping *)malloc(header_size + size + 1);
+	ASSERT_OR(mapping) { return NULL; }
+
+	char *data = (char *)mapping + header_size;
+	data[size] = '\0';
+
+	*mapping = (struct lodge_vfs_file_mapping) {
+		.refs = 1,
+		.mapped = false,
+		.base = data,
+		.size = size,
+	};
+	return mapping;
+}
+
+static struct lodge_vfs_file_mapping* lodge_vfs_file_mapping_new_heap(const char *disk_path)
+{
+	FILE *file = stb_fopen((char*)disk_path, "rb");
+	if(!file) {
+		return NULL;
+	}
+
+	const size_t size = stb_filelen(file);
+
+	struct lodge_vfs_file_mapping *mapping = lodge_vfs_file_mapping_new_heap_no_init(size);
+	if(!mapping) {
+		stb_fclose(file, 0);
+		return NULL;
+	}
+
+	const size_t read = fread(mapping->base, 1, size, file);
+	stb_fclose(file, 0);
+
+	if(read != size) {
+		free(mapping);
+		return NULL;
+	}
+
+	return mapping;
+}
+
+//
+// Maps the file if it is at least `size_min` bytes. With `terminated`, only if its size
+// leaves room for a zero byte in the last page, which the OS fills with zeroes past the
+// end of the file.
+//
+// NOTE(TS): a mapped file that is truncated in place while mapped can fault on access
+// (SIGBUS), and on Windows the mapping keeps writers from truncating it. Editors that
+// save by writing a new file and renaming it over the old one are fine, and the view is
+// released when the file watcher reports the change.
+//
+static struct lodge_vfs_file_mapping* lodge_vfs_file_mapping_new_mapped(const char *disk_path, size_t size_min, bool terminated)
 {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(disk_path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE) {
+		return NULL;
+	}
+
+	LARGE_INTEGER file_size;
+	SYSTEM_INFO system_info;
+	GetSystemInfo(&system_info);
+	if(!GetFileSizeEx(file, &file_size)
+		|| file_size.QuadPart == 0
+		|| (size_t)file_size.QuadPart < size_min
+		|| (terminated && (file_size.QuadPart % system_info.dwPageSize) == 0)) {
+		CloseHandle(file);
+		return NULL;
+	}
+
+	HANDLE file_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if(!file_mapping) {
+		return NULL;
+	}
+
+	// The view keeps the file mapping alive.
+	void *base = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(file_mapping);
+	if(!base) {
+		return NULL;
+	}
+
+	const size_t size = (size_t)file_size.QuadPart;
+#else
+	const int fd = open(disk_path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0) {
+		return NULL;
+	}
+
+	struct stat st;
+	const long page_size = sysconf(_SC_PAGESIZE);
+	if(fstat(fd, &st) != 0
+		|| !S_ISREG(st.st_mode)
+		|| st.st_size == 0
+		|| (size_t)st.st_size < size_min
+		|| (terminated && page_size > 0 && (st.st_size % page_size) == 0)) {
+		close(fd);
+		return NULL;
+	}
+
+	const size_t size = (size_t)st.st_size;
+
+	// The mapping stays valid after the fd is closed.
+	void *base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(base == MAP_FAILED) {
+		return NULL;
+	}
+#endif
+
+	struct lodge_vfs_file_mapping *mapping = (struct lodge_vfs_file_mapping *)malloc(sizeof(struct lodge_vfs_file_mapping));
+	ASSERT_OR(mapping) {
+#ifdef _WIN32
+		UnmapViewOfFile(base);
+#else
+		munmap(base, size);
+#endif
+		return NULL;
+	}
+
+	*mapping = (struct lodge_vfs_file_mapping) {
+		.refs = 1,
+		.mapped = true,
+		.base = base,
+		.size = size,
+	};
+	return mapping;
+}
+
+static void lodge_vfs_file_mapping_free(struct lodge_vfs_file_mapping *mapping)
+{
+	if(mapping->mapped) {
+#ifdef _WIN32
+		UnmapViewOfFile(mapping->base);
+#else
+		munmap(mapping->base, mapping->size);
+#endif
+	}
+	free(mapping);
+}
+
+static size_t lodge_vfs_get_mounts_count(struct lodge_vfs *vfs)
+{
+	lodge_mutex_lock(vfs->mounts_mutex);
+	const size_t count = vfs->mounts_count;
+	lodge_mutex_unlock(vfs->mounts_mutex);
+	return count;
+}
+
+//
+// Resolves `virtual_path` (starting with `/`) in a single mount.
+//
+static bool lodge_vfs_mount_resolve(const struct lodge_vfs_mount *mount, strview_t virtual_path, strbuf_t disk_path_out)
+{
+	const strview_t mount_point = strview_wrap(mount->point);
+	if(!strview_begins_with(virtual_path, mount_point)) {
+		return false;
+	}
+
+	strview_t substring = strview_substring_from_start(virtual_path, mount_point.length);
+	strbuf_setf(disk_path_out, "%s/" STRVIEW_PRINTF_FMT, mount->path, STRVIEW_PRINTF_ARG(substring));
+	return true;
+}
+
+//
+// Checks if a single mount provides `virtual_path` (starting with `/`). Directory mounts
+// write the disk path, pack mounts the entry.
+//
+static bool lodge_vfs_mount_provides(const struct lodge_vfs_mount *mount, strview_t virtual_path, strbuf_t disk_path_out, const struct lodge_pack_entry **entry_out)
+{
+	if(mount->pack_mapping) {
+		const strview_t mount_point = strview_wrap(mount->point);
+		if(!strview_begins_with(virtual_path, mount_point)) {
+			return false;
+		}
+		*entry_out = lodge_pack_find(&mount->pack, strview_substring_from_start(virtual_path, mount_point.length));
+		return *entry_out != NULL;
+	}
+
+	return lodge_vfs_mount_resolve(mount, virtual_path, disk_path_out) && stb_fexists(disk_path_out.s);
+}
+
+//
+// Finds the mount with the highest precedence that provides `virtual_path`.
+//
+static const struct lodge_vfs_mount* lodge_vfs_find(struct lodge_vfs *vfs, strview_t virtual_path, strbuf_t disk_path_out, const struct lodge_pack_entry **entry_out)
+{
+	if(virtual_path.length == 0) {
+		return NULL;
+	}
+
+	// Make sure `virtual_path` begins with `/`
+	char virtual_path_tmp[LODGE_VFS_FILENAME_MAX];
+	strbuf_t virtual_path_tmp_buf = strbuf_wrap(virtual_path_tmp);
+	if(virtual_path.s[0] != '/') {
+		strbuf_setf(virtual_path_tmp_buf, "/" STRVIEW_PRINTF_FMT, STRVIEW_PRINTF_ARG(virtual_path));
+		virtual_path = strbuf_to_strview(virtual_path_tmp_buf);
+	}
+
+	for(size_t i = 0, count = lodge_vfs_get_mounts_count(vfs); i < count; i++) {
+		const struct lodge_vfs_mount *mount = &vfs->mounts[count - 1 - i];
+		if(lodge_vfs_mount_provides(mount, virtual_path, disk_path_out, entry_out)) {
+			return mount;
+		}
+	}
+
+	return NULL;
+}
+
+//
+// Reverse of `lodge_vfs_resolve_disk_path()`: maps a disk path reported by the file
+// watcher to the virtual path it is mounted at. Fails if the file is outside all
+// mounts, or shadowed by a mount with higher precedence.
+//
+static bool lodge_vfs_disk_path_to_virtual_path(struct lodge_vfs *vfs, strview_t disk_path, strbuf_t virtual_path_out)
+{
+	for(size_t i = 0, count = lodge_vfs_get_mounts_count(vfs); i < count; i++) {
+		const size_t index = count - 1 - i;
+		const struct lodge_vfs_mount *mount = &vfs->mounts[index];
+		const strview_t mount_path = strview_wrap(mount->path);
+
+		if(mount->pack_mapping
+			|| disk_path.length <= mount_path.length + 1
+			|| !strview_begins_with(disk_path, mount_path)
+			|| disk_path.s[mount_path.length] != '/') {
+			continue;
+		}
+
+		const strview_t relative_path = strview_substring_from_start(disk_path, mount_path.length + 1);
+		strbuf_setf(virtual_path_out, "%s" STRVIEW_PRINTF_FMT, mount->point, STRVIEW_PRINTF_ARG(relative_path));
+
+		char shadow_path[LODGE_VFS_FILENAME_MAX];
+		const struct lodge_pack_entry *shadow_entry = NULL;
+		for(size_t j = index + 1; j < count; j++) {
+			if(lodge_vfs_mount_provides(&vfs->mounts[j], strbuf_to_strview(virtual_path_out), strbuf_wrap(shadow_path), &shadow_entry)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+static void lodge_vfs_filewatch_event(strview_t disk_path, enum lodge_filewatch_reason reason, struct lodge_vfs *vfs)
+{
+	char virtual_path_buf[LODGE_VFS_FILENAME_MAX];
+	if(!lodge_vfs_disk_path_to_virtual_path(vfs, disk_path, strbuf_wrap(virtual_path_buf))) {
+		return;
+	}
+	const strview_t virtual_path = strview_wrap(virtual_path_buf);
+
 	for(size_t i = 0, count = vfs->global_funcs.count; i < count; i++) {
 		struct lodge_vfs_func *func = &vfs->global_funcs.elements[i];
 		if(func->fn) {
-			func->fn(vfs, path, func->userdata);
+			func->fn(vfs, virtual_path, func->userdata);
 		}
 	}
 
-	struct lodge_vfs_file_entry *file_funcs = lodge_vfs_get_func_entry(vfs, path);
+	struct lodge_vfs_file_entry *file_funcs = lodge_vfs_get_func_entry(vfs, virtual_path);
 	if(file_funcs) {
-		//
-		// TODO(TS): we are currently firing reload events for files reloaded in mounts with lower precedence;
-		// `path` should be a disk_path, and should reverse resolve into a virtual_path
-		// It currently works, because the listener needs to resolve in _read_file() anyways
-		//
 		lodge_vfs_broadcast_file_funcs(vfs, file_funcs);
 	}
 }
@@ -112,6 +408,7 @@ static void lodge_vfs_filewatch_event(strview_t path, enum lodge_filewatch_reaso
 void lodge_vfs_new_inplace(struct lodge_vfs *vfs)
 {
 	memset(vfs, 0, sizeof(struct lodge_vfs));
+	vfs->mounts_mutex = lodge_mutex_new();
 	vfs->filewatch = lodge_filewatch_new();
 	dynbuf_new_inplace(dynbuf(vfs->file_entries), 1024);
 }
@@ -120,11 +417,21 @@ void lodge_vfs_free_inplace(struct lodge_vfs *vfs)
 {
 	lodge_filewatch_free(vfs->filewatch);
 
+	for(size_t i = 0; i < vfs->mounts_count; i++) {
+		struct lodge_vfs_mount *mount = &vfs->mounts[i];
+		if(mount->pack_mapping) {
+			lodge_vfs_file_view_release(&(struct lodge_vfs_file_view) { .mapping = mount->pack_mapping });
+		}
+	}
+
 	for(int i = 0; i < vfs->file_entries.count; i++) {
 		struct lodge_vfs_file_entry *entry = &vfs->file_entries.elements[i];
 		dynbuf_free_inplace(dynbuf(entry->funcs));
 	}
 	dynbuf_free_inplace(dynbuf(vfs->file_entries));
+	dynbuf_free_inplace(dynbuf(vfs->global_funcs));
+	dynbuf_free_inplace(dynbuf(vfs->mount_added_funcs));
+	lodge_mutex_free(vfs->mounts_mutex);
 }
 
 void lodge_vfs_update(struct lodge_vfs *vfs, float delta_time)
@@ -169,6 +476,8 @@ void lodge_vfs_register_callback(struct lodge_vfs *vfs, strview_t virtual_path,
 	if(!func_entry) {
 		func_entry = dynbuf_append_no_init(dynbuf(vfs->file_entries));
 
+		virtual_path = lodge_vfs_strip_root(virtual_path);
+
 		dynbuf_new_inplace(dynbuf(func_entry->funcs), 8);
 		strbuf_set(strbuf_wrap(func_entry->virtual_path), virtual_path);
 		func_entry->virtual_path_hash = strview_calc_hash(virtual_path);
@@ -203,6 +512,42 @@ bool lodge_vfs_remove_callback(struct lodge_vfs *vfs, strview_t virtual_path, lo
 	return false;
 }
 
+static void lodge_vfs_broadcast_virtual_path(struct lodge_vfs *vfs, strview_t virtual_path)
+{
+	struct lodge_vfs_file_entry* file_funcs = lodge_vfs_get_func_entry(vfs, virtual_path);
+	if(file_funcs) {
+		lodge_vfs_broadcast_file_funcs(vfs, file_funcs);
+	}
+}
+
+static bool lodge_vfs_mount_pack(struct lodge_vfs *vfs, struct lodge_vfs_mount *mount)
+{
+	mount->pack_mapping = lodge_vfs_file_mapping_new_mapped(mount->path, 0, false);
+	if(!mount->pack_mapping) {
+		mount->pack_mapping = lodge_vfs_file_mapping_new_heap(mount->path);
+	}
+	if(!mount->pack_mapping) {
+		return false;
+	}
+
+	if(!lodge_pack_init(&mount->pack, mount->pack_mapping->base, mount->pack_mapping->size)) {
+		lodge_vfs_file_view_release(&(struct lodge_vfs_file_view) { .mapping = mount->pack_mapping });
+		mount->pack_mapping = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+//
+// `dir` is either a directory or a pack file (ending with `LODGE_PACK_EXTENSION`). Later
+// mounts take precedence over earlier ones.
+//
+// Packs are read-only and not watched for changes.
+//
+// Call from the main thread, which runs the callbacks; other threads may keep
+// reading through the VFS meanwhile.
+//
 void lodge_vfs_mount(struct lodge_vfs *vfs, strview_t mount_point, strview_t dir)
 {
 	if (strview_empty(dir)) {
@@ -210,11 +555,8 @@ void lodge_vfs_mount(struct lodge_vfs *vfs, strview_t mount_point, strview_t dir
 		return;
 	}
 
-	strbuf_t path;
-	{
-		char path_buf[LODGE_VFS_MOUNT_PATH_MAX] = { 0 };
-		path = strbuf_wrap(path_buf);
-	}
+	char path_buf[LODGE_VFS_MOUNT_PATH_MAX] = { 0 };
+	strbuf_t path = strbuf_wrap(path_buf);
 	strbuf_set(path, dir);
 
 	size_t pathlen = strbuf_length(path);
@@ -228,48 +570,95 @@ void lodge_vfs_mount(struct lodge_vfs *vfs, strview_t mount_point, strview_t dir
 		path.s[pathlen - 1] = '\0';
 	}
 
-	lodge_filewatch_add_dir(vfs->filewatch, strbuf_to_strview(path), true, &lodge_vfs_filewatch_event, vfs);
+	const bool is_pack = strview_ends_with(strbuf_to_strview(path), strview(LODGE_PACK_EXTENSION));
 
-	{
-		struct lodge_vfs_mount *new_mount = membuf_append_no_init(membuf_wrap(vfs->mounts), &vfs->mounts_count);
-		
-		strbuf_set(strbuf_wrap(new_mount->point), mount_point);
-		if(!strview_ends_with(mount_point, strview("/"))) {
-			strbuf_append(strbuf_wrap(new_mount->point), strview("/"));
-		}
-		
-		strbuf_set(strbuf_wrap(new_mount->path), dir);
+	struct lodge_vfs_mount mount = { 0 };
+
+	strbuf_set(strbuf_wrap(mount.point), mount_point);
+	if(!strview_ends_with(mount_point, strview("/"))) {
+		strbuf_append(strbuf_wrap(mount.point), strview("/"));
 	}
 
-	// TODO(TS): we need to scan new mount and fire modify callbacks for all new files we have callbacks for,
-	// since this mount will take precedence
+	// Without the trailing separator, so disk paths from the file watcher map back.
+	strbuf_set(strbuf_wrap(mount.path), strbuf_to_strview(path));
 
-	char** filenames = stb_readdir_recursive(path.s, NULL);
-	ASSERT(filenames);
-	for(int i=0, count = stb_arr_len(filenames); i < count; i++) {
-		const size_t filename_len = strlen(filenames[i]);
-		strview_t virtual_filename = strview_make(filenames[i] + strbuf_length(path) + 1, filename_len - strbuf_length(path));
+	if(is_pack && !lodge_vfs_mount_pack(vfs, &mount)) {
+		ASSERT_FAIL("Failed to mount pack");
+		return;
+	}
 
-		struct lodge_vfs_file_entry* file_funcs = lodge_vfs_get_func_entry(vfs, virtual_filename);
-		if(file_funcs) {
-			lodge_vfs_broadcast_file_funcs(vfs, file_funcs);
+	lodge_mutex_lock(vfs->mounts_mutex);
+	struct lodge_vfs_mount *new_mount = membuf_append_no_init(membuf_wrap(vfs->mounts), &vfs->mounts_count);
+	if(new_mount) {
+		*new_mount = mount;
+	}
+	lodge_mutex_unlock(vfs->mounts_mutex);
+
+	if(!new_mount) {
+		if(mount.pack_mapping) {
+			lodge_vfs_file_view_release(&(struct lodge_vfs_file_view) { .mapping = mount.pack_mapping });
 		}
+		return;
 	}
 
 	//
-	// Notify listeners that a new mount has been added.
+	// This mount takes precedence: fire callbacks for the files it provides.
 	//
-	for(size_t i = 0; i < vfs->mount_added_funcs.count; i++) {
-		lodge_vfs_funcs_broadcast(&vfs->mount_added_funcs, vfs, mount_point);
+	char virtual_filename[LODGE_VFS_FILENAME_MAX];
+	if(is_pack) {
+		for(size_t i = 0, count = lodge_pack_entries_count(&new_mount->pack); i < count; i++) {
+			const strview_t name = lodge_pack_entry_name(&new_mount->pack, &new_mount->pack.entries[i]);
+			strbuf_setf(strbuf_wrap(virtual_filename), "%s" STRVIEW_PRINTF_FMT, new_mount->point, STRVIEW_PRINTF_ARG(name));
+			lodge_vfs_broadcast_virtual_path(vfs, strview_wrap(virtual_filename));
+		}
+	} else {
+		lodge_filewatch_add_dir(vfs->filewatch, strbuf_to_strview(path), true, &lodge_vfs_filewatch_event, vfs);
+
+		char** filenames = stb_readdir_recursive(path.s, NULL);
+		ASSERT(filenames);
+		for(int i=0, count = stb_arr_len(filenames); i < count; i++) {
+			if(lodge_vfs_disk_path_to_virtual_path(vfs, strview_make(filenames[i], strlen(filenames[i])), strbuf_wrap(virtual_filename))) {
+				lodge_vfs_broadcast_virtual_path(vfs, strview_wrap(virtual_filename));
+			}
+		}
+		stb_readdir_free(filenames);
 	}
+
+	//
+	// Notify listeners that a new mount has been added.
+	//
+	lodge_vfs_funcs_broadcast(&vfs->mount_added_funcs, vfs, mount_point);
 }
 
 void* lodge_vfs_read_file(struct lodge_vfs *vfs, strview_t virtual_path, size_t *out_num_bytes)
 {
 	char disk_path[LODGE_VFS_FILENAME_MAX];
+	const struct lodge_pack_entry *entry = NULL;
+
+	const struct lodge_vfs_mount *mount = lodge_vfs_find(vfs, virtual_path, strbuf_wrap(disk_path), &entry);
+	if(!mount) {
+		return NULL;
+	}
+
+	if(mount->pack_mapping) {
+		struct lodge_vfs_file_view view;
+		if(!lodge_vfs_map_file(vfs, virtual_path, &view)) {
+			return NULL;
+		}
+		char *data = malloc(view.size);
+		if(data) {
+			memcpy(data, view.data, view.size);
+			*out_num_bytes = view.size;
+		}
+		lodge_vfs_file_view_release(&view);
+		return data;
+	}
 
-	if(lodge_vfs_resolve_disk_path(vfs, virtual_path, strbuf_wrap(disk_path))) {
+	{
 		FILE *file = stb_fopen(disk_path, "rb");
+		if(!file) {
+			return NULL;
+		}
 		*out_num_bytes = stb_filelen(file);
 		char *data = malloc(*out_num_bytes);
 		fread(data, 1, *out_num_bytes, file);
@@ -299,40 +688,98 @@ char* lodge_vfs_read_text_file(struct lodge_vfs *vfs, strview_t virtual_path, si
 	return data;
 }
 
-bool lodge_vfs_resolve_disk_path(struct lodge_vfs *vfs, strview_t virtual_path, strbuf_t disk_path_out)
+static bool lodge_vfs_map_pack_entry(const struct lodge_vfs_mount *mount, const struct lodge_pack_entry *entry, struct lodge_vfs_file_view *view_out)
 {
-	if(virtual_path.length == 0) {
+	const char *stored = mount->pack.data + entry->offset;
+
+	if(!(entry->flags & LODGE_PACK_ENTRY_COMPRESSED)) {
+		lodge_atomic_add_i32(&mount->pack_mapping->refs, 1);
+		*view_out = (struct lodge_vfs_file_view) {
+			.data = stored,
+			.size = (size_t)entry->size,
+			.mapping = mount->pack_mapping,
+		};
+		return true;
+	}
+
+	if(entry->size > INT32_MAX || entry->uncompressed_size > INT32_MAX) {
 		return false;
 	}
 
-	// Make sure `virtual_path` begins with `/`
-	char virtual_path_tmp[4096];
-	strbuf_t virtual_path_tmp_buf = strbuf_wrap(virtual_path_tmp);
-	if(virtual_path.s[0] != '/') {
-		strbuf_setf(virtual_path_tmp_buf, "/" STRVIEW_PRINTF_FMT, STRVIEW_PRINTF_ARG(virtual_path));
-		virtual_path = strbuf_to_strview(virtual_path_tmp_buf);
+	struct lodge_vfs_file_mapping *mapping = lodge_vfs_file_mapping_new_heap_no_init((size_t)entry->uncompressed_size);
+	if(!mapping) {
+		return false;
 	}
 
-	// TODO(TS): add resolve cache, sync from file watcher
+	const int decoded = stbi_zlib_decode_buffer((char *)mapping->base, (int)entry->uncompressed_size, stored, (int)entry->size);
+	if(decoded < 0 || (uint64_t)decoded != entry->uncompressed_size) {
+		lodge_vfs_file_mapping_free(mapping);
+		return false;
+	}
 
-	for(size_t i=0, count=vfs->mounts_count; i<count; i++) {
-		const size_t index = count - 1 - i;
-		struct lodge_vfs_mount *mount = &vfs->mounts[index];
+	*view_out = (struct lodge_vfs_file_view) {
+		.data = (const char *)mapping->base,
+		.size = mapping->size,
+		.mapping = mapping,
+	};
+	return true;
+}
 
-		strbuf_t mount_point_buf = strbuf_wrap(mount->point);
-		const size_t mount_point_len = strbuf_length(mount_point_buf);
+bool lodge_vfs_map_file(struct lodge_vfs *vfs, strview_t virtual_path, struct lodge_vfs_file_view *view_out)
+{
+	char disk_path[LODGE_VFS_FILENAME_MAX];
+	const struct lodge_pack_entry *entry = NULL;
 
-		if(strview_begins_with(virtual_path, strbuf_to_strview(mount_point_buf))) {
-			strview_t substring = strview_substring_from_start(virtual_path, mount_point_len);
-			strbuf_setf(disk_path_out, "%s/" STRVIEW_PRINTF_FMT, mount->path, STRVIEW_PRINTF_ARG(substring));
+	const struct lodge_vfs_mount *mount = lodge_vfs_find(vfs, virtual_path, strbuf_wrap(disk_path), &entry);
+	if(!mount) {
+		return false;
+	}
 
-			if(stb_fexists(disk_path_out.s)) {
-				return true;
-			}
-		}
+	if(mount->pack_mapping) {
+		return lodge_vfs_map_pack_entry(mount, entry, view_out);
 	}
 
-	return false;
+	struct lodge_vfs_file_mapping *mapping = lodge_vfs_file_mapping_new_mapped(disk_path, LODGE_VFS_MAP_SIZE_MIN, true);
+	if(!mapping) {
+		mapping = lodge_vfs_file_mapping_new_heap(disk_path);
+	}
+	if(!mapping) {
+		return false;
+	}
+
+	*view_out = (struct lodge_vfs_file_view) {
+		.data = (const char *)mapping->base,
+		.size = mapping->size,
+		.mapping = mapping,
+	};
+	return true;
+}
+
+struct lodge_vfs_file_view lodge_vfs_file_view_retain(const struct lodge_vfs_file_view *view)
+{
+	if(view->mapping) {
+		lodge_atomic_add_i32(&view->mapping->refs, 1);
+	}
+	return *view;
+}
+
+void lodge_vfs_file_view_release(struct lodge_vfs_file_view *view)
+{
+	if(view->mapping && lodge_atomic_add_i32(&view->mapping->refs, -1) == 0) {
+		lodge_vfs_file_mapping_free(view->mapping);
+	}
+	*view = (struct lodge_vfs_file_view) { 0 };
+}
+
+//
+// Fails for files provided by a pack mount, which have no disk path.
+//
+bool lodge_vfs_resolve_disk_path(struct lodge_vfs *vfs, strview_t virtual_path, strbuf_t disk_path_out)
+{
+	// TODO(TS): add resolve cache, sync from file watcher
+	const struct lodge_pack_entry *entry = NULL;
+	const struct lodge_vfs_mount *mount = lodge_vfs_find(vfs, virtual_path, disk_path_out, &entry);
+	return mount && !mount->pack_mapping;
 }
 
 bool lodge_vfs_iterate(struct lodge_vfs *vfs, strview_t path, strview_t mask, struct lodge_vfs_iterate_dynbuf *out)
@@ -343,10 +790,35 @@ bool lodge_vfs_iterate(struct lodge_vfs *vfs, strview_t path, strview_t mask, st
 	ASSERT_NULL_TERMINATED(path);
 	ASSERT_NULL_TERMINATED(mask);
 
-	for(size_t i = 0, count = vfs->mounts_count; i < count; i++) {
+	for(size_t i = 0, count = lodge_vfs_get_mounts_count(vfs); i < count; i++) {
 		struct lodge_vfs_mount *mount = &vfs->mounts[i];
 		const size_t mount_path_length = strbuf_length(strbuf_wrap(mount->path));
 
+		//
+		// Pack mounts list their table of contents without touching the disk.
+		//
+		if(mount->pack_mapping) {
+			for(size_t j = 0, entries_count = lodge_pack_entries_count(&mount->pack); j < entries_count; j++) {
+				const strview_t name = lodge_pack_entry_name(&mount->pack, &mount->pack.entries[j]);
+
+				char virtual_path[LODGE_VFS_FILENAME_MAX];
+				strbuf_setf(strbuf_wrap(virtual_path), "%s" STRVIEW_PRINTF_FMT, mount->point, STRVIEW_PRINTF_ARG(name));
+				if(!strview_begins_with(strview_wrap(virtual_path), path)) {
+					continue;
+				}
+
+				const char *basename = strrchr(virtual_path, '/') + 1;
+				if(!stb_wildmatchi((char*)mask.s, (char*)basename)) {
+					continue;
+				}
+
+				struct lodge_vfs_entry *entry = dynbuf_append_no_init(dynbuf_wrap(out));
+				entry->dir = false;
+				strbuf_set(strbuf_wrap(entry->name), strview_wrap(virtual_path));
+			}
+			continue;
+		}
+
 		if(strview_begins_with(strbuf_to_strview(strbuf_wrap(mount->point)), path)) {
 			// Files
 			{
@@ -24,6 +24,24 @@ struct lodge_vfs_entry
 	char					name[LODGE_VFS_FILENAME_MAX];
 };
 
+//
+// Read-only view of a file's contents. Files of at least `LODGE_VFS_MAP_SIZE_MIN` bytes are
+// memory mapped, smaller files are read into a heap copy. Either way the data is followed
+// by a `\0`, so text can be parsed in place.
+//
+// Views are refcounted: `_retain()` shares the data, and each view must be released.
+//
+#define LODGE_VFS_MAP_SIZE_MIN			(64 * 1024)
+
+struct lodge_vfs_file_mapping;
+
+struct lodge_vfs_file_view
+{
+	const char						*data;
+	size_t							size;
+	struct lodge_vfs_file_mapping	*mapping;
+};
+
 struct lodge_vfs_iterate_dynbuf
 {
 	struct lodge_vfs_entry	*elements;
@@ -51,9 +69,16 @@ void					lodge_vfs_remove_global_callback(struct lodge_vfs *vfs, lodge_vfs_func_
 void					lodge_vfs_add_on_mount_added_func(struct lodge_vfs *vfs, lodge_vfs_func_t func, void *userdata);
 void					lodge_vfs_remove_on_mount_added_func(struct lodge_vfs *vfs, lodge_vfs_func_t func, void *userdata);
 
+//
+// Reading and mapping files is safe from any thread, also while mounts are added.
+//
 void*					lodge_vfs_read_file(struct lodge_vfs *vfs, strview_t virtual_path, size_t *out_num_bytes);
 char*					lodge_vfs_read_text_file(struct lodge_vfs *vfs, strview_t virtual_path, size_t *out_num_bytes);
 
+bool					lodge_vfs_map_file(struct lodge_vfs *vfs, strview_t virtual_path, struct lodge_vfs_file_view *view_out);
+struct lodge_vfs_file_view	lodge_vfs_file_view_retain(const struct lodge_vfs_file_view *view);
+void					lodge_vfs_file_view_release(struct lodge_vfs_file_view *view);
+
 bool					lodge_vfs_resolve_disk_path(struct lodge_vfs *vfs, strview_t virtual_path, strbuf_t disk_path_out);
 
 bool					lodge_vfs_iterate(struct lodge_vfs *vfs, strview_t path, strview_t mask, struct lodge_vfs_iterate_dynbuf *out);
@@ -0,0 +1,278 @@
+//
+// File watching on a scratch directory: bursts of writes coalesced into one event,
+// directories created while watched, renames, and the virtual paths `lodge_vfs`
+// reports for watched mounts, including files shadowed by a later mount.
+//
+
+#include "lodge_filewatch.h"
+#include "lodge_vfs.h"
+#include "lodge_time.h"
+
+#include "lodge_test.h"
+
+#include "strbuf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define TEST_PATH_MAX			1024
+#define TEST_EVENTS_MAX			64
+
+struct test_event
+{
+	char						path[TEST_PATH_MAX];
+	enum lodge_filewatch_reason	reason;
+};
+
+struct test_events
+{
+	size_t						count;
+	struct test_event			elements[TEST_EVENTS_MAX];
+};
+
+static void test_events_push(struct test_events *events, strview_t path, enum lodge_filewatch_reason reason)
+{
+	if(events->count < TEST_EVENTS_MAX) {
+		struct test_event *event = &events->elements[events->count++];
+		strbuf_set(strbuf_wrap(event->path), path);
+		event->reason = reason;
+	}
+}
+
+//
+// Number of events for `path`, and with `reason` unless it is LODGE_FILEWATCH_REASON_MAX.
+//
+static size_t test_events_count(const struct test_events *events, const char *path, enum lodge_filewatch_reason reason)
+{
+	size_t count = 0;
+	for(size_t i = 0; i < events->count; i++) {
+		if(strcmp(events->elements[i].path, path) == 0
+			&& (reason == LODGE_FILEWATCH_REASON_MAX || events->elements[i].reason == reason)) {
+			count++;
+		}
+	}
+	return count;
+}
+
+static void test_on_filewatch(strview_t path, enum lodge_filewatch_reason reason, struct test_events *events)
+{
+	test_events_push(events, path, reason);
+}
+
+static void test_on_vfs(struct lodge_vfs *vfs, strview_t virtual_path, struct test_events *events)
+{
+	test_events_push(events, virtual_path, LODGE_FILEWATCH_REASON_FILE_MODIFIED);
+}
+
+static void test_make_dir(char *dir, const char *name)
+{
+	snprintf(dir, TEST_PATH_MAX, "/tmp/lodge_%s_XXXXXX", name);
+	if(!mkdtemp(dir)) {
+		LODGE_TEST_CHECK_MSG(false, "mkdtemp %s", dir);
+	}
+}
+
+static void test_remove_dir(const char *dir)
+{
+	DIR *it = opendir(dir);
+	if(it) {
+		char path[TEST_PATH_MAX];
+		for(struct dirent *entry = readdir(it); entry; entry = readdir(it)) {
+			if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+				continue;
+			}
+			snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+			struct stat st;
+			if(lstat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+				test_remove_dir(path);
+			} else {
+				unlink(path);
+			}
+		}
+		closedir(it);
+	}
+	rmdir(dir);
+}
+
+static void test_write(const char *dir, const char *name, const char *text)
+{
+	char path[TEST_PATH_MAX];
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+	FILE *file = fopen(path, "wb");
+	LODGE_TEST_CHECK_MSG(file, "%s", path);
+	if(file) {
+		fputs(text, file);
+		fclose(file);
+	}
+}
+
+static const char* test_path(char *path, const char *dir, const char *name)
+{
+	snprintf(path, TEST_PATH_MAX, "%s/%s", dir, name);
+	return path;
+}
+
+//
+// Updates until the debounce window of everything that happened before has passed.
+//
+static void test_pump(struct lodge_filewatch *filewatch, struct lodge_vfs *vfs)
+{
+	const lodge_timestamp_t before = lodge_timestamp_get();
+	while(lodge_timestamp_elapsed_ms(before) < LODGE_FILEWATCH_DEBOUNCE_MS * 3.0) {
+		if(filewatch) {
+			lodge_filewatch_update(filewatch, 0.005f);
+		}
+		if(vfs) {
+			lodge_vfs_update(vfs, 0.005f);
+		}
+		usleep(5000);
+	}
+}
+
+static void test_filewatch_events()
+{
+	char root[TEST_PATH_MAX];
+	test_make_dir(root, "filewatch");
+
+	char path[TEST_PATH_MAX];
+	mkdir(test_path(path, root, "old"), 0755);
+	test_write(root, "a.txt", "");
+
+	struct test_events events = { 0 };
+	struct lodge_filewatch *filewatch = lodge_filewatch_new();
+	lodge_filewatch_add_dir(filewatch, strview_make(root, strlen(root)), true, &test_on_filewatch, &events);
+
+	//
+	// A burst of writes to one file, like an editor saving, is one event once it settles.
+	//
+	for(int i = 0; i < 20; i++) {
+		test_write(root, "a.txt", "burst");
+	}
+	lodge_filewatch_update(filewatch, 0.0f);
+	LODGE_TEST_CHECK_MSG(events.count == 0, "%zu events inside the debounce window", events.count);
+
+	test_pump(filewatch, NULL);
+	LODGE_TEST_CHECK_MSG(events.count == 1, "%zu events", events.count);
+	LODGE_TEST_CHECK(test_events_count(&events, test_path(path, root, "a.txt"), LODGE_FILEWATCH_REASON_FILE_MODIFIED) == 1);
+
+	//
+	// Directories that existed when watching started.
+	//
+	events.count = 0;
+	test_write(root, "old/b.txt", "b");
+	test_pump(filewatch, NULL);
+	LODGE_TEST_CHECK_MSG(events.count == 1, "%zu events", events.count);
+	LODGE_TEST_CHECK(test_events_count(&events, test_path(path, root, "old/b.txt"), LODGE_FILEWATCH_REASON_FILE_CREATED) == 1);
+
+	//
+	// A directory created while watched is picked up, with the file written into it
+	// before its watch was added.
+	//
+	events.count = 0;
+	mkdir(test_path(path, root, "new"), 0755);
+	test_write(root, "new/c.txt", "c");
+	test_pump(filewatch, NULL);
+	LODGE_TEST_CHECK_MSG(events.count == 2, "%zu events", events.count);
+	LODGE_TEST_CHECK(test_events_count(&events, test_path(path, root, "new"), LODGE_FILEWATCH_REASON_DIR_CREATED) == 1);
+	LODGE_TEST_CHECK(test_events_count(&events, test_path(path, root, "new/c.txt"), LODGE_FILEWATCH_REASON_FILE_CREATED) == 1);
+
+	events.count = 0;
+	test_write(root, "new/c.txt", "cc");
+	test_pump(filewatch, NULL);
+	LODGE_TEST_CHECK_MSG(events.count == 1, "%zu events", events.count);
+	LODGE_TEST_CHECK(test_events_count(&events, test_path(path, root, "new/c.txt"), LODGE_FILEWATCH_REASON_FILE_MODIFIED) == 1);
+
+	//
+	// A rename reports both names.
+	//
+	events.count = 0;
+	char renamed[TEST_PATH_MAX];
+	rename(test_path(path, root, "a.txt"), test_path(renamed, root, "d.txt"));
+	test_pump(filewatch, NULL);
+	LODGE_TEST_CHECK_MSG(events.count == 2, "%zu events", events.count);
+	LODGE_TEST_CHECK(test_events_count(&events, test_path(path, root, "a.txt"), LODGE_FILEWATCH_REASON_FILE_RENAMED) == 1);
+	LODGE_TEST_CHECK(test_events_count(&events, test_path(path, root, "d.txt"), LODGE_FILEWATCH_REASON_FILE_RENAMED) == 1);
+
+	events.count = 0;
+	unlink(test_path(path, root, "d.txt"));
+	test_pump(filewatch, NULL);
+	LODGE_TEST_CHECK_MSG(events.count == 1, "%zu events", events.count);
+	LODGE_TEST_CHECK(test_events_count(&events, test_path(path, root, "d.txt"), LODGE_FILEWATCH_REASON_FILE_DELETED) == 1);
+
+	lodge_filewatch_free(filewatch);
+	test_remove_dir(root);
+}
+
+static void test_vfs_virtual_paths()
+{
+	char low[TEST_PATH_MAX];
+	char high[TEST_PATH_MAX];
+	char data[TEST_PATH_MAX];
+	test_make_dir(low, "filewatch_low");
+	test_make_dir(high, "filewatch_high");
+	test_make_dir(data, "filewatch_data");
+
+	char path[TEST_PATH_MAX];
+	mkdir(test_path(path, low, "sub"), 0755);
+
+	struct lodge_vfs *vfs = (struct lodge_vfs *)calloc(1, lodge_vfs_sizeof());
+	lodge_vfs_new_inplace(vfs);
+	lodge_vfs_mount(vfs, strview_static("/"), strview_make(low, strlen(low)));
+	lodge_vfs_mount(vfs, strview_static("/"), strview_make(high, strlen(high)));
+	lodge_vfs_mount(vfs, strview_static("/data"), strview_make(data, strlen(data)));
+
+	struct test_events events = { 0 };
+	lodge_vfs_add_global_callback(vfs, &test_on_vfs, &events);
+
+	test_write(low, "x.txt", "low");
+	test_write(low, "sub/y.txt", "low");
+	test_write(data, "z.txt", "data");
+	test_pump(NULL, vfs);
+	LODGE_TEST_CHECK_MSG(events.count == 3, "%zu events", events.count);
+	LODGE_TEST_CHECK(test_events_count(&events, "/x.txt", LODGE_FILEWATCH_REASON_MAX) == 1);
+	LODGE_TEST_CHECK(test_events_count(&events, "/sub/y.txt", LODGE_FILEWATCH_REASON_MAX) == 1);
+	LODGE_TEST_CHECK(test_events_count(&events, "/data/z.txt", LODGE_FILEWATCH_REASON_MAX) == 1);
+
+	//
+	// The later mount shadows `/x.txt`: changes to the earlier one are not reported
+	// until the shadowing file is gone again.
+	//
+	events.count = 0;
+	test_write(high, "x.txt", "high");
+	test_pump(NULL, vfs);
+	LODGE_TEST_CHECK_MSG(events.count == 1 && test_events_count(&events, "/x.txt", LODGE_FILEWATCH_REASON_MAX) == 1, "%zu events", events.count);
+
+	events.count = 0;
+	test_write(low, "x.txt", "low, shadowed");
+	test_pump(NULL, vfs);
+	LODGE_TEST_CHECK_MSG(events.count == 0, "%zu events", events.count);
+
+	unlink(test_path(path, high, "x.txt"));
+	test_pump(NULL, vfs);
+	LODGE_TEST_CHECK_MSG(events.count == 1 && test_events_count(&events, "/x.txt", LODGE_FILEWATCH_REASON_MAX) == 1, "%zu events", events.count);
+
+	events.count = 0;
+	test_write(low, "x.txt", "low again");
+	test_pump(NULL, vfs);
+	LODGE_TEST_CHECK_MSG(events.count == 1 && test_events_count(&events, "/x.txt", LODGE_FILEWATCH_REASON_MAX) == 1, "%zu events", events.count);
+
+	lodge_vfs_free_inplace(vfs);
+	free(vfs);
+
+	test_remove_dir(low);
+	test_remove_dir(high);
+	test_remove_dir(data);
+}
+
+int main(int argc, char **argv)
+{
+	LODGE_TEST_RUN(test_filewatch_events);
+	LODGE_TEST_RUN(test_vfs_virtual_paths);
+	return lodge_test_result();
+}